@@ -21,6 +21,7 @@ import java.io.File;
 import java.io.FileOutputStream;
 import java.io.IOException;
 import java.io.RandomAccessFile;
+import java.nio.ByteBuffer;
 import java.nio.file.Files;
 import java.nio.file.Path;
 import java.nio.file.Paths;
@@ -41,6 +42,9 @@ import com.dynamo.bob.pipeline.ResourceNode;
 import com.dynamo.liveupdate.proto.Manifest.HashAlgorithm;
 import com.dynamo.liveupdate.proto.Manifest.ResourceEntryFlag;
 
+import net.jpountz.lz4.LZ4FastDecompressor;
+import net.jpountz.lz4.LZ4Factory;
+
 public class ArchiveTest {
 
     private String contentRoot;
@@ -240,6 +244,34 @@ public class ArchiveTest {
         assertArrayEquals(expected, actual);
     }
 
+    @Test
+    public void testCompressResourceDataBlocks() throws Exception {
+        byte[] content = new byte[ArchiveBuilder.COMPRESSION_BLOCK_SIZE * 2 + 1000];
+        for (int i = 0; i < content.length; ++i) {
+            content[i] = (byte) (i / 100);
+        }
+        ArchiveBuilder instance = new ArchiveBuilder(FilenameUtils.separatorsToSystem(contentRoot), manifestBuilder, true, 4);
+
+        byte[] compressed = instance.compressResourceDataBlocks(content);
+        assertTrue(instance.shouldUseCompressedResourceData(content, compressed));
+
+        ByteBuffer table = ByteBuffer.wrap(compressed);
+        assertEquals(ArchiveBuilder.COMPRESSION_BLOCK_SIZE, table.getInt());
+        assertEquals(3, table.getInt());
+
+        LZ4FastDecompressor decompressor = LZ4Factory.fastestInstance().fastDecompressor();
+        byte[] actual = new byte[content.length];
+        int offset = 4 * (2 + 3);
+        for (int i = 0; i < 3; ++i) {
+            int compressedSize = table.getInt();
+            int size = Math.min(ArchiveBuilder.COMPRESSION_BLOCK_SIZE, content.length - i * ArchiveBuilder.COMPRESSION_BLOCK_SIZE);
+            assertEquals(compressedSize, decompressor.decompress(compressed, offset, actual, i * ArchiveBuilder.COMPRESSION_BLOCK_SIZE, size));
+            offset += compressedSize;
+        }
+        assertEquals(compressed.length, offset);
+        assertArrayEquals(content, actual);
+    }
+
     @Test
     public void testShouldUseCompressedResourceData() throws Exception {
         ArchiveBuilder instance = new ArchiveBuilder(FilenameUtils.separatorsToSystem(contentRoot), manifestBuilder, true, 4);
@@ -0,0 +1,80 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+package com.dynamo.bob.test.util;
+
+import static org.junit.Assert.assertEquals;
+
+import org.junit.Test;
+
+import com.dynamo.bob.util.RigUtil;
+import com.dynamo.rig.proto.Rig;
+
+public class RigUtilTest {
+
+    private static final int SAMPLE_COUNT = 31;
+
+    private static Rig.AnimationTrack.Builder newTrack() {
+        Rig.AnimationTrack.Builder track = Rig.AnimationTrack.newBuilder().setBoneIndex(0);
+        for (int i = 0; i < SAMPLE_COUNT; ++i) {
+            // Constant position
+            track.addPositions(1.0f).addPositions(2.0f).addPositions(3.0f);
+            // Linear scale
+            track.addScale(1.0f + 0.1f * i).addScale(1.0f).addScale(1.0f);
+            // Rotation around z, with a turn in direction halfway
+            double angle = (i <= SAMPLE_COUNT / 2 ? i : SAMPLE_COUNT - 1 - i) * 0.05;
+            track.addRotations(0.0f).addRotations(0.0f).addRotations((float)Math.sin(angle * 0.5)).addRotations((float)Math.cos(angle * 0.5));
+        }
+        return track;
+    }
+
+    @Test
+    public void testCompressTrack() throws Exception {
+        Rig.AnimationTrack.Builder track = newTrack();
+        RigUtil.compressTrack(track);
+
+        assertEquals(3, track.getPositionsCount());
+        assertEquals(0, track.getPositionKeysCount());
+        assertEquals(2.0f, track.getPositions(1), 0.0f);
+
+        assertEquals(6, track.getScaleCount());
+        assertEquals(2, track.getScaleKeysCount());
+        assertEquals(0, track.getScaleKeys(0));
+        assertEquals(SAMPLE_COUNT - 1, track.getScaleKeys(1));
+
+        assertEquals(0, track.getRotationsCount());
+        assertEquals(3, track.getRotationKeysCount());
+        assertEquals(SAMPLE_COUNT / 2, track.getRotationKeys(1));
+        assertEquals(3, track.getPackedRotationsCount());
+
+        // Compressing again keeps the track
+        Rig.AnimationTrack compressed = track.build();
+        RigUtil.compressTrack(track);
+        assertEquals(compressed, track.build());
+    }
+
+    @Test
+    public void testPackQuat() throws Exception {
+        // The largest component is dropped, identity packs to w with zeroed components
+        long mid = 1L << 19;
+        long packed = RigUtil.packQuat(new double[] {0.0, 0.0, 0.0, 1.0});
+        assertEquals(3, packed & 3);
+        assertEquals(mid, (packed >> 2) & 0xfffff);
+        assertEquals(mid, (packed >> 22) & 0xfffff);
+        assertEquals(mid, (packed >> 42) & 0xfffff);
+
+        // q and -q pack the same
+        double s = Math.sqrt(0.5);
+        assertEquals(RigUtil.packQuat(new double[] {s, 0.0, 0.0, s}), RigUtil.packQuat(new double[] {-s, -0.0, -0.0, -s}));
+        assertEquals(1, RigUtil.packQuat(new double[] {0.0, -1.0, 0.0, 0.0}) & 3);
+    }
+}
@@ -45,11 +45,14 @@ import net.jpountz.lz4.LZ4Factory;
 
 public class ArchiveBuilder {
 
-    public static final int VERSION = 4;
+    public static final int VERSION = 5;
     public static final int HASH_MAX_LENGTH = 64; // 512 bits
     public static final int HASH_LENGTH = 20;
     public static final int MD5_HASH_DIGEST_BYTE_LENGTH = 16; // 128 bits
 
+    // Bundled entries larger than this are compressed as independent blocks that the engine decodes in parallel
+    public static final int COMPRESSION_BLOCK_SIZE = 256 * 1024;
+
     private static final byte[] KEY = "aQj8CScgNP4VsfXK".getBytes();
 
     private static final List<String> ENCRYPTED_EXTS = Arrays.asList("luac", "scriptc", "gui_scriptc", "render_scriptc");
@@ -123,6 +126,28 @@ public class ArchiveBuilder {
         return Arrays.copyOfRange(compressedContent, 0, compressedSize);
     }
 
+    // Block table (block size, block count, compressed size of each block) followed by the blocks.
+    // Must match dmResourceArchive::DecompressBlocks
+    public byte[] compressResourceDataBlocks(byte[] buffer) {
+        int blockCount = (buffer.length + COMPRESSION_BLOCK_SIZE - 1) / COMPRESSION_BLOCK_SIZE;
+        int maximumBlockSize = lz4Compressor.maxCompressedLength(COMPRESSION_BLOCK_SIZE);
+        byte[] compressedBlock = new byte[maximumBlockSize];
+
+        ByteBuffer blocks = ByteBuffer.allocate((2 + blockCount) * 4 + blockCount * maximumBlockSize);
+        blocks.putInt(COMPRESSION_BLOCK_SIZE);
+        blocks.putInt(blockCount);
+        int blockDataOffset = blocks.position() + blockCount * 4;
+        for (int i = 0; i < blockCount; ++i) {
+            int offset = i * COMPRESSION_BLOCK_SIZE;
+            int length = Math.min(COMPRESSION_BLOCK_SIZE, buffer.length - offset);
+            int compressedSize = lz4Compressor.compress(buffer, offset, length, compressedBlock, 0, maximumBlockSize);
+            blocks.putInt((2 + i) * 4, compressedSize);
+            System.arraycopy(compressedBlock, 0, blocks.array(), blockDataOffset, compressedSize);
+            blockDataOffset += compressedSize;
+        }
+        return Arrays.copyOfRange(blocks.array(), 0, blockDataOffset);
+    }
+
     public boolean shouldUseCompressedResourceData(byte[] original, byte[] compressed) {
         double ratio = (double) compressed.length / (double) original.length;
         return ratio <= 0.95;
@@ -198,11 +223,17 @@ public class ArchiveBuilder {
             byte[] buffer = this.loadResourceData(entry.fileName);
             byte archiveEntryFlags = (byte) entry.flags;
             int resourceEntryFlags = ResourceEntryFlag.BUNDLED.getNumber();
+            String normalisedPath = FilenameUtils.separatorsToUnix(entry.relName);
+            boolean excluded = this.excludeResource(normalisedPath, excludedResources);
             if (entry.compressedSize != ArchiveEntry.FLAG_UNCOMPRESSED) {
-                // Compress data
-                byte[] compressed = this.compressResourceData(buffer);
+                // Compress data. Excluded entries end up in resource packs, which are always compressed as one buffer
+                boolean useBlocks = !excluded && buffer.length > COMPRESSION_BLOCK_SIZE;
+                byte[] compressed = useBlocks ? this.compressResourceDataBlocks(buffer) : this.compressResourceData(buffer);
                 if (this.shouldUseCompressedResourceData(buffer, compressed)) {
                     archiveEntryFlags = (byte)(archiveEntryFlags | ArchiveEntry.FLAG_COMPRESSED);
+                    if (useBlocks) {
+                        entry.flags = (entry.flags | ArchiveEntry.FLAG_COMPRESSED_BLOCKS);
+                    }
                     buffer = compressed;
                     entry.compressedSize = compressed.length;
                 } else {
@@ -218,9 +249,6 @@ public class ArchiveBuilder {
                 buffer = this.encryptResourceData(buffer);
             }
 
-            // Add entry to manifest
-            String normalisedPath = FilenameUtils.separatorsToUnix(entry.relName);
-
             // Calculate hash digest values for resource
             String hexDigest = null;
             try {
@@ -233,7 +261,7 @@ public class ArchiveBuilder {
             }
 
             // Write resource to data archive
-            if (this.excludeResource(normalisedPath, excludedResources)) {
+            if (excluded) {
                 resourceEntryFlags = ResourceEntryFlag.EXCLUDED.getNumber();
                 this.writeResourcePack(hexDigest, resourcePackDirectory.toString(), buffer, archiveEntryFlags, entry.size);
                 entries.remove(i);
@@ -21,6 +21,7 @@ public class ArchiveEntry implements Comparable<ArchiveEntry> {
     public static final int FLAG_ENCRYPTED = 1 << 0;
     public static final int FLAG_COMPRESSED = 1 << 1;
     public static final int FLAG_LIVEUPDATE = 1 << 2;
+    public static final int FLAG_COMPRESSED_BLOCKS = 1 << 3;
     public static final int FLAG_UNCOMPRESSED = 0xFFFFFFFF;
 
     // Member vars, TODO make these private and add getters/setters
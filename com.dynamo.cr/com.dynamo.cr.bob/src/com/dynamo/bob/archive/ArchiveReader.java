@@ -26,7 +26,7 @@ import com.dynamo.liveupdate.proto.Manifest.ManifestFile;
 import com.dynamo.liveupdate.proto.Manifest.ResourceEntry;
 
 public class ArchiveReader {
-    public static final int VERSION = 4;
+    public static final int VERSION = 5;
     public static final int HASH_BUFFER_BYTESIZE = 64; // 512 bits
 
     private ArrayList<ArchiveEntry> entries = null;
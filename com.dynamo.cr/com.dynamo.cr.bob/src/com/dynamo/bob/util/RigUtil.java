@@ -25,6 +25,7 @@ import javax.vecmath.Vector3d;
 
 import com.dynamo.bob.textureset.TextureSetGenerator.UVTransform;
 import com.dynamo.bob.util.RigUtil.AnimationCurve.CurveIntepolation;
+import com.dynamo.rig.proto.Rig;
 import com.dynamo.rig.proto.Rig.MeshAnimationTrack;
 
 /**
@@ -34,6 +35,15 @@ import com.dynamo.rig.proto.Rig.MeshAnimationTrack;
  */
 public class RigUtil {
     static double EPSILON = 0.0001;
+
+    // Max errors of compressed tracks, positions are relative to the largest coordinate of the track
+    static double COMPRESS_POSITION_ERROR = 0.0005;
+    static double COMPRESS_ROTATION_ERROR = 0.0005;
+    static double COMPRESS_SCALE_ERROR = 0.0005;
+    // Smallest three encoding of packed rotations, see AnimationTrack in rig_ddf.proto
+    static final int PACKED_QUAT_COMPONENT_BITS = 20;
+    static final long PACKED_QUAT_COMPONENT_MASK = (1L << PACKED_QUAT_COMPONENT_BITS) - 1;
+    static final double PACKED_QUAT_RANGE = Math.sqrt(0.5);
     
     @SuppressWarnings("serial")
     public static class LoadException extends Exception {
@@ -768,4 +778,191 @@ public class RigUtil {
         // Create duplicate of last keyframe
         propertyBuilder.duplicateLast();
     }
+
+    public static long packQuat(double[] q) {
+        int largest = 0;
+        for (int i = 1; i < 4; ++i) {
+            if (Math.abs(q[i]) > Math.abs(q[largest])) {
+                largest = i;
+            }
+        }
+        // q and -q are the same rotation, store the one with a positive largest component
+        double sign = q[largest] < 0.0 ? -1.0 : 1.0;
+        long packed = largest;
+        int shift = 2;
+        for (int i = 0; i < 4; ++i) {
+            if (i == largest) {
+                continue;
+            }
+            double n = Math.min(1.0, Math.max(0.0, (sign * q[i] / PACKED_QUAT_RANGE + 1.0) * 0.5));
+            packed |= Math.round(n * PACKED_QUAT_COMPONENT_MASK) << shift;
+            shift += PACKED_QUAT_COMPONENT_BITS;
+        }
+        return packed;
+    }
+
+    // Same as slerp in the runtime vector math library
+    private static void slerp(double t, double[] q0, double[] q1, double[] out) {
+        double cos = q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3];
+        double sign = 1.0;
+        if (cos < 0.0) {
+            cos = -cos;
+            sign = -1.0;
+        }
+        double scale0 = 1.0 - t;
+        double scale1 = t;
+        if (cos < 0.999) {
+            double angle = Math.acos(cos);
+            double recipSin = 1.0 / Math.sin(angle);
+            scale0 = Math.sin((1.0 - t) * angle) * recipSin;
+            scale1 = Math.sin(t * angle) * recipSin;
+        }
+        for (int i = 0; i < 4; ++i) {
+            out[i] = sign * q0[i] * scale0 + q1[i] * scale1;
+        }
+    }
+
+    // Error of the sample i when interpolated between the samples k0 and k1, as the runtime does
+    private static double keyError(float[] values, int stride, int k0, int k1, int i, double[][] tmp) {
+        double t = k1 > k0 ? (double)(i - k0) / (double)(k1 - k0) : 0.0;
+        if (stride == 4) {
+            for (int c = 0; c < 4; ++c) {
+                tmp[0][c] = values[k0 * 4 + c];
+                tmp[1][c] = values[k1 * 4 + c];
+            }
+            slerp(t, tmp[0], tmp[1], tmp[2]);
+            // Twice the chord between the rotations, close to the angle for small errors
+            double d0 = 0.0;
+            double d1 = 0.0;
+            for (int c = 0; c < 4; ++c) {
+                double v = values[i * 4 + c];
+                d0 += (tmp[2][c] - v) * (tmp[2][c] - v);
+                d1 += (tmp[2][c] + v) * (tmp[2][c] + v);
+            }
+            return 2.0 * Math.sqrt(Math.min(d0, d1));
+        }
+        double error = 0.0;
+        for (int c = 0; c < stride; ++c) {
+            double v0 = values[k0 * stride + c];
+            double v1 = values[k1 * stride + c];
+            error = Math.max(error, Math.abs(v0 + (v1 - v0) * t - values[i * stride + c]));
+        }
+        return error;
+    }
+
+    /**
+     * Reduces a sampled property to the samples needed to interpolate it within the max error.
+     * A constant property is reduced to its first sample. Otherwise each key is placed as late as
+     * possible, so that all samples since the previous key are within the error.
+     * @return indices of the kept samples
+     */
+    static int[] reduceProperty(float[] values, int stride, double maxError) {
+        int count = values.length / stride;
+        if (count < 2) {
+            return new int[count];
+        }
+        double[][] tmp = new double[3][4];
+        boolean constant = true;
+        for (int i = 1; i < count && constant; ++i) {
+            constant = keyError(values, stride, 0, 0, i, tmp) <= maxError;
+        }
+        if (constant) {
+            return new int[1];
+        }
+
+        List<Integer> keys = new ArrayList<Integer>();
+        keys.add(0);
+        int key = 0;
+        for (int end = 2; end < count; ++end) {
+            for (int i = key + 1; i < end; ++i) {
+                if (keyError(values, stride, key, end, i, tmp) > maxError) {
+                    key = end - 1;
+                    keys.add(key);
+                    break;
+                }
+            }
+        }
+        keys.add(count - 1);
+
+        int[] result = new int[keys.size()];
+        for (int i = 0; i < result.length; ++i) {
+            result[i] = keys.get(i);
+        }
+        return result;
+    }
+
+    private static float[] toArray(List<Float> list) {
+        float[] values = new float[list.size()];
+        for (int i = 0; i < values.length; ++i) {
+            values[i] = list.get(i);
+        }
+        return values;
+    }
+
+    /**
+     * Compresses a sampled bone track. Constant properties are stored as a single value, the others only
+     * keep the samples needed to stay within the max errors, and rotations are quantized to 64 bits.
+     * Tracks that are already compressed are left as is.
+     */
+    public static void compressTrack(Rig.AnimationTrack.Builder track) {
+        if (track.getPackedRotationsCount() > 0 || track.getPositionKeysCount() > 0 || track.getRotationKeysCount() > 0 || track.getScaleKeysCount() > 0) {
+            return;
+        }
+
+        float[] positions = toArray(track.getPositionsList());
+        double maxPosition = 1.0;
+        for (float p : positions) {
+            maxPosition = Math.max(maxPosition, Math.abs(p));
+        }
+        int[] keys = reduceProperty(positions, 3, COMPRESS_POSITION_ERROR * maxPosition);
+        track.clearPositions();
+        for (int key : keys) {
+            track.addPositions(positions[key * 3 + 0]).addPositions(positions[key * 3 + 1]).addPositions(positions[key * 3 + 2]);
+        }
+        if (keys.length > 1 && keys.length < positions.length / 3) {
+            for (int key : keys) {
+                track.addPositionKeys(key);
+            }
+        }
+
+        float[] rotations = toArray(track.getRotationsList());
+        keys = reduceProperty(rotations, 4, COMPRESS_ROTATION_ERROR);
+        track.clearRotations();
+        double[] q = new double[4];
+        for (int key : keys) {
+            for (int c = 0; c < 4; ++c) {
+                q[c] = rotations[key * 4 + c];
+            }
+            track.addPackedRotations(packQuat(q));
+        }
+        if (keys.length > 1 && keys.length < rotations.length / 4) {
+            for (int key : keys) {
+                track.addRotationKeys(key);
+            }
+        }
+
+        float[] scale = toArray(track.getScaleList());
+        keys = reduceProperty(scale, 3, COMPRESS_SCALE_ERROR);
+        track.clearScale();
+        for (int key : keys) {
+            track.addScale(scale[key * 3 + 0]).addScale(scale[key * 3 + 1]).addScale(scale[key * 3 + 2]);
+        }
+        if (keys.length > 1 && keys.length < scale.length / 3) {
+            for (int key : keys) {
+                track.addScaleKeys(key);
+            }
+        }
+    }
+
+    public static void compressAnimationSet(Rig.AnimationSet.Builder animSetBuilder) {
+        for (int a = 0; a < animSetBuilder.getAnimationsCount(); ++a) {
+            Rig.RigAnimation.Builder animBuilder = animSetBuilder.getAnimations(a).toBuilder();
+            for (int t = 0; t < animBuilder.getTracksCount(); ++t) {
+                Rig.AnimationTrack.Builder trackBuilder = animBuilder.getTracks(t).toBuilder();
+                compressTrack(trackBuilder);
+                animBuilder.setTracks(t, trackBuilder);
+            }
+            animSetBuilder.setAnimations(a, animBuilder);
+        }
+    }
 }
@@ -426,6 +426,9 @@ public class SpineSceneBuilder extends Builder<Void> {
             for (Map.Entry<String, RigUtil.Animation> entry : scene.animations.entrySet()) {
                 animationToDDF(scene, entry.getKey(), entry.getValue(), animSetBuilder, builder.getSampleRate());
             }
+            if (project.getProjectProperties().getBooleanValue("spine", "compress_animations", false)) {
+                RigUtil.compressAnimationSet(animSetBuilder);
+            }
             out = new ByteArrayOutputStream(64 * 1024);
             animSetBuilder.build().writeTo(out);
             out.close();
@@ -77,7 +77,7 @@
   (g/clear-property! node-id property))
 
 (g/defnk produce-form-data
-  [_node-id sound looping group gain pan speed loopcount]
+  [_node-id sound looping group gain pan speed loopcount priority]
   {:navigation false
    :form-ops {:user-data {:node-id _node-id}
               :set set-form-op
@@ -105,6 +105,9 @@
                          {:path [:speed]
                          :label "Speed"
                          :type :number}
+                         {:path [:priority]
+                         :label "Priority"
+                         :type :integer}
                          ]}]
    :values {[:sound] sound
             [:looping] looping
@@ -112,17 +115,19 @@
             [:gain] gain
             [:pan] pan
             [:speed] speed
-            [:loopcount] loopcount}})
+            [:loopcount] loopcount
+            [:priority] priority}})
 
 (g/defnk produce-pb-msg
-  [_node-id sound-resource looping group gain pan speed loopcount]
+  [_node-id sound-resource looping group gain pan speed loopcount priority]
   {:sound (resource/resource->proj-path sound-resource)
    :looping (if looping 1 0)
    :group group
    :gain gain
    :pan pan
    :speed speed
-   :loopcount loopcount})
+   :loopcount loopcount
+   :priority priority})
 
 (defn build-sound
   [resource dep-resources user-data]
@@ -157,7 +162,8 @@
     :gain (:gain sound)
     :pan (:pan sound)
     :speed (:speed sound)
-    :loopcount (:loopcount sound)))
+    :loopcount (:loopcount sound)
+    :priority (:priority sound)))
 
 (def prop-sound_speed? (partial validation/prop-outside-range? [0.1 5.0]))
 
@@ -195,6 +201,9 @@
             (dynamic error (validation/prop-error-fnk :fatal validation/prop-1-1? pan)))
   (property speed g/Num (default 1.0)
             (dynamic error (validation/prop-error-fnk :fatal prop-sound_speed? speed)))
+  (property priority g/Int (default 0)
+            (dynamic error (g/fnk [_node-id priority]
+                             (validation/prop-error :fatal _node-id :priority (partial validation/prop-outside-range? [0 255]) priority "Priority"))))
 
 
 
@@ -178,15 +178,19 @@
                                      (:view render-args)
                                      (:projection render-args)
                                      (:texture render-args)))
-                ;; In the runtime, vertices are in world space. In the editor we
-                ;; prefer to keep the vertices in local space in order to avoid
+                ;; In the runtime, vertices are in world space unless the
+                ;; material is in local vertex space. In the editor we prefer
+                ;; to keep the vertices in local space in order to avoid
                 ;; unnecessary buffer updates. As a workaround, we trick the
                 ;; shader by supplying a world-view-projection matrix for the
-                ;; view-projection matrix. If this turns out to be a problem, we
-                ;; need to produce world-space buffers here in the render
-                ;; function, seeing as we don't have the final world-transform
-                ;; until the scene has been flattened.
-                render-args (assoc render-args :view-proj (:world-view-proj render-args))
+                ;; view-projection matrix, and an identity world matrix for
+                ;; shaders that apply the world transform themselves. If this
+                ;; turns out to be a problem, we need to produce world-space
+                ;; buffers here in the render function, seeing as we don't have
+                ;; the final world-transform until the scene has been flattened.
+                render-args (assoc render-args
+                              :view-proj (:world-view-proj render-args)
+                              :world geom/Identity4d)
                 vertex-binding (vtx/use-with node-id vbuf shader)]
             (gl/with-gl-bindings gl render-args [gpu-texture shader vertex-binding]
               (gl/set-blend-mode gl blend-mode)
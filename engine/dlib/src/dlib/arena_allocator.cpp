@@ -0,0 +1,231 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "arena_allocator.h"
+#include "align.h"
+#include "dstrings.h"
+#include "math.h"
+#include "memory.h"
+#include "profile.h"
+#include "thread.h"
+
+namespace dmArenaAllocator
+{
+    static const uint32_t PAGE_ALIGN = 16;
+    static const uint32_t THREAD_ARENA_PAGE_SIZE = 64 * 1024;
+
+    struct Page
+    {
+        Page*    m_Next;
+        uint32_t m_Size;
+        uint32_t m_Used;
+    };
+
+    static const uint32_t PAGE_HEADER_SIZE = DM_ALIGN(sizeof(Page), PAGE_ALIGN);
+
+    struct Arena
+    {
+        Page*       m_First;
+        Page*       m_Current;
+        uint32_t    m_PageSize;
+        uint32_t    m_Used;
+        uint32_t    m_FramePeak;
+        uint32_t    m_HighWaterMark;
+        const char* m_Name;
+        uint32_t    m_UsedCounterIndex;
+        uint32_t    m_PeakCounterIndex;
+    };
+
+    static dmThread::TlsKey g_ThreadArenaKey = dmThread::AllocTls();
+
+    static inline char* PageData(Page* page)
+    {
+        return (char*) page + PAGE_HEADER_SIZE;
+    }
+
+    static Page* NewPage(uint32_t size)
+    {
+        Page* page = 0;
+        dmMemory::AlignedMalloc((void**) &page, PAGE_ALIGN, PAGE_HEADER_SIZE + size);
+        assert(page);
+        page->m_Next = 0;
+        page->m_Size = size;
+        page->m_Used = 0;
+        return page;
+    }
+
+    static void DeletePages(Page* page)
+    {
+        while (page)
+        {
+            Page* next = page->m_Next;
+            dmMemory::AlignedFree(page);
+            page = next;
+        }
+    }
+
+    HArena New(uint32_t page_size, const char* name)
+    {
+        Arena* arena = new Arena;
+        memset(arena, 0, sizeof(*arena));
+        arena->m_PageSize = DM_ALIGN(dmMath::Max(page_size, PAGE_ALIGN), PAGE_ALIGN);
+        arena->m_First = NewPage(arena->m_PageSize);
+        arena->m_Current = arena->m_First;
+        arena->m_Name = name;
+        arena->m_UsedCounterIndex = 0xffffffffu;
+        arena->m_PeakCounterIndex = 0xffffffffu;
+        return arena;
+    }
+
+    void Delete(HArena arena)
+    {
+        DeletePages(arena->m_First);
+        delete arena;
+    }
+
+    // Move on to the next page, reusing the pages kept from earlier frames when they fit
+    static Page* NextPage(HArena arena, uint32_t size)
+    {
+        Page* current = arena->m_Current;
+        Page* next = current->m_Next;
+        if (!next || next->m_Size < size)
+        {
+            Page* page = NewPage(dmMath::Max(arena->m_PageSize, (uint32_t) DM_ALIGN(size, PAGE_ALIGN)));
+            page->m_Next = next;
+            current->m_Next = page;
+            next = page;
+        }
+        next->m_Used = 0;
+        arena->m_Current = next;
+        return next;
+    }
+
+    void* Alloc(HArena arena, uint32_t size, uint32_t align)
+    {
+        assert(align <= PAGE_ALIGN && (align & (align - 1)) == 0);
+
+        Page* page = arena->m_Current;
+        uint32_t offset = DM_ALIGN(page->m_Used, align);
+        if (offset > page->m_Size || size > page->m_Size - offset)
+        {
+            page = NextPage(arena, size);
+            offset = 0;
+        }
+
+        arena->m_Used += offset + size - page->m_Used;
+        page->m_Used = offset + size;
+        if (arena->m_Used > arena->m_FramePeak)
+        {
+            arena->m_FramePeak = arena->m_Used;
+            if (arena->m_Used > arena->m_HighWaterMark)
+                arena->m_HighWaterMark = arena->m_Used;
+        }
+        return PageData(page) + offset;
+    }
+
+    Marker GetMarker(HArena arena)
+    {
+        Marker marker;
+        marker.m_Page = arena->m_Current;
+        marker.m_Offset = arena->m_Current->m_Used;
+        marker.m_Used = arena->m_Used;
+        return marker;
+    }
+
+    void ResetToMarker(HArena arena, const Marker& marker)
+    {
+        Page* page = (Page*) marker.m_Page;
+        assert(marker.m_Offset <= page->m_Size);
+        page->m_Used = marker.m_Offset;
+        arena->m_Current = page;
+        arena->m_Used = marker.m_Used;
+    }
+
+    static void UpdateCounters(HArena arena)
+    {
+        if (!arena->m_Name || !dmProfile::g_IsInitialized)
+            return;
+
+        if (arena->m_UsedCounterIndex == 0xffffffffu)
+        {
+            char peak_name[128];
+            dmSnPrintf(peak_name, sizeof(peak_name), "%sPeak", arena->m_Name);
+            uint32_t peak_name_length = (uint32_t) strlen(peak_name);
+            const char* peak_name_internal = dmProfile::Internalize(peak_name, peak_name_length, dmProfile::GetNameHash(peak_name, peak_name_length));
+            if (!peak_name_internal)
+                return;
+            arena->m_UsedCounterIndex = dmProfile::AllocateCounter(arena->m_Name);
+            arena->m_PeakCounterIndex = dmProfile::AllocateCounter(peak_name_internal);
+        }
+
+        if (arena->m_UsedCounterIndex != 0xffffffffu)
+            dmProfile::AddCounterIndex(arena->m_UsedCounterIndex, arena->m_FramePeak);
+        if (arena->m_PeakCounterIndex != 0xffffffffu)
+            dmProfile::AddCounterIndex(arena->m_PeakCounterIndex, arena->m_HighWaterMark);
+    }
+
+    void Reset(HArena arena)
+    {
+        UpdateCounters(arena);
+
+        // The last frame didn't fit in the first page. Merge all pages into one that fits the
+        // high-water mark, to keep the memory contiguous and avoid walking the pages each frame.
+        if (arena->m_First->m_Next)
+        {
+            uint32_t page_size = DM_ALIGN(dmMath::Max(arena->m_HighWaterMark, arena->m_PageSize), arena->m_PageSize);
+            DeletePages(arena->m_First);
+            arena->m_First = NewPage(page_size);
+        }
+
+        arena->m_First->m_Used = 0;
+        arena->m_Current = arena->m_First;
+        arena->m_Used = 0;
+        arena->m_FramePeak = 0;
+    }
+
+    void GetStats(HArena arena, Stats* stats)
+    {
+        stats->m_Used = arena->m_Used;
+        stats->m_FramePeak = arena->m_FramePeak;
+        stats->m_HighWaterMark = arena->m_HighWaterMark;
+        stats->m_Capacity = 0;
+        for (Page* page = arena->m_First; page; page = page->m_Next)
+        {
+            stats->m_Capacity += page->m_Size;
+        }
+    }
+
+    HArena GetThreadArena()
+    {
+        HArena arena = (HArena) dmThread::GetTlsValue(g_ThreadArenaKey);
+        if (!arena)
+        {
+            arena = New(THREAD_ARENA_PAGE_SIZE, "ThreadArena");
+            dmThread::SetTlsValue(g_ThreadArenaKey, arena);
+        }
+        return arena;
+    }
+
+    void DeleteThreadArena()
+    {
+        HArena arena = (HArena) dmThread::GetTlsValue(g_ThreadArenaKey);
+        if (arena)
+        {
+            Delete(arena);
+            dmThread::SetTlsValue(g_ThreadArenaKey, 0);
+        }
+    }
+}
@@ -0,0 +1,141 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_ARENA_ALLOCATOR_H
+#define DM_ARENA_ALLOCATOR_H
+
+#include <stdint.h>
+#include <string.h>
+#include <dmsdk/dlib/array.h>
+
+/**
+ * Linear arena allocator for transient, typically per-frame, data. Allocation is a pointer bump and
+ * nothing is freed individually. Instead the arena is reset, usually once per frame, or rewound to a marker.
+ * Memory is kept between resets, and when a frame needed more than one page the pages are merged
+ * into a single page of the high-water size on the next reset.
+ *
+ * Not thread safe. Use #GetThreadArena for per-thread arenas.
+ */
+namespace dmArenaAllocator
+{
+    /// Arena handle
+    typedef struct Arena* HArena;
+
+    /// Position in an arena, see #GetMarker
+    struct Marker
+    {
+        void*    m_Page;
+        uint32_t m_Offset;
+        uint32_t m_Used;
+    };
+
+    /// Arena memory statistics
+    struct Stats
+    {
+        /// Bytes currently allocated
+        uint32_t m_Used;
+        /// Max bytes allocated since the last reset
+        uint32_t m_FramePeak;
+        /// Max bytes allocated since the arena was created
+        uint32_t m_HighWaterMark;
+        /// Total size of the pages owned by the arena
+        uint32_t m_Capacity;
+    };
+
+    /**
+     * Create a new arena
+     * @param page_size initial page size
+     * @param name name of the profiler counters, the bytes used each frame and "<name>Peak" for the high-water mark.
+     * Must be a literal or outlive the profiler. Can be 0.
+     * @return arena handle
+     */
+    HArena New(uint32_t page_size, const char* name);
+
+    /**
+     * Delete arena and free all memory
+     * @param arena arena handle
+     */
+    void Delete(HArena arena);
+
+    /**
+     * Allocate memory. Allocations larger than the page size get a page of their own.
+     * @param arena arena handle
+     * @param size size
+     * @param align alignment, power of two
+     * @return pointer to memory, valid until the arena is reset or rewound past it
+     */
+    void* Alloc(HArena arena, uint32_t size, uint32_t align);
+
+    /**
+     * Get the current position, to later free everything allocated after it with #ResetToMarker
+     * @param arena arena handle
+     * @return marker
+     */
+    Marker GetMarker(HArena arena);
+
+    /**
+     * Free everything allocated since the marker was taken
+     * @param arena arena handle
+     * @param marker marker from #GetMarker, taken after the last #Reset
+     */
+    void ResetToMarker(HArena arena, const Marker& marker);
+
+    /**
+     * Free all allocations, typically at the end of a frame. Adds the peak since the last reset and the
+     * high-water mark to the profiler counters, so an arena reset several times a frame reports the sums.
+     * @param arena arena handle
+     */
+    void Reset(HArena arena);
+
+    /**
+     * Get memory statistics
+     * @param arena arena handle
+     * @param stats [out] statistics
+     */
+    void GetStats(HArena arena, Stats* stats);
+
+    /**
+     * Get the arena of the calling thread, created on first use. The thread owns the arena
+     * and is responsible for resetting it.
+     * @return arena handle
+     */
+    HArena GetThreadArena();
+
+    /**
+     * Delete the arena of the calling thread, if any. Call before the thread exits.
+     */
+    void DeleteThreadArena();
+
+    /**
+     * Set the capacity of an array to storage allocated from the arena. The elements that fit are copied,
+     * also from storage in the same arena that was freed by #ResetToMarker.
+     * The array becomes user allocated, so the capacity may only be changed through this function
+     * until it is reset with a regular array, and it must not be used after the arena is reset.
+     * @param arena arena handle
+     * @param array array
+     * @param capacity new capacity
+     */
+    template <typename T>
+    void SetCapacity(HArena arena, dmArray<T>& array, uint32_t capacity)
+    {
+        T* buffer = (T*) Alloc(arena, capacity * sizeof(T), 16);
+        uint32_t size = array.Size() < capacity ? array.Size() : capacity;
+        if (size)
+        {
+            memmove(buffer, array.Begin(), size * sizeof(T));
+        }
+        dmArray<T> tmp(buffer, size, capacity);
+        array.Swap(tmp);
+    }
+}
+
+#endif // DM_ARENA_ALLOCATOR_H
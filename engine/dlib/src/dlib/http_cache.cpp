@@ -28,6 +28,7 @@
 #include "array.h"
 #include "poolallocator.h"
 #include "path.h"
+#include "align.h"
 #include <dlib/mutex.h>
 
 namespace dmHttpCache
@@ -35,7 +36,7 @@ namespace dmHttpCache
     // Magic file header for index file
     const uint32_t MAGIC = 0xCAAAAAAC;
     // Current index file version
-    const uint32_t VERSION = 7;
+    const uint32_t VERSION = 8;
 
     // Maximum number of cache entry creations in flight
     const uint32_t MAX_CACHE_CREATORS = 16;
@@ -51,6 +52,9 @@ namespace dmHttpCache
         uint64_t m_Checksum;
         uint32_t m_SizeOfEntry;     // Making sure the size is double checked
         uint32_t m_SizeOfFileEntry; // Making sure the size is double checked
+        // Number of entries in the payload
+        uint32_t m_EntryCount;
+        uint32_t m_Reserved;
     };
 
     /*
@@ -68,15 +72,13 @@ namespace dmHttpCache
     };
 
     /*
-     * Disk (index) representation of a cache entry
+     * Disk (index) representation of a cache entry. The URI follows the entry,
+     * without null-termination and padded to FILE_ENTRY_ALIGN bytes. Storing the URI
+     * in full size (MAX_URI_LEN) made the index of a large cache tens of megabytes.
      */
     struct FileEntry
     {
         uint64_t m_UriHash;
-        // ETag string
-        char     m_ETag[MAX_TAG_LEN];
-        // Path string
-        char     m_URI[MAX_URI_LEN];
         // The content hash is the hash of URI and ETag.
         uint64_t m_IdentifierHash;
         // Last accessed time
@@ -85,8 +87,15 @@ namespace dmHttpCache
         uint64_t m_Expires;
         // Checksum
         uint64_t m_Checksum;
+        // ETag string
+        char     m_ETag[MAX_TAG_LEN];
+        // Length of the URI that follows
+        uint32_t m_URILength;
+        uint32_t m_Reserved;
     };
 
+    const uint32_t FILE_ENTRY_ALIGN = 8;
+
     /*
      * Cache entry creation state
      */
@@ -112,6 +121,7 @@ namespace dmHttpCache
             m_MaxCacheEntryAge = max_entry_age;
             m_CacheTable.SetCapacity(11, 32);
             m_Mutex = dmMutex::New();
+            m_FlushMutex = dmMutex::New();
             m_Policy = CONSISTENCY_POLICY_VERIFY;
             m_StringAllocator = dmPoolAllocator::New(4096);
             m_Dirty = false;
@@ -121,13 +131,17 @@ namespace dmHttpCache
         {
             free(m_Path);
             dmMutex::Delete(m_Mutex);
+            dmMutex::Delete(m_FlushMutex);
             dmPoolAllocator::Delete(m_StringAllocator);
         }
 
         char*                m_Path;
         uint64_t             m_MaxCacheEntryAge;
         dmHashTable64<Entry> m_CacheTable;
+        // Protects the cache table. File operations are done without holding it.
         dmMutex::HMutex      m_Mutex;
+        // Serializes writing of the index file
+        dmMutex::HMutex      m_FlushMutex;
         dmIndexPool16        m_CacheCreatorsPool;
         dmArray<CacheCreator> m_CacheCreators;
         ConsistencyPolicy    m_Policy;
@@ -245,29 +259,43 @@ namespace dmHttpCache
                 }
                 else
                 {
-                    uint32_t n_entries = (size - sizeof(IndexHeader)) / sizeof(FileEntry);
-                    FileEntry* entries = (FileEntry*) (((uintptr_t) buffer) + sizeof(IndexHeader));
+                    uint32_t n_entries = header->m_EntryCount;
+                    const uint8_t* cursor = (const uint8_t*) buffer + sizeof(IndexHeader);
+                    const uint8_t* end = (const uint8_t*) buffer + size;
                     uint32_t capacity = n_entries + 128;
                     c->m_CacheTable.SetCapacity(2 * capacity / 3, capacity);
                     uint64_t current_time = dmTime::GetTime();
                     for (uint32_t i = 0; i < n_entries; ++i)
                     {
-                        if (entries[i].m_LastAccessed + c->m_MaxCacheEntryAge >= current_time)
+                        const FileEntry* file_entry = (const FileEntry*) cursor;
+                        if (cursor + sizeof(FileEntry) > end ||
+                            file_entry->m_URILength >= MAX_URI_LEN ||
+                            cursor + sizeof(FileEntry) + DM_ALIGN(file_entry->m_URILength, FILE_ENTRY_ALIGN) > end)
+                        {
+                            dmLogError("Truncated cache index file '%s'", cache_file);
+                            break;
+                        }
+                        const char* uri = (const char*) (cursor + sizeof(FileEntry));
+                        cursor += sizeof(FileEntry) + DM_ALIGN(file_entry->m_URILength, FILE_ENTRY_ALIGN);
+
+                        if (file_entry->m_LastAccessed + c->m_MaxCacheEntryAge >= current_time)
                         {
                             // Keep cache entry, ie within max age
                             Entry e;
-                            memcpy(e.m_Info.m_ETag, entries[i].m_ETag, sizeof(e.m_Info.m_ETag));
-                            e.m_Info.m_URI = dmPoolAllocator::Duplicate(c->m_StringAllocator, entries[i].m_URI);
-                            e.m_Info.m_IdentifierHash = entries[i].m_IdentifierHash;
-                            e.m_Info.m_LastAccessed = entries[i].m_LastAccessed;
-                            e.m_Info.m_Expires = entries[i].m_Expires;
-                            e.m_Info.m_Checksum = entries[i].m_Checksum;
-                            c->m_CacheTable.Put(entries[i].m_UriHash, e);
+                            memcpy(e.m_Info.m_ETag, file_entry->m_ETag, sizeof(e.m_Info.m_ETag));
+                            e.m_Info.m_URI = (char*) dmPoolAllocator::Alloc(c->m_StringAllocator, file_entry->m_URILength + 1);
+                            memcpy(e.m_Info.m_URI, uri, file_entry->m_URILength);
+                            e.m_Info.m_URI[file_entry->m_URILength] = '\0';
+                            e.m_Info.m_IdentifierHash = file_entry->m_IdentifierHash;
+                            e.m_Info.m_LastAccessed = file_entry->m_LastAccessed;
+                            e.m_Info.m_Expires = file_entry->m_Expires;
+                            e.m_Info.m_Checksum = file_entry->m_Checksum;
+                            c->m_CacheTable.Put(file_entry->m_UriHash, e);
                         }
                         else
                         {
                             // Remove old cache entry
-                            RemoveCachedContentFile(c, entries[i].m_IdentifierHash);
+                            RemoveCachedContentFile(c, file_entry->m_IdentifierHash);
                         }
                     }
                 }
@@ -282,107 +310,103 @@ namespace dmHttpCache
 
     struct WriteEntryContext
     {
-        FILE* m_File;
-        bool m_Error;
-        HashState64 m_HashState;
-        WriteEntryContext(FILE* f)
-        {
-            m_File = f;
-            m_Error = false;
-            dmHashInit64(&m_HashState, false);
-        }
+        dmArray<uint8_t>* m_Buffer;
+        uint32_t          m_EntryCount;
     };
 
     static void WriteEntry(WriteEntryContext* context, const uint64_t* key, Entry* entry)
     {
-        if (context->m_Error)
-            return;
-
         if(entry->m_WriteLock)
         {
             dmLogWarning("Invalid http cache state. Not yet flushed cache entry (etag: %s).", entry->m_Info.m_ETag);
             return;
         }
 
-        FileEntry file_entry;
-        memset(&file_entry, 0, sizeof(file_entry));
+        uint32_t uri_length = dmMath::Min((uint32_t) strlen(entry->m_Info.m_URI), MAX_URI_LEN - 1);
+        uint32_t record_size = sizeof(FileEntry) + DM_ALIGN(uri_length, FILE_ENTRY_ALIGN);
 
-        file_entry.m_UriHash = *key;
-        memcpy(file_entry.m_ETag, entry->m_Info.m_ETag, sizeof(file_entry.m_ETag));
-        dmStrlCpy(file_entry.m_URI, entry->m_Info.m_URI, sizeof(file_entry.m_URI));
-        file_entry.m_IdentifierHash = entry->m_Info.m_IdentifierHash;
-        file_entry.m_LastAccessed = entry->m_Info.m_LastAccessed;
-        file_entry.m_Expires = entry->m_Info.m_Expires;
-        file_entry.m_Checksum = entry->m_Info.m_Checksum;
-
-        dmHashUpdateBuffer64(&context->m_HashState, &file_entry, sizeof(file_entry));
-        size_t n_written = fwrite(&file_entry, 1, sizeof(file_entry), context->m_File);
-        if (n_written != sizeof(file_entry))
+        dmArray<uint8_t>& buffer = *context->m_Buffer;
+        if (buffer.Remaining() < record_size)
         {
-            context->m_Error = true;
+            buffer.OffsetCapacity(dmMath::Max(record_size, buffer.Capacity() / 2));
         }
+        uint32_t offset = buffer.Size();
+        buffer.SetSize(offset + record_size);
+        memset(&buffer[offset], 0, record_size);
+
+        FileEntry* file_entry = (FileEntry*) &buffer[offset];
+        file_entry->m_UriHash = *key;
+        memcpy(file_entry->m_ETag, entry->m_Info.m_ETag, sizeof(file_entry->m_ETag));
+        file_entry->m_IdentifierHash = entry->m_Info.m_IdentifierHash;
+        file_entry->m_LastAccessed = entry->m_Info.m_LastAccessed;
+        file_entry->m_Expires = entry->m_Info.m_Expires;
+        file_entry->m_Checksum = entry->m_Info.m_Checksum;
+        file_entry->m_URILength = uri_length;
+        memcpy(&buffer[offset + sizeof(FileEntry)], entry->m_Info.m_URI, uri_length);
+
+        context->m_EntryCount++;
     }
 
-    static Result WriteIndex(HCache cache, FILE* f)
+    // Serialize the index to memory, header included
+    static void WriteIndex(HCache cache, dmArray<uint8_t>& buffer)
     {
-        IndexHeader header;
-
-        header.m_Magic = MAGIC;
-        header.m_Version = VERSION;
-        header.m_Checksum = 0;
-        header.m_SizeOfEntry = (uint32_t)sizeof(Entry);
-        header.m_SizeOfFileEntry = (uint32_t)sizeof(FileEntry);
-        size_t n_written = fwrite(&header, 1, sizeof(header), f);
-        if (n_written != sizeof(header))
-        {
-            return RESULT_IO_ERROR;
-        }
-        else
-        {
-            WriteEntryContext context(f);
-            cache->m_CacheTable.Iterate(&WriteEntry, &context);
-            if (context.m_Error)
-            {
-                return RESULT_IO_ERROR;
-            }
-            else
-            {
-                // Rewrite header with checksum
-                fseek(f, 0, SEEK_SET);
-                header.m_Checksum = dmHashFinal64(&context.m_HashState);
-                size_t n_written = fwrite(&header, 1, sizeof(header), f);
-                if (n_written != sizeof(header))
-                {
-                    return RESULT_IO_ERROR;
-                }
-            }
-        }
-        return RESULT_OK;
+        buffer.SetCapacity(sizeof(IndexHeader) + cache->m_CacheTable.Size() * (sizeof(FileEntry) + 64));
+        buffer.SetSize(sizeof(IndexHeader));
+
+        WriteEntryContext context;
+        context.m_Buffer = &buffer;
+        context.m_EntryCount = 0;
+        cache->m_CacheTable.Iterate(&WriteEntry, &context);
+
+        IndexHeader* header = (IndexHeader*) buffer.Begin();
+        memset(header, 0, sizeof(*header));
+        header->m_Magic = MAGIC;
+        header->m_Version = VERSION;
+        header->m_SizeOfEntry = (uint32_t)sizeof(Entry);
+        header->m_SizeOfFileEntry = (uint32_t)sizeof(FileEntry);
+        header->m_EntryCount = context.m_EntryCount;
+        header->m_Checksum = dmHashBuffer64(buffer.Begin() + sizeof(IndexHeader), buffer.Size() - sizeof(IndexHeader));
     }
 
     Result Flush(HCache cache)
     {
-        dmMutex::ScopedLock lock(cache->m_Mutex);
-        if (!cache->m_Dirty) {
-            return RESULT_OK;
+        dmMutex::ScopedLock flush_lock(cache->m_FlushMutex);
+
+        // Only the snapshot of the index is taken under the cache lock, so
+        // requests aren't blocked while the index is written to disk
+        dmArray<uint8_t> buffer;
+        {
+            dmMutex::ScopedLock lock(cache->m_Mutex);
+            if (!cache->m_Dirty) {
+                return RESULT_OK;
+            }
+
+            cache->m_Dirty = false;
+            WriteIndex(cache, buffer);
         }
 
-        cache->m_Dirty = false;
         dmLogInfo("Flushing http cache to disk");
 
+        // Write to a temporary file and rename it, so the index is never left half written
         char cache_file[DMPATH_MAX_PATH];
+        char tmp_cache_file[DMPATH_MAX_PATH];
         dmSnPrintf(cache_file, sizeof(cache_file), "%s/%s", cache->m_Path, "index");
-        FILE* f = fopen(cache_file, "wb");
+        dmSnPrintf(tmp_cache_file, sizeof(tmp_cache_file), "%s/%s", cache->m_Path, "index.tmp");
+        FILE* f = fopen(tmp_cache_file, "wb");
         if (f) {
-            Result r = WriteIndex(cache, f);
+            size_t n_written = fwrite(buffer.Begin(), 1, buffer.Size(), f);
             fclose(f);
-            if (r != RESULT_OK) {
+            if (n_written != buffer.Size() || dmSys::RenameFile(cache_file, tmp_cache_file) != dmSys::RESULT_OK) {
                 dmLogError("Error writing to index file '%s'", cache_file);
-                dmSys::Unlink(cache_file);
+                dmSys::Unlink(tmp_cache_file);
+                dmMutex::ScopedLock lock(cache->m_Mutex);
+                cache->m_Dirty = true;
                 return RESULT_IO_ERROR;
             }
         } else {
-            dmLogError("Unable to open index file '%s'", cache_file);
+            dmLogError("Unable to open index file '%s'", tmp_cache_file);
+            dmMutex::ScopedLock lock(cache->m_Mutex);
+            cache->m_Dirty = true;
             return RESULT_IO_ERROR;
         }
 
@@ -547,29 +571,12 @@ namespace dmHttpCache
         return RESULT_OK;
     }
 
-    Result End(HCache cache, HCacheCreator cache_creator)
+    // Move the finished temporary file into place. The entry is write locked, so no
+    // one else is reading or writing the content file and the cache lock isn't needed.
+    static Result MoveContentFile(HCache cache, HCacheCreator cache_creator)
     {
-        dmMutex::ScopedLock lock(cache->m_Mutex);
-
-        assert(cache_creator->m_File && cache_creator->m_Filename);
-        uint64_t identifier_hash = cache_creator->m_IdentifierHash;
-
-        fclose(cache_creator->m_File);
-        cache_creator->m_File = 0;
-
-        uint64_t uri_hash = cache_creator->m_UriHash;
-        Entry* entry = cache->m_CacheTable.Get(uri_hash);
-        assert(entry);
-
-        if (cache_creator->m_Error)
-        {
-            FreeCacheCreator(cache, cache_creator);
-            cache->m_CacheTable.Erase(uri_hash);
-            return RESULT_IO_ERROR;
-        }
-
         char path[DMPATH_MAX_PATH];
-        ContentFilePath(cache, identifier_hash, path, sizeof(path));
+        ContentFilePath(cache, cache_creator->m_IdentifierHash, path, sizeof(path));
         struct stat stat_data;
         if (stat(path, &stat_data) == 0)
         {
@@ -577,8 +584,6 @@ namespace dmHttpCache
             if (r != dmSys::RESULT_OK)
             {
                 dmLogError("Unable to remove cache file: %s", path);
-                FreeCacheCreator(cache, cache_creator);
-                cache->m_CacheTable.Erase(uri_hash);
                 return RESULT_IO_ERROR;
             }
         }
@@ -597,30 +602,55 @@ namespace dmHttpCache
                 if (r != dmSys::RESULT_OK)
                 {
                     dmLogError("Unable to create directory '%s'", path);
-                    FreeCacheCreator(cache, cache_creator);
-                    cache->m_CacheTable.Erase(uri_hash);
                     return RESULT_IO_ERROR;
                 }
             }
             *last_slash = save;
         }
 
-        assert(entry->m_WriteLock);
-        assert(entry->m_Info.m_IdentifierHash == identifier_hash);
-        entry->m_WriteLock = 0;
-        entry->m_Info.m_Checksum = dmHashFinal64(&cache_creator->m_ChecksumState);
-
         int ret = rename(cache_creator->m_Filename, path);
         if (ret != 0)
         {
             // TODO: strerror is not thread-safe.
             char* error_msg = strerror(errno);
             dmLogError("Unable to rename temporary cache file from '%s' to '%s'. %s (%d)", cache_creator->m_Filename, path, error_msg, errno);
+            return RESULT_IO_ERROR;
+        }
+        return RESULT_OK;
+    }
+
+    Result End(HCache cache, HCacheCreator cache_creator)
+    {
+        assert(cache_creator->m_File && cache_creator->m_Filename);
+        uint64_t identifier_hash = cache_creator->m_IdentifierHash;
+
+        fclose(cache_creator->m_File);
+        cache_creator->m_File = 0;
+
+        Result r = RESULT_IO_ERROR;
+        if (!cache_creator->m_Error)
+        {
+            r = MoveContentFile(cache, cache_creator);
+        }
+
+        dmMutex::ScopedLock lock(cache->m_Mutex);
+
+        uint64_t uri_hash = cache_creator->m_UriHash;
+        Entry* entry = cache->m_CacheTable.Get(uri_hash);
+        assert(entry);
+
+        if (r != RESULT_OK)
+        {
             FreeCacheCreator(cache, cache_creator);
             cache->m_CacheTable.Erase(uri_hash);
-            return RESULT_IO_ERROR;
+            return r;
         }
 
+        assert(entry->m_WriteLock);
+        assert(entry->m_Info.m_IdentifierHash == identifier_hash);
+        entry->m_WriteLock = 0;
+        entry->m_Info.m_Checksum = dmHashFinal64(&cache_creator->m_ChecksumState);
+
         FreeCacheCreator(cache, cache_creator);
         cache->m_Dirty = true;
 
@@ -668,8 +698,6 @@ namespace dmHttpCache
 
     Result Get(HCache cache, const char* uri, const char* etag, FILE** file, uint64_t* checksum)
     {
-        dmMutex::ScopedLock lock(cache->m_Mutex);
-
         HashState64 hash_state;
         dmHashInit64(&hash_state, false);
         dmHashUpdateBuffer64(&hash_state, uri, strlen(uri));
@@ -677,9 +705,16 @@ namespace dmHttpCache
         uint64_t identifier_hash = dmHashFinal64(&hash_state);
 
         uint64_t uri_hash = dmHashString64(uri);
-        Entry* entry = cache->m_CacheTable.Get(uri_hash);
-        if (entry != 0 && entry->m_Info.m_IdentifierHash == identifier_hash)
+
+        // The entry is read locked while the file is opened without holding the cache lock
         {
+            dmMutex::ScopedLock lock(cache->m_Mutex);
+            Entry* entry = cache->m_CacheTable.Get(uri_hash);
+            if (entry == 0 || entry->m_Info.m_IdentifierHash != identifier_hash)
+            {
+                return RESULT_NO_ENTRY;
+            }
+
             if (entry->m_WriteLock)
             {
                 dmLogWarning("Cache entry locked.");
@@ -687,26 +722,30 @@ namespace dmHttpCache
             }
 
             entry->m_Info.m_LastAccessed = dmTime::GetTime();
+            entry->m_ReadLockCount++;
+            *checksum = entry->m_Info.m_Checksum;
+        }
 
-            char path[DMPATH_MAX_PATH];
-            ContentFilePath(cache, identifier_hash, path, sizeof(path));
-            FILE* f = fopen(path, "rb");
-            if (f)
-            {
-                *file = f;
-                entry->m_ReadLockCount++;
-                *checksum = entry->m_Info.m_Checksum;
-                return RESULT_OK;
-            }
-            else
-            {
-                dmLogError("Unable to open %s", path);
-                // Remove invalid cache entry
-                cache->m_CacheTable.Erase(uri_hash);
-                return RESULT_NO_ENTRY;
-            }
+        char path[DMPATH_MAX_PATH];
+        ContentFilePath(cache, identifier_hash, path, sizeof(path));
+        FILE* f = fopen(path, "rb");
+        if (f)
+        {
+            *file = f;
+            return RESULT_OK;
         }
 
+        dmLogError("Unable to open %s", path);
+
+        dmMutex::ScopedLock lock(cache->m_Mutex);
+        Entry* entry = cache->m_CacheTable.Get(uri_hash);
+        assert(entry && entry->m_ReadLockCount > 0);
+        --entry->m_ReadLockCount;
+        // Remove invalid cache entry, unless someone else is still reading it
+        if (entry->m_ReadLockCount == 0)
+        {
+            cache->m_CacheTable.Erase(uri_hash);
+        }
         return RESULT_NO_ENTRY;
     }
 
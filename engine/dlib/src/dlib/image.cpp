@@ -14,6 +14,18 @@
 #include <dlib/log.h>
 #include "image.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DM_IMAGE_SSE2
+    #if defined(__SSSE3__)
+        #include <tmmintrin.h>
+        #define DM_IMAGE_SSSE3
+    #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define DM_IMAGE_NEON
+#endif
+
 //#define STBI_NO_JPEG
 //#define STBI_NO_PNG
 #define STBI_NO_BMP
@@ -33,19 +45,142 @@
 
 namespace dmImage
 {
+    // Premultiply pixel_count RGBA pixels from src to dst. src and dst may be the same buffer.
+    // Each channel becomes (c * a + 255) >> 8, with the alpha unchanged.
+    static void PremultiplyPixels(const uint8_t* src, uint8_t* dst, uint32_t pixel_count)
+    {
+        uint32_t i = 0;
+#if defined(DM_IMAGE_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(255);
+        const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+        for (; i + 4 <= pixel_count; i += 4)
+        {
+            __m128i pixels = _mm_loadu_si128((const __m128i*) (src + i * 4));
+            __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+            __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+            __m128i alpha_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3));
+            __m128i alpha_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3));
+            lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, alpha_lo), bias), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, alpha_hi), bias), 8);
+            __m128i result = _mm_packus_epi16(lo, hi);
+            result = _mm_or_si128(_mm_andnot_si128(alpha_mask, result), _mm_and_si128(alpha_mask, pixels));
+            _mm_storeu_si128((__m128i*) (dst + i * 4), result);
+        }
+#elif defined(DM_IMAGE_NEON)
+        const uint16x8_t bias = vdupq_n_u16(255);
+        for (; i + 8 <= pixel_count; i += 8)
+        {
+            uint8x8x4_t pixels = vld4_u8(src + i * 4);
+            uint8x8_t a = pixels.val[3];
+            pixels.val[0] = vshrn_n_u16(vaddq_u16(vmull_u8(pixels.val[0], a), bias), 8);
+            pixels.val[1] = vshrn_n_u16(vaddq_u16(vmull_u8(pixels.val[1], a), bias), 8);
+            pixels.val[2] = vshrn_n_u16(vaddq_u16(vmull_u8(pixels.val[2], a), bias), 8);
+            vst4_u8(dst + i * 4, pixels);
+        }
+#endif
+        for (; i < pixel_count; ++i)
+        {
+            const uint8_t* s = src + i * 4;
+            uint8_t* d = dst + i * 4;
+            uint32_t a = s[3];
+            d[0] = (uint8_t) ((s[0] * a + 255) >> 8);
+            d[1] = (uint8_t) ((s[1] * a + 255) >> 8);
+            d[2] = (uint8_t) ((s[2] * a + 255) >> 8);
+            d[3] = (uint8_t) a;
+        }
+    }
+
     void Premultiply(uint8_t* buffer, int width, int height)
     {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                int index = (y * width + x) * 4;
-                uint32_t a = buffer[index + 3];
-                uint32_t r = (buffer[index + 0] * a + 255) >> 8;
-                uint32_t g = (buffer[index + 1] * a + 255) >> 8;
-                uint32_t b = (buffer[index + 2] * a + 255) >> 8;
-                buffer[index + 0] = r;
-                buffer[index + 1] = g;
-                buffer[index + 2] = b;
+        PremultiplyPixels(buffer, buffer, (uint32_t) width * (uint32_t) height);
+    }
+
+    void ConvertRGBToRGBA(const uint8_t* rgb, uint8_t* rgba, uint32_t pixel_count)
+    {
+        uint32_t i = 0;
+#if defined(DM_IMAGE_SSSE3)
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32(0xff000000);
+        // Reads 16 bytes for 4 pixels (12 bytes), so stop early enough not to read past the source
+        for (; i + 6 <= pixel_count; i += 4)
+        {
+            __m128i pixels = _mm_loadu_si128((const __m128i*) (rgb + i * 3));
+            _mm_storeu_si128((__m128i*) (rgba + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+        }
+#elif defined(DM_IMAGE_NEON)
+        for (; i + 8 <= pixel_count; i += 8)
+        {
+            uint8x8x3_t pixels = vld3_u8(rgb + i * 3);
+            uint8x8x4_t result;
+            result.val[0] = pixels.val[0];
+            result.val[1] = pixels.val[1];
+            result.val[2] = pixels.val[2];
+            result.val[3] = vdup_n_u8(255);
+            vst4_u8(rgba + i * 4, result);
+        }
+#else
+        // Unaligned 32-bit loads, the fourth byte being the next pixel's red
+        for (; i + 2 <= pixel_count; ++i)
+        {
+            uint32_t pixel;
+            memcpy(&pixel, rgb + i * 3, 4);
+            const uint8_t alpha[4] = {0, 0, 0, 255};
+            uint32_t alpha_mask;
+            memcpy(&alpha_mask, alpha, 4);
+            pixel = (pixel & ~alpha_mask) | alpha_mask;
+            memcpy(rgba + i * 4, &pixel, 4);
+        }
+#endif
+        for (; i < pixel_count; ++i)
+        {
+            rgba[i * 4 + 0] = rgb[i * 3 + 0];
+            rgba[i * 4 + 1] = rgb[i * 3 + 1];
+            rgba[i * 4 + 2] = rgb[i * 3 + 2];
+            rgba[i * 4 + 3] = 255;
+        }
+    }
+
+    void FlipVertical(uint8_t* buffer, uint32_t width, uint32_t height, Type type)
+    {
+        if (height < 2)
+            return;
+        uint32_t stride = width * BytesPerPixel(type);
+        uint8_t tmp[1024];
+        uint8_t* top = buffer;
+        uint8_t* bottom = buffer + (height - 1) * stride;
+        for (uint32_t y = 0; y < height / 2; ++y)
+        {
+            // Swap the rows in chunks, memcpy is vectorized already
+            for (uint32_t x = 0; x < stride; x += sizeof(tmp))
+            {
+                uint32_t n = stride - x < sizeof(tmp) ? stride - x : sizeof(tmp);
+                memcpy(tmp, top + x, n);
+                memcpy(top + x, bottom + x, n);
+                memcpy(bottom + x, tmp, n);
             }
+            top += stride;
+            bottom -= stride;
+        }
+    }
+
+    static Result ToType(int comp, bool expand_rgb, Type* type)
+    {
+        switch (comp) {
+        case 1:
+        case 2:
+            // Luminance + alpha is converted to luminance
+            *type = TYPE_LUMINANCE;
+            return RESULT_OK;
+        case 3:
+            *type = expand_rgb ? TYPE_RGBA : TYPE_RGB;
+            return RESULT_OK;
+        case 4:
+            *type = TYPE_RGBA;
+            return RESULT_OK;
+        default:
+            dmLogError("Unexpected number of components in image (%d)", comp);
+            return RESULT_IMAGE_ERROR;
         }
     }
 
@@ -59,29 +194,15 @@ namespace dmImage
             Image i;
             i.m_Width = (uint32_t) x;
             i.m_Height = (uint32_t) y;
-            switch (comp) {
-            case 1:
-                i.m_Type = TYPE_LUMINANCE;
-                break;
-            case 2:
-                // Luminance + alpha. Convert to luminance
-                i.m_Type = TYPE_LUMINANCE;
-                ret = stbi__convert_format(ret, 2, 1, x, y);
-                break;
-            case 3:
-                i.m_Type = TYPE_RGB;
-                break;
-            case 4:
-                i.m_Type = TYPE_RGBA;
-                if (premult) {
-                    Premultiply(ret, x, y);
-                }
-                break;
-            default:
-                dmLogError("Unexpected number of components in image (%d)", comp);
+            if (ToType(comp, false, &i.m_Type) != RESULT_OK) {
                 free(ret);
                 return RESULT_IMAGE_ERROR;
             }
+            if (comp == 2) {
+                ret = stbi__convert_format(ret, 2, 1, x, y);
+            } else if (comp == 4 && premult) {
+                Premultiply(ret, x, y);
+            }
             i.m_Buffer = (void*) ret;
             *image = i;
             return RESULT_OK;
@@ -91,6 +212,71 @@ namespace dmImage
         }
     }
 
+    Result GetInfo(const void* buffer, uint32_t buffer_size, const LoadParams& params, Image* image)
+    {
+        int x, y, comp;
+        if (!stbi_info_from_memory((const stbi_uc*) buffer, (int) buffer_size, &x, &y, &comp)) {
+            dmLogError("Failed to read image info: '%s'", stbi_failure_reason());
+            return RESULT_IMAGE_ERROR;
+        }
+        Image i;
+        i.m_Width = (uint32_t) x;
+        i.m_Height = (uint32_t) y;
+        if (ToType(comp, params.m_ExpandRGB, &i.m_Type) != RESULT_OK) {
+            return RESULT_IMAGE_ERROR;
+        }
+        *image = i;
+        return RESULT_OK;
+    }
+
+    Result LoadInto(const void* buffer, uint32_t buffer_size, const LoadParams& params, void* out_buffer, uint32_t out_buffer_size, Image* image)
+    {
+        int x, y, comp;
+        unsigned char* ret = stbi_load_from_memory((const stbi_uc*) buffer, (int) buffer_size, &x, &y, &comp, 0);
+        if (!ret) {
+            dmLogError("Failed to load image: '%s'", stbi_failure_reason());
+            return RESULT_IMAGE_ERROR;
+        }
+
+        Image i;
+        i.m_Width = (uint32_t) x;
+        i.m_Height = (uint32_t) y;
+        if (ToType(comp, params.m_ExpandRGB, &i.m_Type) != RESULT_OK) {
+            free(ret);
+            return RESULT_IMAGE_ERROR;
+        }
+
+        uint32_t src_stride = i.m_Width * (uint32_t) comp;
+        uint32_t dst_stride = i.m_Width * BytesPerPixel(i.m_Type);
+        if (dst_stride * i.m_Height > out_buffer_size) {
+            dmLogError("Image buffer too small (%u bytes, %u needed)", out_buffer_size, dst_stride * i.m_Height);
+            free(ret);
+            return RESULT_BUFFER_TOO_SMALL;
+        }
+
+        // Flip, premultiply and convert in the same pass as the copy to the output buffer
+        for (uint32_t row = 0; row < i.m_Height; ++row)
+        {
+            const uint8_t* src = ret + row * src_stride;
+            uint8_t* dst = (uint8_t*) out_buffer + (params.m_FlipVertically ? i.m_Height - 1 - row : row) * dst_stride;
+            if (comp == 2) {
+                for (uint32_t p = 0; p < i.m_Width; ++p)
+                    dst[p] = src[p * 2];
+            } else if (comp == 3 && params.m_ExpandRGB) {
+                ConvertRGBToRGBA(src, dst, i.m_Width);
+            } else if (comp == 4 && params.m_Premultiply) {
+                PremultiplyPixels(src, dst, i.m_Width);
+            } else {
+                memcpy(dst, src, dst_stride);
+            }
+        }
+        free(ret);
+
+        i.m_Buffer = out_buffer;
+        *image = i;
+        return RESULT_OK;
+    }
+
     void Free(Image* image)
     {
         free(image->m_Buffer);
@@ -22,6 +22,7 @@ namespace dmImage
         RESULT_OK                   = 0,
         RESULT_UNSUPPORTED_FORMAT   = -1,
         RESULT_IMAGE_ERROR          = -2,
+        RESULT_BUFFER_TOO_SMALL     = -3,
     };
 
     enum Type
@@ -58,6 +59,70 @@ namespace dmImage
      */
     Result Load(const void* buffer, uint32_t buffer_size, bool premult, Image* image);
 
+    /**
+     * Parameters for #LoadInto and #GetInfo
+     */
+    struct LoadParams
+    {
+        LoadParams() : m_Premultiply(false), m_FlipVertically(false), m_ExpandRGB(false) {}
+        /// Premultiply alpha
+        bool m_Premultiply;
+        /// Store the rows in reverse order, ie the first row last
+        bool m_FlipVertically;
+        /// Convert RGB images to RGBA, with alpha 255
+        bool m_ExpandRGB;
+    };
+
+    /**
+     * Get the size and type an image will be loaded as, without decoding it.
+     * Use to allocate the buffer for #LoadInto.
+     * @param buffer image buffer
+     * @param buffer_size image buffer size
+     * @param params load parameters
+     * @param image output. The buffer is not set.
+     * @return RESULT_OK on success
+     */
+    Result GetInfo(const void* buffer, uint32_t buffer_size, const LoadParams& params, Image* image);
+
+    /**
+     * Load image from buffer into a caller provided buffer, eg a texture upload staging area.
+     * Flipping, premultiplication and RGB expansion are done while copying the
+     * decoded rows, so no extra pass over the image is needed. See #Load for supported formats.
+     * @param buffer image buffer
+     * @param buffer_size image buffer size
+     * @param params load parameters
+     * @param out_buffer output pixel buffer, owned by the caller. Don't call #Free on the image.
+     * @param out_buffer_size output pixel buffer size
+     * @param image output
+     * @return RESULT_OK on success, RESULT_BUFFER_TOO_SMALL if the output buffer doesn't fit the image
+     */
+    Result LoadInto(const void* buffer, uint32_t buffer_size, const LoadParams& params, void* out_buffer, uint32_t out_buffer_size, Image* image);
+
+    /**
+     * Premultiply RGBA pixels with alpha, in place
+     * @param buffer RGBA pixels
+     * @param width width
+     * @param height height
+     */
+    void Premultiply(uint8_t* buffer, int width, int height);
+
+    /**
+     * Convert RGB pixels to RGBA, with alpha 255
+     * @param rgb source pixels
+     * @param rgba destination pixels, must not overlap the source
+     * @param pixel_count number of pixels
+     */
+    void ConvertRGBToRGBA(const uint8_t* rgb, uint8_t* rgba, uint32_t pixel_count);
+
+    /**
+     * Flip image vertically, in place
+     * @param buffer pixels
+     * @param width width
+     * @param height height
+     * @param type image type
+     */
+    void FlipVertical(uint8_t* buffer, uint32_t width, uint32_t height, Type type);
+
     /**
      * Free loaded image
      * @param image image to free
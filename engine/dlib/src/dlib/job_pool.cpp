@@ -0,0 +1,155 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <string.h>
+#include "job_pool.h"
+#include "condition_variable.h"
+#include "mutex.h"
+#include "thread.h"
+
+namespace dmJobPool
+{
+    struct JobPool
+    {
+        dmThread::Thread                        m_Threads[MAX_THREADS];
+        dmMutex::HMutex                         m_Mutex;
+        // Held while a job runs, jobs run concurrently by other threads run on their own thread instead of waiting
+        dmMutex::HMutex                         m_JobMutex;
+        dmConditionVariable::HConditionVariable m_WorkCond;
+        dmConditionVariable::HConditionVariable m_DoneCond;
+        JobFunction                             m_Function;
+        void*                                   m_Context;
+        uint32_t                                m_Generation;
+        uint32_t                                m_Active;
+        uint32_t                                m_RefCount;
+        bool                                    m_Quit;
+    };
+
+    static JobPool* g_JobPool = 0;
+
+#if !(defined(__EMSCRIPTEN__))
+    static void JobThread(void* arg)
+    {
+        JobPool* pool = (JobPool*) arg;
+        uint32_t generation = 0;
+
+        dmMutex::Lock(pool->m_Mutex);
+        while (true)
+        {
+            while (!pool->m_Quit && pool->m_Generation == generation)
+            {
+                dmConditionVariable::Wait(pool->m_WorkCond, pool->m_Mutex);
+            }
+            if (pool->m_Quit)
+                break;
+
+            generation = pool->m_Generation;
+            JobFunction function = pool->m_Function;
+            void* context = pool->m_Context;
+            if (!function)
+                continue; // The job finished before this thread woke up
+
+            pool->m_Active++;
+            dmMutex::Unlock(pool->m_Mutex);
+
+            function(context);
+
+            dmMutex::Lock(pool->m_Mutex);
+            if (--pool->m_Active == 0)
+            {
+                dmConditionVariable::Signal(pool->m_DoneCond);
+            }
+        }
+        dmMutex::Unlock(pool->m_Mutex);
+    }
+#endif
+
+    void Acquire()
+    {
+#if !(defined(__EMSCRIPTEN__))
+        if (g_JobPool)
+        {
+            g_JobPool->m_RefCount++;
+            return;
+        }
+
+        JobPool* pool = new JobPool;
+        memset(pool, 0, sizeof(*pool));
+        pool->m_Mutex = dmMutex::New();
+        pool->m_JobMutex = dmMutex::New();
+        pool->m_WorkCond = dmConditionVariable::New();
+        pool->m_DoneCond = dmConditionVariable::New();
+        pool->m_RefCount = 1;
+        for (uint32_t i = 0; i < MAX_THREADS; ++i)
+        {
+            pool->m_Threads[i] = dmThread::New(JobThread, 0x10000, pool, "jobpool");
+        }
+        g_JobPool = pool;
+#endif
+    }
+
+    void Release()
+    {
+        JobPool* pool = g_JobPool;
+        if (!pool || --pool->m_RefCount > 0)
+            return;
+
+        g_JobPool = 0;
+
+        dmMutex::Lock(pool->m_Mutex);
+        pool->m_Quit = true;
+        dmConditionVariable::Broadcast(pool->m_WorkCond);
+        dmMutex::Unlock(pool->m_Mutex);
+
+        for (uint32_t i = 0; i < MAX_THREADS; ++i)
+        {
+            dmThread::Join(pool->m_Threads[i]);
+        }
+
+        dmConditionVariable::Delete(pool->m_DoneCond);
+        dmConditionVariable::Delete(pool->m_WorkCond);
+        dmMutex::Delete(pool->m_JobMutex);
+        dmMutex::Delete(pool->m_Mutex);
+        delete pool;
+    }
+
+    void Run(JobFunction function, void* context)
+    {
+        JobPool* pool = g_JobPool;
+        if (!pool || !dmMutex::TryLock(pool->m_JobMutex))
+        {
+            function(context);
+            return;
+        }
+
+        dmMutex::Lock(pool->m_Mutex);
+        pool->m_Function = function;
+        pool->m_Context = context;
+        pool->m_Generation++;
+        dmConditionVariable::Broadcast(pool->m_WorkCond);
+        dmMutex::Unlock(pool->m_Mutex);
+
+        function(context);
+
+        // All work is claimed, wait for the threads still running the job
+        dmMutex::Lock(pool->m_Mutex);
+        pool->m_Function = 0;
+        pool->m_Context = 0;
+        while (pool->m_Active > 0)
+        {
+            dmConditionVariable::Wait(pool->m_DoneCond, pool->m_Mutex);
+        }
+        dmMutex::Unlock(pool->m_Mutex);
+
+        dmMutex::Unlock(pool->m_JobMutex);
+    }
+}
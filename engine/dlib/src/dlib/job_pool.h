@@ -0,0 +1,55 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_JOB_POOL_H
+#define DM_JOB_POOL_H
+
+#include <stdint.h>
+
+/**
+ * Shared worker threads that help the calling thread finish a job. A job is a function that
+ * repeatedly claims a part of the work, e.g. with an atomic counter, until all parts are claimed.
+ * It's called on the calling thread and on each worker thread at once.
+ */
+namespace dmJobPool
+{
+    /// Number of worker threads, the calling thread runs the job as well
+    const uint32_t MAX_THREADS = 3;
+
+    /**
+     * Called on each thread running the job
+     * @param context the context passed to Run()
+     */
+    typedef void (*JobFunction)(void* context);
+
+    /**
+     * Starts the worker threads on the first call. Each call must be matched by a call to Release().
+     * Not thread safe, acquire and release from the same thread. No threads are started on platforms without them.
+     */
+    void Acquire();
+
+    /**
+     * Stops the worker threads when the last reference is released
+     */
+    void Release();
+
+    /**
+     * Runs the job on the calling thread and the worker threads, and returns when all of them are done.
+     * The job runs on the calling thread only if the pool isn't acquired or is running a job for another
+     * thread, rather than waiting for it.
+     * @param function the job
+     * @param context passed to the function
+     */
+    void Run(JobFunction function, void* context);
+}
+
+#endif // DM_JOB_POOL_H
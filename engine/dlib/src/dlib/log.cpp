@@ -11,6 +11,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
 #include <assert.h>
@@ -18,6 +19,9 @@
 #include "array.h"
 #include "dstrings.h"
 #include "log.h"
+#include "atomic.h"
+#include "hash.h"
+#include "spinlock.h"
 #include "socket.h"
 #include "message.h"
 #include "thread.h"
@@ -72,6 +76,58 @@ static FILE* g_LogFile = 0;
 static dmCustomLogCallback g_CustomLogCallback = 0;
 static void* g_CustomLogCallbackUserData = 0;
 
+// Asynchronous mode. Each logging thread formats into its own single producer/single consumer
+// ring buffer, which is drained by the log thread. The buffers are kept for the life-time of the
+// process, since there is no way to clear the thread local pointers of other threads. When a thread
+// exits, the TLS destructor marks its buffer as exited and the next new thread reuses it, after any
+// messages still in it.
+static const uint32_t DM_LOG_THREAD_BUFFER_SIZE = 64 * 1024; // Must be power of two
+static const uint32_t DM_LOG_MAX_THREAD_BUFFERS = 32;
+
+struct dmLogThreadBuffer
+{
+    char           m_Data[DM_LOG_THREAD_BUFFER_SIZE];
+    int32_atomic_t m_Write;
+    int32_atomic_t m_Read;
+    // Set when the owning thread has exited, protected by g_LogLock
+    uint32_t       m_Exited;
+};
+
+// Header of each message in the ring buffer, followed by the message bytes
+struct dmLogRecord
+{
+    uint16_t m_Length;
+    uint8_t  m_Severity;
+    uint8_t  m_Pad;
+};
+
+// Repeat limiting is done per thread, so that logging doesn't need a lock. The state is freed,
+// and a pending summary written, when the thread exits
+struct dmLogRepeatState
+{
+    uint32_t      m_Hash;
+    uint32_t      m_Count;
+    dmLogSeverity m_Severity;
+    char          m_Domain[32];
+};
+
+static volatile bool g_LogAsync = false;
+static dmLogBufferFullPolicy g_LogBufferFullPolicy = DM_LOG_BUFFER_FULL_DROP;
+static dmLogThreadBuffer* g_LogThreadBuffers[DM_LOG_MAX_THREAD_BUFFERS];
+static int32_atomic_t g_LogThreadBufferCount = 0;
+static int32_atomic_t g_LogDroppedCount = 0;
+static void dmLogReleaseThreadBuffer(void* value);
+static dmThread::TlsKey g_LogTlsKey = dmThread::AllocTls(dmLogReleaseThreadBuffer);
+// Set as thread local value for threads that must log synchronously, e.g. the log thread itself
+static dmLogThreadBuffer* const DM_LOG_NO_THREAD_BUFFER = (dmLogThreadBuffer*)(uintptr_t)1;
+
+static uint32_t g_LogMaxRepeatedMessages = 0;
+static void dmLogDeleteRepeatState(void* value);
+static void dmLogFlushRepeated();
+static dmThread::TlsKey g_LogRepeatTlsKey = dmThread::AllocTls(dmLogDeleteRepeatState);
+static dmSpinlock::lock_t g_LogLock; // Thread buffer registration
+static bool g_LogLockInitialized = false;
+
 // create and bind the server socket, will reuse old port if supplied handle valid
 static void dmLogInitSocket( dmSocket::Socket& server_socket )
 {
@@ -221,19 +277,10 @@ static void dmLogUpdateNetwork()
     }
 }
 
-static void dmLogDispatch(dmMessage::Message *message, void* user_ptr)
+static void dmLogSendToConnections(const char* message, int msg_len)
 {
     dmLogServer* self = g_dmLogServer;
 
-    bool* run = (bool*) user_ptr;
-    dmLogMessage* log_message = (dmLogMessage*) &message->m_Data[0];
-    if (log_message->m_Type == dmLogMessage::SHUTDOWN)
-    {
-        *run = false;
-        return;
-    }
-    int msg_len = (int) strlen(log_message->m_Message);
-
     // NOTE: Keep i as signed! See --i below after EraseSwap
     int n = (int) self->m_Connections.Size();
     for (int i = 0; i < n; ++i)
@@ -244,7 +291,7 @@ static void dmLogDispatch(dmMessage::Message *message, void* user_ptr)
         int total_sent = 0;
         do
         {
-            r = dmSocket::Send(c->m_Socket, log_message->m_Message + total_sent, msg_len - total_sent, &sent_bytes);
+            r = dmSocket::Send(c->m_Socket, message + total_sent, msg_len - total_sent, &sent_bytes);
             if (r == dmSocket::RESULT_OK)
             {
                 total_sent += sent_bytes;
@@ -267,26 +314,112 @@ static void dmLogDispatch(dmMessage::Message *message, void* user_ptr)
     }
 }
 
+static void dmLogDispatch(dmMessage::Message *message, void* user_ptr)
+{
+    bool* run = (bool*) user_ptr;
+    dmLogMessage* log_message = (dmLogMessage*) &message->m_Data[0];
+    if (log_message->m_Type == dmLogMessage::SHUTDOWN)
+    {
+        *run = false;
+        return;
+    }
+    dmLogSendToConnections(log_message->m_Message, (int) strlen(log_message->m_Message));
+}
+
+// Forward declared as the log thread writes drained messages itself
+static void dmLogWriteOutput(dmLogSeverity severity, dmLogMessage* msg, int n, bool on_log_thread);
+
+// Returns true if any messages were written
+static bool dmLogDrainThreadBuffers()
+{
+    char tmp_buf[sizeof(dmLogMessage) + DM_LOG_MAX_STRING_SIZE];
+    dmLogMessage* msg = (dmLogMessage*) &tmp_buf[0];
+    char* str_buf = &tmp_buf[sizeof(dmLogMessage)];
+    const uint32_t mask = DM_LOG_THREAD_BUFFER_SIZE - 1;
+    bool written = false;
+
+    uint32_t buffer_count = (uint32_t) dmAtomicAdd32(&g_LogThreadBufferCount, 0);
+    for (uint32_t i = 0; i < buffer_count; ++i)
+    {
+        dmLogThreadBuffer* buffer = g_LogThreadBuffers[i];
+        uint32_t read = (uint32_t) buffer->m_Read;
+        uint32_t write = (uint32_t) dmAtomicAdd32(&buffer->m_Write, 0);
+        while (read != write)
+        {
+            dmLogRecord record;
+            for (uint32_t j = 0; j < sizeof(record); ++j)
+                ((char*) &record)[j] = buffer->m_Data[(read + j) & mask];
+            read += sizeof(record);
+
+            uint32_t offset = read & mask;
+            uint32_t first = dmMath::Min((uint32_t) record.m_Length, DM_LOG_THREAD_BUFFER_SIZE - offset);
+            memcpy(str_buf, &buffer->m_Data[offset], first);
+            memcpy(str_buf + first, &buffer->m_Data[0], record.m_Length - first);
+            str_buf[record.m_Length] = '\0';
+            read += record.m_Length;
+
+            // Release the space before writing, so a blocked thread can continue
+            dmAtomicStore32(&buffer->m_Read, (int32_t) read);
+            dmLogWriteOutput((dmLogSeverity) record.m_Severity, msg, record.m_Length, true);
+            written = true;
+        }
+    }
+
+    static uint32_t reported_dropped = 0;
+    uint32_t dropped = (uint32_t) dmAtomicAdd32(&g_LogDroppedCount, 0);
+    if (dropped != reported_dropped)
+    {
+        int n = dmSnPrintf(str_buf, DM_LOG_MAX_STRING_SIZE, "WARNING:DLIB: %u log messages dropped\n", dropped - reported_dropped);
+        reported_dropped = dropped;
+        dmLogWriteOutput(DM_LOG_SEVERITY_WARNING, msg, n, true);
+        written = true;
+    }
+
+    if (written && g_LogFile)
+        fflush(g_LogFile);
+    return written;
+}
+
 static void dmLogThread(void* args)
 {
     dmLogServer* self = g_dmLogServer;
 
+    // Messages logged from the log thread itself can't wait for it to drain them
+    dmThread::SetTlsValue(g_LogTlsKey, DM_LOG_NO_THREAD_BUFFER);
+
     volatile bool run = true;
+    bool busy = false;
     while (run)
     {
         // NOTE: We have support for blocking dispatch in dmMessage
         // but we have to wait for both new messages and on sockets.
         // Currently no support for that and hence the sleep here
-        dmTime::Sleep(1000 * 30);
+        // In asynchronous mode we poll more often as the thread buffers are bounded,
+        // and not at all while there is a backlog
+        if (!busy)
+            dmTime::Sleep(g_LogAsync ? 1000 * 4 : 1000 * 30);
         dmLogUpdateNetwork();
+        busy = dmLogDrainThreadBuffers();
         dmMessage::Dispatch(self->m_MessgeSocket, dmLogDispatch, (void*) &run);
     }
+
+    // Messages logged before asynchronous mode was turned off
+    dmLogDrainThreadBuffers();
 }
 
 void dmLogInitialize(const dmLogParams* params)
 {
     g_TotalBytesLogged = 0;
 
+    if (!g_LogLockInitialized)
+    {
+        dmSpinlock::Init(&g_LogLock);
+        g_LogLockInitialized = true;
+    }
+    dmLogFlushRepeated();
+    g_LogMaxRepeatedMessages = params->m_MaxRepeatedMessages;
+    g_LogBufferFullPolicy = params->m_BufferFullPolicy;
+
     if (!dLib::IsDebugMode() || !dLib::FeaturesSupported(DM_FEATURE_BIT_SOCKET_SERVER_TCP))
         return;
 
@@ -323,6 +456,7 @@ void dmLogInitialize(const dmLogParams* params)
     g_dmLogServer = new dmLogServer(server_socket, port, message_socket);
     thread = dmThread::New(dmLogThread, 0x80000, 0, "log");
     g_dmLogServer->m_Thread = thread;
+    g_LogAsync = params->m_Async;
 
     /*
      * This message is parsed by editor 2 - don't remove or change without
@@ -339,8 +473,20 @@ static void CloseLogFile()
     }
 }
 
+void dmLogSetParams(const dmLogParams* params)
+{
+    dmLogFlushRepeated();
+    g_LogMaxRepeatedMessages = params->m_MaxRepeatedMessages;
+    g_LogBufferFullPolicy = params->m_BufferFullPolicy;
+    // Without the log thread, there is no one to drain the buffers
+    g_LogAsync = params->m_Async && g_dmLogServer != 0;
+}
+
 void dmLogFinalize()
 {
+    // Write the summary of a pending run while the log thread is still around
+    dmLogFlushRepeated();
+    g_LogMaxRepeatedMessages = 0;
     if (!g_dmLogServer)
     {
         CloseLogFile();
@@ -348,6 +494,10 @@ void dmLogFinalize()
     }
     dmLogServer* self = g_dmLogServer;
 
+    // Any thread blocked on a full buffer falls back to writing synchronously
+    // and the log thread drains the buffers before exiting
+    g_LogAsync = false;
+
     dmLogMessage msg;
     msg.m_Type = dmLogMessage::SHUTDOWN;
     dmMessage::URL receiver;
@@ -382,6 +532,16 @@ void dmLogFinalize()
     CloseLogFile();
 }
 
+uint32_t dmLogGetDroppedCount()
+{
+    return (uint32_t) dmAtomicAdd32(&g_LogDroppedCount, 0);
+}
+
+uint32_t dmLogGetThreadBufferCount()
+{
+    return (uint32_t) dmAtomicAdd32(&g_LogThreadBufferCount, 0);
+}
+
 uint16_t dmLogGetPort()
 {
     if (!g_dmLogServer)
@@ -424,76 +584,31 @@ static android_LogPriority ToAndroidPriority(dmLogSeverity severity)
 }
 #endif
 
-void dmLogInternal(dmLogSeverity severity, const char* domain, const char* format, ...)
+static const char* dmLogSeverityString(dmLogSeverity severity)
 {
-    if (!dLib::IsDebugMode())
-        return;
-
-    if (severity < g_LogLevel)
-        return;
-
-    va_list lst;
-    va_start(lst, format);
-
-    const char* severity_str = 0;
     switch (severity)
     {
         case DM_LOG_SEVERITY_DEBUG:
-            severity_str = "DEBUG";
-            break;
+            return "DEBUG";
         case DM_LOG_SEVERITY_USER_DEBUG:
-            severity_str = "DEBUG";
-            break;
+            return "DEBUG";
         case DM_LOG_SEVERITY_INFO:
-            severity_str = "INFO";
-            break;
+            return "INFO";
         case DM_LOG_SEVERITY_WARNING:
-            severity_str = "WARNING";
-            break;
+            return "WARNING";
         case DM_LOG_SEVERITY_ERROR:
-            severity_str = "ERROR";
-            break;
+            return "ERROR";
         case DM_LOG_SEVERITY_FATAL:
-            severity_str = "FATAL";
-            break;
+            return "FATAL";
         default:
             assert(0);
-            break;
+            return 0;
     }
+}
 
-    char tmp_buf[sizeof(dmLogMessage) + DM_LOG_MAX_STRING_SIZE];
-    dmLogMessage* msg = (dmLogMessage*) &tmp_buf[0];
-    char* str_buf = &tmp_buf[sizeof(dmLogMessage)];
-
-    int n = 0;
-    n += dmSnPrintf(str_buf + n, DM_LOG_MAX_STRING_SIZE - n, "%s:%s: ", severity_str, domain);
-    if (n < DM_LOG_MAX_STRING_SIZE)
-    {
-        n += vsnprintf(str_buf + n, DM_LOG_MAX_STRING_SIZE - n, format, lst);
-    }
-
-    if (n < DM_LOG_MAX_STRING_SIZE)
-    {
-        n += dmSnPrintf(str_buf + n, DM_LOG_MAX_STRING_SIZE - n, "\n");
-    }
-
-    if (n >= DM_LOG_MAX_STRING_SIZE)
-    {
-        strcpy(&str_buf[DM_LOG_MAX_STRING_SIZE - (strlen(LOG_OUTPUT_TRUNCATED_MESSAGE) + 1)], LOG_OUTPUT_TRUNCATED_MESSAGE);
-    }
-
-    str_buf[DM_LOG_MAX_STRING_SIZE-1] = '\0';
-    int actual_n = dmMath::Min(n, (int)(DM_LOG_MAX_STRING_SIZE-1));
-
-    g_TotalBytesLogged += actual_n;
-
-    va_end(lst);
-
-    if (g_CustomLogCallback != 0x0)
-    {
-        g_CustomLogCallback(g_CustomLogCallbackUserData, str_buf);
-        return;
-    }
+static void dmLogWriteOutput(dmLogSeverity severity, dmLogMessage* msg, int n, bool on_log_thread)
+{
+    const char* str_buf = msg->m_Message;
 
 #ifdef ANDROID
     __android_log_print(ToAndroidPriority(severity), "defold", "%s", str_buf);
@@ -506,32 +621,268 @@ void dmLogInternal(dmLogSeverity severity, const char* domain, const char* forma
 #ifdef __EMSCRIPTEN__
     //Emscripten maps stderr to console.error and stdout to console.log.
     if (severity == DM_LOG_SEVERITY_ERROR || severity == DM_LOG_SEVERITY_FATAL){
-        fwrite(str_buf, 1, actual_n, stderr);
+        fwrite(str_buf, 1, n, stderr);
     } else {
-        fwrite(str_buf, 1, actual_n, stdout);
+        fwrite(str_buf, 1, n, stdout);
     }
 #elif !defined(ANDROID)
-    fwrite(str_buf, 1, actual_n, stderr);
+    fwrite(str_buf, 1, n, stderr);
 #endif
 
     if(!dLib::FeaturesSupported(DM_FEATURE_BIT_SOCKET_SERVER_TCP))
         return;
 
     if (g_LogFile && g_TotalBytesLogged < DM_LOG_MAX_LOG_FILE_SIZE) {
-        fwrite(str_buf, 1, actual_n, g_LogFile);
-        fflush(g_LogFile);
+        fwrite(str_buf, 1, n, g_LogFile);
+        // The log thread flushes once per drained batch
+        if (!on_log_thread)
+            fflush(g_LogFile);
     }
 
     dmLogServer* self = g_dmLogServer;
     if (self)
     {
+        if (on_log_thread)
+        {
+            dmLogSendToConnections(str_buf, n);
+            return;
+        }
+
         msg->m_Type = dmLogMessage::MESSAGE;
         dmMessage::URL receiver;
         receiver.m_Socket = self->m_MessgeSocket;
         receiver.m_Path = 0;
         receiver.m_Fragment = 0;
-        dmMessage::Post(0, &receiver, 0, 0, 0, msg, dmMath::Min(sizeof(dmLogMessage) + actual_n + 1, sizeof(tmp_buf)), 0);
+        dmMessage::Post(0, &receiver, 0, 0, 0, msg, dmMath::Min(sizeof(dmLogMessage) + n + 1, sizeof(dmLogMessage) + DM_LOG_MAX_STRING_SIZE), 0);
+    }
+}
+
+// TLS destructor, called when a thread exits
+static void dmLogReleaseThreadBuffer(void* value)
+{
+    dmLogThreadBuffer* buffer = (dmLogThreadBuffer*) value;
+    if (buffer == DM_LOG_NO_THREAD_BUFFER)
+        return;
+    DM_SPINLOCK_SCOPED_LOCK(g_LogLock);
+    buffer->m_Exited = 1;
+}
+
+static dmLogThreadBuffer* dmLogGetThreadBuffer()
+{
+    dmLogThreadBuffer* buffer = (dmLogThreadBuffer*) dmThread::GetTlsValue(g_LogTlsKey);
+    if (buffer)
+        return buffer;
+
+    DM_SPINLOCK_SCOPED_LOCK(g_LogLock);
+    uint32_t count = (uint32_t) g_LogThreadBufferCount;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        // Only the owning thread writes to a buffer, so the one of an exited thread can be continued
+        if (g_LogThreadBuffers[i]->m_Exited)
+        {
+            buffer = g_LogThreadBuffers[i];
+            buffer->m_Exited = 0;
+            break;
+        }
+    }
+
+    if (buffer == 0)
+    {
+        if (count == DM_LOG_MAX_THREAD_BUFFERS)
+        {
+            // Too many threads are logging, let the rest log synchronously
+            buffer = DM_LOG_NO_THREAD_BUFFER;
+        }
+        else
+        {
+            buffer = new dmLogThreadBuffer;
+            buffer->m_Write = 0;
+            buffer->m_Read = 0;
+            buffer->m_Exited = 0;
+            g_LogThreadBuffers[count] = buffer;
+            dmAtomicStore32(&g_LogThreadBufferCount, (int32_t) count + 1);
+        }
+    }
+    dmThread::SetTlsValue(g_LogTlsKey, buffer);
+    return buffer;
+}
+
+static void dmLogRingWrite(dmLogThreadBuffer* buffer, uint32_t position, const void* data, uint32_t size)
+{
+    uint32_t offset = position & (DM_LOG_THREAD_BUFFER_SIZE - 1);
+    uint32_t first = dmMath::Min(size, DM_LOG_THREAD_BUFFER_SIZE - offset);
+    memcpy(&buffer->m_Data[offset], data, first);
+    memcpy(&buffer->m_Data[0], (const char*) data + first, size - first);
+}
+
+// Returns false if the message should be written synchronously instead
+static bool dmLogPushAsync(dmLogSeverity severity, const char* str_buf, int n)
+{
+    dmLogThreadBuffer* buffer = dmLogGetThreadBuffer();
+    if (buffer == DM_LOG_NO_THREAD_BUFFER)
+        return false;
+
+    const uint32_t size = sizeof(dmLogRecord) + n;
+    const uint32_t write = (uint32_t) buffer->m_Write;
+    while (DM_LOG_THREAD_BUFFER_SIZE - (write - (uint32_t) dmAtomicAdd32(&buffer->m_Read, 0)) < size)
+    {
+        if (!g_LogAsync)
+            return false;
+
+        if (g_LogBufferFullPolicy == DM_LOG_BUFFER_FULL_DROP)
+        {
+            dmAtomicIncrement32(&g_LogDroppedCount);
+            return true;
+        }
+        dmTime::Sleep(100);
+    }
+
+    dmLogRecord record;
+    record.m_Length = (uint16_t) n;
+    record.m_Severity = (uint8_t) severity;
+    record.m_Pad = 0;
+    dmLogRingWrite(buffer, write, &record, sizeof(record));
+    dmLogRingWrite(buffer, write + sizeof(record), str_buf, n);
+
+    // Publish the message to the log thread
+    dmAtomicStore32(&buffer->m_Write, (int32_t) (write + size));
+    return true;
+}
+
+static void dmLogEmit(dmLogSeverity severity, dmLogMessage* msg, int n)
+{
+    if (g_CustomLogCallback != 0x0)
+    {
+        g_CustomLogCallback(g_CustomLogCallbackUserData, msg->m_Message);
+        return;
+    }
+
+    // Fatal messages are written immediately, as the process might not be around for long
+    if (g_LogAsync && severity != DM_LOG_SEVERITY_FATAL && dmLogPushAsync(severity, msg->m_Message, n))
+        return;
+
+    dmLogWriteOutput(severity, msg, n, false);
+}
+
+// Writes the summary of a run of suppressed messages to summary_msg, returns the length or 0 if there is none
+static int dmLogGetRepeatSummary(dmLogRepeatState* state, dmLogMessage* summary_msg)
+{
+    uint32_t max_repeated = g_LogMaxRepeatedMessages;
+    if (max_repeated == 0 || state->m_Count <= max_repeated)
+        return 0;
+    return dmSnPrintf(summary_msg->m_Message, DM_LOG_MAX_STRING_SIZE, "%s:%s: Previous message repeated %u more times\n",
+                      dmLogSeverityString(state->m_Severity), state->m_Domain, state->m_Count - max_repeated);
+}
+
+static void dmLogDeleteRepeatState(void* value)
+{
+    dmLogRepeatState* state = (dmLogRepeatState*) value;
+    char summary_buf[sizeof(dmLogMessage) + DM_LOG_MAX_STRING_SIZE];
+    dmLogMessage* summary_msg = (dmLogMessage*) &summary_buf[0];
+    int summary_n = dmLogGetRepeatSummary(state, summary_msg);
+    if (summary_n > 0)
+        dmLogEmit(state->m_Severity, summary_msg, summary_n);
+    free(state);
+}
+
+static void dmLogFlushRepeated()
+{
+    dmLogRepeatState* state = (dmLogRepeatState*) dmThread::GetTlsValue(g_LogRepeatTlsKey);
+    if (state == 0)
+        return;
+    char summary_buf[sizeof(dmLogMessage) + DM_LOG_MAX_STRING_SIZE];
+    dmLogMessage* summary_msg = (dmLogMessage*) &summary_buf[0];
+    int summary_n = dmLogGetRepeatSummary(state, summary_msg);
+    if (summary_n > 0)
+        dmLogEmit(state->m_Severity, summary_msg, summary_n);
+    state->m_Count = 0;
+}
+
+// Returns false if the message is a repetition over the limit. If it ends a run of suppressed
+// messages, a summary of the run is written to summary_msg
+static bool dmLogFilterRepeated(dmLogSeverity severity, const char* domain, const char* str_buf, int n,
+                                dmLogMessage* summary_msg, int* summary_n, dmLogSeverity* summary_severity)
+{
+    uint32_t hash = dmHashBuffer32(str_buf, n);
+
+    dmLogRepeatState* state = (dmLogRepeatState*) dmThread::GetTlsValue(g_LogRepeatTlsKey);
+    if (state == 0)
+    {
+        state = (dmLogRepeatState*) malloc(sizeof(dmLogRepeatState));
+        memset(state, 0, sizeof(*state));
+        dmThread::SetTlsValue(g_LogRepeatTlsKey, state);
     }
+
+    if (state->m_Count > 0 && state->m_Hash == hash)
+    {
+        state->m_Count++;
+        return state->m_Count <= g_LogMaxRepeatedMessages;
+    }
+
+    *summary_n = dmLogGetRepeatSummary(state, summary_msg);
+    *summary_severity = state->m_Severity;
+
+    state->m_Hash = hash;
+    state->m_Count = 1;
+    state->m_Severity = severity;
+    dmStrlCpy(state->m_Domain, domain, sizeof(state->m_Domain));
+    return true;
+}
+
+void dmLogInternal(dmLogSeverity severity, const char* domain, const char* format, ...)
+{
+    if (!dLib::IsDebugMode())
+        return;
+
+    if (severity < g_LogLevel)
+        return;
+
+    va_list lst;
+    va_start(lst, format);
+
+    const char* severity_str = dmLogSeverityString(severity);
+
+    char tmp_buf[sizeof(dmLogMessage) + DM_LOG_MAX_STRING_SIZE];
+    dmLogMessage* msg = (dmLogMessage*) &tmp_buf[0];
+    char* str_buf = &tmp_buf[sizeof(dmLogMessage)];
+
+    int n = 0;
+    n += dmSnPrintf(str_buf + n, DM_LOG_MAX_STRING_SIZE - n, "%s:%s: ", severity_str, domain);
+    if (n < DM_LOG_MAX_STRING_SIZE)
+    {
+        n += vsnprintf(str_buf + n, DM_LOG_MAX_STRING_SIZE - n, format, lst);
+    }
+
+    if (n < DM_LOG_MAX_STRING_SIZE)
+    {
+        n += dmSnPrintf(str_buf + n, DM_LOG_MAX_STRING_SIZE - n, "\n");
+    }
+
+    if (n >= DM_LOG_MAX_STRING_SIZE)
+    {
+        strcpy(&str_buf[DM_LOG_MAX_STRING_SIZE - (strlen(LOG_OUTPUT_TRUNCATED_MESSAGE) + 1)], LOG_OUTPUT_TRUNCATED_MESSAGE);
+    }
+
+    str_buf[DM_LOG_MAX_STRING_SIZE-1] = '\0';
+    int actual_n = dmMath::Min(n, (int)(DM_LOG_MAX_STRING_SIZE-1));
+
+    g_TotalBytesLogged += actual_n;
+
+    va_end(lst);
+
+    if (g_LogMaxRepeatedMessages > 0)
+    {
+        char summary_buf[sizeof(dmLogMessage) + DM_LOG_MAX_STRING_SIZE];
+        dmLogMessage* summary_msg = (dmLogMessage*) &summary_buf[0];
+        int summary_n = 0;
+        dmLogSeverity summary_severity = severity;
+        if (!dmLogFilterRepeated(severity, domain, str_buf, actual_n, summary_msg, &summary_n, &summary_severity))
+            return;
+        if (summary_n > 0)
+            dmLogEmit(summary_severity, summary_msg, summary_n);
+    }
+
+    dmLogEmit(severity, msg, actual_n);
 }
 
 void dmSetLogFile(const char* path)
@@ -45,11 +45,36 @@ struct dmLogMessage
 };
 
 const uint32_t DM_LOG_MAX_STRING_SIZE = dmMessage::DM_MESSAGE_MAX_DATA_SIZE - sizeof(dmLogMessage);
+
+/**
+ * What to do when a thread's log buffer is full in asynchronous mode
+ */
+enum dmLogBufferFullPolicy
+{
+    /// Drop the message and count it, see dmLogGetDroppedCount()
+    DM_LOG_BUFFER_FULL_DROP = 0,
+    /// Wait for the log thread to make room
+    DM_LOG_BUFFER_FULL_BLOCK = 1,
+};
+
 struct dmLogParams
 {
     dmLogParams()
+    : m_Async(false)
+    , m_BufferFullPolicy(DM_LOG_BUFFER_FULL_DROP)
+    , m_MaxRepeatedMessages(0)
     {
     }
+
+    /// Only format the message on the calling thread. The output to console, log file and
+    /// log server is done on the log thread. Requires the log server to be running.
+    /// Fatal messages are always written synchronously.
+    bool                  m_Async;
+    /// Policy when a thread's log buffer is full in asynchronous mode
+    dmLogBufferFullPolicy m_BufferFullPolicy;
+    /// Max number of identical consecutive messages from a thread to output. Subsequent copies are
+    /// summarized once the thread logs a different message, exits, or the log is finalized. 0 for no limit
+    uint32_t              m_MaxRepeatedMessages;
 };
 
 /**
@@ -60,11 +85,30 @@ struct dmLogParams
 void dmLogInitialize(const dmLogParams* params);
 
 
+/**
+ * Change the log parameters after initialization, e.g. when the project settings are loaded.
+ * Asynchronous mode is only enabled if the log server is running.
+ * @param params log parameters
+ */
+void dmLogSetParams(const dmLogParams* params);
+
 /**
  * Finalize logging system
  */
 void dmLogFinalize();
 
+/**
+ * Get the number of messages dropped due to full log buffers in asynchronous mode
+ * @return number of dropped messages since startup
+ */
+uint32_t dmLogGetDroppedCount();
+
+/**
+ * Get the number of thread buffers used for asynchronous logging. Buffers of exited threads are reused
+ * @return number of thread buffers allocated since startup
+ */
+uint32_t dmLogGetThreadBufferCount();
+
 /**
  * Get log server port
  * @return server port. 0 if the server isn't started.
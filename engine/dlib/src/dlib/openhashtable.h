@@ -0,0 +1,485 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_OPENHASHTABLE_H
+#define DM_OPENHASHTABLE_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DM_OPENHASHTABLE_SSE2
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+/**
+ * Open addressing hash table with memcpy-copy semantics (POD types).
+ *
+ * Drop-in alternative to dmHashTable for hot lookups, with the same Put/Get/Erase/Iterate API.
+ * The slot count is a power of two, so no integer division is needed to find a slot.
+ * The table stores one control byte per slot (empty, deleted or 7 bits of the key hash)
+ * and probes a group of slots at a time: 16 slots using SSE2 where available, otherwise
+ * 8 slots using 64-bit word operations.
+ *
+ * @note The key type must be an integer type (it is converted to uint64_t for hashing)
+ * @note The capacity is fixed until SetCapacity() is called, just like dmHashTable
+ */
+template <typename KEY, typename T>
+class dmOpenHashTable
+{
+#if defined(DM_OPENHASHTABLE_SSE2)
+    static const uint32_t GROUP_WIDTH = 16;
+    // Match masks have one bit per slot
+    static const uint32_t MASK_SHIFT = 0;
+#else
+    static const uint32_t GROUP_WIDTH = 8;
+    // Match masks have the top bit of each byte set per slot
+    static const uint32_t MASK_SHIFT = 3;
+    static const uint64_t LSBS = 0x0101010101010101ULL;
+    static const uint64_t MSBS = 0x8080808080808080ULL;
+#endif
+    static const uint8_t  CTRL_EMPTY = 0x80;
+    static const uint8_t  CTRL_DELETED = 0xfe;
+
+public:
+    struct Entry
+    {
+        KEY      m_Key;
+        T        m_Value;
+    };
+
+    /**
+     * Constructor. Create an empty hashtable with zero capacity
+     */
+    dmOpenHashTable()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    /**
+     * Destructor.
+     */
+    ~dmOpenHashTable()
+    {
+        free(m_Ctrl);
+        free(m_Entries);
+    }
+
+    /**
+     * Removes all the entries from the table.
+     */
+    void Clear()
+    {
+        if (m_Ctrl)
+            memset(m_Ctrl, CTRL_EMPTY, m_SlotCount);
+        m_Count = 0;
+        m_Deleted = 0;
+    }
+
+    /**
+     * Number of entries stored in table.
+     * @return Number of entries.
+     */
+    uint32_t Size() const
+    {
+        return m_Count;
+    }
+
+    /**
+     * Hashtable capacity. Maximum number of entries possible to store in table
+     * @return the capacity of the table
+     */
+    uint32_t Capacity() const
+    {
+        return m_Capacity;
+    }
+
+    /**
+     * Set hashtable capacity. New capacity must be greater or equal to current capacity.
+     * The number of slots is derived from the capacity, rounded up to a power of two.
+     * @param capacity Capacity. capacity < 0x7fffffff
+     */
+    void SetCapacity(uint32_t capacity)
+    {
+        assert(capacity < 0x7fffffff);
+        assert(capacity >= m_Capacity);
+
+        // Keep the load factor at or below 7/8
+        uint32_t slot_count = GROUP_WIDTH;
+        while (slot_count - slot_count / 8 < capacity)
+            slot_count *= 2;
+
+        m_Capacity = capacity;
+        if (slot_count != m_SlotCount)
+            Rehash(slot_count);
+    }
+
+    /**
+     * Set hashtable capacity. Same signature as dmHashTable::SetCapacity for easy migration.
+     * @param table_size Ignored, the table size is derived from the capacity
+     * @param capacity Capacity. capacity < 0x7fffffff
+     */
+    void SetCapacity(uint32_t table_size, uint32_t capacity)
+    {
+        (void)table_size;
+        SetCapacity(capacity);
+    }
+
+    /**
+     * Swaps the contents of two hash tables
+     * @param other the other table
+     */
+    void Swap(dmOpenHashTable<KEY, T>& other)
+    {
+        char buf[sizeof(*this)];
+        memcpy(buf, &other, sizeof(buf));
+        memcpy(&other, this, sizeof(buf));
+        memcpy(this, buf, sizeof(buf));
+    }
+
+    /**
+     * Check if the table is full
+     * @return true if the table is full
+     */
+    bool Full() const
+    {
+        return m_Count == m_Capacity;
+    }
+
+    /**
+     * Check if the table is empty
+     * @return true if the table is empty
+     */
+    bool Empty() const
+    {
+        return m_Count == 0;
+    }
+
+    /**
+     * Put key/value pair in hash table. NOTE: The method will "assert" if the hashtable is full.
+     * @param key Key
+     * @param value Value
+     */
+    void Put(KEY key, const T& value)
+    {
+        uint64_t hash = Hash(key);
+        Entry* entry = FindEntry(key, hash);
+        if (entry != 0)
+        {
+            entry->m_Value = value;
+            return;
+        }
+
+        assert(!Full());
+
+        // Too many tombstones, rebuild to keep the probe sequences short and terminating
+        if (m_Count + m_Deleted >= m_SlotCount - m_SlotCount / 8)
+            Rehash(m_SlotCount);
+
+        uint32_t slot = FindInsertSlot(hash);
+        if (m_Ctrl[slot] == CTRL_DELETED)
+            --m_Deleted;
+        m_Ctrl[slot] = H2(hash);
+        m_Entries[slot].m_Key = key;
+        m_Entries[slot].m_Value = value;
+        ++m_Count;
+    }
+
+    /**
+     * Get pointer to value from key
+     * @param key Key
+     * @return Pointer to value. NULL if the key/value pair doesn't exist.
+     */
+    T* Get(KEY key)
+    {
+        Entry* entry = FindEntry(key, Hash(key));
+        return entry ? &entry->m_Value : 0;
+    }
+
+    /**
+     * Get pointer to value from key. "const" version.
+     * @param key Key
+     * @return Pointer to value. NULL if the key/value pair doesn't exist.
+     */
+    const T* Get(KEY key) const
+    {
+        Entry* entry = FindEntry(key, Hash(key));
+        return entry ? &entry->m_Value : 0;
+    }
+
+    /**
+     * Remove key/value pair.
+     * @param key Key to remove
+     * @note Only valid if key exists in table
+     */
+    void Erase(KEY key)
+    {
+        Entry* entry = FindEntry(key, Hash(key));
+        assert(entry != 0 && "Key not found (erase)");
+
+        uint32_t slot = (uint32_t)(entry - m_Entries);
+        // Probing stops at the first group containing an empty slot. If this group already
+        // has one, no probe sequence continues past it and the slot can be made empty.
+        uint32_t group = slot & ~(GROUP_WIDTH - 1);
+        if (MatchEmpty(group))
+        {
+            m_Ctrl[slot] = CTRL_EMPTY;
+        }
+        else
+        {
+            m_Ctrl[slot] = CTRL_DELETED;
+            ++m_Deleted;
+        }
+        --m_Count;
+    }
+
+    /**
+     * Iterate over all entries in table
+     * @param call_back Call-back called for every entry
+     * @param context Context
+     */
+    template <typename CONTEXT>
+    void Iterate(void (*call_back)(CONTEXT *context, const KEY* key, T* value), CONTEXT* context)
+    {
+        for (uint32_t i = 0; i < m_SlotCount; ++i)
+        {
+            if (IsFull(m_Ctrl[i]))
+            {
+                Entry* e = &m_Entries[i];
+                call_back(context, &e->m_Key, &e->m_Value);
+            }
+        }
+    }
+
+    /**
+     * Verify internal structure. "assert" if invalid. For unit testing
+     */
+    void Verify()
+    {
+        uint32_t real_count = 0;
+        uint32_t real_deleted = 0;
+        for (uint32_t i = 0; i < m_SlotCount; ++i)
+        {
+            if (IsFull(m_Ctrl[i]))
+            {
+                real_count++;
+                Entry* e = &m_Entries[i];
+                assert(m_Ctrl[i] == H2(Hash(e->m_Key)));
+                assert(FindEntry(e->m_Key, Hash(e->m_Key)) == e);
+            }
+            else if (m_Ctrl[i] == CTRL_DELETED)
+            {
+                real_deleted++;
+            }
+        }
+        assert(real_count == m_Count);
+        assert(real_deleted == m_Deleted);
+    }
+
+private:
+    // Forbid assignment operator and copy-constructor
+    dmOpenHashTable(const dmOpenHashTable<KEY, T>&);
+    const dmOpenHashTable<KEY, T>& operator=(const dmOpenHashTable<KEY, T>&);
+
+    static uint64_t Hash(KEY key)
+    {
+        // Keys are often sequential indices or already hashed, mix them so both the
+        // slot (high bits) and the control byte (low bits) are well distributed
+        uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+        return h ^ (h >> 32);
+    }
+
+    static uint8_t H2(uint64_t hash)
+    {
+        return (uint8_t)(hash & 0x7f);
+    }
+
+    static bool IsFull(uint8_t ctrl)
+    {
+        return (ctrl & 0x80) == 0;
+    }
+
+    uint32_t FirstGroup(uint64_t hash) const
+    {
+        return (uint32_t)(hash >> 7) & (m_SlotCount - 1) & ~(GROUP_WIDTH - 1);
+    }
+
+#if defined(DM_OPENHASHTABLE_SSE2)
+    __m128i LoadGroup(uint32_t group) const
+    {
+        return _mm_loadu_si128((const __m128i*)&m_Ctrl[group]);
+    }
+
+    // Bit i set if slot group+i has control byte 'value'
+    uint64_t Match(uint32_t group, uint8_t value) const
+    {
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(LoadGroup(group), _mm_set1_epi8((char)value)));
+    }
+
+    uint64_t MatchEmpty(uint32_t group) const
+    {
+        return Match(group, CTRL_EMPTY);
+    }
+
+    // Bit i set if slot group+i is empty or deleted
+    uint64_t MatchEmptyOrDeleted(uint32_t group) const
+    {
+        return (uint32_t)_mm_movemask_epi8(LoadGroup(group));
+    }
+#else
+    uint64_t LoadGroup(uint32_t group) const
+    {
+        uint64_t ctrl;
+        memcpy(&ctrl, &m_Ctrl[group], sizeof(ctrl));
+        return ctrl;
+    }
+
+    // May report false positives, the keys are always compared afterwards
+    uint64_t Match(uint32_t group, uint8_t value) const
+    {
+        uint64_t x = LoadGroup(group) ^ (LSBS * value);
+        return (x - LSBS) & ~x & MSBS;
+    }
+
+    uint64_t MatchEmpty(uint32_t group) const
+    {
+        // Only CTRL_EMPTY has bit 7 set and bit 1 clear
+        uint64_t ctrl = LoadGroup(group);
+        return ctrl & (~ctrl << 6) & MSBS;
+    }
+
+    uint64_t MatchEmptyOrDeleted(uint32_t group) const
+    {
+        // Both CTRL_EMPTY and CTRL_DELETED have bit 7 set and bit 0 clear
+        uint64_t ctrl = LoadGroup(group);
+        return ctrl & ~(ctrl << 7) & MSBS;
+    }
+#endif
+
+    static uint32_t LowestBit(uint64_t mask)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return (uint32_t)__builtin_ctzll(mask) >> MASK_SHIFT;
+#elif defined(_MSC_VER) && defined(_WIN64)
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return (uint32_t)index >> MASK_SHIFT;
+#else
+        uint32_t i = 0;
+        while ((mask & 1) == 0)
+        {
+            mask >>= 1;
+            ++i;
+        }
+        return i >> MASK_SHIFT;
+#endif
+    }
+
+    Entry* FindEntry(KEY key, uint64_t hash) const
+    {
+        if (m_SlotCount == 0)
+            return 0;
+
+        uint8_t h2 = H2(hash);
+        uint32_t group = FirstGroup(hash);
+        // Triangular probing over the groups visits every group once
+        for (uint32_t step = GROUP_WIDTH; step <= m_SlotCount; step += GROUP_WIDTH)
+        {
+            uint64_t mask = Match(group, h2);
+            while (mask)
+            {
+                uint32_t slot = group + LowestBit(mask);
+                if (m_Entries[slot].m_Key == key)
+                    return &m_Entries[slot];
+                mask &= mask - 1;
+            }
+            if (MatchEmpty(group))
+                return 0;
+            group = (group + step) & (m_SlotCount - 1);
+        }
+        return 0;
+    }
+
+    uint32_t FindInsertSlot(uint64_t hash) const
+    {
+        uint32_t group = FirstGroup(hash);
+        for (uint32_t step = GROUP_WIDTH; step <= m_SlotCount; step += GROUP_WIDTH)
+        {
+            uint64_t mask = MatchEmptyOrDeleted(group);
+            if (mask)
+                return group + LowestBit(mask);
+            group = (group + step) & (m_SlotCount - 1);
+        }
+        assert(false && "No free slots in hashtable");
+        return 0;
+    }
+
+    void Rehash(uint32_t slot_count)
+    {
+        uint8_t* old_ctrl = m_Ctrl;
+        Entry* old_entries = m_Entries;
+        uint32_t old_slot_count = m_SlotCount;
+
+        m_Ctrl = (uint8_t*) malloc(slot_count);
+        memset(m_Ctrl, CTRL_EMPTY, slot_count);
+        m_Entries = (Entry*) malloc(sizeof(Entry) * slot_count);
+        m_SlotCount = slot_count;
+        m_Deleted = 0;
+
+        for (uint32_t i = 0; i < old_slot_count; ++i)
+        {
+            if (IsFull(old_ctrl[i]))
+            {
+                uint64_t hash = Hash(old_entries[i].m_Key);
+                uint32_t slot = FindInsertSlot(hash);
+                m_Ctrl[slot] = H2(hash);
+                memcpy(&m_Entries[slot], &old_entries[i], sizeof(Entry));
+            }
+        }
+
+        free(old_ctrl);
+        free(old_entries);
+    }
+
+    // One control byte per slot: CTRL_EMPTY, CTRL_DELETED or the 7 low bits of the hash
+    uint8_t*  m_Ctrl;
+    Entry*    m_Entries;
+    // Number of slots, a power of two and a multiple of GROUP_WIDTH
+    uint32_t  m_SlotCount;
+    // Maximum number of key/value pairs
+    uint32_t  m_Capacity;
+    // Number of key/value pairs in table
+    uint32_t  m_Count;
+    // Number of tombstones
+    uint32_t  m_Deleted;
+};
+
+/**
+ * Specialized open addressing hash table with uint32_t as keys
+ */
+template <typename T>
+class dmOpenHashTable32 : public dmOpenHashTable<uint32_t, T> {};
+
+/**
+ * Specialized open addressing hash table with uint64_t as keys
+ */
+template <typename T>
+class dmOpenHashTable64 : public dmOpenHashTable<uint64_t, T> {};
+
+#endif // DM_OPENHASHTABLE_H
@@ -13,6 +13,7 @@
 #include "profile.h"
 
 #include <algorithm>
+#include <stdlib.h>
 #include <string.h>
 
 #if defined(_WIN32)
@@ -39,6 +40,7 @@
 namespace dmProfile
 {
     const uint32_t PROFILE_BUFFER_COUNT = 3;
+    const uint32_t MAX_THREAD_SAMPLE_CAPACITY = 65536;
 
     dmArray<Scope> g_Scopes;
 
@@ -50,6 +52,8 @@ namespace dmProfile
         dmArray<Sample>      m_Samples;
         dmArray<CounterData> m_CountersData;
         dmArray<ScopeData>   m_ScopesData;
+        // Tick the profile started recording at, sample start times are relative to this
+        uint64_t             m_BeginTicks;
         uint32_t             m_ScopeCount;
         uint32_t             m_CounterCount;
     };
@@ -77,9 +81,44 @@ namespace dmProfile
     bool g_OutOfCounters = false;
     bool g_IsInitialized = false;
     bool g_Paused = false;
+    // Protects the profiles, counters table and the list of thread buffers
     dmSpinlock::lock_t g_ProfileLock;
+    dmSpinlock::lock_t g_StringPoolLock;
+
+    /*
+     * Samples are recorded into a ring buffer per thread, registered once in the thread's TLS slot.
+     * Only the owning thread writes samples and advances m_Write, and Begin() merges the new samples
+     * into the active profile and advances m_Read. Starting and ending scopes is thereby lock free.
+     * A sample is open (SAMPLE_OPEN) until its scope ends, and open samples are kept in the buffer
+     * until a later Begin(). Samples after an open sample that are already merged are SAMPLE_MERGED.
+     * The buffers are reallocated by their owning thread when the profiler is initialized again
+     * (m_Generation). When a thread exits, the TLS destructor marks its buffer as exited. The
+     * remaining samples are merged and the buffer is reused, with its thread id, by the next new
+     * thread. Finalize() frees the buffers of exited threads.
+     */
+    struct ThreadSampleBuffer
+    {
+        Sample*             m_Samples;
+        ThreadSampleBuffer* m_Next;
+        // Power of two, or zero if samples are disabled
+        uint32_t            m_Capacity;
+        uint32_t            m_Generation;
+        int32_atomic_t      m_Write;
+        int32_atomic_t      m_Read;
+        uint16_t            m_ThreadId;
+        uint16_t            m_Exited;
+    };
+
+    static const uint32_t SAMPLE_OPEN = 0xffffffffu;
+    static const uint32_t SAMPLE_MERGED = 0xfffffffeu;
+    static const uint32_t SAMPLE_MAX_ELAPSED = 0xfffffffdu;
+
+    ThreadSampleBuffer* g_ThreadBuffers = 0;
+    uint32_t g_ThreadSampleCapacity = 0;
+    uint32_t g_Generation = 0;
 
-    dmThread::TlsKey g_TlsKey = dmThread::AllocTls();
+    static void ReleaseThreadBuffer(void* value);
+    dmThread::TlsKey g_TlsKey = dmThread::AllocTls(ReleaseThreadBuffer);
     int32_atomic_t g_ThreadCount = 0;
 
     // Used when out of scopes in order to remove conditional branches
@@ -91,6 +130,7 @@ namespace dmProfile
         InitSpinLocks()
         {
             dmSpinlock::Init(&g_ProfileLock);
+            dmSpinlock::Init(&g_StringPoolLock);
         }
     };
 
@@ -109,7 +149,23 @@ namespace dmProfile
         }
 
         g_StringTable.SetCapacity(1024, 1536); // Rather arbitrary...
-        g_StringPool = dmStringPool::New();
+        {
+            DM_SPINLOCK_SCOPED_LOCK(g_StringPoolLock)
+            g_StringPool = dmStringPool::New();
+        }
+
+        // Each thread can record up to max_samples per frame, the thread buffers are (re)allocated on first use
+        g_ThreadSampleCapacity = 0;
+        if (max_samples > 0)
+        {
+            g_ThreadSampleCapacity = 1;
+            while (g_ThreadSampleCapacity < max_samples && g_ThreadSampleCapacity < MAX_THREAD_SAMPLE_CAPACITY)
+                g_ThreadSampleCapacity *= 2;
+        }
+        {
+            DM_SPINLOCK_SCOPED_LOCK(g_ProfileLock)
+            ++g_Generation;
+        }
 
         if (g_Scopes.Capacity() == 0)
         {
@@ -135,6 +191,7 @@ namespace dmProfile
             p->m_ScopesData.SetCapacity(max_scopes);
             p->m_ScopesData.SetSize(max_scopes);
 
+            p->m_BeginTicks = 0;
             p->m_ScopeCount = 0;
             p->m_CounterCount = 0;
 
@@ -178,7 +235,8 @@ namespace dmProfile
         // Set g_BeginTime even if we haven't started since threads may calculate scopes outside of
         // engine Begin()/End() of profiles which happens in Engine::Step() - just so we don't get
         // totally crazy numbers if this happens
-        g_BeginTime = GetNowTicks();
+        g_ActiveProfile->m_BeginTicks = GetNowTicks();
+        g_BeginTime = (uint32_t)g_ActiveProfile->m_BeginTicks;
         g_IsInitialized = true;
     }
 
@@ -202,10 +260,34 @@ namespace dmProfile
         g_ActiveProfile = &g_EmptyProfile;
 
         g_StringTable.Clear();
-        if (g_StringPool != 0)
-            dmStringPool::Delete(g_StringPool);
-        g_StringPool = 0;
+        {
+            DM_SPINLOCK_SCOPED_LOCK(g_StringPoolLock)
+            if (g_StringPool != 0)
+                dmStringPool::Delete(g_StringPool);
+            g_StringPool = 0;
+        }
         g_IsInitialized = false;
+
+        // The buffers of live threads are still referred to by their TLS values, and are reallocated
+        // by their threads after the next Initialize() or marked as exited when the threads exit
+        {
+            DM_SPINLOCK_SCOPED_LOCK(g_ProfileLock)
+            ThreadSampleBuffer** buffer_ptr = &g_ThreadBuffers;
+            while (*buffer_ptr != 0)
+            {
+                ThreadSampleBuffer* buffer = *buffer_ptr;
+                if (buffer->m_Exited)
+                {
+                    *buffer_ptr = buffer->m_Next;
+                    free(buffer->m_Samples);
+                    free(buffer);
+                }
+                else
+                {
+                    buffer_ptr = &buffer->m_Next;
+                }
+            }
+        }
     }
 
     static void CalculateScopeProfileThread(Profile* profile, const uint32_t* key, uint8_t* value)
@@ -341,6 +423,60 @@ namespace dmProfile
         active_threads.Iterate(&CalculateScopeProfileThread, profile);
     }
 
+    // Move the samples of ended scopes recorded by all threads since the last call into the profile
+    static bool MergeThreadSamples(Profile* profile)
+    {
+        bool out_of_samples = false;
+        for (ThreadSampleBuffer* buffer = g_ThreadBuffers; buffer != 0; buffer = buffer->m_Next)
+        {
+            uint32_t read = (uint32_t)buffer->m_Read;
+            uint32_t write = (uint32_t)dmAtomicAdd32(&buffer->m_Write, 0);
+            // The first open sample, the buffer is read from there on the next merge
+            uint32_t pending = write;
+            // Buffers from a previous initialization are reallocated by their threads on next use
+            if (buffer->m_Generation == g_Generation)
+            {
+                uint32_t mask = buffer->m_Capacity - 1;
+                for (uint32_t i = read; i != write; ++i)
+                {
+                    Sample* sample = &buffer->m_Samples[i & mask];
+                    int32_atomic_t* elapsed = (int32_atomic_t*)&sample->m_Elapsed;
+                    uint32_t value = (uint32_t)dmAtomicAdd32(elapsed, 0);
+                    if (value == SAMPLE_MERGED)
+                        continue;
+                    if (value == SAMPLE_OPEN)
+                    {
+                        // Keep the open sample unless it holds back half the buffer, then it's dropped
+                        if (write - i < buffer->m_Capacity / 2)
+                        {
+                            if (pending == write)
+                                pending = i;
+                            // It's merged into a later profile, from the start of that profile
+                            sample->m_Start = 0;
+                            continue;
+                        }
+                        if ((uint32_t)dmAtomicCompareStore32(elapsed, (int32_t)SAMPLE_MERGED, (int32_t)SAMPLE_OPEN) == SAMPLE_OPEN)
+                            continue;
+                        // The scope ended in the meantime
+                    }
+                    if (profile->m_Samples.Full())
+                    {
+                        out_of_samples = true;
+                        pending = write;
+                        break;
+                    }
+                    profile->m_Samples.Push(*sample);
+                    if (pending != write)
+                    {
+                        dmAtomicStore32(elapsed, (int32_t)SAMPLE_MERGED);
+                    }
+                }
+            }
+            dmAtomicStore32(&buffer->m_Read, (int32_t)pending);
+        }
+        return out_of_samples;
+    }
+
     HProfile Begin()
     {
         if (!g_IsInitialized)
@@ -351,6 +487,7 @@ namespace dmProfile
 
         dmSpinlock::Lock(&g_ProfileLock);
 
+        bool out_of_samples = MergeThreadSamples(g_ActiveProfile);
         CalculateScopeProfile(g_ActiveProfile);
 
         Profile* ret = g_ActiveProfile;
@@ -394,10 +531,11 @@ namespace dmProfile
 
         profile->m_Samples.SetSize(0);
 
-        g_BeginTime = GetNowTicks();
+        profile->m_BeginTicks = GetNowTicks();
+        g_BeginTime = (uint32_t)profile->m_BeginTicks;
 
         g_OutOfScopes = false;
-        g_OutOfSamples = false;
+        g_OutOfSamples = out_of_samples;
         g_OutOfCounters = false;
 
         dmSpinlock::Unlock(&g_ProfileLock);
@@ -461,58 +599,88 @@ namespace dmProfile
     // Used when out of samples in order to remove conditional branches
     Sample g_DummySample = { "OUT_OF_SAMPLES", 0, 0, 0, 0 };
 
-    static Sample* AllocateNewSample()
+    // TLS destructor, called when a thread exits
+    static void ReleaseThreadBuffer(void* value)
     {
-        // NOTE: We can't take the spinlock if paused
-        // as it might already been taken in dmProfile:Begin()
-        // A deadlock case occur in dmMessage::Post if http-server is logging
-        // TODO: Use mutex instead?
-        if (g_Paused)
+        ThreadSampleBuffer* buffer = (ThreadSampleBuffer*)value;
+        DM_SPINLOCK_SCOPED_LOCK(g_ProfileLock)
+        buffer->m_Exited = 1;
+    }
+
+    static ThreadSampleBuffer* SetupThreadBuffer(ThreadSampleBuffer* buffer)
+    {
+        DM_SPINLOCK_SCOPED_LOCK(g_ProfileLock)
+        if (buffer == 0)
         {
-            return &g_DummySample;
+            // Reuse the buffer of an exited thread. Samples not yet merged are kept
+            for (ThreadSampleBuffer* b = g_ThreadBuffers; b != 0; b = b->m_Next)
+            {
+                if (b->m_Exited)
+                {
+                    buffer = b;
+                    break;
+                }
+            }
+            if (buffer != 0)
+            {
+                buffer->m_Exited = 0;
+                dmThread::SetTlsValue(g_TlsKey, buffer);
+                if (buffer->m_Generation == g_Generation)
+                    return buffer;
+            }
+            else
+            {
+                buffer = (ThreadSampleBuffer*)malloc(sizeof(ThreadSampleBuffer));
+                memset(buffer, 0, sizeof(*buffer));
+                buffer->m_ThreadId = (uint16_t)dmAtomicIncrement32(&g_ThreadCount);
+                buffer->m_Next = g_ThreadBuffers;
+                g_ThreadBuffers = buffer;
+                dmThread::SetTlsValue(g_TlsKey, buffer);
+            }
         }
 
-        DM_SPINLOCK_SCOPED_LOCK(g_ProfileLock)
-        Profile* profile = g_ActiveProfile;
+        free(buffer->m_Samples);
+        buffer->m_Samples = g_ThreadSampleCapacity > 0 ? (Sample*)malloc(sizeof(Sample) * g_ThreadSampleCapacity) : 0;
+        buffer->m_Capacity = g_ThreadSampleCapacity;
+        buffer->m_Generation = g_Generation;
+        dmAtomicStore32(&buffer->m_Write, 0);
+        dmAtomicStore32(&buffer->m_Read, 0);
+        return buffer;
+    }
 
-        bool full = profile->m_Samples.Full();
-        if (full)
+    // Returns a slot in the calling thread's buffer. The sample is published when the scope has filled it in
+    static Sample* AllocateSample(ProfileScope* scope)
+    {
+        if (g_Paused || !g_IsInitialized)
         {
-            g_OutOfSamples = true;
             return &g_DummySample;
         }
-        profile->m_Samples.SetSize(profile->m_Samples.Size() + 1);
-        Sample* ret = profile->m_Samples.End() - 1;
-        return ret;
-    }
 
-    Sample* AllocateSample()
-    {
-        Sample* ret = AllocateNewSample();
-        if (ret == &g_DummySample)
+        ThreadSampleBuffer* buffer = (ThreadSampleBuffer*)dmThread::GetTlsValue(g_TlsKey);
+        if (buffer == 0 || buffer->m_Generation != g_Generation)
         {
-            return ret;
+            buffer = SetupThreadBuffer(buffer);
         }
 
-        void* tls_data = dmThread::GetTlsValue(g_TlsKey);
-        if (tls_data == 0)
+        uint32_t write = (uint32_t)buffer->m_Write;
+        if (write - (uint32_t)buffer->m_Read >= buffer->m_Capacity)
         {
-            // NOTE: We store thread_id + 1. Otherwise we can't differentiate between thread-id 0 and not initialized
-            int32_t next_thread_id = dmAtomicIncrement32(&g_ThreadCount) + 1;
-            void* thread_id = (void*)((uintptr_t)next_thread_id);
-            dmThread::SetTlsValue(g_TlsKey, thread_id);
-            tls_data = thread_id;
+            g_OutOfSamples = true;
+            return &g_DummySample;
         }
-        intptr_t thread_id = ((intptr_t)tls_data) - 1;
-        assert(thread_id >= 0);
 
-        ret->m_ThreadId = thread_id;
+        scope->m_Buffer = buffer;
+        scope->m_SampleIndex = write;
+        scope->m_Generation = buffer->m_Generation;
+
+        Sample* ret = &buffer->m_Samples[write & (buffer->m_Capacity - 1)];
+        ret->m_ThreadId = buffer->m_ThreadId;
         return ret;
     }
 
     const char* Internalize(const char* string, uint32_t string_length, uint32_t string_hash)
     {
-        DM_SPINLOCK_SCOPED_LOCK(g_ProfileLock)
+        DM_SPINLOCK_SCOPED_LOCK(g_StringPoolLock)
         if (g_StringPool)
         {
             const char* s = dmStringPool::Add(g_StringPool, string, string_length, string_hash);
@@ -622,9 +790,14 @@ namespace dmProfile
             return;
         }
 
-        DM_SPINLOCK_SCOPED_LOCK(g_ProfileLock)
+        // Lock free, an add racing with the profile swap in Begin() is attributed to either frame
         Profile* profile = g_ActiveProfile;
-        profile->m_CountersData[counter_index].m_Value += amount;
+        dmAtomicAdd32(&profile->m_CountersData[counter_index].m_Value, (int32_t)amount);
+    }
+
+    uint64_t GetBeginTicks(HProfile profile)
+    {
+        return profile->m_BeginTicks;
     }
 
     float GetFrameTime()
@@ -803,23 +976,46 @@ namespace dmProfile
     void ProfileScope::StartScope(uint32_t scope_index, const char* name, uint32_t name_hash)
     {
         m_StartTick = GetNowTicks();
-        Sample* s = AllocateSample();
+        m_Buffer = 0;
+        Sample* s = AllocateSample(this);
         s->m_Name = name;
         s->m_Scope = &g_Scopes[scope_index];
         s->m_NameHash = name_hash;
         s->m_Start = (uint32_t)(m_StartTick - g_BeginTime);
+        s->m_Elapsed = m_Buffer ? SAMPLE_OPEN : 0;
         m_Sample = s;
+
+        if (m_Buffer)
+        {
+            dmAtomicStore32(&m_Buffer->m_Write, (int32_t)(m_SampleIndex + 1));
+        }
     }
 
     void ProfileScope::EndScope()
     {
         uint64_t end = GetNowTicks();
-        m_Sample->m_Elapsed = (uint32_t)(end - m_StartTick);
-        if (m_Sample->m_Elapsed > (dmProfile::GetTicksPerSecond() * 2))
+        uint32_t elapsed = (uint32_t)dmMath::Min(end - m_StartTick, (uint64_t)SAMPLE_MAX_ELAPSED);
+
+        // Long running scopes may outlive their slot if the thread recorded a full buffer of samples
+        // in the meantime, or if the profiler was reinitialized
+        ThreadSampleBuffer* buffer = m_Buffer;
+        bool valid = buffer == 0 || (buffer->m_Generation == m_Generation && (uint32_t)buffer->m_Write - m_SampleIndex <= buffer->m_Capacity);
+        if (buffer == 0)
         {
-            double elapsed_s = (double)(m_Sample->m_Elapsed) / dmProfile::GetTicksPerSecond();
-            dmLogWarning("Profiler %s.%s took %.3lf seconds", m_Sample->m_Scope->m_Name, m_Sample->m_Name, elapsed_s);
+            m_Sample->m_Elapsed = elapsed;
+        }
+        else if (valid)
+        {
+            // Fails if the open sample was dropped by Begin()
+            dmAtomicCompareStore32((int32_atomic_t*)&m_Sample->m_Elapsed, (int32_t)elapsed, (int32_t)SAMPLE_OPEN);
         }
 
+        if (elapsed > (dmProfile::GetTicksPerSecond() * 2))
+        {
+            double elapsed_s = (double)(elapsed) / dmProfile::GetTicksPerSecond();
+            const char* scope_name = valid ? m_Sample->m_Scope->m_Name : "?";
+            const char* sample_name = valid ? m_Sample->m_Name : "?";
+            dmLogWarning("Profiler %s.%s took %.3lf seconds", scope_name, sample_name, elapsed_s);
+        }
     }
 } // namespace dmProfile
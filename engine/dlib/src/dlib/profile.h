@@ -273,12 +273,6 @@ namespace dmProfile
      */
     uint32_t AllocateScope(const char* name);
 
-    /**
-     * Internal function
-     * @return #Sample
-     */
-    Sample* AllocateSample();
-
     /**
      * Create an internalized string. Use this function in DM_PROFILE if the
      * name isn't valid for the life-time of the application
@@ -318,6 +312,13 @@ namespace dmProfile
      */
     void AddCounterIndex(uint32_t counter_index, uint32_t amount);
 
+    /**
+     * Get the tick the profile snapshot started recording at
+     * @param profile Profile snapshot
+     * @return Begin tick. Sample start times are relative to this
+     */
+    uint64_t GetBeginTicks(HProfile profile);
+
     /**
      * Get time for the frame total
      * @return Total frame time
@@ -348,10 +349,16 @@ namespace dmProfile
     uint64_t GetNowTicks();
 
     /// Internal, do not use.
+    struct ThreadSampleBuffer;
+
     struct ProfileScope
     {
         Sample* m_Sample;
+        // Owning thread buffer, used to detect if the sample slot was recycled before the scope ended
+        ThreadSampleBuffer* m_Buffer;
         uint64_t m_StartTick;
+        uint32_t m_SampleIndex;
+        uint32_t m_Generation;
         inline ProfileScope(uint32_t scope_index, const char* name, uint32_t name_hash)
         {
             if (scope_index != 0xffffffffu)
@@ -0,0 +1,437 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "profile_capture.h"
+#include "array.h"
+#include "condition_variable.h"
+#include "hashtable.h"
+#include "log.h"
+#include "math.h"
+#include "mutex.h"
+#include "thread.h"
+
+namespace dmProfile
+{
+    struct CaptureFrameData
+    {
+        dmArray<uint8_t> m_Data;
+        uint32_t         m_FrameIndex;
+        uint32_t         m_FrameTicks;
+    };
+
+    struct Capture
+    {
+        FILE*                           m_File;
+
+        // String pointer to string id. Profile strings are either literals or internalized,
+        // so the pointers are valid for the life-time of the profiler
+        dmHashTable<uintptr_t, uint32_t> m_StringIds;
+        // All string records written so far. In streaming mode, the ones after m_FlushedStringsSize
+        // are prepended to the next queued frame
+        dmArray<uint8_t>                m_StringData;
+        uint32_t                        m_FlushedStringsSize;
+        dmArray<uint8_t>                m_FrameData;
+
+        // Streaming: ring buffer of frames pending for the writer thread
+        // Worst frames: the currently worst frames, unordered
+        CaptureFrameData*               m_Frames;
+        uint32_t                        m_FrameSlots;
+        uint32_t                        m_PendingHead;
+        uint32_t                        m_PendingCount;
+        uint32_t                        m_WorstFrameCount;
+
+        dmThread::Thread                m_Thread;
+        dmMutex::HMutex                 m_Mutex;
+        dmConditionVariable::HConditionVariable m_Condition;
+        bool                            m_Quit;
+        bool                            m_WriteError;
+
+        uint32_t                        m_FrameIndex;
+        uint32_t                        m_CapturedFrames;
+        uint32_t                        m_DroppedFrames;
+    };
+
+    static void WriteU16(dmArray<uint8_t>& buffer, uint16_t value)
+    {
+        if (buffer.Remaining() < sizeof(value))
+            buffer.OffsetCapacity(dmMath::Max(buffer.Capacity(), 256U));
+        buffer.PushArray((const uint8_t*)&value, sizeof(value));
+    }
+
+    static void WriteU32(dmArray<uint8_t>& buffer, uint32_t value)
+    {
+        if (buffer.Remaining() < sizeof(value))
+            buffer.OffsetCapacity(dmMath::Max(buffer.Capacity(), 256U));
+        buffer.PushArray((const uint8_t*)&value, sizeof(value));
+    }
+
+    static void WriteU64(dmArray<uint8_t>& buffer, uint64_t value)
+    {
+        if (buffer.Remaining() < sizeof(value))
+            buffer.OffsetCapacity(dmMath::Max(buffer.Capacity(), 256U));
+        buffer.PushArray((const uint8_t*)&value, sizeof(value));
+    }
+
+    static void WriteBytes(dmArray<uint8_t>& buffer, const void* data, uint32_t size)
+    {
+        if (buffer.Remaining() < size)
+            buffer.OffsetCapacity(dmMath::Max(buffer.Capacity(), size + 256U));
+        buffer.PushArray((const uint8_t*)data, size);
+    }
+
+    static void WriteTag(dmArray<uint8_t>& buffer, const char* tag, uint32_t payload_size)
+    {
+        WriteBytes(buffer, tag, 4);
+        WriteU32(buffer, payload_size);
+    }
+
+    // The payload size of a record isn't known until it's written
+    static void PatchU32(dmArray<uint8_t>& buffer, uint32_t offset, uint32_t value)
+    {
+        memcpy(&buffer[offset], &value, sizeof(value));
+    }
+
+    static uint32_t GetStringId(Capture* capture, const char* string)
+    {
+        if (!string)
+            string = "";
+
+        uint32_t* id = capture->m_StringIds.Get((uintptr_t)string);
+        if (id)
+            return *id;
+
+        if (capture->m_StringIds.Full())
+        {
+            uint32_t capacity = capture->m_StringIds.Capacity() + 256;
+            capture->m_StringIds.SetCapacity(dmMath::Max(16U, 2 * capacity / 3), capacity);
+        }
+
+        uint32_t new_id = capture->m_StringIds.Size();
+        capture->m_StringIds.Put((uintptr_t)string, new_id);
+
+        uint32_t length = (uint32_t)strlen(string);
+        WriteTag(capture->m_StringData, "STRG", 4 + length);
+        WriteU32(capture->m_StringData, new_id);
+        WriteBytes(capture->m_StringData, string, length);
+        return new_id;
+    }
+
+    struct FrameContext
+    {
+        Capture*          m_Capture;
+        dmArray<uint8_t>* m_Buffer;
+        uint32_t          m_Count;
+        uint32_t          m_MaxElapsed;
+    };
+
+    static void FrameTicksCallback(void* context, const ScopeData* scope_data)
+    {
+        // Frame time is defined as the maximum scope, see CalculateScopeProfile
+        FrameContext* ctx = (FrameContext*)context;
+        ctx->m_MaxElapsed = dmMath::Max(ctx->m_MaxElapsed, scope_data->m_Elapsed);
+    }
+
+    static void WriteSampleCallback(void* context, const Sample* sample)
+    {
+        FrameContext* ctx = (FrameContext*)context;
+        dmArray<uint8_t>& buffer = *ctx->m_Buffer;
+        WriteU32(buffer, GetStringId(ctx->m_Capture, sample->m_Name));
+        WriteU32(buffer, GetStringId(ctx->m_Capture, sample->m_Scope ? sample->m_Scope->m_Name : 0));
+        WriteU32(buffer, sample->m_Start);
+        WriteU32(buffer, sample->m_Elapsed);
+        WriteU16(buffer, sample->m_ThreadId);
+        WriteU16(buffer, 0);
+        ctx->m_Count++;
+    }
+
+    static void WriteScopeCallback(void* context, const ScopeData* scope_data)
+    {
+        if (scope_data->m_Count == 0)
+            return;
+        FrameContext* ctx = (FrameContext*)context;
+        dmArray<uint8_t>& buffer = *ctx->m_Buffer;
+        WriteU32(buffer, GetStringId(ctx->m_Capture, scope_data->m_Scope->m_Name));
+        WriteU32(buffer, scope_data->m_Elapsed);
+        WriteU32(buffer, scope_data->m_Count);
+        ctx->m_Count++;
+    }
+
+    static void WriteCounterCallback(void* context, const CounterData* counter_data)
+    {
+        if (counter_data->m_Value == 0)
+            return;
+        FrameContext* ctx = (FrameContext*)context;
+        dmArray<uint8_t>& buffer = *ctx->m_Buffer;
+        WriteU32(buffer, GetStringId(ctx->m_Capture, counter_data->m_Counter->m_Name));
+        WriteU32(buffer, (uint32_t)counter_data->m_Value);
+        ctx->m_Count++;
+    }
+
+    static void WriteFrame(Capture* capture, HProfile profile, uint32_t frame_ticks, dmArray<uint8_t>& buffer)
+    {
+        uint32_t start = buffer.Size();
+        WriteTag(buffer, "FRAM", 0);
+        WriteU32(buffer, capture->m_FrameIndex);
+        WriteU64(buffer, GetBeginTicks(profile));
+        WriteU32(buffer, frame_ticks);
+        uint32_t counts_offset = buffer.Size();
+        WriteU32(buffer, 0);
+        WriteU32(buffer, 0);
+        WriteU32(buffer, 0);
+
+        FrameContext ctx;
+        ctx.m_Capture = capture;
+        ctx.m_Buffer = &buffer;
+        ctx.m_Count = 0;
+        IterateSamples(profile, &ctx, false, WriteSampleCallback);
+        PatchU32(buffer, counts_offset, ctx.m_Count);
+
+        ctx.m_Count = 0;
+        IterateScopeData(profile, &ctx, false, WriteScopeCallback);
+        PatchU32(buffer, counts_offset + 4, ctx.m_Count);
+
+        ctx.m_Count = 0;
+        IterateCounterData(profile, &ctx, WriteCounterCallback);
+        PatchU32(buffer, counts_offset + 8, ctx.m_Count);
+
+        PatchU32(buffer, start + 4, buffer.Size() - start - 8);
+    }
+
+    static void WriteToFile(Capture* capture, dmArray<uint8_t>& buffer)
+    {
+        if (buffer.Empty() || capture->m_WriteError)
+            return;
+        if (fwrite(buffer.Begin(), 1, buffer.Size(), capture->m_File) != buffer.Size())
+        {
+            dmLogError("Failed to write profile capture");
+            capture->m_WriteError = true;
+        }
+    }
+
+    static void WriterThread(void* arg)
+    {
+        Capture* capture = (Capture*)arg;
+        while (true)
+        {
+            uint32_t index;
+            {
+                DM_MUTEX_SCOPED_LOCK(capture->m_Mutex);
+                while (capture->m_PendingCount == 0 && !capture->m_Quit)
+                {
+                    dmConditionVariable::Wait(capture->m_Condition, capture->m_Mutex);
+                }
+                if (capture->m_PendingCount == 0)
+                    break;
+                index = capture->m_PendingHead;
+            }
+
+            // The slot is owned by the writer until it's popped below
+            WriteToFile(capture, capture->m_Frames[index].m_Data);
+
+            DM_MUTEX_SCOPED_LOCK(capture->m_Mutex);
+            capture->m_PendingHead = (capture->m_PendingHead + 1) % capture->m_FrameSlots;
+            capture->m_PendingCount--;
+        }
+    }
+
+    void SetDefaultCaptureParams(CaptureParams* params)
+    {
+        memset(params, 0, sizeof(*params));
+        params->m_MaxPendingFrames = 16;
+    }
+
+    HCapture NewCapture(const CaptureParams* params)
+    {
+        FILE* file = fopen(params->m_Path, "wb");
+        if (!file)
+        {
+            dmLogError("Failed to open profile capture file '%s'", params->m_Path);
+            return 0;
+        }
+
+        Capture* capture = new Capture;
+        capture->m_File = file;
+        capture->m_StringIds.SetCapacity(256, 384);
+        capture->m_FlushedStringsSize = 0;
+        capture->m_WorstFrameCount = params->m_WorstFrameCount;
+        capture->m_FrameSlots = params->m_WorstFrameCount ? params->m_WorstFrameCount : dmMath::Max(1U, params->m_MaxPendingFrames);
+        capture->m_Frames = new CaptureFrameData[capture->m_FrameSlots];
+        capture->m_PendingHead = 0;
+        capture->m_PendingCount = 0;
+        capture->m_Quit = false;
+        capture->m_WriteError = false;
+        capture->m_FrameIndex = 0;
+        capture->m_CapturedFrames = 0;
+        capture->m_DroppedFrames = 0;
+
+        dmArray<uint8_t> header;
+        WriteBytes(header, "DMPC", 4);
+        WriteU32(header, CAPTURE_VERSION);
+        WriteU64(header, GetTicksPerSecond());
+        WriteToFile(capture, header);
+
+        capture->m_Thread = 0;
+        capture->m_Mutex = 0;
+        capture->m_Condition = 0;
+        if (!capture->m_WorstFrameCount)
+        {
+            capture->m_Mutex = dmMutex::New();
+            capture->m_Condition = dmConditionVariable::New();
+            capture->m_Thread = dmThread::New(WriterThread, 0x80000, capture, "profcapture");
+        }
+        return capture;
+    }
+
+    static void CaptureWorstFrame(Capture* capture, HProfile profile, uint32_t frame_ticks)
+    {
+        uint32_t slot;
+        if (capture->m_CapturedFrames < capture->m_WorstFrameCount)
+        {
+            slot = capture->m_CapturedFrames++;
+        }
+        else
+        {
+            // The number of kept frames is small, a linear scan for the best one is cheap
+            slot = 0;
+            for (uint32_t i = 1; i < capture->m_FrameSlots; ++i)
+            {
+                if (capture->m_Frames[i].m_FrameTicks < capture->m_Frames[slot].m_FrameTicks)
+                    slot = i;
+            }
+            if (frame_ticks <= capture->m_Frames[slot].m_FrameTicks)
+                return;
+        }
+
+        CaptureFrameData& frame = capture->m_Frames[slot];
+        frame.m_FrameIndex = capture->m_FrameIndex;
+        frame.m_FrameTicks = frame_ticks;
+        frame.m_Data.SetSize(0);
+        WriteFrame(capture, profile, frame_ticks, frame.m_Data);
+    }
+
+    static void CaptureStreamFrame(Capture* capture, HProfile profile, uint32_t frame_ticks)
+    {
+        uint32_t slot;
+        {
+            DM_MUTEX_SCOPED_LOCK(capture->m_Mutex);
+            if (capture->m_PendingCount == capture->m_FrameSlots)
+            {
+                capture->m_DroppedFrames++;
+                return;
+            }
+            slot = (capture->m_PendingHead + capture->m_PendingCount) % capture->m_FrameSlots;
+        }
+
+        // The slot isn't visible to the writer until the pending count is increased
+        CaptureFrameData& frame = capture->m_Frames[slot];
+        frame.m_FrameIndex = capture->m_FrameIndex;
+        frame.m_FrameTicks = frame_ticks;
+        frame.m_Data.SetSize(0);
+
+        capture->m_FrameData.SetSize(0);
+        WriteFrame(capture, profile, frame_ticks, capture->m_FrameData);
+
+        // New strings must precede the frame referencing them
+        uint32_t new_strings_size = capture->m_StringData.Size() - capture->m_FlushedStringsSize;
+        if (new_strings_size)
+        {
+            WriteBytes(frame.m_Data, &capture->m_StringData[capture->m_FlushedStringsSize], new_strings_size);
+            capture->m_FlushedStringsSize = capture->m_StringData.Size();
+        }
+        WriteBytes(frame.m_Data, capture->m_FrameData.Begin(), capture->m_FrameData.Size());
+        capture->m_CapturedFrames++;
+
+        DM_MUTEX_SCOPED_LOCK(capture->m_Mutex);
+        capture->m_PendingCount++;
+        dmConditionVariable::Signal(capture->m_Condition);
+    }
+
+    void CaptureFrame(HCapture capture, HProfile profile)
+    {
+        if (!profile)
+            return;
+
+        FrameContext ctx;
+        ctx.m_MaxElapsed = 0;
+        IterateScopeData(profile, &ctx, false, FrameTicksCallback);
+
+        if (capture->m_WorstFrameCount)
+            CaptureWorstFrame(capture, profile, ctx.m_MaxElapsed);
+        else
+            CaptureStreamFrame(capture, profile, ctx.m_MaxElapsed);
+        capture->m_FrameIndex++;
+    }
+
+    void DeleteCapture(HCapture capture)
+    {
+        if (capture->m_Thread)
+        {
+            {
+                DM_MUTEX_SCOPED_LOCK(capture->m_Mutex);
+                capture->m_Quit = true;
+                dmConditionVariable::Signal(capture->m_Condition);
+            }
+            dmThread::Join(capture->m_Thread);
+            dmConditionVariable::Delete(capture->m_Condition);
+            dmMutex::Delete(capture->m_Mutex);
+        }
+        else
+        {
+            // Strings are only complete once all frames are captured, so they go first
+            WriteToFile(capture, capture->m_StringData);
+
+            // Write the kept frames in the order they were captured
+            uint32_t count = capture->m_CapturedFrames;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                uint32_t first = i;
+                for (uint32_t j = i + 1; j < count; ++j)
+                {
+                    if (capture->m_Frames[j].m_FrameIndex < capture->m_Frames[first].m_FrameIndex)
+                        first = j;
+                }
+                if (first != i)
+                {
+                    CaptureFrameData& a = capture->m_Frames[i];
+                    CaptureFrameData& b = capture->m_Frames[first];
+                    a.m_Data.Swap(b.m_Data);
+                    uint32_t tmp = a.m_FrameIndex; a.m_FrameIndex = b.m_FrameIndex; b.m_FrameIndex = tmp;
+                    tmp = a.m_FrameTicks; a.m_FrameTicks = b.m_FrameTicks; b.m_FrameTicks = tmp;
+                }
+                WriteToFile(capture, capture->m_Frames[i].m_Data);
+            }
+        }
+
+        dmArray<uint8_t> footer;
+        WriteTag(footer, "ENDC", 8);
+        WriteU32(footer, capture->m_CapturedFrames);
+        WriteU32(footer, capture->m_DroppedFrames);
+        WriteToFile(capture, footer);
+
+        fclose(capture->m_File);
+        delete [] capture->m_Frames;
+        delete capture;
+    }
+
+    uint32_t GetCapturedFrameCount(HCapture capture)
+    {
+        return capture->m_CapturedFrames;
+    }
+
+    uint32_t GetDroppedFrameCount(HCapture capture)
+    {
+        return capture->m_DroppedFrames;
+    }
+}
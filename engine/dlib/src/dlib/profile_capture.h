@@ -0,0 +1,108 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_PROFILE_CAPTURE_H
+#define DM_PROFILE_CAPTURE_H
+
+#include <stdint.h>
+#include <dlib/profile.h>
+
+/**
+ * Profile capture. Records the profile snapshots to a file for offline analysis,
+ * e.g. for long headless runs where polling the engine service isn't an option.
+ *
+ * The file is a sequence of records, all values in little endian:
+ *
+ *   header:  "DMPC" | u32 version | u64 ticks per second
+ *   record:  char[4] tag | u32 payload size | payload
+ *
+ *   "STRG":  u32 string id | string bytes (not null terminated)
+ *   "FRAM":  u32 frame index | u64 begin tick | u32 frame ticks |
+ *            u32 sample count | u32 scope count | u32 counter count |
+ *            samples:  u32 name id | u32 scope id | u32 start | u32 elapsed | u16 thread id | u16 pad
+ *            scopes:   u32 name id | u32 elapsed | u32 count
+ *            counters: u32 name id | i32 value
+ *   "ENDC":  u32 captured frame count | u32 dropped frame count
+ *
+ * A string record always precedes the first frame referencing it. Sample start times are relative
+ * to the frame begin tick. Use the profile_capture.py tool to convert a capture to Chrome trace-event JSON.
+ */
+namespace dmProfile
+{
+    /// Profile capture handle
+    typedef struct Capture* HCapture;
+
+    /// Version of the capture file format
+    const uint32_t CAPTURE_VERSION = 1;
+
+    void SetDefaultCaptureParams(struct CaptureParams* params);
+
+    /**
+     * Parameters when creating a new capture
+     */
+    struct CaptureParams
+    {
+        /// Path of the capture file
+        const char* m_Path;
+
+        /// If non-zero, only the N frames with the longest frame time are kept and written
+        /// when the capture is deleted. Otherwise every frame is streamed to the file.
+        /// Default 0
+        uint32_t    m_WorstFrameCount;
+
+        /// Max number of frames queued for the writer thread when streaming. Frames captured
+        /// while the queue is full are dropped rather than stalling the caller.
+        /// Default 16
+        uint32_t    m_MaxPendingFrames;
+
+        CaptureParams()
+        {
+            SetDefaultCaptureParams(this);
+        }
+    };
+
+    /**
+     * Create a new capture and open the capture file for writing
+     * @param params parameters
+     * @return capture handle, 0 if the file couldn't be opened
+     */
+    HCapture NewCapture(const CaptureParams* params);
+
+    /**
+     * Flush all pending frames and close the capture file
+     * @param capture capture handle
+     */
+    void DeleteCapture(HCapture capture);
+
+    /**
+     * Capture a profile snapshot. Call with the profile returned by #Begin, before it's released.
+     * @param capture capture handle
+     * @param profile profile snapshot
+     */
+    void CaptureFrame(HCapture capture, HProfile profile);
+
+    /**
+     * Get the number of frames written, or kept for writing, so far
+     * @param capture capture handle
+     * @return number of captured frames
+     */
+    uint32_t GetCapturedFrameCount(HCapture capture);
+
+    /**
+     * Get the number of frames dropped since the writer thread couldn't keep up
+     * @param capture capture handle
+     * @return number of dropped frames
+     */
+    uint32_t GetDroppedFrameCount(HCapture capture);
+}
+
+#endif // DM_PROFILE_CAPTURE_H
@@ -0,0 +1,153 @@
+# Copyright 2020 The Defold Foundation
+# Licensed under the Defold License version 1.0 (the "License"); you may not use
+# this file except in compliance with the License.
+#
+# You may obtain a copy of the License, together with FAQs at
+# https://www.defold.com/license
+#
+# Unless required by applicable law or agreed to in writing, software distributed
+# under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied. See the License for the
+# specific language governing permissions and limitations under the License.
+
+# Reads profile captures written by dmProfile::NewCapture (see dlib/profile_capture.h)
+# and converts them to Chrome trace-event JSON (chrome://tracing, Perfetto) or prints a summary.
+
+import sys, struct, json
+from optparse import OptionParser
+
+CAPTURE_VERSION = 1
+
+class Frame(object):
+    def __init__(self, index, begin_tick, frame_ticks):
+        self.index = index
+        self.begin_tick = begin_tick
+        self.frame_ticks = frame_ticks
+        self.samples = []   # (name, scope, start, elapsed, thread_id)
+        self.scopes = []    # (name, elapsed, count)
+        self.counters = []  # (name, value)
+
+class Capture(object):
+    def __init__(self):
+        self.ticks_per_second = 1
+        self.strings = {}
+        self.frames = []
+        self.captured_count = None
+        self.dropped_count = None
+
+def load(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if len(data) < 16 or data[0:4] != b'DMPC':
+        raise Exception('%s is not a profile capture' % path)
+    version, ticks_per_second = struct.unpack_from('<IQ', data, 4)
+    if version != CAPTURE_VERSION:
+        raise Exception('Unsupported capture version %d' % version)
+
+    capture = Capture()
+    capture.ticks_per_second = ticks_per_second
+    strings = capture.strings
+
+    offset = 16
+    while offset + 8 <= len(data):
+        tag = data[offset:offset+4]
+        size, = struct.unpack_from('<I', data, offset + 4)
+        p = offset + 8
+        if p + size > len(data):
+            # The engine was killed while writing, keep what we have
+            sys.stderr.write('Warning: truncated capture\n')
+            break
+
+        if tag == b'STRG':
+            string_id, = struct.unpack_from('<I', data, p)
+            strings[string_id] = data[p+4:p+size].decode('utf-8', 'replace')
+        elif tag == b'FRAM':
+            index, begin_tick, frame_ticks, sample_count, scope_count, counter_count = struct.unpack_from('<IQIIII', data, p)
+            frame = Frame(index, begin_tick, frame_ticks)
+            p += 28
+            for i in range(sample_count):
+                name, scope, start, elapsed, thread_id, _ = struct.unpack_from('<IIIIHH', data, p)
+                frame.samples.append((strings[name], strings[scope], start, elapsed, thread_id))
+                p += 20
+            for i in range(scope_count):
+                name, elapsed, count = struct.unpack_from('<III', data, p)
+                frame.scopes.append((strings[name], elapsed, count))
+                p += 12
+            for i in range(counter_count):
+                name, value = struct.unpack_from('<Ii', data, p)
+                frame.counters.append((strings[name], value))
+                p += 8
+            capture.frames.append(frame)
+        elif tag == b'ENDC':
+            capture.captured_count, capture.dropped_count = struct.unpack_from('<II', data, p)
+        offset += 8 + size
+
+    return capture
+
+def to_chrome_trace(capture):
+    events = []
+    if not capture.frames:
+        return {'traceEvents': events}
+
+    us_per_tick = 1000000.0 / capture.ticks_per_second
+    base = capture.frames[0].begin_tick
+    for frame in capture.frames:
+        frame_ts = (frame.begin_tick - base) * us_per_tick
+        events.append({'name': 'Frame %d' % frame.index, 'ph': 'i', 's': 'g', 'ts': frame_ts, 'pid': 0, 'tid': 0})
+        for name, scope, start, elapsed, thread_id in frame.samples:
+            events.append({'name': name, 'cat': scope, 'ph': 'X', 'pid': 0, 'tid': thread_id,
+                           'ts': frame_ts + start * us_per_tick, 'dur': elapsed * us_per_tick})
+        for name, value in frame.counters:
+            events.append({'name': name, 'ph': 'C', 'ts': frame_ts, 'pid': 0, 'args': {'value': value}})
+
+    return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+def print_summary(capture, count):
+    ms_per_tick = 1000.0 / capture.ticks_per_second
+    print('Frames: %d' % len(capture.frames))
+    if capture.dropped_count:
+        print('Dropped frames: %d' % capture.dropped_count)
+    if not capture.frames:
+        return
+
+    times = [f.frame_ticks * ms_per_tick for f in capture.frames]
+    print('Frame time: avg %.3f ms  min %.3f ms  max %.3f ms' % (sum(times) / len(times), min(times), max(times)))
+
+    print('\nWorst frames:')
+    worst = sorted(capture.frames, key=lambda f: f.frame_ticks, reverse=True)[:count]
+    for frame in worst:
+        print('  frame %8d  %8.3f ms' % (frame.index, frame.frame_ticks * ms_per_tick))
+
+    totals = {}
+    for frame in capture.frames:
+        for name, elapsed, scope_count in frame.scopes:
+            total = totals.setdefault(name, [0, 0])
+            total[0] += elapsed
+            total[1] += scope_count
+    print('\nScopes (avg per frame):')
+    for name, total in sorted(totals.items(), key=lambda t: t[1][0], reverse=True)[:count]:
+        print('  %-32s %8.3f ms  %8.1f' % (name, total[0] * ms_per_tick / len(capture.frames), float(total[1]) / len(capture.frames)))
+
+if __name__ == '__main__':
+    usage = '''usage: %prog [options] capture-file
+
+Converts a profile capture to Chrome trace-event JSON, or prints a summary of it.'''
+    parser = OptionParser(usage = usage)
+    parser.add_option('-o', '--output', dest='output', default=None, help='Output JSON file. Defaults to stdout')
+    parser.add_option('-s', '--summary', dest='summary', action='store_true', default=False, help='Print a summary instead of converting')
+    parser.add_option('-n', '--count', dest='count', type='int', default=10, help='Number of entries in the summary lists')
+    options, args = parser.parse_args()
+    if len(args) != 1:
+        parser.error('capture file required')
+
+    capture = load(args[0])
+    if options.summary:
+        print_summary(capture, options.count)
+    else:
+        trace = to_chrome_trace(capture)
+        if options.output:
+            with open(options.output, 'w') as f:
+                json.dump(trace, f)
+        else:
+            json.dump(trace, sys.stdout)
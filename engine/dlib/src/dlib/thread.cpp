@@ -11,7 +11,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <assert.h>
-#include <dmsdk/dlib/thread.h>
+#include "thread.h"
 
 #if defined(_WIN32)
 #include <stdlib.h>
@@ -97,9 +97,14 @@ namespace dmThread
     }
 
     TlsKey AllocTls()
+    {
+        return AllocTls(0);
+    }
+
+    TlsKey AllocTls(TlsDestructor destructor)
     {
         pthread_key_t key;
-        int ret = pthread_key_create(&key, 0);
+        int ret = pthread_key_create(&key, destructor);
         assert(ret == 0);
         return key;
     }
@@ -165,12 +170,60 @@ namespace dmThread
     #endif
     }
 
+    // Windows TLS has no destructors, they are called when threads created by New exit
+    static const uint32_t MAX_TLS_DESTRUCTORS = 16;
+    struct TlsDestructorEntry
+    {
+        TlsKey          m_Key;
+        TlsDestructor   m_Destructor;
+    };
+    static TlsDestructorEntry g_TlsDestructors[MAX_TLS_DESTRUCTORS];
+    static volatile LONG g_TlsDestructorCount = 0;
+
+    struct ThreadData
+    {
+        ThreadStart m_Start;
+        void*       m_Arg;
+    };
+
+    static void RunTlsDestructors()
+    {
+        uint32_t count = (uint32_t)g_TlsDestructorCount;
+        if (count > MAX_TLS_DESTRUCTORS)
+            count = MAX_TLS_DESTRUCTORS;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            TlsDestructorEntry* entry = &g_TlsDestructors[i];
+            if (entry->m_Destructor == 0)
+                continue;
+            void* value = TlsGetValue(entry->m_Key);
+            if (value != 0)
+            {
+                TlsSetValue(entry->m_Key, 0);
+                entry->m_Destructor(value);
+            }
+        }
+    }
+
+    static DWORD WINAPI ThreadStartProxy(LPVOID arg)
+    {
+        ThreadData* data = (ThreadData*) arg;
+        data->m_Start(data->m_Arg);
+        delete data;
+        RunTlsDestructors();
+        return 0;
+    }
+
     Thread New(ThreadStart thread_start, uint32_t stack_size, void* arg, const char* name)
     {
+        ThreadData* thread_data = new ThreadData;
+        thread_data->m_Start = thread_start;
+        thread_data->m_Arg = arg;
+
         DWORD thread_id;
         HANDLE thread = CreateThread(NULL, stack_size,
-                                     (LPTHREAD_START_ROUTINE) thread_start,
-                                     arg, 0, &thread_id);
+                                     ThreadStartProxy,
+                                     thread_data, 0, &thread_id);
         assert(thread);
 
         SetThreadName((Thread)thread, name);
@@ -194,8 +247,29 @@ namespace dmThread
         return TlsAlloc();
     }
 
+    TlsKey AllocTls(TlsDestructor destructor)
+    {
+        TlsKey key = TlsAlloc();
+        if (destructor != 0)
+        {
+            uint32_t index = (uint32_t)InterlockedIncrement(&g_TlsDestructorCount) - 1;
+            assert(index < MAX_TLS_DESTRUCTORS);
+            g_TlsDestructors[index].m_Key = key;
+            g_TlsDestructors[index].m_Destructor = destructor;
+        }
+        return key;
+    }
+
     void FreeTls(TlsKey key)
     {
+        uint32_t count = (uint32_t)g_TlsDestructorCount;
+        for (uint32_t i = 0; i < count && i < MAX_TLS_DESTRUCTORS; ++i)
+        {
+            if (g_TlsDestructors[i].m_Key == key)
+            {
+                g_TlsDestructors[i].m_Destructor = 0;
+            }
+        }
         BOOL ret = TlsFree(key);
         assert(ret);
     }
@@ -15,4 +15,18 @@
 
 #include <dmsdk/dlib/thread.h>
 
+namespace dmThread
+{
+    typedef void (*TlsDestructor)(void* value);
+
+    /**
+     * Allocate thread local storage key with a destructor. The destructor is called with the
+     * thread's value when a thread exits with a non-null value set.
+     * On Windows the destructor is only called for threads created with dmThread::New
+     * @param destructor Destructor
+     * @return Key
+     */
+    TlsKey AllocTls(TlsDestructor destructor);
+}
+
 #endif // DM_THREAD_H
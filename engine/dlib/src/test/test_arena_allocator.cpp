@@ -0,0 +1,184 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+#include "../dlib/arena_allocator.h"
+#include "../dlib/thread.h"
+
+TEST(dmArenaAllocator, Alloc)
+{
+    dmArenaAllocator::HArena arena = dmArenaAllocator::New(256, 0);
+
+    for (uint32_t frame = 0; frame < 4; ++frame)
+    {
+        char* buffers[64];
+        uint32_t sizes[64];
+        for (uint32_t i = 0; i < 64; ++i)
+        {
+            sizes[i] = rand() % 100;
+            uint32_t align = 1 << (rand() % 5);
+            buffers[i] = (char*) dmArenaAllocator::Alloc(arena, sizes[i], align);
+            ASSERT_NE((char*) 0, buffers[i]);
+            ASSERT_EQ(0U, ((uintptr_t) buffers[i]) & (align - 1));
+            memset(buffers[i], (int) i, sizes[i]);
+        }
+
+        for (uint32_t i = 0; i < 64; ++i)
+        {
+            for (uint32_t j = 0; j < sizes[i]; ++j)
+            {
+                ASSERT_EQ((char) i, buffers[i][j]);
+            }
+        }
+        dmArenaAllocator::Reset(arena);
+    }
+
+    // After the first reset the pages are merged into one
+    dmArenaAllocator::Stats stats;
+    dmArenaAllocator::GetStats(arena, &stats);
+    ASSERT_EQ(0U, stats.m_Used);
+    ASSERT_EQ(0U, stats.m_FramePeak);
+    ASSERT_GE(stats.m_Capacity, stats.m_HighWaterMark);
+    ASSERT_EQ(0U, stats.m_Capacity % 256);
+
+    dmArenaAllocator::Delete(arena);
+}
+
+TEST(dmArenaAllocator, LargeAlloc)
+{
+    dmArenaAllocator::HArena arena = dmArenaAllocator::New(64, 0);
+
+    void* small = dmArenaAllocator::Alloc(arena, 16, 16);
+    void* large = dmArenaAllocator::Alloc(arena, 1000, 16);
+    ASSERT_NE((void*) 0, small);
+    ASSERT_NE((void*) 0, large);
+    memset(large, 0xff, 1000);
+
+    dmArenaAllocator::Stats stats;
+    dmArenaAllocator::GetStats(arena, &stats);
+    ASSERT_EQ(1016U, stats.m_Used);
+    ASSERT_EQ(1016U, stats.m_HighWaterMark);
+    ASSERT_EQ(64U + 1008U, stats.m_Capacity);
+
+    dmArenaAllocator::Reset(arena);
+    dmArenaAllocator::GetStats(arena, &stats);
+    ASSERT_EQ(1024U, stats.m_Capacity);
+
+    // The same frame now fits in the merged page
+    char* a = (char*) dmArenaAllocator::Alloc(arena, 16, 16);
+    char* b = (char*) dmArenaAllocator::Alloc(arena, 1000, 16);
+    ASSERT_EQ(a + 16, b);
+
+    dmArenaAllocator::Delete(arena);
+}
+
+TEST(dmArenaAllocator, Marker)
+{
+    dmArenaAllocator::HArena arena = dmArenaAllocator::New(128, 0);
+
+    void* first = dmArenaAllocator::Alloc(arena, 32, 16);
+    dmArenaAllocator::Marker marker = dmArenaAllocator::GetMarker(arena);
+
+    void* second = dmArenaAllocator::Alloc(arena, 32, 16);
+    // Spill over to a second page
+    dmArenaAllocator::Alloc(arena, 100, 16);
+    dmArenaAllocator::Alloc(arena, 100, 16);
+
+    dmArenaAllocator::Stats stats;
+    dmArenaAllocator::GetStats(arena, &stats);
+    ASSERT_EQ(264U, stats.m_Used);
+
+    dmArenaAllocator::ResetToMarker(arena, marker);
+    dmArenaAllocator::GetStats(arena, &stats);
+    ASSERT_EQ(32U, stats.m_Used);
+    ASSERT_EQ(264U, stats.m_FramePeak);
+
+    ASSERT_EQ(second, dmArenaAllocator::Alloc(arena, 32, 16));
+    ASSERT_NE(first, second);
+
+    dmArenaAllocator::Delete(arena);
+}
+
+TEST(dmArenaAllocator, Array)
+{
+    dmArenaAllocator::HArena arena = dmArenaAllocator::New(1024, 0);
+
+    dmArray<uint32_t> array;
+    array.SetCapacity(4);
+    for (uint32_t i = 0; i < 4; ++i)
+        array.Push(i);
+
+    // Heap storage is moved to the arena
+    dmArenaAllocator::SetCapacity(arena, array, 8);
+    ASSERT_EQ(4U, array.Size());
+    ASSERT_EQ(8U, array.Capacity());
+    for (uint32_t i = 4; i < 8; ++i)
+        array.Push(i);
+
+    // Growing within the arena
+    dmArenaAllocator::SetCapacity(arena, array, 100);
+    ASSERT_EQ(8U, array.Size());
+    for (uint32_t i = 0; i < 8; ++i)
+        ASSERT_EQ(i, array[i]);
+
+    // Rewinding and reallocating overlapping storage keeps the content
+    dmArenaAllocator::Marker marker = dmArenaAllocator::GetMarker(arena);
+    dmArenaAllocator::SetCapacity(arena, array, 16);
+    dmArenaAllocator::ResetToMarker(arena, marker);
+    dmArenaAllocator::SetCapacity(arena, array, 16);
+    for (uint32_t i = 0; i < 8; ++i)
+        ASSERT_EQ(i, array[i]);
+
+    dmArenaAllocator::Reset(arena);
+    array.SetSize(0);
+    dmArenaAllocator::SetCapacity(arena, array, 4);
+    ASSERT_EQ(0U, array.Size());
+    ASSERT_EQ(4U, array.Capacity());
+
+    // Back to heap storage before the arena is deleted
+    dmArray<uint32_t> heap;
+    array.Swap(heap);
+    dmArenaAllocator::Delete(arena);
+}
+
+static void ThreadArenaFunction(void* arg)
+{
+    dmArenaAllocator::HArena* arenas = (dmArenaAllocator::HArena*) arg;
+    arenas[0] = dmArenaAllocator::GetThreadArena();
+    arenas[1] = dmArenaAllocator::GetThreadArena();
+    dmArenaAllocator::Alloc(arenas[0], 128, 16);
+    dmArenaAllocator::DeleteThreadArena();
+}
+
+TEST(dmArenaAllocator, ThreadArena)
+{
+    dmArenaAllocator::HArena arenas[2] = {0, 0};
+    dmThread::Thread thread = dmThread::New(ThreadArenaFunction, 0x80000, arenas, "arena");
+    dmThread::Join(thread);
+
+    dmArenaAllocator::HArena arena = dmArenaAllocator::GetThreadArena();
+    ASSERT_NE((dmArenaAllocator::HArena) 0, arena);
+    ASSERT_EQ(arena, dmArenaAllocator::GetThreadArena());
+    ASSERT_NE(arena, arenas[0]);
+    ASSERT_EQ(arenas[0], arenas[1]);
+    dmArenaAllocator::DeleteThreadArena();
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
@@ -682,6 +682,65 @@ TEST_F(dmHttpCacheTest, Persist)
     dmHttpCache::Close(cache);
 }
 
+TEST_F(dmHttpCacheTest, Benchmark)
+{
+    const uint32_t entry_count = 10000;
+    dmHttpCache::HCache cache;
+    dmHttpCache::NewParams params;
+    params.m_Path = "tmp/cache";
+    dmHttpCache::Result r = dmHttpCache::Open(&params, &cache);
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+
+    char content[1024];
+    for (uint32_t i = 0; i < sizeof(content); ++i)
+        content[i] = (char) i;
+
+    char uri[128];
+    char etag[32];
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < entry_count; ++i)
+    {
+        dmSnPrintf(uri, sizeof(uri), "http://localhost:8080/build/default/content/asset_%d.texturec", i);
+        dmSnPrintf(etag, sizeof(etag), "etag%d", i);
+        r = Put(cache, uri, etag, content, sizeof(content));
+        ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    }
+    uint64_t put_time = dmTime::GetTime() - start;
+
+    start = dmTime::GetTime();
+    r = dmHttpCache::Flush(cache);
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    uint64_t flush_time = dmTime::GetTime() - start;
+    dmHttpCache::Close(cache);
+
+    start = dmTime::GetTime();
+    r = dmHttpCache::Open(&params, &cache);
+    uint64_t open_time = dmTime::GetTime() - start;
+    ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+    ASSERT_EQ(entry_count, dmHttpCache::GetEntryCount(cache));
+
+    char buffer[sizeof(content)];
+    start = dmTime::GetTime();
+    for (uint32_t i = 0; i < entry_count; ++i)
+    {
+        dmSnPrintf(uri, sizeof(uri), "http://localhost:8080/build/default/content/asset_%d.texturec", i);
+        dmSnPrintf(etag, sizeof(etag), "etag%d", i);
+        FILE* f = 0;
+        uint64_t checksum;
+        r = dmHttpCache::Get(cache, uri, etag, &f, &checksum);
+        ASSERT_EQ(dmHttpCache::RESULT_OK, r);
+        ASSERT_EQ(sizeof(buffer), fread(buffer, 1, sizeof(buffer), f));
+        dmHttpCache::Release(cache, uri, etag, f);
+    }
+    uint64_t get_time = dmTime::GetTime() - start;
+    ASSERT_EQ(0, memcmp(content, buffer, sizeof(content)));
+
+    printf("%u entries: put %.2f ms, flush %.2f ms, open %.2f ms, get %.2f us/entry\n",
+           entry_count, put_time / 1000.0, flush_time / 1000.0, open_time / 1000.0, get_time / (double) entry_count);
+
+    dmHttpCache::Close(cache);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -16,6 +16,12 @@
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include "../dlib/image.h"
+#include "../dlib/array.h"
+#include "../dlib/time.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STBI_WRITE_NO_STDIO
+#include "../stb/stb_image_write.h"
 
 #include "data/color_check_2x2.png.embed.h"
 #include "data/color_check_2x2_premult.png.embed.h"
@@ -276,6 +282,193 @@ TEST(dmImage, case2319)
     dmImage::Free(&image);
 }
 
+static void PremultiplyReference(const uint8_t* src, uint8_t* dst, uint32_t pixel_count)
+{
+    for (uint32_t i = 0; i < pixel_count * 4; i += 4)
+    {
+        uint32_t a = src[i + 3];
+        dst[i + 0] = (src[i + 0] * a + 255) >> 8;
+        dst[i + 1] = (src[i + 1] * a + 255) >> 8;
+        dst[i + 2] = (src[i + 2] * a + 255) >> 8;
+        dst[i + 3] = a;
+    }
+}
+
+TEST(dmImage, PremultiplyKernel)
+{
+    // Odd sizes to cover the scalar tail after the vector loop
+    const uint32_t sizes[] = {1, 3, 4, 7, 8, 17, 257};
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        uint32_t count = sizes[s];
+        uint8_t* pixels = (uint8_t*) malloc(count * 4);
+        uint8_t* expected = (uint8_t*) malloc(count * 4);
+        for (uint32_t i = 0; i < count * 4; ++i)
+            pixels[i] = (uint8_t) rand();
+        pixels[3] = 0;
+        pixels[count * 4 - 1] = 255;
+
+        PremultiplyReference(pixels, expected, count);
+        dmImage::Premultiply(pixels, count, 1);
+        ASSERT_EQ(0, memcmp(expected, pixels, count * 4));
+
+        free(pixels);
+        free(expected);
+    }
+}
+
+TEST(dmImage, ConvertRGBToRGBA)
+{
+    const uint32_t sizes[] = {1, 2, 5, 6, 9, 16, 255};
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        uint32_t count = sizes[s];
+        uint8_t* rgb = (uint8_t*) malloc(count * 3);
+        uint8_t* rgba = (uint8_t*) malloc(count * 4);
+        for (uint32_t i = 0; i < count * 3; ++i)
+            rgb[i] = (uint8_t) rand();
+
+        dmImage::ConvertRGBToRGBA(rgb, rgba, count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ASSERT_EQ(rgb[i * 3 + 0], rgba[i * 4 + 0]);
+            ASSERT_EQ(rgb[i * 3 + 1], rgba[i * 4 + 1]);
+            ASSERT_EQ(rgb[i * 3 + 2], rgba[i * 4 + 2]);
+            ASSERT_EQ(255, rgba[i * 4 + 3]);
+        }
+
+        free(rgb);
+        free(rgba);
+    }
+}
+
+TEST(dmImage, FlipVertical)
+{
+    const uint32_t width = 300;
+    const uint32_t height = 5;
+    uint8_t* pixels = (uint8_t*) malloc(width * height * 4);
+    for (uint32_t y = 0; y < height; ++y)
+        memset(pixels + y * width * 4, (int) y, width * 4);
+
+    dmImage::FlipVertical(pixels, width, height, dmImage::TYPE_RGBA);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        ASSERT_EQ(height - 1 - y, pixels[y * width * 4]);
+        ASSERT_EQ(height - 1 - y, pixels[y * width * 4 + width * 4 - 1]);
+    }
+    free(pixels);
+}
+
+TEST(dmImage, LoadInto)
+{
+    dmImage::LoadParams params;
+    params.m_Premultiply = true;
+    params.m_FlipVertically = true;
+
+    dmImage::Image info;
+    dmImage::Result r = dmImage::GetInfo(COLOR_CHECK_2X2_PREMULT_PNG, COLOR_CHECK_2X2_PREMULT_PNG_SIZE, params, &info);
+    ASSERT_EQ(dmImage::RESULT_OK, r);
+    ASSERT_EQ(2U, info.m_Width);
+    ASSERT_EQ(2U, info.m_Height);
+    ASSERT_EQ(dmImage::TYPE_RGBA, info.m_Type);
+
+    uint8_t buffer[2 * 2 * 4];
+    dmImage::Image image;
+    r = dmImage::LoadInto(COLOR_CHECK_2X2_PREMULT_PNG, COLOR_CHECK_2X2_PREMULT_PNG_SIZE, params, buffer, sizeof(buffer) - 1, &image);
+    ASSERT_EQ(dmImage::RESULT_BUFFER_TOO_SMALL, r);
+    r = dmImage::LoadInto(COLOR_CHECK_2X2_PREMULT_PNG, COLOR_CHECK_2X2_PREMULT_PNG_SIZE, params, buffer, sizeof(buffer), &image);
+    ASSERT_EQ(dmImage::RESULT_OK, r);
+    ASSERT_EQ((void*) buffer, image.m_Buffer);
+
+    dmImage::Image expected;
+    r = dmImage::Load(COLOR_CHECK_2X2_PREMULT_PNG, COLOR_CHECK_2X2_PREMULT_PNG_SIZE, true, &expected);
+    ASSERT_EQ(dmImage::RESULT_OK, r);
+    dmImage::FlipVertical((uint8_t*) expected.m_Buffer, 2, 2, dmImage::TYPE_RGBA);
+    ASSERT_EQ(0, memcmp(expected.m_Buffer, buffer, sizeof(buffer)));
+    dmImage::Free(&expected);
+
+    // RGB expanded to RGBA
+    params.m_Premultiply = false;
+    params.m_FlipVertically = false;
+    params.m_ExpandRGB = true;
+    r = dmImage::LoadInto(COLOR_CHECK_2X2_INDEXED_PNG, COLOR_CHECK_2X2_INDEXED_PNG_SIZE, params, buffer, sizeof(buffer), &image);
+    ASSERT_EQ(dmImage::RESULT_OK, r);
+    ASSERT_EQ(dmImage::TYPE_RGBA, image.m_Type);
+    const uint8_t rgba[] = {255, 0, 0, 255,  0, 255, 0, 255,  0, 0, 255, 255,  255, 255, 0, 255};
+    ASSERT_EQ(0, memcmp(rgba, buffer, sizeof(buffer)));
+}
+
+static void WriteToArray(void* context, void* data, int size)
+{
+    dmArray<uint8_t>* array = (dmArray<uint8_t>*) context;
+    if (array->Remaining() < (uint32_t) size)
+        array->OffsetCapacity(size + array->Capacity());
+    array->PushArray((const uint8_t*) data, size);
+}
+
+TEST(dmImage, Benchmark)
+{
+    const uint32_t sizes[][2] = {{1024, 1024}, {1920, 1080}, {2048, 2048}};
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        uint32_t width = sizes[s][0];
+        uint32_t height = sizes[s][1];
+        uint32_t size = width * height * 4;
+        uint8_t* pixels = (uint8_t*) malloc(size);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                uint8_t* p = pixels + (y * width + x) * 4;
+                p[0] = (uint8_t) x;
+                p[1] = (uint8_t) y;
+                p[2] = (uint8_t) (x ^ y);
+                p[3] = (uint8_t) (x + y + (rand() & 7));
+            }
+        }
+
+        dmArray<uint8_t> png;
+        dmArray<uint8_t> jpg;
+        ASSERT_NE(0, stbi_write_png_to_func(WriteToArray, &png, width, height, 4, pixels, width * 4));
+        ASSERT_NE(0, stbi_write_jpg_to_func(WriteToArray, &jpg, width, height, 3, pixels, 90));
+
+        uint64_t start = dmTime::GetTime();
+        dmImage::Premultiply(pixels, width, height);
+        uint64_t premult_time = dmTime::GetTime() - start;
+
+        dmImage::Image image;
+        start = dmTime::GetTime();
+        ASSERT_EQ(dmImage::RESULT_OK, dmImage::Load(png.Begin(), png.Size(), true, &image));
+        uint64_t png_time = dmTime::GetTime() - start;
+        dmImage::Free(&image);
+
+        dmImage::LoadParams params;
+        params.m_Premultiply = true;
+        params.m_FlipVertically = true;
+        start = dmTime::GetTime();
+        ASSERT_EQ(dmImage::RESULT_OK, dmImage::LoadInto(png.Begin(), png.Size(), params, pixels, size, &image));
+        uint64_t png_into_time = dmTime::GetTime() - start;
+
+        start = dmTime::GetTime();
+        ASSERT_EQ(dmImage::RESULT_OK, dmImage::Load(jpg.Begin(), jpg.Size(), false, &image));
+        uint64_t jpg_time = dmTime::GetTime() - start;
+        dmImage::Free(&image);
+
+        params.m_ExpandRGB = true;
+        start = dmTime::GetTime();
+        ASSERT_EQ(dmImage::RESULT_OK, dmImage::LoadInto(jpg.Begin(), jpg.Size(), params, pixels, size, &image));
+        uint64_t jpg_into_time = dmTime::GetTime() - start;
+
+        float mp = width * height / 1000000.0f;
+        printf("%ux%u: premultiply %.2f ms, png %.1f MP/s (into, flipped %.1f MP/s), jpg %.1f MP/s (into, rgba flipped %.1f MP/s)\n",
+               width, height, premult_time / 1000.0f,
+               mp / (png_time / 1000000.0f), mp / (png_into_time / 1000000.0f),
+               mp / (jpg_time / 1000000.0f), mp / (jpg_into_time / 1000000.0f));
+
+        free(pixels);
+    }
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
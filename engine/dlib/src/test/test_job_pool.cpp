@@ -0,0 +1,134 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+#include <dlib/atomic.h>
+#include <dlib/job_pool.h>
+#include <dlib/thread.h>
+
+struct SumJob
+{
+    const uint32_t* m_Values;
+    uint32_t        m_Count;
+    int32_atomic_t  m_Next;
+    int32_atomic_t  m_Sum;
+    int32_atomic_t  m_Calls;
+};
+
+static void Sum(void* context)
+{
+    SumJob* job = (SumJob*) context;
+    dmAtomicIncrement32(&job->m_Calls);
+    while (true)
+    {
+        uint32_t i = (uint32_t) dmAtomicIncrement32(&job->m_Next);
+        if (i >= job->m_Count)
+            break;
+        dmAtomicAdd32(&job->m_Sum, (int32_t) job->m_Values[i]);
+    }
+}
+
+static void RunSum(SumJob* job, const uint32_t* values, uint32_t count)
+{
+    job->m_Values = values;
+    job->m_Count = count;
+    job->m_Next = 0;
+    job->m_Sum = 0;
+    job->m_Calls = 0;
+    dmJobPool::Run(Sum, job);
+}
+
+TEST(dmJobPool, Run)
+{
+    const uint32_t count = 10000;
+    uint32_t* values = new uint32_t[count];
+    for (uint32_t i = 0; i < count; ++i)
+        values[i] = i;
+    const int32_t expected = (int32_t) (count * (count - 1) / 2);
+
+    // Runs on the calling thread only
+    SumJob job;
+    RunSum(&job, values, count);
+    ASSERT_EQ(expected, job.m_Sum);
+    ASSERT_EQ(1, job.m_Calls);
+
+    dmJobPool::Acquire();
+    dmJobPool::Acquire();
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        RunSum(&job, values, count);
+        ASSERT_EQ(expected, job.m_Sum);
+        ASSERT_LE(1, job.m_Calls);
+        ASSERT_GE((int32_t) dmJobPool::MAX_THREADS + 1, job.m_Calls);
+    }
+
+    // Still running after releasing one of the references
+    dmJobPool::Release();
+    RunSum(&job, values, count);
+    ASSERT_EQ(expected, job.m_Sum);
+    dmJobPool::Release();
+
+    RunSum(&job, values, count);
+    ASSERT_EQ(expected, job.m_Sum);
+    ASSERT_EQ(1, job.m_Calls);
+
+    delete[] values;
+}
+
+struct ConcurrentArg
+{
+    const uint32_t* m_Values;
+    uint32_t        m_Count;
+    int32_t         m_Sum;
+};
+
+static void RunSumThread(void* arg)
+{
+    ConcurrentArg* a = (ConcurrentArg*) arg;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        SumJob job;
+        RunSum(&job, a->m_Values, a->m_Count);
+        a->m_Sum = job.m_Sum;
+    }
+}
+
+TEST(dmJobPool, Concurrent)
+{
+    const uint32_t count = 10000;
+    uint32_t* values = new uint32_t[count];
+    for (uint32_t i = 0; i < count; ++i)
+        values[i] = 1;
+
+    // A job run while the pool is busy runs on its own thread
+    dmJobPool::Acquire();
+    ConcurrentArg a = {values, count, 0};
+    ConcurrentArg b = {values, count, 0};
+    dmThread::Thread t1 = dmThread::New(&RunSumThread, 0x80000, &a, "job_a");
+    dmThread::Thread t2 = dmThread::New(&RunSumThread, 0x80000, &b, "job_b");
+    dmThread::Join(t1);
+    dmThread::Join(t2);
+    dmJobPool::Release();
+
+    ASSERT_EQ((int32_t) count, a.m_Sum);
+    ASSERT_EQ((int32_t) count, b.m_Sum);
+
+    delete[] values;
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
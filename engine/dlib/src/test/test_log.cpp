@@ -22,11 +22,17 @@
 #include "../dlib/socket.h"
 #include "../dlib/thread.h"
 #include "../dlib/time.h"
+#include "../dlib/math.h"
 #include "../dlib/path.h"
 #include "../dlib/sys.h"
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
 TEST(dmLog, Init)
 {
     dmLogParams params;
@@ -151,6 +157,310 @@ TEST(dmLog, TestCapture)
     dmSetCustomLogCallback(0x0, 0x0);
 }
 
+TEST(dmLog, RepeatLimit)
+{
+    dmLogParams params;
+    params.m_MaxRepeatedMessages = 2;
+    dmLogInitialize(&params);
+
+    dmArray<char> log_output;
+    dmSetCustomLogCallback(TestLogCaptureCallback, &log_output);
+    for (int i = 0; i < 5; ++i)
+    {
+        dmLogWarning("Missing resource");
+    }
+    dmLogWarning("Another message");
+    dmSetCustomLogCallback(0x0, 0x0);
+    dmLogFinalize();
+
+    log_output.Push(0);
+
+    const char* ExpectedOutput =
+                "WARNING:DLIB: Missing resource\n"
+                "WARNING:DLIB: Missing resource\n"
+                "WARNING:DLIB: Previous message repeated 3 more times\n"
+                "WARNING:DLIB: Another message\n";
+
+    ASSERT_STREQ(ExpectedOutput, log_output.Begin());
+}
+
+// A run that is still being suppressed is summarized when the log is finalized
+TEST(dmLog, RepeatLimitFinalize)
+{
+    dmLogParams params;
+    params.m_MaxRepeatedMessages = 2;
+    dmLogInitialize(&params);
+
+    dmArray<char> log_output;
+    dmSetCustomLogCallback(TestLogCaptureCallback, &log_output);
+    for (int i = 0; i < 4; ++i)
+    {
+        dmLogWarning("Missing resource");
+    }
+    dmLogFinalize();
+    dmSetCustomLogCallback(0x0, 0x0);
+
+    log_output.Push(0);
+
+    const char* ExpectedOutput =
+                "WARNING:DLIB: Missing resource\n"
+                "WARNING:DLIB: Missing resource\n"
+                "WARNING:DLIB: Previous message repeated 2 more times\n";
+
+    ASSERT_STREQ(ExpectedOutput, log_output.Begin());
+}
+
+static void RepeatLogThread(void* arg)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        dmLogWarning("Missing resource %s", (const char*) arg);
+    }
+}
+
+// Runs are tracked per thread, and the pending summary is written when the thread exits
+TEST(dmLog, RepeatLimitThread)
+{
+    dmLogParams params;
+    dmLogInitialize(&params);
+    params.m_MaxRepeatedMessages = 1;
+    dmLogSetParams(&params);
+
+    dmArray<char> log_output;
+    dmSetCustomLogCallback(TestLogCaptureCallback, &log_output);
+    dmLogWarning("Missing resource main");
+    dmThread::Thread t = dmThread::New(RepeatLogThread, 0x80000, (void*) "t1", "t1");
+    dmThread::Join(t);
+    dmLogWarning("Missing resource main");
+    dmLogFinalize();
+    dmSetCustomLogCallback(0x0, 0x0);
+
+    log_output.Push(0);
+
+    const char* ExpectedOutput =
+                "WARNING:DLIB: Missing resource main\n"
+                "WARNING:DLIB: Missing resource t1\n"
+                "WARNING:DLIB: Previous message repeated 3 more times\n"
+                "WARNING:DLIB: Previous message repeated 1 more times\n";
+
+    ASSERT_STREQ(ExpectedOutput, log_output.Begin());
+}
+
+// Keep the console output of the tests below readable
+struct SilenceStderr
+{
+#if !defined(_WIN32)
+    int m_Fd;
+    SilenceStderr()
+    {
+        fflush(stderr);
+        m_Fd = dup(2);
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, 2);
+        close(null_fd);
+    }
+    ~SilenceStderr()
+    {
+        fflush(stderr);
+        dup2(m_Fd, 2);
+        close(m_Fd);
+    }
+#endif
+};
+
+static uint32_t CountLines(const char* path, const char* pattern)
+{
+    uint32_t count = 0;
+    char line[1024];
+    FILE* f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        if (strstr(line, pattern))
+            ++count;
+    }
+    fclose(f);
+    return count;
+}
+
+static const uint32_t ASYNC_THREAD_MESSAGES = 2000;
+
+static void AsyncLogThread(void* arg)
+{
+    for (uint32_t i = 0; i < ASYNC_THREAD_MESSAGES; ++i)
+    {
+        dmLogInfo("ASYNC_MESSAGE %s %u", (const char*) arg, i);
+    }
+}
+
+TEST(dmLog, AsyncBlock)
+{
+    if (!dLib::FeaturesSupported(DM_FEATURE_BIT_SOCKET_SERVER_TCP))
+    {
+        printf("Test disabled due to platform not supporting TCP");
+        return;
+    }
+
+    char path[DMPATH_MAX_PATH];
+    dmSys::GetLogPath(path, sizeof(path));
+    dmStrlCat(path, "log_async.txt", sizeof(path));
+
+    {
+        SilenceStderr silence;
+        dmLogParams params;
+        params.m_Async = true;
+        params.m_BufferFullPolicy = DM_LOG_BUFFER_FULL_BLOCK;
+        dmLogInitialize(&params);
+        dmSetLogFile(path);
+
+        uint32_t dropped = dmLogGetDroppedCount();
+        dmThread::Thread t1 = dmThread::New(AsyncLogThread, 0x80000, (void*) "t1", "t1");
+        dmThread::Thread t2 = dmThread::New(AsyncLogThread, 0x80000, (void*) "t2", "t2");
+        AsyncLogThread((void*) "main");
+        dmThread::Join(t1);
+        dmThread::Join(t2);
+        dmLogFinalize();
+        ASSERT_EQ(dropped, dmLogGetDroppedCount());
+    }
+
+    ASSERT_EQ(ASYNC_THREAD_MESSAGES * 3, CountLines(path, "ASYNC_MESSAGE"));
+    ASSERT_EQ(ASYNC_THREAD_MESSAGES, CountLines(path, "ASYNC_MESSAGE t1"));
+    dmSys::Unlink(path);
+}
+
+TEST(dmLog, AsyncDrop)
+{
+    if (!dLib::FeaturesSupported(DM_FEATURE_BIT_SOCKET_SERVER_TCP))
+    {
+        printf("Test disabled due to platform not supporting TCP");
+        return;
+    }
+
+    char path[DMPATH_MAX_PATH];
+    dmSys::GetLogPath(path, sizeof(path));
+    dmStrlCat(path, "log_async.txt", sizeof(path));
+
+    char padding[256];
+    memset(padding, 'x', sizeof(padding) - 1);
+    padding[sizeof(padding) - 1] = 0;
+
+    const uint32_t count = 5000;
+    uint32_t dropped;
+    {
+        SilenceStderr silence;
+        dmLogParams params;
+        params.m_Async = true;
+        params.m_BufferFullPolicy = DM_LOG_BUFFER_FULL_DROP;
+        dmLogInitialize(&params);
+        dmSetLogFile(path);
+
+        dropped = dmLogGetDroppedCount();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            dmLogInfo("ASYNC_DROP %u %s", i, padding);
+        }
+        dmLogFinalize();
+        dropped = dmLogGetDroppedCount() - dropped;
+    }
+
+    // Every message is either written or counted as dropped
+    ASSERT_EQ(count, CountLines(path, "ASYNC_DROP") + dropped);
+    if (dropped > 0)
+    {
+        ASSERT_LE(1U, CountLines(path, "log messages dropped"));
+    }
+    dmSys::Unlink(path);
+}
+
+static void AsyncReuseLogThread(void* arg)
+{
+    dmLogInfo("ASYNC_REUSE %u", (uint32_t) (uintptr_t) arg);
+}
+
+TEST(dmLog, AsyncThreadBufferReuse)
+{
+    if (!dLib::FeaturesSupported(DM_FEATURE_BIT_SOCKET_SERVER_TCP))
+    {
+        printf("Test disabled due to platform not supporting TCP");
+        return;
+    }
+
+    char path[DMPATH_MAX_PATH];
+    dmSys::GetLogPath(path, sizeof(path));
+    dmStrlCat(path, "log_async.txt", sizeof(path));
+
+    // More threads than there are thread buffers, one after another
+    const uint32_t count = 64;
+    uint32_t buffer_count;
+    {
+        SilenceStderr silence;
+        dmLogParams params;
+        params.m_Async = true;
+        params.m_BufferFullPolicy = DM_LOG_BUFFER_FULL_BLOCK;
+        dmLogInitialize(&params);
+        dmSetLogFile(path);
+
+        buffer_count = dmLogGetThreadBufferCount();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            dmThread::Thread t = dmThread::New(AsyncReuseLogThread, 0x80000, (void*) (uintptr_t) i, "reuse");
+            dmThread::Join(t);
+        }
+        buffer_count = dmLogGetThreadBufferCount() - buffer_count;
+        dmLogFinalize();
+    }
+
+    ASSERT_GE(1U, buffer_count);
+    ASSERT_EQ(count, CountLines(path, "ASYNC_REUSE"));
+    dmSys::Unlink(path);
+}
+
+static double BenchLog(bool async, dmLogBufferFullPolicy policy, bool log_file, uint32_t count)
+{
+    char path[DMPATH_MAX_PATH];
+    dmSys::GetLogPath(path, sizeof(path));
+    dmStrlCat(path, "log_bench.txt", sizeof(path));
+
+    SilenceStderr silence;
+    dmLogParams params;
+    params.m_Async = async;
+    params.m_BufferFullPolicy = policy;
+    dmLogInitialize(&params);
+    if (log_file)
+        dmSetLogFile(path);
+
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        dmLogWarning("Resource '/main/missing_%u.texturec' not found", i);
+    }
+    uint64_t end = dmTime::GetTime();
+
+    dmLogFinalize();
+    if (log_file)
+        dmSys::Unlink(path);
+    return count * 1000000.0 / (double) dmMath::Max((uint64_t) 1, end - start);
+}
+
+TEST(dmLog, Bench)
+{
+    if (!dLib::FeaturesSupported(DM_FEATURE_BIT_SOCKET_SERVER_TCP))
+    {
+        printf("Test disabled due to platform not supporting TCP");
+        return;
+    }
+
+    const uint32_t count = 20000;
+    // With the block policy the async numbers are bound by the log thread once the buffer is full,
+    // with the drop policy they show the cost for the logging thread
+    printf("sync:                    %10.0f lines/s\n", BenchLog(false, DM_LOG_BUFFER_FULL_BLOCK, false, count));
+    printf("sync, log file:          %10.0f lines/s\n", BenchLog(false, DM_LOG_BUFFER_FULL_BLOCK, true, count));
+    printf("async block:             %10.0f lines/s\n", BenchLog(true, DM_LOG_BUFFER_FULL_BLOCK, false, count));
+    printf("async block, log file:   %10.0f lines/s\n", BenchLog(true, DM_LOG_BUFFER_FULL_BLOCK, true, count));
+    printf("async drop, log file:    %10.0f lines/s\n", BenchLog(true, DM_LOG_BUFFER_FULL_DROP, true, count));
+}
+
 int main(int argc, char **argv)
 {
     dmSocket::Initialize();
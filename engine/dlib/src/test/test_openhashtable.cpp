@@ -0,0 +1,323 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <map>
+#include <vector>
+
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+
+#include "dlib/hashtable.h"
+#include "dlib/openhashtable.h"
+#include "dlib/time.h"
+
+TEST(dmOpenHashTable, EmptyConstructor)
+{
+    dmOpenHashTable32<int> ht;
+
+    EXPECT_EQ(0U, ht.Size());
+    EXPECT_EQ(0U, ht.Capacity());
+    EXPECT_TRUE(ht.Full());
+    EXPECT_TRUE(ht.Empty());
+    EXPECT_EQ((int*) 0, ht.Get(1));
+}
+
+TEST(dmOpenHashTable, SimplePut)
+{
+    dmOpenHashTable<uint32_t, uint32_t> ht;
+    ht.SetCapacity(10);
+    ht.Put(12, 23);
+
+    uint32_t* val = ht.Get(12);
+    ASSERT_NE((uintptr_t) 0, (uintptr_t) val);
+    EXPECT_EQ((uint32_t) 23, *val);
+
+    // Overwrite doesn't add a new entry, even when full
+    ht.SetCapacity(10, 10);
+    for (uint32_t i = 0; i < 9; ++i)
+        ht.Put(100 + i, i);
+    ASSERT_TRUE(ht.Full());
+    ht.Put(12, 24);
+    EXPECT_EQ(10U, ht.Size());
+    EXPECT_EQ((uint32_t) 24, *ht.Get(12));
+}
+
+TEST(dmOpenHashTable, SimpleErase)
+{
+    dmOpenHashTable<uint32_t, uint32_t> ht;
+    ht.SetCapacity(10);
+    ht.Put(1, 10);
+    ht.Put(2, 20);
+    ht.Erase(1);
+    ht.Verify();
+
+    EXPECT_EQ((uint32_t*) 0, ht.Get(1));
+    ASSERT_NE((uint32_t*) 0, ht.Get(2));
+    EXPECT_EQ(20U, *ht.Get(2));
+    EXPECT_EQ(1U, ht.Size());
+}
+
+TEST(dmOpenHashTable, Exhaustive)
+{
+    const int N = 100;
+    for (int count = 1; count < N; count += 7)
+    {
+        std::map<uint64_t, uint32_t> map;
+        dmOpenHashTable64<uint32_t> ht;
+        ht.SetCapacity(count);
+
+        const uint32_t grow_shrink_iter_count = 20;
+        for (uint32_t grow_shrink_iter = 0; grow_shrink_iter < grow_shrink_iter_count; ++grow_shrink_iter)
+        {
+            uint32_t target_size = uint32_t(rand() % (count + 1));
+            if (grow_shrink_iter == grow_shrink_iter_count/2)
+            {
+                // Fill completely
+                target_size = count;
+            }
+
+            while (map.size() != target_size)
+            {
+                if (map.size() < target_size)
+                {
+                    uint64_t key = rand() & 0x3ff; // keys up to 1023...
+                    uint32_t val = rand();
+                    map[key] = val;
+                    ht.Put(key, val);
+                }
+                else
+                {
+                    uint64_t key = map.begin()->first;
+                    map.erase(map.begin());
+                    ht.Erase(key);
+                }
+                ASSERT_EQ(map.size(), ht.Size());
+            }
+            ht.Verify();
+
+            for (uint64_t key = 0; key < 0x400; ++key)
+            {
+                std::map<uint64_t, uint32_t>::iterator iter = map.find(key);
+                if (iter == map.end())
+                {
+                    ASSERT_EQ((uint32_t*) 0, ht.Get(key));
+                }
+                else
+                {
+                    ASSERT_NE((uint32_t*) 0, ht.Get(key));
+                    ASSERT_EQ(iter->second, *ht.Get(key));
+                }
+            }
+        }
+    }
+}
+
+TEST(dmOpenHashTable, Tombstones)
+{
+    // Churn through many distinct keys at full capacity so the table has to clean up deleted slots
+    dmOpenHashTable<uint32_t, uint32_t> ht;
+    ht.SetCapacity(14);
+    for (uint32_t i = 0; i < 14; ++i)
+        ht.Put(i, i);
+
+    for (uint32_t i = 14; i < 10000; ++i)
+    {
+        ht.Erase(i - 14);
+        ht.Put(i, i);
+        ASSERT_EQ(14U, ht.Size());
+        ASSERT_EQ((uint32_t*) 0, ht.Get(i - 14));
+    }
+    ht.Verify();
+
+    for (uint32_t i = 10000 - 14; i < 10000; ++i)
+    {
+        ASSERT_NE((uint32_t*) 0, ht.Get(i));
+        ASSERT_EQ(i, *ht.Get(i));
+    }
+}
+
+static void IterateCallback(int* context, const uint32_t* key, int* value)
+{
+    *context += *value;
+}
+
+TEST(dmOpenHashTable, Iterate)
+{
+    for (uint32_t capacity = 1; capacity < 100; ++capacity)
+    {
+        dmOpenHashTable<uint32_t, int> ht;
+        ht.SetCapacity(capacity);
+
+        int sum = 0;
+        for (uint32_t i = 0; i < capacity; ++i)
+        {
+            int x = rand() & 0xffff;
+            ht.Put(i, x);
+            sum += x;
+        }
+        int context = 0;
+        ht.Iterate(IterateCallback, &context);
+        ASSERT_EQ(sum, context);
+    }
+}
+
+TEST(dmOpenHashTable, Grow)
+{
+    dmOpenHashTable<uint32_t, int> ht;
+    std::map<uint32_t, int> map;
+
+    for (uint32_t iter = 0; iter < 2000; ++iter)
+    {
+        if (ht.Full())
+        {
+            ht.SetCapacity(ht.Capacity() + (rand() % 4) + 1);
+        }
+        uint32_t key = rand();
+        int val = rand();
+        ht.Put(key, val);
+        map[key] = val;
+    }
+    ht.Verify();
+
+    ASSERT_EQ(map.size(), ht.Size());
+    for (std::map<uint32_t, int>::iterator iter = map.begin(); iter != map.end(); ++iter)
+    {
+        ASSERT_EQ(iter->second, *ht.Get(iter->first));
+    }
+}
+
+static uint32_t g_ClearCount;
+
+static void ClearCallback(int* context, const uint32_t* key, int* value)
+{
+    g_ClearCount++;
+}
+
+TEST(dmOpenHashTable, Clear)
+{
+    dmOpenHashTable<uint32_t, int> ht;
+    ht.SetCapacity(40);
+    for (uint32_t i = 0; i < 40; ++i)
+        ht.Put(i * 7, i);
+
+    ht.Clear();
+    ht.Verify();
+    EXPECT_TRUE(ht.Empty());
+    EXPECT_EQ((int*) 0, ht.Get(7));
+
+    g_ClearCount = 0;
+    ht.Iterate(ClearCallback, (int*) 0);
+    ASSERT_EQ(0U, g_ClearCount);
+}
+
+TEST(dmOpenHashTable, Swap)
+{
+    dmOpenHashTable<int, int> h1;
+    dmOpenHashTable<int, int> h2;
+    h1.SetCapacity(10);
+    h2.SetCapacity(10);
+
+    h1.Put(1, 10);
+    h1.Put(2, 20);
+
+    h2.Put(10, 100);
+    h2.Put(20, 200);
+
+    h1.Swap(h2);
+
+    ASSERT_EQ(10, *h2.Get(1));
+    ASSERT_EQ(20, *h2.Get(2));
+    ASSERT_EQ(100, *h1.Get(10));
+    ASSERT_EQ(200, *h1.Get(20));
+}
+
+// Benchmark against dmHashTable, with the table sized the way call sites usually size it
+// (about 2/3 buckets per entry for the chained table) and filled to different load factors
+template <typename TABLE>
+static void BenchTable(const char* name, uint32_t capacity, uint32_t count, const std::vector<uint64_t>& keys, const std::vector<uint64_t>& misses)
+{
+    TABLE ht;
+    ht.SetCapacity((capacity * 2) / 3, capacity);
+
+    const uint32_t rounds = 20;
+    uint64_t put_time = 0, get_time = 0, miss_time = 0, erase_time = 0;
+    uint64_t sum = 0;
+    for (uint32_t r = 0; r < rounds; ++r)
+    {
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t i = 0; i < count; ++i)
+            ht.Put(keys[i], (uint32_t)i);
+        uint64_t end = dmTime::GetTime();
+        put_time += end - start;
+
+        start = dmTime::GetTime();
+        for (uint32_t i = 0; i < count; ++i)
+            sum += *ht.Get(keys[i]);
+        end = dmTime::GetTime();
+        get_time += end - start;
+
+        start = dmTime::GetTime();
+        for (uint32_t i = 0; i < count; ++i)
+            sum += ht.Get(misses[i]) != 0;
+        end = dmTime::GetTime();
+        miss_time += end - start;
+
+        start = dmTime::GetTime();
+        for (uint32_t i = 0; i < count; ++i)
+            ht.Erase(keys[i]);
+        end = dmTime::GetTime();
+        erase_time += end - start;
+    }
+
+    double n = (double)count * rounds;
+    printf("%-16s load %.2f: put %6.2f ns  get %6.2f ns  miss %6.2f ns  erase %6.2f ns  (%llu)\n", name, count / (double)capacity,
+            put_time * 1000.0 / n, get_time * 1000.0 / n, miss_time * 1000.0 / n, erase_time * 1000.0 / n, (unsigned long long)sum);
+}
+
+TEST(dmOpenHashTable, Bench)
+{
+    const uint32_t capacity = 32768;
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> misses;
+    std::map<uint64_t, bool> used;
+    while (keys.size() < capacity)
+    {
+        uint64_t key = ((uint64_t)rand() << 32) ^ ((uint64_t)rand() << 16) ^ (uint64_t)rand();
+        if (used.find(key) != used.end())
+            continue;
+        used[key] = true;
+        keys.push_back(key);
+    }
+    while (misses.size() < capacity)
+    {
+        uint64_t key = ((uint64_t)rand() << 32) ^ ((uint64_t)rand() << 16) ^ (uint64_t)rand();
+        if (used.find(key) == used.end())
+            misses.push_back(key);
+    }
+
+    const float load_factors[] = {0.25f, 0.5f, 0.75f, 1.0f};
+    for (uint32_t i = 0; i < sizeof(load_factors) / sizeof(load_factors[0]); ++i)
+    {
+        uint32_t count = (uint32_t)(capacity * load_factors[i]);
+        BenchTable<dmHashTable64<uint32_t> >("dmHashTable", capacity, count, keys, misses);
+        BenchTable<dmOpenHashTable64<uint32_t> >("dmOpenHashTable", capacity, count, keys, misses);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
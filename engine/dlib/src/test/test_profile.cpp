@@ -388,6 +388,114 @@ TEST(dmProfile, ThreadProfile)
     dmProfile::Finalize();
 }
 
+static int32_atomic_t g_ProfileThreadsDone = 0;
+
+void ProfileThreadDone(void* arg)
+{
+    ProfileThread(arg);
+    dmAtomicIncrement32(&g_ProfileThreadsDone);
+}
+
+// Swap frames while other threads are recording, no samples should be lost or duplicated
+TEST(dmProfile, ThreadProfileConcurrentBegin)
+{
+    dmProfile::Initialize(128, 1024 * 1024, 16);
+    g_ProfileThreadsDone = 0;
+
+    dmProfile::HProfile profile = dmProfile::Begin();
+    dmProfile::Release(profile);
+    dmThread::Thread t1 = dmThread::New(ProfileThreadDone, 0xf0000, 0, "p1");
+    dmThread::Thread t2 = dmThread::New(ProfileThreadDone, 0xf0000, 0, "p2");
+
+    std::vector<dmProfile::Sample> samples;
+    bool done = false;
+    while (!done)
+    {
+        done = dmAtomicAdd32(&g_ProfileThreadsDone, 0) == 2;
+        profile = dmProfile::Begin();
+        dmProfile::IterateSamples(profile, &samples, false, &ProfileSampleCallback);
+        dmProfile::Release(profile);
+    }
+    dmThread::Join(t1);
+    dmThread::Join(t2);
+
+    ASSERT_EQ(20000U * 2U, samples.size());
+
+    dmProfile::Finalize();
+}
+
+// A scope that is open when the profile is swapped is merged into the profile where it ends
+TEST(dmProfile, OpenScopeAtBegin)
+{
+    dmProfile::Initialize(128, 1024, 16);
+
+    dmProfile::HProfile profile = dmProfile::Begin();
+    dmProfile::Release(profile);
+
+    std::vector<dmProfile::Sample> samples;
+    {
+        DM_PROFILE(X, "open")
+        {
+            DM_PROFILE(X, "closed")
+        }
+        dmTime::BusyWait(10000);
+
+        profile = dmProfile::Begin();
+        dmProfile::IterateSamples(profile, &samples, false, &ProfileSampleCallback);
+        dmProfile::Release(profile);
+
+        ASSERT_EQ(1U, samples.size());
+        ASSERT_STREQ("closed", samples[0].m_Name);
+        samples.clear();
+        dmTime::BusyWait(10000);
+    }
+
+    profile = dmProfile::Begin();
+    dmProfile::IterateSamples(profile, &samples, false, &ProfileSampleCallback);
+    dmProfile::Release(profile);
+
+    ASSERT_EQ(1U, samples.size());
+    ASSERT_STREQ("open", samples[0].m_Name);
+    ASSERT_LE(20000 / 1000000.0, samples[0].m_Elapsed / (double)dmProfile::GetTicksPerSecond());
+
+    dmProfile::Finalize();
+}
+
+void ProfileThreadShort(void* arg)
+{
+    for (int i = 0; i < 1000; ++i)
+    {
+        DM_PROFILE(X, "a")
+    }
+}
+
+// The buffer of an exited thread is reused by the next thread, along with its thread id
+TEST(dmProfile, ThreadBufferReuse)
+{
+    dmProfile::Initialize(128, 1024 * 1024, 16);
+
+    dmProfile::HProfile profile = dmProfile::Begin();
+    dmProfile::Release(profile);
+    for (int i = 0; i < 8; ++i)
+    {
+        dmThread::Thread t = dmThread::New(ProfileThreadShort, 0xf0000, 0, "p");
+        dmThread::Join(t);
+    }
+
+    std::vector<dmProfile::Sample> samples;
+    profile = dmProfile::Begin();
+    dmProfile::IterateSamples(profile, &samples, false, &ProfileSampleCallback);
+    dmProfile::Release(profile);
+
+    ASSERT_EQ(1000U * 8U, samples.size());
+    for (uint32_t i = 1; i < samples.size(); ++i)
+    {
+        ASSERT_EQ(samples[0].m_ThreadId, samples[i].m_ThreadId);
+    }
+
+    dmProfile::Finalize();
+}
+
 TEST(dmProfile, DynamicScope)
 {
     const char* FUNCTION_NAMES[] = {
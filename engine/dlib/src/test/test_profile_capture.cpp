@@ -0,0 +1,224 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+#include "dlib/profile.h"
+#include "dlib/profile_capture.h"
+#include "dlib/sys.h"
+#include "dlib/time.h"
+
+#if !defined(_WIN32)
+
+static const char* CAPTURE_PATH = "tmp/profile_capture.dmpc";
+
+struct CapturedFrame
+{
+    uint32_t                 m_FrameIndex;
+    uint32_t                 m_FrameTicks;
+    std::vector<std::string> m_SampleNames;
+    std::map<std::string, int32_t> m_Counters;
+};
+
+struct CaptureFile
+{
+    std::map<uint32_t, std::string> m_Strings;
+    std::vector<CapturedFrame>      m_Frames;
+    uint32_t                        m_CapturedCount;
+    uint32_t                        m_DroppedCount;
+    bool                            m_HasEnd;
+};
+
+static uint32_t ReadU32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static bool ReadCapture(const char* path, CaptureFile* out)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+        return false;
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        data.insert(data.end(), buf, buf + n);
+    fclose(f);
+
+    out->m_HasEnd = false;
+    if (data.size() < 16 || memcmp(&data[0], "DMPC", 4) != 0 || ReadU32(&data[4]) != dmProfile::CAPTURE_VERSION)
+        return false;
+
+    size_t offset = 16;
+    while (offset + 8 <= data.size())
+    {
+        const uint8_t* tag = &data[offset];
+        uint32_t size = ReadU32(&data[offset + 4]);
+        const uint8_t* p = &data[offset + 8];
+        if (offset + 8 + size > data.size())
+            return false;
+
+        if (memcmp(tag, "STRG", 4) == 0)
+        {
+            out->m_Strings[ReadU32(p)] = std::string((const char*)p + 4, size - 4);
+        }
+        else if (memcmp(tag, "FRAM", 4) == 0)
+        {
+            CapturedFrame frame;
+            frame.m_FrameIndex = ReadU32(p);
+            frame.m_FrameTicks = ReadU32(p + 12);
+            uint32_t sample_count = ReadU32(p + 16);
+            uint32_t scope_count = ReadU32(p + 20);
+            uint32_t counter_count = ReadU32(p + 24);
+            if (28 + sample_count * 20 + scope_count * 12 + counter_count * 8 != size)
+                return false;
+
+            const uint8_t* samples = p + 28;
+            for (uint32_t i = 0; i < sample_count; ++i)
+            {
+                uint32_t name = ReadU32(samples + i * 20);
+                if (out->m_Strings.find(name) == out->m_Strings.end())
+                    return false;
+                frame.m_SampleNames.push_back(out->m_Strings[name]);
+            }
+            const uint8_t* counters = samples + sample_count * 20 + scope_count * 12;
+            for (uint32_t i = 0; i < counter_count; ++i)
+            {
+                frame.m_Counters[out->m_Strings[ReadU32(counters + i * 8)]] = (int32_t)ReadU32(counters + i * 8 + 4);
+            }
+            out->m_Frames.push_back(frame);
+        }
+        else if (memcmp(tag, "ENDC", 4) == 0)
+        {
+            out->m_CapturedCount = ReadU32(p);
+            out->m_DroppedCount = ReadU32(p + 4);
+            out->m_HasEnd = true;
+        }
+        offset += 8 + size;
+    }
+    return offset == data.size();
+}
+
+TEST(dmProfileCapture, Stream)
+{
+    dmSys::Mkdir("tmp", 0755);
+    dmProfile::Initialize(128, 1024, 16);
+
+    dmProfile::CaptureParams params;
+    params.m_Path = CAPTURE_PATH;
+    params.m_MaxPendingFrames = 1024;
+    dmProfile::HCapture capture = dmProfile::NewCapture(&params);
+    ASSERT_NE((dmProfile::HCapture)0, capture);
+
+    dmProfile::Release(dmProfile::Begin());
+
+    const uint32_t frame_count = 100;
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        {
+            DM_PROFILE(Capture, "Frame")
+            {
+                DM_PROFILE(Capture, "Update")
+            }
+            DM_COUNTER("Frames", 1);
+        }
+        dmProfile::HProfile profile = dmProfile::Begin();
+        dmProfile::CaptureFrame(capture, profile);
+        dmProfile::Release(profile);
+    }
+
+    ASSERT_EQ(frame_count, dmProfile::GetCapturedFrameCount(capture));
+    dmProfile::DeleteCapture(capture);
+    dmProfile::Finalize();
+
+    CaptureFile file;
+    ASSERT_TRUE(ReadCapture(CAPTURE_PATH, &file));
+    ASSERT_TRUE(file.m_HasEnd);
+    ASSERT_EQ(frame_count, file.m_CapturedCount);
+    ASSERT_EQ(0U, file.m_DroppedCount);
+    ASSERT_EQ(frame_count, (uint32_t)file.m_Frames.size());
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        CapturedFrame& frame = file.m_Frames[i];
+        ASSERT_EQ(i, frame.m_FrameIndex);
+        ASSERT_EQ(2U, (uint32_t)frame.m_SampleNames.size());
+        ASSERT_EQ(1, frame.m_Counters["Frames"]);
+    }
+    dmSys::Unlink(CAPTURE_PATH);
+}
+
+TEST(dmProfileCapture, WorstFrames)
+{
+    dmSys::Mkdir("tmp", 0755);
+    dmProfile::Initialize(128, 1024, 16);
+
+    dmProfile::CaptureParams params;
+    params.m_Path = CAPTURE_PATH;
+    params.m_WorstFrameCount = 3;
+    dmProfile::HCapture capture = dmProfile::NewCapture(&params);
+    ASSERT_NE((dmProfile::HCapture)0, capture);
+
+    dmProfile::Release(dmProfile::Begin());
+
+    // Frames 2, 5 and 7 are slow
+    const uint32_t frame_count = 10;
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        {
+            DM_PROFILE(Capture, "Frame")
+            bool slow = i == 2 || i == 5 || i == 7;
+            dmTime::BusyWait(slow ? 20000 : 1000);
+        }
+        dmProfile::HProfile profile = dmProfile::Begin();
+        dmProfile::CaptureFrame(capture, profile);
+        dmProfile::Release(profile);
+    }
+
+    ASSERT_EQ(3U, dmProfile::GetCapturedFrameCount(capture));
+    dmProfile::DeleteCapture(capture);
+    dmProfile::Finalize();
+
+    CaptureFile file;
+    ASSERT_TRUE(ReadCapture(CAPTURE_PATH, &file));
+    ASSERT_TRUE(file.m_HasEnd);
+    ASSERT_EQ(3U, (uint32_t)file.m_Frames.size());
+    ASSERT_EQ(2U, file.m_Frames[0].m_FrameIndex);
+    ASSERT_EQ(5U, file.m_Frames[1].m_FrameIndex);
+    ASSERT_EQ(7U, file.m_Frames[2].m_FrameIndex);
+    ASSERT_EQ("Frame", file.m_Frames[0].m_SampleNames[0]);
+    dmSys::Unlink(CAPTURE_PATH);
+}
+
+TEST(dmProfileCapture, InvalidPath)
+{
+    dmProfile::CaptureParams params;
+    params.m_Path = "tmp/no_such_dir/profile_capture.dmpc";
+    ASSERT_EQ((dmProfile::HCapture)0, dmProfile::NewCapture(&params));
+}
+
+#else
+#endif
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
@@ -108,6 +108,27 @@ namespace dmEngine
 #define SYSTEM_SOCKET_NAME "@system"
 
     dmEngineService::HEngineService g_EngineService = 0;
+    // Number of profile captures opened by this process, the engine is recreated on reboot
+    static uint32_t g_ProfileCaptureCount = 0;
+
+    // The first capture uses the path as is. Captures after a reboot get a ".<n>" suffix before
+    // the extension, so that they don't overwrite the capture of the previous session
+    static void GetProfileCapturePath(const char* path, uint32_t index, char* buffer, uint32_t buffer_size)
+    {
+        if (index == 0)
+        {
+            dmStrlCpy(buffer, path, buffer_size);
+            return;
+        }
+        const char* ext = strrchr(path, '.');
+        const char* sep = strrchr(path, '/');
+        const char* backslash = strrchr(path, '\\');
+        if (backslash != 0 && (sep == 0 || backslash > sep))
+            sep = backslash;
+        if (ext == 0 || (sep != 0 && ext < sep))
+            ext = path + strlen(path);
+        dmSnPrintf(buffer, buffer_size, "%.*s.%u%s", (int)(ext - path), path, index, ext);
+    }
 
     static void OnWindowResize(void* user_data, uint32_t width, uint32_t height)
     {
@@ -212,6 +233,7 @@ namespace dmEngine
     , m_DisplayProfiles(0x0)
     , m_RenderScriptPrototype(0x0)
     , m_Stats()
+    , m_ProfileCapture(0x0)
     , m_WasIconified(true)
     , m_QuitOnEsc(false)
     , m_ConnectionAppMode(false)
@@ -254,6 +276,9 @@ namespace dmEngine
 
         dmLiveUpdate::Finalize();
 
+        if (engine->m_ProfileCapture)
+            dmProfile::DeleteCapture(engine->m_ProfileCapture);
+
         // Reregister the types before the rest of the contexts are deleted
         if (engine->m_Factory) {
             dmResource::DeregisterTypes(engine->m_Factory, &engine->m_ResourceTypeContexts);
@@ -314,6 +339,12 @@ namespace dmEngine
             }
         }
 
+        if (engine->m_TextureContext.m_Streamer) {
+            // Streamed textures still alive are released with the factory below
+            dmGameSystem::DeleteTextureStreamer(engine->m_TextureContext.m_Streamer);
+            engine->m_TextureContext.m_Streamer = 0;
+        }
+
         if (engine->m_Factory) {
             dmResource::DeleteFactory(engine->m_Factory);
         }
@@ -602,6 +633,8 @@ namespace dmEngine
         const char validation_layers_support_arg[] = "--use-validation-layers";
         const char verbose_long[] = "--verbose";
         const char verbose_short[] = "-v";
+        const char profile_capture_arg[] = "--profile-capture=";
+        const char* profile_capture_path = dmConfigFile::GetString(engine->m_Config, "profiler.capture_file", 0);
         for (int i = 0; i < argc; ++i)
         {
             const char* arg = argv[i];
@@ -629,6 +662,24 @@ namespace dmEngine
             {
                 dmLogSetlevel(DM_LOG_SEVERITY_DEBUG);
             }
+            else if (strncmp(profile_capture_arg, arg, sizeof(profile_capture_arg)-1) == 0)
+            {
+                profile_capture_path = arg + sizeof(profile_capture_arg)-1;
+            }
+        }
+
+        if (profile_capture_path && profile_capture_path[0])
+        {
+            char capture_path[DMPATH_MAX_PATH];
+            GetProfileCapturePath(profile_capture_path, g_ProfileCaptureCount++, capture_path, sizeof(capture_path));
+            if (strcmp(capture_path, profile_capture_path) != 0)
+            {
+                dmLogInfo("Writing profile capture to '%s'", capture_path);
+            }
+            dmProfile::CaptureParams capture_params;
+            capture_params.m_Path = capture_path;
+            capture_params.m_WorstFrameCount = dmConfigFile::GetInt(engine->m_Config, "profiler.capture_worst_frames", 0);
+            engine->m_ProfileCapture = dmProfile::NewCapture(&capture_params);
         }
 
         dmBuffer::NewContext();
@@ -681,6 +732,11 @@ namespace dmEngine
             }
         }
 
+        dmLogParams log_params;
+        log_params.m_Async = dmConfigFile::GetInt(engine->m_Config, "engine.log_async", 0) != 0;
+        log_params.m_MaxRepeatedMessages = (uint32_t)dmMath::Max(0, dmConfigFile::GetInt(engine->m_Config, "engine.log_max_repeated_messages", 0));
+        dmLogSetParams(&log_params);
+
         const char* update_order = dmConfigFile::GetString(engine->m_Config, "gameobject.update_order", 0);
 
         // This scope is mainly here to make sure the "Main" scope is created first
@@ -1005,23 +1061,38 @@ namespace dmEngine
             dmPhysics::SetDebugCallbacks2D(engine->m_PhysicsContext.m_Context2D, debug_callbacks);
 #endif
 
+        engine->m_TextureContext.m_GraphicsContext = engine->m_GraphicsContext;
+        if (dmConfigFile::GetInt(engine->m_Config, "graphics.texture_streaming", 0))
+        {
+            uint64_t budget = (uint64_t) dmConfigFile::GetInt(engine->m_Config, "graphics.texture_streaming_budget", 128) * 1024 * 1024;
+            engine->m_TextureContext.m_Streamer = dmGameSystem::NewTextureStreamer(engine->m_Factory, engine->m_GraphicsContext, budget);
+        }
+        engine->m_GuiContext.m_TextureStreamer = engine->m_TextureContext.m_Streamer;
+        engine->m_ParticleFXContext.m_TextureStreamer = engine->m_TextureContext.m_Streamer;
+
         engine->m_SpriteContext.m_RenderContext = engine->m_RenderContext;
+        engine->m_SpriteContext.m_TextureStreamer = engine->m_TextureContext.m_Streamer;
         engine->m_SpriteContext.m_MaxSpriteCount = dmConfigFile::GetInt(engine->m_Config, "sprite.max_count", 128);
         engine->m_SpriteContext.m_Subpixels = dmConfigFile::GetInt(engine->m_Config, "sprite.subpixels", 1);
 
         engine->m_ModelContext.m_RenderContext = engine->m_RenderContext;
         engine->m_ModelContext.m_Factory = engine->m_Factory;
+        engine->m_ModelContext.m_TextureStreamer = engine->m_TextureContext.m_Streamer;
         engine->m_ModelContext.m_MaxModelCount = max_model_count;
+        engine->m_ModelContext.m_PoseCache = dmConfigFile::GetInt(engine->m_Config, "model.pose_cache", 0) != 0;
 
         engine->m_MeshContext.m_RenderContext = engine->m_RenderContext;
         engine->m_MeshContext.m_Factory       = engine->m_Factory;
+        engine->m_MeshContext.m_TextureStreamer = engine->m_TextureContext.m_Streamer;
         engine->m_MeshContext.m_MaxMeshCount = dmConfigFile::GetInt(engine->m_Config, "mesh.max_count", 128);
 
         engine->m_LabelContext.m_RenderContext      = engine->m_RenderContext;
+        engine->m_LabelContext.m_Factory            = engine->m_Factory;
         engine->m_LabelContext.m_MaxLabelCount      = dmConfigFile::GetInt(engine->m_Config, "label.max_count", 64);
         engine->m_LabelContext.m_Subpixels          = dmConfigFile::GetInt(engine->m_Config, "label.subpixels", 1);
 
         engine->m_TilemapContext.m_RenderContext    = engine->m_RenderContext;
+        engine->m_TilemapContext.m_TextureStreamer  = engine->m_TextureContext.m_Streamer;
         engine->m_TilemapContext.m_MaxTilemapCount  = dmConfigFile::GetInt(engine->m_Config, "tilemap.max_count", 16);
         engine->m_TilemapContext.m_MaxTileCount     = dmConfigFile::GetInt(engine->m_Config, "tilemap.max_tile_count", 2048);
 
@@ -1051,6 +1122,7 @@ namespace dmEngine
         component_create_ctx.m_Contexts.SetCapacity(3, 8);
         component_create_ctx.m_Contexts.Put(dmHashString64("graphics"), engine->m_GraphicsContext);
         component_create_ctx.m_Contexts.Put(dmHashString64("render"), engine->m_RenderContext);
+        component_create_ctx.m_Contexts.Put(dmHashString64("texture_streamer"), engine->m_TextureContext.m_Streamer);
 
         dmResource::Result fact_result;
         dmGameSystem::ScriptLibContext script_lib_context;
@@ -1067,7 +1139,7 @@ namespace dmEngine
         if (fact_result != dmResource::RESULT_OK)
             goto bail;
 
-        fact_result = dmGameSystem::RegisterResourceTypes(engine->m_Factory, engine->m_RenderContext, &engine->m_GuiContext, engine->m_InputContext, &engine->m_PhysicsContext);
+        fact_result = dmGameSystem::RegisterResourceTypes(engine->m_Factory, engine->m_RenderContext, &engine->m_GuiContext, engine->m_InputContext, &engine->m_PhysicsContext, &engine->m_TextureContext);
         if (fact_result != dmResource::RESULT_OK)
             goto bail;
 
@@ -1435,6 +1507,10 @@ bail:
             }
 
             dmProfile::HProfile profile = dmProfile::Begin();
+            if (engine->m_ProfileCapture)
+            {
+                dmProfile::CaptureFrame(engine->m_ProfileCapture, profile);
+            }
             {
                 DM_PROFILE(Engine, "Frame");
 
@@ -1563,6 +1639,10 @@ bail:
 
                     dmRender::ClearRenderObjects(engine->m_RenderContext);
 
+                    if (engine->m_TextureContext.m_Streamer)
+                    {
+                        dmGameSystem::UpdateTextureStreamer(engine->m_TextureContext.m_Streamer);
+                    }
 
                     dmMessage::Dispatch(engine->m_SystemSocket, Dispatch, engine);
                 }
@@ -17,6 +17,7 @@
 
 #include <dlib/configfile.h>
 #include <dlib/hashtable.h>
+#include <dlib/profile_capture.h>
 #include <dlib/message.h>
 
 #include <resource/resource.h>
@@ -134,6 +135,7 @@ namespace dmEngine
         dmScript::HContext                          m_GuiScriptContext;
         dmResource::HFactory                        m_Factory;
         dmGameSystem::GuiContext                    m_GuiContext;
+        dmGameSystem::TextureContext                m_TextureContext;
         dmMessage::HSocket                          m_SystemSocket;
         dmGameSystem::SpriteContext                 m_SpriteContext;
         dmGameSystem::CollectionProxyContext        m_CollectionProxyContext;
@@ -156,6 +158,9 @@ namespace dmEngine
 
         Stats                                       m_Stats;
 
+        /// Profile capture file, if enabled with profiler.capture_file or --profile-capture
+        dmProfile::HCapture                         m_ProfileCapture;
+
         bool                                        m_UseSwVsync;
         bool                                        m_UseVariableDt;
         bool                                        m_WasIconified;
@@ -34,13 +34,12 @@ namespace dmGameObject
 #define MAX_CAPACITY 65000u
 #define MIN_CAPACITY_GROWTH 2048u
 
+    // The members are ordered by how often they are accessed during the update.
+    // The members used to advance and evaluate a playing animation are kept first,
+    // so that they share cache lines, followed by the ones used when starting and
+    // stopping animations.
     struct Animation
     {
-        HInstance           m_Instance;
-        dmhash_t            m_ComponentId;
-        dmhash_t            m_PropertyId;
-        Playback            m_Playback;
-        dmEasing::Curve     m_Easing;
         float*              m_Value;
         float               m_From;
         float               m_To;
@@ -48,6 +47,11 @@ namespace dmGameObject
         float               m_Cursor;
         float               m_Duration;
         float               m_InvDuration;
+        Playback            m_Playback;
+        dmEasing::Curve     m_Easing;
+        HInstance           m_Instance;
+        dmhash_t            m_ComponentId;
+        dmhash_t            m_PropertyId;
         AnimationStopped    m_AnimationStopped;
         void*               m_Userdata1;
         void*               m_Userdata2;
@@ -60,6 +64,8 @@ namespace dmGameObject
         uint16_t            m_Composite : 1;
         uint16_t            m_Backwards : 1;
         uint16_t            m_FirstUpdate : 1;
+        // Set when the from-value was already read by the composite animation
+        uint16_t            m_HasFrom : 1;
     };
 
     struct AnimWorld
@@ -69,7 +75,11 @@ namespace dmGameObject
         dmIndexPool<uint16_t>               m_AnimMapIndexPool;
         dmHashTable<uintptr_t, uint16_t>    m_InstanceToIndex;
         dmHashTable<uintptr_t, uint16_t>    m_ListenerInstanceToIndex;
+        // Number of animations that have not yet had their first update, the start pass is skipped when zero
+        uint32_t                            m_FirstUpdateCount;
         uint32_t                            m_InUpdate : 1;
+        // Set when any animation has been stopped, the prune pass is skipped otherwise
+        uint32_t                            m_HasStopped : 1;
     };
 
     CreateResult CompAnimNewWorld(const ComponentNewWorldParams& params)
@@ -88,7 +98,9 @@ namespace dmGameObject
             const uint32_t table_count = dmMath::Max(1, instance_count/3);
             world->m_InstanceToIndex.SetCapacity(table_count, instance_count);
             world->m_ListenerInstanceToIndex.SetCapacity(table_count, instance_count);
+            world->m_FirstUpdateCount = 0;
             world->m_InUpdate = 0;
+            world->m_HasStopped = 0;
             return CREATE_RESULT_OK;
         }
         else
@@ -110,10 +122,11 @@ namespace dmGameObject
         }
     }
 
-    static void StopAnimation(Animation* anim, bool finished)
+    static void StopAnimation(AnimWorld* world, Animation* anim, bool finished)
     {
         anim->m_Finished = finished;
         anim->m_Playing = 0;
+        world->m_HasStopped = 1;
     }
 
     static void StopAnimations(AnimWorld* world, uint16_t* head_ptr, dmhash_t component_id, dmhash_t property_id)
@@ -126,7 +139,7 @@ namespace dmGameObject
                 Animation* anim = &world->m_Animations[world->m_AnimMap[index]];
                 if (anim->m_ComponentId == component_id && anim->m_PropertyId == property_id)
                 {
-                    StopAnimation(anim, false);
+                    StopAnimation(world, anim, false);
                 }
                 index = anim->m_Next;
             }
@@ -141,7 +154,7 @@ namespace dmGameObject
             while (index != INVALID_INDEX)
             {
                 Animation* anim = &world->m_Animations[world->m_AnimMap[index]];
-                StopAnimation(anim, false);
+                StopAnimation(world, anim, false);
                 index = anim->m_Next;
             }
         }
@@ -149,6 +162,59 @@ namespace dmGameObject
 
     static void RemoveAnimationCallback(AnimWorld* world, Animation* anim);
 
+    static uint32_t GetElementCount(PropertyType type)
+    {
+        switch (type)
+        {
+        case PROPERTY_TYPE_NUMBER:
+            return 1;
+        case PROPERTY_TYPE_VECTOR3:
+            return 3;
+        case PROPERTY_TYPE_VECTOR4:
+        case PROPERTY_TYPE_QUAT:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    static bool IsPendingElement(const Animation& anim, const Animation& composite, dmhash_t element_id, float update_dt)
+    {
+        return anim.m_FirstUpdate && anim.m_Playing && !anim.m_Composite && anim.m_Value == 0x0
+            && anim.m_Delay <= update_dt && anim.m_Instance == composite.m_Instance
+            && anim.m_ComponentId == composite.m_ComponentId && anim.m_PropertyId == element_id;
+    }
+
+    // The element animations of a composite animation are added right after it. When they are
+    // set through the property path (no value pointer), the from-values of all elements are read
+    // with a single GetProperty of the composite property instead of one per element.
+    // Elements that have been moved by an erase are not found here and read their own from-value.
+    static void ReadCompositeFrom(AnimWorld* world, uint32_t composite_index, float update_dt)
+    {
+        uint32_t size = world->m_Animations.Size();
+        uint32_t first = composite_index + 1;
+        if (first >= size)
+            return;
+        const Animation& composite = world->m_Animations[composite_index];
+        const Animation& next = world->m_Animations[first];
+        if (!next.m_FirstUpdate || next.m_Value != 0x0 || next.m_Instance != composite.m_Instance
+                || next.m_ComponentId != composite.m_ComponentId)
+            return;
+        PropertyDesc desc;
+        if (GetProperty(composite.m_Instance, composite.m_ComponentId, composite.m_PropertyId, desc) != PROPERTY_RESULT_OK)
+            return;
+        uint32_t element_count = GetElementCount(desc.m_Variant.m_Type);
+        for (uint32_t e = 0; e < element_count && first + e < size; ++e)
+        {
+            Animation& element = world->m_Animations[first + e];
+            if (IsPendingElement(element, composite, desc.m_ElementIds[e], update_dt))
+            {
+                element.m_From = desc.m_Variant.m_V4[e];
+                element.m_HasFrom = 1;
+            }
+        }
+    }
+
     CreateResult CompAnimAddToUpdate(const ComponentAddToUpdateParams& params) {
         // Intentional pass-through
         return CREATE_RESULT_OK;
@@ -173,6 +239,9 @@ namespace dmGameObject
          * The third pass prunes stopped animations and call callbacks.
          *
          * The reason for this is to give consistent animation evaluation, independent of ordering.
+         *
+         * With many long running animations most frames neither start nor stop any animation,
+         * so the first and third passes are skipped when there is nothing for them to do.
          */
         UpdateResult result = UPDATE_RESULT_OK;
         AnimWorld* world = (AnimWorld*)params.m_World;
@@ -180,23 +249,28 @@ namespace dmGameObject
         uint32_t size = world->m_Animations.Size();
         uint32_t orig_size = size;
         DM_COUNTER("animc", size);
+        const float update_dt = params.m_UpdateContext->m_DT;
         uint32_t i = 0;
-        for (i = 0; i < size; ++i)
+        for (i = 0; i < size && world->m_FirstUpdateCount > 0; ++i)
         {
             Animation& anim = world->m_Animations[i];
             if (!anim.m_Playing)
                 continue;
-            float dt = params.m_UpdateContext->m_DT;
             // Check delay
-            if (anim.m_Delay > dt)
+            if (anim.m_Delay > update_dt)
             {
                 continue;
             }
             if (anim.m_FirstUpdate)
             {
                 anim.m_FirstUpdate = 0;
+                --world->m_FirstUpdateCount;
                 // Update from-value
-                if (!anim.m_Composite)
+                if (anim.m_Composite)
+                {
+                    ReadCompositeFrom(world, i, update_dt);
+                }
+                else if (!anim.m_HasFrom)
                 {
                     if (anim.m_Value != 0x0)
                         anim.m_From = *anim.m_Value;
@@ -219,7 +293,7 @@ namespace dmGameObject
                         if (anim_index != i && !a2->m_FirstUpdate && a2->m_ComponentId == anim.m_ComponentId
                                 && a2->m_PropertyId == anim.m_PropertyId && a2->m_Delay <= 0.0f)
                         {
-                            StopAnimation(a2, false);
+                            StopAnimation(world, a2, false);
                         }
                         index = a2->m_Next;
                     }
@@ -233,7 +307,7 @@ namespace dmGameObject
             // Ignore canceled or delayed animations
             if (!anim.m_Playing)
                 continue;
-            float dt = params.m_UpdateContext->m_DT;
+            float dt = update_dt;
             if (anim.m_Delay > dt)
             {
                 anim.m_Delay -= dt;
@@ -313,11 +387,17 @@ namespace dmGameObject
             }
             if (completed)
             {
-                StopAnimation(&anim, true);
+                StopAnimation(world, &anim, true);
             }
         }
         i = 0;
         // Prune canceled animations and call callbacks
+        // Animations stopped by the callbacks below are pruned next update, unless they are further down the list
+        if (!world->m_HasStopped)
+        {
+            i = size;
+        }
+        world->m_HasStopped = 0;
         while (i < size)
         {
             Animation* anim = &world->m_Animations[i];
@@ -359,6 +439,10 @@ namespace dmGameObject
                 {
                     world->m_InstanceToIndex.Erase((uintptr_t)anim->m_Instance);
                 }
+                if (anim->m_FirstUpdate)
+                {
+                    --world->m_FirstUpdateCount;
+                }
                 // delete the instance from the list
                 anim = &world->m_Animations.EraseSwap(i);
                 --size;
@@ -471,6 +555,7 @@ namespace dmGameObject
         if (animation.m_Playback == PLAYBACK_ONCE_BACKWARD || animation.m_Playback == PLAYBACK_LOOP_BACKWARD)
             animation.m_Backwards = 1;
         animation.m_FirstUpdate = 1;
+        ++world->m_FirstUpdateCount;
 
 
         if (0x0 != animation_stopped)
@@ -504,22 +589,6 @@ namespace dmGameObject
                 duration, delay, animation_stopped, userdata1, userdata2, true);
     }
 
-    static uint32_t GetElementCount(PropertyType type)
-    {
-        switch (type)
-        {
-        case PROPERTY_TYPE_NUMBER:
-            return 1;
-        case PROPERTY_TYPE_VECTOR3:
-            return 3;
-        case PROPERTY_TYPE_VECTOR4:
-        case PROPERTY_TYPE_QUAT:
-            return 4;
-        default:
-            return 0;
-        }
-    }
-
     PropertyResult Animate(HCollection collection, HInstance instance, dmhash_t component_id,
                      dmhash_t property_id,
                      Playback playback,
@@ -640,7 +709,7 @@ namespace dmGameObject
                 {
                     uint16_t anim_index = world->m_AnimMap[index];
                     Animation* anim = &world->m_Animations[anim_index];
-                    StopAnimation(anim, false);
+                    StopAnimation(world, anim, false);
                     if (anim->m_AnimationStopped != 0x0)
                     {
                         anim->m_AnimationStopped(anim->m_Instance, anim->m_ComponentId, anim->m_PropertyId, anim->m_Finished,
@@ -653,6 +722,10 @@ namespace dmGameObject
                     }
                     world->m_AnimMapIndexPool.Push(index);
                     index = anim->m_Next;
+                    if (anim->m_FirstUpdate)
+                    {
+                        --world->m_FirstUpdateCount;
+                    }
                     // delete the instance from the list
                     anim_index = (uint16_t)(anim - world->m_Animations.Begin());
                     anim = &world->m_Animations.EraseSwap(anim_index);
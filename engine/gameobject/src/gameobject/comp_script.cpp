@@ -104,18 +104,17 @@ namespace dmGameObject
             int top = lua_gettop(L);
             (void) top;
 
-            lua_rawgeti(L, LUA_REGISTRYINDEX, script_instance->m_InstanceReference);
-            dmScript::SetInstance(L);
-
             lua_rawgeti(L, LUA_REGISTRYINDEX, script->m_FunctionReferences[script_function]);
             lua_rawgeti(L, LUA_REGISTRYINDEX, script_instance->m_InstanceReference);
+            lua_pushvalue(L, -1);
+            dmScript::SetInstance(L);
 
             int arg_count = 1;
 
             if (script_function == SCRIPT_FUNCTION_INIT)
             {
                 // Backwards compatibility
-                lua_rawgeti(L, LUA_REGISTRYINDEX, script_instance->m_InstanceReference);
+                lua_pushvalue(L, -1);
                 ++arg_count;
             }
             if (script_function == SCRIPT_FUNCTION_UPDATE)
@@ -125,9 +124,14 @@ namespace dmGameObject
             }
 
             {
-                uint32_t profiler_hash = 0;
-                const char* profiler_string = dmScript::GetProfilerString(L, 0, script->m_LuaModule->m_Source.m_Filename, SCRIPT_FUNCTION_NAMES[script_function], 0, &profiler_hash);
-                DM_PROFILE_DYN(Script, profiler_string, profiler_hash);
+                // The profiler string only depends on the script and function, so build it once
+                if (script->m_ProfilerStrings[script_function] == 0)
+                {
+                    uint32_t profiler_hash = 0;
+                    script->m_ProfilerStrings[script_function] = dmScript::GetProfilerString(L, 0, script->m_LuaModule->m_Source.m_Filename, SCRIPT_FUNCTION_NAMES[script_function], 0, &profiler_hash);
+                    script->m_ProfilerHashes[script_function] = profiler_hash;
+                }
+                DM_PROFILE_DYN(Script, script->m_ProfilerStrings[script_function], script->m_ProfilerHashes[script_function]);
                 if (dmScript::PCall(L, arg_count, 0) != 0)
                 {
                     result = SCRIPT_RESULT_FAILED;
@@ -233,8 +237,9 @@ namespace dmGameObject
             }
         }
 
-        // TODO: Find out if the scripts actually sent any transform events
-        update_result.m_TransformsUpdated = true;
+        // Transform writes from scripts (go.set_position, go.set etc) mark the collection
+        // transforms as dirty directly, so there is nothing to report here.
+        update_result.m_TransformsUpdated = false;
 
         assert(top == lua_gettop(L));
         return result;
@@ -1208,6 +1208,8 @@ namespace dmGameObject
                 // world transforms need to be up to date in time for the script init calls
                 collection->m_WorldTransforms[new_instances[i]->m_Index] = dmTransform::ToMatrix4(new_instances[i]->m_Transform);
             }
+            // The world transforms above ignore the hierarchy, so propagate them before the next read
+            collection->m_DirtyTransforms = 1;
         }
 
         // Exit point 1: Before components are created.
@@ -1794,8 +1796,12 @@ namespace dmGameObject
         assert(collection->m_LevelIndices[instance->m_Depth].Size() > 0);
         assert(instance->m_LevelIndex < collection->m_LevelIndices[instance->m_Depth].Size());
 
-        // Reparent child nodes
+        // Reparent child nodes, their world transforms change with the new parent
         uint32_t index = instance->m_FirstChildIndex;
+        if (index != INVALID_INSTANCE_INDEX)
+        {
+            collection->m_DirtyTransforms = 1;
+        }
         while (index != INVALID_INSTANCE_INDEX)
         {
             Instance* child = collection->m_Instances[index];
@@ -2770,6 +2776,7 @@ namespace dmGameObject
     void SetPosition(HInstance instance, Point3 position)
     {
         instance->m_Transform.SetTranslation(Vector3(position));
+        instance->m_Collection->m_DirtyTransforms = 1;
     }
 
     Point3 GetPosition(HInstance instance)
@@ -2780,6 +2787,7 @@ namespace dmGameObject
     void SetRotation(HInstance instance, Quat rotation)
     {
         instance->m_Transform.SetRotation(rotation);
+        instance->m_Collection->m_DirtyTransforms = 1;
     }
 
     Quat GetRotation(HInstance instance)
@@ -2790,11 +2798,13 @@ namespace dmGameObject
     void SetScale(HInstance instance, float scale)
     {
         instance->m_Transform.SetUniformScale(scale);
+        instance->m_Collection->m_DirtyTransforms = 1;
     }
 
     void SetScale(HInstance instance, Vector3 scale)
     {
         instance->m_Transform.SetScale(scale);
+        instance->m_Collection->m_DirtyTransforms = 1;
     }
 
     float GetUniformScale(HInstance instance)
@@ -2935,6 +2945,7 @@ namespace dmGameObject
             }
         }
 
+        collection->m_DirtyTransforms = 1;
         return RESULT_OK;
     }
 
@@ -3183,6 +3194,8 @@ namespace dmGameObject
             return PROPERTY_RESULT_INVALID_INSTANCE;
         if (component_id == 0)
         {
+            // All properties of the instance itself are transform properties
+            instance->m_Collection->m_DirtyTransforms = 1;
             float* position = instance->m_Transform.GetPositionPtr();
             float* rotation = instance->m_Transform.GetRotationPtr();
             float* scale = instance->m_Transform.GetScalePtr();
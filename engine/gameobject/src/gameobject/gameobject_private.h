@@ -288,6 +288,7 @@ namespace dmGameObject
         uint32_t                 m_ToBeDeleted : 1;
         // If the game object dynamically created in this collection should have the Z component of the position affected by scale
         uint32_t                 m_ScaleAlongZ : 1;
+        // Set when any instance transform or the hierarchy has changed since the last UpdateTransforms
         uint32_t                 m_DirtyTransforms : 1;
         uint32_t                 m_Initialized : 1;
     };
@@ -62,6 +62,9 @@ namespace dmGameObject
         int                     m_InstanceReference;
         // Resources referenced through property values in the script
         dmArray<void*>          m_PropertyResources;
+        // Profiler scope names per script function, internalized on first call
+        const char*             m_ProfilerStrings[MAX_SCRIPT_FUNCTION_COUNT];
+        uint32_t                m_ProfilerHashes[MAX_SCRIPT_FUNCTION_COUNT];
     };
 
     typedef Script* HScript;
@@ -824,6 +824,136 @@ TEST_F(AnimTest, ScaleZ)
     dmGameObject::Delete(m_Collection, go, false);
 }
 
+// Test that an animation started after others are already running, and after a pending animation
+// was cancelled, still reads its from-value when it starts
+TEST_F(AnimTest, StartAfterCancelledPending)
+{
+    dmGameObject::HInstance go1 = dmGameObject::New(m_Collection, "/dummy.goc");
+    dmGameObject::HInstance go2 = dmGameObject::New(m_Collection, "/dummy.goc");
+
+    m_UpdateContext.m_DT = 0.25f;
+    dmhash_t id_x = hash("position.x");
+    dmhash_t id_y = hash("position.y");
+    dmGameObject::PropertyVar var_long(100.0f);
+    dmGameObject::PropertyVar var_short(1.0f);
+
+    // A long running animation and one that finishes after two frames
+    Animate(m_Collection, go1, 0, id_x, dmGameObject::PLAYBACK_ONCE_FORWARD, var_long, dmEasing::Curve(dmEasing::TYPE_LINEAR), 10.0f, 0.0f, AnimationStopped, this, 0x0);
+    Animate(m_Collection, go2, 0, id_x, dmGameObject::PLAYBACK_ONCE_FORWARD, var_short, dmEasing::Curve(dmEasing::TYPE_LINEAR), 0.5f, 0.0f, AnimationStopped, this, 0x0);
+    dmGameObject::Update(m_Collection, &m_UpdateContext);
+    dmGameObject::Update(m_Collection, &m_UpdateContext);
+    ASSERT_NEAR(5.0f, X(go1), EPSILON);
+    ASSERT_NEAR(1.0f, X(go2), EPSILON);
+    ASSERT_EQ(1u, m_FinishCount);
+    ASSERT_EQ(0u, m_CancelCount);
+
+    // Only the long running animation is left, a pending animation is cancelled before it starts
+    Animate(m_Collection, go2, 0, id_x, dmGameObject::PLAYBACK_ONCE_FORWARD, var_long, dmEasing::Curve(dmEasing::TYPE_LINEAR), 1.0f, 0.5f, AnimationStopped, this, 0x0);
+    dmGameObject::CancelAnimations(m_Collection, go2);
+    ASSERT_EQ(1u, m_CancelCount);
+    dmGameObject::Update(m_Collection, &m_UpdateContext);
+    ASSERT_NEAR(7.5f, X(go1), EPSILON);
+    ASSERT_NEAR(1.0f, X(go2), EPSILON);
+
+    // The from-value of a new animation is read when it starts, after the delay
+    dmGameObject::PropertyVar var_y(4.0f);
+    Animate(m_Collection, go2, 0, id_y, dmGameObject::PLAYBACK_ONCE_FORWARD, var_y, dmEasing::Curve(dmEasing::TYPE_LINEAR), 0.25f, 0.25f, AnimationStopped, this, 0x0);
+    dmGameObject::SetPosition(go2, Point3(1.0f, 2.0f, 0.0f));
+    dmGameObject::Update(m_Collection, &m_UpdateContext);
+    ASSERT_NEAR(2.0f, dmGameObject::GetPosition(go2).getY(), EPSILON);
+    dmGameObject::Update(m_Collection, &m_UpdateContext);
+    ASSERT_NEAR(4.0f, dmGameObject::GetPosition(go2).getY(), EPSILON);
+    ASSERT_EQ(2u, m_FinishCount);
+    ASSERT_EQ(1u, m_CancelCount);
+
+    // A finished animation is pruned while the long running one keeps playing
+    dmGameObject::Update(m_Collection, &m_UpdateContext);
+    ASSERT_NEAR(15.0f, X(go1), EPSILON);
+    ASSERT_EQ(2u, m_FinishCount);
+
+    dmGameObject::Delete(m_Collection, go1, false);
+    dmGameObject::Delete(m_Collection, go2, false);
+}
+
+// Test that the element animations of a composite property without value pointers read their from-values on start
+TEST_F(AnimTest, CompositeFromValue)
+{
+    m_UpdateContext.m_DT = 0.25f;
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/composite_from.goc", hash("test"), 0, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    dmhash_t id = hash("test_value");
+    dmGameObject::PropertyDesc desc;
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::GetProperty(go, hash("script"), id, desc));
+    ASSERT_NEAR(2.0f, desc.m_Variant.m_V4[0], EPSILON);
+    ASSERT_NEAR(3.0f, desc.m_Variant.m_V4[1], EPSILON);
+    ASSERT_NEAR(4.0f, desc.m_Variant.m_V4[2], EPSILON);
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    }
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::GetProperty(go, hash("script"), id, desc));
+    ASSERT_NEAR(5.0f, desc.m_Variant.m_V4[0], EPSILON);
+    ASSERT_NEAR(6.0f, desc.m_Variant.m_V4[1], EPSILON);
+    ASSERT_NEAR(7.0f, desc.m_Variant.m_V4[2], EPSILON);
+}
+
+// Measures the steady state cost of many running tweens, i.e. frames where no animation starts or stops.
+// The time of a frame without animations is subtracted to leave the animation update.
+TEST_F(AnimTest, UpdateBenchmark)
+{
+    const uint32_t count = 4096;
+    const uint32_t frame_count = 60;
+    m_UpdateContext.m_DT = 1.0f / 60.0f;
+    dmhash_t id = hash("position");
+    dmGameObject::PropertyVar var(Vector3(10.0f, 0.0f, 0.0f));
+
+    dmGameObject::HInstance* gos = new dmGameObject::HInstance[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        gos[i] = dmGameObject::New(m_Collection, "/dummy.goc");
+    }
+
+    uint64_t time = dmTime::GetTime();
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    }
+    uint64_t base = dmTime::GetTime() - time;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        dmGameObject::PropertyResult result = Animate(m_Collection, gos[i], 0, id, dmGameObject::PLAYBACK_LOOP_PINGPONG, var,
+                dmEasing::Curve(dmEasing::TYPE_INOUTQUAD), 1.0f + (i % 7), 0.0f, 0x0, this, 0x0);
+        ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, result);
+    }
+    // Start frame
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    time = dmTime::GetTime();
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    }
+    uint64_t delta = dmTime::GetTime() - time;
+    uint64_t anim_delta = delta > base ? delta - base : 0;
+
+    // 3 element animations per composite position animation
+    const uint32_t anim_count = count * 3;
+    printf("%d animations updated in %.3f ms/frame (%.3f ms/frame without animations, %.1f ns/animation)\n", anim_count,
+            delta * 0.001 / frame_count, base * 0.001 / frame_count, anim_delta * 1000.0 / (frame_count * anim_count));
+
+    // The looping animations are still playing
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_LT(0.0f, X(gos[i]));
+        dmGameObject::Delete(m_Collection, gos[i], false);
+    }
+    delete [] gos;
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -621,6 +621,68 @@ TEST_F(HierarchyTest, TestHierarchyScale)
     dmGameObject::Delete(m_Collection, parent, false);
 }
 
+TEST_F(HierarchyTest, TestDirtyTransforms)
+{
+    dmGameObject::HInstance parent = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::HInstance child = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::Collection* collection = m_Collection->m_Collection;
+
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(child, parent));
+    ASSERT_TRUE(collection->m_DirtyTransforms);
+
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_FALSE(collection->m_DirtyTransforms);
+
+    // Scripts that don't move anything should leave the transforms clean
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_FALSE(collection->m_DirtyTransforms);
+
+    dmGameObject::SetPosition(parent, Point3(1.0f, 2.0f, 3.0f));
+    ASSERT_TRUE(collection->m_DirtyTransforms);
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_FALSE(collection->m_DirtyTransforms);
+    ASSERT_NEAR(1.0f, dmGameObject::GetWorldPosition(child).getX(), EPSILON);
+
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::SetProperty(parent, 0, dmHashString64("position.x"), dmGameObject::PropertyVar(5.0f)));
+    ASSERT_TRUE(collection->m_DirtyTransforms);
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_NEAR(5.0f, dmGameObject::GetWorldPosition(child).getX(), EPSILON);
+
+    dmGameObject::Delete(m_Collection, child, false);
+    dmGameObject::Delete(m_Collection, parent, false);
+}
+
+TEST_F(HierarchyTest, TestDeleteParentDirtyTransforms)
+{
+    dmGameObject::HInstance grand_parent = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::HInstance parent = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::HInstance child = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::Collection* collection = m_Collection->m_Collection;
+
+    dmGameObject::SetPosition(grand_parent, Point3(1.0f, 0.0f, 0.0f));
+    dmGameObject::SetPosition(parent, Point3(10.0f, 0.0f, 0.0f));
+    dmGameObject::SetPosition(child, Point3(100.0f, 0.0f, 0.0f));
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(parent, grand_parent));
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(child, parent));
+
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_FALSE(collection->m_DirtyTransforms);
+    ASSERT_NEAR(111.0f, dmGameObject::GetWorldPosition(child).getX(), EPSILON);
+
+    dmGameObject::Delete(m_Collection, parent, false);
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    ASSERT_EQ(grand_parent, dmGameObject::GetParent(child));
+    ASSERT_TRUE(collection->m_DirtyTransforms);
+
+    // The child is now attached to the grand parent on the next frame
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_FALSE(collection->m_DirtyTransforms);
+    ASSERT_NEAR(101.0f, dmGameObject::GetWorldPosition(child).getX(), EPSILON);
+
+    dmGameObject::Delete(m_Collection, child, false);
+    dmGameObject::Delete(m_Collection, grand_parent, false);
+}
+
 TEST_F(HierarchyTest, TestHierarchyNonUniformScale)
 {
     dmGameObject::HInstance parent = dmGameObject::New(m_Collection, "/go.goc");
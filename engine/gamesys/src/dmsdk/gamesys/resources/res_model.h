@@ -34,6 +34,8 @@ namespace dmGameSystem
         dmhash_t                m_TexturePaths[dmRender::RenderObject::MAX_TEXTURE_COUNT];
         dmGraphics::Type        m_IndexBufferElementType;
         uint32_t                m_ElementCount;
+        /// Radius of the sphere around the model origin that contains all mesh positions
+        float                   m_BoundingRadius;
     };
 }
 
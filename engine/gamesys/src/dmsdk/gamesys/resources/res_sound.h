@@ -33,6 +33,7 @@ namespace dmGameSystem
         float               m_Pan;
         float               m_Speed;
         uint8_t             m_Loopcount;
+        uint8_t             m_Priority;
         uint8_t             m_Looping:1;
     };
 }
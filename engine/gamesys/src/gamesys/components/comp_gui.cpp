@@ -34,6 +34,7 @@
 #include "../resources/res_skeleton.h"
 #include "../resources/res_meshset.h"
 #include "../resources/res_animationset.h"
+#include "../resources/res_texture.h"
 #include "../gamesys.h"
 #include "../gamesys_private.h"
 
@@ -143,6 +144,7 @@ namespace dmGameSystem
         // Grows automatically
         gui_world->m_GuiRenderObjects.SetCapacity(128);
 
+        gui_world->m_TextureStreamer = gui_context->m_TextureStreamer;
         gui_world->m_MaxParticleFXCount = gui_context->m_MaxParticleFXCount;
         gui_world->m_MaxParticleCount = gui_context->m_MaxParticleCount;
         gui_world->m_ParticleContext = dmParticle::CreateContext(gui_world->m_MaxParticleFXCount, gui_world->m_MaxParticleCount);
@@ -685,6 +687,13 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
+    // The size of the nodes on screen is not estimated, so the full resolution is requested
+    static inline void RequestTexture(GuiWorld* gui_world, dmGraphics::HTexture texture)
+    {
+        if (gui_world->m_TextureStreamer && texture)
+            RequestTextureMip(gui_world->m_TextureStreamer, texture, 0);
+    }
+
     struct RenderGuiContext
     {
         dmRender::HRenderContext    m_RenderContext;
@@ -914,6 +923,7 @@ namespace dmGameSystem
         ro.m_VertexStart = gui_world->m_ClientVertexBuffer.Size();
         ro.m_Material = gui_context->m_Material;
         ro.m_Textures[0] = (dmGraphics::HTexture)first_emitter_render_data->m_Texture;
+        RequestTexture(gui_world, ro.m_Textures[0]);
 
         // Offset capacity to fit vertices for all emitters we are about to render
         uint32_t vertex_count = 0;
@@ -1039,6 +1049,7 @@ namespace dmGameSystem
 
         // Set default texture
         dmGraphics::HTexture texture = dmGameSystem::GetNodeTexture(scene, first_node);
+        RequestTexture(gui_world, texture);
         if (texture) {
             ro.m_Textures[0] = texture;
         } else {
@@ -1110,6 +1121,7 @@ namespace dmGameSystem
 
         // Set default texture
         dmGraphics::HTexture texture = dmGameSystem::GetNodeTexture(scene, first_node);
+        RequestTexture(gui_world, texture);
         if (texture)
             ro.m_Textures[0] = texture;
         else
@@ -1414,6 +1426,7 @@ namespace dmGameSystem
 
         // Set default texture
         dmGraphics::HTexture texture = dmGameSystem::GetNodeTexture(scene, first_node);
+        RequestTexture(gui_world, texture);
         if (texture)
             ro.m_Textures[0] = texture;
         else
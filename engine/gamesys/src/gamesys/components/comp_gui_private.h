@@ -23,6 +23,7 @@
 namespace dmGameSystem
 {
     struct GuiSceneResource;
+    struct TextureStreamer;
 
     struct GuiComponent
     {
@@ -92,6 +93,7 @@ namespace dmGameSystem
         float                            m_DT;
         dmRig::HRigContext               m_RigContext;
         dmScript::ScriptWorld*           m_ScriptWorld;
+        TextureStreamer*                 m_TextureStreamer;
     };
 
     typedef BoxVertex ParticleGuiVertex;
@@ -65,18 +65,31 @@ namespace dmGameSystem
         dmRender::HFontMap          m_FontMap;
 
         const char*                 m_Text;
+        // Glyphs laid out in font space, only updated when the layout changes (see LayoutLabel)
+        dmRender::TextGlyph*        m_Glyphs;
+        uint32_t                    m_GlyphCount;
+        uint32_t                    m_GlyphCapacity;
 
         uint16_t                    m_ComponentIndex;
         uint16_t                    m_Enabled : 1;
         uint16_t                    m_AddedToUpdate : 1;
         uint16_t                    m_UserAllocatedText : 1;
         uint16_t                    m_ReHash : 1;
-        uint16_t                    m_Padding : 4;
+        uint16_t                    m_Relayout : 1;
+        uint16_t                    m_Padding : 3;
     };
 
     struct LabelWorld
     {
-        dmObjectPool<LabelComponent>    m_Components;
+        dmObjectPool<LabelComponent>        m_Components;
+        dmArray<dmRender::RenderObject*>    m_RenderObjects;
+        uint32_t                            m_RenderObjectsInUse;
+        dmArray<dmRender::TextGlyph>        m_Layout;
+        dmGraphics::HVertexBuffer           m_VertexBuffer;
+        dmRender::GlyphVertex*              m_VertexBufferData;
+        dmRender::GlyphVertex*              m_VertexBufferWritePtr;
+        uint32_t                            m_VertexBufferCapacity;
+        uint32_t                            m_LayoutCount;
     };
 
     DM_GAMESYS_PROP_VECTOR3(LABEL_PROP_SCALE, scale, false);
@@ -85,6 +98,8 @@ namespace dmGameSystem
     DM_GAMESYS_PROP_VECTOR4(LABEL_PROP_OUTLINE, outline, false);
     DM_GAMESYS_PROP_VECTOR4(LABEL_PROP_SHADOW, shadow, false);
 
+    static void ResourceReloadedCallback(const dmResource::ResourceReloadedParams& params);
+
     dmGameObject::CreateResult CompLabelNewWorld(const dmGameObject::ComponentNewWorldParams& params)
     {
         DM_STATIC_ASSERT( dmRender::MAX_FONT_RENDER_CONSTANTS == MAX_COMP_RENDER_CONSTANTS, Constant_Arrays_Must_Have_Same_Size );
@@ -94,6 +109,15 @@ namespace dmGameSystem
 
         world->m_Components.SetCapacity(label_context->m_MaxLabelCount);
         memset(world->m_Components.m_Objects.Begin(), 0, sizeof(LabelComponent) * label_context->m_MaxLabelCount);
+        world->m_RenderObjectsInUse = 0;
+
+        world->m_VertexBuffer = dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(label_context->m_RenderContext), 0, 0x0, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+        world->m_VertexBufferData = 0;
+        world->m_VertexBufferWritePtr = 0;
+        world->m_VertexBufferCapacity = 0;
+        world->m_LayoutCount = 0;
+
+        dmResource::RegisterResourceReloadedCallback(label_context->m_Factory, ResourceReloadedCallback, world);
 
         *params.m_World = world;
         return dmGameObject::CREATE_RESULT_OK;
@@ -111,8 +135,22 @@ namespace dmGameSystem
             {
                 free((void*)component.m_Text);
             }
+            free(component.m_Glyphs);
+        }
+
+        for (uint32_t i = 0; i < world->m_RenderObjects.Size(); ++i)
+        {
+            delete world->m_RenderObjects[i];
         }
 
+        dmGraphics::DeleteVertexBuffer(world->m_VertexBuffer);
+        if (world->m_VertexBufferData)
+        {
+            dmMemory::AlignedFree(world->m_VertexBufferData);
+        }
+
+        dmResource::UnregisterResourceReloadedCallback(((LabelContext*)params.m_Context)->m_Factory, ResourceReloadedCallback, world);
+
         delete world;
         return dmGameObject::CREATE_RESULT_OK;
     }
@@ -234,6 +272,7 @@ namespace dmGameSystem
         component->m_Text = ddf->m_Text;
         component->m_UserAllocatedText = 0;
         component->m_ReHash = 1;
+        component->m_Relayout = 1;
 
         *params.m_UserData = (uintptr_t)index;
         return dmGameObject::CREATE_RESULT_OK;
@@ -250,6 +289,7 @@ namespace dmGameSystem
             component.m_UserAllocatedText = 0;
             free((void*)component.m_Text);
         }
+        free(component.m_Glyphs);
         dmResource::HFactory factory = dmGameObject::GetFactory(params.m_Collection);
         if (component.m_Material) {
             dmResource::Release(factory, component.m_Material);
@@ -330,23 +370,16 @@ namespace dmGameSystem
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
-    static void CreateDrawTextParams(LabelComponent* component, dmRender::DrawTextParams& params)
+    static void CreateLayoutParams(LabelComponent* component, dmRender::DrawTextParams& params)
     {
         dmGameSystemDDF::LabelDesc* ddf = component->m_Resource->m_DDF;
 
-        params.m_FaceColor = component->m_Color;
-        params.m_OutlineColor = component->m_Outline;
-        params.m_ShadowColor = component->m_Shadow;
         params.m_Text = component->m_Text;
-        params.m_WorldTransform = component->m_World;
-        params.m_RenderOrder = 0;
         params.m_LineBreak = ddf->m_LineBreak;
         params.m_Leading = ddf->m_Leading;
         params.m_Tracking = ddf->m_Tracking;
         params.m_Width = component->m_Size.getX();
         params.m_Height = component->m_Size.getY();
-        // Disable stencil
-        params.m_StencilTestParamsSet = 0;
 
         switch (ddf->m_Pivot)
         {
@@ -387,28 +420,115 @@ namespace dmGameSystem
             params.m_VAlign = dmRender::TEXT_VALIGN_BOTTOM;
             break;
         }
+    }
+
+    // The layout is kept until the text, font or text area size changes, and the vertices
+    // are then created from it each frame with the current transform and colors.
+    static void LayoutLabel(LabelWorld* world, LabelComponent* component)
+    {
+        DM_PROFILE(Label, "LayoutLabel");
+
+        dmRender::DrawTextParams params;
+        CreateLayoutParams(component, params);
+
+        dmArray<dmRender::TextGlyph>& layout = world->m_Layout;
+        layout.SetSize(0);
+        dmRender::LayoutText(GetFontMap(component, component->m_Resource), params, layout);
+
+        uint32_t glyph_count = layout.Size();
+        if (glyph_count > component->m_GlyphCapacity)
+        {
+            component->m_Glyphs = (dmRender::TextGlyph*) realloc(component->m_Glyphs, sizeof(dmRender::TextGlyph) * glyph_count);
+            component->m_GlyphCapacity = glyph_count;
+        }
+        if (glyph_count)
+        {
+            memcpy(component->m_Glyphs, layout.Begin(), sizeof(dmRender::TextGlyph) * glyph_count);
+        }
+        component->m_GlyphCount = glyph_count;
+        component->m_Relayout = 0;
+        ++world->m_LayoutCount;
+    }
+
+    static void ReserveVertices(LabelWorld* world, uint32_t vertex_count)
+    {
+        if (vertex_count <= world->m_VertexBufferCapacity)
+            return;
+
+        // The vertices are written from scratch every frame, so the old data isn't kept
+        uint32_t capacity = dmMath::Max(vertex_count, world->m_VertexBufferCapacity + world->m_VertexBufferCapacity / 2);
+        if (world->m_VertexBufferData)
+        {
+            dmMemory::AlignedFree(world->m_VertexBufferData);
+        }
+        // The glyph vertices must be 16 byte aligned, see GlyphVertex
+        dmMemory::AlignedMalloc((void**)&world->m_VertexBufferData, 16, sizeof(dmRender::GlyphVertex) * capacity);
+        world->m_VertexBufferCapacity = capacity;
+    }
+
+    static void RenderBatch(LabelWorld* world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(Label, "RenderBatch");
+
+        // The batch key includes the font map, material, blend mode and render constants
+        LabelComponent* first = (LabelComponent*) buf[*begin].m_UserData;
+        LabelResource* resource = first->m_Resource;
+        dmRender::HFontMap font_map = GetFontMap(first, resource);
+
+        if (world->m_RenderObjectsInUse == world->m_RenderObjects.Capacity())
+        {
+            world->m_RenderObjects.OffsetCapacity(1);
+            dmRender::RenderObject* ro = new dmRender::RenderObject;
+            world->m_RenderObjects.Push(ro);
+        }
+
+        dmRender::RenderObject& ro = *world->m_RenderObjects[world->m_RenderObjectsInUse++];
+
+        dmRender::GlyphVertex* vb_begin = world->m_VertexBufferWritePtr;
+        dmRender::GlyphVertex* vb_end = world->m_VertexBufferData + world->m_VertexBufferCapacity;
+        dmRender::GlyphVertex* vb_iter = vb_begin;
+        for (uint32_t* i = begin; i != end; ++i)
+        {
+            const LabelComponent* component = (LabelComponent*) buf[*i].m_UserData;
+            vb_iter += dmRender::CreateTextVertexData(render_context, font_map, component->m_World,
+                                                      component->m_Color, component->m_Outline, component->m_Shadow,
+                                                      component->m_Glyphs, component->m_GlyphCount, vb_iter, (uint32_t)(vb_end - vb_iter));
+        }
+        world->m_VertexBufferWritePtr = vb_iter;
+
+        ro.Init();
+        ro.m_VertexBuffer = world->m_VertexBuffer;
+        ro.m_Material = GetMaterial(first, resource);
+        ro.m_VertexStart = vb_begin - world->m_VertexBufferData;
+        ro.m_VertexCount = vb_iter - vb_begin;
+        dmRender::SetupTextRenderObject(render_context, font_map, &ro);
+
+        if (first->m_RenderConstants) {
+            dmGameSystem::EnableRenderObjectConstants(&ro, first->m_RenderConstants);
+        }
 
+        dmGameSystemDDF::LabelDesc* ddf = resource->m_DDF;
         // Taken from comp_sprite.cpp
         switch (ddf->m_BlendMode)
         {
             case dmGameSystemDDF::LabelDesc::BLEND_MODE_ALPHA:
-                params.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
-                params.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
             break;
 
             case dmGameSystemDDF::LabelDesc::BLEND_MODE_ADD:
-                params.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
-                params.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
             break;
 
             case dmGameSystemDDF::LabelDesc::BLEND_MODE_MULT:
-                params.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_DST_COLOR;
-                params.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_DST_COLOR;
+                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
             break;
 
             case dmGameSystemDDF::LabelDesc::BLEND_MODE_SCREEN:
-                params.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_DST_COLOR;
-                params.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_DST_COLOR;
+                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
             break;
 
             default:
@@ -416,6 +536,40 @@ namespace dmGameSystem
                 assert(0);
             break;
         }
+
+        ro.m_SetBlendFactors = 1;
+
+        dmRender::AddToRender(render_context, &ro);
+    }
+
+    static void RenderListDispatch(dmRender::RenderListDispatchParams const &params)
+    {
+        LabelWorld* world = (LabelWorld*) params.m_UserData;
+
+        switch (params.m_Operation)
+        {
+            case dmRender::RENDER_LIST_OPERATION_BEGIN:
+                world->m_VertexBufferWritePtr = world->m_VertexBufferData;
+                world->m_RenderObjectsInUse = 0;
+                break;
+            case dmRender::RENDER_LIST_OPERATION_END:
+                {
+                    uint32_t vertex_count = world->m_VertexBufferWritePtr - world->m_VertexBufferData;
+                    if (vertex_count)
+                    {
+                        uint32_t vertex_size = sizeof(dmRender::GlyphVertex) * vertex_count;
+                        dmGraphics::SetVertexBufferData(world->m_VertexBuffer, vertex_size,
+                                                        world->m_VertexBufferData, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+
+                        DM_COUNTER("LabelCharacterCount", vertex_count / 6); // each quad is two triangles
+                        DM_COUNTER("LabelVertexBuffer", vertex_size);
+                    }
+                }
+                break;
+            default:
+                assert(params.m_Operation == dmRender::RENDER_LIST_OPERATION_BATCH);
+                RenderBatch(world, params.m_Context, params.m_Buf, params.m_Begin, params.m_End);
+        }
     }
 
     dmGameObject::UpdateResult CompLabelRender(const dmGameObject::ComponentsRenderParams& params)
@@ -427,11 +581,19 @@ namespace dmGameSystem
         dmArray<LabelComponent>& components = world->m_Components.m_Objects;
         uint32_t component_count = components.Size();
 
+        world->m_LayoutCount = 0;
         if (!component_count)
             return dmGameObject::UPDATE_RESULT_OK;
 
         UpdateTransforms(world, label_context->m_Subpixels);
 
+        // Submit all labels as entries in the render list for sorting. Labels with the same font map,
+        // material, blend mode and render constants are batched into one draw call from the world vertex buffer.
+        dmRender::RenderListEntry* render_list = dmRender::RenderListAlloc(render_context, component_count);
+        dmRender::HRenderListDispatch label_dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, world);
+        dmRender::RenderListEntry* write_ptr = render_list;
+        uint32_t vertex_count = 0;
+
         for (uint32_t i = 0; i < component_count; ++i)
         {
             LabelComponent* component = &components[i];
@@ -443,24 +605,31 @@ namespace dmGameSystem
                 ReHash(component);
             }
 
-            dmRender::DrawTextParams params;
-            CreateDrawTextParams(component, params);
-
-            if (component->m_RenderConstants)
+            if (component->m_Relayout)
             {
-                uint32_t size = dmGameSystem::GetRenderConstantCount(component->m_RenderConstants);
-                for (uint32_t i = 0; i < size; ++i)
-                {
-                    dmGameSystem::GetRenderConstant(component->m_RenderConstants, i, &params.m_RenderConstants[i]);
-                }
-                params.m_NumRenderConstants = dmMath::Max<uint32_t>(size, dmRender::MAX_FONT_RENDER_CONSTANTS);
+                LayoutLabel(world, component);
             }
 
+            if (!component->m_GlyphCount)
+                continue;
+
             LabelResource* resource = component->m_Resource;
-            dmRender::DrawText(render_context, GetFontMap(component, resource), GetMaterial(component, resource), component->m_MixedHash, params);
+            vertex_count += dmRender::GetTextVertexCount(GetFontMap(component, resource), component->m_GlyphCount);
+
+            const Vector4 trans = component->m_World.getCol(3);
+            write_ptr->m_WorldPosition = Point3(trans.getX(), trans.getY(), trans.getZ());
+            write_ptr->m_UserData = (uintptr_t) component;
+            write_ptr->m_BatchKey = component->m_MixedHash;
+            write_ptr->m_TagListKey = dmRender::GetMaterialTagListKey(GetMaterial(component, resource));
+            write_ptr->m_Dispatch = label_dispatch;
+            write_ptr->m_MinorOrder = 0;
+            write_ptr->m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+            ++write_ptr;
         }
 
-        dmRender::FlushTexts(render_context, dmRender::RENDER_ORDER_WORLD, 0, false);
+        ReserveVertices(world, vertex_count);
+
+        dmRender::RenderListSubmit(render_context, render_list, write_ptr);
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
@@ -508,6 +677,7 @@ namespace dmGameSystem
             }
             component->m_Text = strdup(textmsg->m_Text);
             component->m_UserAllocatedText = 1;
+            component->m_Relayout = 1;
         }
 
         return dmGameObject::UPDATE_RESULT_OK;
@@ -515,7 +685,26 @@ namespace dmGameSystem
 
     void CompLabelOnReload(const dmGameObject::ComponentOnReloadParams& params)
     {
-        (void)params;
+        LabelWorld* world = (LabelWorld*)params.m_World;
+        LabelComponent* component = &world->m_Components.Get(*params.m_UserData);
+        component->m_ReHash = 1;
+        component->m_Relayout = 1;
+    }
+
+    // The cached glyph layout depends on the font metrics, so labels using a reloaded font are laid out again
+    static void ResourceReloadedCallback(const dmResource::ResourceReloadedParams& params)
+    {
+        LabelWorld* world = (LabelWorld*) params.m_UserData;
+        dmArray<LabelComponent>& components = world->m_Components.m_Objects;
+        uint32_t n = components.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            LabelComponent* component = &components[i];
+            if (component->m_Resource && GetFontMap(component, component->m_Resource) == params.m_Resource->m_Resource)
+            {
+                component->m_Relayout = 1;
+            }
+        }
     }
 
     void* CompLabelGetComponent(const dmGameObject::ComponentGetParams& params)
@@ -525,6 +714,12 @@ namespace dmGameSystem
         return &world->m_Components.Get(index);
     }
 
+    void GetLabelStats(void* label_world, LabelStats* stats)
+    {
+        LabelWorld* world = (LabelWorld*)label_world;
+        stats->m_LayoutCount = world->m_LayoutCount;
+    }
+
     void CompLabelGetTextMetrics(const LabelComponent* component, struct dmRender::TextMetrics& metrics)
     {
         dmGameSystemDDF::LabelDesc* ddf = component->m_Resource->m_DDF;
@@ -591,7 +786,9 @@ namespace dmGameSystem
         }
         else if (IsReferencingProperty(LABEL_PROP_SIZE, set_property))
         {
-            return SetProperty(set_property, params.m_Value, component->m_Size, LABEL_PROP_SIZE);
+            dmGameObject::PropertyResult res = SetProperty(set_property, params.m_Value, component->m_Size, LABEL_PROP_SIZE);
+            component->m_Relayout |= res == dmGameObject::PROPERTY_RESULT_OK;
+            return res;
         }
         else if (IsReferencingProperty(LABEL_PROP_COLOR, set_property))
         {
@@ -615,6 +812,7 @@ namespace dmGameSystem
         {
             dmGameObject::PropertyResult res = SetResourceProperty(dmGameObject::GetFactory(params.m_Instance), params.m_Value, FONT_EXT_HASH, (void**)&component->m_FontMap);
             component->m_ReHash |= res == dmGameObject::PROPERTY_RESULT_OK;
+            component->m_Relayout |= res == dmGameObject::PROPERTY_RESULT_OK;
             return res;
         }
         return SetMaterialConstant(GetMaterial(component, component->m_Resource), set_property, params.m_Value, CompLabelSetConstantCallback, component);
@@ -46,6 +46,14 @@ namespace dmGameSystem
 
     dmGameObject::PropertyResult CompLabelSetProperty(const dmGameObject::ComponentSetPropertyParams& params);
 
+    // Statistics of the last render of the world
+    struct LabelStats
+    {
+        uint32_t m_LayoutCount; // Labels laid out again
+    };
+
+    void GetLabelStats(void* label_world, LabelStats* stats);
+
     // For scripting
     struct LabelComponent;
 
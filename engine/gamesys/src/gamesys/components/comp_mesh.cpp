@@ -38,6 +38,7 @@
 #include <gamesys/mesh_ddf.h>
 
 #include "../resources/res_mesh.h"
+#include "../resources/res_texture.h"
 
 namespace dmGameSystem
 {
@@ -87,6 +88,8 @@ namespace dmGameSystem
         dmArray<dmGraphics::HVertexBuffer> m_VertexBufferPool;
         dmArray<dmGraphics::HVertexBuffer> m_VertexBufferWorld; // for meshes batched in world space
         dmGraphics::HContext               m_GraphicsContext;
+        HTextureStreamer                   m_TextureStreamer;
+        InstanceBuffer                     m_InstanceBuffer;
         void*                              m_WorldVertexData;
         size_t                             m_WorldVertexDataSize;
         /// Keep track of how much vertex data we have rendered so it can be
@@ -206,6 +209,10 @@ namespace dmGameSystem
 
         world->m_RenderedVertexSize = 0;
 
+        world->m_GraphicsContext = dmRender::GetGraphicsContext(context->m_RenderContext);
+        world->m_TextureStreamer = context->m_TextureStreamer;
+        NewInstanceBuffer(world->m_GraphicsContext, &world->m_InstanceBuffer);
+
         *params.m_World = world;
 
         dmResource::RegisterResourceReloadedCallback(context->m_Factory, ResourceReloadedCallback, world);
@@ -232,6 +239,8 @@ namespace dmGameSystem
             free(world->m_WorldVertexData);
         }
 
+        DeleteInstanceBuffer(&world->m_InstanceBuffer);
+
         dmResource::UnregisterResourceReloadedCallback(((MeshContext*)params.m_Context)->m_Factory, ResourceReloadedCallback, world);
 
         delete world;
@@ -473,6 +482,18 @@ namespace dmGameSystem
             dmGameSystem::EnableRenderObjectConstants(&ro, constants);
     }
 
+    // The size of the meshes on screen is not estimated, so the full resolution is requested
+    static void RequestTextureMips(MeshWorld* world, const dmRender::RenderObject& ro)
+    {
+        if (!world->m_TextureStreamer)
+            return;
+        for (uint32_t i = 0; i < dmRender::RenderObject::MAX_TEXTURE_COUNT; ++i)
+        {
+            if (ro.m_Textures[i])
+                RequestTextureMip(world->m_TextureStreamer, ro.m_Textures[i], 0);
+        }
+    }
+
     template<typename T> static void FillAndApply(const Matrix4& matrix, bool is_point, uint8_t component_count, uint32_t count, uint32_t stride, T* raw_data, T* src_stream_data, T* dst_data_ptr)
     {
         // Offset dst_data_ptr if stream isn't first!
@@ -651,6 +672,7 @@ namespace dmGameSystem
         const MeshComponent* component = (MeshComponent*) buf[*begin].m_UserData;
 
         FillRenderObject(ro, mr->m_PrimitiveType, material, mr->m_Textures, component->m_Textures, vert_decl, vert_buffer, 0, element_count, Matrix4::identity(), first->m_RenderConstants);
+        RequestTextureMips(world, ro);
         dmGraphics::SetVertexBufferData(vert_buffer, vert_size * element_count, world->m_WorldVertexData, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
         dmRender::AddToRender(render_context, &ro);
     }
@@ -660,7 +682,11 @@ namespace dmGameSystem
     {
         DM_PROFILE(Mesh, "RenderBatchLocal");
 
-        for (uint32_t *i=begin;i!=end;i++)
+        // With an instanced material, consecutive components sharing the vertices are drawn with
+        // one instanced draw call. The rest of the render state is the same for the whole batch.
+        bool instanced = dmRender::IsMaterialInstanced(material);
+
+        for (uint32_t *i=begin;i!=end;)
         {
             dmRender::RenderObject& ro = *world->m_RenderObjects.End();
             world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
@@ -707,7 +733,24 @@ namespace dmGameSystem
             world->m_RenderedVertexSize += vert_size * elem_count;
 
             FillRenderObject(ro, mr->m_PrimitiveType, material, mr->m_Textures, component->m_Textures, vert_decl, vertex_buffer, 0, elem_count, component->m_World, component->m_RenderConstants);
+            RequestTextureMips(world, ro);
+
+            uint32_t* run_end = i + 1;
+            if (instanced)
+            {
+                BeginInstances(&world->m_InstanceBuffer, &ro);
+                AddInstance(&world->m_InstanceBuffer, &ro, component->m_World);
+                for (; run_end != end; ++run_end)
+                {
+                    const MeshComponent* c = (MeshComponent*) buf[*run_end].m_UserData;
+                    if (GetVerticesBuffer(c, c->m_Resource) != br || GetVertexDeclaration(c) != vert_decl)
+                        break;
+                    AddInstance(&world->m_InstanceBuffer, &ro, c->m_World);
+                }
+            }
+
             dmRender::AddToRender(render_context, &ro);
+            i = run_end;
         }
     }
 
@@ -743,6 +786,7 @@ namespace dmGameSystem
             {
                 world->m_RenderedVertexSize = 0;
                 world->m_RenderObjects.SetSize(0);
+                world->m_InstanceBuffer.m_Data.SetSize(0);
 
                 if (world->m_VertexBufferPool.Capacity() < world->m_VertexBufferPool.Size()+world->m_VertexBufferWorld.Size())
                     world->m_VertexBufferPool.OffsetCapacity(world->m_VertexBufferWorld.Size());
@@ -757,6 +801,7 @@ namespace dmGameSystem
             }
             case dmRender::RENDER_LIST_OPERATION_END:
             {
+                world->m_RenderedVertexSize += UploadInstanceBuffer(&world->m_InstanceBuffer);
                 DM_COUNTER("MeshVertexBuffer", world->m_RenderedVertexSize);
                 break;
             }
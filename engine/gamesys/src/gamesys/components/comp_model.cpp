@@ -36,6 +36,7 @@
 #include "../resources/res_skeleton.h"
 #include "../resources/res_animationset.h"
 #include "../resources/res_meshset.h"
+#include "../resources/res_texture.h"
 #include "comp_private.h"
 
 #include <gamesys/gamesys_ddf.h>
@@ -80,9 +81,13 @@ namespace dmGameSystem
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
         dmGraphics::HVertexBuffer*      m_VertexBuffers;
         dmArray<dmRig::RigModelVertex>* m_VertexBufferData;
+        InstanceBuffer                  m_InstanceBuffer;
         // Temporary scratch array for instances, only used during the creation phase of components
         dmArray<dmGameObject::HInstance> m_ScratchInstances;
+        // Temporary scratch array for the rig instances of a render batch
+        dmArray<dmRig::GenerateVertexDataParams> m_ScratchSkinParams;
         dmRig::HRigContext              m_RigContext;
+        HTextureStreamer                m_TextureStreamer;
         uint32_t                        m_MaxElementsVertices;
         uint32_t                        m_VertexBufferSwapChainIndex;
         uint32_t                        m_VertexBufferSwapChainSize;
@@ -109,6 +114,7 @@ namespace dmGameSystem
         dmRig::NewContextParams rig_params = {0};
         rig_params.m_Context = &world->m_RigContext;
         rig_params.m_MaxRigInstanceCount = context->m_MaxModelCount;
+        rig_params.m_PoseCache = context->m_PoseCache;
         dmRig::Result rr = dmRig::NewContext(rig_params);
         if (rr != dmRig::RESULT_OK)
         {
@@ -118,6 +124,7 @@ namespace dmGameSystem
 
         world->m_Components.SetCapacity(context->m_MaxModelCount);
         world->m_RenderObjects.SetCapacity(context->m_MaxModelCount);
+        world->m_TextureStreamer = context->m_TextureStreamer;
 
         dmGraphics::VertexElement ve[] =
         {
@@ -134,6 +141,7 @@ namespace dmGameSystem
         {
             world->m_VertexBuffers[i] = dmGraphics::NewVertexBuffer(graphics_context, 0, 0x0, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
         }
+        NewInstanceBuffer(graphics_context, &world->m_InstanceBuffer);
 
         *params.m_World = world;
 
@@ -150,6 +158,7 @@ namespace dmGameSystem
         {
             dmGraphics::DeleteVertexBuffer(world->m_VertexBuffers[i]);
         }
+        DeleteInstanceBuffer(&world->m_InstanceBuffer);
 
         dmResource::UnregisterResourceReloadedCallback(((ModelContext*)params.m_Context)->m_Factory, ResourceReloadedCallback, world);
 
@@ -463,7 +472,12 @@ namespace dmGameSystem
     {
         DM_PROFILE(Model, "RenderBatchLocal");
 
-        for (uint32_t *i=begin;i!=end;i++)
+        // Material, textures and render constants are the same for the whole batch. With an instanced
+        // material, consecutive components sharing the geometry are drawn with one instanced draw call.
+        const ModelComponent* first = (ModelComponent*) buf[*begin].m_UserData;
+        bool instanced = dmRender::IsMaterialInstanced(GetMaterial(first, first->m_Resource));
+
+        for (uint32_t *i=begin;i!=end;)
         {
             dmRender::RenderObject& ro = *world->m_RenderObjects.End();
             world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
@@ -472,6 +486,15 @@ namespace dmGameSystem
             const ModelResource* mr = component->m_Resource;
             assert(mr->m_VertexBuffer);
 
+            uint32_t* run_end = i + 1;
+            if (instanced)
+            {
+                while (run_end != end && ((ModelComponent*) buf[*run_end].m_UserData)->m_Resource->m_VertexBuffer == mr->m_VertexBuffer)
+                {
+                    ++run_end;
+                }
+            }
+
             ro.Init();
             ro.m_VertexDeclaration = world->m_VertexDeclaration;
             ro.m_VertexBuffer = mr->m_VertexBuffer;
@@ -496,7 +519,17 @@ namespace dmGameSystem
                 dmGameSystem::EnableRenderObjectConstants(&ro, component->m_RenderConstants);
             }
 
+            if (instanced)
+            {
+                BeginInstances(&world->m_InstanceBuffer, &ro);
+                for (uint32_t *j=i;j!=run_end;j++)
+                {
+                    AddInstance(&world->m_InstanceBuffer, &ro, ((ModelComponent*) buf[*j].m_UserData)->m_World);
+                }
+            }
+
             dmRender::AddToRender(render_context, &ro);
+            i = run_end;
         }
     }
 
@@ -529,17 +562,26 @@ namespace dmGameSystem
 
         dmGraphics::HVertexBuffer& gfx_vertex_buffer = world->m_VertexBuffers[batchIndex];
 
-        // Fill in vertex buffer
+        // Fill in vertex buffer, each component at its own offset so that the whole batch is skinned at once
         dmRig::RigModelVertex *vb_begin = vertex_buffer.End();
         dmRig::RigModelVertex *vb_end = vb_begin;
+        dmArray<dmRig::GenerateVertexDataParams>& skin_params = world->m_ScratchSkinParams;
+        skin_params.SetSize(0);
+        if (skin_params.Capacity() < (uint32_t)(end - begin))
+            skin_params.SetCapacity(end - begin);
         for (uint32_t *i=begin;i!=end;i++)
         {
             const ModelComponent* c = (ModelComponent*) buf[*i].m_UserData;
-            dmRig::HRigContext rig_context = world->m_RigContext;
-            Matrix4 normal_matrix = inverse(c->m_World);
-            normal_matrix = transpose(normal_matrix);
-            vb_end = (dmRig::RigModelVertex *)dmRig::GenerateVertexData(rig_context, c->m_RigInstance, c->m_World, normal_matrix, Vector4(1.0), dmRig::RIG_VERTEX_FORMAT_MODEL, (void*)vb_end);
+            dmRig::GenerateVertexDataParams params;
+            params.m_ModelMatrix = c->m_World;
+            params.m_NormalMatrix = transpose(inverse(c->m_World));
+            params.m_Color = Vector4(1.0);
+            params.m_Instance = c->m_RigInstance;
+            params.m_VertexDataOut = (void*)vb_end;
+            skin_params.Push(params);
+            vb_end += dmRig::GetVertexCount(c->m_RigInstance);
         }
+        dmRig::GenerateVertexDataBatch(world->m_RigContext, dmRig::RIG_VERTEX_FORMAT_MODEL, skin_params.Begin(), skin_params.Size());
         vertex_buffer.SetSize(vb_end - vertex_buffer.Begin());
 
         // Ninja in-place writing of render object.
@@ -567,10 +609,43 @@ namespace dmGameSystem
         dmRender::AddToRender(render_context, &ro);
     }
 
+    // Request the texture mips needed by the models, from the size of their bounding spheres on screen
+    static void RequestTextureMips(ModelWorld* world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    {
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        float width = (float) dmGraphics::GetWindowWidth(graphics_context);
+        float height = (float) dmGraphics::GetWindowHeight(graphics_context);
+        const Matrix4& view_proj = dmRender::GetViewProjectionMatrix(render_context);
+
+        for (uint32_t *i = begin; i != end; ++i)
+        {
+            const ModelComponent* component = (ModelComponent*) buf[*i].m_UserData;
+            const ModelResource* resource = component->m_Resource;
+            Matrix4 extent = component->m_World * Matrix4::scale(Vector3(2.0f * resource->m_BoundingRadius));
+            for (uint32_t t = 0; t < MAX_TEXTURE_COUNT; ++t)
+            {
+                dmGraphics::HTexture texture = GetTexture(component, resource, t);
+                if (!texture || !IsTextureStreamed(world->m_TextureStreamer, texture))
+                    continue;
+                // Without a radius, the size on screen is unknown
+                uint32_t mip = 0;
+                if (resource->m_BoundingRadius > 0.0f)
+                {
+                    mip = GetRequiredTextureMip(view_proj, width, height, extent,
+                                                (float) dmGraphics::GetOriginalTextureWidth(texture), (float) dmGraphics::GetOriginalTextureHeight(texture));
+                }
+                RequestTextureMip(world->m_TextureStreamer, texture, mip);
+            }
+        }
+    }
+
     static void RenderBatch(ModelWorld* world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
     {
         DM_PROFILE(Model, "RenderBatch");
 
+        if (world->m_TextureStreamer)
+            RequestTextureMips(world, render_context, buf, begin, end);
+
         const ModelComponent* first = (ModelComponent*) buf[*begin].m_UserData;
         dmRender::HMaterial material = first->m_Resource->m_Material;
         switch(dmRender::GetMaterialVertexSpace(material))
@@ -670,6 +745,7 @@ namespace dmGameSystem
                 {
                     world->m_VertexBufferData[batch_index].SetSize(0);
                 }
+                world->m_InstanceBuffer.m_Data.SetSize(0);
                 break;
             }
             case dmRender::RENDER_LIST_OPERATION_BATCH:
@@ -692,6 +768,7 @@ namespace dmGameSystem
                     dmGraphics::SetVertexBufferData(gfx_vertex_buffer, vb_size, vertex_buffer_data.Begin(), dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
                     total_size += vb_size;
                 }
+                total_size += UploadInstanceBuffer(&world->m_InstanceBuffer);
                 DM_COUNTER("ModelVertexBuffer", total_size);
                 break;
             }
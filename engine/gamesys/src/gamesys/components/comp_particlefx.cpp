@@ -30,6 +30,7 @@
 #include "../gamesys_private.h"
 
 #include "resources/res_particlefx.h"
+#include "resources/res_texture.h"
 #include "resources/res_textureset.h"
 
 namespace dmGameSystem
@@ -66,6 +67,7 @@ namespace dmGameSystem
         ParticleFXContext* m_Context;
         dmParticle::HParticleContext m_ParticleContext;
         dmGraphics::HVertexBuffer m_VertexBuffer;
+        // Allocated from the render frame arena on the first batch of a draw call
         dmArray<dmParticle::Vertex> m_VertexBufferData;
         dmGraphics::HVertexDeclaration m_VertexDeclaration;
         uint32_t m_EmitterCount;
@@ -89,7 +91,6 @@ namespace dmGameSystem
         world->m_PrototypeIndices.SetCapacity(particle_fx_count);
         uint32_t buffer_size = dmParticle::GetVertexBufferSize(ctx->m_MaxParticleCount, dmParticle::PARTICLE_GO);
         world->m_VertexBuffer = dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(ctx->m_RenderContext), buffer_size, 0x0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
-        world->m_VertexBufferData.SetCapacity(ctx->m_MaxParticleCount * 6);
         world->m_WarnOutOfROs = 0;
         world->m_EmitterCount = 0;
         dmGraphics::VertexElement ve[] =
@@ -229,6 +230,10 @@ namespace dmGameSystem
         dmParticle::HParticleContext particle_context = pfx_world->m_ParticleContext;
 
         dmArray<dmParticle::Vertex> &vertex_buffer = pfx_world->m_VertexBufferData;
+        if (vertex_buffer.Capacity() == 0)
+        {
+            dmArenaAllocator::SetCapacity(dmRender::GetFrameArena(render_context), vertex_buffer, pfx_context->m_MaxParticleCount * 6);
+        }
         dmParticle::Vertex* vb_begin = vertex_buffer.End();
         dmParticle::Vertex* vb_end = vb_begin;
 
@@ -253,6 +258,11 @@ namespace dmGameSystem
         ro.Init();
         ro.m_Material = (dmRender::HMaterial)first->m_Material;
         ro.m_Textures[0] = (dmGraphics::HTexture)first->m_Texture;
+        if (pfx_context->m_TextureStreamer && ro.m_Textures[0])
+        {
+            // The size of the particles on screen is not estimated
+            RequestTextureMip(pfx_context->m_TextureStreamer, ro.m_Textures[0], 0);
+        }
         ro.m_VertexStart = vb_begin - vertex_buffer.Begin();
         ro.m_VertexCount = ro_vertex_count;
         ro.m_VertexBuffer = pfx_world->m_VertexBuffer;
@@ -272,7 +282,9 @@ namespace dmGameSystem
         if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_BEGIN)
         {
             dmGraphics::SetVertexBufferData(pfx_world->m_VertexBuffer, 0, 0x0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
-            pfx_world->m_VertexBufferData.SetSize(0);
+            // Drop the storage from the previous draw call, it was released with the frame arena
+            dmArray<dmParticle::Vertex> empty;
+            pfx_world->m_VertexBufferData.Swap(empty);
             pfx_world->m_RenderObjects.SetSize(0);
         }
         else if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_BATCH)
@@ -13,6 +13,8 @@
 #include "comp_private.h"
 #include "resources/res_textureset.h"
 #include <dlib/log.h>
+#include <float.h>
+#include <math.h>
 
 using namespace Vectormath::Aos;
 namespace dmGameSystem
@@ -426,5 +428,78 @@ void EnableRenderObjectConstants(dmRender::RenderObject* ro, HComponentRenderCon
     }
 }
 
+void NewInstanceBuffer(dmGraphics::HContext graphics_context, InstanceBuffer* buffer)
+{
+    dmGraphics::VertexElement ve[] =
+    {
+        {"mtx_world", 0, 16, dmGraphics::TYPE_FLOAT, false},
+    };
+    buffer->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, ve, sizeof(ve) / sizeof(dmGraphics::VertexElement));
+    buffer->m_VertexBuffer = dmGraphics::NewVertexBuffer(graphics_context, 0, 0x0, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+}
+
+void DeleteInstanceBuffer(InstanceBuffer* buffer)
+{
+    dmGraphics::DeleteVertexBuffer(buffer->m_VertexBuffer);
+    dmGraphics::DeleteVertexDeclaration(buffer->m_VertexDeclaration);
+}
+
+void BeginInstances(InstanceBuffer* buffer, dmRender::RenderObject* ro)
+{
+    ro->m_InstanceVertexDeclaration = buffer->m_VertexDeclaration;
+    ro->m_InstanceVertexBuffer = buffer->m_VertexBuffer;
+    ro->m_InstanceBufferOffset = buffer->m_Data.Size() * sizeof(Matrix4);
+    ro->m_InstanceCount = 0;
+}
+
+void AddInstance(InstanceBuffer* buffer, dmRender::RenderObject* ro, const Matrix4& world)
+{
+    if (buffer->m_Data.Full())
+        buffer->m_Data.OffsetCapacity(dmMath::Max(64U, buffer->m_Data.Capacity() / 2));
+    buffer->m_Data.Push(world);
+    ro->m_InstanceCount++;
+}
+
+uint32_t UploadInstanceBuffer(InstanceBuffer* buffer)
+{
+    if (buffer->m_Data.Empty())
+        return 0;
+    uint32_t size = buffer->m_Data.Size() * sizeof(Matrix4);
+    dmGraphics::SetVertexBufferData(buffer->m_VertexBuffer, size, buffer->m_Data.Begin(), dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+    return size;
+}
+
+static float GetScreenLength(const Vector4& center, const Vector4& axis, float half_width, float half_height)
+{
+    // The projected axis relative to the projected center, i.e. the derivative of the perspective divide
+    float w = center.getW();
+    float x = (axis.getX() - center.getX() * axis.getW() / w) * half_width;
+    float y = (axis.getY() - center.getY() * axis.getW() / w) * half_height;
+    return sqrtf(x*x + y*y) / w;
+}
+
+uint32_t GetRequiredTextureMip(const Matrix4& view_proj, float viewport_width, float viewport_height, const Matrix4& world, float texels_x, float texels_y)
+{
+    Matrix4 m = view_proj * world;
+    Vector4 center = m.getCol3();
+    if (center.getW() <= 0.0001f)
+        return ~0u;
+
+    float half_width = viewport_width * 0.5f;
+    float half_height = viewport_height * 0.5f;
+    float pixels_x = GetScreenLength(center, m.getCol0(), half_width, half_height);
+    float pixels_y = GetScreenLength(center, m.getCol1(), half_width, half_height);
+
+    float ratio = 0.0f;
+    if (texels_x > 0.0f)
+        ratio = pixels_x > 0.0001f ? texels_x / pixels_x : FLT_MAX;
+    if (texels_y > 0.0f)
+        ratio = dmMath::Max(ratio, pixels_y > 0.0001f ? texels_y / pixels_y : FLT_MAX);
+    if (ratio <= 1.0f)
+        return 0;
+    if (ratio >= (float)(1u << 31))
+        return 31;
+    return (uint32_t)floorf(log2f(ratio));
+}
 
 }
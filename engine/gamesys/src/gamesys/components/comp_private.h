@@ -13,8 +13,10 @@
 #ifndef DM_GAMESYS_COMP_PRIVATE_H
 #define DM_GAMESYS_COMP_PRIVATE_H
 
+#include <dlib/array.h>
 #include <dlib/hash.h>
 #include <dlib/math.h>
+#include <graphics/graphics.h>
 #include <gameobject/gameobject.h>
 #include <render/render.h>
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
@@ -30,6 +32,35 @@ namespace dmGameSystem
 
     dmGameObject::PropertyResult GetProperty(dmGameObject::PropertyDesc& out_value, dmhash_t get_property, const Vectormath::Aos::Vector4& ref_value, const PropVector4& property);
     dmGameObject::PropertyResult SetProperty(dmhash_t set_property, const dmGameObject::PropertyVar& in_value, Vectormath::Aos::Vector4& set_value, const PropVector4& property);
+
+    /**
+     * Per instance world transforms of the instanced render objects of a component world, see dmRender::IsMaterialInstanced.
+     * Cleared when the render list dispatch begins and uploaded when it ends.
+     */
+    struct InstanceBuffer
+    {
+        dmGraphics::HVertexDeclaration      m_VertexDeclaration;
+        dmGraphics::HVertexBuffer           m_VertexBuffer;
+        dmArray<Vectormath::Aos::Matrix4>   m_Data;
+    };
+
+    void NewInstanceBuffer(dmGraphics::HContext graphics_context, InstanceBuffer* buffer);
+    void DeleteInstanceBuffer(InstanceBuffer* buffer);
+    /// Turn the render object into an instanced draw, with the instances added with AddInstance after this call
+    void BeginInstances(InstanceBuffer* buffer, dmRender::RenderObject* ro);
+    void AddInstance(InstanceBuffer* buffer, dmRender::RenderObject* ro, const Vectormath::Aos::Matrix4& world);
+    /// @return the uploaded size in bytes
+    uint32_t UploadInstanceBuffer(InstanceBuffer* buffer);
+
+    /**
+     * Estimate the texture mip needed to draw a quad without minification, from its size on screen.
+     * The world transform maps the unit quad centered at the origin to the quad in world space.
+     * @param texels_x number of texels across the x axis of the quad at mip 0
+     * @param texels_y number of texels across the y axis of the quad at mip 0
+     * @return the mip, 0 being the full resolution, or ~0u when the quad is behind the camera
+     */
+    uint32_t GetRequiredTextureMip(const Vectormath::Aos::Matrix4& view_proj, float viewport_width, float viewport_height,
+                                   const Vectormath::Aos::Matrix4& world, float texels_x, float texels_y);
 }
 
 #endif // DM_GAMESYS_COMP_PRIVATE_H
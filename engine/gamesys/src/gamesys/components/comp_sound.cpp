@@ -384,6 +384,7 @@ namespace dmGameSystem
                     if (result != dmSound::RESULT_OK) {
                         dmLogError("Failed to set sound group (%d)", result);
                     }
+                    dmSound::SetPriority(entry.m_SoundInstance, sound->m_Priority);
 
                     float gain = play_sound->m_Gain * component->m_Gain;
                     float pan = play_sound->m_Pan + component->m_Pan;
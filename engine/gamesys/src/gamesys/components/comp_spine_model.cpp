@@ -37,6 +37,7 @@
 #include "../resources/res_skeleton.h"
 #include "../resources/res_meshset.h"
 #include "../resources/res_animationset.h"
+#include "../resources/res_texture.h"
 #include "../resources/res_textureset.h"
 
 #include <gamesys/spine_ddf.h>
@@ -67,7 +68,9 @@ namespace dmGameSystem
         dmResource::HFactory        m_Factory;
         dmRender::HRenderContext    m_RenderContext;
         dmGraphics::HContext        m_GraphicsContext;
+        HTextureStreamer            m_TextureStreamer;
         uint32_t                    m_MaxSpineModelCount;
+        uint32_t                    m_PoseCache : 1;
     };
 
     // Translation table to translate from dmGameObject playback mode into dmRig playback mode.
@@ -95,6 +98,7 @@ namespace dmGameSystem
         dmRig::NewContextParams rig_params = {0};
         rig_params.m_Context = &world->m_RigContext;
         rig_params.m_MaxRigInstanceCount = context->m_MaxSpineModelCount;
+        rig_params.m_PoseCache = context->m_PoseCache;
         dmRig::Result rr = dmRig::NewContext(rig_params);
         if (rr != dmRig::RESULT_OK)
         {
@@ -104,6 +108,7 @@ namespace dmGameSystem
 
         world->m_Components.SetCapacity(context->m_MaxSpineModelCount);
         world->m_RenderObjects.SetCapacity(context->m_MaxSpineModelCount);
+        world->m_TextureStreamer = context->m_TextureStreamer;
 
         dmGraphics::VertexElement ve[] =
         {
@@ -463,15 +468,26 @@ namespace dmGameSystem
         if (vertex_buffer.Remaining() < vertex_count)
             vertex_buffer.OffsetCapacity(vertex_count - vertex_buffer.Remaining());
 
-        // Fill in vertex buffer
+        // Fill in vertex buffer, each component at its own offset so that the whole batch is skinned at once
         dmRig::RigSpineModelVertex *vb_begin = vertex_buffer.End();
         dmRig::RigSpineModelVertex *vb_end = vb_begin;
-        dmRig::HRigContext rig_context = world->m_RigContext;
+        dmArray<dmRig::GenerateVertexDataParams>& skin_params = world->m_ScratchSkinParams;
+        skin_params.SetSize(0);
+        if (skin_params.Capacity() < (uint32_t)(end - begin))
+            skin_params.SetCapacity(end - begin);
         for (uint32_t *i=begin;i!=end;i++)
         {
             const SpineModelComponent* c = (SpineModelComponent*) buf[*i].m_UserData;
-            vb_end = (dmRig::RigSpineModelVertex*)dmRig::GenerateVertexData(rig_context, c->m_RigInstance, c->m_World, Matrix4::identity(), Vector4(1.0), dmRig::RIG_VERTEX_FORMAT_SPINE, (void*)vb_end);
+            dmRig::GenerateVertexDataParams params;
+            params.m_ModelMatrix = c->m_World;
+            params.m_NormalMatrix = Matrix4::identity();
+            params.m_Color = Vector4(1.0);
+            params.m_Instance = c->m_RigInstance;
+            params.m_VertexDataOut = (void*)vb_end;
+            skin_params.Push(params);
+            vb_end += dmRig::GetVertexCount(c->m_RigInstance);
         }
+        dmRig::GenerateVertexDataBatch(world->m_RigContext, dmRig::RIG_VERTEX_FORMAT_SPINE, skin_params.Begin(), skin_params.Size());
         vertex_buffer.SetSize(vb_end - vertex_buffer.Begin());
 
         // Ninja in-place writing of render object.
@@ -485,6 +501,10 @@ namespace dmGameSystem
         ro.m_VertexStart = vb_begin - vertex_buffer.Begin();
         ro.m_VertexCount = vb_end - vb_begin;
         ro.m_Textures[0] = resource->m_RigScene->m_TextureSet->m_Texture;
+        if (world->m_TextureStreamer)
+        {
+            RequestTextureMip(world->m_TextureStreamer, ro.m_Textures[0], 0);
+        }
         ro.m_Material = GetMaterial(first, resource);
 
         if (first->m_RenderConstants) {
@@ -973,9 +993,12 @@ namespace dmGameSystem
         spinemodelctx->m_Factory = ctx->m_Factory;
         spinemodelctx->m_GraphicsContext = *(dmGraphics::HContext*)ctx->m_Contexts.Get(dmHashString64("graphics"));
         spinemodelctx->m_RenderContext = *(dmRender::HRenderContext*)ctx->m_Contexts.Get(dmHashString64("render"));
+        void* const* texture_streamer = ctx->m_Contexts.Get(dmHashString64("texture_streamer"));
+        spinemodelctx->m_TextureStreamer = texture_streamer ? (HTextureStreamer) *texture_streamer : 0;
 
         int32_t max_rig_instance = max_rig_instance = dmConfigFile::GetInt(ctx->m_Config, "rig.max_instance_count", 128);
         spinemodelctx->m_MaxSpineModelCount = dmMath::Max(dmConfigFile::GetInt(ctx->m_Config, "spine.max_count", 128), max_rig_instance);
+        spinemodelctx->m_PoseCache = dmConfigFile::GetInt(ctx->m_Config, "spine.pose_cache", 0) != 0;
 
         // Ideally, we'd like to move this priority a lot earlier
         // We sould be able to avoid doing UpdateTransforms again in the Render() function
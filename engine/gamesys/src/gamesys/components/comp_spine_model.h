@@ -29,6 +29,8 @@ namespace dmGameSystem
 {
     using namespace Vectormath::Aos;
 
+    struct TextureStreamer;
+
     dmGameObject::CreateResult CompSpineModelNewWorld(const dmGameObject::ComponentNewWorldParams& params);
 
     dmGameObject::CreateResult CompSpineModelDeleteWorld(const dmGameObject::ComponentDeleteWorldParams& params);
@@ -86,7 +88,10 @@ namespace dmGameSystem
         dmArray<dmRig::RigSpineModelVertex> m_VertexBufferData;
         // Temporary scratch array for instances, only used during the creation phase of components
         dmArray<dmGameObject::HInstance>    m_ScratchInstances;
+        // Temporary scratch array for the rig instances of a render batch
+        dmArray<dmRig::GenerateVertexDataParams> m_ScratchSkinParams;
         dmRig::HRigContext                  m_RigContext;
+        TextureStreamer*                    m_TextureStreamer;
     };
 
     bool CompSpineModelSetIKTargetInstance(SpineModelComponent* component, dmhash_t constraint_id, float mix, dmhash_t instance_id);
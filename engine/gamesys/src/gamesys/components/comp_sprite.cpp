@@ -29,6 +29,7 @@
 #include <gameobject/gameobject_ddf.h>
 
 #include "../resources/res_sprite.h"
+#include "../resources/res_texture.h"
 #include "../gamesys.h"
 #include "../gamesys_private.h"
 #include "comp_private.h"
@@ -92,6 +93,7 @@ namespace dmGameSystem
         dmObjectPool<SpriteComponent>   m_Components;
         dmArray<dmRender::RenderObject*> m_RenderObjects;
         uint32_t                        m_RenderObjectsInUse;
+        HTextureStreamer                m_TextureStreamer;
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
         dmGraphics::HVertexBuffer       m_VertexBuffer;
         SpriteVertex*                   m_VertexBufferData;
@@ -180,6 +182,7 @@ namespace dmGameSystem
         sprite_world->m_Components.SetCapacity(sprite_context->m_MaxSpriteCount);
         memset(sprite_world->m_Components.m_Objects.Begin(), 0, sizeof(SpriteComponent) * sprite_context->m_MaxSpriteCount);
         sprite_world->m_RenderObjectsInUse = 0;
+        sprite_world->m_TextureStreamer = sprite_context->m_TextureStreamer;
 
         dmGraphics::VertexElement ve[] =
         {
@@ -562,6 +565,23 @@ namespace dmGameSystem
         *ib_where = indices;
     }
 
+    // The texture mip needed by the largest sprite on screen
+    static uint32_t GetRequiredTextureMip(dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    {
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        float width = (float) dmGraphics::GetWindowWidth(graphics_context);
+        float height = (float) dmGraphics::GetWindowHeight(graphics_context);
+        const Matrix4& view_proj = dmRender::GetViewProjectionMatrix(render_context);
+
+        uint32_t mip = ~0u;
+        for (uint32_t *i = begin; i != end && mip > 0; ++i)
+        {
+            const SpriteComponent* component = (SpriteComponent*) buf[*i].m_UserData;
+            mip = dmMath::Min(mip, dmGameSystem::GetRequiredTextureMip(view_proj, width, height, component->m_World, component->m_Size.getX(), component->m_Size.getY()));
+        }
+        return mip;
+    }
+
     static void RenderBatch(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
     {
         DM_PROFILE(Sprite, "RenderBatch");
@@ -572,6 +592,11 @@ namespace dmGameSystem
         SpriteResource* resource = first->m_Resource;
         TextureSetResource* texture_set = GetTextureSet(first, resource);
 
+        if (sprite_world->m_TextureStreamer && IsTextureStreamed(sprite_world->m_TextureStreamer, texture_set->m_Texture))
+        {
+            RequestTextureMip(sprite_world->m_TextureStreamer, texture_set->m_Texture, GetRequiredTextureMip(render_context, buf, begin, end));
+        }
+
         // Although we generally like to preallocate it, we cannot since we
         // 1) don't want to preallocate max_sprite number of render objects and
         // 2) We cannot keep the render object in a (small) fixed array and then reallocate it, since we pass the pointer to the render engine
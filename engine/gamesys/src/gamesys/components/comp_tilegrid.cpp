@@ -33,11 +33,18 @@
 #include "../gamesys_private.h"
 #include <gamesys/tile_ddf.h>
 #include <gamesys/physics_ddf.h>
+#include "../resources/res_texture.h"
 #include "../resources/res_tilegrid.h"
 
 namespace dmGameSystem
 {
     const uint32_t TILEGRID_REGION_SIZE = 32;
+    const uint32_t TILEGRID_REGION_MAX_VERTICES = 6 * TILEGRID_REGION_SIZE * TILEGRID_REGION_SIZE;
+    // Max number of views the regions are culled against. With more views the regions aren't culled.
+    const uint32_t TILEGRID_MAX_CULL_VIEWS = 4;
+    // Scales the clip space bounds the regions are culled against, which keeps the regions
+    // a quarter of the view outside each edge
+    const float TILEGRID_CULL_SCALE = 1.5f;
 
     using namespace Vectormath::Aos;
 
@@ -56,6 +63,40 @@ namespace dmGameSystem
         uint8_t :7;
     };
 
+    struct TileGridVertex
+    {
+        float x, y, z, u, v;
+    };
+
+    // The vertices of one layer in a region, within the buffer of the layer
+    struct TileGridRegionLayer
+    {
+        uint32_t m_VertexStart;
+        uint16_t m_VertexCount;
+        uint8_t  m_Dirty:1;     // The tiles changed since the vertices were created
+        uint8_t  m_Packed:1;    // The vertices are in the layer buffer
+        uint8_t  :6;
+    };
+
+    // The vertices of the regions of a layer that are in or near the view, packed in region order so that
+    // the layer is drawn with one draw call. A copy of the vertices is kept, so that the buffer can be
+    // repacked as the view moves without creating the vertices of the regions already in it again.
+    struct TileGridLayerBuffer
+    {
+        TileGridLayerBuffer()
+        : m_VertexBuffer(0)
+        , m_Repack(0)
+        {
+        }
+
+        dmArray<TileGridVertex>     m_Vertices;
+        dmArray<uint32_t>           m_Regions;      // The regions packed in the buffer
+        dmArray<uint32_t>           m_NextRegions;  // The regions to pack, collected when the tile grid is submitted
+        dmGraphics::HVertexBuffer   m_VertexBuffer;
+        uint8_t                     m_Repack:1;
+        uint8_t                     :7;
+    };
+
     struct TileGridComponent
     {
         struct Flags
@@ -73,6 +114,7 @@ namespace dmGameSystem
         , m_Material(0)
         , m_TextureSet(0)
         , m_Resource(0)
+        , m_TextureSetDDF(0)
         {
         }
 
@@ -84,22 +126,22 @@ namespace dmGameSystem
         Flags*                      m_CellFlags;
         dmArray<TileGridRegion>     m_Regions;
         dmArray<TileGridLayer>      m_Layers;
+        dmArray<TileGridRegionLayer> m_RegionLayers; // region_index * layer_count + layer
+        dmArray<TileGridLayerBuffer*> m_LayerBuffers;
         uint32_t                    m_MixedHash;
         HComponentRenderConstants   m_RenderConstants;
         dmRender::HMaterial         m_Material;
         TextureSetResource*         m_TextureSet;
         TileGridResource*           m_Resource;
+        // The texture set the region buffers were built with, changed by a property or a reload
+        dmGameSystemDDF::TextureSet* m_TextureSetDDF;
         uint16_t                    m_RegionsX; // number of regions in the x dimension
         uint16_t                    m_RegionsY; // number of regions in the y dimension
         uint16_t                    m_Occupied; // Number of occupied regions (regions with visible tiles)
         uint8_t                     m_Enabled : 1;
         uint8_t                     m_AddedToUpdate : 1;
-        uint8_t                     : 6;
-    };
-
-    struct TileGridVertex
-    {
-        float x, y, z, u, v;
+        uint8_t                     m_LocalSpace : 1; // The vertices are in local space, and transformed when drawn
+        uint8_t                     : 5;
     };
 
     struct TileGridWorld
@@ -110,14 +152,31 @@ namespace dmGameSystem
         }
 
         dmRender::HRenderContext        m_RenderContext;
+        HTextureStreamer                m_TextureStreamer;
         dmArray<TileGridComponent*>     m_Components;
         dmArray<dmRender::RenderObject> m_RenderObjects;
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
 
-        dmGraphics::HVertexBuffer       m_VertexBuffer;
+        // Scratch memory for building the vertices of one region layer
         TileGridVertex*                 m_VertexBufferData;
-        TileGridVertex*                 m_VertexBufferDataEnd;
-        TileGridVertex*                 m_VertexBufferWritePtr;
+        // Scratch memory for repacking a layer buffer
+        dmArray<TileGridVertex>         m_PackVertices;
+        // Scratch memory for culling the regions
+        dmArray<uint8_t>                m_CornerMasks;
+
+        // The views the tiles have been drawn with since the tile grids were submitted
+        Matrix4                         m_DrawViewProjs[TILEGRID_MAX_CULL_VIEWS];
+        uint32_t                        m_DrawViewProjCount;
+        // The views the regions are culled against when submitted
+        Matrix4                         m_CullViewProjs[TILEGRID_MAX_CULL_VIEWS];
+        uint32_t                        m_CullViewProjCount;
+        uint8_t                         m_DrawViewProjOverflow : 1;
+        uint8_t                         m_CullDisabled : 1;
+        uint8_t                         : 6;
+
+        uint32_t                        m_TileCount;    // Tiles drawn by the current draw call
+        uint32_t                        m_UploadSize;   // Bytes of vertex data uploaded by the current draw call
+        uint32_t                        m_BuildCount;   // Region layers created by the current draw call
 
         uint32_t                        m_MaxTilemapCount;
         uint32_t                        m_MaxTileCount;
@@ -136,10 +195,8 @@ namespace dmGameSystem
                 {"texcoord0", 1, 2, dmGraphics::TYPE_FLOAT, false},
         };
         world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, ve, sizeof(ve) / sizeof(ve[0]));
-        world->m_VertexBuffer = dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(world->m_RenderContext), 0, 0x0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
-        uint32_t vcount = 6 * world->m_MaxTileCount;
+        uint32_t vcount = 6 * TILEGRID_REGION_SIZE * TILEGRID_REGION_SIZE;
         world->m_VertexBufferData = (TileGridVertex*) malloc(sizeof(TileGridVertex) * vcount);
-        world->m_VertexBufferDataEnd = world->m_VertexBufferData + vcount;
     }
 
     dmGameObject::CreateResult CompTileGridNewWorld(const dmGameObject::ComponentNewWorldParams& params)
@@ -147,6 +204,7 @@ namespace dmGameSystem
         TileGridWorld* world = new TileGridWorld;
         TilemapContext* context = (TilemapContext*)params.m_Context;
         world->m_RenderContext = context->m_RenderContext;
+        world->m_TextureStreamer = context->m_TextureStreamer;
 
         world->m_MaxTilemapCount = context->m_MaxTilemapCount;
         world->m_MaxTileCount = context->m_MaxTileCount;
@@ -165,7 +223,6 @@ namespace dmGameSystem
         if (world->m_VertexDeclaration)
         {
             dmGraphics::DeleteVertexDeclaration(world->m_VertexDeclaration);
-            dmGraphics::DeleteVertexBuffer(world->m_VertexBuffer);
             free(world->m_VertexBufferData);
         }
         delete world;
@@ -214,13 +271,38 @@ namespace dmGameSystem
         layer->m_IsVisible = visible;
     }
 
-    static void SetRegionDirty(TileGridComponent* component, int32_t cell_x, int32_t cell_y)
+    static void SetRegionDirty(TileGridComponent* component, uint32_t layer, int32_t cell_x, int32_t cell_y)
     {
         uint32_t region_x = cell_x / TILEGRID_REGION_SIZE;
         uint32_t region_y = cell_y / TILEGRID_REGION_SIZE;
         uint32_t region_index = region_y * component->m_RegionsX + region_x;
         TileGridRegion* region = &component->m_Regions[region_index];
         region->m_Dirty = 1;
+        component->m_RegionLayers[region_index * component->m_Layers.Size() + layer].m_Dirty = 1;
+    }
+
+    static void SetRegionLayersDirty(TileGridComponent* component)
+    {
+        uint32_t n = component->m_RegionLayers.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            component->m_RegionLayers[i].m_Dirty = 1;
+        }
+    }
+
+    static void DeleteLayerBuffers(TileGridComponent* component)
+    {
+        uint32_t n = component->m_LayerBuffers.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            TileGridLayerBuffer* layer_buffer = component->m_LayerBuffers[i];
+            if (layer_buffer->m_VertexBuffer)
+            {
+                dmGraphics::DeleteVertexBuffer(layer_buffer->m_VertexBuffer);
+            }
+            delete layer_buffer;
+        }
+        component->m_LayerBuffers.SetSize(0);
     }
 
     void SetTileGridTile(TileGridComponent* component, uint32_t layer, int32_t cell_x, int32_t cell_y, uint32_t tile, bool flip_h, bool flip_v)
@@ -233,7 +315,7 @@ namespace dmGameSystem
         flags->m_FlipHorizontal = flip_h;
         flags->m_FlipVertical = flip_v;
 
-        SetRegionDirty(component, cell_x, cell_y);
+        SetRegionDirty(component, layer, cell_x, cell_y);
     }
 
     uint16_t GetTileCount(const TileGridComponent* component) {
@@ -267,6 +349,20 @@ namespace dmGameSystem
         component->m_Regions.SetCapacity(region_count);
         component->m_Regions.SetSize(region_count);
         memset(&component->m_Regions[0], 0xFF, region_count * sizeof(TileGridRegion)); // mark them all dirty
+
+        uint32_t layer_count = component->m_Layers.Size();
+        uint32_t region_layer_count = region_count * layer_count;
+        component->m_RegionLayers.SetCapacity(region_layer_count);
+        component->m_RegionLayers.SetSize(region_layer_count);
+        memset(component->m_RegionLayers.Begin(), 0, region_layer_count * sizeof(TileGridRegionLayer));
+        SetRegionLayersDirty(component);
+
+        DeleteLayerBuffers(component);
+        component->m_LayerBuffers.SetCapacity(layer_count);
+        for (uint32_t i = 0; i < layer_count; ++i)
+        {
+            component->m_LayerBuffers.Push(new TileGridLayerBuffer);
+        }
     }
 
     static uint32_t UpdateRegion(TileGridComponent* component, uint32_t region_x, uint32_t region_y)
@@ -430,6 +526,7 @@ namespace dmGameSystem
 
                 delete [] tile_grid->m_Cells;
                 delete [] tile_grid->m_CellFlags;
+                DeleteLayerBuffers(tile_grid);
 
                 if (tile_grid->m_RenderConstants)
                 {
@@ -479,32 +576,53 @@ namespace dmGameSystem
 
             Matrix4 local(component->m_Rotation, component->m_Translation);
             const Matrix4& go_world = dmGameObject::GetWorldMatrix(component->m_Instance);
+            Matrix4 world_matrix;
             if (dmGameObject::ScaleAlongZ(component->m_Instance))
             {
-                component->m_World = go_world * local;
+                world_matrix = go_world * local;
             }
             else
             {
-                component->m_World = dmTransform::MulNoScaleZ(go_world, local);
+                world_matrix = dmTransform::MulNoScaleZ(go_world, local);
+            }
+
+            // Materials in local vertex space are given the world transform when drawn, so only the
+            // vertices in world space need to be created again when the tile grid moves
+            bool local_space = dmRender::GetMaterialVertexSpace(GetMaterial(component)) == dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL;
+            bool world_changed = memcmp(&world_matrix, &component->m_World, sizeof(world_matrix)) != 0;
+            dmGameSystemDDF::TextureSet* texture_set_ddf = GetTextureSet(component)->m_TextureSet;
+            component->m_World = world_matrix;
+            if ((world_changed && !local_space) || local_space != component->m_LocalSpace || texture_set_ddf != component->m_TextureSetDDF)
+            {
+                component->m_LocalSpace = local_space;
+                component->m_TextureSetDDF = texture_set_ddf;
+                SetRegionLayersDirty(component);
             }
         }
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
-    static inline uint64_t EncodeRegionInfo(uint32_t tile_grid, uint32_t layer, uint32_t region_x, uint32_t region_y)
+    static inline uint64_t EncodeGridAndLayer(uint32_t tile_grid, uint32_t layer)
     {
-        return (uint64_t)( (tile_grid & 0xFFFF) | ((layer & 0xFFFF) << 16) | ((uint64_t)region_x << 32) | ((uint64_t)region_y << 48) );
+        return (uint64_t)( (tile_grid & 0xFFFF) | ((layer & 0xFFFF) << 16) );
     }
 
-    static inline void DecodeGridAndLayer(uint64_t ptr, uint32_t& tile_grid, uint32_t& layer, uint32_t& region_x, uint32_t& region_y)
+    static inline void DecodeGridAndLayer(uint64_t ptr, uint32_t& tile_grid, uint32_t& layer)
     {
         tile_grid = ptr & 0xFFFF;
         layer = (ptr >> 16) & 0xFFFF;
-        region_x = (ptr >> 32) & 0xFFFF;
-        region_y = (ptr >> 48) & 0xFFFF;
     }
 
-    TileGridVertex* CreateVertexData(TileGridWorld* world, TileGridVertex* where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    static inline void GetRegionCellBounds(const TileGridResource* resource, uint32_t region_x, uint32_t region_y, int32_t& min_x, int32_t& min_y, int32_t& max_x, int32_t& max_y)
+    {
+        min_x = resource->m_MinCellX + region_x * TILEGRID_REGION_SIZE;
+        min_y = resource->m_MinCellY + region_y * TILEGRID_REGION_SIZE;
+        max_x = dmMath::Min(min_x + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellX + (int32_t)resource->m_ColumnCount);
+        max_y = dmMath::Min(min_y + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellY + (int32_t)resource->m_RowCount);
+    }
+
+    // Creates the vertices of one layer in a region, in local or world space, returns the vertex count
+    static uint32_t CreateVertexData(TileGridVertex* where, const TileGridComponent* component, uint32_t layer, uint32_t region_x, uint32_t region_y)
     {
         DM_PROFILE(TileGrid, "CreateVertexData");
         static int tex_coord_order[] = {
@@ -514,146 +632,271 @@ namespace dmGameSystem
             2,3,0,0,1,2     //hv
         };
 
-        dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
+        dmGameSystemDDF::TextureSet* texture_set_ddf = GetTextureSet(component)->m_TextureSet;
         const float* tex_coords = (const float*) texture_set_ddf->m_TexCoords.m_Data;
 
         uint32_t tile_width = texture_set_ddf->m_TileWidth;
         uint32_t tile_height = texture_set_ddf->m_TileHeight;
 
-        for (uint32_t* i = begin; i != end; ++i)
-        {
-            uint32_t index, layer, region_x, region_y;
-            DecodeGridAndLayer(buf[*i].m_UserData, index, layer, region_x, region_y);
-
-            const TileGridComponent* component = world->m_Components[index];
-            const TileGridResource* resource = component->m_Resource;
-            dmGameSystemDDF::TileGrid* tile_grid_ddf = resource->m_TileGrid;
-            dmGameSystemDDF::TileLayer* layer_ddf = &tile_grid_ddf->m_Layers[layer];
+        const TileGridResource* resource = component->m_Resource;
+        dmGameSystemDDF::TileGrid* tile_grid_ddf = resource->m_TileGrid;
+        dmGameSystemDDF::TileLayer* layer_ddf = &tile_grid_ddf->m_Layers[layer];
 
-            const Matrix4& w = component->m_World;
-            const float z = layer_ddf->m_Z;
+        const Matrix4 w = component->m_LocalSpace ? Matrix4::identity() : component->m_World;
+        const float z = layer_ddf->m_Z;
 
-            uint32_t column_count = resource->m_ColumnCount;
-            uint32_t row_count = resource->m_RowCount;
+        uint32_t column_count = resource->m_ColumnCount;
+        uint32_t row_count = resource->m_RowCount;
 
-            int32_t min_x = resource->m_MinCellX + region_x * TILEGRID_REGION_SIZE;
-            int32_t min_y = resource->m_MinCellY + region_y * TILEGRID_REGION_SIZE;
-            int32_t max_x = dmMath::Min(min_x + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellX + (int32_t)column_count);
-            int32_t max_y = dmMath::Min(min_y + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellY + (int32_t)row_count);
+        int32_t min_x, min_y, max_x, max_y;
+        GetRegionCellBounds(resource, region_x, region_y, min_x, min_y, max_x, max_y);
 
-            for (int32_t y = min_y; y < max_y; ++y)
+        TileGridVertex* begin = where;
+        for (int32_t y = min_y; y < max_y; ++y)
+        {
+            for (int32_t x = min_x; x < max_x; ++x)
             {
-                for (int32_t x = min_x; x < max_x; ++x)
+                uint32_t cell = CalculateCellIndex(layer, x - resource->m_MinCellX, y - resource->m_MinCellY, column_count, row_count);
+                uint16_t tile = component->m_Cells[cell];
+                if (tile == 0xffff)
                 {
-                    uint32_t cell = CalculateCellIndex(layer, x - resource->m_MinCellX, y - resource->m_MinCellY, column_count, row_count);
-                    uint16_t tile = component->m_Cells[cell];
-                    if (tile == 0xffff)
-                    {
-                        continue;
-                    }
+                    continue;
+                }
 
-                    if( where >= world->m_VertexBufferDataEnd )
-                    {
-                        dmLogError("Out of tiles to render (%zu). You can change this with the game.project setting tilemap.max_tile_count", (size_t)((world->m_VertexBufferDataEnd - world->m_VertexBufferData) / 6));
-                        return world->m_VertexBufferDataEnd;
+                float p[4];
+                CalculateCellBounds(x, y, 1, 1, p);
+                const float* puv = &tex_coords[tile * 8];
+                uint32_t flip_flag = 0;
+
+                TileGridComponent::Flags flags = component->m_CellFlags[cell];
+                if (flags.m_FlipHorizontal)
+                {
+                    flip_flag = 1;
+                }
+                if (flags.m_FlipVertical)
+                {
+                    flip_flag |= 2;
+                }
+                const int* tex_lookup = &tex_coord_order[flip_flag * 6];
+
+                #define SET_VERTEX(_I, _X, _Y, _Z, _U, _V) \
+                    { \
+                        const Vector4 v = w * Point3(_X * tile_width, _Y * tile_height, _Z); \
+                        where[_I].x = v.getX(); \
+                        where[_I].y = v.getY(); \
+                        where[_I].z = v.getZ(); \
+                        where[_I].u = _U; \
+                        where[_I].v = _V; \
                     }
 
-                    float p[4];
-                    CalculateCellBounds(x, y, 1, 1, p);
-                    const float* puv = &tex_coords[tile * 8];
-                    uint32_t flip_flag = 0;
+                SET_VERTEX(0, p[0], p[1], z, puv[tex_lookup[0] * 2], puv[tex_lookup[0] * 2 + 1]);
+                SET_VERTEX(1, p[0], p[3], z, puv[tex_lookup[1] * 2], puv[tex_lookup[1] * 2 + 1]);
+                SET_VERTEX(2, p[2], p[3], z, puv[tex_lookup[2] * 2], puv[tex_lookup[2] * 2 + 1]);
+                SET_VERTEX(3, p[2], p[3], z, puv[tex_lookup[3] * 2], puv[tex_lookup[3] * 2 + 1]);
+                SET_VERTEX(4, p[2], p[1], z, puv[tex_lookup[4] * 2], puv[tex_lookup[4] * 2 + 1]);
+                SET_VERTEX(5, p[0], p[1], z, puv[tex_lookup[5] * 2], puv[tex_lookup[5] * 2 + 1]);
 
-                    TileGridComponent::Flags flags = component->m_CellFlags[cell];
-                    if (flags.m_FlipHorizontal)
-                    {
-                        flip_flag = 1;
-                    }
-                    if (flags.m_FlipVertical)
-                    {
-                        flip_flag |= 2;
-                    }
-                    const int* tex_lookup = &tex_coord_order[flip_flag * 6];
-
-                    #define SET_VERTEX(_I, _X, _Y, _Z, _U, _V) \
-                        { \
-                            const Vector4 v = w * Point3(_X * tile_width, _Y * tile_height, _Z); \
-                            where[_I].x = v.getX(); \
-                            where[_I].y = v.getY(); \
-                            where[_I].z = v.getZ(); \
-                            where[_I].u = _U; \
-                            where[_I].v = _V; \
-                        }
-
-                    SET_VERTEX(0, p[0], p[1], z, puv[tex_lookup[0] * 2], puv[tex_lookup[0] * 2 + 1]);
-                    SET_VERTEX(1, p[0], p[3], z, puv[tex_lookup[1] * 2], puv[tex_lookup[1] * 2 + 1]);
-                    SET_VERTEX(2, p[2], p[3], z, puv[tex_lookup[2] * 2], puv[tex_lookup[2] * 2 + 1]);
-                    SET_VERTEX(3, p[2], p[3], z, puv[tex_lookup[3] * 2], puv[tex_lookup[3] * 2 + 1]);
-                    SET_VERTEX(4, p[2], p[1], z, puv[tex_lookup[4] * 2], puv[tex_lookup[4] * 2 + 1]);
-                    SET_VERTEX(5, p[0], p[1], z, puv[tex_lookup[5] * 2], puv[tex_lookup[5] * 2 + 1]);
-
-                    where += 6;
-
-                    #undef SET_VERTEX
+                where += 6;
+
+                #undef SET_VERTEX
+            }
+        }
+        return (uint32_t)(where - begin);
+    }
+
+    static uint32_t CreateRegionVertices(TileGridWorld* world, const TileGridComponent* component, uint32_t layer, uint32_t region_index, TileGridVertex* where)
+    {
+        uint32_t region_x = region_index % component->m_RegionsX;
+        uint32_t region_y = region_index / component->m_RegionsX;
+        ++world->m_BuildCount;
+        return CreateVertexData(where, component, layer, region_x, region_y);
+    }
+
+    // Brings the vertices of a layer buffer up to date. A changed region is updated in place if its vertex count
+    // is the same, otherwise the buffer is repacked. When repacking, the vertices of the regions that were already
+    // packed and are unchanged are copied rather than created again.
+    static void UpdateLayerBuffer(TileGridWorld* world, TileGridComponent* component, uint32_t layer)
+    {
+        DM_PROFILE(TileGrid, "UpdateLayerBuffer");
+
+        TileGridLayerBuffer* layer_buffer = component->m_LayerBuffers[layer];
+        uint32_t n_layers = component->m_Layers.Size();
+
+        // A region created in the scratch memory that didn't fit in place
+        uint32_t created_region = ~0u;
+        uint32_t created_vertex_count = 0;
+
+        if (!layer_buffer->m_Repack)
+        {
+            uint32_t n = layer_buffer->m_Regions.Size();
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                uint32_t region_index = layer_buffer->m_Regions[i];
+                TileGridRegionLayer* region_layer = &component->m_RegionLayers[region_index * n_layers + layer];
+                if (!region_layer->m_Dirty)
+                    continue;
+
+                uint32_t vertex_count = CreateRegionVertices(world, component, layer, region_index, world->m_VertexBufferData);
+                if (vertex_count != region_layer->m_VertexCount)
+                {
+                    created_region = region_index;
+                    created_vertex_count = vertex_count;
+                    layer_buffer->m_Repack = 1;
+                    break;
+                }
+
+                if (vertex_count)
+                {
+                    uint32_t size = sizeof(TileGridVertex) * vertex_count;
+                    memcpy(layer_buffer->m_Vertices.Begin() + region_layer->m_VertexStart, world->m_VertexBufferData, size);
+                    dmGraphics::SetVertexBufferSubData(layer_buffer->m_VertexBuffer, sizeof(TileGridVertex) * region_layer->m_VertexStart, size, world->m_VertexBufferData);
+                    world->m_UploadSize += size;
                 }
+                region_layer->m_Dirty = 0;
             }
+
+            if (!layer_buffer->m_Repack)
+                return;
         }
-        return where;
+
+        dmArray<TileGridVertex>& vertices = world->m_PackVertices;
+        vertices.SetSize(0);
+
+        dmArray<uint32_t>& regions = layer_buffer->m_NextRegions;
+        uint32_t n = regions.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            uint32_t region_index = regions[i];
+            TileGridRegionLayer* region_layer = &component->m_RegionLayers[region_index * n_layers + layer];
+
+            if (vertices.Remaining() < TILEGRID_REGION_MAX_VERTICES)
+            {
+                vertices.OffsetCapacity(dmMath::Max(vertices.Capacity(), TILEGRID_REGION_MAX_VERTICES));
+            }
+
+            TileGridVertex* where = vertices.End();
+            uint32_t vertex_count;
+            if (region_index == created_region)
+            {
+                vertex_count = created_vertex_count;
+                memcpy(where, world->m_VertexBufferData, sizeof(TileGridVertex) * vertex_count);
+            }
+            else if (region_layer->m_Packed && !region_layer->m_Dirty)
+            {
+                vertex_count = region_layer->m_VertexCount;
+                memcpy(where, layer_buffer->m_Vertices.Begin() + region_layer->m_VertexStart, sizeof(TileGridVertex) * vertex_count);
+            }
+            else
+            {
+                vertex_count = CreateRegionVertices(world, component, layer, region_index, where);
+            }
+
+            region_layer->m_VertexStart = vertices.Size();
+            region_layer->m_VertexCount = (uint16_t)vertex_count;
+            region_layer->m_Dirty = 0;
+            vertices.SetSize(vertices.Size() + vertex_count);
+        }
+
+        for (uint32_t i = 0; i < layer_buffer->m_Regions.Size(); ++i)
+        {
+            component->m_RegionLayers[layer_buffer->m_Regions[i] * n_layers + layer].m_Packed = 0;
+        }
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            component->m_RegionLayers[regions[i] * n_layers + layer].m_Packed = 1;
+        }
+        if (layer_buffer->m_Regions.Capacity() < n)
+        {
+            layer_buffer->m_Regions.SetCapacity(n);
+        }
+        layer_buffer->m_Regions.SetSize(n);
+        if (n)
+        {
+            memcpy(layer_buffer->m_Regions.Begin(), regions.Begin(), sizeof(uint32_t) * n);
+        }
+
+        layer_buffer->m_Vertices.Swap(vertices);
+        layer_buffer->m_Repack = 0;
+
+        uint32_t vertex_count = layer_buffer->m_Vertices.Size();
+        if (vertex_count)
+        {
+            if (!layer_buffer->m_VertexBuffer)
+            {
+                layer_buffer->m_VertexBuffer = dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(world->m_RenderContext), 0, 0x0, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+            }
+            uint32_t size = sizeof(TileGridVertex) * vertex_count;
+            dmGraphics::SetVertexBufferData(layer_buffer->m_VertexBuffer, size, layer_buffer->m_Vertices.Begin(), dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+            world->m_UploadSize += size;
+        }
+    }
+
+    // Remembers a view the tiles are drawn with, to cull the regions against when the tile grids are submitted next
+    static void AddDrawView(TileGridWorld* world, const Matrix4& view_proj)
+    {
+        for (uint32_t i = 0; i < world->m_DrawViewProjCount; ++i)
+        {
+            if (memcmp(&world->m_DrawViewProjs[i], &view_proj, sizeof(view_proj)) == 0)
+                return;
+        }
+        if (world->m_DrawViewProjCount == TILEGRID_MAX_CULL_VIEWS)
+        {
+            world->m_DrawViewProjOverflow = 1;
+            return;
+        }
+        world->m_DrawViewProjs[world->m_DrawViewProjCount++] = view_proj;
     }
 
     static void RenderBatch(TileGridWorld* world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
     {
         DM_PROFILE(TileGrid, "RenderBatch");
 
-        uint32_t index, layer, region_x, region_y;
-        DecodeGridAndLayer(buf[*begin].m_UserData, index, layer, region_x, region_y);
+        uint32_t index, layer;
+        DecodeGridAndLayer(buf[*begin].m_UserData, index, layer);
         TileGridComponent* first = world->m_Components[index];
         assert(first->m_Enabled);
 
         TileGridResource* resource = first->m_Resource;
         TextureSetResource* texture_set = GetTextureSet(first);
 
-        dmRender::RenderObject& ro = *world->m_RenderObjects.End();
-        world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
-
-        // Fill in vertex buffer
-        TileGridVertex* vb_begin = world->m_VertexBufferWritePtr;
-        world->m_VertexBufferWritePtr = CreateVertexData(world, vb_begin, texture_set, buf, begin, end);
-
-        ro.Init();
-        ro.m_VertexDeclaration = world->m_VertexDeclaration;
-        ro.m_VertexBuffer = world->m_VertexBuffer;
-        ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
-        ro.m_VertexStart = vb_begin - world->m_VertexBufferData;
-        ro.m_VertexCount = (world->m_VertexBufferWritePtr - vb_begin);
-        ro.m_Material = GetMaterial(first);
-        ro.m_Textures[0] = texture_set->m_Texture;
+        // The batch shares material, texture set, blend mode and constants
+        dmRender::RenderObject batch_ro;
+        batch_ro.Init();
+        batch_ro.m_VertexDeclaration = world->m_VertexDeclaration;
+        batch_ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
+        batch_ro.m_Material = GetMaterial(first);
+        batch_ro.m_Textures[0] = texture_set->m_Texture;
+        if (world->m_TextureStreamer)
+        {
+            RequestTextureMip(world->m_TextureStreamer, texture_set->m_Texture, 0);
+        }
 
         if (first->m_RenderConstants) {
-            dmGameSystem::EnableRenderObjectConstants(&ro, first->m_RenderConstants);
+            dmGameSystem::EnableRenderObjectConstants(&batch_ro, first->m_RenderConstants);
         }
 
         dmGameSystemDDF::TileGrid::BlendMode blend_mode = resource->m_TileGrid->m_BlendMode;
         switch (blend_mode)
         {
             case dmGameSystemDDF::TileGrid::BLEND_MODE_ALPHA:
-                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
-                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                batch_ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                batch_ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
             break;
 
             case dmGameSystemDDF::TileGrid::BLEND_MODE_ADD:
             case dmGameSystemDDF::TileGrid::BLEND_MODE_ADD_ALPHA:
-                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
-                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                batch_ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                batch_ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
             break;
 
             case dmGameSystemDDF::TileGrid::BLEND_MODE_MULT:
-                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_DST_COLOR;
-                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                batch_ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_DST_COLOR;
+                batch_ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
             break;
 
             case dmGameSystemDDF::TileGrid::BLEND_MODE_SCREEN:
-                ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_DST_COLOR;
-                ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
+                batch_ro.m_SourceBlendFactor = dmGraphics::BLEND_FACTOR_ONE_MINUS_DST_COLOR;
+                batch_ro.m_DestinationBlendFactor = dmGraphics::BLEND_FACTOR_ONE;
             break;
 
             default:
@@ -662,9 +905,46 @@ namespace dmGameSystem
             break;
         }
 
-        ro.m_SetBlendFactors = 1;
+        batch_ro.m_SetBlendFactors = 1;
+
+        AddDrawView(world, dmRender::GetViewProjectionMatrix(render_context));
+
+        for (uint32_t* i = begin; i != end; ++i)
+        {
+            DecodeGridAndLayer(buf[*i].m_UserData, index, layer);
+            TileGridComponent* component = world->m_Components[index];
+
+            UpdateLayerBuffer(world, component, layer);
+
+            TileGridLayerBuffer* layer_buffer = component->m_LayerBuffers[layer];
+            uint32_t vertex_count = layer_buffer->m_Vertices.Size();
+            if (vertex_count == 0)
+            {
+                continue;
+            }
+
+            uint32_t tile_count = vertex_count / 6;
+            if (world->m_TileCount + tile_count > world->m_MaxTileCount)
+            {
+                dmLogError("Out of tiles to render (%u). You can change this with the game.project setting tilemap.max_tile_count", world->m_MaxTileCount);
+                return;
+            }
+            world->m_TileCount += tile_count;
+
+            dmRender::RenderObject& ro = *world->m_RenderObjects.End();
+            world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
+
+            ro = batch_ro;
+            ro.m_VertexBuffer = layer_buffer->m_VertexBuffer;
+            ro.m_VertexStart = 0;
+            ro.m_VertexCount = vertex_count;
+            if (component->m_LocalSpace)
+            {
+                ro.m_WorldTransform = component->m_World;
+            }
 
-        dmRender::AddToRender(render_context, &ro);
+            dmRender::AddToRender(render_context, &ro);
+        }
     }
 
     static void RenderListDispatch(dmRender::RenderListDispatchParams const &params)
@@ -674,16 +954,16 @@ namespace dmGameSystem
         switch (params.m_Operation)
         {
         case dmRender::RENDER_LIST_OPERATION_BEGIN:
-            world->m_VertexBufferWritePtr = world->m_VertexBufferData;
+            world->m_TileCount = 0;
+            world->m_UploadSize = 0;
+            world->m_BuildCount = 0;
             world->m_RenderObjects.SetSize(0);
             break;
 
         case dmRender::RENDER_LIST_OPERATION_END:
-            dmGraphics::SetVertexBufferData(world->m_VertexBuffer, 0, 0, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
-            dmGraphics::SetVertexBufferData(world->m_VertexBuffer, sizeof(TileGridVertex) * (world->m_VertexBufferWritePtr - world->m_VertexBufferData),
-                                            world->m_VertexBufferData, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
-            DM_COUNTER("TileGridVertexBuffer", (world->m_VertexBufferWritePtr - world->m_VertexBufferData) * sizeof(TileGridVertex));
-            DM_COUNTER("TileGridTileCount", (world->m_VertexBufferWritePtr - world->m_VertexBufferData));
+            DM_COUNTER("TileGridVertexBuffer", world->m_UploadSize);
+            DM_COUNTER("TileGridTileCount", world->m_TileCount);
+            DM_COUNTER("TileGridRegionBuild", world->m_BuildCount);
             break;
 
         case dmRender::RENDER_LIST_OPERATION_BATCH:
@@ -693,7 +973,7 @@ namespace dmGameSystem
     }
 
     // Estimates the number of render entries needed
-    static uint32_t CalcNumVisibleRegions(TileGridComponent** components, uint32_t num_components)
+    static uint32_t CalcNumVisibleLayers(TileGridComponent** components, uint32_t num_components)
     {
         uint32_t num_render_entries = 0;
         for (uint32_t i = 0; i < num_components; ++i)
@@ -709,12 +989,131 @@ namespace dmGameSystem
                 if (!layer->m_IsVisible)
                     continue;
 
-                num_render_entries += component->m_RegionsY * component->m_RegionsX;
+                ++num_render_entries;
             }
         }
         return num_render_entries;
     }
 
+    // Sets a bit per clip space plane that a corner of the region grid of a layer is outside of.
+    // The grid is flat, so the corners are found by stepping along its axes in clip space.
+    static void CalcCornerMasks(const Matrix4& view_proj, const TileGridComponent* component, uint32_t layer, uint8_t* masks)
+    {
+        const TileGridResource* resource = component->m_Resource;
+        dmGameSystemDDF::TextureSet* texture_set_ddf = GetTextureSet(component)->m_TextureSet;
+        float tile_width = (float)texture_set_ddf->m_TileWidth;
+        float tile_height = (float)texture_set_ddf->m_TileHeight;
+        float z = resource->m_TileGrid->m_Layers[layer].m_Z;
+
+        const Matrix4 world_view_proj = view_proj * component->m_World;
+        const Vector4 origin = world_view_proj * Point3(resource->m_MinCellX * tile_width, resource->m_MinCellY * tile_height, z);
+        const Vector4 step_x = world_view_proj * Vector3(TILEGRID_REGION_SIZE * tile_width, 0.0f, 0.0f);
+        const Vector4 step_y = world_view_proj * Vector3(0.0f, TILEGRID_REGION_SIZE * tile_height, 0.0f);
+
+        uint32_t corners_x = component->m_RegionsX + 1;
+        uint32_t corners_y = component->m_RegionsY + 1;
+        for (uint32_t y = 0; y < corners_y; ++y)
+        {
+            for (uint32_t x = 0; x < corners_x; ++x)
+            {
+                const Vector4 p = origin + step_x * (float)x + step_y * (float)y;
+                uint8_t mask = 0;
+                if (p.getW() > 0.0f) // Corners behind the camera are kept
+                {
+                    float w = p.getW() * TILEGRID_CULL_SCALE;
+                    mask |= p.getX() < -w ? 1 : 0;
+                    mask |= p.getX() > w ? 2 : 0;
+                    mask |= p.getY() < -w ? 4 : 0;
+                    mask |= p.getY() > w ? 8 : 0;
+                }
+                masks[y * corners_x + x] = mask;
+            }
+        }
+    }
+
+    // Collects the occupied regions of a layer that are in or near any of the cull views. Conservative,
+    // a region is only culled if all corners of its grid cell are outside the same plane.
+    static void CollectVisibleRegions(TileGridWorld* world, const TileGridComponent* component, uint32_t layer, dmArray<uint32_t>& regions)
+    {
+        DM_PROFILE(TileGrid, "CollectVisibleRegions");
+
+        uint32_t corners_x = component->m_RegionsX + 1;
+        uint32_t corner_count = corners_x * (component->m_RegionsY + 1);
+        uint32_t view_count = world->m_CullDisabled ? 0 : world->m_CullViewProjCount;
+
+        dmArray<uint8_t>& masks = world->m_CornerMasks;
+        if (masks.Capacity() < corner_count * view_count)
+        {
+            masks.SetCapacity(corner_count * view_count);
+        }
+        masks.SetSize(corner_count * view_count);
+        for (uint32_t v = 0; v < view_count; ++v)
+        {
+            CalcCornerMasks(world->m_CullViewProjs[v], component, layer, &masks[v * corner_count]);
+        }
+
+        regions.SetSize(0);
+        for (uint32_t y = 0, region_index = 0; y < component->m_RegionsY; ++y)
+        {
+            for (uint32_t x = 0; x < component->m_RegionsX; ++x, ++region_index)
+            {
+                if (!component->m_Regions[region_index].m_Occupied)
+                    continue;
+
+                bool visible = view_count == 0;
+                uint32_t corner = y * corners_x + x;
+                for (uint32_t v = 0; v < view_count && !visible; ++v)
+                {
+                    const uint8_t* m = &masks[v * corner_count + corner];
+                    visible = (m[0] & m[1] & m[corners_x] & m[corners_x + 1]) == 0;
+                }
+
+                if (visible)
+                {
+                    if (regions.Full())
+                    {
+                        regions.OffsetCapacity(64);
+                    }
+                    regions.Push(region_index);
+                }
+            }
+        }
+    }
+
+    // The regions are culled when submitted, against the views the tiles were drawn with since the previous submit.
+    // The views of this frame aren't known until the render script draws, so the bounds are scaled to keep the
+    // regions near the view as well, and a camera that moves less than a quarter of the view per frame still has
+    // its regions in the layer buffers.
+    static void UpdateCullViews(TileGridWorld* world, dmRender::HRenderContext render_context)
+    {
+        if (world->m_DrawViewProjOverflow)
+        {
+            world->m_CullDisabled = 1;
+        }
+        else if (world->m_DrawViewProjCount > 0)
+        {
+            memcpy(world->m_CullViewProjs, world->m_DrawViewProjs, sizeof(Matrix4) * world->m_DrawViewProjCount);
+            world->m_CullViewProjCount = world->m_DrawViewProjCount;
+            world->m_CullDisabled = 0;
+        }
+        else if (world->m_CullViewProjCount == 0 && !world->m_CullDisabled)
+        {
+            // Nothing drawn yet, use the current view of the render context
+            world->m_CullViewProjs[0] = dmRender::GetViewProjectionMatrix(render_context);
+            world->m_CullViewProjCount = 1;
+        }
+        world->m_DrawViewProjCount = 0;
+        world->m_DrawViewProjOverflow = 0;
+    }
+
+    static bool AreRegionsEqual(dmArray<uint32_t>& a, dmArray<uint32_t>& b)
+    {
+        return a.Size() == b.Size() && (a.Empty() || memcmp(a.Begin(), b.Begin(), sizeof(uint32_t) * a.Size()) == 0);
+    }
+
+    // Submits one render entry per visible layer, which draws the regions in or near the view with one draw call.
+    // The entry is submitted even when no regions are near the view, so that RenderBatch still sees the views
+    // the tiles are drawn with.
     dmGameObject::UpdateResult CompTileGridRender(const dmGameObject::ComponentsRenderParams& params)
     {
         TilemapContext* context = (TilemapContext*)params.m_Context;
@@ -727,7 +1126,7 @@ namespace dmGameSystem
             return dmGameObject::UPDATE_RESULT_OK;
         }
 
-        uint32_t num_render_entries = CalcNumVisibleRegions(&components[0], n);
+        uint32_t num_render_entries = CalcNumVisibleLayers(&components[0], n);
 
         // We need to calculate this before actually pushing render object references to the renderer
         // This however means we need to make this array potentially oversized, but this allocation should only occur
@@ -741,6 +1140,8 @@ namespace dmGameSystem
         dmRender::HRenderListDispatch dispatch = dmRender::RenderListMakeDispatch(render_context, &RenderListDispatch, world);
         dmRender::RenderListEntry* write_ptr = render_list;
 
+        UpdateCullViews(world, render_context);
+
         for (uint32_t i = 0; i < n; ++i)
         {
             TileGridComponent* component = components[i];
@@ -753,13 +1154,7 @@ namespace dmGameSystem
                 ReHash(component);
             }
 
-            TileGridResource* resource = component->m_Resource;
-            dmGameSystemDDF::TextureSet* texture_set_ddf = GetTextureSet(component)->m_TextureSet;
-            dmGameSystemDDF::TileGrid* tile_grid_ddf = resource->m_TileGrid;
-
-            uint32_t tile_width = texture_set_ddf->m_TileWidth;
-            uint32_t tile_height = texture_set_ddf->m_TileHeight;
-
+            dmGameSystemDDF::TileGrid* tile_grid_ddf = component->m_Resource->m_TileGrid;
             uint32_t n_layers = tile_grid_ddf->m_Layers.m_Count;
             for (uint32_t l = 0; l < n_layers; ++l)
             {
@@ -767,27 +1162,23 @@ namespace dmGameSystem
                 if (!layer->m_IsVisible)
                     continue;
 
-                dmGameSystemDDF::TileLayer* layer_ddf = &tile_grid_ddf->m_Layers[l];
-                for (uint32_t y = 0, region_index = 0; y < component->m_RegionsY; ++y) {
-                    for (uint32_t x = 0; x < component->m_RegionsX; ++x, ++region_index) {
-
-                        TileGridRegion* region = &component->m_Regions[region_index];
-                        if (!region->m_Occupied) {
-                            continue;
-                        }
-
-                        Vector4 trans = component->m_World * Point3(x * tile_width, y * tile_height, layer_ddf->m_Z);
-
-                        write_ptr->m_WorldPosition = Point3(trans.getXYZ());
-                        write_ptr->m_UserData = EncodeRegionInfo(i, l, x, y);
-                        write_ptr->m_TagListKey = dmRender::GetMaterialTagListKey(GetMaterial(component));
-                        write_ptr->m_BatchKey = component->m_MixedHash;
-                        write_ptr->m_Dispatch = dispatch;
-                        write_ptr->m_MinorOrder = 0;
-                        write_ptr->m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
-                        ++write_ptr;
-                    }
+                TileGridLayerBuffer* layer_buffer = component->m_LayerBuffers[l];
+                CollectVisibleRegions(world, component, l, layer_buffer->m_NextRegions);
+                if (!AreRegionsEqual(layer_buffer->m_NextRegions, layer_buffer->m_Regions))
+                {
+                    layer_buffer->m_Repack = 1;
                 }
+
+                Vector4 trans = component->m_World * Point3(0.0f, 0.0f, tile_grid_ddf->m_Layers[l].m_Z);
+
+                write_ptr->m_WorldPosition = Point3(trans.getXYZ());
+                write_ptr->m_UserData = EncodeGridAndLayer(i, l);
+                write_ptr->m_TagListKey = dmRender::GetMaterialTagListKey(GetMaterial(component));
+                write_ptr->m_BatchKey = component->m_MixedHash;
+                write_ptr->m_Dispatch = dispatch;
+                write_ptr->m_MinorOrder = 0;
+                write_ptr->m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+                ++write_ptr;
             }
         }
 
@@ -796,6 +1187,14 @@ namespace dmGameSystem
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
+    void GetTileGridStats(void* tilegrid_world, TileGridStats* stats)
+    {
+        TileGridWorld* world = (TileGridWorld*)tilegrid_world;
+        stats->m_UploadSize = world->m_UploadSize;
+        stats->m_BuildCount = world->m_BuildCount;
+        stats->m_TileCount = world->m_TileCount;
+    }
+
     uint32_t GetLayerIndex(const TileGridComponent* component, dmhash_t layer_id)
     {
         dmGameSystemDDF::TileGrid* tile_grid_ddf = component->m_Resource->m_TileGrid;
@@ -42,6 +42,16 @@ namespace dmGameSystem
 
     dmGameObject::PropertyResult CompTileGridSetProperty(const dmGameObject::ComponentSetPropertyParams& params);
 
+    // Statistics of the last draw call, reset when the render list of the world is dispatched
+    struct TileGridStats
+    {
+        uint32_t m_UploadSize;  // Bytes of vertex data uploaded
+        uint32_t m_BuildCount;  // Region layers whose vertices were created
+        uint32_t m_TileCount;   // Tiles drawn
+    };
+
+    void GetTileGridStats(void* tilegrid_world, TileGridStats* stats);
+
     // Script support
     struct TileGridComponent;
 
@@ -33,6 +33,9 @@ namespace dmMessage { struct URL; }
 
 namespace dmGameSystem
 {
+    /// Texture streamer handle, see #NewTextureStreamer
+    typedef struct TextureStreamer* HTextureStreamer;
+
     /// Config key to use for tweaking maximum number of collisions reported
     extern const char* PHYSICS_MAX_COLLISIONS_KEY;
     /// Config key to use for tweaking maximum number of contacts reported
@@ -44,6 +47,17 @@ namespace dmGameSystem
     /// Config key to use for tweaking maximum number of collection factories
     extern const char* COLLECTION_FACTORY_MAX_COUNT_KEY;
 
+    struct TextureContext
+    {
+        TextureContext()
+        {
+            memset(this, 0, sizeof(*this));
+        }
+        dmGraphics::HContext        m_GraphicsContext;
+        /// 0 when textures are loaded with all mips up front
+        HTextureStreamer            m_Streamer;
+    };
+
     struct TilemapContext
     {
         TilemapContext()
@@ -51,6 +65,7 @@ namespace dmGameSystem
             memset(this, 0, sizeof(*this));
         }
         dmRender::HRenderContext    m_RenderContext;
+        HTextureStreamer            m_TextureStreamer;
         uint32_t                    m_MaxTilemapCount;
         uint32_t                    m_MaxTileCount;
     };
@@ -62,6 +77,7 @@ namespace dmGameSystem
             memset(this, 0, sizeof(*this));
         }
         dmRender::HRenderContext    m_RenderContext;
+        dmResource::HFactory        m_Factory;
         uint32_t                    m_MaxLabelCount;
         uint32_t                    m_Subpixels : 1;
     };
@@ -87,6 +103,7 @@ namespace dmGameSystem
         }
         dmResource::HFactory m_Factory;
         dmRender::HRenderContext m_RenderContext;
+        HTextureStreamer m_TextureStreamer;
         uint32_t m_MaxParticleFXCount;
         uint32_t m_MaxParticleCount;
         bool m_Debug;
@@ -108,6 +125,7 @@ namespace dmGameSystem
         dmRender::HRenderContext    m_RenderContext;
         dmGui::HContext             m_GuiContext;
         dmScript::HContext          m_ScriptContext;
+        HTextureStreamer            m_TextureStreamer;
         uint32_t                    m_MaxGuiComponents;
         uint32_t                    m_MaxParticleFXCount;
         uint32_t                    m_MaxParticleCount;
@@ -121,6 +139,7 @@ namespace dmGameSystem
             memset(this, 0, sizeof(*this));
         }
         dmRender::HRenderContext    m_RenderContext;
+        HTextureStreamer            m_TextureStreamer;
         uint32_t                    m_MaxSpriteCount;
         uint32_t                    m_Subpixels : 1;
     };
@@ -133,7 +152,9 @@ namespace dmGameSystem
         }
         dmRender::HRenderContext    m_RenderContext;
         dmResource::HFactory        m_Factory;
+        HTextureStreamer            m_TextureStreamer;
         uint32_t                    m_MaxModelCount;
+        uint32_t                    m_PoseCache : 1;
     };
 
     struct SoundContext
@@ -153,6 +174,7 @@ namespace dmGameSystem
         }
         dmRender::HRenderContext    m_RenderContext;
         dmResource::HFactory        m_Factory;
+        HTextureStreamer            m_TextureStreamer;
         uint32_t                    m_MaxMeshCount;
     };
 
@@ -203,7 +225,8 @@ namespace dmGameSystem
         dmRender::HRenderContext render_context,
         GuiContext* gui_context,
         dmInput::HContext input_context,
-        PhysicsContext* physics_context);
+        PhysicsContext* physics_context,
+        TextureContext* texture_context);
 
     dmGameObject::Result RegisterComponentTypes(dmResource::HFactory factory,
                                                   dmGameObject::HRegister regist,
@@ -221,6 +244,29 @@ namespace dmGameSystem
                                                   TilemapContext* tilemap_context,
                                                   SoundContext* sound_context);
 
+    /**
+     * Create a texture streamer. Textures created while the streamer is set in the TextureContext
+     * only load their lowest mips, and the higher mips are loaded when the components drawing them request them.
+     * @param factory Factory to load the mips with
+     * @param graphics_context Graphics context
+     * @param memory_budget Budget for the resident texture data in bytes, 0 for no budget
+     * @return New texture streamer
+     */
+    HTextureStreamer NewTextureStreamer(dmResource::HFactory factory, dmGraphics::HContext graphics_context, uint64_t memory_budget);
+
+    /**
+     * Delete a texture streamer. Waits for any pending loads. The streamed textures keep their resident mips.
+     * @param streamer Texture streamer
+     */
+    void DeleteTextureStreamer(HTextureStreamer streamer);
+
+    /**
+     * Update the texture streamer, once per frame after rendering. Uploads loaded mips, starts loads for the mips
+     * requested during the frame and evicts mips to stay within the memory budget.
+     * @param streamer Texture streamer
+     */
+    void UpdateTextureStreamer(HTextureStreamer streamer);
+
     void GuiGetURLCallback(dmGui::HScene scene, dmMessage::URL* url);
     uintptr_t GuiGetUserDataCallback(dmGui::HScene scene);
     dmhash_t GuiResolvePathCallback(dmGui::HScene scene, const char* path, uint32_t path_size);
@@ -100,13 +100,7 @@ namespace dmGameSystem
 
         if (params.m_Resource->m_NameHash == vertex_name_hash || params.m_Resource->m_NameHash == fragment_name_hash)
         {
-            dmRender::HRenderContext render_context = dmRender::GetMaterialRenderContext(material);
-            dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
-            dmGraphics::HProgram program = dmRender::GetMaterialProgram(material);
-            dmGraphics::HVertexProgram vert_program = dmRender::GetMaterialVertexProgram(material);
-            dmGraphics::HFragmentProgram frag_program = dmRender::GetMaterialFragmentProgram(material);
-
-            if (!dmGraphics::ReloadProgram(graphics_context, program, vert_program, frag_program))
+            if (!dmRender::ReloadMaterialProgram(material))
             {
                 dmLogWarning("Reloading the material failed, some shaders might not have been correctly linked.");
             }
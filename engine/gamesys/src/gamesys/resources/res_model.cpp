@@ -17,6 +17,7 @@
 #include <dlib/path.h>
 #include <dlib/dstrings.h>
 #include <dlib/memory.h>
+#include <dlib/math.h>
 #include <rig/rig.h>
 
 
@@ -82,6 +83,21 @@ namespace dmGameSystem
         delete []rmv_buffer;
     }
 
+    static float GetBoundingRadius(const dmRigDDF::MeshSet* mesh_set)
+    {
+        float max_sq_length = 0.0f;
+        for (uint32_t i = 0; i < mesh_set->m_MeshAttachments.m_Count; ++i)
+        {
+            const dmRigDDF::Mesh& mesh = mesh_set->m_MeshAttachments[i];
+            for (uint32_t j = 0; j + 2 < mesh.m_Positions.m_Count; j += 3)
+            {
+                const float* v = &mesh.m_Positions[j];
+                max_sq_length = dmMath::Max(max_sq_length, v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+            }
+        }
+        return sqrtf(max_sq_length);
+    }
+
     dmResource::Result AcquireResources(dmGraphics::HContext context, dmResource::HFactory factory, ModelResource* resource, const char* filename)
     {
         dmResource::Result result = dmResource::Get(factory, resource->m_Model->m_RigScene, (void**) &resource->m_RigScene);
@@ -121,6 +137,12 @@ namespace dmGameSystem
         }
         memcpy(resource->m_Textures, textures, sizeof(dmGraphics::HTexture) * dmRender::RenderObject::MAX_TEXTURE_COUNT);
 
+        resource->m_BoundingRadius = 0.0f;
+        if (resource->m_RigScene->m_MeshSetRes && resource->m_RigScene->m_MeshSetRes->m_MeshSet)
+        {
+            resource->m_BoundingRadius = GetBoundingRadius(resource->m_RigScene->m_MeshSetRes->m_MeshSet);
+        }
+
         if(dmRender::GetMaterialVertexSpace(resource->m_Material) ==  dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL)
         {
             if(resource->m_RigScene->m_AnimationSetRes || resource->m_RigScene->m_SkeletonRes)
@@ -14,6 +14,7 @@
 #include <string.h>
 
 #include <dlib/log.h>
+#include <dlib/math.h>
 #include <sound/sound.h>
 #include <gamesys/sound_ddf.h>
 
@@ -36,6 +37,7 @@ namespace dmGameSystem
             s->m_SoundData = sound_data;
             s->m_Looping = sound_desc->m_Looping;
             s->m_Loopcount = sound_desc->m_Loopcount;
+            s->m_Priority = (uint8_t) dmMath::Clamp(sound_desc->m_Priority, 0, 255);
             s->m_GroupHash = dmHashString64(sound_desc->m_Group);
             s->m_Gain = sound_desc->m_Gain;
             s->m_Pan = sound_desc->m_Pan;
@@ -12,6 +12,12 @@
 
 #include "res_texture.h"
 
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include <dlib/array.h>
+#include <dlib/hashtable.h>
 #include <dlib/log.h>
 #include <dlib/profile.h>
 #include <dlib/time.h>
@@ -82,7 +88,414 @@ namespace dmGameSystem
         dmGraphics::SetTextureAsync(texture, params);
     }
 
-    dmResource::Result AcquireResources(const char* path, dmResource::SResourceDescriptor* resource_desc, dmGraphics::HContext context, ImageDesc* image_desc, dmGraphics::HTexture texture, dmGraphics::HTexture* texture_out)
+    // Texture streaming
+    //
+    // Streamed 2D textures are created with only the mips from STREAMING_BASE_SIZE and down, and the
+    // higher mips are loaded when components request them. Every component that draws with texture
+    // resources requests the mips it needs when it renders. Sprites and models estimate the mip from
+    // their size on screen, the others request the full resolution. The texture handle is shared by value with
+    // materials, texture sets and gui scenes, so the texture is set again at the size of its highest
+    // resident mip rather than replaced. The original size is kept, which is what the users size against.
+    //
+    // UpdateTextureStreamer starts a load of the whole file for textures that need more mips and uploads
+    // the needed mips when it is done. When the resident mips exceed the memory budget, textures that
+    // haven't been requested for a while are evicted back to their base mips, which are kept in memory.
+
+    // Size of the largest mip loaded up front
+    static const uint32_t STREAMING_BASE_SIZE = 64;
+    // Frames a texture needs to go unrequested before it can be evicted
+    static const uint32_t STREAMING_EVICT_FRAMES = 60;
+
+    struct StreamedTexture
+    {
+        dmGraphics::HTexture        m_Texture;
+        char*                       m_Path;
+        // The base mips, to evict the texture without loading it again
+        uint8_t*                    m_BaseData;
+        dmResource::HRawLoadRequest m_Request;
+        uint64_t                    m_RequestTime;
+        uint32_t                    m_MipSize[s_MaxMipCount];
+        dmGraphics::TextureFormat   m_Format;
+        dmGraphics::TextureFilter   m_MinFilter;
+        dmGraphics::TextureFilter   m_MagFilter;
+        uint32_t                    m_Alternative;
+        uint32_t                    m_LastRequestFrame;
+        uint16_t                    m_Width;
+        uint16_t                    m_Height;
+        uint8_t                     m_MipCount;
+        uint8_t                     m_BaseMip;
+        uint8_t                     m_ResidentMip;
+        uint8_t                     m_LoadingMip;
+        // Lowest mip requested during m_LastRequestFrame
+        uint8_t                     m_RequestedMip;
+        uint8_t                     m_Requested : 1;
+        uint8_t                     m_LoadFailed : 1;
+    };
+
+    struct TextureStreamer
+    {
+        dmResource::HRawLoader      m_Loader;
+        dmGraphics::HContext        m_GraphicsContext;
+        dmArray<StreamedTexture*>   m_Textures;
+        // Index into m_Textures by texture handle
+        dmHashTable64<uint32_t>     m_TextureIndices;
+        // Destroyed textures with loads in flight
+        dmArray<StreamedTexture*>   m_Cancelled;
+        // Scratch list of textures to evict
+        dmArray<StreamedTexture*>   m_Evictable;
+        uint64_t                    m_MemoryBudget;
+        // Size of the mips above the base mips, resident or being loaded
+        uint64_t                    m_ResidentSize;
+        uint32_t                    m_Frame;
+    };
+
+    static uint32_t GetStreamingBaseMip(uint32_t width, uint32_t height, uint32_t mip_count)
+    {
+        uint32_t mip = 0;
+        while (mip + 1 < mip_count && dmMath::Max(width >> mip, height >> mip) > STREAMING_BASE_SIZE)
+            ++mip;
+        return mip;
+    }
+
+    static uint64_t GetStreamedSize(const StreamedTexture* st, uint32_t mip)
+    {
+        uint64_t size = 0;
+        for (uint32_t i = mip; i < st->m_BaseMip; ++i)
+            size += st->m_MipSize[i];
+        return size;
+    }
+
+    static void FreeStreamedTexture(StreamedTexture* st)
+    {
+        free(st->m_Path);
+        free(st->m_BaseData);
+        free(st);
+    }
+
+    static void SetStreamedTextureMips(StreamedTexture* st, const uint8_t* const* mip_data, uint32_t first_mip)
+    {
+        dmGraphics::TextureParams params;
+        params.m_Format = st->m_Format;
+        params.m_MinFilter = st->m_MinFilter;
+        params.m_MagFilter = st->m_MagFilter;
+        for (uint32_t i = first_mip; i < st->m_MipCount; ++i)
+        {
+            params.m_MipMap = i - first_mip;
+            params.m_Width = dmMath::Max(1, st->m_Width >> i);
+            params.m_Height = dmMath::Max(1, st->m_Height >> i);
+            params.m_Data = mip_data[i];
+            params.m_DataSize = st->m_MipSize[i];
+            // Synchronous, since the texture is in use and would be incomplete between the mips
+            dmGraphics::SetTexture(st->m_Texture, params);
+        }
+        st->m_ResidentMip = first_mip;
+    }
+
+    static void SetStreamedTextureBaseMips(StreamedTexture* st)
+    {
+        const uint8_t* mip_data[s_MaxMipCount];
+        const uint8_t* data = st->m_BaseData;
+        for (uint32_t i = st->m_BaseMip; i < st->m_MipCount; ++i)
+        {
+            mip_data[i] = data;
+            data += st->m_MipSize[i];
+        }
+        SetStreamedTextureMips(st, mip_data, st->m_BaseMip);
+    }
+
+    static void AddStreamedTexture(TextureStreamer* streamer, dmGraphics::HTexture texture, const char* path, const dmGraphics::TextureImage::Image* image,
+                                   uint32_t alternative, uint32_t base_mip, const dmGraphics::TextureParams& params)
+    {
+        StreamedTexture* st = (StreamedTexture*) malloc(sizeof(StreamedTexture));
+        memset(st, 0, sizeof(StreamedTexture));
+        st->m_Texture = texture;
+        st->m_Path = strdup(path);
+        st->m_Format = params.m_Format;
+        st->m_MinFilter = params.m_MinFilter;
+        st->m_MagFilter = params.m_MagFilter;
+        st->m_Alternative = alternative;
+        st->m_Width = image->m_Width;
+        st->m_Height = image->m_Height;
+        st->m_MipCount = image->m_MipMapOffset.m_Count;
+        st->m_BaseMip = base_mip;
+        st->m_ResidentMip = base_mip;
+        st->m_LoadingMip = base_mip;
+        st->m_RequestedMip = base_mip;
+
+        uint32_t base_size = 0;
+        for (uint32_t i = 0; i < st->m_MipCount; ++i)
+        {
+            st->m_MipSize[i] = image->m_MipMapSize[i];
+            if (i >= base_mip)
+                base_size += image->m_MipMapSize[i];
+        }
+        st->m_BaseData = (uint8_t*) malloc(base_size);
+        uint8_t* data = st->m_BaseData;
+        for (uint32_t i = base_mip; i < st->m_MipCount; ++i)
+        {
+            memcpy(data, &image->m_Data[image->m_MipMapOffset[i]], st->m_MipSize[i]);
+            data += st->m_MipSize[i];
+        }
+
+        if (streamer->m_TextureIndices.Full())
+        {
+            uint32_t capacity = streamer->m_TextureIndices.Capacity() + 64;
+            streamer->m_TextureIndices.SetCapacity(dmMath::Max(17U, capacity / 3), capacity);
+        }
+        streamer->m_TextureIndices.Put((uintptr_t) texture, streamer->m_Textures.Size());
+        if (streamer->m_Textures.Full())
+            streamer->m_Textures.OffsetCapacity(64);
+        streamer->m_Textures.Push(st);
+    }
+
+    static void RemoveStreamedTexture(TextureStreamer* streamer, dmGraphics::HTexture texture)
+    {
+        uint32_t* index = streamer->m_TextureIndices.Get((uintptr_t) texture);
+        if (!index)
+            return;
+        StreamedTexture* st = streamer->m_Textures[*index];
+        streamer->m_ResidentSize -= GetStreamedSize(st, dmMath::Min(st->m_ResidentMip, st->m_LoadingMip));
+
+        uint32_t last = streamer->m_Textures.Size() - 1;
+        if (*index != last)
+        {
+            StreamedTexture* moved = streamer->m_Textures[last];
+            streamer->m_TextureIndices.Put((uintptr_t) moved->m_Texture, *index);
+        }
+        streamer->m_Textures.EraseSwap(*index);
+        streamer->m_TextureIndices.Erase((uintptr_t) texture);
+
+        if (st->m_Request)
+        {
+            st->m_Texture = 0;
+            if (streamer->m_Cancelled.Full())
+                streamer->m_Cancelled.OffsetCapacity(16);
+            streamer->m_Cancelled.Push(st);
+        }
+        else
+        {
+            FreeStreamedTexture(st);
+        }
+    }
+
+    static dmResource::Result StreamedTexturePreload(const dmResource::ResourcePreloadParams& params)
+    {
+        dmGraphics::TextureImage* texture_image;
+        dmDDF::Result e = dmDDF::LoadMessage<dmGraphics::TextureImage>(params.m_Buffer, params.m_BufferSize, (&texture_image));
+        if ( e != dmDDF::RESULT_OK )
+        {
+            return dmResource::RESULT_FORMAT_ERROR;
+        }
+        *params.m_PreloadData = texture_image;
+        return dmResource::RESULT_OK;
+    }
+
+    // Upload the mips of a completed load. The file may have changed since the texture was created, in which case the mips are dropped.
+    static bool SetLoadedMips(StreamedTexture* st, const dmGraphics::TextureImage* texture_image)
+    {
+        if (st->m_Alternative >= texture_image->m_Alternatives.m_Count)
+            return false;
+        const dmGraphics::TextureImage::Image* image = &texture_image->m_Alternatives[st->m_Alternative];
+        if (image->m_Width != st->m_Width || image->m_Height != st->m_Height || image->m_MipMapOffset.m_Count != st->m_MipCount ||
+            TextureImageToTextureFormat(image->m_Format) != st->m_Format)
+            return false;
+
+        const uint8_t* mip_data[s_MaxMipCount];
+        for (uint32_t i = 0; i < st->m_MipCount; ++i)
+        {
+            if (image->m_MipMapSize[i] != st->m_MipSize[i])
+                return false;
+            mip_data[i] = &image->m_Data[image->m_MipMapOffset[i]];
+        }
+        SetStreamedTextureMips(st, mip_data, st->m_LoadingMip);
+        return true;
+    }
+
+    static void CompleteLoads(TextureStreamer* streamer)
+    {
+        uint32_t load_count = 0;
+        uint64_t latency = 0;
+        for (uint32_t i = 0; i < streamer->m_Textures.Size(); ++i)
+        {
+            StreamedTexture* st = streamer->m_Textures[i];
+            if (!st->m_Request)
+                continue;
+
+            void* data = 0;
+            dmResource::Result r = dmResource::EndRawLoad(streamer->m_Loader, st->m_Request, &data);
+            if (r == dmResource::RESULT_PENDING)
+                continue;
+            st->m_Request = 0;
+
+            dmGraphics::TextureImage* texture_image = (dmGraphics::TextureImage*) data;
+            if (r != dmResource::RESULT_OK)
+            {
+                dmLogWarning("Unable to stream texture %s (%s)", st->m_Path, dmResource::ResultToString(r));
+            }
+            else if (!SetLoadedMips(st, texture_image))
+            {
+                dmLogWarning("Unable to stream texture %s, the file no longer matches the texture", st->m_Path);
+            }
+            if (st->m_ResidentMip != st->m_LoadingMip)
+            {
+                streamer->m_ResidentSize -= GetStreamedSize(st, st->m_LoadingMip) - GetStreamedSize(st, st->m_ResidentMip);
+                st->m_LoadFailed = 1;
+            }
+            if (texture_image)
+                dmDDF::FreeMessage(texture_image);
+            st->m_LoadingMip = st->m_ResidentMip;
+
+            ++load_count;
+            latency += dmTime::GetTime() - st->m_RequestTime;
+        }
+
+        for (uint32_t i = 0; i < streamer->m_Cancelled.Size();)
+        {
+            StreamedTexture* st = streamer->m_Cancelled[i];
+            void* data = 0;
+            dmResource::Result r = dmResource::EndRawLoad(streamer->m_Loader, st->m_Request, &data);
+            if (r == dmResource::RESULT_PENDING)
+            {
+                ++i;
+                continue;
+            }
+            if (data)
+                dmDDF::FreeMessage(data);
+            FreeStreamedTexture(st);
+            streamer->m_Cancelled.EraseSwap(i);
+        }
+
+        DM_COUNTER("TextureStreamingLoads", load_count);
+        DM_COUNTER("TextureStreamingLatency (ms)", (uint32_t)(latency / 1000));
+    }
+
+    static bool CompareLastRequestFrame(const StreamedTexture* a, const StreamedTexture* b)
+    {
+        return a->m_LastRequestFrame < b->m_LastRequestFrame;
+    }
+
+    // Evict the least recently requested textures back to their base mips, until size fits the budget
+    static bool Evict(TextureStreamer* streamer, uint64_t size)
+    {
+        if (streamer->m_ResidentSize + size <= streamer->m_MemoryBudget)
+            return true;
+
+        dmArray<StreamedTexture*>& evictable = streamer->m_Evictable;
+        evictable.SetSize(0);
+        if (evictable.Capacity() < streamer->m_Textures.Size())
+            evictable.SetCapacity(streamer->m_Textures.Size());
+        for (uint32_t i = 0; i < streamer->m_Textures.Size(); ++i)
+        {
+            StreamedTexture* st = streamer->m_Textures[i];
+            if (st->m_Requested && !st->m_Request && st->m_ResidentMip < st->m_BaseMip && streamer->m_Frame - st->m_LastRequestFrame >= STREAMING_EVICT_FRAMES)
+                evictable.Push(st);
+        }
+        std::sort(evictable.Begin(), evictable.End(), CompareLastRequestFrame);
+
+        for (uint32_t i = 0; i < evictable.Size() && streamer->m_ResidentSize + size > streamer->m_MemoryBudget; ++i)
+        {
+            StreamedTexture* st = evictable[i];
+            streamer->m_ResidentSize -= GetStreamedSize(st, st->m_ResidentMip);
+            SetStreamedTextureBaseMips(st);
+            st->m_LoadingMip = st->m_ResidentMip;
+        }
+        return streamer->m_ResidentSize + size <= streamer->m_MemoryBudget;
+    }
+
+    HTextureStreamer NewTextureStreamer(dmResource::HFactory factory, dmGraphics::HContext graphics_context, uint64_t memory_budget)
+    {
+        TextureStreamer* streamer = new TextureStreamer;
+        streamer->m_Loader = dmResource::NewRawLoader(factory);
+        streamer->m_GraphicsContext = graphics_context;
+        streamer->m_MemoryBudget = memory_budget;
+        streamer->m_ResidentSize = 0;
+        streamer->m_Frame = 0;
+        return streamer;
+    }
+
+    void DeleteTextureStreamer(HTextureStreamer streamer)
+    {
+        for (uint32_t i = 0; i < streamer->m_Textures.Size(); ++i)
+        {
+            StreamedTexture* st = streamer->m_Textures[i];
+            if (st->m_Request)
+            {
+                st->m_Texture = 0;
+                if (streamer->m_Cancelled.Full())
+                    streamer->m_Cancelled.OffsetCapacity(16);
+                streamer->m_Cancelled.Push(st);
+            }
+            else
+            {
+                FreeStreamedTexture(st);
+            }
+        }
+        streamer->m_Textures.SetSize(0);
+        while (!streamer->m_Cancelled.Empty())
+        {
+            CompleteLoads(streamer);
+            if (!streamer->m_Cancelled.Empty())
+                dmTime::Sleep(1000);
+        }
+        dmResource::DeleteRawLoader(streamer->m_Loader);
+        delete streamer;
+    }
+
+    void UpdateTextureStreamer(HTextureStreamer streamer)
+    {
+        DM_PROFILE(Texture, "UpdateTextureStreamer");
+
+        CompleteLoads(streamer);
+
+        uint32_t frame = streamer->m_Frame;
+        for (uint32_t i = 0; i < streamer->m_Textures.Size(); ++i)
+        {
+            StreamedTexture* st = streamer->m_Textures[i];
+            if (!st->m_Requested || st->m_LastRequestFrame != frame || st->m_Request || st->m_LoadFailed || !SynchronizeTexture(st->m_Texture, false))
+                continue;
+
+            uint32_t mip = dmMath::Min(st->m_RequestedMip, st->m_BaseMip);
+            if (mip >= st->m_ResidentMip)
+                continue;
+
+            uint64_t size = GetStreamedSize(st, mip) - GetStreamedSize(st, st->m_ResidentMip);
+            if (streamer->m_MemoryBudget && !Evict(streamer, size))
+                continue;
+
+            st->m_Request = dmResource::BeginRawLoad(streamer->m_Loader, st->m_Path, StreamedTexturePreload, st);
+            // The load queue is full, try again next frame
+            if (!st->m_Request)
+                break;
+            st->m_RequestTime = dmTime::GetTime();
+            st->m_LoadingMip = mip;
+            streamer->m_ResidentSize += size;
+        }
+
+        DM_COUNTER("TextureStreamingResident", (uint32_t) streamer->m_ResidentSize);
+        ++streamer->m_Frame;
+    }
+
+    bool IsTextureStreamed(HTextureStreamer streamer, dmGraphics::HTexture texture)
+    {
+        return streamer->m_TextureIndices.Get((uintptr_t) texture) != 0;
+    }
+
+    void RequestTextureMip(HTextureStreamer streamer, dmGraphics::HTexture texture, uint32_t mip)
+    {
+        uint32_t* index = streamer->m_TextureIndices.Get((uintptr_t) texture);
+        if (!index)
+            return;
+        StreamedTexture* st = streamer->m_Textures[*index];
+        if (st->m_LastRequestFrame != streamer->m_Frame || !st->m_Requested)
+        {
+            st->m_LastRequestFrame = streamer->m_Frame;
+            st->m_RequestedMip = st->m_BaseMip;
+            st->m_Requested = 1;
+        }
+        st->m_RequestedMip = dmMath::Min((uint32_t) st->m_RequestedMip, mip);
+    }
+
+    dmResource::Result AcquireResources(const char* path, dmResource::SResourceDescriptor* resource_desc, dmGraphics::HContext context, TextureStreamer* streamer, ImageDesc* image_desc, dmGraphics::HTexture texture, dmGraphics::HTexture* texture_out)
     {
         dmResource::Result result = dmResource::RESULT_FORMAT_ERROR;
         for (uint32_t i = 0; i < image_desc->m_DDFImage->m_Alternatives.m_Count; ++i)
@@ -128,11 +541,20 @@ namespace dmGameSystem
             } else {
                 assert(0);
             }
-            creation_params.m_Width = image->m_Width;
-            creation_params.m_Height = image->m_Height;
+
+            // Streamed textures start out with their base mips
+            uint32_t first_mip = 0;
+            if (streamer && path && creation_params.m_Type == dmGraphics::TEXTURE_TYPE_2D && !image_desc->m_UseBlankTexture &&
+                !dmGraphics::IsFormatTranscoded(image->m_CompressionType))
+            {
+                first_mip = GetStreamingBaseMip(image->m_Width, image->m_Height, num_mips);
+            }
+
+            creation_params.m_Width = dmMath::Max(1U, image->m_Width >> first_mip);
+            creation_params.m_Height = dmMath::Max(1U, image->m_Height >> first_mip);
             creation_params.m_OriginalWidth = image->m_OriginalWidth;
             creation_params.m_OriginalHeight = image->m_OriginalHeight;
-            creation_params.m_MipMapCount = image->m_MipMapOffset.m_Count;
+            creation_params.m_MipMapCount = image->m_MipMapOffset.m_Count - first_mip;
 
             if (!texture)
                 texture = dmGraphics::NewTexture(context, creation_params);
@@ -160,9 +582,16 @@ namespace dmGameSystem
                 break;
             }
 
-            for (uint32_t i = 0; i < num_mips; ++i)
+            if (first_mip > 0)
+            {
+                AddStreamedTexture(streamer, texture, path, image, i, first_mip, params);
+                params.m_Width = creation_params.m_Width;
+                params.m_Height = creation_params.m_Height;
+            }
+
+            for (uint32_t i = first_mip; i < num_mips; ++i)
             {
-                params.m_MipMap = i;
+                params.m_MipMap = i - first_mip;
                 params.m_Data = image_desc->m_DecompressedData[i] == 0 ? &image->m_Data[image->m_MipMapOffset[i]] : image_desc->m_DecompressedData[i];
                 params.m_DataSize = image_desc->m_DecompressedData[i] == 0 ? image->m_MipMapSize[i] : image_desc->m_DecompressedDataSize[i];
                 dmGraphics::SetTextureAsync(texture, params);
@@ -235,7 +664,7 @@ namespace dmGameSystem
             return dmResource::RESULT_FORMAT_ERROR;
         }
 
-        ImageDesc* image_desc = CreateImage(params.m_Filename, (dmGraphics::HContext) params.m_Context, texture_image);
+        ImageDesc* image_desc = CreateImage(params.m_Filename, ((TextureContext*) params.m_Context)->m_GraphicsContext, texture_image);
         *params.m_PreloadData = image_desc;
         return dmResource::RESULT_OK;
     }
@@ -258,9 +687,9 @@ namespace dmGameSystem
 
     dmResource::Result ResTextureCreate(const dmResource::ResourceCreateParams& params)
     {
-        dmGraphics::HContext graphics_context = (dmGraphics::HContext) params.m_Context;
+        TextureContext* context = (TextureContext*) params.m_Context;
         dmGraphics::HTexture texture;
-        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, (ImageDesc*) params.m_PreloadData, 0, &texture);
+        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, context->m_GraphicsContext, context->m_Streamer, (ImageDesc*) params.m_PreloadData, 0, &texture);
         if (r == dmResource::RESULT_OK)
         {
             params.m_Resource->m_Resource = (void*) texture;
@@ -270,7 +699,11 @@ namespace dmGameSystem
 
     dmResource::Result ResTextureDestroy(const dmResource::ResourceDestroyParams& params)
     {
-        dmGraphics::DeleteTexture((dmGraphics::HTexture) params.m_Resource->m_Resource);
+        TextureContext* context = (TextureContext*) params.m_Context;
+        dmGraphics::HTexture texture = (dmGraphics::HTexture) params.m_Resource->m_Resource;
+        if (context->m_Streamer)
+            RemoveStreamedTexture(context->m_Streamer, texture);
+        dmGraphics::DeleteTexture(texture);
         return dmResource::RESULT_OK;
     }
 
@@ -285,16 +718,21 @@ namespace dmGameSystem
                 return dmResource::RESULT_FORMAT_ERROR;
             }
         }
-        dmGraphics::HContext graphics_context = (dmGraphics::HContext) params.m_Context;
+        TextureContext* context = (TextureContext*) params.m_Context;
+        dmGraphics::HContext graphics_context = context->m_GraphicsContext;
         dmGraphics::HTexture texture = (dmGraphics::HTexture) params.m_Resource->m_Resource;
 
         // Create the image from the DDF data.
         // Note that the image desc for performance reasons keeps references to the DDF image, meaning they're invalid after the DDF message has been free'd!
-        ImageDesc* image_desc = CreateImage(params.m_Filename, (dmGraphics::HContext) params.m_Context, texture_image);
+        ImageDesc* image_desc = CreateImage(params.m_Filename, graphics_context, texture_image);
+
+        // The new image is set in full, since the file no longer holds the mips of the texture
+        if (context->m_Streamer)
+            RemoveStreamedTexture(context->m_Streamer, texture);
 
         // Set up the new texture (version), wait for it to finish before issuing new requests
         SynchronizeTexture(texture, true);
-        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, image_desc, texture, &texture);
+        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, 0, image_desc, texture, &texture);
 
         // Wait for any async texture uploads
         SynchronizeTexture(texture, true);
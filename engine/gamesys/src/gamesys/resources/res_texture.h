@@ -15,6 +15,8 @@
 
 #include <resource/resource.h>
 #include <dmsdk/gamesys/resources/res_texture.h>
+#include <graphics/graphics.h>
+#include "../gamesys.h"
 
 namespace dmGameSystem
 {
@@ -27,6 +29,15 @@ namespace dmGameSystem
     dmResource::Result ResTextureDestroy(const dmResource::ResourceDestroyParams& params);
 
     dmResource::Result ResTextureRecreate(const dmResource::ResourceRecreateParams& params);
+
+    /// @return true if the texture has mips that are loaded on demand
+    bool IsTextureStreamed(HTextureStreamer streamer, dmGraphics::HTexture texture);
+
+    /**
+     * Request the mip needed to render the texture this frame, 0 being the full resolution.
+     * The lowest mip requested during the frame is loaded by UpdateTextureStreamer.
+     */
+    void RequestTextureMip(HTextureStreamer streamer, dmGraphics::HTexture texture, uint32_t mip);
 }
 
 #endif
@@ -325,6 +325,40 @@ namespace dmGameSystem
         return 1;
     }
 
+    /*# set mixer group voice limit
+     * Set the max number of sounds in the group that are decoded and mixed at the same time.
+     * The sounds over the limit with the lowest priority and gain continue playing
+     * without being heard, and are faded in again when there is room. Inaudible sounds are never counted.
+     *
+     * @param group [type:string|hash] group name
+     * @param max_voices [type:number] max number of audible sounds, 0 for no limit
+     * @name sound.set_group_voice_limit
+     * @examples
+     *
+     * Hear at most 8 of the sounds in the "footsteps" group:
+     *
+     * ```lua
+     * sound.set_group_voice_limit("footsteps", 8)
+     * ```
+     */
+    static int Sound_SetGroupVoiceLimit(lua_State* L)
+    {
+        int top = lua_gettop(L);
+        dmhash_t group_hash = CheckGroupName(L, 1);
+        int max_voices = luaL_checkinteger(L, 2);
+        if (max_voices < 0) {
+            return luaL_error(L, "The voice limit can not be negative: %d", max_voices);
+        }
+
+        dmSound::Result r = dmSound::SetGroupVoiceLimit(group_hash, (uint32_t) max_voices);
+        if (r != dmSound::RESULT_OK) {
+            dmLogWarning("Failed to set group voice limit (%d)", r);
+        }
+
+        assert(top == lua_gettop(L));
+        return 0;
+    }
+
     /*# get all mixer group names
      * Get a table of all mixer group names (hashes).
      *
@@ -708,6 +742,7 @@ namespace dmGameSystem
         {"get_peak", Sound_GetPeak},
         {"set_group_gain", Sound_SetGroupGain},
         {"get_group_gain", Sound_GetGroupGain},
+        {"set_group_voice_limit", Sound_SetGroupVoiceLimit},
         {"get_groups", Sound_GetGroups},
         {"get_group_name", Sound_GetGroupName},
         {"is_phone_call_active", Sound_IsPhoneCallActive},
@@ -0,0 +1,12 @@
+components {
+  id: "label1"
+  component: "/label/valid.label"
+}
+components {
+  id: "label2"
+  component: "/label/valid.label"
+}
+components {
+  id: "label3"
+  component: "/label/valid.label"
+}
@@ -0,0 +1,12 @@
+components {
+  id: "model1"
+  component: "/model/instanced.model"
+}
+components {
+  id: "model2"
+  component: "/model/instanced.model"
+}
+components {
+  id: "model3"
+  component: "/model/instanced.model"
+}
@@ -27,8 +27,12 @@
 #include <ddf/ddf.h>
 #include <gameobject/gameobject_ddf.h>
 #include <gamesys/gamesys_ddf.h>
+#include <gamesys/label_ddf.h>
 #include <gamesys/sprite_ddf.h>
 #include "../components/comp_label.h"
+#include "../components/comp_tilegrid.h"
+#include "../resources/res_texture.h"
+#include "../resources/res_tilegrid.h"
 
 #include <dmsdk/gamesys/render_constants.h>
 
@@ -305,9 +309,9 @@ TEST_P(InvalidVertexSpaceTest, InvalidVertexSpace)
     void* resource;
     ASSERT_NE(dmResource::RESULT_OK, dmResource::Get(m_Factory, resource_name, &resource));
 }
-
-
-
+
+
+
 
 // Test for input consuming in collection proxy
 TEST_F(ComponentTest, ConsumeInputInCollectionProxy)
@@ -1437,23 +1441,23 @@ TEST_F(GamepadConnectedTest, TestGamepadConnectedInputEvent)
 
     dmGameSystem::FinalizeScriptLibs(scriptlibcontext);
 }
-
-TEST_F(CollisionObject2DTest, WakingCollisionObjectTest)
-{
-    dmHashEnableReverseHash(true);
-    lua_State* L = dmScript::GetLuaState(m_ScriptContext);
-
-    dmGameSystem::ScriptLibContext scriptlibcontext;
-    scriptlibcontext.m_Factory = m_Factory;
-    scriptlibcontext.m_Register = m_Register;
-    scriptlibcontext.m_LuaState = L;
+
+TEST_F(CollisionObject2DTest, WakingCollisionObjectTest)
+{
+    dmHashEnableReverseHash(true);
+    lua_State* L = dmScript::GetLuaState(m_ScriptContext);
+
+    dmGameSystem::ScriptLibContext scriptlibcontext;
+    scriptlibcontext.m_Factory = m_Factory;
+    scriptlibcontext.m_Register = m_Register;
+    scriptlibcontext.m_LuaState = L;
     dmGameSystem::InitializeScriptLibs(scriptlibcontext);
 
     // a 'base' gameobject works as the base for other dynamic objects to stand on
     const char* path_sleepy_go = "/collision_object/sleepy_base.goc";
     dmhash_t hash_base_go = dmHashString64("/base-go");
-    // place the base object so that the upper level of base is at Y = 0
-    dmGameObject::HInstance base_go = Spawn(m_Factory, m_Collection, path_sleepy_go, hash_base_go, 0, 0, Point3(50, -10, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    // place the base object so that the upper level of base is at Y = 0
+    dmGameObject::HInstance base_go = Spawn(m_Factory, m_Collection, path_sleepy_go, hash_base_go, 0, 0, Point3(50, -10, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
     ASSERT_NE((void*)0, base_go);
 
     // two dynamic 'body' objects will get spawned and placed apart
@@ -1468,23 +1472,23 @@ TEST_F(CollisionObject2DTest, WakingCollisionObjectTest)
     ASSERT_NE((void*)0, body2_go);
 
 
-    // iterate until the lua env signals the end of the test of error occurs
-    bool tests_done = false;
-    while (!tests_done)
-    {
-        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
-        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    // iterate until the lua env signals the end of the test of error occurs
+    bool tests_done = false;
+    while (!tests_done)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
 
         ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
-        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
-        // check if tests are done
-        lua_getglobal(L, "tests_done");
-        tests_done = lua_toboolean(L, -1);
-        lua_pop(L, 1);
-    }
-
-    ASSERT_TRUE(dmGameObject::Final(m_Collection));
-}
+        ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+        // check if tests are done
+        lua_getglobal(L, "tests_done");
+        tests_done = lua_toboolean(L, -1);
+        lua_pop(L, 1);
+    }
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
 
 // Test case for collision-object properties
 TEST_F(CollisionObject2DTest, PropertiesTest)
@@ -1944,7 +1948,7 @@ const char* valid_tileset_resources[] = {"/tile/valid.texturesetc"};
 INSTANTIATE_TEST_CASE_P(TileSet, ResourceTest, jc_test_values_in(valid_tileset_resources));
 
 /* TileGrid */
-const char* valid_tilegrid_resources[] = {"/tile/valid.tilemapc"};
+const char* valid_tilegrid_resources[] = {"/tile/valid.tilemapc", "/tile/local_vertexspace.tilemapc"};
 INSTANTIATE_TEST_CASE_P(TileGrid, ResourceTest, jc_test_values_in(valid_tilegrid_resources));
 
 const char* valid_tileset_gos[] = {"/tile/valid_tilegrid.goc", "/tile/valid_tilegrid_collisionobject.goc"};
@@ -1961,6 +1965,68 @@ ResourceFailParams invalid_texture_resources[] =
 };
 INSTANTIATE_TEST_CASE_P(Texture, ResourceFailTest, jc_test_values_in(invalid_texture_resources));
 
+/* Texture streaming */
+
+// Request the mip each frame until the texture has the width
+static bool StreamTexture(dmGameSystem::HTextureStreamer streamer, dmGraphics::HTexture texture, uint32_t mip, uint32_t width)
+{
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        dmGameSystem::RequestTextureMip(streamer, texture, mip);
+        dmGameSystem::UpdateTextureStreamer(streamer);
+        if (dmGraphics::GetTextureWidth(texture) == width)
+            return true;
+        dmTime::Sleep(1000);
+    }
+    return false;
+}
+
+TEST_P(TextureStreamingTest, StreamAndEvict)
+{
+    // Room for the full resolution of one of the 128x128 textures
+    dmGameSystem::HTextureStreamer streamer = dmGameSystem::NewTextureStreamer(m_Factory, m_GraphicsContext, 128 * 128 * 4);
+    m_TextureContext.m_Streamer = streamer;
+
+    dmGraphics::HTexture texture;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, GetParam(), (void**) &texture));
+    ASSERT_TRUE(dmGameSystem::IsTextureStreamed(streamer, texture));
+    ASSERT_EQ(64, dmGraphics::GetTextureWidth(texture));
+    ASSERT_EQ(64, dmGraphics::GetTextureHeight(texture));
+    ASSERT_EQ(128, dmGraphics::GetOriginalTextureWidth(texture));
+
+    // Textures no component requests keep their base mips
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        dmGameSystem::UpdateTextureStreamer(streamer);
+    }
+    ASSERT_EQ(64, dmGraphics::GetTextureWidth(texture));
+
+    ASSERT_TRUE(StreamTexture(streamer, texture, 0, 128));
+    ASSERT_EQ(128, dmGraphics::GetTextureHeight(texture));
+
+    // The second texture only fits once the first has gone unrequested long enough to be evicted
+    dmGraphics::HTexture texture_b;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/texture/stream_png_128.texturec", (void**) &texture_b));
+    ASSERT_EQ(64, dmGraphics::GetTextureWidth(texture_b));
+    ASSERT_TRUE(StreamTexture(streamer, texture_b, 0, 128));
+    ASSERT_EQ(64, dmGraphics::GetTextureWidth(texture));
+
+    dmResource::Release(m_Factory, texture_b);
+    dmResource::Release(m_Factory, texture);
+
+    // Textures that don't fit at all keep their base mips
+    dmGameSystem::DeleteTextureStreamer(streamer);
+    streamer = dmGameSystem::NewTextureStreamer(m_Factory, m_GraphicsContext, 1);
+    m_TextureContext.m_Streamer = streamer;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, GetParam(), (void**) &texture));
+    ASSERT_FALSE(StreamTexture(streamer, texture, 0, 128));
+    ASSERT_EQ(64, dmGraphics::GetTextureWidth(texture));
+    dmResource::Release(m_Factory, texture);
+}
+
+const char* texture_streaming_resources[] = {"/texture/valid_png_128.texturec"};
+INSTANTIATE_TEST_CASE_P(TextureStreaming, TextureStreamingTest, jc_test_values_in(texture_streaming_resources));
+
 /* Vertex Program */
 
 const char* valid_vp_resources[] = {"/vertex_program/valid.vpc"};
@@ -1987,6 +2053,78 @@ INSTANTIATE_TEST_CASE_P(SpineModel, ComponentTest, jc_test_values_in(valid_spine
 
 /* Label */
 
+static uint32_t RenderLabelFrame(dmGameObject::HCollection collection, dmRender::HRenderContext render_context, dmGameObject::UpdateContext* update_context, void* label_world)
+{
+    dmGameObject::Update(collection, update_context);
+    dmRender::RenderListBegin(render_context);
+    dmGameObject::Render(collection);
+    dmRender::RenderListEnd(render_context);
+    dmRender::DrawRenderList(render_context, 0x0, 0x0);
+    dmGameObject::PostUpdate(collection);
+
+    dmGameSystem::LabelStats stats;
+    dmGameSystem::GetLabelStats(label_world, &stats);
+    return stats.m_LayoutCount;
+}
+
+// The glyph layout is cached and only redone when the text, text area size or font changes
+TEST_F(LabelRenderTest, Relayout)
+{
+    dmhash_t go_id = dmHashString64("/go");
+    dmhash_t label_id = dmHashString64("label");
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/label/valid_label.goc", go_id, 0, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    dmResource::ResourceType resource_type;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::GetTypeFromExtension(m_Factory, "labelc", &resource_type));
+    uint32_t component_type_index;
+    ASSERT_NE((void*)0, dmGameObject::FindComponentType(m_Register, resource_type, &component_type_index));
+    void* label_world = dmGameObject::GetWorld(m_Collection, component_type_index);
+    ASSERT_NE((void*)0, label_world);
+
+    ASSERT_EQ(1U, RenderLabelFrame(m_Collection, m_RenderContext, &m_UpdateContext, label_world));
+    ASSERT_EQ(0U, RenderLabelFrame(m_Collection, m_RenderContext, &m_UpdateContext, label_world));
+
+    // Transform and color changes reuse the layout
+    dmGameObject::SetPosition(go, Point3(10, 20, 0));
+    dmGameObject::SetRotation(go, Quat::rotationZ(1.0f));
+    ASSERT_EQ(0U, RenderLabelFrame(m_Collection, m_RenderContext, &m_UpdateContext, label_world));
+
+    dmGameObject::PropertyVar color(Vector4(1.0f, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::SetProperty(go, label_id, dmHashString64("color"), color));
+    ASSERT_EQ(0U, RenderLabelFrame(m_Collection, m_RenderContext, &m_UpdateContext, label_world));
+
+    // A new text area size lays the text out again
+    dmGameObject::PropertyVar size(Vector3(64.0f, 32.0f, 0.0f));
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::SetProperty(go, label_id, dmHashString64("size"), size));
+    ASSERT_EQ(1U, RenderLabelFrame(m_Collection, m_RenderContext, &m_UpdateContext, label_world));
+
+    // So does a new text
+    const char* text = "Relayout";
+    uint32_t text_length = strlen(text) + 1;
+    uint8_t msg_data[sizeof(dmGameSystemDDF::SetText) + 16];
+    ASSERT_LE(sizeof(dmGameSystemDDF::SetText) + text_length, sizeof(msg_data));
+    dmGameSystemDDF::SetText* msg = (dmGameSystemDDF::SetText*)msg_data;
+    msg->m_Text = (const char*)sizeof(dmGameSystemDDF::SetText);
+    memcpy(msg_data + sizeof(dmGameSystemDDF::SetText), text, text_length);
+
+    dmMessage::URL msg_url;
+    dmMessage::ResetURL(&msg_url);
+    msg_url.m_Socket = dmGameObject::GetMessageSocket(m_Collection);
+    msg_url.m_Path = go_id;
+    msg_url.m_Fragment = label_id;
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(&msg_url, &msg_url, dmGameSystemDDF::SetText::m_DDFDescriptor->m_NameHash, (uintptr_t)go, (uintptr_t)dmGameSystemDDF::SetText::m_DDFDescriptor, msg_data, sizeof(dmGameSystemDDF::SetText) + text_length, 0));
+    ASSERT_EQ(1U, RenderLabelFrame(m_Collection, m_RenderContext, &m_UpdateContext, label_world));
+
+    // And a reload of the font
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::ReloadResource(m_Factory, "/font/valid_font.fontc", 0));
+    ASSERT_EQ(1U, RenderLabelFrame(m_Collection, m_RenderContext, &m_UpdateContext, label_world));
+    ASSERT_EQ(0U, RenderLabelFrame(m_Collection, m_RenderContext, &m_UpdateContext, label_world));
+
+    dmGraphics::Flip(m_GraphicsContext);
+}
+
+
 void AssertPointEquals(const Vector4& p, float x, float y)
 {
     static const float test_epsilon = 0.000001f;
@@ -2065,7 +2203,6 @@ const char* invalid_vertexspace_resources[] =
     "/sprite/invalid_vertexspace.spritec",
     "/model/invalid_vertexspace.modelc",
     "/spine/invalid_vertexspace.spinemodelc",
-    "/tile/invalid_vertexspace.tilegridc",
     "/particlefx/invalid_vertexspace.particlefxc",
     "/gui/invalid_vertexspace.guic",
     "/label/invalid_vertexspace.labelc",
@@ -2115,6 +2252,9 @@ DrawCountParams draw_count_params[] =
 {
     {"/gui/draw_count_test.goc", 2},
     {"/gui/draw_count_test2.goc", 1},
+    {"/model/local_models.goc", 3},
+    {"/model/instanced_models.goc", 1}, // The models sharing geometry are drawn instanced
+    {"/label/draw_count_labels.goc", 1}, // The labels sharing font and material are drawn in one batch
 };
 INSTANTIATE_TEST_CASE_P(DrawCount, DrawCountTest, jc_test_values_in(draw_count_params));
 
@@ -2982,6 +3122,192 @@ TEST_F(RenderConstantsTest, SetGetConstant)
     dmResource::Release(m_Factory, material);
 }
 
+/* Tile grid */
+
+struct TileGridBenchmarkState
+{
+    dmGameObject::UpdateContext*    m_UpdateContext;
+    dmRender::HRenderContext        m_RenderContext;
+    dmGameSystem::TilemapContext*   m_Context;
+    void*                           m_World;
+};
+
+static void RenderTileGridFrame(const TileGridBenchmarkState& state, const Matrix4& view)
+{
+    dmGameObject::ComponentsUpdateParams update_params;
+    update_params.m_Collection = 0;
+    update_params.m_UpdateContext = state.m_UpdateContext;
+    update_params.m_World = state.m_World;
+    update_params.m_Context = state.m_Context;
+    dmGameObject::ComponentsUpdateResult update_result;
+    dmGameSystem::CompTileGridUpdate(update_params, update_result);
+
+    dmRender::SetViewMatrix(state.m_RenderContext, view);
+
+    dmRender::RenderListBegin(state.m_RenderContext);
+    dmGameObject::ComponentsRenderParams render_params;
+    render_params.m_Collection = 0;
+    render_params.m_World = state.m_World;
+    render_params.m_Context = state.m_Context;
+    dmGameSystem::CompTileGridRender(render_params);
+    dmRender::RenderListEnd(state.m_RenderContext);
+    dmRender::DrawRenderList(state.m_RenderContext, 0x0, 0x0);
+}
+
+// A 2000x2000 tile grid viewed through a 1280x720 camera, which covers 3x2 regions of 32x32 tiles (16x16 pixels each).
+// The regions are culled against the view expanded by a quarter on each side, which keeps 4x2 regions.
+TEST_F(TileGridTest, RegionBufferBenchmark)
+{
+    dmGameSystem::TileGridResource* resource = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/tile/tilegrid_benchmark.tilemapc", (void**)&resource));
+    dmGameObject::HInstance instance = dmGameObject::New(m_Collection, 0x0);
+    ASSERT_NE((void*)0, instance);
+
+    m_TilemapContext.m_MaxTileCount = 16384;
+
+    TileGridBenchmarkState state;
+    state.m_UpdateContext = &m_UpdateContext;
+    state.m_RenderContext = m_RenderContext;
+    state.m_Context = &m_TilemapContext;
+    state.m_World = 0;
+
+    dmGameObject::ComponentNewWorldParams world_params;
+    world_params.m_Context = &m_TilemapContext;
+    world_params.m_ComponentIndex = 0;
+    world_params.m_MaxInstances = 1;
+    world_params.m_World = &state.m_World;
+    ASSERT_EQ(dmGameObject::CREATE_RESULT_OK, dmGameSystem::CompTileGridNewWorld(world_params));
+
+    uintptr_t user_data = 0;
+    dmGameObject::ComponentCreateParams create_params;
+    create_params.m_Instance = instance;
+    create_params.m_Position = Point3(0.0f, 0.0f, 0.0f);
+    create_params.m_Rotation = Quat::identity();
+    create_params.m_Resource = resource;
+    create_params.m_World = state.m_World;
+    create_params.m_Context = &m_TilemapContext;
+    create_params.m_UserData = &user_data;
+    create_params.m_ComponentIndex = 0;
+    ASSERT_EQ(dmGameObject::CREATE_RESULT_OK, dmGameSystem::CompTileGridCreate(create_params));
+
+    dmGameObject::ComponentAddToUpdateParams add_params;
+    add_params.m_Collection = m_Collection;
+    add_params.m_Instance = instance;
+    add_params.m_World = state.m_World;
+    add_params.m_Context = &m_TilemapContext;
+    add_params.m_UserData = &user_data;
+    dmGameSystem::CompTileGridAddToUpdate(add_params);
+
+    dmGameSystem::TileGridComponent* component = (dmGameSystem::TileGridComponent*) user_data;
+    int32_t min_x, min_y, width, height;
+    dmGameSystem::GetTileGridBounds(component, &min_x, &min_y, &width, &height);
+    ASSERT_EQ(2000, width);
+    ASSERT_EQ(2000, height);
+    for (int32_t y = 0; y < height; ++y)
+    {
+        for (int32_t x = 0; x < width; ++x)
+        {
+            dmGameSystem::SetTileGridTile(component, 0, x, y, (x + y) % 4, false, false);
+        }
+    }
+
+    dmRender::SetProjectionMatrix(m_RenderContext, Matrix4::orthographic(0.0f, 1280.0f, 0.0f, 720.0f, -1.0f, 1.0f));
+
+    const uint32_t region_size = 32U * 32U * 6U * 5U * sizeof(float);
+
+    // Only the regions near the view are built, and the layer is drawn with one draw call
+    dmGameSystem::TileGridStats stats;
+    RenderTileGridFrame(state, Matrix4::identity());
+    ASSERT_EQ(1U, dmGraphics::GetDrawCount());
+    dmGameSystem::GetTileGridStats(state.m_World, &stats);
+    ASSERT_EQ(8U, stats.m_BuildCount);
+    ASSERT_EQ(8U * region_size, stats.m_UploadSize);
+    dmGraphics::Flip(m_GraphicsContext);
+
+    // An unchanged frame rebuilds and uploads nothing
+    RenderTileGridFrame(state, Matrix4::identity());
+    ASSERT_EQ(1U, dmGraphics::GetDrawCount());
+    dmGameSystem::GetTileGridStats(state.m_World, &stats);
+    ASSERT_EQ(0U, stats.m_BuildCount);
+    ASSERT_EQ(0U, stats.m_UploadSize);
+    dmGraphics::Flip(m_GraphicsContext);
+
+    // Editing one tile rebuilds and uploads only its region
+    dmGameSystem::SetTileGridTile(component, 0, 40, 20, 1, false, false);
+    RenderTileGridFrame(state, Matrix4::identity());
+    dmGameSystem::GetTileGridStats(state.m_World, &stats);
+    ASSERT_EQ(1U, stats.m_BuildCount);
+    ASSERT_EQ(region_size, stats.m_UploadSize);
+    dmGraphics::Flip(m_GraphicsContext);
+
+    // Moving the tile grid draws the vertices with the new world transform, without rebuilding them
+    dmGameObject::SetPosition(instance, Point3(-100.0f, -50.0f, 0.0f));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    RenderTileGridFrame(state, Matrix4::identity());
+    ASSERT_EQ(1U, dmGraphics::GetDrawCount());
+    dmGameSystem::GetTileGridStats(state.m_World, &stats);
+    ASSERT_EQ(0U, stats.m_BuildCount);
+    ASSERT_EQ(0U, stats.m_UploadSize);
+    dmGraphics::Flip(m_GraphicsContext);
+
+    // Moving it further repacks the regions near the view, and only builds the ones that weren't packed
+    dmGameObject::SetPosition(instance, Point3(-600.0f, 0.0f, 0.0f));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    RenderTileGridFrame(state, Matrix4::identity());
+    ASSERT_EQ(1U, dmGraphics::GetDrawCount());
+    dmGameSystem::GetTileGridStats(state.m_World, &stats);
+    ASSERT_EQ(2U, stats.m_BuildCount);
+    ASSERT_EQ(10U * region_size, stats.m_UploadSize);
+    dmGraphics::Flip(m_GraphicsContext);
+
+    dmGameObject::SetPosition(instance, Point3(0.0f, 0.0f, 0.0f));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    const uint32_t frame_count = 300;
+    const uint32_t edit_counts[] = {0, 16, 256};
+    for (uint32_t e = 0; e < sizeof(edit_counts) / sizeof(edit_counts[0]); ++e)
+    {
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            // Edit tiles in view
+            for (uint32_t i = 0; i < edit_counts[e]; ++i)
+            {
+                dmGameSystem::SetTileGridTile(component, 0, rand() % 80, rand() % 45, rand() % 4, false, false);
+            }
+            RenderTileGridFrame(state, Matrix4::identity());
+            dmGraphics::Flip(m_GraphicsContext);
+        }
+        uint64_t end = dmTime::GetTime();
+        printf("Static view, %u edited tiles per frame: %.3f ms/frame\n", edit_counts[e], (end - start) / (frame_count * 1000.0f));
+    }
+
+    // Scrolling 4 pixels per frame builds the regions scrolled into view
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t frame = 0; frame < frame_count; ++frame)
+    {
+        RenderTileGridFrame(state, Matrix4::translation(Vector3(-4.0f * frame, -2.0f * frame, 0.0f)));
+        dmGraphics::Flip(m_GraphicsContext);
+    }
+    uint64_t end = dmTime::GetTime();
+    printf("Scrolling view: %.3f ms/frame\n", (end - start) / (frame_count * 1000.0f));
+
+    dmGameObject::ComponentDestroyParams destroy_params;
+    destroy_params.m_Collection = m_Collection;
+    destroy_params.m_Instance = instance;
+    destroy_params.m_World = state.m_World;
+    destroy_params.m_Context = &m_TilemapContext;
+    destroy_params.m_UserData = &user_data;
+    ASSERT_EQ(dmGameObject::CREATE_RESULT_OK, dmGameSystem::CompTileGridDestroy(destroy_params));
+
+    dmGameObject::ComponentDeleteWorldParams delete_world_params;
+    delete_world_params.m_Context = &m_TilemapContext;
+    delete_world_params.m_World = state.m_World;
+    dmGameSystem::CompTileGridDeleteWorld(delete_world_params);
+
+    dmGameObject::Delete(m_Collection, instance, false);
+    dmResource::Release(m_Factory, resource);
+}
 
 int main(int argc, char **argv)
 {
@@ -86,6 +86,7 @@ protected:
     dmGameSystem::PhysicsContext m_PhysicsContext;
     dmGameSystem::ParticleFXContext m_ParticleFXContext;
     dmGameSystem::GuiContext m_GuiContext;
+    dmGameSystem::TextureContext m_TextureContext;
     dmHID::HContext m_HidContext;
     dmInput::HContext m_InputContext;
     dmInputDDF::GamepadMaps* m_GamepadMapsDDF;
@@ -307,6 +308,24 @@ public:
     virtual ~RenderConstantsTest() {}
 };
 
+class TileGridTest : public GamesysTest<const char*>
+{
+public:
+    virtual ~TileGridTest() {}
+};
+
+class LabelRenderTest : public GamesysTest<const char*>
+{
+public:
+    virtual ~LabelRenderTest() {}
+};
+
+class TextureStreamingTest : public GamesysTest<const char*>
+{
+public:
+    virtual ~TextureStreamingTest() {}
+};
+
 bool CopyResource(const char* src, const char* dst);
 bool UnlinkResource(const char* name);
 
@@ -385,6 +404,7 @@ void GamesysTest<T>::SetUp()
     m_CollectionFactoryContext.m_ScriptContext = m_ScriptContext;
 
     m_LabelContext.m_RenderContext = m_RenderContext;
+    m_LabelContext.m_Factory = m_Factory;
     m_LabelContext.m_MaxLabelCount = 32;
     m_LabelContext.m_Subpixels     = 0;
 
@@ -404,7 +424,9 @@ void GamesysTest<T>::SetUp()
 
     m_SoundContext.m_MaxComponentCount = 32;
 
-    dmResource::Result r = dmGameSystem::RegisterResourceTypes(m_Factory, m_RenderContext, &m_GuiContext, m_InputContext, &m_PhysicsContext);
+    m_TextureContext.m_GraphicsContext = m_GraphicsContext;
+
+    dmResource::Result r = dmGameSystem::RegisterResourceTypes(m_Factory, m_RenderContext, &m_GuiContext, m_InputContext, &m_PhysicsContext, &m_TextureContext);
     assert(dmResource::RESULT_OK == r);
 
     dmResource::Get(m_Factory, "/input/valid.gamepadsc", (void**)&m_GamepadMapsDDF);
@@ -446,6 +468,8 @@ void GamesysTest<T>::TearDown()
     dmGraphics::DeleteContext(m_GraphicsContext);
     dmScript::Finalize(m_ScriptContext);
     dmScript::DeleteContext(m_ScriptContext);
+    if (m_TextureContext.m_Streamer)
+        dmGameSystem::DeleteTextureStreamer(m_TextureContext.m_Streamer);
     dmResource::DeleteFactory(m_Factory);
     dmGameObject::DeleteRegister(m_Register);
     dmSound::Finalize();
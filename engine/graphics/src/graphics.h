@@ -495,6 +495,34 @@ namespace dmGraphics
     void DrawElements(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer);
     void Draw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count);
 
+    /**
+     * Enable a vertex declaration of per-instance data, used together with the declaration enabled with
+     * EnableVertexDeclaration. Its streams advance once per instance in DrawInstanced and DrawElementsInstanced.
+     * A float stream of size 16 is a 4x4 matrix, bound as four vec4 columns at consecutive attribute locations.
+     * Streams not used by the program are ignored.
+     * @param context Graphics context
+     * @param vertex_declaration Instance vertex declaration
+     * @param vertex_buffer Buffer with the instance data
+     * @param buffer_offset Byte offset of the first instance in the buffer
+     * @param program Program to bind the streams to
+     */
+    void EnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t buffer_offset, HProgram program);
+    void DisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration);
+
+    /**
+     * Draw several instances of the same geometry in one draw call. Requires IsInstancingSupported
+     * and an enabled instance vertex declaration, see EnableInstanceVertexDeclaration.
+     */
+    void DrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer, uint32_t instance_count);
+    void DrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count);
+
+    /**
+     * Check if instanced drawing is supported by the context
+     * @param context Graphics context
+     * @return True if DrawInstanced and DrawElementsInstanced can be used
+     */
+    bool IsInstancingSupported(HContext context);
+
     HVertexProgram NewVertexProgram(HContext context, ShaderDesc::Shader* ddf);
     HFragmentProgram NewFragmentProgram(HContext context, ShaderDesc::Shader* ddf);
     HProgram NewProgram(HContext context, HVertexProgram vertex_program, HFragmentProgram fragment_program);
@@ -514,6 +542,7 @@ namespace dmGraphics
     uint32_t GetUniformName(HProgram prog, uint32_t index, char* buffer, uint32_t buffer_size, Type* type);
     uint32_t GetUniformCount(HProgram prog);
     int32_t  GetUniformLocation(HProgram prog, const char* name);
+    int32_t  GetAttributeLocation(HProgram prog, const char* name);
 
     void SetConstantV4(HContext context, const Vectormath::Aos::Vector4* data, int base_register);
     void SetConstantM4(HContext context, const Vectormath::Aos::Vector4* data, int base_register);
@@ -146,6 +146,43 @@ namespace dmGraphics
         return true;
     }
 
+    bool GLSLAttributeParse(const char* buffer, AttributeCallback cb, uintptr_t userdata)
+    {
+        if (buffer == 0x0)
+            return true;
+        const char* word_end = buffer;
+        const char* word_start = buffer;
+        uint32_t size = 0;
+        while (*word_end != '\0')
+        {
+            NextWord(&word_start, &word_end, &size);
+
+            if (size > 0)
+            {
+                if (STRNCMP("attribute", word_start, size))
+                {
+                    // The name is the last word of the declaration, after the precision and type
+                    do
+                    {
+                        NextWord(&word_start, &word_end, &size);
+                    } while (size > 0 && word_start[size-1] != ';');
+
+                    if (size < 2)
+                    {
+                        return false;
+                    }
+                    cb(word_start, size-1, userdata);
+                }
+                else
+                {
+                    word_start = SkipWS(SkipLine(word_end));
+                    word_end = word_start;
+                }
+            }
+        }
+        return true;
+    }
+
 #undef STRNCMP
 
 }
@@ -640,6 +640,56 @@ namespace dmGraphics
         g_DrawCount++;
     }
 
+    static void NullEnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t buffer_offset, HProgram program)
+    {
+        assert(context);
+        assert(vertex_declaration);
+        assert(vertex_buffer);
+        context->m_InstanceVertexDeclaration = vertex_declaration;
+        context->m_InstanceVertexBuffer = (VertexBuffer*) vertex_buffer;
+        context->m_InstanceBufferOffset = buffer_offset;
+    }
+
+    static void NullDisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    {
+        assert(context);
+        assert(context->m_InstanceVertexDeclaration == vertex_declaration);
+        context->m_InstanceVertexDeclaration = 0x0;
+        context->m_InstanceVertexBuffer = 0x0;
+        context->m_InstanceBufferOffset = 0;
+    }
+
+    // The instance data of all instances must be within the enabled instance buffer
+    static void CheckInstanceData(HContext context, uint32_t instance_count)
+    {
+        VertexDeclaration* vd = context->m_InstanceVertexDeclaration;
+        assert(vd);
+        uint32_t stride = 0;
+        for (uint32_t i = 0; i < vd->m_Count; ++i)
+            stride += vd->m_Elements[i].m_Size * TYPE_SIZE[vd->m_Elements[i].m_Type - dmGraphics::TYPE_BYTE];
+        assert(context->m_InstanceBufferOffset + stride * instance_count <= context->m_InstanceVertexBuffer->m_Size);
+        (void) stride;
+    }
+
+    static void NullDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer, uint32_t instance_count)
+    {
+        assert(context);
+        CheckInstanceData(context, instance_count);
+        NullDrawElements(context, prim_type, first, count, type, index_buffer);
+    }
+
+    static void NullDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        assert(context);
+        CheckInstanceData(context, instance_count);
+        NullDraw(context, prim_type, first, count);
+    }
+
+    static bool NullIsInstancingSupported(HContext context)
+    {
+        return true;
+    }
+
     // For tests
     uint64_t GetDrawCount()
     {
@@ -666,6 +716,8 @@ namespace dmGraphics
         Type m_Type;
     };
 
+    static void NullAttributeCallback(const char* name, uint32_t name_length, uintptr_t userdata);
+
     struct Program
     {
         Program(VertexProgram* vp, FragmentProgram* fp)
@@ -673,23 +725,52 @@ namespace dmGraphics
             m_Uniforms.SetCapacity(16);
             m_VP = vp;
             m_FP = fp;
+            Link();
+        }
+
+        ~Program()
+        {
+            Clear();
+        }
+
+        void Link()
+        {
             if (m_VP != 0x0)
+            {
                 GLSLUniformParse(m_VP->m_Data, NullUniformCallback, (uintptr_t)this);
+                GLSLAttributeParse(m_VP->m_Data, NullAttributeCallback, (uintptr_t)this);
+            }
             if (m_FP != 0x0)
                 GLSLUniformParse(m_FP->m_Data, NullUniformCallback, (uintptr_t)this);
         }
 
-        ~Program()
+        void Clear()
         {
             for(uint32_t i = 0; i < m_Uniforms.Size(); ++i)
                 delete[] m_Uniforms[i].m_Name;
+            for(uint32_t i = 0; i < m_Attributes.Size(); ++i)
+                delete[] m_Attributes[i];
+            m_Uniforms.SetSize(0);
+            m_Attributes.SetSize(0);
         }
 
         VertexProgram* m_VP;
         FragmentProgram* m_FP;
         dmArray<Uniform> m_Uniforms;
+        dmArray<char*> m_Attributes;
     };
 
+    static void NullAttributeCallback(const char* name, uint32_t name_length, uintptr_t userdata)
+    {
+        Program* program = (Program*) userdata;
+        if(program->m_Attributes.Full())
+            program->m_Attributes.OffsetCapacity(8);
+        name_length++;
+        char* attribute = new char[name_length];
+        dmStrlCpy(attribute, name, name_length);
+        program->m_Attributes.Push(attribute);
+    }
+
     static void NullUniformCallback(const char* name, uint32_t name_length, dmGraphics::Type type, uintptr_t userdata)
     {
         Program* program = (Program*) userdata;
@@ -746,8 +827,9 @@ namespace dmGraphics
         assert(ddf);
         VertexProgram* p = (VertexProgram*)prog;
         delete [] (char*)p->m_Data;
-        p->m_Data = new char[ddf->m_Source.m_Count];
+        p->m_Data = new char[ddf->m_Source.m_Count+1];
         memcpy((char*)p->m_Data, ddf->m_Source.m_Data, ddf->m_Source.m_Count);
+        p->m_Data[ddf->m_Source.m_Count] = '\0';
         return !g_ForceVertexReloadFail;
     }
 
@@ -757,8 +839,9 @@ namespace dmGraphics
         assert(ddf);
         FragmentProgram* p = (FragmentProgram*)prog;
         delete [] (char*)p->m_Data;
-        p->m_Data = new char[ddf->m_Source.m_Count];
+        p->m_Data = new char[ddf->m_Source.m_Count+1];
         memcpy((char*)p->m_Data, ddf->m_Source.m_Data, ddf->m_Source.m_Count);
+        p->m_Data[ddf->m_Source.m_Count] = '\0';
         return !g_ForceFragmentReloadFail;
     }
 
@@ -798,8 +881,13 @@ namespace dmGraphics
     static bool NullReloadProgram(HContext context, HProgram program, HVertexProgram vert_program, HFragmentProgram frag_program)
     {
         (void) context;
-        (void) program;
+        (void) vert_program;
+        (void) frag_program;
 
+        // Pick up the uniforms and attributes of the reloaded shaders
+        Program* p = (Program*) program;
+        p->Clear();
+        p->Link();
         return true;
     }
 
@@ -834,6 +922,20 @@ namespace dmGraphics
         return -1;
     }
 
+    static int32_t NullGetAttributeLocation(HProgram prog, const char* name)
+    {
+        Program* program = (Program*)prog;
+        uint32_t count = program->m_Attributes.Size();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (strcmp(program->m_Attributes[i], name) == 0)
+            {
+                return (int32_t)i;
+            }
+        }
+        return -1;
+    }
+
     static void NullSetViewport(HContext context, int32_t x, int32_t y, int32_t width, int32_t height)
     {
         assert(context);
@@ -1027,6 +1129,13 @@ namespace dmGraphics
         texture->m_Data = new char[params.m_DataSize];
         if (params.m_Data != 0x0)
             memcpy(texture->m_Data, params.m_Data, params.m_DataSize);
+        if (!params.m_SubUpdate && params.m_MipMap == 0 && (texture->m_Width != params.m_Width || texture->m_Height != params.m_Height))
+        {
+            // A new size starts a new mip chain
+            texture->m_Width       = params.m_Width;
+            texture->m_Height      = params.m_Height;
+            texture->m_MipMapCount = 0;
+        }
         texture->m_MipMapCount = dmMath::Max(texture->m_MipMapCount, (uint16_t)(params.m_MipMap+1));
     }
 
@@ -1256,6 +1365,11 @@ namespace dmGraphics
         fn_table.m_HashVertexDeclaration = NullHashVertexDeclaration;
         fn_table.m_DrawElements = NullDrawElements;
         fn_table.m_Draw = NullDraw;
+        fn_table.m_EnableInstanceVertexDeclaration = NullEnableInstanceVertexDeclaration;
+        fn_table.m_DisableInstanceVertexDeclaration = NullDisableInstanceVertexDeclaration;
+        fn_table.m_DrawElementsInstanced = NullDrawElementsInstanced;
+        fn_table.m_DrawInstanced = NullDrawInstanced;
+        fn_table.m_IsInstancingSupported = NullIsInstancingSupported;
         fn_table.m_NewVertexProgram = NullNewVertexProgram;
         fn_table.m_NewFragmentProgram = NullNewFragmentProgram;
         fn_table.m_NewProgram = NullNewProgram;
@@ -1271,6 +1385,7 @@ namespace dmGraphics
         fn_table.m_GetUniformName = NullGetUniformName;
         fn_table.m_GetUniformCount = NullGetUniformCount;
         fn_table.m_GetUniformLocation = NullGetUniformLocation;
+        fn_table.m_GetAttributeLocation = NullGetAttributeLocation;
         fn_table.m_SetConstantV4 = NullSetConstantV4;
         fn_table.m_SetConstantM4 = NullSetConstantM4;
         fn_table.m_SetSampler = NullSetSampler;
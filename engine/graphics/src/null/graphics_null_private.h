@@ -86,6 +86,9 @@ namespace dmGraphics
         FrameBuffer                 m_MainFrameBuffer;
         FrameBuffer*                m_CurrentFrameBuffer;
         void*                       m_Program;
+        VertexDeclaration*          m_InstanceVertexDeclaration;
+        VertexBuffer*               m_InstanceVertexBuffer;
+        uint32_t                    m_InstanceBufferOffset;
         WindowResizeCallback        m_WindowResizeCallback;
         void*                       m_WindowResizeCallbackUserData;
         WindowCloseCallback         m_WindowCloseCallback;
@@ -348,6 +348,12 @@ static void LogFrameBufferError(GLenum status)
     // The alternative is a matrix of conditional typedefs, linked statically/dynamically or core. OpenGL function prototypes does not change, so this is safe.
     typedef void (* DM_PFNGLINVALIDATEFRAMEBUFFERPROC) (GLenum target, GLsizei numAttachments, const GLenum *attachments);
     DM_PFNGLINVALIDATEFRAMEBUFFERPROC PFN_glInvalidateFramebuffer = NULL;
+    typedef void (* DM_PFNGLDRAWARRAYSINSTANCEDPROC) (GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+    DM_PFNGLDRAWARRAYSINSTANCEDPROC PFN_glDrawArraysInstanced = NULL;
+    typedef void (* DM_PFNGLDRAWELEMENTSINSTANCEDPROC) (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount);
+    DM_PFNGLDRAWELEMENTSINSTANCEDPROC PFN_glDrawElementsInstanced = NULL;
+    typedef void (* DM_PFNGLVERTEXATTRIBDIVISORPROC) (GLuint index, GLuint divisor);
+    DM_PFNGLVERTEXATTRIBDIVISORPROC PFN_glVertexAttribDivisor = NULL;
 
     Context* g_Context = 0x0;
 
@@ -940,6 +946,10 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         }
 
         DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glInvalidateFramebuffer, "glDiscardFramebuffer", "discard_framebuffer", "glInvalidateFramebuffer", DM_PFNGLINVALIDATEFRAMEBUFFERPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawArraysInstanced, "glDrawArraysInstanced", "draw_instanced", "glDrawArraysInstanced", DM_PFNGLDRAWARRAYSINSTANCEDPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawElementsInstanced, "glDrawElementsInstanced", "draw_instanced", "glDrawElementsInstanced", DM_PFNGLDRAWELEMENTSINSTANCEDPROC, extensions);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glVertexAttribDivisor, "glVertexAttribDivisor", "instanced_arrays", "glVertexAttribDivisor", DM_PFNGLVERTEXATTRIBDIVISORPROC, extensions);
+        context->m_InstancingSupport = PFN_glDrawArraysInstanced != NULL && PFN_glDrawElementsInstanced != NULL && PFN_glVertexAttribDivisor != NULL;
 
         if (IsExtensionSupported("GL_IMG_texture_compression_pvrtc", extensions) ||
             IsExtensionSupported("WEBGL_compressed_texture_pvrtc", extensions))
@@ -1574,6 +1584,77 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         CHECK_GL_ERROR;
     }
 
+    // Per instance streams. A float stream of size 16 is a 4x4 matrix, taking four consecutive attribute locations.
+    static inline uint32_t GetInstanceStreamLocationCount(const VertexDeclaration::Stream& stream)
+    {
+        return stream.m_Size == 16 ? 4 : 1;
+    }
+
+    static void OpenGLEnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t buffer_offset, HProgram program)
+    {
+        assert(context);
+        assert(context->m_InstancingSupport);
+        assert(vertex_buffer);
+        assert(vertex_declaration);
+
+        if (!(context->m_ModificationVersion == vertex_declaration->m_ModificationVersion && vertex_declaration->m_BoundForProgram == program))
+        {
+            BindVertexDeclarationProgram(context, vertex_declaration, program);
+        }
+
+        #define BUFFER_OFFSET(i) ((char*)0x0 + (i))
+
+        glBindBufferARB(GL_ARRAY_BUFFER, vertex_buffer);
+        CHECK_GL_ERROR;
+
+        for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
+        {
+            VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
+            if (stream.m_PhysicalIndex == -1)
+                continue;
+
+            uint32_t location_count = GetInstanceStreamLocationCount(stream);
+            uint32_t size = stream.m_Size / location_count;
+            uint32_t column_size = stream.m_Size == 16 ? 4 * sizeof(float) : 0;
+            for (uint32_t c = 0; c < location_count; ++c)
+            {
+                GLuint location = stream.m_PhysicalIndex + c;
+                glEnableVertexAttribArray(location);
+                CHECK_GL_ERROR;
+                glVertexAttribPointer(location, size, GetOpenGLType(stream.m_Type), stream.m_Normalize, vertex_declaration->m_Stride,
+                    BUFFER_OFFSET(buffer_offset + stream.m_Offset + c * column_size));
+                CHECK_GL_ERROR;
+                PFN_glVertexAttribDivisor(location, 1);
+                CHECK_GL_ERROR;
+            }
+        }
+
+        #undef BUFFER_OFFSET
+    }
+
+    static void OpenGLDisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    {
+        assert(context);
+        assert(vertex_declaration);
+
+        for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
+        {
+            VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
+            if (stream.m_PhysicalIndex == -1)
+                continue;
+
+            uint32_t location_count = GetInstanceStreamLocationCount(stream);
+            for (uint32_t c = 0; c < location_count; ++c)
+            {
+                // The divisor is attribute state, reset it for regular draws using the location
+                PFN_glVertexAttribDivisor(stream.m_PhysicalIndex + c, 0);
+                CHECK_GL_ERROR;
+                glDisableVertexAttribArray(stream.m_PhysicalIndex + c);
+                CHECK_GL_ERROR;
+            }
+        }
+    }
+
     void OpenGLHashVertexDeclaration(HashState32 *state, HVertexDeclaration vertex_declaration)
     {
         uint16_t stream_count = vertex_declaration->m_StreamCount;
@@ -1616,6 +1697,34 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         CHECK_GL_ERROR
     }
 
+    static void OpenGLDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer, uint32_t instance_count)
+    {
+        assert(context);
+        assert(index_buffer);
+        DM_PROFILE(Graphics, "DrawElementsInstanced");
+        DM_COUNTER("DrawCalls", 1);
+
+        glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+        CHECK_GL_ERROR;
+
+        PFN_glDrawElementsInstanced(GetOpenGLPrimitiveType(prim_type), count, GetOpenGLType(type), (GLvoid*)(uintptr_t) first, instance_count);
+        CHECK_GL_ERROR
+    }
+
+    static void OpenGLDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        assert(context);
+        DM_PROFILE(Graphics, "DrawInstanced");
+        DM_COUNTER("DrawCalls", 1);
+        PFN_glDrawArraysInstanced(GetOpenGLPrimitiveType(prim_type), first, count, instance_count);
+        CHECK_GL_ERROR
+    }
+
+    static bool OpenGLIsInstancingSupported(HContext context)
+    {
+        return context->m_InstancingSupport;
+    }
+
     static uint32_t CreateShader(GLenum type, const void* program, uint32_t program_size)
     {
         GLuint s = glCreateShader(type);
@@ -1885,6 +1994,17 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         return (uint32_t) location;
     }
 
+    static int32_t OpenGLGetAttributeLocation(HProgram prog, const char* name)
+    {
+        GLint location = glGetAttribLocation(prog, name);
+        if (location == -1)
+        {
+            // Clear error if attribute isn't found
+            CLEAR_GL_ERROR
+        }
+        return (int32_t) location;
+    }
+
     static void OpenGLSetViewport(HContext context, int32_t x, int32_t y, int32_t width, int32_t height)
     {
         assert(context);
@@ -2394,6 +2514,11 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
             glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
             CHECK_GL_ERROR;
         }
+        // Setting mip 0 to a new size starts a new mip chain, e.g. when a streamed texture changes its resident mips
+        if (!params.m_SubUpdate && params.m_MipMap == 0 && (texture->m_Width != params.m_Width || texture->m_Height != params.m_Height))
+        {
+            texture->m_MipMapCount = 1;
+        }
         texture->m_MipMapCount = dmMath::Max(texture->m_MipMapCount, (uint16_t)(params.m_MipMap+1));
 
         GLenum type = GetOpenGLTextureType(texture->m_Type);
@@ -3000,6 +3125,11 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         fn_table.m_HashVertexDeclaration = OpenGLHashVertexDeclaration;
         fn_table.m_DrawElements = OpenGLDrawElements;
         fn_table.m_Draw = OpenGLDraw;
+        fn_table.m_EnableInstanceVertexDeclaration = OpenGLEnableInstanceVertexDeclaration;
+        fn_table.m_DisableInstanceVertexDeclaration = OpenGLDisableInstanceVertexDeclaration;
+        fn_table.m_DrawElementsInstanced = OpenGLDrawElementsInstanced;
+        fn_table.m_DrawInstanced = OpenGLDrawInstanced;
+        fn_table.m_IsInstancingSupported = OpenGLIsInstancingSupported;
         fn_table.m_NewVertexProgram = OpenGLNewVertexProgram;
         fn_table.m_NewFragmentProgram = OpenGLNewFragmentProgram;
         fn_table.m_NewProgram = OpenGLNewProgram;
@@ -3015,6 +3145,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         fn_table.m_GetUniformName = OpenGLGetUniformName;
         fn_table.m_GetUniformCount = OpenGLGetUniformCount;
         fn_table.m_GetUniformLocation = OpenGLGetUniformLocation;
+        fn_table.m_GetAttributeLocation = OpenGLGetAttributeLocation;
         fn_table.m_SetConstantV4 = OpenGLSetConstantV4;
         fn_table.m_SetConstantM4 = OpenGLSetConstantM4;
         fn_table.m_SetSampler = OpenGLSetSampler;
@@ -327,6 +327,54 @@ TEST_F(dmGraphicsTest, Drawing)
     dmGraphics::DeleteVertexDeclaration(vd);
 }
 
+TEST_F(dmGraphicsTest, DrawingInstanced)
+{
+    ASSERT_TRUE(dmGraphics::IsInstancingSupported(m_Context));
+
+    float v[] = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f };
+    uint32_t i[] = { 0, 1, 2 };
+    float instances[16 * 3];
+    memset(instances, 0, sizeof(instances));
+
+    dmGraphics::VertexElement ve[] =
+    {
+        {"position", 0, 3, dmGraphics::TYPE_FLOAT, false }
+    };
+    dmGraphics::VertexElement instance_ve[] =
+    {
+        {"mtx_world", 0, 16, dmGraphics::TYPE_FLOAT, false }
+    };
+    dmGraphics::HVertexDeclaration vd = dmGraphics::NewVertexDeclaration(m_Context, ve, 1);
+    dmGraphics::HVertexDeclaration instance_vd = dmGraphics::NewVertexDeclaration(m_Context, instance_ve, 1);
+    dmGraphics::HVertexBuffer vb = dmGraphics::NewVertexBuffer(m_Context, sizeof(v), v, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+    dmGraphics::HVertexBuffer instance_vb = dmGraphics::NewVertexBuffer(m_Context, sizeof(instances), instances, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+    dmGraphics::HIndexBuffer ib = dmGraphics::NewIndexBuffer(m_Context, sizeof(i), i, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+
+    dmGraphics::Flip(m_Context);
+
+    // One draw for all instances
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::EnableInstanceVertexDeclaration(m_Context, instance_vd, instance_vb, 0, 0);
+    dmGraphics::DrawElementsInstanced(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3, dmGraphics::TYPE_UNSIGNED_INT, ib, 3);
+    dmGraphics::DisableInstanceVertexDeclaration(m_Context, instance_vd);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+    ASSERT_EQ(1u, dmGraphics::GetDrawCount());
+
+    // Instance data starting at an offset
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::EnableInstanceVertexDeclaration(m_Context, instance_vd, instance_vb, 16 * sizeof(float), 0);
+    dmGraphics::DrawInstanced(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3, 2);
+    dmGraphics::DisableInstanceVertexDeclaration(m_Context, instance_vd);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+    ASSERT_EQ(2u, dmGraphics::GetDrawCount());
+
+    dmGraphics::DeleteIndexBuffer(ib);
+    dmGraphics::DeleteVertexBuffer(instance_vb);
+    dmGraphics::DeleteVertexBuffer(vb);
+    dmGraphics::DeleteVertexDeclaration(instance_vd);
+    dmGraphics::DeleteVertexDeclaration(vd);
+}
+
 static inline dmGraphics::ShaderDesc::Shader MakeDDFShader(const char* data, uint32_t count)
 {
     dmGraphics::ShaderDesc::Shader ddf;
@@ -379,6 +427,9 @@ TEST_F(dmGraphicsTest, TestProgram)
     ASSERT_EQ(1, dmGraphics::GetUniformLocation(program, "world"));
     ASSERT_EQ(2, dmGraphics::GetUniformLocation(program, "texture_sampler"));
     ASSERT_EQ(3, dmGraphics::GetUniformLocation(program, "tint"));
+    ASSERT_EQ(0, dmGraphics::GetAttributeLocation(program, "position"));
+    ASSERT_EQ(1, dmGraphics::GetAttributeLocation(program, "texcoord0"));
+    ASSERT_EQ(-1, dmGraphics::GetAttributeLocation(program, "var_texcoord0"));
     char buffer[64];
     dmGraphics::Type type;
     dmGraphics::GetUniformName(program, 0, buffer, 64, &type);
@@ -520,6 +571,50 @@ TEST_F(dmGraphicsTest, TestTextureDefautlOriginalDimension)
     dmGraphics::DeleteTexture(texture);
 }
 
+static uint32_t SetTextureMipChain(dmGraphics::HTexture texture, uint16_t width, uint16_t height, char* data)
+{
+    dmGraphics::TextureParams params;
+    params.m_Format = dmGraphics::TEXTURE_FORMAT_LUMINANCE;
+    params.m_Data   = data;
+    uint32_t mip    = 0;
+    for (; width > 0 && height > 0; width >>= 1, height >>= 1)
+    {
+        params.m_Width    = width;
+        params.m_Height   = height;
+        params.m_DataSize = width * height;
+        params.m_MipMap   = mip++;
+        dmGraphics::SetTexture(texture, params);
+    }
+    return mip;
+}
+
+TEST_F(dmGraphicsTest, TestTextureResizeMipChain)
+{
+    dmGraphics::TextureCreationParams creation_params;
+    creation_params.m_Width       = 16;
+    creation_params.m_Height      = 16;
+    creation_params.m_MipMapCount = 5;
+
+    char* data = new char[16 * 16];
+    dmGraphics::HTexture texture = dmGraphics::NewTexture(m_Context, creation_params);
+    ASSERT_EQ(5U, SetTextureMipChain(texture, 16, 16, data));
+    uint32_t full_size = dmGraphics::GetTextureResourceSize(texture);
+
+    // Only the lower mips resident, as for a streamed texture
+    SetTextureMipChain(texture, 4, 4, data);
+    ASSERT_EQ(4, dmGraphics::GetTextureWidth(texture));
+    ASSERT_EQ(4, dmGraphics::GetTextureHeight(texture));
+    ASSERT_EQ(16, dmGraphics::GetOriginalTextureWidth(texture));
+    ASSERT_EQ(full_size - (16 * 16 + 8 * 8), dmGraphics::GetTextureResourceSize(texture));
+
+    SetTextureMipChain(texture, 16, 16, data);
+    ASSERT_EQ(16, dmGraphics::GetTextureWidth(texture));
+    ASSERT_EQ(full_size, dmGraphics::GetTextureResourceSize(texture));
+
+    delete [] data;
+    dmGraphics::DeleteTexture(texture);
+}
+
 TEST_F(dmGraphicsTest, TestRenderTarget)
 {
     dmGraphics::TextureCreationParams creation_params[dmGraphics::MAX_BUFFER_TYPE_COUNT];
@@ -1311,13 +1311,18 @@ bail:
 
     static Pipeline* GetOrCreatePipeline(VkDevice vk_device, VkSampleCountFlagBits vk_sample_count,
         const PipelineState pipelineState, PipelineCache& pipelineCache,
-        Program* program, RenderTarget* rt, DeviceBuffer* vertexBuffer, HVertexDeclaration vertexDeclaration)
+        Program* program, RenderTarget* rt, DeviceBuffer* vertexBuffer, HVertexDeclaration vertexDeclaration,
+        HVertexDeclaration instanceVertexDeclaration)
     {
         HashState64 pipeline_hash_state;
         dmHashInit64(&pipeline_hash_state, false);
         dmHashUpdateBuffer64(&pipeline_hash_state, &program->m_Hash, sizeof(program->m_Hash));
         dmHashUpdateBuffer64(&pipeline_hash_state, &pipelineState, sizeof(pipelineState));
         dmHashUpdateBuffer64(&pipeline_hash_state, &vertexDeclaration->m_Hash, sizeof(vertexDeclaration->m_Hash));
+        if (instanceVertexDeclaration)
+        {
+            dmHashUpdateBuffer64(&pipeline_hash_state, &instanceVertexDeclaration->m_Hash, sizeof(instanceVertexDeclaration->m_Hash));
+        }
         dmHashUpdateBuffer64(&pipeline_hash_state, &rt->m_Id, sizeof(rt->m_Id));
         dmHashUpdateBuffer64(&pipeline_hash_state, &vk_sample_count, sizeof(vk_sample_count));
         uint64_t pipeline_hash = dmHashFinal64(&pipeline_hash_state);
@@ -1334,7 +1339,7 @@ bail:
             vk_scissor.offset.x = 0;
             vk_scissor.offset.y = 0;
 
-            VkResult res = CreatePipeline(vk_device, vk_scissor, vk_sample_count, pipelineState, program, vertexBuffer, vertexDeclaration, rt->m_RenderPass, &new_pipeline);
+            VkResult res = CreatePipeline(vk_device, vk_scissor, vk_sample_count, pipelineState, program, vertexBuffer, vertexDeclaration, instanceVertexDeclaration, rt->m_RenderPass, &new_pipeline);
             CHECK_VK_ERROR(res);
 
             if (pipelineCache.Full())
@@ -1523,6 +1528,8 @@ bail:
             else if(size == 2) return VK_FORMAT_R32G32_SFLOAT;
             else if(size == 3) return VK_FORMAT_R32G32B32_SFLOAT;
             else if(size == 4) return VK_FORMAT_R32G32B32A32_SFLOAT;
+            // 4x4 matrix, the format of each column
+            else if(size == 16) return VK_FORMAT_R32G32B32A32_SFLOAT;
         }
         else if (type == TYPE_UNSIGNED_BYTE)
         {
@@ -1568,6 +1575,7 @@ bail:
             vd->m_Streams[i].m_Format   = GetVulkanFormatFromTypeAndSize(el.m_Type, el.m_Size);
             vd->m_Streams[i].m_Offset   = vd->m_Stride;
             vd->m_Streams[i].m_Location = 0;
+            vd->m_Streams[i].m_LocationCount = el.m_Type == TYPE_FLOAT && el.m_Size == 16 ? 4 : 1;
             vd->m_Stride               += el.m_Size * GetGraphicsTypeSize(el.m_Type);
 
             dmHashUpdateBuffer64(hash, &el.m_Size, sizeof(el.m_Size));
@@ -1619,11 +1627,8 @@ bail:
         context->m_CurrentVertexDeclaration = (VertexDeclaration*) vertex_declaration;
     }
 
-    static void VulkanEnableVertexDeclarationProgram(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program)
+    static void BindVertexDeclarationProgram(HVertexDeclaration vertex_declaration, Program* program_ptr)
     {
-        Program* program_ptr = (Program*) program;
-        VulkanEnableVertexDeclaration(context, vertex_declaration, vertex_buffer);
-
         for (uint32_t i=0; i < vertex_declaration->m_StreamCount; i++)
         {
             VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
@@ -1643,11 +1648,33 @@ bail:
         }
     }
 
+    static void VulkanEnableVertexDeclarationProgram(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program)
+    {
+        VulkanEnableVertexDeclaration(context, vertex_declaration, vertex_buffer);
+        BindVertexDeclarationProgram(vertex_declaration, (Program*) program);
+    }
+
     static void VulkanDisableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
     {
         context->m_CurrentVertexDeclaration = 0;
     }
 
+    static void VulkanEnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t buffer_offset, HProgram program)
+    {
+        assert(vertex_buffer);
+        context->m_CurrentInstanceVertexBuffer      = (DeviceBuffer*) vertex_buffer;
+        context->m_CurrentInstanceVertexDeclaration = (VertexDeclaration*) vertex_declaration;
+        context->m_CurrentInstanceBufferOffset      = buffer_offset;
+        BindVertexDeclarationProgram(vertex_declaration, (Program*) program);
+    }
+
+    static void VulkanDisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    {
+        context->m_CurrentInstanceVertexBuffer      = 0;
+        context->m_CurrentInstanceVertexDeclaration = 0;
+        context->m_CurrentInstanceBufferOffset      = 0;
+    }
+
     static inline bool IsUniformTextureSampler(ShaderResourceBinding uniform)
     {
         return uniform.m_Type == ShaderDesc::SHADER_TYPE_SAMPLER2D ||
@@ -1923,7 +1950,7 @@ bail:
         Pipeline* pipeline = GetOrCreatePipeline(vk_device, vk_sample_count,
             context->m_PipelineState, context->m_PipelineCache,
             program_ptr, context->m_CurrentRenderTarget,
-            vertex_buffer, context->m_CurrentVertexDeclaration);
+            vertex_buffer, context->m_CurrentVertexDeclaration, context->m_CurrentInstanceVertexDeclaration);
         vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *pipeline);
 
 
@@ -1945,6 +1972,13 @@ bail:
         VkBuffer vk_vertex_buffer             = vertex_buffer->m_Handle.m_Buffer;
         VkDeviceSize vk_vertex_buffer_offsets = 0;
         vkCmdBindVertexBuffers(vk_command_buffer, 0, 1, &vk_vertex_buffer, &vk_vertex_buffer_offsets);
+
+        if (context->m_CurrentInstanceVertexDeclaration)
+        {
+            VkBuffer vk_instance_buffer             = context->m_CurrentInstanceVertexBuffer->m_Handle.m_Buffer;
+            VkDeviceSize vk_instance_buffer_offsets = context->m_CurrentInstanceBufferOffset;
+            vkCmdBindVertexBuffers(vk_command_buffer, 1, 1, &vk_instance_buffer, &vk_instance_buffer_offsets);
+        }
     }
 
     void VulkanHashVertexDeclaration(HashState32 *state, HVertexDeclaration vertex_declaration)
@@ -1988,6 +2022,39 @@ bail:
         vkCmdDraw(vk_command_buffer, count, 1, first, 0);
     }
 
+    static void VulkanDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer, uint32_t instance_count)
+    {
+        assert(context->m_FrameBegun);
+        assert(context->m_CurrentInstanceVertexDeclaration);
+        DM_PROFILE(Graphics, "DrawElementsInstanced");
+        DM_COUNTER("DrawCalls", 1);
+        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
+        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
+        context->m_PipelineState.m_PrimtiveType = prim_type;
+        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], (DeviceBuffer*) index_buffer, type);
+
+        uint32_t index_offset = first / (type == TYPE_UNSIGNED_SHORT ? 2 : 4);
+        vkCmdDrawIndexed(vk_command_buffer, count, instance_count, index_offset, 0, 0);
+    }
+
+    static void VulkanDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        assert(context->m_FrameBegun);
+        assert(context->m_CurrentInstanceVertexDeclaration);
+        DM_PROFILE(Graphics, "DrawInstanced");
+        DM_COUNTER("DrawCalls", 1);
+        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
+        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
+        context->m_PipelineState.m_PrimtiveType = prim_type;
+        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], 0, TYPE_BYTE);
+        vkCmdDraw(vk_command_buffer, count, instance_count, first, 0);
+    }
+
+    static bool VulkanIsInstancingSupported(HContext context)
+    {
+        return true;
+    }
+
     static void CreateShaderResourceBindings(ShaderModule* shader, ShaderDesc::Shader* ddf, uint32_t dynamicAlignment)
     {
         if (ddf->m_Uniforms.m_Count > 0)
@@ -2414,6 +2481,21 @@ bail:
         return false;
     }
 
+    static int32_t VulkanGetAttributeLocation(HProgram prog, const char* name)
+    {
+        assert(prog);
+        ShaderModule* vs = ((Program*) prog)->m_VertexModule;
+        dmhash_t name_hash = dmHashString64(name);
+        for (uint32_t i = 0; i < vs->m_AttributeCount; ++i)
+        {
+            if (vs->m_Attributes[i].m_NameHash == name_hash)
+            {
+                return (int32_t) vs->m_Attributes[i].m_Binding;
+            }
+        }
+        return -1;
+    }
+
     static int32_t VulkanGetUniformLocation(HProgram prog, const char* name)
     {
         assert(prog);
@@ -3131,6 +3213,20 @@ bail:
         }
     }
 
+    static uint16_t GetResizedMipMapCount(uint16_t mipmap_count, uint32_t old_size, uint32_t new_size)
+    {
+        if (mipmap_count <= 1)
+        {
+            return mipmap_count;
+        }
+        int32_t count = mipmap_count;
+        for (; old_size > new_size && count > 1; old_size >>= 1)
+            --count;
+        for (; old_size < new_size; old_size <<= 1)
+            ++count;
+        return (uint16_t) count;
+    }
+
     static void VulkanSetTexture(HTexture texture, const TextureParams& params)
     {
         // Same as graphics_opengl.cpp
@@ -3183,6 +3279,16 @@ bail:
 
         tex_data_size             = tex_bpp * params.m_Width * params.m_Height * tex_layer_count;
         texture->m_GraphicsFormat = params.m_Format;
+
+        // Setting mip 0 to a new size starts a new mip chain, e.g. when a streamed texture changes its resident mips.
+        // The image is created with all levels up front, so the chain is resized to end at the same smallest mip.
+        bool resized = !params.m_SubUpdate && params.m_MipMap == 0 && (texture->m_Width != params.m_Width || texture->m_Height != params.m_Height);
+        if (resized)
+        {
+            texture->m_MipMapCount = GetResizedMipMapCount(texture->m_MipMapCount, dmMath::Max(texture->m_Width, texture->m_Height), dmMath::Max(params.m_Width, params.m_Height));
+            texture->m_Width       = params.m_Width;
+            texture->m_Height      = params.m_Height;
+        }
         texture->m_MipMapCount    = dmMath::Max(texture->m_MipMapCount, (uint16_t)(params.m_MipMap+1));
 
         SetTextureParams(texture, params.m_MinFilter, params.m_MagFilter, params.m_UWrap, params.m_VWrap);
@@ -3194,7 +3300,7 @@ bail:
         }
         else if (params.m_MipMap == 0)
         {
-            if (texture->m_Format != vk_format || texture->m_Width != params.m_Width || texture->m_Height != params.m_Height)
+            if (texture->m_Format != vk_format || resized)
             {
                 DestroyResourceDeferred(g_VulkanContext->m_MainResourcesToDestroy[g_VulkanContext->m_SwapChain->m_ImageIndex], texture);
                 texture->m_Format = vk_format;
@@ -3400,6 +3506,11 @@ bail:
         fn_table.m_HashVertexDeclaration = VulkanHashVertexDeclaration;
         fn_table.m_DrawElements = VulkanDrawElements;
         fn_table.m_Draw = VulkanDraw;
+        fn_table.m_EnableInstanceVertexDeclaration = VulkanEnableInstanceVertexDeclaration;
+        fn_table.m_DisableInstanceVertexDeclaration = VulkanDisableInstanceVertexDeclaration;
+        fn_table.m_DrawElementsInstanced = VulkanDrawElementsInstanced;
+        fn_table.m_DrawInstanced = VulkanDrawInstanced;
+        fn_table.m_IsInstancingSupported = VulkanIsInstancingSupported;
         fn_table.m_NewVertexProgram = VulkanNewVertexProgram;
         fn_table.m_NewFragmentProgram = VulkanNewFragmentProgram;
         fn_table.m_NewProgram = VulkanNewProgram;
@@ -3415,6 +3526,7 @@ bail:
         fn_table.m_GetUniformName = VulkanGetUniformName;
         fn_table.m_GetUniformCount = VulkanGetUniformCount;
         fn_table.m_GetUniformLocation = VulkanGetUniformLocation;
+        fn_table.m_GetAttributeLocation = VulkanGetAttributeLocation;
         fn_table.m_SetConstantV4 = VulkanSetConstantV4;
         fn_table.m_SetConstantM4 = VulkanSetConstantM4;
         fn_table.m_SetSampler = VulkanSetSampler;
@@ -51,22 +51,29 @@ namespace dmGraphics
         memset(this, 0, sizeof(*this));
     }
 
-    static uint16_t FillVertexInputAttributeDesc(HVertexDeclaration vertexDeclaration, VkVertexInputAttributeDescription* vk_vertex_input_descs)
+    static uint16_t FillVertexInputAttributeDesc(HVertexDeclaration vertexDeclaration, uint32_t binding, VkVertexInputAttributeDescription* vk_vertex_input_descs, uint16_t max_attributes)
     {
         uint16_t num_attributes = 0;
         for (uint16_t i = 0; i < vertexDeclaration->m_StreamCount; ++i)
         {
-            if (vertexDeclaration->m_Streams[i].m_Location == 0xffff)
+            VertexDeclaration::Stream& stream = vertexDeclaration->m_Streams[i];
+            if (stream.m_Location == 0xffff)
             {
                 continue;
             }
 
-            vk_vertex_input_descs[num_attributes].binding  = 0;
-            vk_vertex_input_descs[num_attributes].location = vertexDeclaration->m_Streams[i].m_Location;
-            vk_vertex_input_descs[num_attributes].format   = vertexDeclaration->m_Streams[i].m_Format;
-            vk_vertex_input_descs[num_attributes].offset   = vertexDeclaration->m_Streams[i].m_Offset;
+            // Matrix streams are bound column by column to consecutive locations
+            uint32_t column_size = stream.m_LocationCount > 1 ? 4 * sizeof(float) : 0;
+            for (uint8_t c = 0; c < stream.m_LocationCount; ++c)
+            {
+                assert(num_attributes < max_attributes);
+                vk_vertex_input_descs[num_attributes].binding  = binding;
+                vk_vertex_input_descs[num_attributes].location = stream.m_Location + c;
+                vk_vertex_input_descs[num_attributes].format   = stream.m_Format;
+                vk_vertex_input_descs[num_attributes].offset   = stream.m_Offset + c * column_size;
 
-            num_attributes++;
+                num_attributes++;
+            }
         }
 
         return num_attributes;
@@ -898,27 +905,40 @@ bail:
 
     VkResult CreatePipeline(VkDevice vk_device, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count,
         PipelineState pipelineState, Program* program, DeviceBuffer* vertexBuffer,
-        HVertexDeclaration vertexDeclaration, const VkRenderPass vk_render_pass, Pipeline* pipelineOut)
+        HVertexDeclaration vertexDeclaration, HVertexDeclaration instanceVertexDeclaration,
+        const VkRenderPass vk_render_pass, Pipeline* pipelineOut)
     {
         assert(pipelineOut && *pipelineOut == VK_NULL_HANDLE);
 
-        VkVertexInputAttributeDescription vk_vertex_input_descs[DM_MAX_VERTEX_STREAM_COUNT];
-        uint16_t active_attributes = FillVertexInputAttributeDesc(vertexDeclaration, vk_vertex_input_descs);
+        const uint16_t max_attributes = DM_MAX_VERTEX_STREAM_COUNT * 2;
+        VkVertexInputAttributeDescription vk_vertex_input_descs[max_attributes];
+        uint16_t active_attributes = FillVertexInputAttributeDesc(vertexDeclaration, 0, vk_vertex_input_descs, max_attributes);
         assert(active_attributes != 0);
 
-        VkVertexInputBindingDescription vk_vx_input_description;
-        memset(&vk_vx_input_description, 0, sizeof(vk_vx_input_description));
+        VkVertexInputBindingDescription vk_vx_input_descriptions[2];
+        memset(vk_vx_input_descriptions, 0, sizeof(vk_vx_input_descriptions));
+
+        vk_vx_input_descriptions[0].binding   = 0;
+        vk_vx_input_descriptions[0].stride    = vertexDeclaration->m_Stride;
+        vk_vx_input_descriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        uint32_t binding_count = 1;
 
-        vk_vx_input_description.binding   = 0;
-        vk_vx_input_description.stride    = vertexDeclaration->m_Stride;
-        vk_vx_input_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        // Per instance streams are read from a second binding
+        if (instanceVertexDeclaration)
+        {
+            active_attributes += FillVertexInputAttributeDesc(instanceVertexDeclaration, 1, vk_vertex_input_descs + active_attributes, max_attributes - active_attributes);
+            vk_vx_input_descriptions[1].binding   = 1;
+            vk_vx_input_descriptions[1].stride    = instanceVertexDeclaration->m_Stride;
+            vk_vx_input_descriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+            binding_count = 2;
+        }
 
         VkPipelineVertexInputStateCreateInfo vk_vertex_input_info;
         memset(&vk_vertex_input_info, 0, sizeof(vk_vertex_input_info));
 
         vk_vertex_input_info.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vk_vertex_input_info.vertexBindingDescriptionCount   = 1;
-        vk_vertex_input_info.pVertexBindingDescriptions      = &vk_vx_input_description;
+        vk_vertex_input_info.vertexBindingDescriptionCount   = binding_count;
+        vk_vertex_input_info.pVertexBindingDescriptions      = vk_vx_input_descriptions;
         vk_vertex_input_info.vertexAttributeDescriptionCount = active_attributes;
         vk_vertex_input_info.pVertexAttributeDescriptions    = vk_vertex_input_descs;
 
@@ -131,6 +131,8 @@ namespace dmGraphics
             uint16_t m_Location;
             uint16_t m_Offset;
             VkFormat m_Format;
+            // Number of consecutive locations, four for a 4x4 matrix stream
+            uint8_t  m_LocationCount;
 
             // TODO: Not sure how to deal with normalizing
             //       a vertex stream in VK.
@@ -411,6 +413,9 @@ namespace dmGraphics
         RenderTarget*                   m_CurrentRenderTarget;
         DeviceBuffer*                   m_CurrentVertexBuffer;
         VertexDeclaration*              m_CurrentVertexDeclaration;
+        DeviceBuffer*                   m_CurrentInstanceVertexBuffer;
+        VertexDeclaration*              m_CurrentInstanceVertexDeclaration;
+        uint32_t                        m_CurrentInstanceBufferOffset;
         Program*                        m_CurrentProgram;
         // Misc state
         TextureFilter                   m_DefaultTextureMinFilter;
@@ -485,7 +490,8 @@ namespace dmGraphics
         const void* source, uint32_t sourceSize, ShaderModule* shaderModuleOut);
     VkResult CreatePipeline(VkDevice vk_device, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count,
         const PipelineState pipelineState, Program* program, DeviceBuffer* vertexBuffer,
-        HVertexDeclaration vertexDeclaration, const VkRenderPass vk_render_pass, Pipeline* pipelineOut);
+        HVertexDeclaration vertexDeclaration, HVertexDeclaration instanceVertexDeclaration,
+        const VkRenderPass vk_render_pass, Pipeline* pipelineOut);
     // Reset functions
     void           ResetScratchBuffer(VkDevice vk_device, ScratchBuffer* scratchBuffer);
     // Destroy funcions
@@ -220,6 +220,7 @@ namespace dmGui
         context->m_HidContext = params->m_HidContext;
         context->m_Scenes.SetCapacity(INITIAL_SCENE_COUNT);
         context->m_ScratchBoneNodes.SetCapacity(32);
+        context->m_FrameArena = dmArenaAllocator::New(16 * 1024, "GuiFrameArena");
 
         return context;
     }
@@ -227,6 +228,7 @@ namespace dmGui
     void DeleteContext(HContext context, dmScript::HContext script_context)
     {
         FinalizeScript(context->m_LuaState, script_context);
+        dmArenaAllocator::Delete(context->m_FrameArena);
         delete context;
     }
 
@@ -1408,12 +1410,9 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         if (capacity > c->m_RenderNodes.Capacity())
         {
             c->m_RenderNodes.SetCapacity(capacity);
-            c->m_RenderTransforms.SetCapacity(capacity);
-            c->m_RenderOpacities.SetCapacity(capacity);
             c->m_SceneTraversalCache.m_Data.SetCapacity(capacity);
             c->m_SceneTraversalCache.m_Data.SetSize(capacity);
             c->m_StencilClippingNodes.SetCapacity(capacity);
-            c->m_StencilScopes.SetCapacity(capacity);
             c->m_StencilScopeIndices.SetCapacity(capacity);
         }
 
@@ -1429,18 +1428,21 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
         std::sort(c->m_RenderNodes.Begin(), c->m_RenderNodes.End(), RenderEntrySortPred(scene));
         Matrix4 transform;
 
-        if (c->m_RenderNodes.Capacity() > c->m_RenderTransforms.Capacity())
+        if (c->m_RenderNodes.Capacity() > c->m_SceneTraversalCache.m_Data.Capacity())
         {
             uint32_t new_capacity = c->m_RenderNodes.Capacity();
-            c->m_RenderTransforms.SetCapacity(new_capacity);
-            c->m_RenderOpacities.SetCapacity(new_capacity);
             c->m_SceneTraversalCache.m_Data.SetCapacity(new_capacity);
             c->m_SceneTraversalCache.m_Data.SetSize(new_capacity);
             c->m_StencilClippingNodes.SetCapacity(new_capacity);
-            c->m_StencilScopes.SetCapacity(new_capacity);
             c->m_StencilScopeIndices.SetCapacity(new_capacity);
         }
 
+        // The per node render data is only needed until the render callback returns
+        dmArenaAllocator::Reset(c->m_FrameArena);
+        dmArenaAllocator::SetCapacity(c->m_FrameArena, c->m_RenderTransforms, node_count);
+        dmArenaAllocator::SetCapacity(c->m_FrameArena, c->m_RenderOpacities, node_count);
+        dmArenaAllocator::SetCapacity(c->m_FrameArena, c->m_StencilScopes, node_count);
+
         for (uint32_t i = 0; i < node_count; ++i)
         {
             const RenderEntry& entry = c->m_RenderNodes[i];
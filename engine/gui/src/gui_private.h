@@ -14,6 +14,7 @@
 #define DM_GUI_PRIVATE_H
 
 #include <dlib/index_pool.h>
+#include <dlib/arena_allocator.h>
 #include <dlib/array.h>
 #include <dlib/hashtable.h>
 #include <dlib/easing.h>
@@ -89,10 +90,11 @@ namespace dmGui
         uint32_t                        m_Dpi;
         dmArray<HScene>                 m_Scenes;
         dmArray<RenderEntry>            m_RenderNodes;
-        dmArray<Matrix4>                m_RenderTransforms;
-        dmArray<float>                	m_RenderOpacities;
+        dmArenaAllocator::HArena        m_FrameArena;           // Reset in RenderScene
+        dmArray<Matrix4>                m_RenderTransforms;     // From m_FrameArena
+        dmArray<float>                	m_RenderOpacities;      // From m_FrameArena
         dmArray<InternalClippingNode>   m_StencilClippingNodes;
-        dmArray<StencilScope*>          m_StencilScopes;
+        dmArray<StencilScope*>          m_StencilScopes;        // From m_FrameArena
         dmArray<uint16_t>               m_StencilScopeIndices;
         dmArray<HNode>                  m_ScratchBoneNodes;
         dmHID::HContext                 m_HidContext;
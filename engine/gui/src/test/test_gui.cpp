@@ -495,7 +495,7 @@ private:
         anim1.m_MeshTracks.m_Count  = 0;
 
         uint32_t bone_track_count = 2;
-        anim0.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[bone_track_count];
+        anim0.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[bone_track_count]();
         anim0.m_Tracks.m_Count = bone_track_count;
         dmRigDDF::AnimationTrack& anim_track0 = anim0.m_Tracks.m_Data[0];
         dmRigDDF::AnimationTrack& anim_track1 = anim0.m_Tracks.m_Data[1];
@@ -172,6 +172,10 @@ namespace dmRender
      * @member m_StencilTestParams [type: dmRender::StencilTestParams] the stencil test params
      * @member m_VertexStart [type: uint32_t] the vertex start
      * @member m_VertexCount [type: uint32_t] the vertex count
+     * @member m_InstanceVertexBuffer [type: dmGraphics::HVertexBuffer] the vertex buffer holding the per instance data
+     * @member m_InstanceVertexDeclaration [type: dmGraphics::HVertexDeclaration] the vertex declaration of the per instance data
+     * @member m_InstanceBufferOffset [type: uint32_t] the byte offset of the first instance in the instance vertex buffer
+     * @member m_InstanceCount [type: uint32_t] the number of instances. If non zero, the object is drawn with one instanced draw call
      * @member m_SetBlendFactors [type: uint8_t:1] use the blend factors
      * @member m_SetStencilTest [type: uint8_t:1] use the stencil test
      */
@@ -199,6 +203,10 @@ namespace dmRender
         StencilTestParams               m_StencilTestParams;
         uint32_t                        m_VertexStart;
         uint32_t                        m_VertexCount;
+        dmGraphics::HVertexBuffer       m_InstanceVertexBuffer;
+        dmGraphics::HVertexDeclaration  m_InstanceVertexDeclaration;
+        uint32_t                        m_InstanceBufferOffset;
+        uint32_t                        m_InstanceCount;
         uint8_t                         m_SetBlendFactors : 1;
         uint8_t                         m_SetStencilTest : 1;
         uint8_t                         m_SetFaceWinding : 1;
@@ -664,15 +664,16 @@ namespace dmRender
         }
     }
 
-    static int CreateFontVertexDataInternal(TextContext& text_context, HFontMap font_map, const char* text, const TextEntry& te, float recip_w, float recip_h, GlyphVertex* vertices, uint32_t num_vertices)
+    static void LayoutGlyphs(HFontMap font_map, const char* text, float box_width, float box_height, float leading_scale, float tracking_scale,
+                             bool line_break, uint32_t align, uint32_t valign, dmArray<TextGlyph>& glyphs)
     {
-        float width = te.m_Width;
-        if (!te.m_LineBreak) {
+        float width = box_width;
+        if (!line_break) {
             width = FLT_MAX;
         }
         float line_height = font_map->m_MaxAscent + font_map->m_MaxDescent;
-        float leading = line_height * te.m_Leading;
-        float tracking = line_height * te.m_Tracking;
+        float leading = line_height * leading_scale;
+        float tracking = line_height * tracking_scale;
 
         const uint32_t max_lines = 128;
         TextLine lines[max_lines];
@@ -681,23 +682,82 @@ namespace dmRender
         // rendering multiline text.
         // For single line text we still want to include spaces when the text
         // layout is calculated (https://github.com/defold/defold/issues/5911)
-        bool measure_trailing_space = !te.m_LineBreak;
+        bool measure_trailing_space = !line_break;
 
         LayoutMetrics lm(font_map, tracking);
         float layout_width;
         int line_count = Layout(text, width, lines, max_lines, &layout_width, lm, measure_trailing_space);
-        float x_offset = OffsetX(te.m_Align, te.m_Width);
-        float y_offset = OffsetY(te.m_VAlign, te.m_Height, font_map->m_MaxAscent, font_map->m_MaxDescent, te.m_Leading, line_count);
+        float x_offset = OffsetX(align, box_width);
+        float y_offset = OffsetY(valign, box_height, font_map->m_MaxAscent, font_map->m_MaxDescent, leading_scale, line_count);
+
+        for (int line = 0; line < line_count; ++line) {
+            TextLine& l = lines[line];
+            int16_t x = (int16_t)(x_offset - OffsetX(align, l.m_Width) + 0.5f);
+            int16_t y = (int16_t) (y_offset - line * leading + 0.5f);
+            const char* cursor = &text[l.m_Index];
+            int n = l.m_Count;
+            for (int j = 0; j < n; ++j)
+            {
+                uint32_t c = dmUtf8::NextChar(&cursor);
+
+                Glyph* g =  GetGlyph(font_map, c);
+                if (!g) {
+                    continue;
+                }
+
+                if (g->m_Width > 0)
+                {
+                    if (glyphs.Full()) {
+                        glyphs.OffsetCapacity(dmMath::Max(16U, glyphs.Capacity()));
+                    }
+                    // Store the character of the glyph found, so that the fallback isn't looked up again
+                    TextGlyph tg;
+                    tg.m_X = x;
+                    tg.m_Y = y;
+                    tg.m_Character = g->m_Character;
+                    glyphs.Push(tg);
+                }
+                x += (int16_t)(g->m_Advance + tracking);
+            }
+        }
+    }
+
+    static uint32_t GetLayerCount(HFontMap font_map)
+    {
+        uint8_t layer_mask = font_map->m_LayerMask;
+        return 1 + ((layer_mask & OUTLINE) == OUTLINE) + ((layer_mask & SHADOW) == SHADOW);
+    }
+
+    static Vector4 GetTextureSizeRecip(HFontMap font_map)
+    {
+        float im_recip = 1.0f;
+        float ih_recip = 1.0f;
+        float cache_cell_width_ratio  = 0.0;
+        float cache_cell_height_ratio = 0.0;
 
-        const Vectormath::Aos::Vector4 face_color    = dmGraphics::UnpackRGBA(te.m_FaceColor);
-        const Vectormath::Aos::Vector4 outline_color = dmGraphics::UnpackRGBA(te.m_OutlineColor);
-        const Vectormath::Aos::Vector4 shadow_color  = dmGraphics::UnpackRGBA(te.m_ShadowColor);
+        if (font_map->m_Texture) {
+            float cache_width  = (float) dmGraphics::GetTextureWidth(font_map->m_Texture);
+            float cache_height = (float) dmGraphics::GetTextureHeight(font_map->m_Texture);
 
+            im_recip /= cache_width;
+            ih_recip /= cache_height;
+
+            cache_cell_width_ratio  = ((float) font_map->m_CacheCellWidth) / cache_width;
+            cache_cell_height_ratio = ((float) font_map->m_CacheCellHeight) / cache_height;
+        }
+        return Vector4(im_recip, ih_recip, cache_cell_width_ratio, cache_cell_height_ratio);
+    }
+
+    static uint32_t CreateGlyphVertices(TextContext& text_context, HFontMap font_map, const Matrix4& transform,
+                                        const Vector4& face_color, const Vector4& outline_color, const Vector4& shadow_color,
+                                        const TextGlyph* glyphs, uint32_t glyph_count, float recip_w, float recip_h,
+                                        GlyphVertex* vertices, uint32_t num_vertices)
+    {
         // No support for non-uniform scale with SDF so just peek at the first
         // row to extract scale factor. The purpose of this scaling is to have
         // world space distances in the computation, for good 'anti aliasing' no matter
         // what scale is being rendered in.
-        const Vectormath::Aos::Vector4 r0 = te.m_Transform.getRow(0);
+        const Vectormath::Aos::Vector4 r0 = transform.getRow(0);
         const float sdf_edge_value = 0.75f;
         float sdf_world_scale = sqrtf(r0.getX() * r0.getX() + r0.getY() * r0.getY());
         float sdf_outline = font_map->m_SdfOutline;
@@ -708,7 +768,7 @@ namespace dmRender
         uint32_t vertexindex        = 0;
         uint32_t valid_glyph_count  = 0;
         uint8_t  vertices_per_quad  = 6;
-        uint8_t  layer_count        = 1;
+        uint8_t  layer_count        = (uint8_t) GetLayerCount(font_map);
         uint8_t  layer_mask         = font_map->m_LayerMask;
 
         #define HAS_LAYER(mask,layer) ((mask & layer) == layer)
@@ -724,247 +784,198 @@ namespace dmRender
         // * For the layered approach, we need to place vertices in sorted order from
         //     back to front layer in the order of shadow -> outline -> face, where the offset of each
         //     layer depends on how many glyphs we actually can place in the buffer. To get a valid count, we
-        //     do a dry run first over the input string and place glyphs in the cache if they are renderable.
-        if (HAS_LAYER(layer_mask,OUTLINE) || HAS_LAYER(layer_mask,SHADOW))
+        //     do a dry run first over the glyphs and place them in the cache if they are renderable.
+        //     The glyphs are marked as used this frame, so that they aren't evicted by the following ones.
+        for (uint32_t i = 0; i < glyph_count; ++i)
         {
-            layer_count += HAS_LAYER(layer_mask,OUTLINE) + HAS_LAYER(layer_mask,SHADOW);
-
-            // Calculate number of valid glyphs
-            for (int line = 0; line < line_count; ++line)
+            Glyph* g = font_map->m_Glyphs.Get(glyphs[i].m_Character);
+            if (!g)
             {
-                TextLine& l = lines[line];
-                const char* cursor = &text[l.m_Index];
-                bool inner_break = false;
-
-                for (int j = 0; j < l.m_Count; ++j)
-                {
-                    uint32_t c = dmUtf8::NextChar(&cursor);
-                    Glyph* g   = GetGlyph(font_map, c);
-
-                    if (!g)
-                    {
-                        continue;
-                    }
-
-                    if ((vertexindex + vertices_per_quad) * layer_count > num_vertices)
-                    {
-                        inner_break = true;
-                        break;
-                    }
-
-                    if (g->m_Width > 0)
-                    {
-                        int16_t px_cell_offset_y = font_map->m_CacheCellMaxAscent - (int16_t)g->m_Ascent;
-
-                        // Prepare the cache here aswell since we only count glyphs we definitely
-                        // will render.
-                        if (!g->m_InCache)
-                        {
-                            AddGlyphToCache(font_map, text_context, g, px_cell_offset_y);
-                        }
-
-                        if (g->m_InCache)
-                        {
-                            valid_glyph_count++;
-
-                            vertexindex += vertices_per_quad;
-                        }
-                    }
-                }
-
-                if (inner_break)
-                {
-                    break;
-                }
+                continue;
             }
 
-            vertexindex = 0;
-        }
-
-        for (int line = 0; line < line_count; ++line) {
-            TextLine& l = lines[line];
-            int16_t x = (int16_t)(x_offset - OffsetX(te.m_Align, l.m_Width) + 0.5f);
-            int16_t y = (int16_t) (y_offset - line * leading + 0.5f);
-            const char* cursor = &text[l.m_Index];
-            int n = l.m_Count;
-            for (int j = 0; j < n; ++j)
+            if ((vertexindex + vertices_per_quad) * layer_count > num_vertices)
             {
-                uint32_t c = dmUtf8::NextChar(&cursor);
+                dmLogWarning("Character buffer exceeded (size: %d), increase the \"graphics.max_characters\" property in your game.project file.", num_vertices / 6);
+                break;
+            }
 
-                Glyph* g =  GetGlyph(font_map, c);
-                if (!g) {
-                    continue;
-                }
+            if (!g->m_InCache)
+            {
+                // Calculate y-offset in cache-cell space by moving glyphs down to baseline
+                int16_t px_cell_offset_y = font_map->m_CacheCellMaxAscent - (int16_t)g->m_Ascent;
+                AddGlyphToCache(font_map, text_context, g, px_cell_offset_y);
+            }
 
-                // Look ahead and see if we can produce vertices for the next glyph or not
-                if ((vertexindex + vertices_per_quad) * layer_count > num_vertices)
-                {
-                    dmLogWarning("Character buffer exceeded (size: %d), increase the \"graphics.max_characters\" property in your game.project file.", num_vertices / 6);
-                    return vertexindex * layer_count;
-                }
+            if (g->m_InCache)
+            {
+                g->m_Frame = text_context.m_Frame;
+                valid_glyph_count++;
+                vertexindex += vertices_per_quad;
+            }
+        }
 
-                if (g->m_Width > 0)
-                {
-                    int16_t width   = (int16_t) g->m_Width;
-                    int16_t descent = (int16_t) g->m_Descent;
-                    int16_t ascent  = (int16_t) g->m_Ascent;
+        vertexindex = 0;
 
-                    // Calculate y-offset in cache-cell space by moving glyphs down to baseline
-                    int16_t px_cell_offset_y = font_map->m_CacheCellMaxAscent - ascent;
+        for (uint32_t i = 0; i < glyph_count && vertexindex < valid_glyph_count * vertices_per_quad; ++i)
+        {
+            Glyph* g = font_map->m_Glyphs.Get(glyphs[i].m_Character);
+            if (!g || !g->m_InCache) {
+                continue;
+            }
 
-                    if (!g->m_InCache) {
-                        AddGlyphToCache(font_map, text_context, g, px_cell_offset_y);
-                    }
+            float x = glyphs[i].m_X;
+            float y = glyphs[i].m_Y;
+
+            int16_t width   = (int16_t) g->m_Width;
+            int16_t descent = (int16_t) g->m_Descent;
+            int16_t ascent  = (int16_t) g->m_Ascent;
+
+            // Calculate y-offset in cache-cell space by moving glyphs down to baseline
+            int16_t px_cell_offset_y = font_map->m_CacheCellMaxAscent - ascent;
+
+            uint32_t face_index = vertexindex + vertices_per_quad * valid_glyph_count * (layer_count-1);
+
+            // Set face vertices first, this will always hold since we can't have less than 1 layer
+            GlyphVertex& v1_layer_face = vertices[face_index];
+            GlyphVertex& v2_layer_face = vertices[face_index + 1];
+            GlyphVertex& v3_layer_face = vertices[face_index + 2];
+            GlyphVertex& v4_layer_face = vertices[face_index + 3];
+            GlyphVertex& v5_layer_face = vertices[face_index + 4];
+            GlyphVertex& v6_layer_face = vertices[face_index + 5];
+
+            (Vector4&) v1_layer_face.m_Position = transform * Vector4(x + g->m_LeftBearing, y - descent, 0, 1);
+            (Vector4&) v2_layer_face.m_Position = transform * Vector4(x + g->m_LeftBearing, y + ascent, 0, 1);
+            (Vector4&) v3_layer_face.m_Position = transform * Vector4(x + g->m_LeftBearing + width, y - descent, 0, 1);
+            (Vector4&) v6_layer_face.m_Position = transform * Vector4(x + g->m_LeftBearing + width, y + ascent, 0, 1);
+
+            v1_layer_face.m_UV[0] = (g->m_X + font_map->m_CacheCellPadding) * recip_w;
+            v1_layer_face.m_UV[1] = (g->m_Y + font_map->m_CacheCellPadding + ascent + descent + px_cell_offset_y) * recip_h;
+
+            v2_layer_face.m_UV[0] = (g->m_X + font_map->m_CacheCellPadding) * recip_w;
+            v2_layer_face.m_UV[1] = (g->m_Y + font_map->m_CacheCellPadding + px_cell_offset_y) * recip_h;
+
+            v3_layer_face.m_UV[0] = (g->m_X + font_map->m_CacheCellPadding + g->m_Width) * recip_w;
+            v3_layer_face.m_UV[1] = (g->m_Y + font_map->m_CacheCellPadding + ascent + descent + px_cell_offset_y) * recip_h;
+
+            v6_layer_face.m_UV[0] = (g->m_X + font_map->m_CacheCellPadding + g->m_Width) * recip_w;
+            v6_layer_face.m_UV[1] = (g->m_Y + font_map->m_CacheCellPadding + px_cell_offset_y) * recip_h;
+
+            #define SET_VERTEX_FONT_PROPERTIES(v) \
+                v.m_FaceColor[0]    = face_color[0]; \
+                v.m_FaceColor[1]    = face_color[1]; \
+                v.m_FaceColor[2]    = face_color[2]; \
+                v.m_FaceColor[3]    = face_color[3]; \
+                v.m_OutlineColor[0] = outline_color[0]; \
+                v.m_OutlineColor[1] = outline_color[1]; \
+                v.m_OutlineColor[2] = outline_color[2]; \
+                v.m_OutlineColor[3] = outline_color[3]; \
+                v.m_ShadowColor[0]  = shadow_color[0]; \
+                v.m_ShadowColor[1]  = shadow_color[1]; \
+                v.m_ShadowColor[2]  = shadow_color[2]; \
+                v.m_ShadowColor[3]  = shadow_color[3]; \
+                v.m_FaceColor[0]    = face_color[0]; \
+                v.m_FaceColor[1]    = face_color[1]; \
+                v.m_FaceColor[2]    = face_color[2]; \
+                v.m_FaceColor[3]    = face_color[3]; \
+                v.m_SdfParams[0]    = sdf_edge_value; \
+                v.m_SdfParams[1]    = sdf_outline; \
+                v.m_SdfParams[2]    = sdf_smoothing; \
+                v.m_SdfParams[3]    = sdf_shadow;
+
+            SET_VERTEX_FONT_PROPERTIES(v1_layer_face)
+            SET_VERTEX_FONT_PROPERTIES(v2_layer_face)
+            SET_VERTEX_FONT_PROPERTIES(v3_layer_face)
+            SET_VERTEX_FONT_PROPERTIES(v6_layer_face)
+
+            #undef SET_VERTEX_FONT_PROPERTIES
+
+            v4_layer_face = v3_layer_face;
+            v5_layer_face = v2_layer_face;
+
+            #define SET_VERTEX_LAYER_MASK(v,f,o,s) \
+                v.m_LayerMasks[0] = f; \
+                v.m_LayerMasks[1] = o; \
+                v.m_LayerMasks[2] = s;
+
+            // Set outline vertices
+            if (HAS_LAYER(layer_mask,OUTLINE))
+            {
+                uint32_t outline_index = vertexindex + vertices_per_quad * valid_glyph_count * (layer_count-2);
+
+                GlyphVertex& v1_layer_outline = vertices[outline_index];
+                GlyphVertex& v2_layer_outline = vertices[outline_index + 1];
+                GlyphVertex& v3_layer_outline = vertices[outline_index + 2];
+                GlyphVertex& v4_layer_outline = vertices[outline_index + 3];
+                GlyphVertex& v5_layer_outline = vertices[outline_index + 4];
+                GlyphVertex& v6_layer_outline = vertices[outline_index + 5];
+
+                v1_layer_outline = v1_layer_face;
+                v2_layer_outline = v2_layer_face;
+                v3_layer_outline = v3_layer_face;
+                v4_layer_outline = v4_layer_face;
+                v5_layer_outline = v5_layer_face;
+                v6_layer_outline = v6_layer_face;
+
+                SET_VERTEX_LAYER_MASK(v1_layer_outline,0,1,0)
+                SET_VERTEX_LAYER_MASK(v2_layer_outline,0,1,0)
+                SET_VERTEX_LAYER_MASK(v3_layer_outline,0,1,0)
+                SET_VERTEX_LAYER_MASK(v4_layer_outline,0,1,0)
+                SET_VERTEX_LAYER_MASK(v5_layer_outline,0,1,0)
+                SET_VERTEX_LAYER_MASK(v6_layer_outline,0,1,0)
+            }
 
-                    if (g->m_InCache) {
-                        g->m_Frame = text_context.m_Frame;
-
-                        uint32_t face_index = vertexindex + vertices_per_quad * valid_glyph_count * (layer_count-1);
-
-                        // Set face vertices first, this will always hold since we can't have less than 1 layer
-                        GlyphVertex& v1_layer_face = vertices[face_index];
-                        GlyphVertex& v2_layer_face = vertices[face_index + 1];
-                        GlyphVertex& v3_layer_face = vertices[face_index + 2];
-                        GlyphVertex& v4_layer_face = vertices[face_index + 3];
-                        GlyphVertex& v5_layer_face = vertices[face_index + 4];
-                        GlyphVertex& v6_layer_face = vertices[face_index + 5];
-
-                        (Vector4&) v1_layer_face.m_Position = te.m_Transform * Vector4(x + g->m_LeftBearing, y - descent, 0, 1);
-                        (Vector4&) v2_layer_face.m_Position = te.m_Transform * Vector4(x + g->m_LeftBearing, y + ascent, 0, 1);
-                        (Vector4&) v3_layer_face.m_Position = te.m_Transform * Vector4(x + g->m_LeftBearing + width, y - descent, 0, 1);
-                        (Vector4&) v6_layer_face.m_Position = te.m_Transform * Vector4(x + g->m_LeftBearing + width, y + ascent, 0, 1);
-
-                        v1_layer_face.m_UV[0] = (g->m_X + font_map->m_CacheCellPadding) * recip_w;
-                        v1_layer_face.m_UV[1] = (g->m_Y + font_map->m_CacheCellPadding + ascent + descent + px_cell_offset_y) * recip_h;
-
-                        v2_layer_face.m_UV[0] = (g->m_X + font_map->m_CacheCellPadding) * recip_w;
-                        v2_layer_face.m_UV[1] = (g->m_Y + font_map->m_CacheCellPadding + px_cell_offset_y) * recip_h;
-
-                        v3_layer_face.m_UV[0] = (g->m_X + font_map->m_CacheCellPadding + g->m_Width) * recip_w;
-                        v3_layer_face.m_UV[1] = (g->m_Y + font_map->m_CacheCellPadding + ascent + descent + px_cell_offset_y) * recip_h;
-
-                        v6_layer_face.m_UV[0] = (g->m_X + font_map->m_CacheCellPadding + g->m_Width) * recip_w;
-                        v6_layer_face.m_UV[1] = (g->m_Y + font_map->m_CacheCellPadding + px_cell_offset_y) * recip_h;
-
-                        #define SET_VERTEX_FONT_PROPERTIES(v) \
-                            v.m_FaceColor[0]    = face_color[0]; \
-                            v.m_FaceColor[1]    = face_color[1]; \
-                            v.m_FaceColor[2]    = face_color[2]; \
-                            v.m_FaceColor[3]    = face_color[3]; \
-                            v.m_OutlineColor[0] = outline_color[0]; \
-                            v.m_OutlineColor[1] = outline_color[1]; \
-                            v.m_OutlineColor[2] = outline_color[2]; \
-                            v.m_OutlineColor[3] = outline_color[3]; \
-                            v.m_ShadowColor[0]  = shadow_color[0]; \
-                            v.m_ShadowColor[1]  = shadow_color[1]; \
-                            v.m_ShadowColor[2]  = shadow_color[2]; \
-                            v.m_ShadowColor[3]  = shadow_color[3]; \
-                            v.m_FaceColor[0]    = face_color[0]; \
-                            v.m_FaceColor[1]    = face_color[1]; \
-                            v.m_FaceColor[2]    = face_color[2]; \
-                            v.m_FaceColor[3]    = face_color[3]; \
-                            v.m_SdfParams[0]    = sdf_edge_value; \
-                            v.m_SdfParams[1]    = sdf_outline; \
-                            v.m_SdfParams[2]    = sdf_smoothing; \
-                            v.m_SdfParams[3]    = sdf_shadow;
-
-                        SET_VERTEX_FONT_PROPERTIES(v1_layer_face)
-                        SET_VERTEX_FONT_PROPERTIES(v2_layer_face)
-                        SET_VERTEX_FONT_PROPERTIES(v3_layer_face)
-                        SET_VERTEX_FONT_PROPERTIES(v6_layer_face)
-
-                        #undef SET_VERTEX_FONT_PROPERTIES
-
-                        v4_layer_face = v3_layer_face;
-                        v5_layer_face = v2_layer_face;
-
-                        #define SET_VERTEX_LAYER_MASK(v,f,o,s) \
-                            v.m_LayerMasks[0] = f; \
-                            v.m_LayerMasks[1] = o; \
-                            v.m_LayerMasks[2] = s;
-
-                        // Set outline vertices
-                        if (HAS_LAYER(layer_mask,OUTLINE))
-                        {
-                            uint32_t outline_index = vertexindex + vertices_per_quad * valid_glyph_count * (layer_count-2);
-
-                            GlyphVertex& v1_layer_outline = vertices[outline_index];
-                            GlyphVertex& v2_layer_outline = vertices[outline_index + 1];
-                            GlyphVertex& v3_layer_outline = vertices[outline_index + 2];
-                            GlyphVertex& v4_layer_outline = vertices[outline_index + 3];
-                            GlyphVertex& v5_layer_outline = vertices[outline_index + 4];
-                            GlyphVertex& v6_layer_outline = vertices[outline_index + 5];
-
-                            v1_layer_outline = v1_layer_face;
-                            v2_layer_outline = v2_layer_face;
-                            v3_layer_outline = v3_layer_face;
-                            v4_layer_outline = v4_layer_face;
-                            v5_layer_outline = v5_layer_face;
-                            v6_layer_outline = v6_layer_face;
-
-                            SET_VERTEX_LAYER_MASK(v1_layer_outline,0,1,0)
-                            SET_VERTEX_LAYER_MASK(v2_layer_outline,0,1,0)
-                            SET_VERTEX_LAYER_MASK(v3_layer_outline,0,1,0)
-                            SET_VERTEX_LAYER_MASK(v4_layer_outline,0,1,0)
-                            SET_VERTEX_LAYER_MASK(v5_layer_outline,0,1,0)
-                            SET_VERTEX_LAYER_MASK(v6_layer_outline,0,1,0)
-                        }
-
-                        // Set shadow vertices
-                        if (HAS_LAYER(layer_mask,SHADOW))
-                        {
-                            uint32_t shadow_index = vertexindex;
-                            float shadow_x        = font_map->m_ShadowX;
-                            float shadow_y        = font_map->m_ShadowY;
-
-                            GlyphVertex& v1_layer_shadow = vertices[shadow_index];
-                            GlyphVertex& v2_layer_shadow = vertices[shadow_index + 1];
-                            GlyphVertex& v3_layer_shadow = vertices[shadow_index + 2];
-                            GlyphVertex& v4_layer_shadow = vertices[shadow_index + 3];
-                            GlyphVertex& v5_layer_shadow = vertices[shadow_index + 4];
-                            GlyphVertex& v6_layer_shadow = vertices[shadow_index + 5];
-
-                            v1_layer_shadow = v1_layer_face;
-                            v2_layer_shadow = v2_layer_face;
-                            v3_layer_shadow = v3_layer_face;
-                            v6_layer_shadow = v6_layer_face;
-
-                            // Shadow offsets must be calculated since we need to offset in local space (before vertex transformation)
-                            (Vector4&) v1_layer_shadow.m_Position = te.m_Transform * Vector4(x + g->m_LeftBearing + shadow_x, y - descent + shadow_y, 0, 1);
-                            (Vector4&) v2_layer_shadow.m_Position = te.m_Transform * Vector4(x + g->m_LeftBearing + shadow_x, y + ascent + shadow_y, 0, 1);
-                            (Vector4&) v3_layer_shadow.m_Position = te.m_Transform * Vector4(x + g->m_LeftBearing + shadow_x + width, y - descent + shadow_y, 0, 1);
-                            (Vector4&) v6_layer_shadow.m_Position = te.m_Transform * Vector4(x + g->m_LeftBearing + shadow_x + width, y + ascent + shadow_y, 0, 1);
-
-                            v4_layer_shadow = v3_layer_shadow;
-                            v5_layer_shadow = v2_layer_shadow;
-
-                            SET_VERTEX_LAYER_MASK(v1_layer_shadow,0,0,1)
-                            SET_VERTEX_LAYER_MASK(v2_layer_shadow,0,0,1)
-                            SET_VERTEX_LAYER_MASK(v3_layer_shadow,0,0,1)
-                            SET_VERTEX_LAYER_MASK(v4_layer_shadow,0,0,1)
-                            SET_VERTEX_LAYER_MASK(v5_layer_shadow,0,0,1)
-                            SET_VERTEX_LAYER_MASK(v6_layer_shadow,0,0,1)
-                        }
-
-                        // If we only have one layer, we need to set the mask to (1,1,1)
-                        // so that we can use the same calculations for both single and multi.
-                        // The mask is set last for layer 1 since we copy the vertices to
-                        // all other layers to avoid re-calculating their data.
-                        uint8_t is_one_layer = layer_count > 1 ? 0 : 1;
-                        SET_VERTEX_LAYER_MASK(v1_layer_face,1,is_one_layer,is_one_layer)
-                        SET_VERTEX_LAYER_MASK(v2_layer_face,1,is_one_layer,is_one_layer)
-                        SET_VERTEX_LAYER_MASK(v3_layer_face,1,is_one_layer,is_one_layer)
-                        SET_VERTEX_LAYER_MASK(v4_layer_face,1,is_one_layer,is_one_layer)
-                        SET_VERTEX_LAYER_MASK(v5_layer_face,1,is_one_layer,is_one_layer)
-                        SET_VERTEX_LAYER_MASK(v6_layer_face,1,is_one_layer,is_one_layer)
-
-                        #undef SET_VERTEX_LAYER_MASK
-
-                        vertexindex += vertices_per_quad;
-                    }
-                }
-                x += (int16_t)(g->m_Advance + tracking);
+            // Set shadow vertices
+            if (HAS_LAYER(layer_mask,SHADOW))
+            {
+                uint32_t shadow_index = vertexindex;
+                float shadow_x        = font_map->m_ShadowX;
+                float shadow_y        = font_map->m_ShadowY;
+
+                GlyphVertex& v1_layer_shadow = vertices[shadow_index];
+                GlyphVertex& v2_layer_shadow = vertices[shadow_index + 1];
+                GlyphVertex& v3_layer_shadow = vertices[shadow_index + 2];
+                GlyphVertex& v4_layer_shadow = vertices[shadow_index + 3];
+                GlyphVertex& v5_layer_shadow = vertices[shadow_index + 4];
+                GlyphVertex& v6_layer_shadow = vertices[shadow_index + 5];
+
+                v1_layer_shadow = v1_layer_face;
+                v2_layer_shadow = v2_layer_face;
+                v3_layer_shadow = v3_layer_face;
+                v6_layer_shadow = v6_layer_face;
+
+                // Shadow offsets must be calculated since we need to offset in local space (before vertex transformation)
+                (Vector4&) v1_layer_shadow.m_Position = transform * Vector4(x + g->m_LeftBearing + shadow_x, y - descent + shadow_y, 0, 1);
+                (Vector4&) v2_layer_shadow.m_Position = transform * Vector4(x + g->m_LeftBearing + shadow_x, y + ascent + shadow_y, 0, 1);
+                (Vector4&) v3_layer_shadow.m_Position = transform * Vector4(x + g->m_LeftBearing + shadow_x + width, y - descent + shadow_y, 0, 1);
+                (Vector4&) v6_layer_shadow.m_Position = transform * Vector4(x + g->m_LeftBearing + shadow_x + width, y + ascent + shadow_y, 0, 1);
+
+                v4_layer_shadow = v3_layer_shadow;
+                v5_layer_shadow = v2_layer_shadow;
+
+                SET_VERTEX_LAYER_MASK(v1_layer_shadow,0,0,1)
+                SET_VERTEX_LAYER_MASK(v2_layer_shadow,0,0,1)
+                SET_VERTEX_LAYER_MASK(v3_layer_shadow,0,0,1)
+                SET_VERTEX_LAYER_MASK(v4_layer_shadow,0,0,1)
+                SET_VERTEX_LAYER_MASK(v5_layer_shadow,0,0,1)
+                SET_VERTEX_LAYER_MASK(v6_layer_shadow,0,0,1)
             }
+
+            // If we only have one layer, we need to set the mask to (1,1,1)
+            // so that we can use the same calculations for both single and multi.
+            // The mask is set last for layer 1 since we copy the vertices to
+            // all other layers to avoid re-calculating their data.
+            uint8_t is_one_layer = layer_count > 1 ? 0 : 1;
+            SET_VERTEX_LAYER_MASK(v1_layer_face,1,is_one_layer,is_one_layer)
+            SET_VERTEX_LAYER_MASK(v2_layer_face,1,is_one_layer,is_one_layer)
+            SET_VERTEX_LAYER_MASK(v3_layer_face,1,is_one_layer,is_one_layer)
+            SET_VERTEX_LAYER_MASK(v4_layer_face,1,is_one_layer,is_one_layer)
+            SET_VERTEX_LAYER_MASK(v5_layer_face,1,is_one_layer,is_one_layer)
+            SET_VERTEX_LAYER_MASK(v6_layer_face,1,is_one_layer,is_one_layer)
+
+            #undef SET_VERTEX_LAYER_MASK
+
+            vertexindex += vertices_per_quad;
         }
 
         #undef HAS_LAYER
@@ -980,21 +991,9 @@ namespace dmRender
         const TextEntry& first_te = *(TextEntry*) buf[*begin].m_UserData;
 
         HFontMap font_map = first_te.m_FontMap;
-        float im_recip = 1.0f;
-        float ih_recip = 1.0f;
-        float cache_cell_width_ratio  = 0.0;
-        float cache_cell_height_ratio = 0.0;
-
-        if (font_map->m_Texture) {
-            float cache_width  = (float) dmGraphics::GetTextureWidth(font_map->m_Texture);
-            float cache_height = (float) dmGraphics::GetTextureHeight(font_map->m_Texture);
-
-            im_recip /= cache_width;
-            ih_recip /= cache_height;
-
-            cache_cell_width_ratio  = ((float) font_map->m_CacheCellWidth) / cache_width;
-            cache_cell_height_ratio = ((float) font_map->m_CacheCellHeight) / cache_height;
-        }
+        Vector4 texture_size_recip = GetTextureSizeRecip(font_map);
+        float im_recip = texture_size_recip.getX();
+        float ih_recip = texture_size_recip.getY();
 
         GlyphVertex* vertices = (GlyphVertex*)text_context.m_ClientBuffer;
 
@@ -1014,7 +1013,6 @@ namespace dmRender
         ro->m_StencilTestParams = first_te.m_StencilTestParams;
         ro->m_SetStencilTest = first_te.m_StencilTestParamsSet;
 
-        Vector4 texture_size_recip(im_recip, ih_recip, cache_cell_width_ratio, cache_cell_height_ratio);
         EnableRenderObjectConstant(ro, g_TextureSizeRecipHash, texture_size_recip);
 
         const dmRender::Constant* constants = first_te.m_RenderConstants;
@@ -1030,8 +1028,17 @@ namespace dmRender
             const TextEntry& te = *(TextEntry*) buf[*i].m_UserData;
             const char* text = &text_context.m_TextBuffer[te.m_StringOffset];
 
-            int num_indices = CreateFontVertexDataInternal(text_context, font_map, text, te, im_recip, ih_recip, &vertices[text_context.m_VertexIndex], text_context.m_MaxVertexCount - text_context.m_VertexIndex);
-            text_context.m_VertexIndex += num_indices;
+            text_context.m_Glyphs.SetSize(0);
+            LayoutGlyphs(font_map, text, te.m_Width, te.m_Height, te.m_Leading, te.m_Tracking, te.m_LineBreak, te.m_Align, te.m_VAlign, text_context.m_Glyphs);
+
+            const Vector4 face_color    = dmGraphics::UnpackRGBA(te.m_FaceColor);
+            const Vector4 outline_color = dmGraphics::UnpackRGBA(te.m_OutlineColor);
+            const Vector4 shadow_color  = dmGraphics::UnpackRGBA(te.m_ShadowColor);
+
+            uint32_t num_vertices = CreateGlyphVertices(text_context, font_map, te.m_Transform, face_color, outline_color, shadow_color,
+                                                        text_context.m_Glyphs.Begin(), text_context.m_Glyphs.Size(), im_recip, ih_recip,
+                                                        &vertices[text_context.m_VertexIndex], text_context.m_MaxVertexCount - text_context.m_VertexIndex);
+            text_context.m_VertexIndex += num_vertices;
         }
 
         ro->m_VertexCount = text_context.m_VertexIndex - ro->m_VertexStart;
@@ -1121,6 +1128,37 @@ namespace dmRender
         text_context.m_TextEntriesFlushed = text_context.m_TextEntries.Size();
     }
 
+    void LayoutText(HFontMap font_map, const DrawTextParams& params, dmArray<TextGlyph>& glyphs)
+    {
+        DM_PROFILE(Render, "LayoutText");
+        LayoutGlyphs(font_map, params.m_Text, params.m_Width, params.m_Height, params.m_Leading, params.m_Tracking, params.m_LineBreak, params.m_Align, params.m_VAlign, glyphs);
+    }
+
+    uint32_t GetTextVertexCount(HFontMap font_map, uint32_t glyph_count)
+    {
+        return glyph_count * 6 * GetLayerCount(font_map);
+    }
+
+    uint32_t CreateTextVertexData(HRenderContext render_context, HFontMap font_map, const Matrix4& transform,
+                                  const Vector4& face_color, const Vector4& outline_color, const Vector4& shadow_color,
+                                  const TextGlyph* glyphs, uint32_t glyph_count, GlyphVertex* vertices, uint32_t max_vertex_count)
+    {
+        Vector4 texture_size_recip = GetTextureSizeRecip(font_map);
+        return CreateGlyphVertices(render_context->m_TextContext, font_map, transform,
+                                   Vector4(face_color.getXYZ(), face_color.getW() * font_map->m_Alpha),
+                                   Vector4(outline_color.getXYZ(), outline_color.getW() * font_map->m_OutlineAlpha),
+                                   Vector4(shadow_color.getXYZ(), shadow_color.getW() * font_map->m_ShadowAlpha),
+                                   glyphs, glyph_count, texture_size_recip.getX(), texture_size_recip.getY(), vertices, max_vertex_count);
+    }
+
+    void SetupTextRenderObject(HRenderContext render_context, HFontMap font_map, RenderObject* ro)
+    {
+        ro->m_VertexDeclaration = render_context->m_TextContext.m_VertexDecl;
+        ro->m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
+        ro->m_Textures[0] = font_map->m_Texture;
+        EnableRenderObjectConstant(ro, g_TextureSizeRecipHash, GetTextureSizeRecip(font_map));
+    }
+
     static float GetLineTextMetrics(HFontMap font_map, float tracking, const char* text, int n, bool measure_trailing_space)
     {
         float width = 0;
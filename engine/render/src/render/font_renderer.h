@@ -64,6 +64,18 @@ namespace dmRender
         float m_LayerMasks[3];
     };
 
+    /**
+     * Laid out glyph, see #LayoutText
+     */
+    struct TextGlyph
+    {
+        /// Position of the glyph origin in font space
+        float    m_X;
+        float    m_Y;
+        /// Character code, the glyph is looked up when the vertices are created
+        uint32_t m_Character;
+    };
+
     /**
      * Font map parameters supplied to NewFontMap
      */
@@ -241,6 +253,52 @@ namespace dmRender
      */
     void FlushTexts(HRenderContext render_context, uint32_t major_order, uint32_t render_order, bool final);
 
+    /**
+     * Lay out text into glyph positions in font space. The layout only depends on the text, the font map
+     * and the layout parameters of params (width, height, leading, tracking, line break and alignment),
+     * so it can be kept and reused with #CreateTextVertexData as long as those stay the same.
+     * @param font_map Font map handle
+     * @param params Text to lay out and the layout parameters
+     * @param glyphs [out] Glyphs, appended to the array
+     */
+    void LayoutText(HFontMap font_map, const DrawTextParams& params, dmArray<TextGlyph>& glyphs);
+
+    /**
+     * Get the number of vertices needed to draw laid out glyphs with a font map
+     * @param font_map Font map handle
+     * @param glyph_count Number of glyphs
+     * @return Max number of vertices
+     */
+    uint32_t GetTextVertexCount(HFontMap font_map, uint32_t glyph_count);
+
+    /**
+     * Write the vertices for laid out glyphs, adding the glyphs to the glyph cache of the font map when needed.
+     * The vertices are in world space, so the same buffer can hold several texts drawn with the same font map.
+     * @param render_context Context to use when rendering
+     * @param font_map Font map handle
+     * @param transform Transform from font space to world
+     * @param face_color Color of the font face
+     * @param outline_color Color of the outline
+     * @param shadow_color Color of the shadow
+     * @param glyphs Glyphs from #LayoutText
+     * @param glyph_count Number of glyphs
+     * @param vertices Vertex buffer to write to, 16 bytes aligned
+     * @param max_vertex_count Capacity of the vertex buffer
+     * @return Number of vertices written
+     */
+    uint32_t CreateTextVertexData(HRenderContext render_context, HFontMap font_map, const Vectormath::Aos::Matrix4& transform,
+                                  const Vectormath::Aos::Vector4& face_color, const Vectormath::Aos::Vector4& outline_color, const Vectormath::Aos::Vector4& shadow_color,
+                                  const TextGlyph* glyphs, uint32_t glyph_count, GlyphVertex* vertices, uint32_t max_vertex_count);
+
+    /**
+     * Set up the vertex declaration, texture and constants to draw vertices from #CreateTextVertexData.
+     * The material of the render object must be set first.
+     * @param render_context Context to use when rendering
+     * @param font_map Font map handle
+     * @param ro Render object
+     */
+    void SetupTextRenderObject(HRenderContext render_context, HFontMap font_map, RenderObject* ro);
+
     /**
      * Get text metrics for string
      * @param font_map Font map handle
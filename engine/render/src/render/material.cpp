@@ -24,6 +24,17 @@ namespace dmRender
 {
     using namespace Vectormath::Aos;
 
+    // The vertex program takes the world transform per instance when it has a mtx_world attribute
+    static void UpdateMaterialInstanced(Material* m, dmGraphics::HContext graphics_context)
+    {
+        bool has_world_attribute = dmGraphics::GetAttributeLocation(m->m_Program, "mtx_world") != -1;
+        m->m_Instanced = has_world_attribute && dmGraphics::IsInstancingSupported(graphics_context);
+        if (has_world_attribute && !m->m_Instanced)
+        {
+            dmLogWarning("The vertex program takes the world transform as a 'mtx_world' attribute, but instancing isn't supported on this device. Objects using the material will not be transformed.");
+        }
+    }
+
     HMaterial NewMaterial(dmRender::HRenderContext render_context, dmGraphics::HVertexProgram vertex_program, dmGraphics::HFragmentProgram fragment_program)
     {
         Material* m = new Material;
@@ -32,6 +43,7 @@ namespace dmRender
         m->m_FragmentProgram = fragment_program;
         dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
         m->m_Program = dmGraphics::NewProgram(graphics_context, vertex_program, fragment_program);
+        UpdateMaterialInstanced(m, graphics_context);
 
         uint32_t total_constants_count = dmGraphics::GetUniformCount(m->m_Program);
         const uint32_t buffer_size = 128;
@@ -439,6 +451,19 @@ namespace dmRender
         return material->m_VertexSpace;
     }
 
+    bool IsMaterialInstanced(HMaterial material)
+    {
+        return material->m_Instanced;
+    }
+
+    bool ReloadMaterialProgram(HMaterial material)
+    {
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(material->m_RenderContext);
+        bool result = dmGraphics::ReloadProgram(graphics_context, material->m_Program, material->m_VertexProgram, material->m_FragmentProgram);
+        UpdateMaterialInstanced(material, graphics_context);
+        return result;
+    }
+
     uint32_t GetMaterialTagListKey(HMaterial material)
     {
         return material->m_TagListKey;
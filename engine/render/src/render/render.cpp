@@ -149,6 +149,7 @@ namespace dmRender
         context->m_StencilBufferCleared = 0;
 
         context->m_RenderListDispatch.SetCapacity(255);
+        context->m_FrameArena = dmArenaAllocator::New(64 * 1024, "RenderFrameArena");
 
         dmMessage::Result r = dmMessage::NewSocket(RENDER_SOCKET_NAME, &context->m_Socket);
         assert(r == dmMessage::RESULT_OK);
@@ -164,6 +165,7 @@ namespace dmRender
         FinalizeDebugRenderer(render_context);
         FinalizeTextContext(render_context);
         dmMessage::DeleteSocket(render_context->m_Socket);
+        dmArenaAllocator::Delete(render_context->m_FrameArena);
         delete render_context;
 
         return RESULT_OK;
@@ -179,6 +181,7 @@ namespace dmRender
         render_context->m_RenderListSortIndices.SetSize(0);
         render_context->m_RenderListDispatch.SetSize(0);
         render_context->m_RenderListRanges.SetSize(0);
+        dmArenaAllocator::Reset(render_context->m_FrameArena);
     }
 
     HRenderListDispatch RenderListMakeDispatch(HRenderContext render_context, RenderListDispatchFn fn, void *user_data)
@@ -265,6 +268,11 @@ namespace dmRender
         render_context->m_SystemFontMap = font_map;
     }
 
+    dmArenaAllocator::HArena GetFrameArena(HRenderContext render_context)
+    {
+        return render_context->m_FrameArena;
+    }
+
     dmGraphics::HContext GetGraphicsContext(HRenderContext render_context)
     {
         return render_context->m_GraphicsContext;
@@ -403,11 +411,12 @@ namespace dmRender
     {
         DM_PROFILE(Render, "MakeSortBuffer");
 
+        // Allocated from the frame arena and released at the end of DrawRenderList
         const uint32_t required_capacity = context->m_RenderListSortIndices.Capacity();
-        // SetCapacity does early out if they are the same, so just call anyway.
-        context->m_RenderListSortBuffer.SetCapacity(required_capacity);
         context->m_RenderListSortBuffer.SetSize(0);
-        context->m_RenderListSortValues.SetCapacity(required_capacity);
+        context->m_RenderListSortValues.SetSize(0);
+        dmArenaAllocator::SetCapacity(context->m_FrameArena, context->m_RenderListSortBuffer, required_capacity);
+        dmArenaAllocator::SetCapacity(context->m_FrameArena, context->m_RenderListSortValues, required_capacity);
         context->m_RenderListSortValues.SetSize(context->m_RenderListSortIndices.Size());
 
         RenderListSortValue* sort_values = context->m_RenderListSortValues.Begin();
@@ -557,10 +566,15 @@ namespace dmRender
             SortRenderList(context);
         }
 
+        dmArenaAllocator::Marker arena_marker = dmArenaAllocator::GetMarker(context->m_FrameArena);
+
         MakeSortBuffer(context, predicate?predicate->m_TagCount:0, predicate?predicate->m_Tags:0);
 
         if (context->m_RenderListSortBuffer.Empty())
+        {
+            dmArenaAllocator::ResetToMarker(context->m_FrameArena, arena_marker);
             return RESULT_OK;
+        }
 
         {
             DM_PROFILE(Render, "DrawRenderList_SORT");
@@ -628,6 +642,8 @@ namespace dmRender
             d.m_Fn(params);
         }
 
+        dmArenaAllocator::ResetToMarker(context->m_FrameArena, arena_marker);
+
         return Draw(context, predicate, constant_buffer);
     }
 
@@ -702,7 +718,18 @@ namespace dmRender
 
             dmGraphics::EnableVertexDeclaration(context, ro->m_VertexDeclaration, ro->m_VertexBuffer, GetMaterialProgram(material));
 
-            if (ro->m_IndexBuffer)
+            if (ro->m_InstanceCount > 0)
+            {
+                dmGraphics::EnableInstanceVertexDeclaration(context, ro->m_InstanceVertexDeclaration, ro->m_InstanceVertexBuffer, ro->m_InstanceBufferOffset, GetMaterialProgram(material));
+
+                if (ro->m_IndexBuffer)
+                    dmGraphics::DrawElementsInstanced(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_IndexType, ro->m_IndexBuffer, ro->m_InstanceCount);
+                else
+                    dmGraphics::DrawInstanced(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_InstanceCount);
+
+                dmGraphics::DisableInstanceVertexDeclaration(context, ro->m_InstanceVertexDeclaration);
+            }
+            else if (ro->m_IndexBuffer)
                 dmGraphics::DrawElements(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_IndexType, ro->m_IndexBuffer);
             else
                 dmGraphics::Draw(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount);
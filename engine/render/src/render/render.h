@@ -18,6 +18,7 @@
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
 #include <dmsdk/render/render.h>
 
+#include <dlib/arena_allocator.h>
 #include <dlib/hash.h>
 #include <script/script.h>
 #include <script/lua_source_ddf.h>
@@ -114,6 +115,10 @@ namespace dmRender
 
     dmGraphics::HContext GetGraphicsContext(HRenderContext render_context);
 
+    // Arena for transient data during a frame. Allocations made by render list dispatches
+    // are released when DrawRenderList returns, and everything else in RenderListBegin.
+    dmArenaAllocator::HArena GetFrameArena(HRenderContext render_context);
+
     const Matrix4& GetViewProjectionMatrix(HRenderContext render_context);
     void SetViewMatrix(HRenderContext render_context, const Matrix4& view);
     void SetProjectionMatrix(HRenderContext render_context, const Matrix4& projection);
@@ -193,6 +198,11 @@ namespace dmRender
     dmGraphics::HProgram            GetMaterialProgram(HMaterial material);
     dmGraphics::HVertexProgram      GetMaterialVertexProgram(HMaterial material);
     dmGraphics::HFragmentProgram    GetMaterialFragmentProgram(HMaterial material);
+    // True if the vertex program has a "mtx_world" mat4 attribute and the graphics backend supports instancing.
+    // Render objects using the material can then be drawn instanced, see RenderObject::m_InstanceCount
+    bool                            IsMaterialInstanced(HMaterial material);
+    // Relinks the program after its shaders were reloaded, and updates whether the material is instanced
+    bool                            ReloadMaterialProgram(HMaterial material);
     void                            SetMaterialProgramConstantType(HMaterial material, dmhash_t name_hash, dmRenderDDF::MaterialDesc::ConstantType type);
     bool                            GetMaterialProgramConstant(HMaterial, dmhash_t name_hash, Constant& out_value);
 
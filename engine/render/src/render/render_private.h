@@ -15,11 +15,13 @@
 
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
 
+#include <dlib/arena_allocator.h>
 #include <dlib/array.h>
 #include <dlib/message.h>
 #include <dlib/hashtable.h>
 
 #include "render.h"
+#include "font_renderer.h"
 
 extern "C"
 {
@@ -69,6 +71,7 @@ namespace dmRender
         , m_UserData1(0)
         , m_UserData2(0)
         , m_VertexSpace(dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL)
+        , m_Instanced(0)
         {
         }
 
@@ -83,6 +86,7 @@ namespace dmRender
         uint64_t                                m_UserData1;
         uint64_t                                m_UserData2;
         dmRenderDDF::MaterialDesc::VertexSpace  m_VertexSpace;
+        uint8_t                                 m_Instanced : 1;    // the vertex program takes the world transform per instance
     };
 
     // The order of this enum also defines the order in which the corresponding ROs should be rendered
@@ -157,6 +161,8 @@ namespace dmRender
         // Map from batch id (hash of font-map etc) to index into m_TextEntries
         dmArray<TextEntry>                  m_TextEntries;
         uint32_t                            m_TextEntriesFlushed;
+        // Scratch layout for the text entry being batched
+        dmArray<TextGlyph>                  m_Glyphs;
         uint32_t                            m_Frame;
         uint32_t                            m_PreviousFrame;
     };
@@ -225,6 +231,8 @@ namespace dmRender
         dmArray<uint32_t>           m_RenderListSortIndices;
         dmArray<RenderListRange>    m_RenderListRanges;         // Maps tagmask to a range in the (sorted) render list
 
+        dmArenaAllocator::HArena    m_FrameArena;               // Transient data, reset in RenderListBegin
+
         dmHashTable32<MaterialTagList>  m_MaterialTagLists;
 
         HFontMap                    m_SystemFontMap;
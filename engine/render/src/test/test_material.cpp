@@ -198,6 +198,44 @@ TEST(dmMaterialTest, MatchMaterialTags)
     ASSERT_FALSE(dmRender::MatchMaterialTags(DM_ARRAY_SIZE(material_tags), material_tags, DM_ARRAY_SIZE(tags_e), tags_e));
 }
 
+TEST(dmMaterialTest, TestMaterialInstancedReload)
+{
+    dmGraphics::Initialize();
+    dmGraphics::HContext context = dmGraphics::NewContext(dmGraphics::ContextParams());
+    dmRender::RenderContextParams params;
+    params.m_ScriptContext = dmScript::NewContext(0, 0, true);
+    params.m_MaxCharacters = 256;
+    dmRender::HRenderContext render_context = dmRender::NewRenderContext(context, params);
+
+    const char* vp_source = "attribute vec4 position;\n";
+    dmGraphics::ShaderDesc::Shader vp_shader = MakeDDFShader(vp_source, strlen(vp_source));
+    dmGraphics::HVertexProgram vp = dmGraphics::NewVertexProgram(context, &vp_shader);
+    dmGraphics::ShaderDesc::Shader fp_shader = MakeDDFShader("foo", 3);
+    dmGraphics::HFragmentProgram fp = dmGraphics::NewFragmentProgram(context, &fp_shader);
+
+    dmRender::HMaterial material = dmRender::NewMaterial(render_context, vp, fp);
+    ASSERT_FALSE(dmRender::IsMaterialInstanced(material));
+
+    // The world transform is taken per instance after the vertex program is reloaded with it
+    const char* vp_instanced_source = "attribute vec4 position;\nattribute mat4 mtx_world;\n";
+    dmGraphics::ShaderDesc::Shader vp_instanced_shader = MakeDDFShader(vp_instanced_source, strlen(vp_instanced_source));
+    ASSERT_TRUE(dmGraphics::ReloadVertexProgram(vp, &vp_instanced_shader));
+    ASSERT_TRUE(dmRender::ReloadMaterialProgram(material));
+    ASSERT_TRUE(dmRender::IsMaterialInstanced(material));
+
+    ASSERT_TRUE(dmGraphics::ReloadVertexProgram(vp, &vp_shader));
+    ASSERT_TRUE(dmRender::ReloadMaterialProgram(material));
+    ASSERT_FALSE(dmRender::IsMaterialInstanced(material));
+
+    dmRender::DeleteMaterial(render_context, material);
+    dmGraphics::DeleteVertexProgram(vp);
+    dmGraphics::DeleteFragmentProgram(fp);
+
+    dmRender::DeleteRenderContext(render_context, 0);
+    dmGraphics::DeleteContext(context);
+    dmScript::DeleteContext(params.m_ScriptContext);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -640,6 +640,37 @@ TEST_F(dmRenderTest, GetTextMetricsMeasureTrailingSpace)
     ASSERT_GT(metricsSingleLineSpace.m_Width, 0);
 }
 
+TEST_F(dmRenderTest, LayoutText)
+{
+    const int charwidth     = 2;
+    const int lineheight    = 3;
+
+    dmRender::DrawTextParams params;
+    params.m_Text = "Hello World";
+    params.m_Width = 8*charwidth;
+    params.m_LineBreak = true;
+
+    dmArray<dmRender::TextGlyph> glyphs;
+    dmRender::LayoutText(m_SystemFontMap, params, glyphs);
+
+    // The space is dropped at the line break
+    ASSERT_EQ(10U, glyphs.Size());
+    ASSERT_EQ((uint32_t)'H', glyphs[0].m_Character);
+    ASSERT_EQ((uint32_t)'W', glyphs[5].m_Character);
+    ASSERT_EQ(0, glyphs[0].m_X);
+    ASSERT_EQ(charwidth*4, glyphs[4].m_X);
+    ASSERT_EQ(0, glyphs[5].m_X);
+    ASSERT_EQ(glyphs[0].m_Y, glyphs[4].m_Y);
+    ASSERT_EQ(lineheight, glyphs[0].m_Y - glyphs[5].m_Y);
+
+    // Glyphs are appended
+    dmRender::LayoutText(m_SystemFontMap, params, glyphs);
+    ASSERT_EQ(20U, glyphs.Size());
+
+    // One quad per glyph and layer
+    ASSERT_EQ(6U * 10U, dmRender::GetTextVertexCount(m_SystemFontMap, 10));
+}
+
 TEST_F(dmRenderTest, TextAlignment)
 {
     dmRender::TextMetrics metrics;
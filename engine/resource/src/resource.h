@@ -26,7 +26,7 @@ namespace dmResource
 {
     const static uint32_t MANIFEST_MAGIC_NUMBER = 0x43cb6d06;
 
-    const static uint32_t MANIFEST_VERSION = 0x04;
+    const static uint32_t MANIFEST_VERSION = 0x05;
 
     const uint32_t MANIFEST_PROJ_ID_LEN = 41; // SHA1 + NULL terminator
 
@@ -295,6 +295,44 @@ namespace dmResource
      */
     void DeletePreloader(HPreloader preloader);
 
+    /// Raw loader handle, see #NewRawLoader
+    typedef struct RawLoader* HRawLoader;
+    /// Raw load request handle
+    typedef struct RawLoadRequest* HRawLoadRequest;
+
+    /**
+     * Create a loader for resource data needed after the resource is created, e.g. streamed texture mips.
+     * Files are loaded on a load queue of its own, the same way the preloader loads them, but no resources are created.
+     * @param factory Factory handle
+     * @return Raw loader
+     */
+    HRawLoader NewRawLoader(HFactory factory);
+
+    /**
+     * Delete the raw loader. All requests must have been completed with #EndRawLoad.
+     * @param loader Raw loader
+     */
+    void DeleteRawLoader(HRawLoader loader);
+
+    /**
+     * Begin loading a resource file
+     * @param loader Raw loader
+     * @param name Resource name
+     * @param preload_function Called on the loader thread with the loaded file. Optional, 0 if not used
+     * @param context Context passed to the preload function
+     * @return Request handle, or 0 if the loader is busy and the request should be retried later
+     */
+    HRawLoadRequest BeginRawLoad(HRawLoader loader, const char* name, FResourcePreload preload_function, void* context);
+
+    /**
+     * Complete a load request. Unless pending, the request is freed and the handle is no longer valid.
+     * @param loader Raw loader
+     * @param request Request handle
+     * @param preload_data [out] Data set by the preload function, owned by the caller
+     * @return RESULT_PENDING while still loading, otherwise the load or preload result
+     */
+    Result EndRawLoad(HRawLoader loader, HRawLoadRequest request, void** preload_data);
+
     Manifest* GetManifest(HFactory factory);
 
     /**
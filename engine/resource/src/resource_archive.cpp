@@ -25,12 +25,15 @@
 
 #include "resource.h"
 #include "resource_archive_private.h"
+#include <dlib/atomic.h>
 #include <dlib/crypt.h>
 #include <dlib/dstrings.h>
 #include <dlib/endian.h>
 #include <dlib/endian.h>
+#include <dlib/job_pool.h>
 #include <dlib/log.h>
 #include <dlib/lz4.h>
+#include <dlib/math.h>
 #include <dlib/memory.h>
 #include <dlib/path.h>
 #include <dlib/sys.h>
@@ -44,6 +47,18 @@ namespace dmResourceArchive
     int             g_NumArchiveLoaders = 0;
     ArchiveLoader   g_ArchiveLoader[4];
 
+    struct DecompressJob
+    {
+        const uint8_t*  m_Blocks;
+        const uint32_t* m_Offsets;  // Offset of each block from m_Blocks, with the end of the last block last
+        uint8_t*        m_Buffer;
+        uint32_t        m_BufferLen;
+        uint32_t        m_BlockSize;
+        uint32_t        m_BlockCount;
+        int32_atomic_t  m_NextBlock;
+        int32_atomic_t  m_Error;
+    };
+
     ArchiveIndex::ArchiveIndex()
     {
         memset(this, 0, sizeof(ArchiveIndex));
@@ -131,6 +146,8 @@ namespace dmResourceArchive
             return RESULT_NOT_FOUND;
         }
 
+        dmJobPool::Acquire();
+
         *out_manifest = head_manifest;
         *out_archive = head_archive;
         return RESULT_OK;
@@ -138,6 +155,8 @@ namespace dmResourceArchive
 
     Result UnloadArchives(HArchiveIndexContainer archive)
     {
+        dmJobPool::Release();
+
         while (archive)
         {
             HArchiveIndexContainer next = archive->m_Next;
@@ -419,6 +438,77 @@ namespace dmResourceArchive
         return RESULT_OK;
     }
 
+    // Decodes blocks until all are claimed. Run by the calling thread and the job pool threads.
+    static void DecodeBlocks(void* context)
+    {
+        DecompressJob* job = (DecompressJob*) context;
+        while (true)
+        {
+            uint32_t i = (uint32_t) dmAtomicIncrement32(&job->m_NextBlock);
+            if (i >= job->m_BlockCount)
+                break;
+
+            uint32_t offset = i * job->m_BlockSize;
+            uint32_t size = dmMath::Min(job->m_BlockSize, job->m_BufferLen - offset);
+            const uint8_t* src = job->m_Blocks + job->m_Offsets[i];
+            uint32_t src_size = job->m_Offsets[i+1] - job->m_Offsets[i];
+            dmLZ4::Result r = dmLZ4::DecompressBufferFast(src, src_size, job->m_Buffer + offset, size);
+            if (dmLZ4::RESULT_OK != r)
+            {
+                dmAtomicStore32(&job->m_Error, 1);
+            }
+        }
+    }
+
+    Result DecompressBlocks(const void* compressed_buf, uint32_t compressed_size, void* buffer, uint32_t buffer_len)
+    {
+        assert(compressed_buf != buffer);
+        const uint32_t* header = (const uint32_t*) compressed_buf;
+        if (compressed_size < 2 * sizeof(uint32_t))
+        {
+            return RESULT_IO_ERROR;
+        }
+
+        uint32_t block_size = dmEndian::ToNetwork(header[0]);
+        uint32_t block_count = dmEndian::ToNetwork(header[1]);
+        if (block_size == 0 || block_count != (buffer_len + block_size - 1) / block_size
+            || (compressed_size - 2 * sizeof(uint32_t)) / sizeof(uint32_t) < block_count)
+        {
+            return RESULT_IO_ERROR;
+        }
+
+        uint32_t table_size = (2 + block_count) * sizeof(uint32_t);
+        uint32_t* offsets = (uint32_t*) malloc((block_count + 1) * sizeof(uint32_t));
+        offsets[0] = 0;
+        for (uint32_t i = 0; i < block_count; ++i)
+        {
+            offsets[i+1] = offsets[i] + dmEndian::ToNetwork(header[2 + i]);
+        }
+
+        if (offsets[block_count] != compressed_size - table_size)
+        {
+            free(offsets);
+            return RESULT_IO_ERROR;
+        }
+
+        DecompressJob job;
+        job.m_Blocks = (const uint8_t*) compressed_buf + table_size;
+        job.m_Offsets = offsets;
+        job.m_Buffer = (uint8_t*) buffer;
+        job.m_BufferLen = buffer_len;
+        job.m_BlockSize = block_size;
+        job.m_BlockCount = block_count;
+        job.m_NextBlock = 0;
+        job.m_Error = 0;
+        if (block_count < 2)
+            DecodeBlocks(&job);
+        else
+            dmJobPool::Run(DecodeBlocks, &job);
+
+        free(offsets);
+        return job.m_Error ? RESULT_OUTBUFFER_TOO_SMALL : RESULT_OK;
+    }
+
     Result ReadEntryFromArchive(HArchiveIndexContainer archive, const uint8_t* hash, uint32_t hash_len, const EntryData* entry, void* buffer)
     {
         (void)hash;
@@ -507,7 +597,17 @@ namespace dmResourceArchive
             }
         }
 
-        if (compressed)
+        if (compressed && (entry->m_Flags & ENTRY_FLAG_COMPRESSED_BLOCKS))
+        {
+            Result r = DecompressBlocks(compressed_buf, compressed_size, buffer, size);
+            if (RESULT_OK != r)
+            {
+                if (temp_buffer)
+                    free(compressed_buf);
+                return r;
+            }
+        }
+        else if (compressed)
         {
             assert(compressed_buf != buffer);
             dmLZ4::Result r = dmLZ4::DecompressBufferFast(compressed_buf, compressed_size, buffer, size);
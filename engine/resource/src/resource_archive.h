@@ -32,7 +32,7 @@ namespace dmResourceArchive
      * to check a manifest to ensure that it's compatible with the engine's
      * version of the archive format.
      */
-    const static uint32_t VERSION = 4;
+    const static uint32_t VERSION = 5;
 
     // Maximum hash length convention. This size should large enough.
     // If this length changes the VERSION needs to be bumped.
@@ -44,6 +44,7 @@ namespace dmResourceArchive
         ENTRY_FLAG_ENCRYPTED        = 1 << 0,
         ENTRY_FLAG_COMPRESSED       = 1 << 1,
         ENTRY_FLAG_LIVEUPDATE_DATA  = 1 << 2,
+        ENTRY_FLAG_COMPRESSED_BLOCKS = 1 << 3, // Compressed as independent LZ4 blocks, see DecompressBlocks
     };
 
     // part of the .arci file format
@@ -210,6 +211,19 @@ namespace dmResourceArchive
     // Decompressed a buffer
     Result DecompressBuffer(const void* compressed_buf, uint32_t compressed_size, void* buffer, uint32_t buffer_len);
 
+    /**
+     * Decompress an entry stored as independently compressed LZ4 blocks (ENTRY_FLAG_COMPRESSED_BLOCKS).
+     * The data starts with a block table, all values in network byte order:
+     * uncompressed block size, block count and the compressed size of each block, followed by the blocks.
+     * The blocks are decoded in parallel while the archives are loaded, see LoadArchives.
+     * @param compressed_buf compressed data, including the block table
+     * @param compressed_size compressed size
+     * @param buffer output buffer
+     * @param buffer_len uncompressed size
+     * @return RESULT_OK on success
+     */
+    Result DecompressBlocks(const void* compressed_buf, uint32_t compressed_size, void* buffer, uint32_t buffer_len);
+
     // Reads an entry from a single archive
     Result ReadEntryFromArchive(HArchiveIndexContainer archive, const uint8_t* hash, uint32_t hash_len, const EntryData* entry, void* buffer);
 
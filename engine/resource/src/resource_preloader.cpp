@@ -1049,7 +1049,8 @@ namespace dmResource
 
     bool PreloadHint(HPreloadHintInfo info, const char* name)
     {
-        if (!info || !name)
+        // Raw loads have no preloader to hint
+        if (!info || !info->m_Preloader || !name)
             return false;
 
         HPreloader preloader = info->m_Preloader;
@@ -1074,4 +1075,78 @@ namespace dmResource
 
         return true;
     }
+
+    struct RawLoader
+    {
+        HFactory m_Factory;
+        dmLoadQueue::HQueue m_LoadQueue;
+        uint32_t m_PendingCount;
+    };
+
+    struct RawLoadRequest
+    {
+        dmLoadQueue::HRequest m_LoadRequest;
+        // Must outlive the load queue request
+        char m_Name[RESOURCE_PATH_MAX];
+        char m_CanonicalPath[RESOURCE_PATH_MAX];
+    };
+
+    HRawLoader NewRawLoader(HFactory factory)
+    {
+        RawLoader* loader      = new RawLoader;
+        loader->m_Factory      = factory;
+        loader->m_LoadQueue    = dmLoadQueue::CreateQueue(factory);
+        loader->m_PendingCount = 0;
+        return loader;
+    }
+
+    void DeleteRawLoader(HRawLoader loader)
+    {
+        assert(loader->m_PendingCount == 0);
+        dmLoadQueue::DeleteQueue(loader->m_LoadQueue);
+        delete loader;
+    }
+
+    HRawLoadRequest BeginRawLoad(HRawLoader loader, const char* name, FResourcePreload preload_function, void* context)
+    {
+        RawLoadRequest* request = new RawLoadRequest;
+        dmStrlCpy(request->m_Name, name, sizeof(request->m_Name));
+        GetCanonicalPath(name, request->m_CanonicalPath);
+
+        dmLoadQueue::PreloadInfo info;
+        info.m_HintInfo.m_Preloader = 0;
+        info.m_HintInfo.m_Parent    = -1;
+        info.m_Function             = preload_function;
+        info.m_Context              = context;
+
+        request->m_LoadRequest = dmLoadQueue::BeginLoad(loader->m_LoadQueue, request->m_Name, request->m_CanonicalPath, &info);
+        if (!request->m_LoadRequest)
+        {
+            delete request;
+            return 0;
+        }
+        ++loader->m_PendingCount;
+        return request;
+    }
+
+    Result EndRawLoad(HRawLoader loader, HRawLoadRequest request, void** preload_data)
+    {
+        void* buffer;
+        uint32_t buffer_size;
+        dmLoadQueue::LoadResult load_result;
+        if (dmLoadQueue::EndLoad(loader->m_LoadQueue, request->m_LoadRequest, &buffer, &buffer_size, &load_result) == dmLoadQueue::RESULT_PENDING)
+        {
+            return RESULT_PENDING;
+        }
+        dmLoadQueue::FreeLoad(loader->m_LoadQueue, request->m_LoadRequest);
+        delete request;
+        --loader->m_PendingCount;
+
+        *preload_data = load_result.m_PreloadData;
+        if (load_result.m_LoadResult != RESULT_OK)
+        {
+            return load_result.m_LoadResult;
+        }
+        return load_result.m_PreloadResult;
+    }
 } // namespace dmResource
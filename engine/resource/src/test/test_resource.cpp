@@ -854,6 +854,39 @@ TEST_P(GetResourceTest, PreloadGetAbort)
     }
 }
 
+static dmResource::Result RawLoadPreload(const dmResource::ResourcePreloadParams& params)
+{
+    *params.m_PreloadData = (void*)(uintptr_t) params.m_BufferSize;
+    return dmResource::RESULT_OK;
+}
+
+TEST_P(GetResourceTest, RawLoad)
+{
+    dmResource::HRawLoader loader = dmResource::NewRawLoader(m_Factory);
+
+    dmResource::HRawLoadRequest request = dmResource::BeginRawLoad(loader, "/test01.foo", RawLoadPreload, 0);
+    ASSERT_NE((dmResource::HRawLoadRequest) 0, request);
+    dmResource::HRawLoadRequest missing = dmResource::BeginRawLoad(loader, "/does_not_exist.foo", RawLoadPreload, 0);
+    ASSERT_NE((dmResource::HRawLoadRequest) 0, missing);
+
+    void* preload_data = 0;
+    dmResource::Result r;
+    while ((r = dmResource::EndRawLoad(loader, request, &preload_data)) == dmResource::RESULT_PENDING)
+        dmTime::Sleep(1000);
+    ASSERT_EQ(dmResource::RESULT_OK, r);
+    // NOTE: Not pretty to hard-code the size here
+    ASSERT_EQ(2U, (uint32_t)(uintptr_t) preload_data);
+
+    while ((r = dmResource::EndRawLoad(loader, missing, &preload_data)) == dmResource::RESULT_PENDING)
+        dmTime::Sleep(1000);
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, r);
+
+    // No resources are created
+    ASSERT_EQ(0, m_FooResourceCreateCallCount);
+
+    dmResource::DeleteRawLoader(loader);
+}
+
 
 dmResource::Result RecreateResourceCreate(const dmResource::ResourceCreateParams& params)
 {
@@ -15,6 +15,10 @@
 #include "../resource_archive_private.h"
 #include <dlib/dstrings.h>
 #include <dlib/endian.h>
+#include <dlib/job_pool.h>
+#include <dlib/lz4.h>
+#include <dlib/math.h>
+#include <dlib/time.h>
 
 // TODO: replace with dmEndian
 #if defined(_WIN32)
@@ -841,6 +845,123 @@ TEST(dmResourceArchive, LoadFromDisk_Compressed)
     dmResourceArchive::Delete(archive);
 }
 
+// Texture like test data, compresses about as well as uncompressed image data
+static void FillBlockTestData(uint8_t* data, uint32_t size)
+{
+    uint32_t seed = 17;
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (uint8_t) ((i / 64) & 0xF0) | ((seed >> 16) & 0x03);
+    }
+}
+
+// Same layout as ArchiveBuilder.compressResourceDataBlocks
+static uint8_t* CompressBlocks(const uint8_t* data, uint32_t size, uint32_t block_size, uint32_t* out_size)
+{
+    uint32_t block_count = (size + block_size - 1) / block_size;
+    int max_block_size = 0;
+    dmLZ4::MaxCompressedSize(block_size, &max_block_size);
+    uint32_t table_size = (2 + block_count) * sizeof(uint32_t);
+    uint8_t* out = (uint8_t*) malloc(table_size + block_count * max_block_size);
+
+    uint32_t* table = (uint32_t*) out;
+    table[0] = htonl(block_size);
+    table[1] = htonl(block_count);
+    uint32_t offset = table_size;
+    for (uint32_t i = 0; i < block_count; ++i)
+    {
+        uint32_t n = dmMath::Min(block_size, size - i * block_size);
+        int compressed_size = 0;
+        dmLZ4::CompressBuffer(data + i * block_size, n, out + offset, &compressed_size);
+        table[2 + i] = htonl((uint32_t) compressed_size);
+        offset += compressed_size;
+    }
+    *out_size = offset;
+    return out;
+}
+
+TEST(dmResourceArchive, DecompressBlocks)
+{
+    const uint32_t size = 1000 * 1000;
+    uint8_t* data = (uint8_t*) malloc(size);
+    uint8_t* buffer = (uint8_t*) malloc(size);
+    FillBlockTestData(data, size);
+
+    uint32_t compressed_size = 0;
+    uint8_t* compressed = CompressBlocks(data, size, 64 * 1024, &compressed_size);
+
+    // On the calling thread only
+    memset(buffer, 0, size);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, dmResourceArchive::DecompressBlocks(compressed, compressed_size, buffer, size));
+    ASSERT_EQ(0, memcmp(data, buffer, size));
+
+    // With the workers
+    dmJobPool::Acquire();
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        memset(buffer, 0, size);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, dmResourceArchive::DecompressBlocks(compressed, compressed_size, buffer, size));
+        ASSERT_EQ(0, memcmp(data, buffer, size));
+    }
+    dmJobPool::Release();
+
+    // Block table that doesn't match the sizes
+    ASSERT_EQ(dmResourceArchive::RESULT_IO_ERROR, dmResourceArchive::DecompressBlocks(compressed, compressed_size, buffer, size / 2));
+    ASSERT_EQ(dmResourceArchive::RESULT_IO_ERROR, dmResourceArchive::DecompressBlocks(compressed, compressed_size - 1, buffer, size));
+    ASSERT_EQ(dmResourceArchive::RESULT_IO_ERROR, dmResourceArchive::DecompressBlocks(compressed, 4, buffer, size));
+
+    free(compressed);
+    free(buffer);
+    free(data);
+}
+
+TEST(dmResourceArchive, DecompressBlocksBenchmark)
+{
+    const uint32_t size = 16 * 1024 * 1024;
+    const uint32_t iterations = 8;
+    uint8_t* data = (uint8_t*) malloc(size);
+    uint8_t* buffer = (uint8_t*) malloc(size);
+    FillBlockTestData(data, size);
+
+    int max_size = 0;
+    dmLZ4::MaxCompressedSize(size, &max_size);
+    uint8_t* whole = (uint8_t*) malloc(max_size);
+    int whole_size = 0;
+    dmLZ4::CompressBuffer(data, size, whole, &whole_size);
+
+    uint32_t blocks_size = 0;
+    uint8_t* blocks = CompressBlocks(data, size, 256 * 1024, &blocks_size);
+
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < iterations; ++i)
+        dmLZ4::DecompressBufferFast(whole, whole_size, buffer, size);
+    uint64_t whole_time = dmTime::GetTime() - start;
+
+    start = dmTime::GetTime();
+    for (uint32_t i = 0; i < iterations; ++i)
+        dmResourceArchive::DecompressBlocks(blocks, blocks_size, buffer, size);
+    uint64_t blocks_time = dmTime::GetTime() - start;
+
+    dmJobPool::Acquire();
+    start = dmTime::GetTime();
+    for (uint32_t i = 0; i < iterations; ++i)
+        dmResourceArchive::DecompressBlocks(blocks, blocks_size, buffer, size);
+    uint64_t parallel_time = dmTime::GetTime() - start;
+    dmJobPool::Release();
+    ASSERT_EQ(0, memcmp(data, buffer, size));
+
+    printf("Decompress %u MB\n", size / (1024 * 1024));
+    printf("  single buffer   %8u bytes %8.3f ms\n", (uint32_t) whole_size, whole_time / (1000.0 * iterations));
+    printf("  blocks          %8u bytes %8.3f ms\n", blocks_size, blocks_time / (1000.0 * iterations));
+    printf("  blocks parallel %8u bytes %8.3f ms\n", blocks_size, parallel_time / (1000.0 * iterations));
+
+    free(blocks);
+    free(whole);
+    free(buffer);
+    free(data);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
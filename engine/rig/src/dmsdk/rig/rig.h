@@ -208,18 +208,40 @@ namespace dmRig
         float nz;
     };
 
+    // Row major 3x4 affine matrix, used for the skinning matrix palette.
+    struct SkinMatrix
+    {
+        float m_Rows[3][4];
+    };
+
+    // Input to GenerateVertexDataBatch, one per rig instance.
+    struct GenerateVertexDataParams
+    {
+        Matrix4      m_ModelMatrix;
+        Matrix4      m_NormalMatrix;
+        Vector4      m_Color;
+        HRigInstance m_Instance;
+        // Where the GetVertexCount(m_Instance) vertices of the instance are written
+        void*        m_VertexDataOut;
+    };
+
     struct RigContext
     {
         dmObjectPool<HRigInstance>      m_Instances;
         // Temporary scratch buffers used for store pose as transform and matrices
         // (avoids modifying the real pose transform data during rendering).
         dmArray<dmTransform::Transform> m_ScratchPoseTransformBuffer;
-        dmArray<Matrix4>                m_ScratchInfluenceMatrixBuffer;
         dmArray<Matrix4>                m_ScratchPoseMatrixBuffer;
-        // Temporary scratch buffers used when transforming the vertex buffer,
+        // Temporary scratch buffers for the skinning matrix palettes, indexed by mesh influence.
+        dmArray<SkinMatrix>             m_ScratchPaletteBuffer;
+        dmArray<SkinMatrix>             m_ScratchNormalPaletteBuffer;
+        // Temporary scratch buffer used when transforming the vertex buffer,
         // used to creating primitives from indices.
-        dmArray<Vector3>                m_ScratchPositionBuffer;
-        dmArray<Vector3>                m_ScratchNormalBuffer;
+        dmArray<float>                  m_ScratchPositionBuffer;
+        // Meshes and tasks of the current GenerateVertexDataBatch call
+        struct SkinScratch*             m_SkinScratch;
+        // Poses shared between the instances in the current frame, 0 unless NewContextParams::m_PoseCache is set
+        struct PoseCache*               m_PoseCache;
         // Temporary scratch buffers to handle draw order changes.
         dmArray<int32_t>                m_ScratchDrawOrderDeltas;
         dmArray<int32_t>                m_ScratchDrawOrderUnchanged;
@@ -228,6 +250,9 @@ namespace dmRig
     struct NewContextParams {
         HRigContext* m_Context;
         uint32_t     m_MaxRigInstanceCount;
+        // Instances that play the same animation at the same cursor, without blending or IK targets,
+        // share the pose and the skinned vertices within a frame.
+        bool         m_PoseCache;
     };
 
     typedef void (*RigEventCallback)(RigEventType, void*, void*, void*);
@@ -269,6 +294,8 @@ namespace dmRig
         RigMeshType                   m_MeshType;
         // Max bone count used by skeleton (if it is used) and meshset
         uint32_t                      m_MaxBoneCount;
+        // Entry in the pose cache of the context for the current frame, if the pose is shared
+        uint32_t                      m_PoseCacheEntry;
         /// Current player index
         uint8_t                       m_CurrentPlayer : 1;
         /// Whether we are currently X-fading or not
@@ -323,6 +350,9 @@ namespace dmRig
 
     void* GenerateVertexData(HRigContext context, HRigInstance instance, const Matrix4& model_matrix, const Matrix4& normal_matrix, const Vector4 color, RigVertexFormat vertex_format, void* vertex_data_out);
     uint32_t GetVertexCount(HRigInstance instance);
+    // Generates the vertex data of several instances at once, each written to its own m_VertexDataOut.
+    // Large batches are skinned on worker threads.
+    void GenerateVertexDataBatch(HRigContext context, RigVertexFormat vertex_format, const GenerateVertexDataParams* params, uint32_t count);
 
     Result SetMesh(HRigInstance instance, dmhash_t mesh_id);
     dmhash_t GetMesh(HRigInstance instance);
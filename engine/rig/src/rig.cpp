@@ -12,12 +12,24 @@
 
 #include "rig.h"
 
+#include <string.h>
+#include <dlib/atomic.h>
+#include <dlib/hashtable.h>
+#include <dlib/job_pool.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
 #include <dlib/vmath.h>
 #include <dlib/profile.h>
 #include <graphics/graphics.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DM_RIG_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define DM_RIG_NEON
+#endif
+
 namespace dmRig
 {
 
@@ -29,6 +41,151 @@ namespace dmRig
 
     static const float white[] = {1.0f, 1.0f, 1.0, 1.0f};
 
+    // Positions or vertices per task
+    static const uint32_t SKIN_TASK_SIZE = 2048;
+    // Less work than this is done on the calling thread alone
+    static const uint32_t SKIN_PARALLEL_MIN_BONES = 1024;
+    static const uint32_t SKIN_PARALLEL_MIN_VERTICES = 8192;
+    static const uint32_t INVALID_PALETTE_OFFSET = 0xffffffffu;
+    static const uint32_t INVALID_SHARED_MESH = 0xffffffffu;
+    static const uint32_t INVALID_POSE_CACHE_ENTRY = 0xffffffffu;
+    // Cursors are quantized to this many steps per animation sample when looking up shared poses
+    static const float POSE_CACHE_SAMPLE_STEPS = 4.0f;
+    // Packed rotations of compressed tracks, see AnimationTrack in rig_ddf.proto
+    static const uint32_t PACKED_QUAT_COMPONENT_BITS = 20;
+    static const uint64_t PACKED_QUAT_COMPONENT_MASK = (1 << PACKED_QUAT_COMPONENT_BITS) - 1;
+    static const float PACKED_QUAT_RANGE = 0.70710678f;
+
+    struct SkinInstance
+    {
+        SkinMatrix                      m_Model;
+        SkinMatrix                      m_Normal;
+        const GenerateVertexDataParams* m_Params;
+        uint32_t                        m_PoseOffset;
+        // Offset into the palette buffers, INVALID_PALETTE_OFFSET for instances without influences
+        uint32_t                        m_PaletteOffset;
+        // The instance computes the palette, instances sharing a pose use the palette of the first one
+        uint8_t                         m_ComputePalette : 1;
+        // The palette is in model space and the skinned vertices are shared, see SharedSkinMesh
+        uint8_t                         m_ModelSpacePalette : 1;
+    };
+
+    struct SkinMesh
+    {
+        Vector4         m_Color;
+        const Mesh*     m_Mesh;
+        void*           m_VertexDataOut;
+        uint32_t        m_Instance;
+        // Offset of the first position in m_ScratchPositionBuffer, in positions
+        uint32_t        m_PositionOffset;
+        // Model space vertices shared with other instances, or INVALID_SHARED_MESH
+        uint32_t        m_SharedMesh;
+    };
+
+    // A mesh skinned once in model space for all instances sharing a pose
+    struct SharedSkinMesh
+    {
+        const Mesh*     m_Mesh;
+        // Instance with the palette
+        uint32_t        m_Instance;
+        // Offsets of the positions and the per index normals in m_ScratchPositionBuffer, in vectors
+        uint32_t        m_PositionOffset;
+        uint32_t        m_NormalOffset;
+    };
+
+    struct SharedSkinMeshKey
+    {
+        const Mesh*     m_Mesh;
+        uint32_t        m_PoseCacheEntry;
+    };
+
+    struct SkinTask
+    {
+        uint32_t m_Item;
+        uint32_t m_Begin;
+        uint32_t m_End;
+    };
+
+    struct SkinScratch
+    {
+        dmArray<SkinInstance>   m_Instances;
+        dmArray<SkinMesh>       m_Meshes;
+        dmArray<SharedSkinMesh> m_SharedMeshes;
+        dmArray<SkinTask>       m_Tasks;
+        // Pose cache entry to the instance computing the palette
+        dmHashTable32<uint32_t> m_SharedPalettes;
+        // Pose cache entry and mesh to the shared mesh
+        dmHashTable64<uint32_t> m_SharedMeshTable;
+    };
+
+    struct PoseCacheKey
+    {
+        const dmRigDDF::Skeleton*     m_Skeleton;
+        const dmArray<RigBone>*       m_BindPose;
+        const dmArray<uint32_t>*      m_TrackIdxToPose;
+        const dmArray<uint32_t>*      m_PoseIdxToInfluence;
+        const dmRigDDF::RigAnimation* m_Animation;
+        // Quantized animation time
+        uint32_t                      m_Step;
+    };
+
+    struct PoseCacheEntry
+    {
+        PoseCacheKey m_Key;
+        uint32_t     m_PoseOffset;
+        // Instances using the pose this frame
+        uint32_t     m_InstanceCount;
+    };
+
+    struct PoseCache
+    {
+        dmHashTable64<uint32_t>         m_EntryTable;
+        dmArray<PoseCacheEntry>         m_Entries;
+        dmArray<dmTransform::Transform> m_Poses;
+        uint32_t                        m_Hits;
+    };
+
+    struct SkinJob;
+    typedef void (*SkinTaskFunction)(const SkinJob* job, const SkinTask& task);
+
+    struct SkinJob
+    {
+        RigContext*      m_Context;
+        SkinTaskFunction m_Function;
+        const SkinTask*  m_Tasks;
+        uint32_t         m_TaskCount;
+        RigVertexFormat  m_VertexFormat;
+        int32_atomic_t   m_NextTask;
+    };
+
+    template <typename T>
+    static void EnsureSize(dmArray<T>& array, uint32_t size)
+    {
+        if (array.Capacity() < size) {
+            array.OffsetCapacity(size - array.Capacity());
+        }
+        array.SetSize(size);
+    }
+
+    template <typename T>
+    static void PushScratch(dmArray<T>& array, const T& value)
+    {
+        if (array.Full()) {
+            array.OffsetCapacity(dmMath::Max(16U, array.Capacity()));
+        }
+        array.Push(value);
+    }
+
+    template <typename KEY, typename T>
+    static void PutScratch(dmHashTable<KEY, T>& table, KEY key, const T& value)
+    {
+        if (table.Full()) {
+            uint32_t capacity = table.Capacity() + dmMath::Max(32U, table.Capacity());
+            table.SetCapacity(capacity / 2 + 1, capacity);
+        }
+        table.Put(key, value);
+    }
+
     static void DoAnimate(HRigContext context, RigInstance* instance, float dt);
     static bool DoPostUpdate(RigInstance* instance);
     static void UpdateSlotDrawOrder(dmArray<int32_t>& draw_order, dmArray<int32_t>& deltas, int changed, dmArray<int32_t>& unchanged);
@@ -44,6 +201,9 @@ namespace dmRig
         context->m_Instances.SetCapacity(params.m_MaxRigInstanceCount);
         context->m_ScratchPoseTransformBuffer.SetCapacity(0);
         context->m_ScratchPoseMatrixBuffer.SetCapacity(0);
+        context->m_SkinScratch = new SkinScratch;
+        context->m_PoseCache = params.m_PoseCache ? new PoseCache() : 0;
+        dmJobPool::Acquire();
 
         return dmRig::RESULT_OK;
     }
@@ -51,6 +211,9 @@ namespace dmRig
     void DeleteContext(HRigContext context)
     {
         if (context) {
+            dmJobPool::Release();
+            delete context->m_SkinScratch;
+            delete context->m_PoseCache;
             delete context;
         }
     }
@@ -438,6 +601,72 @@ namespace dmRig
         return slerp(frac, Quat(data[i+0], data[i+1], data[i+2], data[i+3]), Quat(data[i+0+4], data[i+1+4], data[i+2+4], data[i+3+4]));
     }
 
+    // Decodes a rotation quantized with the smallest three encoding, see AnimationTrack in rig_ddf.proto
+    static inline Quat UnpackQuat(uint64_t packed)
+    {
+        const float scale = 2.0f * PACKED_QUAT_RANGE / (float)PACKED_QUAT_COMPONENT_MASK;
+        float a = (float)((packed >> 2) & PACKED_QUAT_COMPONENT_MASK) * scale - PACKED_QUAT_RANGE;
+        float b = (float)((packed >> (2 + PACKED_QUAT_COMPONENT_BITS)) & PACKED_QUAT_COMPONENT_MASK) * scale - PACKED_QUAT_RANGE;
+        float c = (float)((packed >> (2 + 2 * PACKED_QUAT_COMPONENT_BITS)) & PACKED_QUAT_COMPONENT_MASK) * scale - PACKED_QUAT_RANGE;
+        float largest = sqrtf(dmMath::Max(0.0f, 1.0f - a * a - b * b - c * c));
+        switch (packed & 3)
+        {
+            case 0:  return Quat(largest, a, b, c);
+            case 1:  return Quat(a, largest, b, c);
+            case 2:  return Quat(a, b, largest, c);
+            default: return Quat(a, b, c, largest);
+        }
+    }
+
+    // Maps a sample and fraction to the keys of a reduced property and the fraction between them.
+    // The first key is the first sample and the last key is the last sample, later samples are clamped to it.
+    // Keys are roughly evenly spread, so the search starts at the proportional position and is usually done in a step or two.
+    static inline void FindKey(const uint32_t* keys, uint32_t key_count, uint32_t* sample, float* frac)
+    {
+        uint32_t s = *sample;
+        uint32_t last = key_count - 1;
+        if (s >= keys[last]) {
+            *sample = last - 1;
+            *frac = 1.0f;
+            return;
+        }
+        uint32_t k = (uint32_t)((float)s * (float)last / (float)keys[last]);
+        while (keys[k] > s)
+            --k;
+        while (keys[k + 1] <= s)
+            ++k;
+        *sample = k;
+        *frac = ((float)(s - keys[k]) + *frac) / (float)(keys[k + 1] - keys[k]);
+    }
+
+    static Vector3 SampleTrackVec3(const float* data, uint32_t count, const uint32_t* keys, uint32_t key_count, uint32_t sample, float frac)
+    {
+        if (count == 3)
+            return Vector3(data[0], data[1], data[2]);
+        if (key_count)
+            FindKey(keys, key_count, &sample, &frac);
+        return SampleVec3(sample, frac, (float*)data);
+    }
+
+    static Quat SampleTrackRotation(const dmRigDDF::AnimationTrack* track, uint32_t sample, float frac)
+    {
+        const uint64_t* packed = track->m_PackedRotations.m_Data;
+        uint32_t count = track->m_PackedRotations.m_Count;
+        if (count == 0) {
+            if (track->m_Rotations.m_Count == 4)
+                return Quat(track->m_Rotations[0], track->m_Rotations[1], track->m_Rotations[2], track->m_Rotations[3]);
+            if (track->m_RotationKeys.m_Count)
+                FindKey(track->m_RotationKeys.m_Data, track->m_RotationKeys.m_Count, &sample, &frac);
+            return SampleQuat(sample, frac, track->m_Rotations.m_Data);
+        }
+
+        if (count == 1)
+            return UnpackQuat(packed[0]);
+        if (track->m_RotationKeys.m_Count)
+            FindKey(track->m_RotationKeys.m_Data, track->m_RotationKeys.m_Count, &sample, &frac);
+        return slerp(frac, UnpackQuat(packed[sample]), UnpackQuat(packed[sample + 1]));
+    }
+
     static float CursorToTime(float cursor, float duration, bool backwards, bool once_pingpong)
     {
         float t = cursor;
@@ -514,7 +743,7 @@ namespace dmRig
         child_t.SetRotation( dmVMath::QuatFromAngle(2, childRotation) );
     }
 
-    static void ApplyAnimation(RigPlayer* player, dmArray<dmTransform::Transform>& pose, const dmArray<uint32_t>& track_idx_to_pose, dmArray<IKAnimation>& ik_animation, dmArray<MeshSlotPose>& mesh_slot_pose, bool update_draw_order, dmArray<int32_t>& draw_order, int& slot_changed, float blend_weight)
+    static void ApplyAnimation(RigPlayer* player, dmArray<dmTransform::Transform>& pose, const dmArray<uint32_t>& track_idx_to_pose, dmArray<IKAnimation>& ik_animation, dmArray<MeshSlotPose>& mesh_slot_pose, bool update_draw_order, dmArray<int32_t>& draw_order, int& slot_changed, float blend_weight, bool apply_pose)
     {
         const dmRigDDF::RigAnimation* animation = player->m_Animation;
         if (animation == 0x0)
@@ -526,8 +755,8 @@ namespace dmRig
         uint32_t sample = (uint32_t)fraction;
         uint32_t rounded_sample = (uint32_t)(fraction + 0.5f);
         fraction -= sample;
-        // Sample animation tracks
-        uint32_t track_count = animation->m_Tracks.m_Count;
+        // Sample animation tracks, unless the pose comes from the pose cache
+        uint32_t track_count = apply_pose ? animation->m_Tracks.m_Count : 0;
         for (uint32_t ti = 0; ti < track_count; ++ti)
         {
             const dmRigDDF::AnimationTrack* track = &animation->m_Tracks[ti];
@@ -539,19 +768,21 @@ namespace dmRig
             dmTransform::Transform& transform = pose[pose_index];
             if (track->m_Positions.m_Count > 0)
             {
-                transform.SetTranslation(lerp(blend_weight, transform.GetTranslation(), SampleVec3(sample, fraction, track->m_Positions.m_Data)));
+                Vector3 position = SampleTrackVec3(track->m_Positions.m_Data, track->m_Positions.m_Count, track->m_PositionKeys.m_Data, track->m_PositionKeys.m_Count, sample, fraction);
+                transform.SetTranslation(lerp(blend_weight, transform.GetTranslation(), position));
             }
-            if (track->m_Rotations.m_Count > 0)
+            if (track->m_Rotations.m_Count > 0 || track->m_PackedRotations.m_Count > 0)
             {
-                transform.SetRotation(slerp(blend_weight, transform.GetRotation(), SampleQuat(sample, fraction, track->m_Rotations.m_Data)));
+                transform.SetRotation(slerp(blend_weight, transform.GetRotation(), SampleTrackRotation(track, sample, fraction)));
             }
             if (track->m_Scale.m_Count > 0)
             {
-                transform.SetScale(lerp(blend_weight, transform.GetScale(), SampleVec3(sample, fraction, track->m_Scale.m_Data)));
+                Vector3 scale = SampleTrackVec3(track->m_Scale.m_Data, track->m_Scale.m_Count, track->m_ScaleKeys.m_Data, track->m_ScaleKeys.m_Count, sample, fraction);
+                transform.SetScale(lerp(blend_weight, transform.GetScale(), scale));
             }
         }
 
-        track_count = animation->m_IkTracks.m_Count;
+        track_count = apply_pose ? animation->m_IkTracks.m_Count : 0;
         for (uint32_t ti = 0; ti < track_count; ++ti)
         {
             const dmRigDDF::IKAnimationTrack* track = &animation->m_IkTracks[ti];
@@ -601,10 +832,76 @@ namespace dmRig
         }
     }
 
+    static bool CanSharePose(RigInstance* instance)
+    {
+        if (instance->m_Blending) {
+            return false;
+        }
+        const dmArray<IKTarget>& ik_targets = instance->m_IKTargets;
+        for (uint32_t i = 0; i < ik_targets.Size(); ++i)
+        {
+            if (ik_targets[i].m_Mix != 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Finds the entry of the pose the instance will have after the player has been applied.
+    // If no other instance has computed it this frame, a new entry is added for the instance to fill in.
+    static uint32_t GetPoseCacheEntry(PoseCache* cache, RigInstance* instance, RigPlayer* player, bool* hit)
+    {
+        PoseCacheKey key;
+        memset(&key, 0, sizeof(key));
+        key.m_Skeleton = instance->m_Skeleton;
+        key.m_BindPose = instance->m_BindPose;
+        key.m_TrackIdxToPose = instance->m_TrackIdxToPose;
+        key.m_PoseIdxToInfluence = instance->m_PoseIdxToInfluence;
+        key.m_Animation = player->m_Animation;
+        if (player->m_Animation) {
+            float duration = GetCursorDuration(player, player->m_Animation);
+            float t = CursorToTime(player->m_Cursor, duration, player->m_Backwards, player->m_Playback == dmRig::PLAYBACK_ONCE_PINGPONG);
+            key.m_Step = (uint32_t)(t * player->m_Animation->m_SampleRate * POSE_CACHE_SAMPLE_STEPS + 0.5f);
+        }
+
+        dmhash_t hash = dmHashBuffer64(&key, sizeof(key));
+        uint32_t* entry_index = cache->m_EntryTable.Get(hash);
+        if (entry_index) {
+            PoseCacheEntry& entry = cache->m_Entries[*entry_index];
+            if (memcmp(&entry.m_Key, &key, sizeof(key)) != 0) {
+                *hit = false;
+                return INVALID_POSE_CACHE_ENTRY;
+            }
+            entry.m_InstanceCount++;
+            cache->m_Hits++;
+            *hit = true;
+            return *entry_index;
+        }
+
+        PoseCacheEntry entry;
+        entry.m_Key = key;
+        entry.m_PoseOffset = cache->m_Poses.Size();
+        entry.m_InstanceCount = 1;
+        EnsureSize(cache->m_Poses, entry.m_PoseOffset + instance->m_Pose.Size());
+        uint32_t index = cache->m_Entries.Size();
+        PushScratch(cache->m_Entries, entry);
+        PutScratch(cache->m_EntryTable, hash, index);
+        *hit = false;
+        return index;
+    }
+
     static void Animate(HRigContext context, float dt)
     {
         DM_PROFILE(Rig, "Animate");
 
+        PoseCache* pose_cache = context->m_PoseCache;
+        if (pose_cache) {
+            pose_cache->m_EntryTable.Clear();
+            pose_cache->m_Entries.SetSize(0);
+            pose_cache->m_Poses.SetSize(0);
+            pose_cache->m_Hits = 0;
+        }
+
         const dmArray<RigInstance*>& instances = context->m_Instances.m_Objects;
         uint32_t n = instances.Size();
         for (uint32_t i = 0; i < n; ++i)
@@ -612,10 +909,16 @@ namespace dmRig
             RigInstance* instance = instances[i];
             DoAnimate(context, instance, dt);
         }
+
+        if (pose_cache) {
+            DM_COUNTER("Rig.PoseCacheHits", pose_cache->m_Hits);
+        }
     }
 
     static void DoAnimate(HRigContext context, RigInstance* instance, float dt)
     {
+            instance->m_PoseCacheEntry = INVALID_POSE_CACHE_ENTRY;
+
             // NOTE we previously checked for (!instance->m_Enabled || !instance->m_AddedToUpdate) here also
             if (instance->m_Pose.Empty() || !instance->m_Enabled)
                 return;
@@ -664,6 +967,7 @@ namespace dmRig
                 context->m_ScratchDrawOrderDeltas[i] = SIGNAL_DELTA_UNCHANGED;
             }
 
+            bool cached_pose = false;
             if (instance->m_Blending)
             {
                 float fade_rate = instance->m_BlendTimer / instance->m_BlendDuration;
@@ -688,7 +992,7 @@ namespace dmRig
 
                     UpdatePlayer(instance, p, dt, blend_weight);
                     bool draw_order = player == p ? fade_rate >= 0.5f : fade_rate < 0.5f;
-                    ApplyAnimation(p, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, draw_order, context->m_ScratchDrawOrderDeltas, slot_changed, alpha);
+                    ApplyAnimation(p, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, draw_order, context->m_ScratchDrawOrderDeltas, slot_changed, alpha, true);
                     if (player == p)
                     {
                         alpha = 1.0f - fade_rate;
@@ -702,7 +1006,11 @@ namespace dmRig
             else
             {
                 UpdatePlayer(instance, player, dt, 1.0f);
-                ApplyAnimation(player, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, true, context->m_ScratchDrawOrderDeltas, slot_changed, 1.0f);
+                if (context->m_PoseCache && CanSharePose(instance)) {
+                    instance->m_PoseCacheEntry = GetPoseCacheEntry(context->m_PoseCache, instance, player, &cached_pose);
+                }
+                // The mesh tracks are still applied when the pose is cached, the slot state is per instance
+                ApplyAnimation(player, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, true, context->m_ScratchDrawOrderDeltas, slot_changed, 1.0f, !cached_pose);
             }
 
             // Update draw order after animation
@@ -710,6 +1018,12 @@ namespace dmRig
                 UpdateSlotDrawOrder(instance->m_DrawOrder, context->m_ScratchDrawOrderDeltas, slot_changed, context->m_ScratchDrawOrderUnchanged);
             }
 
+            if (cached_pose) {
+                const PoseCacheEntry& entry = context->m_PoseCache->m_Entries[instance->m_PoseCacheEntry];
+                memcpy(pose.Begin(), &context->m_PoseCache->m_Poses[entry.m_PoseOffset], bone_count * sizeof(dmTransform::Transform));
+                return;
+            }
+
             for (uint32_t bi = 0; bi < bone_count; ++bi)
             {
                 dmTransform::Transform& t = pose[bi];
@@ -779,6 +1093,11 @@ namespace dmRig
                         ApplyTwoBoneIKConstraint(ik, bind_pose, pose, target_position, parent_position, ik_animation[i].m_Positive, ik_animation[i].m_Mix);
                 }
             }
+
+            if (instance->m_PoseCacheEntry != INVALID_POSE_CACHE_ENTRY) {
+                const PoseCacheEntry& entry = context->m_PoseCache->m_Entries[instance->m_PoseCacheEntry];
+                memcpy(&context->m_PoseCache->m_Poses[entry.m_PoseOffset], pose.Begin(), bone_count * sizeof(dmTransform::Transform));
+            }
     }
 
     static Result PostUpdate(HRigContext context)
@@ -1042,143 +1361,149 @@ namespace dmRig
         return vertex_count;
     }
 
-    static float* GenerateNormalData(const dmRigDDF::Mesh* mesh, const Matrix4& normal_matrix, const dmArray<Matrix4>& pose_matrices, float* out_buffer)
-    {
-        const float* normals_in = mesh->m_Normals.m_Data;
-        const uint32_t* normal_indices = mesh->m_NormalsIndices.m_Data;
-        uint32_t index_count = mesh->m_PositionIndices.m_Count;
-        Vector4 v;
+    // Skinning
+    //
+    // Each pose matrix is premultiplied with the bind pose inverse and the linear part of the model matrix into a
+    // 3x4 palette entry per mesh influence. A vertex then only needs the weighted sum of (at most) four palette rows,
+    // one matrix-vector product and the model translation. The work is split in three passes, the poses per instance,
+    // the positions per mesh and the vertices per mesh, each cut into tasks that are shared with worker threads
+    // when the batch is large enough.
 
-        if (!mesh->m_BoneIndices.m_Count || pose_matrices.Size() == 0)
-        {
-            for (uint32_t ii = 0; ii < index_count; ++ii)
-            {
-                uint32_t ni = normal_indices[ii];
-                Vector3 normal_in(normals_in[ni*3+0], normals_in[ni*3+1], normals_in[ni*3+2]);
-                v = normal_matrix * normal_in;
-                if (lengthSqr(v) > 0.0f) {
-                    normalize(v);
-                }
-                *out_buffer++ = v[0];
-                *out_buffer++ = v[1];
-                *out_buffer++ = v[2];
-            }
-            return out_buffer;
-        }
+#if defined(DM_RIG_SSE2)
 
-        const uint32_t* indices = mesh->m_BoneIndices.m_Data;
-        const float* weights = mesh->m_Weights.m_Data;
-        const uint32_t* vertex_indices = mesh->m_PositionIndices.m_Data;
-        for (uint32_t ii = 0; ii < index_count; ++ii)
+    // out = (weighted sum of the palette matrices of the vertex) * (in, w)
+    // The weights are sorted, the first zero weight ends the influences of the vertex.
+    static inline void SkinVertex(const SkinMatrix* palette, const uint32_t* bone_indices, const float* bone_weights, const float* in, float w, float* out)
+    {
+        __m128 r0 = _mm_setzero_ps();
+        __m128 r1 = r0;
+        __m128 r2 = r0;
+        for (uint32_t i = 0; i < 4 && bone_weights[i]; ++i)
         {
-            const uint32_t ni = normal_indices[ii]*3;
-            const Vector3 normal_in(normals_in[ni+0], normals_in[ni+1], normals_in[ni+2]);
-            Vector4 normal_out(0.0f, 0.0f, 0.0f, 0.0f);
-
-            const uint32_t bi_offset = vertex_indices[ii] << 2;
-            const uint32_t* bone_indices = &indices[bi_offset];
-            const float* bone_weights = &weights[bi_offset];
+            const SkinMatrix& m = palette[bone_indices[i]];
+            __m128 weight = _mm_set1_ps(bone_weights[i]);
+            r0 = _mm_add_ps(r0, _mm_mul_ps(_mm_loadu_ps(m.m_Rows[0]), weight));
+            r1 = _mm_add_ps(r1, _mm_mul_ps(_mm_loadu_ps(m.m_Rows[1]), weight));
+            r2 = _mm_add_ps(r2, _mm_mul_ps(_mm_loadu_ps(m.m_Rows[2]), weight));
+        }
+
+        __m128 v = _mm_set_ps(w, in[2], in[1], in[0]);
+        __m128 x = _mm_mul_ps(r0, v);
+        __m128 y = _mm_mul_ps(r1, v);
+        __m128 z = _mm_mul_ps(r2, v);
+        __m128 t = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(x, y, z, t);
+        __m128 sum = _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, t));
+        _mm_storel_pi((__m64*) out, sum);
+        _mm_store_ss(out + 2, _mm_movehl_ps(sum, sum));
+    }
+
+    // out = m * (in, w)
+    static inline void TransformVertex(const SkinMatrix& m, const float* in, float w, float* out)
+    {
+        __m128 v = _mm_set_ps(w, in[2], in[1], in[0]);
+        __m128 x = _mm_mul_ps(_mm_loadu_ps(m.m_Rows[0]), v);
+        __m128 y = _mm_mul_ps(_mm_loadu_ps(m.m_Rows[1]), v);
+        __m128 z = _mm_mul_ps(_mm_loadu_ps(m.m_Rows[2]), v);
+        __m128 t = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(x, y, z, t);
+        __m128 sum = _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, t));
+        _mm_storel_pi((__m64*) out, sum);
+        _mm_store_ss(out + 2, _mm_movehl_ps(sum, sum));
+    }
 
-            if (bone_weights[0])
-            {
-                normal_out += (pose_matrices[bone_indices[0]] * normal_in) * bone_weights[0];
-                if (bone_weights[1])
-                {
-                    normal_out += (pose_matrices[bone_indices[1]] * normal_in) * bone_weights[1];
-                    if (bone_weights[2])
-                    {
-                        normal_out += (pose_matrices[bone_indices[2]] * normal_in) * bone_weights[2];
-                        if (bone_weights[3])
-                        {
-                            normal_out += (pose_matrices[bone_indices[3]] * normal_in) * bone_weights[3];
-                        }
-                    }
-                }
-            }
+#elif defined(DM_RIG_NEON)
 
-            v = normal_matrix * Vector3(normal_out.getX(), normal_out.getY(), normal_out.getZ());
-            if (lengthSqr(v) > 0.0f) {
-                normalize(v);
-            }
-            *out_buffer++ = v[0];
-            *out_buffer++ = v[1];
-            *out_buffer++ = v[2];
+    static inline void DotRows(float32x4_t r0, float32x4_t r1, float32x4_t r2, const float* in, float w, float* out)
+    {
+        const float v_data[4] = {in[0], in[1], in[2], w};
+        float32x4_t v = vld1q_f32(v_data);
+        float32x4_t x = vmulq_f32(r0, v);
+        float32x4_t y = vmulq_f32(r1, v);
+        float32x4_t z = vmulq_f32(r2, v);
+        float32x2_t xy = vpadd_f32(vpadd_f32(vget_low_f32(x), vget_high_f32(x)), vpadd_f32(vget_low_f32(y), vget_high_f32(y)));
+        float32x2_t zz = vpadd_f32(vget_low_f32(z), vget_high_f32(z));
+        vst1_f32(out, xy);
+        out[2] = vget_lane_f32(vpadd_f32(zz, zz), 0);
+    }
+
+    // out = (weighted sum of the palette matrices of the vertex) * (in, w)
+    // The weights are sorted, the first zero weight ends the influences of the vertex.
+    static inline void SkinVertex(const SkinMatrix* palette, const uint32_t* bone_indices, const float* bone_weights, const float* in, float w, float* out)
+    {
+        float32x4_t r0 = vdupq_n_f32(0.0f);
+        float32x4_t r1 = r0;
+        float32x4_t r2 = r0;
+        for (uint32_t i = 0; i < 4 && bone_weights[i]; ++i)
+        {
+            const SkinMatrix& m = palette[bone_indices[i]];
+            float weight = bone_weights[i];
+            r0 = vmlaq_n_f32(r0, vld1q_f32(m.m_Rows[0]), weight);
+            r1 = vmlaq_n_f32(r1, vld1q_f32(m.m_Rows[1]), weight);
+            r2 = vmlaq_n_f32(r2, vld1q_f32(m.m_Rows[2]), weight);
         }
+        DotRows(r0, r1, r2, in, w, out);
+    }
 
-        return out_buffer;
+    // out = m * (in, w)
+    static inline void TransformVertex(const SkinMatrix& m, const float* in, float w, float* out)
+    {
+        DotRows(vld1q_f32(m.m_Rows[0]), vld1q_f32(m.m_Rows[1]), vld1q_f32(m.m_Rows[2]), in, w, out);
     }
 
-    static float* GeneratePositionData(const dmRigDDF::Mesh* mesh, const Matrix4& model_matrix, const dmArray<Matrix4>& pose_matrices, float* out_buffer)
+#else
+
+    // out = m * (in, w)
+    static inline void TransformVertex(const SkinMatrix& m, const float* in, float w, float* out)
     {
-        const float *positions = mesh->m_Positions.m_Data;
-        const size_t vertex_count = mesh->m_Positions.m_Count / 3;
-        Point3 in_p;
-        Vector4 v;
-        if(!mesh->m_BoneIndices.m_Count || pose_matrices.Size() == 0)
+        for (uint32_t r = 0; r < 3; ++r)
         {
-            for (uint32_t i = 0; i < vertex_count; ++i)
-            {
-                in_p[0] = *positions++;
-                in_p[1] = *positions++;
-                in_p[2] = *positions++;
-                v = model_matrix * in_p;
-                *out_buffer++ = v[0];
-                *out_buffer++ = v[1];
-                *out_buffer++ = v[2];
-            }
-            return out_buffer;
+            const float* row = m.m_Rows[r];
+            out[r] = row[0] * in[0] + row[1] * in[1] + row[2] * in[2] + row[3] * w;
         }
+    }
 
-        const uint32_t* indices = mesh->m_BoneIndices.m_Data;
-        const float* weights = mesh->m_Weights.m_Data;
-        for (uint32_t i = 0; i < vertex_count; ++i)
+    // out = (weighted sum of the palette matrices of the vertex) * (in, w)
+    // The weights are sorted, the first zero weight ends the influences of the vertex.
+    static inline void SkinVertex(const SkinMatrix* palette, const uint32_t* bone_indices, const float* bone_weights, const float* in, float w, float* out)
+    {
+        SkinMatrix blend;
+        memset(&blend, 0, sizeof(blend));
+        for (uint32_t i = 0; i < 4 && bone_weights[i]; ++i)
         {
-            Vector4 in_v;
-            in_v.setX(*positions++);
-            in_v.setY(*positions++);
-            in_v.setZ(*positions++);
-            in_v.setW(1.0f);
-
-            Vector4 out_p(0.0f, 0.0f, 0.0f, 0.0f);
-            const uint32_t bi_offset = i << 2;
-            const uint32_t* bone_indices = &indices[bi_offset];
-            const float* bone_weights = &weights[bi_offset];
-
-            if(bone_weights[0])
+            const float* m = palette[bone_indices[i]].m_Rows[0];
+            float* b = blend.m_Rows[0];
+            float weight = bone_weights[i];
+            for (uint32_t e = 0; e < 12; ++e)
             {
-                out_p += pose_matrices[bone_indices[0]] * in_v * bone_weights[0];
-                if(bone_weights[1])
-                {
-                    out_p += pose_matrices[bone_indices[1]] * in_v * bone_weights[1];
-                    if(bone_weights[2])
-                    {
-                        out_p += pose_matrices[bone_indices[2]] * in_v * bone_weights[2];
-                        if(bone_weights[3])
-                        {
-                            out_p += pose_matrices[bone_indices[3]] * in_v * bone_weights[3];
-                        }
-                    }
-                }
+                b[e] += m[e] * weight;
             }
+        }
+        TransformVertex(blend, in, w, out);
+    }
+
+#endif
 
-            v = model_matrix * Point3(out_p.getX(), out_p.getY(), out_p.getZ());
-            *out_buffer++ = v[0];
-            *out_buffer++ = v[1];
-            *out_buffer++ = v[2];
+    static void ToSkinMatrix(const Matrix4& m, SkinMatrix& out)
+    {
+        for (uint32_t r = 0; r < 3; ++r)
+        {
+            out.m_Rows[r][0] = m.getElem(0, r);
+            out.m_Rows[r][1] = m.getElem(1, r);
+            out.m_Rows[r][2] = m.getElem(2, r);
+            out.m_Rows[r][3] = m.getElem(3, r);
         }
-        return out_buffer;
     }
 
-    static void PoseToMatrix(const dmArray<dmTransform::Transform>& pose, dmArray<Matrix4>& out_matrices)
+    static void PoseToMatrix(const dmTransform::Transform* pose, uint32_t bone_count, Matrix4* out_matrices)
     {
-        uint32_t bone_count = pose.Size();
         for (uint32_t bi = 0; bi < bone_count; ++bi)
         {
             out_matrices[bi] = dmTransform::ToMatrix4(pose[bi]);
         }
     }
 
-    static void PoseToModelSpace(const dmRigDDF::Skeleton* skeleton, const dmArray<dmTransform::Transform>& pose, dmArray<dmTransform::Transform>& out_pose)
+    static void PoseToModelSpace(const dmRigDDF::Skeleton* skeleton, const dmTransform::Transform* pose, dmTransform::Transform* out_pose)
     {
         const dmRigDDF::Bone* bones = skeleton->m_Bones.m_Data;
         uint32_t bone_count = skeleton->m_Bones.m_Count;
@@ -1203,7 +1528,7 @@ namespace dmRig
         }
     }
 
-    static void PoseToModelSpace(const dmRigDDF::Skeleton* skeleton, const dmArray<Matrix4>& pose, dmArray<Matrix4>& out_pose)
+    static void PoseToModelSpace(const dmRigDDF::Skeleton* skeleton, const Matrix4* pose, Matrix4* out_pose)
     {
         const dmRigDDF::Bone* bones = skeleton->m_Bones.m_Data;
         uint32_t bone_count = skeleton->m_Bones.m_Count;
@@ -1228,55 +1553,184 @@ namespace dmRig
         }
     }
 
-    static void PoseToInfluence(const dmArray<uint32_t>& pose_idx_to_influence, const dmArray<Matrix4>& in_pose, dmArray<Matrix4>& out_pose)
+    // Rearrange the pose matrices to the influence indices that the mesh vertices understand, premultiplied with
+    // the linear part of the model matrix. Influences without a bone are left with the model matrix alone.
+    static void PoseToPalette(const dmArray<uint32_t>& pose_idx_to_influence, const Matrix4* pose, const Matrix4& linear, SkinMatrix* palette, uint32_t palette_count)
     {
+        SkinMatrix identity;
+        ToSkinMatrix(linear, identity);
+        for (uint32_t i = 0; i < palette_count; ++i)
+        {
+            palette[i] = identity;
+        }
         for (uint32_t i = 0; i < pose_idx_to_influence.Size(); ++i)
         {
-            uint32_t j = pose_idx_to_influence[i];
-            out_pose[j] = in_pose[i];
+            ToSkinMatrix(linear * pose[i], palette[pose_idx_to_influence[i]]);
+        }
+    }
+
+    static void SkinPoseTask(const SkinJob* job, const SkinTask& task)
+    {
+        RigContext* context = job->m_Context;
+        const SkinInstance& skin_instance = context->m_SkinScratch->m_Instances[task.m_Item];
+        const GenerateVertexDataParams& params = *skin_instance.m_Params;
+        HRigInstance instance = params.m_Instance;
+
+        // Update the pose to be local-to-model
+        uint32_t bone_count = GetBoneCount(instance);
+        Matrix4* pose_matrices = context->m_ScratchPoseMatrixBuffer.Begin() + skin_instance.m_PoseOffset;
+        const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
+        if (skeleton->m_LocalBoneScaling) {
+            dmTransform::Transform* pose_transforms = context->m_ScratchPoseTransformBuffer.Begin() + skin_instance.m_PoseOffset;
+            PoseToModelSpace(skeleton, instance->m_Pose.Begin(), pose_transforms);
+            PoseToMatrix(pose_transforms, bone_count, pose_matrices);
+        } else {
+            PoseToMatrix(instance->m_Pose.Begin(), bone_count, pose_matrices);
+            PoseToModelSpace(skeleton, pose_matrices, pose_matrices);
+        }
+
+        // Premultiply pose matrices with the bind pose inverse so they
+        // can be directly be used to transform each vertex.
+        const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
+        for (uint32_t bi = 0; bi < bone_count; ++bi)
+        {
+            pose_matrices[bi] = pose_matrices[bi] * bind_pose[bi].m_ModelToLocal;
+        }
+
+        uint32_t palette_count = instance->m_MaxBoneCount;
+        if (skin_instance.m_ModelSpacePalette) {
+            // The model and normal matrices are applied per instance when the shared vertices are written
+            PoseToPalette(*instance->m_PoseIdxToInfluence, pose_matrices, Matrix4::identity(), context->m_ScratchPaletteBuffer.Begin() + skin_instance.m_PaletteOffset, palette_count);
+            return;
+        }
+
+        Matrix4 linear = params.m_ModelMatrix;
+        linear.setTranslation(Vector3(0.0f));
+        PoseToPalette(*instance->m_PoseIdxToInfluence, pose_matrices, linear, context->m_ScratchPaletteBuffer.Begin() + skin_instance.m_PaletteOffset, palette_count);
+        if (job->m_VertexFormat == RIG_VERTEX_FORMAT_MODEL) {
+            Matrix4 normal_linear = params.m_NormalMatrix;
+            normal_linear.setTranslation(Vector3(0.0f));
+            PoseToPalette(*instance->m_PoseIdxToInfluence, pose_matrices, normal_linear, context->m_ScratchNormalPaletteBuffer.Begin() + skin_instance.m_PaletteOffset, palette_count);
+        }
+    }
+
+    static void SkinPositionsTask(const SkinJob* job, const SkinTask& task)
+    {
+        RigContext* context = job->m_Context;
+        const SkinMesh& skin_mesh = context->m_SkinScratch->m_Meshes[task.m_Item];
+        const SkinInstance& skin_instance = context->m_SkinScratch->m_Instances[skin_mesh.m_Instance];
+        const dmRigDDF::Mesh* mesh = skin_mesh.m_Mesh;
+
+        const float* positions = mesh->m_Positions.m_Data + task.m_Begin * 3;
+        float* out_buffer = context->m_ScratchPositionBuffer.Begin() + (skin_mesh.m_PositionOffset + task.m_Begin) * 3;
+        uint32_t count = task.m_End - task.m_Begin;
+
+        if (!mesh->m_BoneIndices.m_Count || skin_instance.m_PaletteOffset == INVALID_PALETTE_OFFSET)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                TransformVertex(skin_instance.m_Model, positions, 1.0f, out_buffer);
+                positions += 3;
+                out_buffer += 3;
+            }
+            return;
+        }
+
+        // The palette holds the linear part of the model matrix, the translation is added last
+        const SkinMatrix* palette = context->m_ScratchPaletteBuffer.Begin() + skin_instance.m_PaletteOffset;
+        const uint32_t* bone_indices = mesh->m_BoneIndices.m_Data + task.m_Begin * 4;
+        const float* bone_weights = mesh->m_Weights.m_Data + task.m_Begin * 4;
+        const float tx = skin_instance.m_Model.m_Rows[0][3];
+        const float ty = skin_instance.m_Model.m_Rows[1][3];
+        const float tz = skin_instance.m_Model.m_Rows[2][3];
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            SkinVertex(palette, bone_indices, bone_weights, positions, 1.0f, out_buffer);
+            out_buffer[0] += tx;
+            out_buffer[1] += ty;
+            out_buffer[2] += tz;
+            positions += 3;
+            out_buffer += 3;
+            bone_indices += 4;
+            bone_weights += 4;
+        }
+    }
+
+    // Skins the positions, and the normals of the model format, of a mesh shared by instances with the same pose.
+    // Both are left in model space, the task range covers whichever of the positions and indices is larger.
+    static void SkinSharedMeshTask(const SkinJob* job, const SkinTask& task)
+    {
+        RigContext* context = job->m_Context;
+        const SharedSkinMesh& shared_mesh = context->m_SkinScratch->m_SharedMeshes[task.m_Item];
+        const SkinInstance& skin_instance = context->m_SkinScratch->m_Instances[shared_mesh.m_Instance];
+        const dmRigDDF::Mesh* mesh = shared_mesh.m_Mesh;
+        const SkinMatrix* palette = context->m_ScratchPaletteBuffer.Begin() + skin_instance.m_PaletteOffset;
+        const uint32_t* bone_indices = mesh->m_BoneIndices.m_Data;
+        const float* bone_weights = mesh->m_Weights.m_Data;
+
+        uint32_t position_end = dmMath::Min(task.m_End, mesh->m_Positions.m_Count / 3);
+        float* out_buffer = context->m_ScratchPositionBuffer.Begin() + shared_mesh.m_PositionOffset * 3;
+        for (uint32_t i = task.m_Begin; i < position_end; ++i)
+        {
+            SkinVertex(palette, &bone_indices[i << 2], &bone_weights[i << 2], &mesh->m_Positions.m_Data[i * 3], 1.0f, &out_buffer[i * 3]);
+        }
+
+        if (job->m_VertexFormat != RIG_VERTEX_FORMAT_MODEL || !mesh->m_NormalsIndices.m_Count) {
+            return;
+        }
+        const uint32_t* indices = mesh->m_PositionIndices.m_Data;
+        const uint32_t* normal_indices = mesh->m_NormalsIndices.m_Data;
+        uint32_t normal_end = dmMath::Min(task.m_End, mesh->m_PositionIndices.m_Count);
+        out_buffer = context->m_ScratchPositionBuffer.Begin() + shared_mesh.m_NormalOffset * 3;
+        for (uint32_t i = task.m_Begin; i < normal_end; ++i)
+        {
+            uint32_t vi = indices[i];
+            SkinVertex(palette, &bone_indices[vi << 2], &bone_weights[vi << 2], &mesh->m_Normals.m_Data[normal_indices[i] * 3], 0.0f, &out_buffer[i * 3]);
         }
     }
 
     // NOTE: We have two different vertex data write functions, since we expose two different vertex formats (spine and model).
     // This is a temporary fix until we have better support for custom vertex formats.
-    static RigModelVertex* WriteVertexData(const dmRigDDF::Mesh* mesh, const float* positions, const float* normals, RigModelVertex* out_write_ptr)
+    static void WriteVertexData(const dmRigDDF::Mesh* mesh, const float* positions, const SkinMatrix* normal_palette, const SkinMatrix& normal_matrix, uint32_t begin, uint32_t end, RigModelVertex* out_write_ptr)
     {
-        uint32_t indices_count = mesh->m_PositionIndices.m_Count;
         const uint32_t* indices = mesh->m_PositionIndices.m_Data;
         const uint32_t* uv0_indices = mesh->m_Texcoord0Indices.m_Count ? mesh->m_Texcoord0Indices.m_Data : mesh->m_PositionIndices.m_Data;
         const float* uv0 = mesh->m_Texcoord0.m_Data;
 
         if (mesh->m_NormalsIndices.m_Count)
         {
-            for (uint32_t i = 0; i < indices_count; ++i)
+            const float* normals_in = mesh->m_Normals.m_Data;
+            const uint32_t* normal_indices = mesh->m_NormalsIndices.m_Data;
+            const uint32_t* bone_indices = mesh->m_BoneIndices.m_Data;
+            const float* bone_weights = mesh->m_Weights.m_Data;
+            for (uint32_t i = begin; i < end; ++i)
             {
                 uint32_t vi = indices[i];
                 uint32_t e = vi * 3;
                 out_write_ptr->x = positions[e];
                 out_write_ptr->y = positions[++e];
                 out_write_ptr->z = positions[++e];
-                vi = uv0_indices[i];
-                e = vi << 1;
+                e = uv0_indices[i] << 1;
                 out_write_ptr->u = uv0[e+0];
                 out_write_ptr->v = uv0[e+1];
-                e = i * 3;
-                out_write_ptr->nx = normals[e];
-                out_write_ptr->ny = normals[++e];
-                out_write_ptr->nz = normals[++e];
+                const float* normal_in = &normals_in[normal_indices[i] * 3];
+                if (normal_palette) {
+                    SkinVertex(normal_palette, &bone_indices[vi << 2], &bone_weights[vi << 2], normal_in, 0.0f, &out_write_ptr->nx);
+                } else {
+                    TransformVertex(normal_matrix, normal_in, 0.0f, &out_write_ptr->nx);
+                }
                 out_write_ptr++;
             }
         }
         else
         {
-            for (uint32_t i = 0; i < indices_count; ++i)
+            for (uint32_t i = begin; i < end; ++i)
             {
-                uint32_t vi = indices[i];
-                uint32_t e = vi * 3;
+                uint32_t e = indices[i] * 3;
                 out_write_ptr->x = positions[e];
                 out_write_ptr->y = positions[++e];
                 out_write_ptr->z = positions[++e];
-                vi = uv0_indices[i];
-                e = vi << 1;
+                e = uv0_indices[i] << 1;
                 out_write_ptr->u = uv0[e+0];
                 out_write_ptr->v = uv0[e+1];
                 out_write_ptr->nx = 0.0f;
@@ -1285,178 +1739,379 @@ namespace dmRig
                 out_write_ptr++;
             }
         }
-
-        return out_write_ptr;
     }
 
-    static RigSpineModelVertex* WriteVertexData(const dmRigDDF::Mesh* mesh, const float* positions, const Vector4 color, RigSpineModelVertex* out_write_ptr)
+    static void WriteVertexData(const dmRigDDF::Mesh* mesh, const float* positions, const Vector4 color, uint32_t begin, uint32_t end, RigSpineModelVertex* out_write_ptr)
     {
-        uint32_t indices_count = mesh->m_PositionIndices.m_Count;
         const uint32_t* indices = mesh->m_PositionIndices.m_Data;
         const uint32_t* uv0_indices = mesh->m_Texcoord0Indices.m_Count ? mesh->m_Texcoord0Indices.m_Data : mesh->m_PositionIndices.m_Data;
         const float* uv0 = mesh->m_Texcoord0.m_Data;
+        const float r = color.getX();
+        const float g = color.getY();
+        const float b = color.getZ();
+        const float a = color.getW();
 
-        for (uint32_t i = 0; i < indices_count; ++i)
+        for (uint32_t i = begin; i < end; ++i)
         {
-            uint32_t vi = indices[i];
-            uint32_t e = vi*3;
+            uint32_t e = indices[i] * 3;
             out_write_ptr->x = positions[e+0];
             out_write_ptr->y = positions[e+1];
             out_write_ptr->z = positions[e+2];
-            vi = uv0_indices[i];
-            e = vi << 1;
+            e = uv0_indices[i] << 1;
             out_write_ptr->u = (uv0[e+0]);
             out_write_ptr->v = (uv0[e+1]);
-            out_write_ptr->r = color.getX();
-            out_write_ptr->g = color.getY();
-            out_write_ptr->b = color.getZ();
-            out_write_ptr->a = color.getW();
+            out_write_ptr->r = r;
+            out_write_ptr->g = g;
+            out_write_ptr->b = b;
+            out_write_ptr->a = a;
             out_write_ptr++;
         }
-        return out_write_ptr;
     }
 
-    void* GenerateVertexData(dmRig::HRigContext context, dmRig::HRigInstance instance, const Matrix4& model_matrix, const Matrix4& normal_matrix, const Vector4 color, RigVertexFormat vertex_format, void* vertex_data_out)
+    // Writes vertices from a shared mesh, moving the model space positions and normals to the world space of the instance
+    static void WriteSharedVertexData(const dmRigDDF::Mesh* mesh, const float* positions, const float* normals, const SkinMatrix& model_matrix, const SkinMatrix& normal_matrix, uint32_t begin, uint32_t end, RigModelVertex* out_write_ptr)
     {
-        const dmRigDDF::MeshEntry* mesh_entry = instance->m_MeshEntry;
-        if (!instance->m_MeshEntry || !instance->m_DoRender) {
-            return vertex_data_out;
+        const uint32_t* indices = mesh->m_PositionIndices.m_Data;
+        const uint32_t* uv0_indices = mesh->m_Texcoord0Indices.m_Count ? mesh->m_Texcoord0Indices.m_Data : mesh->m_PositionIndices.m_Data;
+        const float* uv0 = mesh->m_Texcoord0.m_Data;
+        const bool has_normals = mesh->m_NormalsIndices.m_Count != 0;
+
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            TransformVertex(model_matrix, &positions[indices[i] * 3], 1.0f, &out_write_ptr->x);
+            uint32_t e = uv0_indices[i] << 1;
+            out_write_ptr->u = uv0[e+0];
+            out_write_ptr->v = uv0[e+1];
+            if (has_normals) {
+                TransformVertex(normal_matrix, &normals[i * 3], 0.0f, &out_write_ptr->nx);
+            } else {
+                out_write_ptr->nx = 0.0f;
+                out_write_ptr->ny = 0.0f;
+                out_write_ptr->nz = 1.0f;
+            }
+            out_write_ptr++;
         }
+    }
 
-        // Early exit for rigs that has no mesh or only one mesh that is not visible.
-        int mesh_slot_count = mesh_entry->m_MeshSlots.m_Count;
-        if (mesh_slot_count == 0) {
-            return vertex_data_out;
+    static void WriteSharedVertexData(const dmRigDDF::Mesh* mesh, const float* positions, const SkinMatrix& model_matrix, const Vector4 color, uint32_t begin, uint32_t end, RigSpineModelVertex* out_write_ptr)
+    {
+        const uint32_t* indices = mesh->m_PositionIndices.m_Data;
+        const uint32_t* uv0_indices = mesh->m_Texcoord0Indices.m_Count ? mesh->m_Texcoord0Indices.m_Data : mesh->m_PositionIndices.m_Data;
+        const float* uv0 = mesh->m_Texcoord0.m_Data;
+        const float r = color.getX();
+        const float g = color.getY();
+        const float b = color.getZ();
+        const float a = color.getW();
 
-        } else if (mesh_slot_count == 1) {
-            uint32_t active_attachment = instance->m_MeshSlotPose[0].m_ActiveAttachment;
-            if (active_attachment == INVALID_ATTACHMENT_INDEX || mesh_entry->m_MeshSlots[0].m_MeshAttachments[active_attachment] == INVALID_ATTACHMENT_INDEX) {
-                return vertex_data_out;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            TransformVertex(model_matrix, &positions[indices[i] * 3], 1.0f, &out_write_ptr->x);
+            uint32_t e = uv0_indices[i] << 1;
+            out_write_ptr->u = (uv0[e+0]);
+            out_write_ptr->v = (uv0[e+1]);
+            out_write_ptr->r = r;
+            out_write_ptr->g = g;
+            out_write_ptr->b = b;
+            out_write_ptr->a = a;
+            out_write_ptr++;
+        }
+    }
+
+    static void WriteVerticesTask(const SkinJob* job, const SkinTask& task)
+    {
+        RigContext* context = job->m_Context;
+        const SkinMesh& skin_mesh = context->m_SkinScratch->m_Meshes[task.m_Item];
+        const SkinInstance& skin_instance = context->m_SkinScratch->m_Instances[skin_mesh.m_Instance];
+        const dmRigDDF::Mesh* mesh = skin_mesh.m_Mesh;
+
+        if (skin_mesh.m_SharedMesh != INVALID_SHARED_MESH) {
+            const SharedSkinMesh& shared_mesh = context->m_SkinScratch->m_SharedMeshes[skin_mesh.m_SharedMesh];
+            const float* positions = context->m_ScratchPositionBuffer.Begin() + shared_mesh.m_PositionOffset * 3;
+            if (job->m_VertexFormat == RIG_VERTEX_FORMAT_MODEL) {
+                const float* normals = context->m_ScratchPositionBuffer.Begin() + shared_mesh.m_NormalOffset * 3;
+                WriteSharedVertexData(mesh, positions, normals, skin_instance.m_Model, skin_instance.m_Normal, task.m_Begin, task.m_End, (RigModelVertex*)skin_mesh.m_VertexDataOut + task.m_Begin);
+            } else {
+                WriteSharedVertexData(mesh, positions, skin_instance.m_Model, skin_mesh.m_Color, task.m_Begin, task.m_End, (RigSpineModelVertex*)skin_mesh.m_VertexDataOut + task.m_Begin);
             }
+            return;
         }
 
-        dmArray<Matrix4>& pose_matrices      = context->m_ScratchPoseMatrixBuffer;
-        dmArray<Matrix4>& influence_matrices = context->m_ScratchInfluenceMatrixBuffer;
-        dmArray<Vector3>& positions          = context->m_ScratchPositionBuffer;
-        dmArray<Vector3>& normals            = context->m_ScratchNormalBuffer;
+        const float* positions = context->m_ScratchPositionBuffer.Begin() + skin_mesh.m_PositionOffset * 3;
+        if (job->m_VertexFormat == RIG_VERTEX_FORMAT_MODEL) {
+            const SkinMatrix* normal_palette = 0;
+            if (mesh->m_BoneIndices.m_Count && skin_instance.m_PaletteOffset != INVALID_PALETTE_OFFSET) {
+                normal_palette = context->m_ScratchNormalPaletteBuffer.Begin() + skin_instance.m_PaletteOffset;
+            }
+            WriteVertexData(mesh, positions, normal_palette, skin_instance.m_Normal, task.m_Begin, task.m_End, (RigModelVertex*)skin_mesh.m_VertexDataOut + task.m_Begin);
+        } else {
+            WriteVertexData(mesh, positions, skin_mesh.m_Color, task.m_Begin, task.m_End, (RigSpineModelVertex*)skin_mesh.m_VertexDataOut + task.m_Begin);
+        }
+    }
 
-        // If the rig has bones, update the pose to be local-to-model
-        uint32_t bone_count = GetBoneCount(instance);
-        influence_matrices.SetSize(0);
-        if (bone_count && instance->m_PoseIdxToInfluence->Size() > 0) {
+    // Runs tasks until all are claimed. Run by the calling thread and the job pool threads.
+    static void RunSkinTasks(void* context)
+    {
+        SkinJob* job = (SkinJob*) context;
+        while (true)
+        {
+            uint32_t i = (uint32_t) dmAtomicIncrement32(&job->m_NextTask);
+            if (i >= job->m_TaskCount)
+                break;
+            job->m_Function(job, job->m_Tasks[i]);
+        }
+    }
 
-            // Make sure pose scratch buffers have enough space
-            if (pose_matrices.Capacity() < bone_count) {
-                uint32_t size_offset = bone_count - pose_matrices.Capacity();
-                pose_matrices.OffsetCapacity(size_offset);
+    static void RunSkinJob(RigContext* context, RigVertexFormat vertex_format, SkinTaskFunction function, bool parallel)
+    {
+        dmArray<SkinTask>& tasks = context->m_SkinScratch->m_Tasks;
+        SkinJob job;
+        job.m_Context = context;
+        job.m_Function = function;
+        job.m_Tasks = tasks.Begin();
+        job.m_TaskCount = tasks.Size();
+        job.m_VertexFormat = vertex_format;
+        job.m_NextTask = 0;
+
+        if (!parallel || job.m_TaskCount < 2)
+            RunSkinTasks(&job);
+        else
+            dmJobPool::Run(RunSkinTasks, &job);
+    }
+
+    static void PushSkinTasks(dmArray<SkinTask>& tasks, uint32_t item, uint32_t count)
+    {
+        for (uint32_t begin = 0; begin < count; begin += SKIN_TASK_SIZE)
+        {
+            SkinTask task;
+            task.m_Item = item;
+            task.m_Begin = begin;
+            task.m_End = dmMath::Min(begin + SKIN_TASK_SIZE, count);
+            PushScratch(tasks, task);
+        }
+    }
+
+    void GenerateVertexDataBatch(HRigContext context, RigVertexFormat vertex_format, const GenerateVertexDataParams* params, uint32_t count)
+    {
+        DM_PROFILE(Rig, "GenerateVertexData");
+
+        SkinScratch* scratch = context->m_SkinScratch;
+        scratch->m_Instances.SetSize(0);
+        scratch->m_Meshes.SetSize(0);
+        scratch->m_SharedMeshes.SetSize(0);
+        scratch->m_SharedPalettes.Clear();
+        scratch->m_SharedMeshTable.Clear();
+        PoseCache* pose_cache = context->m_PoseCache;
+
+        const uint32_t vertex_size = vertex_format == RIG_VERTEX_FORMAT_MODEL ? sizeof(RigModelVertex) : sizeof(RigSpineModelVertex);
+        uint32_t pose_count = 0;
+        uint32_t palette_count = 0;
+        uint32_t position_count = 0;
+        uint32_t vertex_count = 0;
+
+        for (uint32_t pi = 0; pi < count; ++pi)
+        {
+            HRigInstance instance = params[pi].m_Instance;
+            if (!instance->m_MeshEntry || !instance->m_DoRender) {
+                continue;
             }
-            pose_matrices.SetSize(bone_count);
 
-            // Make sure influence scratch buffers have enough space sufficient for max bones to be indexed
-            uint32_t max_bone_count = instance->m_MaxBoneCount;
-            if (influence_matrices.Capacity() < max_bone_count) {
-                uint32_t capacity = influence_matrices.Capacity();
-                uint32_t size_offset = max_bone_count - capacity;
-                influence_matrices.OffsetCapacity(size_offset);
-                influence_matrices.SetSize(max_bone_count);
-                for(uint32_t i = capacity; i < capacity+size_offset; ++i)
-                    influence_matrices[i] = Matrix4::identity();
+            // Loop that collects the meshes of the instance.
+            // We loop over the slots in the mesh entry, check which attachment point is active,
+            // then locate the actual mesh that has been assigned to that attatchment point.
+            // (Instead of looping over the default slot orders directly, we go through the
+            // draw order array to render the slots in the correct order.)
+            uint32_t instance_index = scratch->m_Instances.Size();
+            uint32_t mesh_count = scratch->m_Meshes.Size();
+            uint8_t* vertex_data_out = (uint8_t*)params[pi].m_VertexDataOut;
+            int32_t slot_count = instance->m_MeshSet->m_SlotCount;
+            for (int32_t i = 0; i < slot_count; i++)
+            {
+                int32_t slot_index = instance->m_DrawOrder[i];
+
+                MeshSlotPose* mesh_slot_pose = &instance->m_MeshSlotPose[slot_index];
+                const dmRigDDF::MeshSlot* mesh_slot = mesh_slot_pose->m_MeshSlot;
+
+                // Get active attachment in the current slot.
+                uint32_t active_attachment = mesh_slot_pose->m_ActiveAttachment;
+                if (active_attachment == INVALID_ATTACHMENT_INDEX) {
+                    continue;
+                }
+
+                // Check if the attachment point has a mesh assigned
+                uint32_t mesh_attachment_index = mesh_slot->m_MeshAttachments[active_attachment];
+                if (mesh_attachment_index == INVALID_ATTACHMENT_INDEX) {
+                    continue;
+                }
+
+                // Lookup the mesh from the list of all the available meshes.
+                const Mesh* mesh_attachment = &instance->m_MeshSet->m_MeshAttachments[mesh_attachment_index];
+
+                SkinMesh skin_mesh;
+                skin_mesh.m_Mesh = mesh_attachment;
+                skin_mesh.m_VertexDataOut = vertex_data_out;
+                skin_mesh.m_Instance = instance_index;
+                skin_mesh.m_PositionOffset = 0;
+                skin_mesh.m_SharedMesh = INVALID_SHARED_MESH;
+                if (vertex_format == RIG_VERTEX_FORMAT_SPINE) {
+                    Vector4 slot_color = Vector4(mesh_slot_pose->m_SlotColor[0], mesh_slot_pose->m_SlotColor[1], mesh_slot_pose->m_SlotColor[2], mesh_slot_pose->m_SlotColor[3]);
+                    const float* mesh_color = mesh_attachment->m_MeshColor.m_Count ? mesh_attachment->m_MeshColor.m_Data : white;
+                    slot_color[0] = mesh_color[0] * slot_color[0];
+                    slot_color[1] = mesh_color[1] * slot_color[1];
+                    slot_color[2] = mesh_color[2] * slot_color[2];
+                    slot_color[3] = mesh_color[3] * slot_color[3];
+                    skin_mesh.m_Color = mulPerElem(params[pi].m_Color, slot_color);
+                }
+                PushScratch(scratch->m_Meshes, skin_mesh);
+
+                uint32_t index_count = mesh_attachment->m_PositionIndices.m_Count;
+                vertex_count += index_count;
+                vertex_data_out += index_count * vertex_size;
             }
-            influence_matrices.SetSize(max_bone_count);
 
-            const dmArray<dmTransform::Transform>& pose = instance->m_Pose;
-            const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
-            if (skeleton->m_LocalBoneScaling) {
+            // Early exit for rigs that has no visible mesh.
+            if (scratch->m_Meshes.Size() == mesh_count) {
+                continue;
+            }
 
-                dmArray<dmTransform::Transform>& pose_transforms = context->m_ScratchPoseTransformBuffer;
-                if (pose_transforms.Capacity() < bone_count) {
-                    pose_transforms.OffsetCapacity(bone_count - pose_transforms.Capacity());
+            SkinInstance skin_instance;
+            ToSkinMatrix(params[pi].m_ModelMatrix, skin_instance.m_Model);
+            ToSkinMatrix(params[pi].m_NormalMatrix, skin_instance.m_Normal);
+            skin_instance.m_Params = &params[pi];
+            skin_instance.m_PoseOffset = pose_count;
+            skin_instance.m_PaletteOffset = INVALID_PALETTE_OFFSET;
+            skin_instance.m_ComputePalette = 0;
+            skin_instance.m_ModelSpacePalette = 0;
+
+            // If the rig has bones, the pose is needed for the palette
+            uint32_t bone_count = GetBoneCount(instance);
+            uint32_t pose_cache_entry = instance->m_PoseCacheEntry;
+            if (bone_count && instance->m_PoseIdxToInfluence->Size() > 0) {
+                // Instances sharing a pose with others this frame use one model space palette, computed by the first of them
+                uint32_t* shared_palette = 0;
+                if (pose_cache && pose_cache_entry != INVALID_POSE_CACHE_ENTRY && pose_cache->m_Entries[pose_cache_entry].m_InstanceCount > 1) {
+                    skin_instance.m_ModelSpacePalette = 1;
+                    shared_palette = scratch->m_SharedPalettes.Get(pose_cache_entry);
+                } else {
+                    pose_cache_entry = INVALID_POSE_CACHE_ENTRY;
                 }
-                pose_transforms.SetSize(bone_count);
 
-                PoseToModelSpace(skeleton, pose, pose_transforms);
-                PoseToMatrix(pose_transforms, pose_matrices);
+                if (shared_palette) {
+                    skin_instance.m_PaletteOffset = scratch->m_Instances[*shared_palette].m_PaletteOffset;
+                } else {
+                    skin_instance.m_ComputePalette = 1;
+                    skin_instance.m_PaletteOffset = palette_count;
+                    pose_count += bone_count;
+                    palette_count += instance->m_MaxBoneCount;
+                    if (skin_instance.m_ModelSpacePalette) {
+                        PutScratch(scratch->m_SharedPalettes, pose_cache_entry, instance_index);
+                    }
+                }
             } else {
-                PoseToMatrix(pose, pose_matrices);
-                PoseToModelSpace(skeleton, pose_matrices, pose_matrices);
+                pose_cache_entry = INVALID_POSE_CACHE_ENTRY;
             }
+            PushScratch(scratch->m_Instances, skin_instance);
 
-            // Premultiply pose matrices with the bind pose inverse so they
-            // can be directly be used to transform each vertex.
-            const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
-            for (uint32_t bi = 0; bi < pose_matrices.Size(); ++bi)
+            // Skinned meshes of instances sharing a pose are skinned once, the other meshes are skinned per instance
+            for (uint32_t i = mesh_count; i < scratch->m_Meshes.Size(); ++i)
             {
-                Matrix4& pose_matrix = pose_matrices[bi];
-                pose_matrix = pose_matrix * bind_pose[bi].m_ModelToLocal;
+                SkinMesh& skin_mesh = scratch->m_Meshes[i];
+                const Mesh* mesh = skin_mesh.m_Mesh;
+                uint32_t mesh_position_count = mesh->m_Positions.m_Count / 3;
+                if (pose_cache_entry == INVALID_POSE_CACHE_ENTRY || !mesh->m_BoneIndices.m_Count) {
+                    skin_mesh.m_PositionOffset = position_count;
+                    position_count += mesh_position_count;
+                    continue;
+                }
+
+                SharedSkinMeshKey key;
+                memset(&key, 0, sizeof(key));
+                key.m_Mesh = mesh;
+                key.m_PoseCacheEntry = pose_cache_entry;
+                dmhash_t hash = dmHashBuffer64(&key, sizeof(key));
+                uint32_t* shared_mesh_index = scratch->m_SharedMeshTable.Get(hash);
+                if (shared_mesh_index) {
+                    skin_mesh.m_SharedMesh = *shared_mesh_index;
+                    continue;
+                }
+
+                SharedSkinMesh shared_mesh;
+                shared_mesh.m_Mesh = mesh;
+                shared_mesh.m_Instance = instance_index;
+                shared_mesh.m_PositionOffset = position_count;
+                position_count += mesh_position_count;
+                shared_mesh.m_NormalOffset = position_count;
+                if (vertex_format == RIG_VERTEX_FORMAT_MODEL && mesh->m_NormalsIndices.m_Count) {
+                    position_count += mesh->m_PositionIndices.m_Count;
+                }
+                skin_mesh.m_SharedMesh = scratch->m_SharedMeshes.Size();
+                PushScratch(scratch->m_SharedMeshes, shared_mesh);
+                PutScratch(scratch->m_SharedMeshTable, hash, skin_mesh.m_SharedMesh);
             }
+        }
 
-            // Rearrange pose matrices to indices that the mesh vertices understand.
-            PoseToInfluence(*instance->m_PoseIdxToInfluence, pose_matrices, influence_matrices);
+        // Make sure the scratch buffers have enough space
+        EnsureSize(context->m_ScratchPoseMatrixBuffer, pose_count);
+        EnsureSize(context->m_ScratchPoseTransformBuffer, pose_count);
+        EnsureSize(context->m_ScratchPaletteBuffer, palette_count);
+        if (vertex_format == RIG_VERTEX_FORMAT_MODEL) {
+            EnsureSize(context->m_ScratchNormalPaletteBuffer, palette_count);
         }
+        EnsureSize(context->m_ScratchPositionBuffer, position_count * 3);
 
-        // Loop that generates actual vertex data for current mesh entry.
-        // We loop over the slots in the mesh entry, check which attachment point is active,
-        // then locate the actual mesh that has been assigned to that attatchment point.
-        // (Instead of looping over the default slot orders directly, we go through the
-        // draw order array to render the slots in the correct order.)
-        int32_t slot_count = instance->m_MeshSet->m_SlotCount;
-        for (int32_t i = 0; i < slot_count; i++)
+        dmArray<SkinTask>& tasks = scratch->m_Tasks;
+        tasks.SetSize(0);
+        for (uint32_t i = 0; i < scratch->m_Instances.Size(); ++i)
         {
-            int32_t slot_index = instance->m_DrawOrder[i];
-
-            MeshSlotPose* mesh_slot_pose = &instance->m_MeshSlotPose[slot_index];
-            const dmRigDDF::MeshSlot* mesh_slot = mesh_slot_pose->m_MeshSlot;
-
-            // Get active attachment in the current slot.
-            uint32_t active_attachment = mesh_slot_pose->m_ActiveAttachment;
-            if (active_attachment != INVALID_ATTACHMENT_INDEX) {
+            if (scratch->m_Instances[i].m_ComputePalette) {
+                SkinTask task;
+                task.m_Item = i;
+                task.m_Begin = 0;
+                task.m_End = 0;
+                PushScratch(tasks, task);
+            }
+        }
+        RunSkinJob(context, vertex_format, SkinPoseTask, pose_count >= SKIN_PARALLEL_MIN_BONES);
 
-                // Check if the attachment point has a mesh assigned
-                uint32_t mesh_attachment_index = mesh_slot->m_MeshAttachments[active_attachment];
-                if (mesh_attachment_index != INVALID_ATTACHMENT_INDEX)
-                {
-                    // Lookup the mesh from the list of all the available meshes.
-                    const Mesh* mesh_attachment = &instance->m_MeshSet->m_MeshAttachments[mesh_attachment_index];
+        bool parallel = vertex_count >= SKIN_PARALLEL_MIN_VERTICES || position_count >= SKIN_PARALLEL_MIN_VERTICES;
+        tasks.SetSize(0);
+        for (uint32_t i = 0; i < scratch->m_Meshes.Size(); ++i)
+        {
+            if (scratch->m_Meshes[i].m_SharedMesh == INVALID_SHARED_MESH) {
+                PushSkinTasks(tasks, i, scratch->m_Meshes[i].m_Mesh->m_Positions.m_Count / 3);
+            }
+        }
+        RunSkinJob(context, vertex_format, SkinPositionsTask, parallel);
 
-                    // Bump scratch buffer capacity to handle current vertex count
-                    uint32_t index_count = mesh_attachment->m_PositionIndices.m_Count;
-                    if (positions.Capacity() < index_count) {
-                        positions.OffsetCapacity(index_count - positions.Capacity());
-                    }
-                    positions.SetSize(index_count);
+        if (!scratch->m_SharedMeshes.Empty()) {
+            tasks.SetSize(0);
+            for (uint32_t i = 0; i < scratch->m_SharedMeshes.Size(); ++i)
+            {
+                const Mesh* mesh = scratch->m_SharedMeshes[i].m_Mesh;
+                PushSkinTasks(tasks, i, dmMath::Max(mesh->m_Positions.m_Count / 3, mesh->m_PositionIndices.m_Count));
+            }
+            RunSkinJob(context, vertex_format, SkinSharedMeshTask, parallel);
+        }
 
-                    if (vertex_format == RIG_VERTEX_FORMAT_MODEL && mesh_attachment->m_NormalsIndices.m_Count) {
-                        if (normals.Capacity() < index_count) {
-                            normals.OffsetCapacity(index_count - normals.Capacity());
-                        }
-                        normals.SetSize(index_count);
-                    }
+        tasks.SetSize(0);
+        for (uint32_t i = 0; i < scratch->m_Meshes.Size(); ++i)
+        {
+            PushSkinTasks(tasks, i, scratch->m_Meshes[i].m_Mesh->m_PositionIndices.m_Count);
+        }
+        RunSkinJob(context, vertex_format, WriteVerticesTask, parallel);
+    }
 
-                    // Fill scratch buffers for positions, and normals if applicable, using pose matrices.
-                    float* positions_buffer = (float*)positions.Begin();
-                    float* normals_buffer = (float*)normals.Begin();
-                    dmRig::GeneratePositionData(mesh_attachment, model_matrix, influence_matrices, positions_buffer);
-                    if (vertex_format == RIG_VERTEX_FORMAT_MODEL && mesh_attachment->m_NormalsIndices.m_Count) {
-                        dmRig::GenerateNormalData(mesh_attachment, normal_matrix, influence_matrices, normals_buffer);
-                    }
+    void* GenerateVertexData(dmRig::HRigContext context, dmRig::HRigInstance instance, const Matrix4& model_matrix, const Matrix4& normal_matrix, const Vector4 color, RigVertexFormat vertex_format, void* vertex_data_out)
+    {
+        GenerateVertexDataParams params;
+        params.m_ModelMatrix = model_matrix;
+        params.m_NormalMatrix = normal_matrix;
+        params.m_Color = color;
+        params.m_Instance = instance;
+        params.m_VertexDataOut = vertex_data_out;
+        GenerateVertexDataBatch(context, vertex_format, &params, 1);
 
-                    // NOTE: We expose two different vertex format that GenerateVertexData can output.
-                    // This is a temporary fix until we have better support for custom vertex formats.
-                    if (vertex_format == RIG_VERTEX_FORMAT_MODEL) {
-                        vertex_data_out = (void*)WriteVertexData(mesh_attachment, positions_buffer, normals_buffer, (RigModelVertex*)vertex_data_out);
-                    } else {
-                        Vector4 slot_color = Vector4(mesh_slot_pose->m_SlotColor[0], mesh_slot_pose->m_SlotColor[1], mesh_slot_pose->m_SlotColor[2], mesh_slot_pose->m_SlotColor[3]);
-                        const float* mesh_color = mesh_attachment->m_MeshColor.m_Count ? mesh_attachment->m_MeshColor.m_Data : white;
-                        slot_color[0] = mesh_color[0] * slot_color[0];
-                        slot_color[1] = mesh_color[1] * slot_color[1];
-                        slot_color[2] = mesh_color[2] * slot_color[2];
-                        slot_color[3] = mesh_color[3] * slot_color[3];
-                        slot_color = mulPerElem(color, slot_color);
-                        vertex_data_out = (void*)WriteVertexData(mesh_attachment, positions_buffer, slot_color, (RigSpineModelVertex*)vertex_data_out);
-                    }
-                }
-            }
-        }
+        const uint32_t vertex_size = vertex_format == RIG_VERTEX_FORMAT_MODEL ? sizeof(RigModelVertex) : sizeof(RigSpineModelVertex);
+        vertex_data_out = (void*)((uint8_t*)vertex_data_out + GetVertexCount(instance) * vertex_size);
 
         // DEF-3610
         // Using Wasm on Microsoft Edge this function returns NULL after a couple of runs.
@@ -1619,6 +2274,7 @@ namespace dmRig
         instance->m_TrackIdxToPose     = params.m_TrackIdxToPose;
 
         instance->m_Enabled = 1;
+        instance->m_PoseCacheEntry = INVALID_POSE_CACHE_ENTRY;
 
         AllocateMeshSlotPose(params.m_MeshSet, instance->m_MeshSlotPose, instance->m_DrawOrder);
         SetMesh(instance, instance->m_MeshId);
@@ -12,10 +12,13 @@
 
 #define _USE_MATH_DEFINES // for C
 #include <math.h>
+#include <string.h>
 
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
+#include <dlib/time.h>
 
 #include <../rig.h>
 
@@ -37,6 +40,18 @@ static void DeleteRigAnimation(dmRigDDF::RigAnimation& anim)
         if (anim_track.m_Scale.m_Count) {
             delete [] anim_track.m_Scale.m_Data;
         }
+        if (anim_track.m_PositionKeys.m_Count) {
+            delete [] anim_track.m_PositionKeys.m_Data;
+        }
+        if (anim_track.m_RotationKeys.m_Count) {
+            delete [] anim_track.m_RotationKeys.m_Data;
+        }
+        if (anim_track.m_ScaleKeys.m_Count) {
+            delete [] anim_track.m_ScaleKeys.m_Data;
+        }
+        if (anim_track.m_PackedRotations.m_Count) {
+            delete [] anim_track.m_PackedRotations.m_Data;
+        }
     }
 
     for (uint32_t t = 0; t < anim.m_IkTracks.m_Count; ++t) {
@@ -640,7 +655,7 @@ void SetUpSimpleRig(dmArray<dmRig::RigBone>& bind_pose, dmRigDDF::Skeleton* skel
         // Animation 0: "valid"
         {
             uint32_t track_count = 2;
-            anim0.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count];
+            anim0.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count]();
             anim0.m_Tracks.m_Count = track_count;
             dmRigDDF::AnimationTrack& anim_track0 = anim0.m_Tracks.m_Data[0];
             dmRigDDF::AnimationTrack& anim_track1 = anim0.m_Tracks.m_Data[1];
@@ -695,7 +710,7 @@ void SetUpSimpleRig(dmArray<dmRig::RigBone>& bind_pose, dmRigDDF::Skeleton* skel
         // Animation 2: "scaling"
         {
             uint32_t track_count = 3; // 2x rotation, 1x scale
-            anim2.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count];
+            anim2.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count]();
             anim2.m_Tracks.m_Count = track_count;
             dmRigDDF::AnimationTrack& anim_track_b0_rot   = anim2.m_Tracks.m_Data[0];
             dmRigDDF::AnimationTrack& anim_track_b0_scale = anim2.m_Tracks.m_Data[1];
@@ -742,7 +757,7 @@ void SetUpSimpleRig(dmArray<dmRig::RigBone>& bind_pose, dmRigDDF::Skeleton* skel
         // Animation 3: "invalid_bones"
         {
             uint32_t track_count = 1;
-            anim3.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count];
+            anim3.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count]();
             anim3.m_Tracks.m_Count = track_count;
             dmRigDDF::AnimationTrack& anim_track0 = anim3.m_Tracks.m_Data[0];
 
@@ -762,7 +777,7 @@ void SetUpSimpleRig(dmArray<dmRig::RigBone>& bind_pose, dmRigDDF::Skeleton* skel
         // Animation 4: "rot_blend1"
         {
             uint32_t track_count = 1;
-            anim4.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count];
+            anim4.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count]();
             anim4.m_Tracks.m_Count = track_count;
             dmRigDDF::AnimationTrack& anim_track0 = anim4.m_Tracks.m_Data[0];
 
@@ -781,7 +796,7 @@ void SetUpSimpleRig(dmArray<dmRig::RigBone>& bind_pose, dmRigDDF::Skeleton* skel
         // Animation 5: "rot_blend2"
         {
             uint32_t track_count = 1;
-            anim5.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count];
+            anim5.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count]();
             anim5.m_Tracks.m_Count = track_count;
             dmRigDDF::AnimationTrack& anim_track0 = anim5.m_Tracks.m_Data[0];
 
@@ -802,7 +817,7 @@ void SetUpSimpleRig(dmArray<dmRig::RigBone>& bind_pose, dmRigDDF::Skeleton* skel
             uint32_t track_count = 2;
             uint32_t samples = 2;
 
-            anim6.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count];
+            anim6.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[track_count]();
             anim6.m_Tracks.m_Count = track_count;
             dmRigDDF::AnimationTrack& anim_track0 = anim6.m_Tracks.m_Data[0];
             dmRigDDF::AnimationTrack& anim_track1 = anim6.m_Tracks.m_Data[1];
@@ -1447,19 +1462,20 @@ TEST_F(RigInstanceTest, PlayValidAnimation)
 
 TEST_F(RigInstanceTest, MaxBoneCount)
 {
-    // Call GenerateVertedData to setup m_ScratchInfluenceMatrixBuffer
+    // Call GenerateVertedData to setup m_ScratchPaletteBuffer
     ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0/60.0));
     dmRig::RigModelVertex data[4];
     dmRig::RigModelVertex* data_end = data + 4;
     ASSERT_EQ(data_end, dmRig::GenerateVertexData(m_Context, m_Instance, Matrix4::identity(), Matrix4::identity(), Vector4(1.0), dmRig::RIG_VERTEX_FORMAT_MODEL, (void*)data));
 
-    // m_ScratchInfluenceMatrixBuffer should be able to contain the instance max bone count, which is the max of the used skeleton and meshset
+    // m_ScratchPaletteBuffer should be able to contain the instance max bone count, which is the max of the used skeleton and meshset
     // MaxBoneCount is set to BoneCount + 1 for testing.
-    ASSERT_EQ(m_Context->m_ScratchInfluenceMatrixBuffer.Size(), dmRig::GetMaxBoneCount(m_Instance));
-    ASSERT_EQ(m_Context->m_ScratchInfluenceMatrixBuffer.Size(), dmRig::GetBoneCount(m_Instance) + 1);
+    ASSERT_EQ(m_Context->m_ScratchPaletteBuffer.Size(), dmRig::GetMaxBoneCount(m_Instance));
+    ASSERT_EQ(m_Context->m_ScratchPaletteBuffer.Size(), dmRig::GetBoneCount(m_Instance) + 1);
+    ASSERT_EQ(m_Context->m_ScratchNormalPaletteBuffer.Size(), dmRig::GetMaxBoneCount(m_Instance));
 
-    // Setting the m_ScratchInfluenceMatrixBuffer to zero ensures it have to be resized to max bone count
-    m_Context->m_ScratchInfluenceMatrixBuffer.SetCapacity(0);
+    // Setting the m_ScratchPaletteBuffer to zero ensures it have to be resized to max bone count
+    m_Context->m_ScratchPaletteBuffer.SetCapacity(0);
     // If this isn't done correctly, it'll assert out of bounds
     ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 1.0/60.0));
 }
@@ -1690,6 +1706,482 @@ TEST_F(RigInstanceTest, GenerateNormalData)
     ASSERT_VERT_NORM(n_neg_right, data[2]); // v2
 }
 
+// Replaces the mesh data with copies of its first four vertices, offset and blended between two bones
+static void RepeatTestMesh(dmRigDDF::Mesh& mesh, uint32_t copies)
+{
+    const uint32_t vert_count = copies * 4;
+    float* positions = new float[vert_count*3];
+    float* normals = new float[vert_count*3];
+    uint32_t* indices = new uint32_t[vert_count];
+    uint32_t* bone_indices = new uint32_t[vert_count*4];
+    float* weights = new float[vert_count*4];
+    for (uint32_t i = 0; i < vert_count; ++i)
+    {
+        uint32_t src = i % 4;
+        float offset = (float)(i / 4) * 0.001f;
+        positions[i*3+0] = mesh.m_Positions[src*3+0] + offset;
+        positions[i*3+1] = mesh.m_Positions[src*3+1] - offset;
+        positions[i*3+2] = mesh.m_Positions[src*3+2] + offset;
+        normals[i*3+0] = mesh.m_Normals[src*3+0];
+        normals[i*3+1] = mesh.m_Normals[src*3+1];
+        normals[i*3+2] = mesh.m_Normals[src*3+2];
+        indices[i] = i;
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+            bone_indices[i*4+j] = mesh.m_BoneIndices[((i+1)%4)*4+j];
+            weights[i*4+j] = 0.0f;
+        }
+        bone_indices[i*4+0] = mesh.m_BoneIndices[src*4];
+        weights[i*4+0] = 0.75f;
+        weights[i*4+1] = 0.25f;
+    }
+
+    delete [] mesh.m_Positions.m_Data;
+    delete [] mesh.m_Normals.m_Data;
+    delete [] mesh.m_NormalsIndices.m_Data;
+    delete [] mesh.m_PositionIndices.m_Data;
+    delete [] mesh.m_BoneIndices.m_Data;
+    delete [] mesh.m_Weights.m_Data;
+    delete [] mesh.m_Texcoord0Indices.m_Data;
+
+    mesh.m_Positions.m_Data = positions;
+    mesh.m_Positions.m_Count = vert_count*3;
+    mesh.m_Normals.m_Data = normals;
+    mesh.m_Normals.m_Count = vert_count*3;
+    mesh.m_BoneIndices.m_Data = bone_indices;
+    mesh.m_BoneIndices.m_Count = vert_count*4;
+    mesh.m_Weights.m_Data = weights;
+    mesh.m_Weights.m_Count = vert_count*4;
+    mesh.m_NormalsIndices.m_Data = indices;
+    mesh.m_NormalsIndices.m_Count = vert_count;
+    mesh.m_PositionIndices.m_Data = new uint32_t[vert_count];
+    mesh.m_PositionIndices.m_Count = vert_count;
+    memcpy(mesh.m_PositionIndices.m_Data, indices, vert_count * sizeof(uint32_t));
+    mesh.m_Texcoord0Indices.m_Data = new uint32_t[vert_count];
+    mesh.m_Texcoord0Indices.m_Count = vert_count;
+    memset(mesh.m_Texcoord0Indices.m_Data, 0, vert_count * sizeof(uint32_t));
+}
+
+TEST_F(RigInstanceTest, GenerateVertexDataBatch)
+{
+    // Enough vertices for the batch to be split into tasks and skinned on the worker threads
+    const uint32_t copies = 8192;
+    dmRigDDF::Mesh& mesh = m_MeshSet->m_MeshAttachments[m_MeshSet->m_MeshEntries[0].m_MeshSlots[0].m_MeshAttachments[0]];
+    RepeatTestMesh(mesh, copies);
+
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.5f));
+
+    const uint32_t vertex_count = dmRig::GetVertexCount(m_Instance);
+    ASSERT_EQ(copies * 4, vertex_count);
+
+    const uint32_t instance_count = 3;
+    Matrix4 model_matrices[instance_count] = {
+        Matrix4::identity(),
+        Matrix4::translation(Vector3(1.0f, 2.0f, 3.0f)),
+        Matrix4::translation(Vector3(-4.0f, 0.0f, 1.0f)) * Matrix4::rotationZ((float) M_PI_4) * Matrix4::scale(Vector3(2.0f, 2.0f, 1.0f))
+    };
+
+    dmArray<dmRig::RigModelVertex> batch;
+    batch.SetCapacity(vertex_count * instance_count);
+    batch.SetSize(vertex_count * instance_count);
+    dmRig::GenerateVertexDataParams params[instance_count];
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        params[i].m_ModelMatrix = model_matrices[i];
+        params[i].m_NormalMatrix = transpose(inverse(model_matrices[i]));
+        params[i].m_Color = Vector4(1.0f);
+        params[i].m_Instance = m_Instance;
+        params[i].m_VertexDataOut = batch.Begin() + vertex_count * i;
+    }
+    dmRig::GenerateVertexDataBatch(m_Context, dmRig::RIG_VERTEX_FORMAT_MODEL, params, instance_count);
+
+    dmArray<dmRig::RigModelVertex> single;
+    single.SetCapacity(vertex_count);
+    single.SetSize(vertex_count);
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        // Same output as one instance at a time
+        ASSERT_EQ(single.End(), dmRig::GenerateVertexData(m_Context, m_Instance, params[i].m_ModelMatrix, params[i].m_NormalMatrix, Vector4(1.0f), dmRig::RIG_VERTEX_FORMAT_MODEL, (void*)single.Begin()));
+        ASSERT_EQ(0, memcmp(single.Begin(), batch.Begin() + vertex_count * i, vertex_count * sizeof(dmRig::RigModelVertex)));
+
+        // Same output as the skinned vertices of the first instance, transformed by the model and normal matrix
+        for (uint32_t v = 0; v < vertex_count; v += 997)
+        {
+            const dmRig::RigModelVertex& local = batch[v];
+            const dmRig::RigModelVertex& world = batch[vertex_count * i + v];
+            Vector4 p = model_matrices[i] * Point3(local.x, local.y, local.z);
+            Vector4 n = params[i].m_NormalMatrix * Vector3(local.nx, local.ny, local.nz);
+            ASSERT_VERT_POS(Vector3(p.getX(), p.getY(), p.getZ()), world);
+            ASSERT_VERT_NORM(Vector3(n.getX(), n.getY(), n.getZ()), world);
+        }
+    }
+}
+
+static dmRig::HRigInstance CreatePoseCacheTestInstance(dmRig::HRigContext context, dmArray<dmRig::RigBone>* bind_pose, dmRigDDF::Skeleton* skeleton, dmRigDDF::MeshSet* mesh_set, dmRigDDF::AnimationSet* animation_set, dmArray<uint32_t>* track_idx_to_pose, dmArray<uint32_t>* pose_idx_to_influence)
+{
+    dmRig::HRigInstance instance = 0x0;
+    dmRig::InstanceCreateParams create_params = {0};
+    create_params.m_Context = context;
+    create_params.m_Instance = &instance;
+    create_params.m_BindPose = bind_pose;
+    create_params.m_Skeleton = skeleton;
+    create_params.m_MeshSet = mesh_set;
+    create_params.m_AnimationSet = animation_set;
+    create_params.m_TrackIdxToPose = track_idx_to_pose;
+    create_params.m_PoseIdxToInfluence = pose_idx_to_influence;
+    create_params.m_MeshId = dmHashString64((const char*)"test");
+    create_params.m_DefaultAnimation = dmHashString64((const char*)"");
+    if (dmRig::RESULT_OK != dmRig::InstanceCreate(create_params)) {
+        return 0x0;
+    }
+    return instance;
+}
+
+static void DestroyPoseCacheTestInstance(dmRig::HRigContext context, dmRig::HRigInstance instance)
+{
+    dmRig::InstanceDestroyParams destroy_params = {0};
+    destroy_params.m_Context = context;
+    destroy_params.m_Instance = instance;
+    dmRig::InstanceDestroy(destroy_params);
+}
+
+TEST_F(RigInstanceTest, PoseCache)
+{
+    dmRig::HRigContext cache_context = 0x0;
+    dmRig::NewContextParams params = {0};
+    params.m_Context = &cache_context;
+    params.m_MaxRigInstanceCount = 3;
+    params.m_PoseCache = true;
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::NewContext(params));
+
+    dmRig::HRigInstance instances[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        instances[i] = CreatePoseCacheTestInstance(cache_context, &m_BindPose, m_Skeleton, m_MeshSet, m_AnimationSet, &m_TrackIdxToPose, &m_PoseIdxToInfluence);
+        ASSERT_NE((dmRig::HRigInstance) 0x0, instances[i]);
+    }
+
+    // Two instances play the same animation in sync, the third one is ahead
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instances[0], dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instances[1], dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instances[2], dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.5f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.5f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(cache_context, 0.5f));
+
+    ASSERT_EQ(instances[0]->m_PoseCacheEntry, instances[1]->m_PoseCacheEntry);
+    ASSERT_NE(instances[0]->m_PoseCacheEntry, instances[2]->m_PoseCacheEntry);
+
+    // The shared pose is the same as the one computed without the cache
+    dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(m_Instance);
+    dmArray<dmTransform::Transform>& shared_pose = *dmRig::GetPose(instances[1]);
+    ASSERT_EQ(pose.Size(), shared_pose.Size());
+    for (uint32_t i = 0; i < pose.Size(); ++i)
+    {
+        ASSERT_VEC3(pose[i].GetTranslation(), shared_pose[i].GetTranslation());
+        ASSERT_VEC4(pose[i].GetRotation(), shared_pose[i].GetRotation());
+    }
+
+    // The shared skinned vertices are the same as the ones skinned per instance
+    const uint32_t vertex_count = dmRig::GetVertexCount(m_Instance);
+    Matrix4 model_matrices[2] = {
+        Matrix4::translation(Vector3(1.0f, 2.0f, 3.0f)),
+        Matrix4::translation(Vector3(-4.0f, 0.0f, 1.0f)) * Matrix4::rotationZ((float) M_PI_4) * Matrix4::scale(Vector3(2.0f, 2.0f, 1.0f))
+    };
+    dmArray<dmRig::RigModelVertex> expected;
+    expected.SetCapacity(vertex_count);
+    expected.SetSize(vertex_count);
+    dmArray<dmRig::RigModelVertex> batch;
+    batch.SetCapacity(vertex_count * 2);
+    batch.SetSize(vertex_count * 2);
+    dmRig::GenerateVertexDataParams batch_params[2];
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        batch_params[i].m_ModelMatrix = model_matrices[i];
+        batch_params[i].m_NormalMatrix = transpose(inverse(model_matrices[i]));
+        batch_params[i].m_Color = Vector4(1.0f);
+        batch_params[i].m_Instance = instances[i];
+        batch_params[i].m_VertexDataOut = batch.Begin() + vertex_count * i;
+    }
+    dmRig::GenerateVertexDataBatch(cache_context, dmRig::RIG_VERTEX_FORMAT_MODEL, batch_params, 2);
+
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        dmRig::GenerateVertexData(m_Context, m_Instance, batch_params[i].m_ModelMatrix, batch_params[i].m_NormalMatrix, Vector4(1.0f), dmRig::RIG_VERTEX_FORMAT_MODEL, (void*)expected.Begin());
+        for (uint32_t v = 0; v < vertex_count; ++v)
+        {
+            const dmRig::RigModelVertex& shared = batch[vertex_count * i + v];
+            ASSERT_VERT_POS(Vector3(expected[v].x, expected[v].y, expected[v].z), shared);
+            ASSERT_VERT_NORM(Vector3(expected[v].nx, expected[v].ny, expected[v].nz), shared);
+        }
+    }
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        DestroyPoseCacheTestInstance(cache_context, instances[i]);
+    }
+    dmRig::DeleteContext(cache_context);
+}
+
+// Compresses tracks the way bob does, see RigUtil.compressTrack
+static uint64_t PackTestQuat(const float* q)
+{
+    const float range = 0.70710678f;
+    const float component_max = (float)((1 << 20) - 1);
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < 4; ++i)
+    {
+        if (fabsf(q[i]) > fabsf(q[largest]))
+            largest = i;
+    }
+    float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+    uint64_t packed = largest;
+    uint32_t shift = 2;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float n = dmMath::Clamp((sign * q[i] / range + 1.0f) * 0.5f, 0.0f, 1.0f);
+        packed |= (uint64_t)(n * component_max + 0.5f) << shift;
+        shift += 20;
+    }
+    return packed;
+}
+
+// Error of the sample i when interpolated between the samples k0 and k1
+static float TestKeyError(const float* values, uint32_t stride, uint32_t k0, uint32_t k1, uint32_t i)
+{
+    float t = k1 > k0 ? (float)(i - k0) / (float)(k1 - k0) : 0.0f;
+    const float* v0 = &values[k0 * stride];
+    const float* v1 = &values[k1 * stride];
+    const float* v = &values[i * stride];
+    if (stride == 4) {
+        // Twice the chord between the rotations, close to the angle for small errors
+        Quat q = slerp(t, Quat(v0[0], v0[1], v0[2], v0[3]), Quat(v1[0], v1[1], v1[2], v1[3]));
+        Quat r(v[0], v[1], v[2], v[3]);
+        return 2.0f * dmMath::Min(length(q - r), length(q + r));
+    }
+    float error = 0.0f;
+    for (uint32_t c = 0; c < stride; ++c)
+    {
+        error = dmMath::Max(error, fabsf(v0[c] + (v1[c] - v0[c]) * t - v[c]));
+    }
+    return error;
+}
+
+template <typename VALUES, typename KEYS>
+static void ReduceTestProperty(VALUES& values, KEYS& keys, uint32_t stride, float error)
+{
+    uint32_t count = values.m_Count / stride;
+    if (count < 2)
+        return;
+
+    uint32_t* key_data = new uint32_t[count];
+    uint32_t key_count = 1;
+    key_data[0] = 0;
+    bool constant = true;
+    for (uint32_t i = 1; i < count && constant; ++i)
+    {
+        constant = TestKeyError(values.m_Data, stride, 0, 0, i) <= error;
+    }
+    if (!constant)
+    {
+        uint32_t key = 0;
+        for (uint32_t end = 2; end < count; ++end)
+        {
+            for (uint32_t i = key + 1; i < end; ++i)
+            {
+                if (TestKeyError(values.m_Data, stride, key, end, i) > error) {
+                    key = end - 1;
+                    key_data[key_count++] = key;
+                    break;
+                }
+            }
+        }
+        key_data[key_count++] = count - 1;
+    }
+
+    float* data = new float[key_count * stride];
+    for (uint32_t k = 0; k < key_count; ++k)
+    {
+        memcpy(&data[k * stride], &values.m_Data[key_data[k] * stride], stride * sizeof(float));
+    }
+    delete [] values.m_Data;
+    values.m_Data = data;
+    values.m_Count = key_count * stride;
+
+    if (key_count > 1 && key_count < count) {
+        keys.m_Data = key_data;
+        keys.m_Count = key_count;
+    } else {
+        delete [] key_data;
+    }
+}
+
+static void CompressTestTrack(dmRigDDF::AnimationTrack& track, float error)
+{
+    ReduceTestProperty(track.m_Positions, track.m_PositionKeys, 3, error);
+    ReduceTestProperty(track.m_Rotations, track.m_RotationKeys, 4, error);
+    ReduceTestProperty(track.m_Scale, track.m_ScaleKeys, 3, error);
+    if (track.m_Rotations.m_Count) {
+        uint32_t count = track.m_Rotations.m_Count / 4;
+        track.m_PackedRotations.m_Data = new uint64_t[count];
+        track.m_PackedRotations.m_Count = count;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            track.m_PackedRotations.m_Data[i] = PackTestQuat(&track.m_Rotations.m_Data[i * 4]);
+        }
+        delete [] track.m_Rotations.m_Data;
+        track.m_Rotations.m_Data = 0;
+        track.m_Rotations.m_Count = 0;
+    }
+}
+
+static uint32_t GetTestTrackSize(const dmRigDDF::RigAnimation& anim)
+{
+    uint32_t size = 0;
+    for (uint32_t t = 0; t < anim.m_Tracks.m_Count; ++t)
+    {
+        const dmRigDDF::AnimationTrack& track = anim.m_Tracks.m_Data[t];
+        size += (track.m_Positions.m_Count + track.m_Rotations.m_Count + track.m_Scale.m_Count) * sizeof(float);
+        size += (track.m_PositionKeys.m_Count + track.m_RotationKeys.m_Count + track.m_ScaleKeys.m_Count) * sizeof(uint32_t);
+        size += track.m_PackedRotations.m_Count * sizeof(uint64_t);
+    }
+    return size;
+}
+
+TEST_F(RigInstanceTest, CompressedTracks)
+{
+    dmRigDDF::RigAnimation& anim = m_AnimationSet->m_Animations.m_Data[0];
+
+    // Add a constant position and a linear scale, to cover all the compressed properties
+    dmRigDDF::AnimationTrack& track = anim.m_Tracks.m_Data[0];
+    const uint32_t samples = track.m_Rotations.m_Count / 4;
+    track.m_Positions.m_Data = new float[samples * 3];
+    track.m_Positions.m_Count = samples * 3;
+    track.m_Scale.m_Data = new float[samples * 3];
+    track.m_Scale.m_Count = samples * 3;
+    for (uint32_t i = 0; i < samples; ++i)
+    {
+        track.m_Positions.m_Data[i * 3 + 0] = 0.5f;
+        track.m_Positions.m_Data[i * 3 + 1] = 0.25f;
+        track.m_Positions.m_Data[i * 3 + 2] = 0.0f;
+        track.m_Scale.m_Data[i * 3 + 0] = 1.0f + 0.5f * i;
+        track.m_Scale.m_Data[i * 3 + 1] = 1.0f;
+        track.m_Scale.m_Data[i * 3 + 2] = 1.0f;
+    }
+
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(m_Instance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+
+    const uint32_t steps = 13;
+    const uint32_t bone_count = dmRig::GetPose(m_Instance)->Size();
+    dmArray<dmTransform::Transform> expected;
+    expected.SetCapacity(steps * bone_count);
+    for (uint32_t i = 0; i < steps; ++i)
+    {
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::SetCursor(m_Instance, i * 0.25f, false));
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.0f));
+        dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(m_Instance);
+        for (uint32_t bi = 0; bi < bone_count; ++bi)
+            expected.Push(pose[bi]);
+    }
+
+    for (uint32_t t = 0; t < anim.m_Tracks.m_Count; ++t)
+    {
+        CompressTestTrack(anim.m_Tracks.m_Data[t], 0.0001f);
+    }
+    ASSERT_EQ(3u, track.m_Positions.m_Count);
+    ASSERT_EQ(0u, track.m_PositionKeys.m_Count);
+    ASSERT_EQ(2u, track.m_ScaleKeys.m_Count);
+    ASSERT_EQ(4u, track.m_RotationKeys.m_Count);
+    ASSERT_EQ(4u, track.m_PackedRotations.m_Count);
+    ASSERT_EQ(0u, track.m_Rotations.m_Count);
+
+    for (uint32_t i = 0; i < steps; ++i)
+    {
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::SetCursor(m_Instance, i * 0.25f, false));
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.0f));
+        dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(m_Instance);
+        for (uint32_t bi = 0; bi < bone_count; ++bi)
+        {
+            const dmTransform::Transform& e = expected[i * bone_count + bi];
+            ASSERT_VEC3(e.GetTranslation(), pose[bi].GetTranslation());
+            ASSERT_VEC4_NEAR(e.GetRotation(), pose[bi].GetRotation(), 0.0001f);
+            ASSERT_VEC3(e.GetScale(), pose[bi].GetScale());
+        }
+    }
+}
+
+// Best time of a few runs
+static uint64_t BenchTestSampling(dmRig::HRigContext context, dmRig::HRigInstance instance, uint32_t frames)
+{
+    dmRig::PlayAnimation(instance, dmHashString64("valid"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f);
+    uint64_t best = ~0ULL;
+    for (uint32_t run = 0; run < 5; ++run)
+    {
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t i = 0; i < frames; ++i)
+        {
+            dmRig::Update(context, 1.0f / 60.0f);
+        }
+        best = dmMath::Min(best, dmTime::GetTime() - start);
+    }
+    return best;
+}
+
+TEST_F(RigInstanceTest, CompressedTracksBench)
+{
+    // Replace the tracks of the "valid" animation with long, smooth tracks for all bones
+    dmRigDDF::RigAnimation& anim = m_AnimationSet->m_Animations.m_Data[0];
+    const float sample_rate = 30.0f;
+    const float duration = 20.0f;
+    const uint32_t samples = (uint32_t)(duration * sample_rate) + 2;
+    DeleteRigAnimation(anim);
+    anim.m_Duration = duration;
+    anim.m_SampleRate = sample_rate;
+    anim.m_Tracks.m_Count = m_AnimationSet->m_BoneList.m_Count;
+    anim.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[anim.m_Tracks.m_Count]();
+    for (uint32_t t = 0; t < anim.m_Tracks.m_Count; ++t)
+    {
+        dmRigDDF::AnimationTrack& track = anim.m_Tracks.m_Data[t];
+        track.m_BoneIndex = t;
+        track.m_Positions.m_Data = new float[samples * 3];
+        track.m_Positions.m_Count = samples * 3;
+        track.m_Rotations.m_Data = new float[samples * 4];
+        track.m_Rotations.m_Count = samples * 4;
+        track.m_Scale.m_Data = new float[samples * 3];
+        track.m_Scale.m_Count = samples * 3;
+        for (uint32_t i = 0; i < samples; ++i)
+        {
+            float time = dmMath::Min(i, samples - 2) / sample_rate;
+            Quat q = Quat::rotationZ(sinf(time * 0.5f + t) * (float)M_PI);
+            track.m_Positions.m_Data[i * 3 + 0] = cosf(time + t) * 10.0f;
+            track.m_Positions.m_Data[i * 3 + 1] = sinf(time * 2.0f) * 5.0f;
+            track.m_Positions.m_Data[i * 3 + 2] = 0.0f;
+            memcpy(&track.m_Rotations.m_Data[i * 4], &q, sizeof(float) * 4);
+            track.m_Scale.m_Data[i * 3 + 0] = 1.0f;
+            track.m_Scale.m_Data[i * 3 + 1] = 1.0f;
+            track.m_Scale.m_Data[i * 3 + 2] = 1.0f;
+        }
+    }
+
+    const uint32_t frames = 10000;
+    uint32_t raw_size = GetTestTrackSize(anim);
+    uint64_t raw_time = BenchTestSampling(m_Context, m_Instance, frames);
+
+    for (uint32_t t = 0; t < anim.m_Tracks.m_Count; ++t)
+    {
+        CompressTestTrack(anim.m_Tracks.m_Data[t], 0.001f);
+    }
+    uint32_t compressed_size = GetTestTrackSize(anim);
+    uint64_t compressed_time = BenchTestSampling(m_Context, m_Instance, frames);
+
+    printf("Track memory: %u bytes raw, %u bytes compressed (%.1f%% saved)\n", raw_size, compressed_size, 100.0f * (1.0f - compressed_size / (float)raw_size));
+    printf("Sampling: %.3f us raw, %.3f us compressed per update of %u tracks\n", raw_time / (float)frames, compressed_time / (float)frames, anim.m_Tracks.m_Count);
+    ASSERT_LT(compressed_size, raw_size);
+}
+
 TEST_F(RigInstanceTest, SetMesh)
 {
     ASSERT_EQ(dmRig::RESULT_OK, dmRig::SetMesh(m_Instance, dmHashString64("test")));
@@ -15,6 +15,7 @@
 #include <string.h>
 #include <dlib/array.h>
 #include <dlib/dstrings.h>
+#include <dlib/hash.h>
 #include <dlib/thread.h>
 #include <dlib/time.h>
 #include <dlib/message.h>
@@ -40,6 +41,8 @@ namespace dmHttpService
     const uint32_t DEFAULT_RESPONSE_BUFFER_SIZE = 64 * 1024;
     const uint32_t DEFAULT_HEADER_BUFFER_SIZE = 16 * 1024;
 
+    // Posted by a worker to the balancer when a request is done, with the worker index as user data
+    static const dmhash_t WORKER_DONE_HASH = dmHashString64("http_worker_done");
 
     struct HttpService;
 
@@ -58,6 +61,25 @@ namespace dmHttpService
         bool                  m_CacheFlusher;
         volatile bool         m_Run;
         int                   m_Canceled;
+        uint32_t              m_Index;
+
+        // Owned by the balancer thread
+        dmhash_t              m_HostHash;
+        bool                  m_Busy;
+    };
+
+    // A request waiting in the balancer for an idle worker
+    struct PendingRequest
+    {
+        dmMessage::URL  m_Sender;
+        dmMessage::URL  m_Receiver;
+        dmhash_t        m_Id;
+        uintptr_t       m_UserData1;
+        uintptr_t       m_UserData2;
+        uintptr_t       m_Descriptor;
+        dmhash_t        m_HostHash;
+        uint8_t*        m_Data;
+        uint32_t        m_DataSize;
     };
 
     struct HttpService
@@ -68,13 +90,16 @@ namespace dmHttpService
             m_Socket = 0;
             m_HttpCache = 0;
             m_LoadBalanceCount = 0;
+            m_MaxConnectionsPerHost = 0;
             m_Run = false;
         }
         dmArray<Worker*>          m_Workers;
+        dmArray<PendingRequest>   m_Pending;
         dmThread::Thread          m_Balancer;
         dmMessage::HSocket        m_Socket;
         dmHttpCache::HCache       m_HttpCache;
         int                       m_LoadBalanceCount;
+        uint32_t                  m_MaxConnectionsPerHost;
         volatile bool             m_Run;
     };
 
@@ -272,6 +297,11 @@ namespace dmHttpService
                 HandleRequest(worker, &message->m_Sender, 0, message->m_UserData2, request);
                 free((void*) request->m_Headers);
                 free((void*) request->m_Request);
+
+                dmMessage::URL balancer;
+                dmMessage::ResetURL(&balancer);
+                balancer.m_Socket = worker->m_Service->m_Socket;
+                dmMessage::Post(0, &balancer, WORKER_DONE_HASH, worker->m_Index, 0, 0, 0, 0, 0);
             }
             else if (message->m_Descriptor == (uintptr_t) dmHttpDDF::StopHttp::m_DDFDescriptor)
             {
@@ -299,12 +329,125 @@ namespace dmHttpService
         }
     }
 
+    static dmhash_t GetHostHash(const dmHttpDDF::HttpRequest* request)
+    {
+        const char* url_string = (const char*) ((uintptr_t) request + (uintptr_t) request->m_Url);
+        dmURI::Parts url;
+        if (dmURI::Parse(url_string, &url) != dmURI::RESULT_OK)
+            return 0;
+
+        // Same key as the connection reuse check in HandleRequest
+        HashState64 state;
+        dmHashInit64(&state, false);
+        dmHashUpdateBuffer64(&state, url.m_Scheme, strlen(url.m_Scheme));
+        dmHashUpdateBuffer64(&state, url.m_Hostname, strlen(url.m_Hostname));
+        dmHashUpdateBuffer64(&state, &url.m_Port, sizeof(url.m_Port));
+        return dmHashFinal64(&state);
+    }
+
+    static void FreePendingRequest(PendingRequest* pending)
+    {
+        dmHttpDDF::HttpRequest* request = (dmHttpDDF::HttpRequest*) pending->m_Data;
+        free((void*) request->m_Headers);
+        free((void*) request->m_Request);
+        free(pending->m_Data);
+    }
+
+    static uint32_t GetRequestsInFlight(const HttpService* service, dmhash_t host_hash)
+    {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < service->m_Workers.Size(); ++i)
+        {
+            const Worker* worker = service->m_Workers[i];
+            count += (worker->m_Busy && worker->m_HostHash == host_hash) ? 1 : 0;
+        }
+        return count;
+    }
+
+    // Prefer an idle worker that is already connected to the host, so the connection is reused
+    static Worker* GetIdleWorker(HttpService* service, dmhash_t host_hash)
+    {
+        Worker* idle = 0;
+        for (uint32_t i = 0; i < service->m_Workers.Size(); ++i)
+        {
+            Worker* worker = service->m_Workers[i];
+            if (worker->m_Busy)
+                continue;
+            if (worker->m_HostHash == host_hash)
+                return worker;
+            if (!idle)
+                idle = worker;
+        }
+        return idle;
+    }
+
+    // Hand out pending requests in order to idle workers. A request to a host that has reached the
+    // connection limit stays in the queue without holding up requests to other hosts.
+    static void Schedule(HttpService* service)
+    {
+        dmArray<PendingRequest>& pending = service->m_Pending;
+        uint32_t i = 0;
+        while (i < pending.Size())
+        {
+            PendingRequest* p = &pending[i];
+            if (service->m_MaxConnectionsPerHost != 0 && GetRequestsInFlight(service, p->m_HostHash) >= service->m_MaxConnectionsPerHost)
+            {
+                ++i;
+                continue;
+            }
+
+            Worker* worker = GetIdleWorker(service, p->m_HostHash);
+            if (!worker)
+                break;
+
+            dmMessage::URL receiver = p->m_Receiver;
+            receiver.m_Socket = worker->m_Socket;
+            dmMessage::Result r = dmMessage::Post(&p->m_Sender, &receiver, p->m_Id, p->m_UserData1, p->m_UserData2,
+                                                  p->m_Descriptor, p->m_Data, p->m_DataSize, 0);
+            if (r == dmMessage::RESULT_OK)
+            {
+                worker->m_Busy = true;
+                worker->m_HostHash = p->m_HostHash;
+                free(p->m_Data);
+            }
+            else
+            {
+                dmLogError("Failed to dispatch HTTP request (%d)", r);
+                FreePendingRequest(p);
+            }
+            memmove(pending.Begin() + i, pending.Begin() + i + 1, (pending.Size() - i - 1) * sizeof(PendingRequest));
+            pending.SetSize(pending.Size() - 1);
+        }
+    }
+
     void LoadBalance(dmMessage::Message *message, void* user_ptr)
     {
         HttpService* service = (HttpService*) user_ptr;
         if (message->m_Descriptor == (uintptr_t) dmHttpDDF::StopHttp::m_DDFDescriptor) {
             service->m_Run = false;
+        } else if (message->m_Id == WORKER_DONE_HASH) {
+            Worker* worker = service->m_Workers[message->m_UserData1];
+            worker->m_Busy = false;
+            Schedule(service);
+        } else if (message->m_Descriptor == (uintptr_t) dmHttpDDF::HttpRequest::m_DDFDescriptor) {
+            PendingRequest p;
+            p.m_Sender = message->m_Sender;
+            p.m_Receiver = message->m_Receiver;
+            p.m_Id = message->m_Id;
+            p.m_UserData1 = message->m_UserData1;
+            p.m_UserData2 = message->m_UserData2;
+            p.m_Descriptor = message->m_Descriptor;
+            p.m_HostHash = GetHostHash((const dmHttpDDF::HttpRequest*) message->m_Data);
+            p.m_DataSize = message->m_DataSize;
+            p.m_Data = (uint8_t*) malloc(message->m_DataSize);
+            memcpy(p.m_Data, message->m_Data, message->m_DataSize);
+
+            if (service->m_Pending.Full())
+                service->m_Pending.OffsetCapacity(64);
+            service->m_Pending.Push(p);
+            Schedule(service);
         } else {
+            // Let a worker report the unknown message
             dmMessage::URL r = message->m_Receiver;
             r.m_Socket = service->m_Workers[service->m_LoadBalanceCount % service->m_Workers.Size()]->m_Socket;
             dmMessage::Post(&message->m_Sender,
@@ -382,6 +525,7 @@ namespace dmHttpService
             threadcount = 2;
 #endif
 
+        service->m_MaxConnectionsPerHost = params->m_MaxConnectionsPerHost;
         service->m_Run = true;
         dmMessage::NewSocket(HTTP_SOCKET_NAME, &service->m_Socket);
         service->m_Workers.SetCapacity(threadcount);
@@ -399,6 +543,9 @@ namespace dmHttpService
             worker->m_CacheFlusher = i == 0 && worker->m_Service->m_HttpCache != 0;
             worker->m_Run = true;
             worker->m_Canceled = 0;
+            worker->m_Index = i;
+            worker->m_HostHash = 0;
+            worker->m_Busy = false;
             service->m_Workers.Push(worker);
 
             dmThread::Thread t = dmThread::New(&Loop, THREAD_STACK_SIZE, worker, "http");
@@ -425,6 +572,12 @@ namespace dmHttpService
         // Stop the balancer first, so we don't accept any new requests
         dmThread::Join(http_service->m_Balancer);
 
+        for (uint32_t i = 0; i < http_service->m_Pending.Size(); ++i)
+        {
+            FreePendingRequest(&http_service->m_Pending[i]);
+        }
+        http_service->m_Pending.SetSize(0);
+
         // Cancel them all first, as opposed to one-by-one
         for (uint32_t i = 0; i < http_service->m_Workers.Size(); ++i)
         {
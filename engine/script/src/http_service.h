@@ -19,14 +19,20 @@ namespace dmHttpService
 {
     typedef struct HttpService* HHttpService;
 
+    /// Largest value that fits Params::m_MaxConnectionsPerHost
+    const uint32_t MAX_CONNECTIONS_PER_HOST = 15;
+
     struct Params
     {
     	Params() :
     		m_ThreadCount(4),
-            m_UseHttpCache(1)
+            m_UseHttpCache(1),
+            m_MaxConnectionsPerHost(0)
     	{}
     	uint32_t m_ThreadCount:4;
         uint32_t m_UseHttpCache:1;
+        /// Max number of requests in flight to the same scheme, host and port. 0 means no limit other than the thread count
+        uint32_t m_MaxConnectionsPerHost:4;
     };
     HHttpService New(const Params* params);
     dmMessage::HSocket GetSocket(HHttpService http_service);
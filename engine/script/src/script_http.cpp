@@ -266,6 +266,13 @@ namespace dmScript
             if (config_file) {
                 params.m_ThreadCount = dmConfigFile::GetInt(config_file, "network.http_thread_count", params.m_ThreadCount);
                 params.m_UseHttpCache = dmConfigFile::GetInt(config_file, "network.http_cache_enabled", params.m_UseHttpCache);
+                int max_connections = dmConfigFile::GetInt(config_file, "network.http_max_connections_per_host", params.m_MaxConnectionsPerHost);
+                if (max_connections < 0 || max_connections > (int) dmHttpService::MAX_CONNECTIONS_PER_HOST) {
+                    int clamped = max_connections < 0 ? 0 : (int) dmHttpService::MAX_CONNECTIONS_PER_HOST;
+                    dmLogWarning("network.http_max_connections_per_host %d is out of range [0, %d], using %d", max_connections, dmHttpService::MAX_CONNECTIONS_PER_HOST, clamped);
+                    max_connections = clamped;
+                }
+                params.m_MaxConnectionsPerHost = max_connections;
             }
             g_Service = dmHttpService::New(&params);
             dmScript::RegisterDDFDecoder(dmHttpDDF::HttpResponse::m_DDFDescriptor, &HttpResponseDecoder);
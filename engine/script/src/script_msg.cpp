@@ -288,6 +288,10 @@ namespace dmScript
      * - `"."` the current game object
      * - `"#"` the current component
      *
+     * The returned URL is fully resolved. Posting to it skips all string parsing and path
+     * resolution, so creating the URLs a script posts to frequently once, e.g. in `init()`,
+     * is the fastest way to send messages.
+     *
      * @name msg.url
      * @param urlstring [type:string] string to create the url from
      * @return url [type:url] a new URL
@@ -654,6 +658,33 @@ namespace dmScript
         return url->m_SocketSize > 0 && url->m_PathSize > 0 && *url->m_Path == '/';
     }
 
+    // The resolved url only depends on the url string and the url of the current instance.
+    // Sockets are identified by their name hash, so entries stay valid when sockets are deleted.
+    static dmhash_t GetURLCacheKey(const char* url, uint32_t url_size, const dmMessage::URL& default_url)
+    {
+        HashState64 state;
+        dmHashInit64(&state, false);
+        dmHashUpdateBuffer64(&state, url, url_size);
+        dmHashUpdateBuffer64(&state, &default_url.m_Socket, sizeof(default_url.m_Socket));
+        dmHashUpdateBuffer64(&state, &default_url.m_Path, sizeof(default_url.m_Path));
+        dmHashUpdateBuffer64(&state, &default_url.m_Fragment, sizeof(default_url.m_Fragment));
+        return dmHashFinal64(&state);
+    }
+
+    static void PutCachedURL(lua_State* L, dmhash_t cache_key, const dmMessage::URL& url)
+    {
+        if (cache_key == 0)
+        {
+            return;
+        }
+        HContext context = GetScriptContext(L);
+        if (context->m_URLCache.Full())
+        {
+            context->m_URLCache.Clear();
+        }
+        context->m_URLCache.Put(cache_key, url);
+    }
+
     int ResolveURL(lua_State* L, int index, dmMessage::URL* out_url, dmMessage::URL* out_default_url)
     {
         if (dmScript::IsURL(L, index))
@@ -667,16 +698,40 @@ namespace dmScript
         }
         else
         {
-
             const char* url = 0;
+            size_t url_size = 0;
+            dmhash_t cache_key = 0;
+            dmMessage::URL default_url;
+            dmMessage::ResetURL(&default_url);
+            if (lua_type(L, index) == LUA_TSTRING)
+            {
+                // The same handful of literal url strings are typically resolved over and over
+                // by the same script instance, so the result is cached per string and instance url
+                url = lua_tolstring(L, index, &url_size);
+                GetURL(L, &default_url);
+                if (out_default_url != 0x0)
+                {
+                    *out_default_url = default_url;
+                }
+                cache_key = GetURLCacheKey(url, url_size, default_url);
+                HContext context = GetScriptContext(L);
+                dmMessage::URL* cached_url = context->m_URLCache.Get(cache_key);
+                if (cached_url != 0x0)
+                {
+                    *out_url = *cached_url;
+                    return 0;
+                }
+            }
+            else if (lua_isstring(L, index))
+            {
+                url = lua_tolstring(L, index, &url_size);
+            }
+
             dmMessage::StringURL string_url;
-            dmMessage::Result parse_url_result;
-            if (lua_isstring(L, index))
+            if (url != 0)
             {
                 // Make sure we get and parse the url only once
-                url = lua_tostring(L, index);
-                parse_url_result = dmMessage::ParseURL(url, &string_url);
-                if (parse_url_result != dmMessage::RESULT_OK)
+                if (dmMessage::ParseURL(url, &string_url) != dmMessage::RESULT_OK)
                 {
                     url = 0;
                 }
@@ -685,44 +740,43 @@ namespace dmScript
             // Initial check for global urls to avoid resolving etc
             if (url != 0)
             {
-                if (parse_url_result == dmMessage::RESULT_OK)
+                if (IsURLGlobal(&string_url))
                 {
-                    if (IsURLGlobal(&string_url))
+                    char socket_name[64];
+                    if (string_url.m_SocketSize >= sizeof(socket_name))
+                        return dmMessage::RESULT_INVALID_SOCKET_NAME;
+                    dmStrlCpy(socket_name, string_url.m_Socket, dmMath::Min(string_url.m_SocketSize+1, (unsigned int) sizeof(socket_name)));
+                    dmMessage::HSocket socket;
+                    dmMessage::Result result = dmMessage::GetSocket(socket_name, &socket);
+                    switch (result)
                     {
-                        char socket_name[64];
-                        if (string_url.m_SocketSize >= sizeof(socket_name))
-                            return dmMessage::RESULT_INVALID_SOCKET_NAME;
-                        dmStrlCpy(socket_name, string_url.m_Socket, dmMath::Min(string_url.m_SocketSize+1, (unsigned int) sizeof(socket_name)));
-                        dmMessage::HSocket socket;
-                        dmMessage::Result result = dmMessage::GetSocket(socket_name, &socket);
-                        switch (result)
-                        {
-                            case dmMessage::RESULT_OK:
-                            case dmMessage::RESULT_NAME_OK_SOCKET_NOT_FOUND:
-                                out_url->m_Socket = socket;
-                                out_url->m_Path = dmHashBuffer64(string_url.m_Path, string_url.m_PathSize);
-                                out_url->m_Fragment = dmHashBuffer64(string_url.m_Fragment, string_url.m_FragmentSize);
-                                if (out_default_url != 0x0)
-                                {
-                                    dmMessage::ResetURL(out_default_url);
-                                    GetURL(L, out_default_url);
-                                }
-                                return 0;
-                            case dmMessage::RESULT_INVALID_SOCKET_NAME:
-                                return luaL_error(L, "The socket '%s' name is invalid.", socket_name);
-                            default:
-                                return luaL_error(L, "Error when checking socket '%s': %d.", socket_name, result);
-                        }
+                        case dmMessage::RESULT_OK:
+                        case dmMessage::RESULT_NAME_OK_SOCKET_NOT_FOUND:
+                            out_url->m_Socket = socket;
+                            out_url->m_Path = dmHashBuffer64(string_url.m_Path, string_url.m_PathSize);
+                            out_url->m_Fragment = dmHashBuffer64(string_url.m_Fragment, string_url.m_FragmentSize);
+                            if (out_default_url != 0x0 && cache_key == 0)
+                            {
+                                dmMessage::ResetURL(out_default_url);
+                                GetURL(L, out_default_url);
+                            }
+                            PutCachedURL(L, cache_key, *out_url);
+                            return 0;
+                        case dmMessage::RESULT_INVALID_SOCKET_NAME:
+                            return luaL_error(L, "The socket '%s' name is invalid.", socket_name);
+                        default:
+                            return luaL_error(L, "Error when checking socket '%s': %d.", socket_name, result);
                     }
                 }
             }
-            // Fetch default URL from the lua state
-            dmMessage::URL default_url;
-            dmMessage::ResetURL(&default_url);
-            GetURL(L, &default_url);
-            if (out_default_url != 0x0)
+            // Fetch default URL from the lua state, unless it was already fetched for the cache lookup
+            if (cache_key == 0)
             {
-                *out_default_url = default_url;
+                GetURL(L, &default_url);
+                if (out_default_url != 0x0)
+                {
+                    *out_default_url = default_url;
+                }
             }
             // Check for the URL representation (nil, string, url, hash) at index
             if (lua_gettop(L) < index || lua_isnil(L, index))
@@ -732,11 +786,7 @@ namespace dmScript
             else if (url != 0)
             {
                 dmMessage::ResetURL(out_url);
-                dmMessage::Result result = parse_url_result;
-                if (parse_url_result == dmMessage::RESULT_OK)
-                {
-                    result = ResolveURL(L, url, out_url, &default_url);
-                }
+                dmMessage::Result result = ResolveURL(L, url, out_url, &default_url);
                 if (result != dmMessage::RESULT_OK)
                 {
                     switch (result)
@@ -751,6 +801,7 @@ namespace dmScript
                         return luaL_error(L, "Error when resolving the URL '%s': %d.", url, result);
                     }
                 }
+                PutCachedURL(L, cache_key, *out_url);
             }
             else if (IsHash(L, index))
             {
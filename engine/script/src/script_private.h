@@ -71,6 +71,7 @@ namespace dmScript
         dmHashTable64<Module>       m_Modules;
         dmHashTable64<Module*>      m_PathToModule;
         dmHashTable64<int>          m_HashInstances;
+        dmHashTable64<dmMessage::URL> m_URLCache;
         dmArray<HScriptExtension>   m_ScriptExtensions;
         lua_State*                  m_LuaState;
         int                         m_ContextTableRef;
@@ -14,6 +14,7 @@
 #include "script_timer_private.h"
 
 #include <string.h>
+#include <algorithm>
 #include <dlib/index_pool.h>
 #include <dlib/hashtable.h>
 #include <dlib/profile.h>
@@ -37,14 +38,21 @@ namespace dmScript
      */
 
     /*
-        The timers are stored in a flat array with no holes which we scan sequenctially on each update.
+        The timers are stored in a flat array with no holes.
 
         When a timer is removed the last timer in the list may change location (EraseSwap).
 
-        This is to keep the array sweep fast and handle cases where multiple short lived timers are
-        created followed by one long-lived timer. If we did not re-shuffle and keep holes we would keep
-        scanning the array to the end where the only live timer exists skipping all the holes.
-        How much of an issue this is guesswork at this point.
+        To avoid visiting every timer on each update the live timers are also kept in a binary min-heap
+        ordered on the absolute time at which they trigger. The timer world keeps a running time which is
+        advanced by dt in UpdateTimers, and only timers at the top of the heap whose trigger time has passed
+        are visited. Long delay timers (respawns, cooldowns) therefore cost nothing until they trigger.
+
+        The heap references timers by their lookup index so it is not affected when timers are moved
+        in the flat array, and each timer keeps its position in the heap so it can be removed directly
+        when cancelled or killed.
+
+        Timers that trigger during the same update are called in the order they are stored in the flat
+        array, same as when the whole array was scanned.
 
         The timer identity is an index into an indirection layer combined with a generation counter,
         this makes it possible to reuse the index for the indirection layer without risk of using
@@ -64,19 +72,22 @@ namespace dmScript
         uintptr_t       m_Owner;
         uintptr_t       m_UserData;
 
+        // The timer world time at which the timer fires
+        double          m_TriggerTime;
+
         // Store complete timer handle with generation here to identify stale timer handles
         HTimer          m_Handle;
 
-        // How much time remaining until the timer fires
-        float           m_Remaining;
-
         // The timer delay, we need to keep this for repeating timers
         float           m_Delay;
 
+        // Position in the trigger heap, INVALID_TIMER_LOOKUP_INDEX if not scheduled
+        uint16_t        m_HeapIndex;
+
         // Flag if the timer should repeat
-        uint32_t        m_Repeat : 1;
+        uint16_t        m_Repeat : 1;
         // Flag if the timer is alive
-        uint32_t        m_IsAlive : 1;
+        uint16_t        m_IsAlive : 1;
     };
 
     #define INVALID_TIMER_LOOKUP_INDEX  0xffffu
@@ -89,6 +100,10 @@ namespace dmScript
         dmArray<Timer>                      m_Timers;
         dmArray<uint16_t>                   m_IndexLookup;
         dmIndexPool<uint16_t>               m_IndexPool;
+        dmArray<uint16_t>                   m_TriggerHeap;  // Lookup indexes of scheduled timers, min-heap on m_TriggerTime
+        dmArray<uint16_t>                   m_Triggered;    // Scratch buffer with the timer indexes triggered in UpdateTimers
+        double                              m_Time;
+        uint16_t                            m_DeadCount; // Timers that died during UpdateTimers and are freed at the end of it
         uint16_t                            m_Version;   // Incremented to avoid collisions each time we push timer indexes back to the m_IndexPool
         uint16_t                            m_InUpdate : 1;
     };
@@ -103,6 +118,90 @@ namespace dmScript
         return (((uint32_t)generation) << 16) | (lookup_index);
     }
 
+    static Timer& GetHeapTimer(HTimerWorld timer_world, uint32_t heap_index)
+    {
+        return timer_world->m_Timers[timer_world->m_IndexLookup[timer_world->m_TriggerHeap[heap_index]]];
+    }
+
+    static void SetHeapEntry(HTimerWorld timer_world, uint32_t heap_index, uint16_t lookup_index)
+    {
+        timer_world->m_TriggerHeap[heap_index] = lookup_index;
+        timer_world->m_Timers[timer_world->m_IndexLookup[lookup_index]].m_HeapIndex = (uint16_t)heap_index;
+    }
+
+    static void SiftUp(HTimerWorld timer_world, uint32_t heap_index)
+    {
+        uint16_t lookup_index = timer_world->m_TriggerHeap[heap_index];
+        double trigger_time = timer_world->m_Timers[timer_world->m_IndexLookup[lookup_index]].m_TriggerTime;
+        while (heap_index > 0)
+        {
+            uint32_t parent = (heap_index - 1) / 2;
+            if (GetHeapTimer(timer_world, parent).m_TriggerTime <= trigger_time)
+            {
+                break;
+            }
+            SetHeapEntry(timer_world, heap_index, timer_world->m_TriggerHeap[parent]);
+            heap_index = parent;
+        }
+        SetHeapEntry(timer_world, heap_index, lookup_index);
+    }
+
+    static void SiftDown(HTimerWorld timer_world, uint32_t heap_index)
+    {
+        uint32_t size = timer_world->m_TriggerHeap.Size();
+        uint16_t lookup_index = timer_world->m_TriggerHeap[heap_index];
+        double trigger_time = timer_world->m_Timers[timer_world->m_IndexLookup[lookup_index]].m_TriggerTime;
+        while (true)
+        {
+            uint32_t child = heap_index * 2 + 1;
+            if (child >= size)
+            {
+                break;
+            }
+            if (child + 1 < size && GetHeapTimer(timer_world, child + 1).m_TriggerTime < GetHeapTimer(timer_world, child).m_TriggerTime)
+            {
+                ++child;
+            }
+            if (trigger_time <= GetHeapTimer(timer_world, child).m_TriggerTime)
+            {
+                break;
+            }
+            SetHeapEntry(timer_world, heap_index, timer_world->m_TriggerHeap[child]);
+            heap_index = child;
+        }
+        SetHeapEntry(timer_world, heap_index, lookup_index);
+    }
+
+    static void ScheduleTimer(HTimerWorld timer_world, Timer& timer)
+    {
+        assert(timer.m_HeapIndex == INVALID_TIMER_LOOKUP_INDEX);
+        uint32_t heap_index = timer_world->m_TriggerHeap.Size();
+        timer_world->m_TriggerHeap.Push(GetLookupIndex(timer.m_Handle));
+        timer.m_HeapIndex = (uint16_t)heap_index;
+        SiftUp(timer_world, heap_index);
+    }
+
+    static void UnscheduleTimer(HTimerWorld timer_world, Timer& timer)
+    {
+        uint32_t heap_index = timer.m_HeapIndex;
+        if (heap_index == INVALID_TIMER_LOOKUP_INDEX)
+        {
+            return;
+        }
+        timer.m_HeapIndex = INVALID_TIMER_LOOKUP_INDEX;
+
+        uint32_t last_index = timer_world->m_TriggerHeap.Size() - 1;
+        uint16_t last_lookup_index = timer_world->m_TriggerHeap[last_index];
+        timer_world->m_TriggerHeap.SetSize(last_index);
+        if (heap_index == last_index)
+        {
+            return;
+        }
+        SetHeapEntry(timer_world, heap_index, last_lookup_index);
+        SiftUp(timer_world, heap_index);
+        SiftDown(timer_world, timer_world->m_Timers[timer_world->m_IndexLookup[last_lookup_index]].m_HeapIndex);
+    }
+
     static Timer* AllocateTimer(HTimerWorld timer_world, uintptr_t owner)
     {
         assert(timer_world != 0x0);
@@ -130,12 +229,14 @@ namespace dmScript
             uint32_t capacity = timer_world->m_Timers.Capacity();
             capacity = dmMath::Min(capacity + TIMER_CAPACITY_GROWTH, MAX_TIMER_CAPACITY);
             timer_world->m_Timers.SetCapacity(capacity);
+            timer_world->m_TriggerHeap.SetCapacity(capacity);
         }
 
         timer_world->m_Timers.SetSize(timer_count + 1);
         Timer& timer = timer_world->m_Timers[timer_count];
         timer.m_Handle = handle;
         timer.m_Owner = owner;
+        timer.m_HeapIndex = INVALID_TIMER_LOOKUP_INDEX;
 
         uint16_t lookup_index = GetLookupIndex(handle);
 
@@ -161,6 +262,8 @@ namespace dmScript
         assert(timer_world != 0x0);
         assert(timer.m_IsAlive == 0);
 
+        UnscheduleTimer(timer_world, timer);
+
         uint16_t lookup_index = GetLookupIndex(timer.m_Handle);
         uint16_t timer_index = timer_world->m_IndexLookup[lookup_index];
         timer_world->m_IndexPool.Push(lookup_index);
@@ -176,6 +279,9 @@ namespace dmScript
         timer_world->m_IndexLookup.SetSize(INITIAL_TIMER_CAPACITY);
         memset(&timer_world->m_IndexLookup[0], 0u, INITIAL_TIMER_CAPACITY * sizeof(uint16_t));
         timer_world->m_IndexPool.SetCapacity(INITIAL_TIMER_CAPACITY);
+        timer_world->m_TriggerHeap.SetCapacity(INITIAL_TIMER_CAPACITY);
+        timer_world->m_Time = 0.0;
+        timer_world->m_DeadCount = 0;
         timer_world->m_Version = 0;
         timer_world->m_InUpdate = 0;
         return timer_world;
@@ -193,34 +299,55 @@ namespace dmScript
         DM_PROFILE(TimerWorld, "Update");
 
         timer_world->m_InUpdate = 1;
+        timer_world->m_Time += dt;
+        const double time = timer_world->m_Time;
 
-        // We only scan timers for trigger if the timer *existed at entry to UpdateTimers*, any timers added
-        // in a trigger callback will always be added at the end of m_Timers and not triggered in this scope.
         uint32_t size = timer_world->m_Timers.Size();
         DM_COUNTER("timerc", size);
 
-        for (uint32_t i = 0; i < size; ++i)
+        // We only trigger timers that *existed at entry to UpdateTimers*. All due timers are taken out of
+        // the heap before any callback is called, so timers added in a trigger callback are not triggered
+        // in this scope even if they have a zero delay.
+        dmArray<uint16_t>& triggered = timer_world->m_Triggered;
+        triggered.SetSize(0);
+        if (triggered.Capacity() < size)
         {
-            Timer* timer = &timer_world->m_Timers[i];
-            if (timer->m_IsAlive == 0)
+            triggered.SetCapacity(size);
+        }
+        while (!timer_world->m_TriggerHeap.Empty())
+        {
+            Timer& timer = GetHeapTimer(timer_world, 0);
+            if (timer.m_TriggerTime > time)
             {
-                continue;
+                break;
             }
+            triggered.Push(timer_world->m_IndexLookup[GetLookupIndex(timer.m_Handle)]);
+            UnscheduleTimer(timer_world, timer);
+        }
 
-            timer->m_Remaining -= dt;
-            if (timer->m_Remaining > 0.0f)
+        // Timers are not moved in m_Timers during the update, so the indexes stay valid and give the same
+        // trigger order as a sequential scan of m_Timers
+        std::sort(triggered.Begin(), triggered.End());
+
+        uint32_t triggered_count = triggered.Size();
+        for (uint32_t i = 0; i < triggered_count; ++i)
+        {
+            uint32_t timer_index = triggered[i];
+            Timer* timer = &timer_world->m_Timers[timer_index];
+            if (timer->m_IsAlive == 0)
             {
                 continue;
             }
 
-            float elapsed_time = timer->m_Delay - timer->m_Remaining;
+            float remaining = (float)(timer->m_TriggerTime - time);
+            float elapsed_time = timer->m_Delay - remaining;
 
             TimerEventType eventType = timer->m_Repeat == 0 ? TIMER_EVENT_TRIGGER_WILL_DIE : TIMER_EVENT_TRIGGER_WILL_REPEAT;
 
             timer->m_Callback(timer_world, eventType, timer->m_Handle, elapsed_time, timer->m_Owner, timer->m_UserData);
 
             // The array might have been reallocated here! So grab the pointer again...
-            timer = &timer_world->m_Timers[i];
+            timer = &timer_world->m_Timers[timer_index];
 
             if (timer->m_IsAlive == 0)
             {
@@ -230,44 +357,50 @@ namespace dmScript
             if (timer->m_Repeat == 0)
             {
                 timer->m_IsAlive = 0;
+                ++timer_world->m_DeadCount;
                 continue;
             }
 
             if (timer->m_Delay == 0.0f)
             {
-                timer->m_Remaining = 0.0f;
+                timer->m_TriggerTime = time;
+                ScheduleTimer(timer_world, *timer);
                 continue;
             }
 
-            float wrapped_count = ((-timer->m_Remaining) / timer->m_Delay) + 1.f;
+            float wrapped_count = ((-remaining) / timer->m_Delay) + 1.f;
             float offset_to_next_trigger  = floor(wrapped_count) * timer->m_Delay;
-            timer->m_Remaining += offset_to_next_trigger;
-            assert(timer->m_Remaining >= 0.f);
+            remaining += offset_to_next_trigger;
+            assert(remaining >= 0.f);
+            timer->m_TriggerTime = time + remaining;
+            ScheduleTimer(timer_world, *timer);
         }
 
         timer_world->m_InUpdate = 0;
 
-        size = timer_world->m_Timers.Size();
-        uint32_t original_size = size;
+        // Only look for the dead timers when some died this update
+        if (timer_world->m_DeadCount == 0)
+        {
+            return;
+        }
+
         uint32_t i = 0;
-        while (i < size)
+        while (timer_world->m_DeadCount > 0 && i < timer_world->m_Timers.Size())
         {
             Timer& timer = timer_world->m_Timers[i];
             if (timer.m_IsAlive == 0)
             {
                 FreeTimer(timer_world, timer);
-                --size;
+                --timer_world->m_DeadCount;
             }
             else
             {
                 ++i;
             }
         }
+        assert(timer_world->m_DeadCount == 0);
 
-        if (size != original_size)
-        {
-            ++timer_world->m_Version;
-        }
+        ++timer_world->m_Version;
     }
 
     HTimer AddTimer(HTimerWorld timer_world,
@@ -287,11 +420,12 @@ namespace dmScript
         }
 
         timer->m_Delay = delay;
-        timer->m_Remaining = delay;
+        timer->m_TriggerTime = timer_world->m_Time + delay;
         timer->m_UserData = userdata;
         timer->m_Callback = timer_callback;
         timer->m_Repeat = repeat;
         timer->m_IsAlive = 1;
+        ScheduleTimer(timer_world, *timer);
 
         return timer->m_Handle;
     }
@@ -323,6 +457,7 @@ namespace dmScript
         }
 
         timer.m_IsAlive = 0;
+        UnscheduleTimer(timer_world, timer);
         timer.m_Callback(timer_world, TIMER_EVENT_CANCELLED, timer.m_Handle, 0.f, timer.m_Owner, timer.m_UserData);
 
         if (timer_world->m_InUpdate == 0)
@@ -330,6 +465,10 @@ namespace dmScript
             FreeTimer(timer_world, timer);
             ++timer_world->m_Version;
         }
+        else
+        {
+            ++timer_world->m_DeadCount;
+        }
         return true;
     }
 
@@ -349,12 +488,17 @@ namespace dmScript
                 continue;
             }
 
-            if (timer.m_IsAlive == 1)
+            // Dead timers only remain during UpdateTimers, where they were counted when they died
+            if (timer.m_IsAlive == 0)
             {
-                timer.m_IsAlive = 0;
-                ++cancelled_count;
+                ++timer_index;
+                continue;
             }
 
+            timer.m_IsAlive = 0;
+            UnscheduleTimer(timer_world, timer);
+            ++cancelled_count;
+
             if (timer_world->m_InUpdate == 0)
             {
                 FreeTimer(timer_world, timer);
@@ -362,6 +506,7 @@ namespace dmScript
             }
             else
             {
+                ++timer_world->m_DeadCount;
                 ++timer_index;
             }
         }
@@ -2265,6 +2265,309 @@ namespace dmScript
         return 1;
     }
 
+    /*# adds two vectors into an existing vector
+     *
+     * Adds two vectors of the same type and stores the result in the
+     * supplied output vector instead of allocating a new one. The output
+     * vector may be one of the arguments.
+     *
+     * [icon:attention] The output vector is modified in place, which is visible
+     * through every reference to it. Use this function for temporaries in
+     * hot paths such as `update()` to reduce garbage collection pressure.
+     *
+     * @name vmath.add_into
+     * @param out [type:vector3|vector4] vector to store the result in
+     * @param v1 [type:vector3|vector4] first vector
+     * @param v2 [type:vector3|vector4] second vector
+     * @return out [type:vector3|vector4] the output vector
+     * @examples
+     *
+     * ```lua
+     * function update(self, dt)
+     *     vmath.add_into(self.pos, self.pos, self.velocity)
+     * end
+     * ```
+     */
+    static int AddInto(lua_State* L)
+    {
+        const ScriptUserType type = GetType(L, 1);
+        if (type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vectormath::Aos::Vector3* out = (Vectormath::Aos::Vector3*)lua_touserdata(L, 1);
+            *out = *CheckVector3(L, 2) + *CheckVector3(L, 3);
+        }
+        else if (type == SCRIPT_TYPE_VECTOR4)
+        {
+            Vectormath::Aos::Vector4* out = (Vectormath::Aos::Vector4*)lua_touserdata(L, 1);
+            *out = *CheckVector4(L, 2) + *CheckVector4(L, 3);
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts (%s|%s) as arguments.", SCRIPT_LIB_NAME, "add_into", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4);
+        }
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    /*# subtracts two vectors into an existing vector
+     *
+     * Subtracts the second vector from the first and stores the result in the
+     * supplied output vector instead of allocating a new one. The output
+     * vector may be one of the arguments.
+     *
+     * @name vmath.sub_into
+     * @param out [type:vector3|vector4] vector to store the result in
+     * @param v1 [type:vector3|vector4] vector to subtract from
+     * @param v2 [type:vector3|vector4] vector to subtract
+     * @return out [type:vector3|vector4] the output vector
+     * @examples
+     *
+     * ```lua
+     * vmath.sub_into(self.dir, target_pos, self.pos)
+     * ```
+     */
+    static int SubInto(lua_State* L)
+    {
+        const ScriptUserType type = GetType(L, 1);
+        if (type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vectormath::Aos::Vector3* out = (Vectormath::Aos::Vector3*)lua_touserdata(L, 1);
+            *out = *CheckVector3(L, 2) - *CheckVector3(L, 3);
+        }
+        else if (type == SCRIPT_TYPE_VECTOR4)
+        {
+            Vectormath::Aos::Vector4* out = (Vectormath::Aos::Vector4*)lua_touserdata(L, 1);
+            *out = *CheckVector4(L, 2) - *CheckVector4(L, 3);
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts (%s|%s) as arguments.", SCRIPT_LIB_NAME, "sub_into", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4);
+        }
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    /*# scales a vector into an existing vector
+     *
+     * Multiplies a vector by a number and stores the result in the
+     * supplied output vector instead of allocating a new one. The output
+     * vector may be the same as the input vector.
+     *
+     * @name vmath.mul_into
+     * @param out [type:vector3|vector4] vector to store the result in
+     * @param v1 [type:vector3|vector4] vector to scale
+     * @param s [type:number] scale factor
+     * @return out [type:vector3|vector4] the output vector
+     * @examples
+     *
+     * ```lua
+     * vmath.mul_into(self.velocity, self.velocity, 0.98)
+     * ```
+     */
+    static int MulInto(lua_State* L)
+    {
+        const ScriptUserType type = GetType(L, 1);
+        float s = (float) luaL_checknumber(L, 3);
+        if (type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vectormath::Aos::Vector3* out = (Vectormath::Aos::Vector3*)lua_touserdata(L, 1);
+            *out = *CheckVector3(L, 2) * s;
+        }
+        else if (type == SCRIPT_TYPE_VECTOR4)
+        {
+            Vectormath::Aos::Vector4* out = (Vectormath::Aos::Vector4*)lua_touserdata(L, 1);
+            *out = *CheckVector4(L, 2) * s;
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts (%s|%s) as arguments.", SCRIPT_LIB_NAME, "mul_into", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4);
+        }
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    /*# adds a scaled vector into an existing vector
+     *
+     * Calculates `v1 + v2 * s` and stores the result in the supplied output
+     * vector instead of allocating a new one. This is the typical
+     * "integrate velocity" operation and replaces two temporary vectors.
+     *
+     * @name vmath.madd_into
+     * @param out [type:vector3|vector4] vector to store the result in
+     * @param v1 [type:vector3|vector4] vector to add to
+     * @param v2 [type:vector3|vector4] vector to scale and add
+     * @param s [type:number] scale factor for the second vector
+     * @return out [type:vector3|vector4] the output vector
+     * @examples
+     *
+     * ```lua
+     * function update(self, dt)
+     *     vmath.madd_into(self.pos, self.pos, self.velocity, dt)
+     *     go.set_position(self.pos)
+     * end
+     * ```
+     */
+    static int MaddInto(lua_State* L)
+    {
+        const ScriptUserType type = GetType(L, 1);
+        float s = (float) luaL_checknumber(L, 4);
+        if (type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vectormath::Aos::Vector3* out = (Vectormath::Aos::Vector3*)lua_touserdata(L, 1);
+            *out = *CheckVector3(L, 2) + *CheckVector3(L, 3) * s;
+        }
+        else if (type == SCRIPT_TYPE_VECTOR4)
+        {
+            Vectormath::Aos::Vector4* out = (Vectormath::Aos::Vector4*)lua_touserdata(L, 1);
+            *out = *CheckVector4(L, 2) + *CheckVector4(L, 3) * s;
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts (%s|%s) as arguments.", SCRIPT_LIB_NAME, "madd_into", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4);
+        }
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    /*# normalizes a vector into an existing vector
+     *
+     * Normalizes a vector and stores the result in the supplied output vector
+     * instead of allocating a new one.
+     *
+     * @name vmath.normalize_into
+     * @param out [type:vector3|vector4|quat] vector to store the result in
+     * @param v1 [type:vector3|vector4|quat] vector to normalize
+     * @return out [type:vector3|vector4|quat] the output vector
+     * @examples
+     *
+     * ```lua
+     * vmath.normalize_into(self.dir, self.dir)
+     * ```
+     */
+    static int NormalizeInto(lua_State* L)
+    {
+        const ScriptUserType type = GetType(L, 1);
+        if (type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vectormath::Aos::Vector3* out = (Vectormath::Aos::Vector3*)lua_touserdata(L, 1);
+            *out = Vectormath::Aos::normalize(*CheckVector3(L, 2));
+        }
+        else if (type == SCRIPT_TYPE_VECTOR4)
+        {
+            Vectormath::Aos::Vector4* out = (Vectormath::Aos::Vector4*)lua_touserdata(L, 1);
+            *out = Vectormath::Aos::normalize(*CheckVector4(L, 2));
+        }
+        else if (type == SCRIPT_TYPE_QUAT)
+        {
+            Vectormath::Aos::Quat* out = (Vectormath::Aos::Quat*)lua_touserdata(L, 1);
+            *out = Vectormath::Aos::normalize(*CheckQuat(L, 2));
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts (%s|%s|%s) as arguments.", SCRIPT_LIB_NAME, "normalize_into", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4, SCRIPT_TYPE_NAME_QUAT);
+        }
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    /*# lerps between two vectors into an existing vector
+     *
+     * Linearly interpolates between two vectors and stores the result in the
+     * supplied output vector instead of allocating a new one.
+     *
+     * [icon:attention] The function does not clamp t between 0 and 1.
+     *
+     * @name vmath.lerp_into
+     * @param out [type:vector3|vector4] vector to store the result in
+     * @param t [type:number] interpolation parameter, 0-1
+     * @param v1 [type:vector3|vector4] vector to lerp from
+     * @param v2 [type:vector3|vector4] vector to lerp to
+     * @return out [type:vector3|vector4] the output vector
+     * @examples
+     *
+     * ```lua
+     * vmath.lerp_into(self.pos, self.t, self.start_pos, self.end_pos)
+     * ```
+     */
+    static int LerpInto(lua_State* L)
+    {
+        const ScriptUserType type = GetType(L, 1);
+        float t = (float) luaL_checknumber(L, 2);
+        if (type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vectormath::Aos::Vector3* out = (Vectormath::Aos::Vector3*)lua_touserdata(L, 1);
+            *out = Vectormath::Aos::lerp(t, *CheckVector3(L, 3), *CheckVector3(L, 4));
+        }
+        else if (type == SCRIPT_TYPE_VECTOR4)
+        {
+            Vectormath::Aos::Vector4* out = (Vectormath::Aos::Vector4*)lua_touserdata(L, 1);
+            *out = Vectormath::Aos::lerp(t, *CheckVector4(L, 3), *CheckVector4(L, 4));
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts (%s|%s) as arguments.", SCRIPT_LIB_NAME, "lerp_into", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4);
+        }
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    /*# adds scaled vectors to an array of vectors
+     *
+     * Batch version of [ref:vmath.madd_into]. For each index `i` in the
+     * array `out`, calculates `v1[i] + v2[i] * s` and stores the result in
+     * `out[i]`. All work is done in a single call without allocating any
+     * vectors. The arrays must contain vectors of the same type and `v1` and
+     * `v2` must be at least as long as `out`. `out` may be the same table as
+     * `v1`.
+     *
+     * @name vmath.madd_batch
+     * @param out [type:table] array of vector3 or vector4 to store the results in
+     * @param v1 [type:table] array of vectors to add to
+     * @param v2 [type:table] array of vectors to scale and add
+     * @param s [type:number] scale factor for the vectors in the second array
+     * @return out [type:table] the output array
+     * @examples
+     *
+     * ```lua
+     * function update(self, dt)
+     *     vmath.madd_batch(self.positions, self.positions, self.velocities, dt)
+     * end
+     * ```
+     */
+    static int MaddBatch(lua_State* L)
+    {
+        luaL_checktype(L, 1, LUA_TTABLE);
+        luaL_checktype(L, 2, LUA_TTABLE);
+        luaL_checktype(L, 3, LUA_TTABLE);
+        float s = (float) luaL_checknumber(L, 4);
+
+        const int count = (int) lua_objlen(L, 1);
+        for (int i = 1; i <= count; ++i)
+        {
+            lua_rawgeti(L, 1, i);
+            lua_rawgeti(L, 2, i);
+            lua_rawgeti(L, 3, i);
+            const ScriptUserType type = GetType(L, -3);
+            if (type == SCRIPT_TYPE_VECTOR3)
+            {
+                Vectormath::Aos::Vector3* out = (Vectormath::Aos::Vector3*)lua_touserdata(L, -3);
+                *out = *CheckVector3(L, -2) + *CheckVector3(L, -1) * s;
+            }
+            else if (type == SCRIPT_TYPE_VECTOR4)
+            {
+                Vectormath::Aos::Vector4* out = (Vectormath::Aos::Vector4*)lua_touserdata(L, -3);
+                *out = *CheckVector4(L, -2) + *CheckVector4(L, -1) * s;
+            }
+            else
+            {
+                return luaL_error(L, "%s.%s expects arrays of (%s|%s), got another type at index %d.", SCRIPT_LIB_NAME, "madd_batch", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4, i);
+            }
+            lua_pop(L, 3);
+        }
+        lua_settop(L, 1);
+        return 1;
+    }
+
     static const luaL_reg methods[] =
     {
         {SCRIPT_TYPE_NAME_VECTOR, Vector_new},
@@ -2301,6 +2604,13 @@ namespace dmScript
         {"inv", Inverse},
         {"ortho_inv", OrthoInverse},
         {"mul_per_elem", MulPerElem},
+        {"add_into", AddInto},
+        {"sub_into", SubInto},
+        {"mul_into", MulInto},
+        {"madd_into", MaddInto},
+        {"normalize_into", NormalizeInto},
+        {"lerp_into", LerpInto},
+        {"madd_batch", MaddBatch},
         {0, 0}
     };
 
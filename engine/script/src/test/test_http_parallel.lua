@@ -0,0 +1,46 @@
+-- Copyright 2020 The Defold Foundation
+-- Licensed under the Defold License version 1.0 (the "License"); you may not use
+-- this file except in compliance with the License.
+-- 
+-- You may obtain a copy of the License, together with FAQs at
+-- https://www.defold.com/license
+-- 
+-- Unless required by applicable law or agreed to in writing, software distributed
+-- under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+-- CONDITIONS OF ANY KIND, either express or implied. See the License for the
+-- specific language governing permissions and limitations under the License.
+
+
+requests_left = 0
+fast_requests_done = 0
+
+-- NOTE: A slow request must not hold up the requests posted after it, even when
+-- there are more requests than http worker threads
+
+function test_http_parallel()
+    local headers = {}
+    headers['X-A'] = 'Defold'
+    headers['X-B'] = '!'
+
+    http.request("http://127.0.0.1:" .. PORT .. "/sleep/1.5", "GET",
+        function(response)
+            assert(response.status == 200)
+            assert(fast_requests_done == 8)
+            requests_left = requests_left - 1
+        end)
+    requests_left = requests_left + 1
+
+    for i=1,8 do
+        http.request("http://127.0.0.1:" .. PORT, "GET",
+            function(response)
+                assert(response.status == 200)
+                assert(response.response == "Hello Defold!")
+                fast_requests_done = fast_requests_done + 1
+                requests_left = requests_left - 1
+            end,
+        headers)
+        requests_left = requests_left + 1
+    end
+end
+
+functions = { test_http_parallel = test_http_parallel }
@@ -0,0 +1,41 @@
+-- Copyright 2020 The Defold Foundation
+-- Licensed under the Defold License version 1.0 (the "License"); you may not use
+-- this file except in compliance with the License.
+-- 
+-- You may obtain a copy of the License, together with FAQs at
+-- https://www.defold.com/license
+-- 
+-- Unless required by applicable law or agreed to in writing, software distributed
+-- under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+-- CONDITIONS OF ANY KIND, either express or implied. See the License for the
+-- specific language governing permissions and limitations under the License.
+
+
+requests_left = 0
+slow_request_done = false
+
+-- NOTE: Run with network.http_max_connections_per_host=1. The fast requests go to
+-- the same host as the slow one, so they must wait for it even though there are
+-- idle http worker threads
+
+function test_http_per_host()
+    http.request("http://127.0.0.1:" .. PORT .. "/sleep/1.0", "GET",
+        function(response)
+            assert(response.status == 200)
+            slow_request_done = true
+            requests_left = requests_left - 1
+        end)
+    requests_left = requests_left + 1
+
+    for i=1,2 do
+        http.request("http://127.0.0.1:" .. PORT, "GET",
+            function(response)
+                assert(response.status == 200)
+                assert(slow_request_done)
+                requests_left = requests_left - 1
+            end)
+        requests_left = requests_left + 1
+    end
+end
+
+functions = { test_http_per_host = test_http_per_host }
@@ -106,3 +106,12 @@ assert(math.abs(vmath.length_sqr(q) - 1) < 0.0000001, "normalized not unit lengt
 local t = 1 / vmath.length(vmath.quat(1, 2, 3, 4))
 assert(math.abs(q.x - t) < 0.000001 and math.abs(q.y - 2*t) < 0.000001 and math.abs(q.z - 3*t) < 0.000001 and math.abs(q.w - 4*t) < 0.000001, "normalize")
 
+-- normalize_into
+q = vmath.quat(1, 2, 3, 4)
+local r = vmath.normalize_into(q, q)
+assert(r == q, "normalize_into does not return out")
+assert(math.abs(q.x - t) < 0.000001 and math.abs(q.y - 2*t) < 0.000001 and math.abs(q.z - 3*t) < 0.000001 and math.abs(q.w - 4*t) < 0.000001, "normalize_into aliased")
+
+-- only vmath.normalize_into accepts quats
+assert(not pcall(vmath.add_into, vmath.quat(), vmath.quat(), vmath.quat()), "add_into accepted quats")
+assert(not pcall(vmath.normalize_into, vmath.quat(), vmath.vector4(1)), "normalize_into accepted mixed types")
@@ -103,7 +103,9 @@ protected:
 
     virtual void SetUp()
     {
-        dmConfigFile::Result r = dmConfigFile::Load("src/test/test.config", 0, 0, &m_ConfigFile);
+        const char* config_override = GetConfigOverride();
+        const char* argv[] = {"test_script_http", config_override};
+        dmConfigFile::Result r = dmConfigFile::Load("src/test/test.config", config_override ? 2 : 0, argv, &m_ConfigFile);
         ASSERT_EQ(dmConfigFile::RESULT_OK, r);
 
         m_HttpResponseCount = 0;
@@ -136,6 +138,12 @@ protected:
         m_NumberOfFails = 0;
     }
 
+    // A "--config=section.key=value" argument to load the config with
+    virtual const char* GetConfigOverride()
+    {
+        return 0;
+    }
+
     virtual void TearDown()
     {
         dmScript::GetInstance(L);
@@ -331,6 +339,115 @@ TEST_F(ScriptHttpTest, TestTimeout)
     ASSERT_EQ(top, lua_gettop(L));
 }
 
+TEST_F(ScriptHttpTest, TestParallel)
+{
+    int top = lua_gettop(L);
+
+    ASSERT_TRUE(RunFile(L, "test_http_parallel.luac"));
+
+    char buf[1024];
+    dmSnPrintf(buf, sizeof(buf), "PORT = %d\n", m_WebServerPort);
+    RunString(L, buf);
+
+    lua_getglobal(L, "functions");
+    ASSERT_EQ(LUA_TTABLE, lua_type(L, -1));
+    lua_getfield(L, -1, "test_http_parallel");
+    ASSERT_EQ(LUA_TFUNCTION, lua_type(L, -1));
+    int result = dmScript::PCall(L, 0, LUA_MULTRET);
+    if (result == LUA_ERRRUN)
+    {
+        ASSERT_TRUE(false);
+    }
+    else
+    {
+        ASSERT_EQ(0, result);
+    }
+    lua_pop(L, 1);
+
+    uint64_t start = dmTime::GetTime();
+    while (1) {
+        dmSys::PumpMessageQueue();
+        dmMessage::Dispatch(m_DefaultURL.m_Socket, DispatchCallbackDDF, this);
+
+        lua_getglobal(L, "requests_left");
+        int requests_left = lua_tointeger(L, -1);
+        lua_pop(L, 1);
+
+        if (requests_left == 0) {
+            break;
+        }
+
+        if( m_NumberOfFails )
+        {
+            break;
+        }
+
+        dmTime::Sleep(10 * 1000);
+
+        uint64_t now = dmTime::GetTime();
+        uint64_t elapsed = now - start;
+        if (elapsed / 1000000 > 4) {
+            dmLogError("The test timed out\n");
+            ASSERT_TRUE(0);
+        }
+    }
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+class ScriptHttpPerHostTest : public ScriptHttpTest
+{
+protected:
+    virtual const char* GetConfigOverride()
+    {
+        return "--config=network.http_max_connections_per_host=1";
+    }
+};
+
+TEST_F(ScriptHttpPerHostTest, TestMaxConnectionsPerHost)
+{
+    int top = lua_gettop(L);
+
+    ASSERT_TRUE(RunFile(L, "test_http_per_host.luac"));
+
+    char buf[1024];
+    dmSnPrintf(buf, sizeof(buf), "PORT = %d\n", m_WebServerPort);
+    RunString(L, buf);
+
+    lua_getglobal(L, "functions");
+    ASSERT_EQ(LUA_TTABLE, lua_type(L, -1));
+    lua_getfield(L, -1, "test_http_per_host");
+    ASSERT_EQ(LUA_TFUNCTION, lua_type(L, -1));
+    int result = dmScript::PCall(L, 0, LUA_MULTRET);
+    ASSERT_EQ(0, result);
+    lua_pop(L, 1);
+
+    uint64_t start = dmTime::GetTime();
+    while (1) {
+        dmSys::PumpMessageQueue();
+        dmMessage::Dispatch(m_DefaultURL.m_Socket, DispatchCallbackDDF, this);
+
+        lua_getglobal(L, "requests_left");
+        int requests_left = lua_tointeger(L, -1);
+        lua_pop(L, 1);
+
+        if (requests_left == 0 || m_NumberOfFails) {
+            break;
+        }
+
+        dmTime::Sleep(10 * 1000);
+
+        uint64_t elapsed = dmTime::GetTime() - start;
+        if (elapsed / 1000000 > 4) {
+            dmLogError("The test timed out\n");
+            ASSERT_TRUE(0);
+        }
+    }
+    ASSERT_EQ(0, m_NumberOfFails);
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
 TEST_F(ScriptHttpTest, TestDeletedSocket)
 {
     SHttpRequestTimeoutGuard timeoutguard(300 * 1000);
@@ -765,6 +765,45 @@ TEST_F(ScriptMsgTest, TestPerf)
     printf("Time per post: %.4f\n", time / (double)count);
 }
 
+TEST_F(ScriptMsgTest, TestURLCacheInstance)
+{
+    int top = lua_gettop(L);
+
+    // The same relative url must resolve differently for different instances
+    ASSERT_TRUE(RunString(L,
+        "local url = msg.url(\"#fragment\")\n"
+        "assert(url.path == __default_url.path, \"invalid path\")\n"
+        "__default_url = msg.url(\"default_socket\", \"other_path\", \"other_fragment\")\n"
+        "url = msg.url(\"#fragment\")\n"
+        "assert(url.path == hash(\"other_path\"), \"cached url from other instance used\")\n"
+        "assert(url.fragment == hash(\"fragment\"), \"invalid fragment\")\n"
+        ));
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(ScriptMsgTest, TestPerfPostURLs)
+{
+    const uint32_t count = 10000;
+    const char* receivers[] = {"\"test_path\"", "\"#test_fragment\"", "\"default_socket:/test_path#test_fragment\"", "test_url"};
+    const char* names[] = {"relative string", "fragment string", "global string", "msg.url"};
+    ASSERT_TRUE(RunString(L, "test_url = msg.url(\"test_path\")"));
+    for (uint32_t i = 0; i < sizeof(receivers) / sizeof(receivers[0]); ++i)
+    {
+        char program[256];
+        dmSnPrintf(program, sizeof(program),
+            "for i = 1,%u do\n"
+            "    msg.post(%s, \"test_message\")\n"
+            "end\n",
+            count, receivers[i]);
+        uint64_t time = dmTime::GetTime();
+        ASSERT_TRUE(RunString(L, program));
+        time = dmTime::GetTime() - time;
+        ASSERT_EQ(count, dmMessage::Consume(m_DefaultURL.m_Socket));
+        printf("Posts per second (%s): %.0f\n", names[i], count / (time / 1000000.0));
+    }
+}
+
 TEST_F(ScriptMsgTest, TestPostDeletedSocket)
 {
     dmMessage::HSocket socket;
@@ -15,6 +15,8 @@
 #include "../script.h"
 #include "../script_timer_private.h"
 
+#include <dlib/time.h>
+
 #if defined(__NX__)
     #define MOUNTFS "host:/"
 #else
@@ -724,6 +726,73 @@ TEST_F(ScriptTimerTest, TestKillTimers)
     dmScript::DeleteTimerWorld(timer_world);
 }
 
+static void OrderTimerCallback(dmScript::HTimerWorld timer_world, dmScript::TimerEventType event_type, dmScript::HTimer timer_handle, float time_elapsed, uintptr_t owner, uintptr_t userdata)
+{
+    if (event_type != dmScript::TIMER_EVENT_CANCELLED)
+    {
+        uint32_t* order = (uint32_t*)owner;
+        order[TimerTestCallback::callback_count++] = (uint32_t)userdata;
+    }
+}
+
+TEST_F(ScriptTimerTest, TestSameFrameTriggerOrder)
+{
+    dmScript::HTimerWorld timer_world = dmScript::NewTimerWorld();
+
+    // Timers triggering in the same update are called in creation order, regardless of their delay
+    uint32_t order[4] = {0};
+    const float delays[4] = {2.f, 0.5f, 1.5f, 1.f};
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, dmScript::AddTimer(timer_world, delays[i], false, OrderTimerCallback, (uintptr_t)order, i));
+    }
+
+    dmScript::UpdateTimers(timer_world, 2.f);
+    ASSERT_EQ(4u, TimerTestCallback::callback_count);
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        ASSERT_EQ(i, order[i]);
+    }
+    ASSERT_EQ(0u, GetAliveTimers(timer_world));
+
+    dmScript::DeleteTimerWorld(timer_world);
+}
+
+TEST_F(ScriptTimerTest, TestTimerThroughput)
+{
+    dmScript::HTimerWorld timer_world = dmScript::NewTimerWorld();
+
+    // Many long delay timers (respawns, cooldowns) and a few short repeating ones
+    const uint32_t long_timer_count = 30000;
+    const uint32_t short_timer_count = 100;
+    for (uint32_t i = 0; i < long_timer_count; ++i)
+    {
+        ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, dmScript::AddTimer(timer_world, 60.f + (float)(i % 600), false, TestCallback, 0x10, 0x0));
+    }
+    for (uint32_t i = 0; i < short_timer_count; ++i)
+    {
+        ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, dmScript::AddTimer(timer_world, 0.1f, true, TestCallback, 0x20, 0x0));
+    }
+
+    const uint32_t frame_count = 600;
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        dmScript::UpdateTimers(timer_world, 1.0f / 60.0f);
+    }
+    uint64_t end = dmTime::GetTime();
+    printf("Bench %u timers, %u frames: %f ms (%f us per update)\n", long_timer_count + short_timer_count, frame_count, (end - start) / 1000.0f, (end - start) / (float)frame_count);
+
+    ASSERT_LT(0u, TimerTestCallback::callback_count);
+    ASSERT_EQ(long_timer_count + short_timer_count, GetAliveTimers(timer_world));
+
+    ASSERT_EQ(long_timer_count, dmScript::KillTimers(timer_world, 0x10));
+    ASSERT_EQ(short_timer_count, dmScript::KillTimers(timer_world, 0x20));
+    ASSERT_EQ(0u, GetAliveTimers(timer_world));
+
+    dmScript::DeleteTimerWorld(timer_world);
+}
+
 static bool RunString(lua_State* L, const char* script)
 {
     luaL_loadstring(L, script);
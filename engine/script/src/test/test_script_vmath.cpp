@@ -411,6 +411,40 @@ TEST_F(ScriptVmathTest, TestToValueFn)
     ASSERT_EQ(top, lua_gettop(L));
 }
 
+TEST_F(ScriptVmathTest, BenchMovers)
+{
+    ASSERT_TRUE(RunFile(L, "test_vmath_movers.luac"));
+
+    const int mover_count = 1000;
+    const int frame_count = 60;
+    const char* modes[] = {"allocating", "in place"};
+    int top = lua_gettop(L);
+    lua_getglobal(L, "assert_same_positions");
+    for (int i = 0; i < 2; ++i)
+    {
+        lua_getglobal(L, "run_movers");
+        lua_pushboolean(L, i);
+        lua_pushinteger(L, mover_count);
+        lua_pushinteger(L, frame_count);
+        ASSERT_EQ(0, lua_pcall(L, 3, 4, 0));
+        double update_time = lua_tonumber(L, -4);
+        double garbage = lua_tonumber(L, -3);
+        double gc_time = lua_tonumber(L, -2);
+        printf("Bench %d movers, %d frames (%s): update %f ms, garbage %f kb, gc %f ms\n", mover_count, frame_count, modes[i], update_time * 1000.0, garbage, gc_time * 1000.0);
+        // Keep the movers as an argument to assert_same_positions
+        lua_replace(L, -4);
+        lua_pop(L, 2);
+    }
+    int result = lua_pcall(L, 2, 0, 0);
+    if (result != 0)
+    {
+        printf("%s\n", lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+    ASSERT_EQ(0, result);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -120,4 +120,67 @@ assert(math.abs(v.x - 0.5 * sq2) < 0.000001 and math.abs(v.y + 0.5 * sq2) < 0.00
 v = vmath.mul_per_elem(vmath.vector3(1,2,3), vmath.vector3(5,6,7))
 assert(v.x == 5, "v.x is not 5")
 assert(v.y ==12, "v.y is not 12")
-assert(v.z ==21, "v.z is not 21")
\ No newline at end of file
+assert(v.z ==21, "v.z is not 21")
+-- add_into, result is the out vector
+local out = vmath.vector3()
+local r = vmath.add_into(out, vmath.vector3(1, 2, 3), vmath.vector3(2, 3, 4))
+assert(r == out, "add_into does not return out")
+assert(out.x == 3 and out.y == 5 and out.z == 7, "add_into")
+
+-- add_into aliasing the inputs
+v = vmath.vector3(1, 2, 3)
+vmath.add_into(v, v, v)
+assert(v.x == 2 and v.y == 4 and v.z == 6, "add_into aliased")
+
+-- sub_into
+vmath.sub_into(out, vmath.vector3(1, 2, 3), vmath.vector3(2, 4, 6))
+assert(out.x == -1 and out.y == -2 and out.z == -3, "sub_into")
+v = vmath.vector3(1, 2, 3)
+vmath.sub_into(v, vmath.vector3(5, 5, 5), v)
+assert(v.x == 4 and v.y == 3 and v.z == 2, "sub_into aliased")
+
+-- mul_into
+v = vmath.vector3(1, 2, 3)
+vmath.mul_into(v, v, 2)
+assert(v.x == 2 and v.y == 4 and v.z == 6, "mul_into aliased")
+
+-- madd_into
+local pos = vmath.vector3(1, 2, 3)
+vmath.madd_into(pos, pos, vmath.vector3(2, 4, 6), 0.5)
+assert(pos.x == 2 and pos.y == 4 and pos.z == 6, "madd_into aliased")
+vmath.madd_into(pos, vmath.vector3(1, 1, 1), pos, 2)
+assert(pos.x == 5 and pos.y == 9 and pos.z == 13, "madd_into aliased with scaled vector")
+
+-- normalize_into
+v = vmath.vector3(1.2, 1.6, 0)
+vmath.normalize_into(v, v)
+assert(math.abs(v.x - 0.6) < 0.000001 and math.abs(v.y - 0.8) < 0.000001 and v.z == 0, "normalize_into aliased")
+
+-- lerp_into
+v = vmath.vector3(1, 0, 0)
+vmath.lerp_into(v, 0.5, v, vmath.vector3(0, -1, 0))
+assert(v.x == 0.5 and v.y == -0.5 and v.z == 0, "lerp_into aliased")
+
+-- madd_batch, out array aliasing the first array
+local positions = { vmath.vector3(1, 0, 0), vmath.vector3(0, 1, 0) }
+local velocities = { vmath.vector3(2, 0, 0), vmath.vector3(0, 4, 2) }
+local first = positions[1]
+r = vmath.madd_batch(positions, positions, velocities, 0.5)
+assert(r == positions, "madd_batch does not return out")
+assert(positions[1] == first, "madd_batch replaced the vector instead of writing to it")
+assert(positions[1].x == 2 and positions[1].y == 0 and positions[1].z == 0, "madd_batch [1]")
+assert(positions[2].x == 0 and positions[2].y == 3 and positions[2].z == 1, "madd_batch [2]")
+vmath.madd_batch({}, {}, {}, 1)
+
+-- bad arguments
+assert(not pcall(vmath.add_into, 1, vmath.vector3(), vmath.vector3()), "add_into accepted a number as out")
+assert(not pcall(vmath.add_into, vmath.vector3(), vmath.vector3(), vmath.vector4()), "add_into accepted mixed types")
+assert(not pcall(vmath.sub_into, vmath.quat(), vmath.quat(), vmath.quat()), "sub_into accepted quats")
+assert(not pcall(vmath.mul_into, vmath.vector3(), vmath.vector3(), "a"), "mul_into accepted a string as scale")
+assert(not pcall(vmath.madd_into, vmath.vector3(), vmath.vector3(), vmath.vector3()), "madd_into accepted a missing scale")
+assert(not pcall(vmath.normalize_into, vmath.vector3(), vmath.vector4(1)), "normalize_into accepted mixed types")
+assert(not pcall(vmath.lerp_into, vmath.vector3(), vmath.vector3(), vmath.vector3(), vmath.vector3()), "lerp_into accepted a vector as t")
+assert(not pcall(vmath.madd_batch, vmath.vector3(), {}, {}, 1), "madd_batch accepted a vector as out")
+assert(not pcall(vmath.madd_batch, { 1 }, { vmath.vector3() }, { vmath.vector3() }, 1), "madd_batch accepted a number in out")
+assert(not pcall(vmath.madd_batch, { vmath.vector3() }, {}, {}, 1), "madd_batch accepted a too short input array")
+assert(not pcall(vmath.madd_batch, { vmath.vector3() }, { vmath.vector4() }, { vmath.vector3() }, 1), "madd_batch accepted mixed types")
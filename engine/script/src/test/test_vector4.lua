@@ -131,3 +131,34 @@ assert(v.x == 5, "v.x is not 5")
 assert(v.y ==12, "v.y is not 12")
 assert(v.z ==21, "v.z is not 21")
 assert(v.w ==32, "v.w is not 32")
+
+-- add_into, sub_into, mul_into and madd_into aliasing the inputs
+v = vmath.vector4(1, 2, 3, 4)
+local r = vmath.add_into(v, v, v)
+assert(r == v, "add_into does not return out")
+assert(v.x == 2 and v.y == 4 and v.z == 6 and v.w == 8, "add_into aliased")
+vmath.sub_into(v, v, vmath.vector4(1, 1, 1, 1))
+assert(v.x == 1 and v.y == 3 and v.z == 5 and v.w == 7, "sub_into aliased")
+vmath.mul_into(v, v, 2)
+assert(v.x == 2 and v.y == 6 and v.z == 10 and v.w == 14, "mul_into aliased")
+vmath.madd_into(v, vmath.vector4(1, 1, 1, 1), v, 0.5)
+assert(v.x == 2 and v.y == 4 and v.z == 6 and v.w == 8, "madd_into aliased")
+
+-- normalize_into
+v = vmath.vector4(1, 2, 3, 4)
+vmath.normalize_into(v, v)
+assert(math.abs(v.x - t) < 0.000001 and math.abs(v.y - 2*t) < 0.000001 and math.abs(v.z - 3*t) < 0.000001 and math.abs(v.w - 4*t) < 0.000001, "normalize_into aliased")
+
+-- lerp_into
+v = vmath.vector4(0, -1, 0, 0)
+vmath.lerp_into(v, 0.5, vmath.vector4(1, 0, 0, 0), v)
+assert(v.x == 0.5 and v.y == -0.5 and v.z == 0 and v.w == 0, "lerp_into aliased")
+
+-- madd_batch
+local positions = { vmath.vector4(1, 0, 0, 0) }
+vmath.madd_batch(positions, positions, { vmath.vector4(2, 2, 2, 2) }, 0.5)
+assert(positions[1].x == 2 and positions[1].y == 1 and positions[1].z == 1 and positions[1].w == 1, "madd_batch")
+
+-- bad arguments
+assert(not pcall(vmath.add_into, vmath.vector4(), vmath.vector4(), vmath.vector3()), "add_into accepted mixed types")
+assert(not pcall(vmath.lerp_into, vmath.vector4(), 0.5, vmath.vector4(), vmath.vector3()), "lerp_into accepted mixed types")
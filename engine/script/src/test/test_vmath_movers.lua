@@ -0,0 +1,86 @@
+-- Copyright 2020 The Defold Foundation
+-- Licensed under the Defold License version 1.0 (the "License"); you may not use
+-- this file except in compliance with the License.
+-- 
+-- You may obtain a copy of the License, together with FAQs at
+-- https://www.defold.com/license
+-- 
+-- Unless required by applicable law or agreed to in writing, software distributed
+-- under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+-- CONDITIONS OF ANY KIND, either express or implied. See the License for the
+-- specific language governing permissions and limitations under the License.
+
+-- Microbenchmark of the per frame vector math in a scene with many scripted
+-- "movers". Each mover integrates a velocity, applies some damping and steers
+-- towards a target, which is the typical shape of an update() function.
+--
+-- The garbage collector is stopped during the frames so that the amount of
+-- garbage produced can be measured, and then a full collection is timed to
+-- get the cost the garbage collector would have had to pay.
+
+local function create_movers(count)
+    local movers = {}
+    for i = 1, count do
+        movers[i] = {
+            pos = vmath.vector3(i, 0, 0),
+            velocity = vmath.vector3(1, 2, 0),
+            target = vmath.vector3(0, i, 0),
+            dir = vmath.vector3(),
+        }
+    end
+    return movers
+end
+
+local function update_alloc(movers, dt)
+    for i = 1, #movers do
+        local m = movers[i]
+        m.pos = m.pos + m.velocity * dt
+        m.velocity = m.velocity * 0.99
+        local dir = vmath.normalize(m.target - m.pos)
+        m.velocity = m.velocity + dir * dt
+    end
+end
+
+local function update_into(movers, dt)
+    for i = 1, #movers do
+        local m = movers[i]
+        vmath.madd_into(m.pos, m.pos, m.velocity, dt)
+        vmath.mul_into(m.velocity, m.velocity, 0.99)
+        vmath.sub_into(m.dir, m.target, m.pos)
+        vmath.normalize_into(m.dir, m.dir)
+        vmath.madd_into(m.velocity, m.velocity, m.dir, dt)
+    end
+end
+
+-- Returns elapsed update time (s), garbage produced (kb), collection time (s) and the movers
+function run_movers(in_place, mover_count, frame_count)
+    local movers = create_movers(mover_count)
+    local update = in_place and update_into or update_alloc
+
+    collectgarbage("collect")
+    collectgarbage("stop")
+    local mem_start = collectgarbage("count")
+    local time_start = os.clock()
+    for frame = 1, frame_count do
+        update(movers, 1 / 60)
+    end
+    local update_time = os.clock() - time_start
+    local garbage = collectgarbage("count") - mem_start
+
+    time_start = os.clock()
+    collectgarbage("collect")
+    local gc_time = os.clock() - time_start
+    collectgarbage("restart")
+    return update_time, garbage, gc_time, movers
+end
+
+-- Both update functions must move the movers the same way
+function assert_same_positions(movers_a, movers_b)
+    assert(#movers_a == #movers_b, "different number of movers")
+    for i = 1, #movers_a do
+        local a = movers_a[i]
+        local b = movers_b[i]
+        assert(vmath.length(a.pos - b.pos) < 0.0001, "mover " .. i .. " position differs: " .. tostring(a.pos) .. " " .. tostring(b.pos))
+        assert(vmath.length(a.velocity - b.velocity) < 0.0001, "mover " .. i .. " velocity differs")
+    end
+end
@@ -40,7 +40,8 @@ namespace dmSoundCodec
 
             DecodeStreamInfo *streamInfo = new DecodeStreamInfo;
             streamInfo->m_Info.m_Rate = info.sample_rate;
-            streamInfo->m_Info.m_Size = 0;
+            // Read from the last page, 0 if unknown
+            streamInfo->m_Info.m_Size = stb_vorbis_stream_length_in_samples(vorbis) * info.channels * 2;
             streamInfo->m_Info.m_Channels = info.channels;
             streamInfo->m_Info.m_BitsPerSample = 16;
             streamInfo->m_StbVorbis = vorbis;
@@ -101,11 +101,12 @@ namespace dmSoundCodec
         vorbis_info *info = ov_info(&tmp->m_File, -1);
 
         tmp->m_Info.m_Rate = info->rate;
-        tmp->m_Info.m_Size = 0;
+        tmp->m_PcmLength = ov_pcm_total(&tmp->m_File, -1);
+
+        // 0 if unknown
+        tmp->m_Info.m_Size = tmp->m_PcmLength > 0 ? (uint32_t) dmMath::Min(tmp->m_PcmLength * info->channels * 2, (ogg_int64_t) 0xffffffff) : 0;
         tmp->m_Info.m_Channels = info->channels;
         tmp->m_Info.m_BitsPerSample = 16;
-
-        tmp->m_PcmLength = ov_pcm_total(&tmp->m_File, -1);
         tmp->m_SeekTo = -1;
 
         *stream = tmp;
@@ -26,6 +26,15 @@
 
 #include <math.h>
 #include <cfloat>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DM_SOUND_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define DM_SOUND_NEON
+#endif
 
 /**
  * Defold simple sound system
@@ -46,6 +55,10 @@ namespace dmSound
     const dmhash_t MASTER_GROUP_HASH = dmHashString64("master");
     const uint32_t GROUP_MEMORY_BUFFER_COUNT = 64;
 
+    // Frames are mixed in blocks of this size. The pan and gain are evaluated at the block edges
+    // and interpolated linearly within the block.
+    const uint32_t MIX_BLOCK_FRAME_COUNT = 64;
+
     static void SoundThread(void* ctx);
 
     /**
@@ -143,19 +156,62 @@ namespace dmSound
         return ramp;
     }
 
+    /**
+     * Fully decoded PCM of a short sound, shared read-only by the instances playing it.
+     * Each instance keeps its own cursor into the frames.
+     */
+    struct PcmCacheEntry
+    {
+        void*               m_Frames;
+        uint32_t            m_Size;
+        // Value of PcmCache::m_Clock when the entry was last used
+        uint32_t            m_LastUsed;
+        uint32_t            m_RefCount;
+        dmSoundCodec::Info  m_Info;
+        // Index in m_SoundData. 0xffff when the sound data was changed or deleted while the entry was in use,
+        // the entry is then freed with the last instance referencing it
+        uint16_t            m_SoundDataIndex;
+    };
+
+    struct PcmCache
+    {
+        // Entries attached to sound data, in no particular order
+        dmArray<PcmCacheEntry*> m_Entries;
+        // Indices of sound data to decode on the sound thread, see DecodePendingPcm()
+        dmArray<uint16_t>       m_DecodeQueue;
+        uint32_t                m_Size;
+        uint32_t                m_MaxSoundSize;
+        uint32_t                m_MemoryUsed;
+        uint32_t                m_Clock;
+        // Source of SoundData::m_Version
+        uint32_t                m_DataVersion;
+        uint32_t                m_Hits;
+        uint32_t                m_Misses;
+        uint32_t                m_Decodes;
+    };
+
     struct SoundData
     {
-        dmhash_t      m_NameHash;
-        void*         m_Data;
-        int           m_Size;
+        dmhash_t       m_NameHash;
+        void*          m_Data;
+        int            m_Size;
+        PcmCacheEntry* m_PcmCacheEntry;
+        // Changed with the data, so a decode started before the change is discarded
+        uint32_t       m_Version;
         // Index in m_SoundData
-        uint16_t      m_Index;
-        SoundDataType m_Type;
+        uint16_t       m_Index;
+        SoundDataType  m_Type;
+        // Set when the decoded sound doesn't fit the cache
+        uint8_t        m_PcmUncacheable : 1;
+        // Queued for decoding into the cache
+        uint8_t        m_PcmDecodePending : 1;
     };
 
     struct SoundInstance
     {
+        // Either a decoder or a cache entry is used
         dmSoundCodec::HDecoder m_Decoder;
+        PcmCacheEntry* m_PcmCacheEntry;
         void*       m_Frames;
         dmhash_t    m_Group;
 
@@ -164,14 +220,23 @@ namespace dmSound
         float       m_Speed;    // 1.0 = normal speed, 0.5 = half speed, 2.0 = double speed
         uint32_t    m_FrameCount;
         uint64_t    m_FrameFraction;
+        // Byte offset in the cached frames
+        uint32_t    m_PcmCursor;
 
         uint16_t    m_Index;
         uint16_t    m_SoundDataIndex;
         uint8_t     m_Looping : 1;
         uint8_t     m_EndOfStream : 1;
         uint8_t     m_Playing : 1;
-        uint8_t     : 5;
+        // Advanced without being decoded or mixed, see UpdateVoices()
+        uint8_t     m_Virtual : 1;
+        // Mixed or skipped since the last start
+        uint8_t     m_Started : 1;
+        uint8_t     : 3;
         int8_t      m_Loopcounter; // if set to 3, there will be 3 loops effectively playing the sound 4 times.
+        uint8_t     m_Priority;
+        // Max gain over the update, set by UpdateVoices()
+        float       m_Audibility;
     };
 
     struct SoundGroup
@@ -182,6 +247,8 @@ namespace dmSound
         float    m_SumSquaredMemory[SOUND_MAX_MIX_CHANNELS * GROUP_MEMORY_BUFFER_COUNT];
         float    m_PeakMemorySq[SOUND_MAX_MIX_CHANNELS * GROUP_MEMORY_BUFFER_COUNT];
         int      m_NextMemorySlot;
+        // Max number of real voices, 0 for no limit
+        uint32_t m_VoiceLimit;
     };
 
     struct SoundSystem
@@ -198,6 +265,12 @@ namespace dmSound
         dmArray<SoundData>      m_SoundData;
         dmIndexPool16           m_SoundDataPool;
 
+        PcmCache                m_PcmCache;
+
+        // Scratch buffer for the voice selection, see UpdateVoices()
+        dmArray<uint16_t>       m_Voices;
+        float                   m_VirtualGainThreshold;
+
         dmHashTable<dmhash_t, int> m_GroupMap;
         SoundGroup              m_Groups[MAX_GROUPS];
 
@@ -246,6 +319,10 @@ namespace dmSound
         params->m_BufferSize = 12 * 4096;
         params->m_FrameCount = 768;
         params->m_MaxInstances = 256;
+        params->m_PcmCacheSize = 2 * 1024 * 1024;
+        params->m_PcmCacheMaxSoundSize = 256 * 1024;
+        // Below one bit at full scale
+        params->m_VirtualGainThreshold = 1.0f / 32768.0f;
         params->m_UseThread = true;
     }
 
@@ -294,6 +371,292 @@ namespace dmSound
         return index;
     }
 
+    static void FreePcmCacheEntry(SoundSystem* sound, PcmCacheEntry* entry)
+    {
+        sound->m_PcmCache.m_MemoryUsed -= entry->m_Size;
+        free(entry->m_Frames);
+        delete entry;
+    }
+
+    static void ReleasePcmCacheEntry(SoundSystem* sound, PcmCacheEntry* entry)
+    {
+        assert(entry->m_RefCount > 0);
+        entry->m_RefCount--;
+        if (entry->m_RefCount == 0 && entry->m_SoundDataIndex == 0xffff)
+        {
+            FreePcmCacheEntry(sound, entry);
+        }
+    }
+
+    // Removes the entry of a sound data that is changed or deleted. Entries still in use are freed on release
+    static void DetachPcmCacheEntry(SoundSystem* sound, SoundData* sound_data)
+    {
+        PcmCacheEntry* entry = sound_data->m_PcmCacheEntry;
+        if (!entry)
+            return;
+
+        sound_data->m_PcmCacheEntry = 0;
+        dmArray<PcmCacheEntry*>& entries = sound->m_PcmCache.m_Entries;
+        for (uint32_t i = 0; i < entries.Size(); ++i)
+        {
+            if (entries[i] == entry)
+            {
+                entries.EraseSwap(i);
+                break;
+            }
+        }
+
+        if (entry->m_RefCount == 0)
+            FreePcmCacheEntry(sound, entry);
+        else
+            entry->m_SoundDataIndex = 0xffff;
+    }
+
+    static bool IsPcmCacheable(SoundSystem* sound, SoundData* sound_data)
+    {
+        // Wav data is read as is by the decoder, so only compressed sounds are worth caching
+        return sound->m_PcmCache.m_Size > 0 && sound_data->m_Type == SOUND_DATA_TYPE_OGG_VORBIS && !sound_data->m_PcmUncacheable;
+    }
+
+    // Evicts the least recently used entries not in use until size bytes fit in the budget
+    static bool MakeRoomInPcmCache(SoundSystem* sound, uint32_t size)
+    {
+        PcmCache* cache = &sound->m_PcmCache;
+        while (cache->m_MemoryUsed + size > cache->m_Size)
+        {
+            uint32_t lru = 0xffffffff;
+            uint32_t max_age = 0;
+            for (uint32_t i = 0; i < cache->m_Entries.Size(); ++i)
+            {
+                PcmCacheEntry* entry = cache->m_Entries[i];
+                uint32_t age = cache->m_Clock - entry->m_LastUsed;
+                if (entry->m_RefCount == 0 && (lru == 0xffffffff || age > max_age))
+                {
+                    lru = i;
+                    max_age = age;
+                }
+            }
+
+            if (lru == 0xffffffff)
+                return false;
+
+            PcmCacheEntry* entry = cache->m_Entries[lru];
+            cache->m_Entries.EraseSwap(lru);
+            sound->m_SoundData[entry->m_SoundDataIndex].m_PcmCacheEntry = 0;
+            FreePcmCacheEntry(sound, entry);
+        }
+        return true;
+    }
+
+    static void AcquirePcmCacheEntry(SoundSystem* sound, PcmCacheEntry* entry)
+    {
+        entry->m_RefCount++;
+        entry->m_LastUsed = ++sound->m_PcmCache.m_Clock;
+    }
+
+    /*
+     * Decodes the whole stream. Returns 0 and sets too_large if the decoded sound is larger than max_size.
+     * Called without the lock, as the decoder and its data are only used by the caller.
+     */
+    static void* DecodePcm(dmSoundCodec::HCodecContext context, dmSoundCodec::HDecoder decoder, uint32_t max_size, uint32_t* size, bool* too_large)
+    {
+        DM_PROFILE(Sound, "DecodePcm");
+
+        // Decode with room for at least a few frames, as a decoder returns 0 bytes when a frame doesn't fit
+        const uint32_t min_space = 64;
+        uint32_t capacity = dmMath::Min(max_size, 64U * 1024U);
+        char* frames = (char*) malloc(capacity);
+        uint32_t used = 0;
+        *too_large = false;
+        while (true)
+        {
+            if (capacity - used < min_space)
+            {
+                if (capacity == max_size)
+                {
+                    // Full, check whether there is more to decode
+                    char probe[min_space];
+                    uint32_t decoded = 0;
+                    dmSoundCodec::Result r = dmSoundCodec::Decode(context, decoder, probe, sizeof(probe), &decoded);
+                    *too_large = r == dmSoundCodec::RESULT_OK && decoded > 0;
+                    if (r != dmSoundCodec::RESULT_OK || decoded > 0)
+                    {
+                        free(frames);
+                        return 0;
+                    }
+                    break;
+                }
+                capacity = dmMath::Min(max_size, capacity * 2);
+                frames = (char*) realloc(frames, capacity);
+            }
+
+            uint32_t decoded = 0;
+            dmSoundCodec::Result r = dmSoundCodec::Decode(context, decoder, frames + used, capacity - used, &decoded);
+            if (r != dmSoundCodec::RESULT_OK)
+            {
+                free(frames);
+                return 0;
+            }
+            if (decoded == 0)
+                break;
+            used += decoded;
+        }
+
+        *size = used;
+        return frames;
+    }
+
+    // Bytes that fit in the budget after evicting every entry not in use
+    static uint32_t GetEvictablePcmCacheSize(SoundSystem* sound)
+    {
+        PcmCache* cache = &sound->m_PcmCache;
+        uint32_t in_use = cache->m_MemoryUsed;
+        for (uint32_t i = 0; i < cache->m_Entries.Size(); ++i)
+        {
+            PcmCacheEntry* entry = cache->m_Entries[i];
+            if (entry->m_RefCount == 0)
+                in_use -= entry->m_Size;
+        }
+        return in_use < cache->m_Size ? cache->m_Size - in_use : 0;
+    }
+
+    /*
+     * Called with the lock on a miss. The instance plays from its own decoder, and the sound is decoded
+     * into the cache on the sound thread for the instances created after that. The decoded size is known
+     * up front for most streams, so a sound is only queued if it would fit once the unused entries are
+     * evicted. A sound that doesn't fit now is checked again on the next miss.
+     */
+    static void RequestPcmDecode(SoundSystem* sound, SoundData* sound_data, dmSoundCodec::HDecoder decoder)
+    {
+        if (sound_data->m_PcmDecodePending)
+            return;
+
+        dmSoundCodec::Info info;
+        dmSoundCodec::GetInfo(sound->m_CodecContext, decoder, &info);
+        if (info.m_Size > sound->m_PcmCache.m_MaxSoundSize)
+        {
+            sound_data->m_PcmUncacheable = 1;
+            return;
+        }
+        if (info.m_Size > GetEvictablePcmCacheSize(sound))
+            return;
+
+        // Indices of changed or deleted sound data are skipped when popped, and may still be queued
+        dmArray<uint16_t>& queue = sound->m_PcmCache.m_DecodeQueue;
+        if (queue.Full())
+            queue.OffsetCapacity(16);
+        sound_data->m_PcmDecodePending = 1;
+        queue.Push(sound_data->m_Index);
+    }
+
+    // Adds the decoded frames of a sound data, taking ownership of them
+    static void AddToPcmCache(SoundSystem* sound, SoundData* sound_data, dmSoundCodec::HDecoder decoder, void* frames, uint32_t size)
+    {
+        if (!MakeRoomInPcmCache(sound, size))
+        {
+            // Entries were acquired while decoding
+            free(frames);
+            return;
+        }
+
+        PcmCacheEntry* entry = new PcmCacheEntry;
+        entry->m_Frames = frames;
+        entry->m_Size = size;
+        entry->m_RefCount = 0;
+        entry->m_LastUsed = ++sound->m_PcmCache.m_Clock;
+        entry->m_SoundDataIndex = sound_data->m_Index;
+        dmSoundCodec::GetInfo(sound->m_CodecContext, decoder, &entry->m_Info);
+        sound_data->m_PcmCacheEntry = entry;
+        sound->m_PcmCache.m_Entries.Push(entry);
+        sound->m_PcmCache.m_MemoryUsed += size;
+    }
+
+    // Removes the first queued index, keeping the order of the rest
+    static uint16_t PopFrontDecodeQueue(dmArray<uint16_t>& queue)
+    {
+        uint16_t index = queue[0];
+        uint32_t size = queue.Size();
+        memmove(queue.Begin(), queue.Begin() + 1, (size - 1) * sizeof(uint16_t));
+        queue.SetSize(size - 1);
+        return index;
+    }
+
+    /*
+     * Decodes the oldest queued sound into the cache. Runs on the sound thread between mixes, or in
+     * Update() without one, so at most one sound is decoded per call to keep the mixer on time.
+     * The sound is decoded from a copy of its data without the lock, so the game thread isn't blocked
+     * and the data may be changed or deleted meanwhile.
+     */
+    static void DecodePendingPcm(SoundSystem* sound)
+    {
+        PcmCache* cache = &sound->m_PcmCache;
+        uint16_t index = 0xffff;
+        uint32_t version = 0;
+        void* data = 0;
+        dmSoundCodec::HDecoder decoder = 0;
+        {
+            DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound->m_Mutex);
+            while (cache->m_DecodeQueue.Size() > 0 && index == 0xffff)
+            {
+                uint16_t i = PopFrontDecodeQueue(cache->m_DecodeQueue);
+                SoundData* sound_data = &sound->m_SoundData[i];
+                if (sound_data->m_Index == i && sound_data->m_PcmDecodePending)
+                    index = i;
+            }
+            if (index == 0xffff)
+                return;
+
+            // Stays pending while decoding, so a miss meanwhile doesn't queue it again
+            SoundData* sound_data = &sound->m_SoundData[index];
+            version = sound_data->m_Version;
+            data = malloc(sound_data->m_Size);
+            memcpy(data, sound_data->m_Data, sound_data->m_Size);
+            dmSoundCodec::Result r = dmSoundCodec::NewDecoder(sound->m_CodecContext, dmSoundCodec::FORMAT_VORBIS, data, sound_data->m_Size, &decoder);
+            if (r != dmSoundCodec::RESULT_OK)
+            {
+                sound_data->m_PcmDecodePending = 0;
+                free(data);
+                return;
+            }
+        }
+
+        uint32_t size = 0;
+        bool too_large = false;
+        void* frames = DecodePcm(sound->m_CodecContext, decoder, cache->m_MaxSoundSize, &size, &too_large);
+
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound->m_Mutex);
+        SoundData* sound_data = &sound->m_SoundData[index];
+        bool unchanged = sound_data->m_Index == index && sound_data->m_Version == version;
+        if (unchanged)
+        {
+            sound_data->m_PcmDecodePending = 0;
+            if (too_large)
+                sound_data->m_PcmUncacheable = 1;
+        }
+        cache->m_Decodes++;
+        if (frames)
+        {
+            if (unchanged)
+                AddToPcmCache(sound, sound_data, decoder, frames, size);
+            else
+                free(frames);
+        }
+        dmSoundCodec::DeleteDecoder(sound->m_CodecContext, decoder);
+        free(data);
+    }
+
+    void GetPcmCacheStats(PcmCacheStats* stats)
+    {
+        SoundSystem* sound = g_SoundSystem;
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound->m_Mutex);
+        PcmCache* cache = &sound->m_PcmCache;
+        stats->m_Hits = cache->m_Hits;
+        stats->m_Misses = cache->m_Misses;
+        stats->m_Decodes = cache->m_Decodes;
+        stats->m_MemoryUsed = cache->m_MemoryUsed;
+        stats->m_EntryCount = cache->m_Entries.Size();
+    }
+
     Result Initialize(dmConfigFile::HConfig config, const InitializeParams* params)
     {
         Result r = PlatformInitialize(config, params);
@@ -329,13 +692,16 @@ namespace dmSound
         sound->m_DeviceType = device_type;
         sound->m_Device = device;
         dmSoundCodec::NewCodecContextParams codec_params;
-        codec_params.m_MaxDecoders = params->m_MaxInstances;
+        // One more for decoding into the PCM cache
+        codec_params.m_MaxDecoders = params->m_MaxInstances + 1;
         sound->m_CodecContext = dmSoundCodec::New(&codec_params);
 
         uint32_t max_sound_data = params->m_MaxSoundData;
         uint32_t max_buffers = params->m_MaxBuffers;
         uint32_t max_sources = params->m_MaxSources;
         uint32_t max_instances = params->m_MaxInstances;
+        uint32_t pcm_cache_size = params->m_PcmCacheSize;
+        uint32_t pcm_cache_max_sound_size = params->m_PcmCacheMaxSoundSize;
 
         if (config)
         {
@@ -344,6 +710,8 @@ namespace dmSound
             max_buffers = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_buffers", (int32_t) max_buffers);
             max_sources = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_sources", (int32_t) max_sources);
             max_instances = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_instances", (int32_t) max_instances);
+            pcm_cache_size = (uint32_t) dmConfigFile::GetInt(config, "sound.pcm_cache_size", (int32_t) (pcm_cache_size / 1024)) * 1024;
+            pcm_cache_max_sound_size = (uint32_t) dmConfigFile::GetInt(config, "sound.pcm_cache_max_sound_size", (int32_t) (pcm_cache_max_sound_size / 1024)) * 1024;
         }
 
         sound->m_Instances.SetCapacity(max_instances);
@@ -362,13 +730,30 @@ namespace dmSound
             instance->m_Speed = 1.0f;
         }
 
+        sound->m_Voices.SetCapacity(max_instances);
+        sound->m_VirtualGainThreshold = params->m_VirtualGainThreshold;
+
         sound->m_SoundData.SetCapacity(max_sound_data);
         sound->m_SoundData.SetSize(max_sound_data);
         sound->m_SoundDataPool.SetCapacity(max_sound_data);
         for (uint32_t i = 0; i < max_sound_data; ++i)
         {
             sound->m_SoundData[i].m_Index = 0xffff;
-        }
+            sound->m_SoundData[i].m_PcmCacheEntry = 0;
+            sound->m_SoundData[i].m_PcmDecodePending = 0;
+        }
+
+        PcmCache* pcm_cache = &sound->m_PcmCache;
+        pcm_cache->m_Entries.SetCapacity(max_sound_data);
+        pcm_cache->m_DecodeQueue.SetCapacity(max_sound_data);
+        pcm_cache->m_Size = pcm_cache_size;
+        pcm_cache->m_MaxSoundSize = dmMath::Min(pcm_cache_max_sound_size, pcm_cache_size);
+        pcm_cache->m_MemoryUsed = 0;
+        pcm_cache->m_Clock = 0;
+        pcm_cache->m_DataVersion = 0;
+        pcm_cache->m_Hits = 0;
+        pcm_cache->m_Misses = 0;
+        pcm_cache->m_Decodes = 0;
 
         sound->m_MixRate = device_info.m_MixRate;
         sound->m_FrameCount = params->m_FrameCount;
@@ -425,6 +810,10 @@ namespace dmSound
             for (uint32_t i = 0; i < sound->m_Instances.Size(); ++i)
             {
                 SoundInstance* instance = &sound->m_Instances[i];
+                if (instance->m_PcmCacheEntry)
+                {
+                    ReleasePcmCacheEntry(sound, instance->m_PcmCacheEntry);
+                }
                 instance->m_Index = 0xffff;
                 instance->m_SoundDataIndex = 0xffff;
                 free(instance->m_Frames);
@@ -435,6 +824,11 @@ namespace dmSound
                 free((void*) sound->m_OutBuffers[i]);
             }
 
+            PcmCache* pcm_cache = &sound->m_PcmCache;
+            for (uint32_t i = 0; i < pcm_cache->m_Entries.Size(); ++i) {
+                FreePcmCacheEntry(sound, pcm_cache->m_Entries[i]);
+            }
+
             for (uint32_t i = 0; i < MAX_GROUPS; i++) {
                 SoundGroup* g = &sound->m_Groups[i];
                 if (g->m_MixBuffer) {
@@ -460,9 +854,52 @@ namespace dmSound
         return dmHashReverseSafe64(hash);
     }
 
+    /*
+     * Stream access for an instance, from the shared cached frames or the instance's own decoder
+     */
+
+    static void GetStreamInfo(SoundSystem* sound, SoundInstance* instance, dmSoundCodec::Info* info)
+    {
+        if (instance->m_PcmCacheEntry)
+            *info = instance->m_PcmCacheEntry->m_Info;
+        else
+            dmSoundCodec::GetInfo(sound->m_CodecContext, instance->m_Decoder, info);
+    }
+
+    // Decodes to buffer, or skips if buffer is 0
+    static dmSoundCodec::Result DecodeStream(SoundSystem* sound, SoundInstance* instance, char* buffer, uint32_t buffer_size, uint32_t* decoded)
+    {
+        PcmCacheEntry* entry = instance->m_PcmCacheEntry;
+        if (entry)
+        {
+            uint32_t n = dmMath::Min(buffer_size, entry->m_Size - instance->m_PcmCursor);
+            if (buffer)
+                memcpy(buffer, (const char*) entry->m_Frames + instance->m_PcmCursor, n);
+            instance->m_PcmCursor += n;
+            *decoded = n;
+            return dmSoundCodec::RESULT_OK;
+        }
+
+        if (buffer)
+            return dmSoundCodec::Decode(sound->m_CodecContext, instance->m_Decoder, buffer, buffer_size, decoded);
+        return dmSoundCodec::Skip(sound->m_CodecContext, instance->m_Decoder, buffer_size, decoded);
+    }
+
+    static void ResetStream(SoundSystem* sound, SoundInstance* instance)
+    {
+        if (instance->m_PcmCacheEntry)
+            instance->m_PcmCursor = 0;
+        else
+            dmSoundCodec::Reset(sound->m_CodecContext, instance->m_Decoder);
+    }
+
 
     static Result SetSoundDataNoLock(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size)
     {
+        DetachPcmCacheEntry(g_SoundSystem, sound_data);
+        sound_data->m_PcmUncacheable = 0;
+        sound_data->m_PcmDecodePending = 0;
+        sound_data->m_Version = ++g_SoundSystem->m_PcmCache.m_DataVersion;
         free(sound_data->m_Data);
         sound_data->m_Data = malloc(sound_buffer_size);
         sound_data->m_Size = sound_buffer_size;
@@ -490,6 +927,8 @@ namespace dmSound
         sd->m_Index = index;
         sd->m_Data = 0;
         sd->m_Size = 0;
+        sd->m_PcmCacheEntry = 0;
+        sd->m_PcmDecodePending = 0;
 
         Result result = SetSoundDataNoLock(sd, sound_buffer, sound_buffer_size);
         if (result == RESULT_OK)
@@ -515,10 +954,13 @@ namespace dmSound
     {
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
 
+        SoundSystem* sound = g_SoundSystem;
+        DetachPcmCacheEntry(sound, sound_data);
+        sound_data->m_PcmDecodePending = 0;
+
         if (sound_data->m_Data != 0x0)
             free((void*) sound_data->m_Data);
 
-        SoundSystem* sound = g_SoundSystem;
         sound->m_SoundDataPool.Push(sound_data->m_Index);
         sound_data->m_Index = 0xffff;
 
@@ -536,7 +978,9 @@ namespace dmSound
             return RESULT_OUT_OF_INSTANCES;
         }
 
-        dmSoundCodec::HDecoder decoder;
+        dmSoundCodec::HDecoder decoder = 0;
+        PcmCacheEntry* pcm_cache_entry = 0;
+        bool pcm_cache_miss = false;
 
         dmSoundCodec::Format codec_format = dmSoundCodec::FORMAT_WAV;
         if (sound_data->m_Type == SOUND_DATA_TYPE_WAV) {
@@ -551,10 +995,27 @@ namespace dmSound
         {
             DM_MUTEX_OPTIONAL_SCOPED_LOCK(ss->m_Mutex);
 
-            dmSoundCodec::Result r = dmSoundCodec::NewDecoder(ss->m_CodecContext, codec_format, sound_data->m_Data, sound_data->m_Size, &decoder);
-            if (r != dmSoundCodec::RESULT_OK) {
-                dmLogError("Failed to decode sound (%d)", r);
-                return RESULT_INVALID_STREAM_DATA;
+            if (IsPcmCacheable(ss, sound_data))
+            {
+                pcm_cache_entry = sound_data->m_PcmCacheEntry;
+                if (pcm_cache_entry) {
+                    AcquirePcmCacheEntry(ss, pcm_cache_entry);
+                    ss->m_PcmCache.m_Hits++;
+                } else {
+                    ss->m_PcmCache.m_Misses++;
+                    pcm_cache_miss = true;
+                }
+            }
+
+            if (!pcm_cache_entry)
+            {
+                dmSoundCodec::Result r = dmSoundCodec::NewDecoder(ss->m_CodecContext, codec_format, sound_data->m_Data, sound_data->m_Size, &decoder);
+                if (r != dmSoundCodec::RESULT_OK) {
+                    dmLogError("Failed to decode sound (%d)", r);
+                    return RESULT_INVALID_STREAM_DATA;
+                }
+                if (pcm_cache_miss)
+                    RequestPcmDecode(ss, sound_data, decoder);
             }
 
             index = ss->m_InstancesPool.Pop();
@@ -570,7 +1031,13 @@ namespace dmSound
         si->m_Looping = 0;
         si->m_EndOfStream = 0;
         si->m_Playing = 0;
+        si->m_Virtual = 0;
+        si->m_Started = 0;
+        si->m_Priority = 0;
         si->m_Decoder = decoder;
+        si->m_PcmCacheEntry = pcm_cache_entry;
+        si->m_PcmCursor = 0;
+        si->m_FrameFraction = 0;
         si->m_Group = MASTER_GROUP_HASH;
 
         *sound_instance = si;
@@ -595,7 +1062,15 @@ namespace dmSound
         sound->m_InstancesPool.Push(index);
         sound_instance->m_Index = 0xffff;
         sound_instance->m_SoundDataIndex = 0xffff;
-        dmSoundCodec::DeleteDecoder(sound->m_CodecContext, sound_instance->m_Decoder);
+        if (sound_instance->m_PcmCacheEntry)
+        {
+            ReleasePcmCacheEntry(sound, sound_instance->m_PcmCacheEntry);
+            sound_instance->m_PcmCacheEntry = 0;
+        }
+        else
+        {
+            dmSoundCodec::DeleteDecoder(sound->m_CodecContext, sound_instance->m_Decoder);
+        }
         sound_instance->m_Decoder = 0;
         sound_instance->m_FrameCount = 0;
         sound_instance->m_Speed = 1.0f;
@@ -666,6 +1141,30 @@ namespace dmSound
         return RESULT_OK;
     }
 
+    Result SetGroupVoiceLimit(dmhash_t group_hash, uint32_t max_voices)
+    {
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
+        SoundSystem* sound = g_SoundSystem;
+        int* index = sound->m_GroupMap.Get(group_hash);
+        if (!index) {
+            return RESULT_NO_SUCH_GROUP;
+        }
+        sound->m_Groups[*index].m_VoiceLimit = max_voices;
+        return RESULT_OK;
+    }
+
+    Result GetGroupVoiceLimit(dmhash_t group_hash, uint32_t* max_voices)
+    {
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
+        SoundSystem* sound = g_SoundSystem;
+        int* index = sound->m_GroupMap.Get(group_hash);
+        if (!index) {
+            return RESULT_NO_SUCH_GROUP;
+        }
+        *max_voices = sound->m_Groups[*index].m_VoiceLimit;
+        return RESULT_OK;
+    }
+
     Result GetGroupGain(dmhash_t group_hash, float* gain)
     {
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
@@ -769,7 +1268,9 @@ namespace dmSound
     {
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
         sound_instance->m_Playing = 0;
-        dmSoundCodec::Reset(sound->m_CodecContext, sound_instance->m_Decoder);
+        sound_instance->m_Started = 0;
+        sound_instance->m_FrameFraction = 0;
+        ResetStream(sound, sound_instance);
     }
 
     Result Stop(HSoundInstance sound_instance)
@@ -802,6 +1303,18 @@ namespace dmSound
         return sound_instance->m_Playing; // && !sound_instance->m_EndOfStream;
     }
 
+    Result SetPriority(HSoundInstance sound_instance, uint8_t priority)
+    {
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
+        sound_instance->m_Priority = priority;
+        return RESULT_OK;
+    }
+
+    bool IsVirtual(HSoundInstance sound_instance)
+    {
+        return sound_instance->m_Virtual;
+    }
+
     Result SetLooping(HSoundInstance sound_instance, bool looping, int8_t loopcounter)
     {
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
@@ -843,6 +1356,192 @@ namespace dmSound
         *right_scale = sinf(theta);
     }
 
+    /**
+     * Left and right gain, including the pan, ramped linearly over a block of frames
+     */
+    struct BlockGain
+    {
+        float m_Left, m_Right;
+        float m_LeftDelta, m_RightDelta;
+
+        BlockGain(const Ramp& gain_ramp, const Ramp& pan_ramp, uint32_t start, uint32_t count)
+        {
+            float left_end, right_end;
+            Get(gain_ramp, pan_ramp, start, &m_Left, &m_Right);
+            Get(gain_ramp, pan_ramp, start + count, &left_end, &right_end);
+            float count_recip = 1.0f / count;
+            m_LeftDelta = (left_end - m_Left) * count_recip;
+            m_RightDelta = (right_end - m_Right) * count_recip;
+        }
+
+        static inline void Get(const Ramp& gain_ramp, const Ramp& pan_ramp, uint32_t i, float* left, float* right)
+        {
+            float gain = gain_ramp.GetValue(i);
+            GetPanScale(pan_ramp.GetValue(i), left, right);
+            *left *= gain;
+            *right *= gain;
+        }
+    };
+
+    /*
+     * Convert samples to float, (s - offset) * scale
+     */
+    template <typename T, int offset, int scale>
+    static inline void ConvertSamples(const T* in, float* out, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            out[i] = ((float) in[i] - offset) * scale;
+        }
+    }
+
+#if defined(DM_SOUND_SSE2) || defined(DM_SOUND_NEON)
+    template <>
+    inline void ConvertSamples<int16_t, 0, 1>(const int16_t* in, float* out, uint32_t count)
+    {
+        uint32_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+#if defined(DM_SOUND_SSE2)
+            __m128i s = _mm_loadu_si128((const __m128i*) (in + i));
+            // Sign extend to 32 bits by placing the samples in the high halves
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+            _mm_storeu_ps(out + i, _mm_cvtepi32_ps(lo));
+            _mm_storeu_ps(out + i + 4, _mm_cvtepi32_ps(hi));
+#else
+            int16x8_t s = vld1q_s16(in + i);
+            vst1q_f32(out + i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))));
+            vst1q_f32(out + i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))));
+#endif
+        }
+        for (; i < count; i++)
+        {
+            out[i] = in[i];
+        }
+    }
+
+    template <>
+    inline void ConvertSamples<uint8_t, 128, 255>(const uint8_t* in, float* out, uint32_t count)
+    {
+        uint32_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+#if defined(DM_SOUND_SSE2)
+            __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) (in + i)), _mm_setzero_si128());
+            s = _mm_sub_epi16(s, _mm_set1_epi16(128));
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+            __m128 scale = _mm_set1_ps(255.0f);
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+#else
+            int16x8_t s = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(in + i))), vdupq_n_s16(128));
+            vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), 255.0f));
+            vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), 255.0f));
+#endif
+        }
+        for (; i < count; i++)
+        {
+            out[i] = ((float) in[i] - 128) * 255;
+        }
+    }
+#endif
+
+    /*
+     * Accumulate mono samples into the stereo mix buffer
+     */
+    static void MixMono(const BlockGain& gain, const float* in, float* mix_buffer, uint32_t count)
+    {
+        float left = gain.m_Left;
+        float right = gain.m_Right;
+        uint32_t i = 0;
+#if defined(DM_SOUND_SSE2)
+        const __m128 ramp = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        __m128 l = _mm_add_ps(_mm_set1_ps(left), _mm_mul_ps(ramp, _mm_set1_ps(gain.m_LeftDelta)));
+        __m128 r = _mm_add_ps(_mm_set1_ps(right), _mm_mul_ps(ramp, _mm_set1_ps(gain.m_RightDelta)));
+        const __m128 dl = _mm_set1_ps(4.0f * gain.m_LeftDelta);
+        const __m128 dr = _mm_set1_ps(4.0f * gain.m_RightDelta);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 s = _mm_loadu_ps(in + i);
+            __m128 sl = _mm_mul_ps(s, l);
+            __m128 sr = _mm_mul_ps(s, r);
+            float* out = mix_buffer + 2 * i;
+            _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_unpacklo_ps(sl, sr)));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(sl, sr)));
+            l = _mm_add_ps(l, dl);
+            r = _mm_add_ps(r, dr);
+        }
+#elif defined(DM_SOUND_NEON)
+        const float ramp_values[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        const float32x4_t ramp = vld1q_f32(ramp_values);
+        float32x4_t l = vmlaq_n_f32(vdupq_n_f32(left), ramp, gain.m_LeftDelta);
+        float32x4_t r = vmlaq_n_f32(vdupq_n_f32(right), ramp, gain.m_RightDelta);
+        const float32x4_t dl = vdupq_n_f32(4.0f * gain.m_LeftDelta);
+        const float32x4_t dr = vdupq_n_f32(4.0f * gain.m_RightDelta);
+        for (; i + 4 <= count; i += 4)
+        {
+            float32x4_t s = vld1q_f32(in + i);
+            float32x4x2_t lr = vzipq_f32(vmulq_f32(s, l), vmulq_f32(s, r));
+            float* out = mix_buffer + 2 * i;
+            vst1q_f32(out, vaddq_f32(vld1q_f32(out), lr.val[0]));
+            vst1q_f32(out + 4, vaddq_f32(vld1q_f32(out + 4), lr.val[1]));
+            l = vaddq_f32(l, dl);
+            r = vaddq_f32(r, dr);
+        }
+#endif
+        for (; i < count; i++)
+        {
+            float s = in[i];
+            mix_buffer[2 * i]       += s * (left + gain.m_LeftDelta * i);
+            mix_buffer[2 * i + 1]   += s * (right + gain.m_RightDelta * i);
+        }
+    }
+
+    /*
+     * Accumulate interleaved stereo samples into the stereo mix buffer
+     */
+    static void MixStereo(const BlockGain& gain, const float* in, float* mix_buffer, uint32_t count)
+    {
+        float left = gain.m_Left;
+        float right = gain.m_Right;
+        uint32_t i = 0;
+#if defined(DM_SOUND_SSE2)
+        // Two frames per register: l0 r0 l1 r1
+        __m128 g = _mm_set_ps(right + gain.m_RightDelta, left + gain.m_LeftDelta, right, left);
+        const __m128 dg = _mm_set_ps(2.0f * gain.m_RightDelta, 2.0f * gain.m_LeftDelta, 2.0f * gain.m_RightDelta, 2.0f * gain.m_LeftDelta);
+        for (; i + 4 <= count; i += 4)
+        {
+            const float* s = in + 2 * i;
+            float* out = mix_buffer + 2 * i;
+            __m128 g2 = _mm_add_ps(g, dg);
+            _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(_mm_loadu_ps(s), g)));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(_mm_loadu_ps(s + 4), g2)));
+            g = _mm_add_ps(g2, dg);
+        }
+#elif defined(DM_SOUND_NEON)
+        const float gain_values[4] = { left, right, left + gain.m_LeftDelta, right + gain.m_RightDelta };
+        const float delta_values[4] = { 2.0f * gain.m_LeftDelta, 2.0f * gain.m_RightDelta, 2.0f * gain.m_LeftDelta, 2.0f * gain.m_RightDelta };
+        float32x4_t g = vld1q_f32(gain_values);
+        const float32x4_t dg = vld1q_f32(delta_values);
+        for (; i + 4 <= count; i += 4)
+        {
+            const float* s = in + 2 * i;
+            float* out = mix_buffer + 2 * i;
+            float32x4_t g2 = vaddq_f32(g, dg);
+            vst1q_f32(out, vmlaq_f32(vld1q_f32(out), vld1q_f32(s), g));
+            vst1q_f32(out + 4, vmlaq_f32(vld1q_f32(out + 4), vld1q_f32(s + 4), g2));
+            g = vaddq_f32(g2, dg);
+        }
+#endif
+        for (; i < count; i++)
+        {
+            mix_buffer[2 * i]       += in[2 * i] * (left + gain.m_LeftDelta * i);
+            mix_buffer[2 * i + 1]   += in[2 * i + 1] * (right + gain.m_RightDelta * i);
+        }
+    }
+
     /*
      *
      * Template parameters
@@ -871,29 +1570,25 @@ namespace dmSound
 
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
-        for (uint32_t i = 0; i < mix_buffer_count; i++)
+        float samples[MIX_BLOCK_FRAME_COUNT];
+        for (uint32_t block = 0; block < mix_buffer_count; block += MIX_BLOCK_FRAME_COUNT)
         {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
-            float mix = frac * range_recip; // determines the bias between two consecutive samples in the sound instance. It ranges from 0-1. A mix of 0, makes only the first sample count while a mix of 0.5 will count equally both samples.
-            T s1 = frames[index];
-            T s2 = frames[index + 1];
-            s1 = (s1 - offset) * scale;
-            s2 = (s2 - offset) * scale;
-
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-
-            float s = (1.0f - mix) * s1 + mix * s2; // resulting destination sample value is a mix of two source samples since a kind of fractional indexing is used
-            mix_buffer[2 * i] += s * gain * left_scale;
-            mix_buffer[2 * i + 1] += s * gain * right_scale;
+            uint32_t count = dmMath::Min(MIX_BLOCK_FRAME_COUNT, mix_buffer_count - block);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                float mix = frac * range_recip; // determines the bias between two consecutive samples in the sound instance. It ranges from 0-1. A mix of 0, makes only the first sample count while a mix of 0.5 will count equally both samples.
+                float s1 = ((float) frames[index] - offset) * scale;
+                float s2 = ((float) frames[index + 1] - offset) * scale;
+                samples[i] = (1.0f - mix) * s1 + mix * s2; // resulting destination sample value is a mix of two source samples since a kind of fractional indexing is used
 
-            prev_index = index; // keep old index for assertion
-            frac += delta;
+                prev_index = index; // keep old index for assertion
+                frac += delta;
 
-            index += (uint32_t)(frac >> RESAMPLE_FRACTION_BITS);
+                index += (uint32_t)(frac >> RESAMPLE_FRACTION_BITS);
 
-            frac &= ((1U << RESAMPLE_FRACTION_BITS) - 1U); // Keep lower RESAMPLE_FRACTION_BITS bits. Clear higher.
+                frac &= ((1U << RESAMPLE_FRACTION_BITS) - 1U); // Keep lower RESAMPLE_FRACTION_BITS bits. Clear higher.
+            }
+            MixMono(BlockGain(gain_ramp, pan_ramp, block, count), samples, mix_buffer + 2 * block, count);
         }
         instance->m_FrameFraction = frac;
 
@@ -926,34 +1621,27 @@ namespace dmSound
 
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
-        for (uint32_t i = 0; i < mix_buffer_count; i++)
+        float samples[2 * MIX_BLOCK_FRAME_COUNT];
+        for (uint32_t block = 0; block < mix_buffer_count; block += MIX_BLOCK_FRAME_COUNT)
         {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
-            float mix = frac * range_recip;
-            T sl1 = frames[2 * index];
-            T sl2 = frames[2 * index + 2];
-            sl1 = (sl1 - offset) * scale;
-            sl2 = (sl2 - offset) * scale;
-
-            T sr1 = frames[2 * index + 1];
-            T sr2 = frames[2 * index + 3];
-            sr1 = (sr1 - offset) * scale;
-            sr2 = (sr2 - offset) * scale;
-
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-
-            float sl = (1.0f - mix) * sl1 + mix * sl2;
-            float sr = (1.0f - mix) * sr1 + mix * sr2;
-            mix_buffer[2 * i]       += sl * gain * left_scale;
-            mix_buffer[2 * i + 1]   += sr * gain * right_scale;
-
-            prev_index = index;
-            frac += delta;
-            index += (uint32_t)(frac >> RESAMPLE_FRACTION_BITS);
-
-            frac &= ((1U << RESAMPLE_FRACTION_BITS) - 1U);
+            uint32_t count = dmMath::Min(MIX_BLOCK_FRAME_COUNT, mix_buffer_count - block);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                float mix = frac * range_recip;
+                float sl1 = ((float) frames[2 * index] - offset) * scale;
+                float sl2 = ((float) frames[2 * index + 2] - offset) * scale;
+                float sr1 = ((float) frames[2 * index + 1] - offset) * scale;
+                float sr2 = ((float) frames[2 * index + 3] - offset) * scale;
+                samples[2 * i]      = (1.0f - mix) * sl1 + mix * sl2;
+                samples[2 * i + 1]  = (1.0f - mix) * sr1 + mix * sr2;
+
+                prev_index = index;
+                frac += delta;
+                index += (uint32_t)(frac >> RESAMPLE_FRACTION_BITS);
+
+                frac &= ((1U << RESAMPLE_FRACTION_BITS) - 1U);
+            }
+            MixStereo(BlockGain(gain_ramp, pan_ramp, block, count), samples, mix_buffer + 2 * block, count);
         }
         instance->m_FrameFraction = frac;
 
@@ -973,17 +1661,12 @@ namespace dmSound
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
 
-        for (uint32_t i = 0; i < mix_buffer_count; i++)
+        float samples[MIX_BLOCK_FRAME_COUNT];
+        for (uint32_t block = 0; block < mix_buffer_count; block += MIX_BLOCK_FRAME_COUNT)
         {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
-            float s = frames[i];
-            s = (s - offset) * scale * gain;
-
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-            mix_buffer[2 * i]       += s * left_scale;
-            mix_buffer[2 * i + 1]   += s * right_scale;
+            uint32_t count = dmMath::Min(MIX_BLOCK_FRAME_COUNT, mix_buffer_count - block);
+            ConvertSamples<T, offset, scale>(frames + block, samples, count);
+            MixMono(BlockGain(gain_ramp, pan_ramp, block, count), samples, mix_buffer + 2 * block, count);
         }
         instance->m_FrameCount -= mix_buffer_count;
     }
@@ -998,19 +1681,12 @@ namespace dmSound
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
 
-        for (uint32_t i = 0; i < mix_buffer_count; i++)
+        float samples[2 * MIX_BLOCK_FRAME_COUNT];
+        for (uint32_t block = 0; block < mix_buffer_count; block += MIX_BLOCK_FRAME_COUNT)
         {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
-            float s1 = frames[2 * i];
-            float s2 = frames[2 * i + 1];
-            s1 = (s1 - offset) * scale * gain;
-            s2 = (s2 - offset) * scale * gain;
-
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-            mix_buffer[2 * i]       += s1 * left_scale;
-            mix_buffer[2 * i + 1]   += s2 * right_scale;
+            uint32_t count = dmMath::Min(MIX_BLOCK_FRAME_COUNT, mix_buffer_count - block);
+            ConvertSamples<T, offset, scale>(frames + 2 * block, samples, 2 * count);
+            MixStereo(BlockGain(gain_ramp, pan_ramp, block, count), samples, mix_buffer + 2 * block, count);
         }
         instance->m_FrameCount -= mix_buffer_count;
     }
@@ -1096,34 +1772,54 @@ namespace dmSound
         }
     }
 
-    static bool IsMuted(SoundInstance* instance) {
-        SoundSystem* sound = g_SoundSystem;
-
-        if (instance->m_Gain.IsZero()) {
-            return true;
+    /*
+     * Advances a virtual instance by the frames the mixer would have consumed this update, keeping its timing.
+     * The buffered frames are consumed first and the rest is skipped in the stream without decoding,
+     * so the buffer still holds decoded frames when the instance becomes real again.
+     */
+    static void SkipInstance(SoundSystem* sound, SoundInstance* instance, const dmSoundCodec::Info* info)
+    {
+        uint32_t skip;
+        if (info->m_Rate == sound->m_MixRate && instance->m_Speed == 1.0f) {
+            skip = sound->m_FrameCount;
+        } else {
+            // Same stepping as in the resampling mixers, summed up
+            uint64_t delta = (((uint64_t) info->m_Rate) << RESAMPLE_FRACTION_BITS) / sound->m_MixRate;
+            delta *= instance->m_Speed;
+            uint64_t frac = instance->m_FrameFraction + delta * sound->m_FrameCount;
+            skip = (uint32_t) (frac >> RESAMPLE_FRACTION_BITS);
+            instance->m_FrameFraction = frac & ((1U << RESAMPLE_FRACTION_BITS) - 1U);
         }
 
-        if (instance->m_Speed == 0.0f) {
-            return true;
-        }
+        const uint32_t stride = info->m_Channels * (info->m_BitsPerSample / 8);
+        uint32_t buffered = dmMath::Min(skip, instance->m_FrameCount);
+        memmove(instance->m_Frames, (char*) instance->m_Frames + buffered * stride, (instance->m_FrameCount - buffered) * stride);
+        instance->m_FrameCount -= buffered;
+        skip -= buffered;
 
-        int* group_index = sound->m_GroupMap.Get(instance->m_Group);
-        if (group_index != NULL) {
-            SoundGroup* group = &sound->m_Groups[*group_index];
-            if (group->m_Gain.IsZero()) {
-                return true;
-            }
+        if (skip == 0 || !instance->m_Playing) {
+            return;
         }
 
-        int* master_index = sound->m_GroupMap.Get(MASTER_GROUP_HASH);
-        if (master_index != NULL) {
-            SoundGroup* master = &sound->m_Groups[*master_index];
-            if (master->m_Gain.IsZero()) {
-                return true;
+        uint32_t skipped = 0;
+        dmSoundCodec::Result r = DecodeStream(sound, instance, 0, skip * stride, &skipped);
+        skip -= skipped / stride;
+        if (r == dmSoundCodec::RESULT_OK && skip > 0) {
+            if (instance->m_Looping && instance->m_Loopcounter != 0) {
+                ResetStream(sound, instance);
+                if ( instance->m_Loopcounter > 0 ) {
+                    instance->m_Loopcounter --;
+                }
+                r = DecodeStream(sound, instance, 0, skip * stride, &skipped);
+            } else {
+                instance->m_EndOfStream = 1;
             }
         }
 
-        return false;
+        if (r != dmSoundCodec::RESULT_OK) {
+            dmLogWarning("Unable to decode file '%s'. Result %d", GetSoundName(sound, instance), r);
+            instance->m_Playing = 0;
+        }
     }
 
     static void MixInstance(const MixContext* mix_context, SoundInstance* instance) {
@@ -1131,7 +1827,7 @@ namespace dmSound
         uint32_t decoded = 0;
 
         dmSoundCodec::Info info;
-        dmSoundCodec::GetInfo(sound->m_CodecContext, instance->m_Decoder, &info);
+        GetStreamInfo(sound, instance, &info);
         bool correct_bit_depth = info.m_BitsPerSample == 16 || info.m_BitsPerSample == 8;
         bool correct_num_channels = info.m_Channels == 1 || info.m_Channels == 2;
         if (!correct_bit_depth || !correct_num_channels) {
@@ -1146,7 +1842,11 @@ namespace dmSound
             return;
         }
 
-        bool is_muted = dmSound::IsMuted(instance);
+        instance->m_Started = 1;
+        if (instance->m_Virtual) {
+            SkipInstance(sound, instance, &info);
+            return;
+        }
 
         dmSoundCodec::Result r = dmSoundCodec::RESULT_OK;
         uint32_t mixed_instance_FrameCount = ceilf(sound->m_FrameCount * dmMath::Max(1.0f, instance->m_Speed));
@@ -1156,19 +1856,8 @@ namespace dmSound
             const uint32_t stride = info.m_Channels * (info.m_BitsPerSample / 8);
             uint32_t n = mixed_instance_FrameCount - instance->m_FrameCount; // if the result contains a fractional part and we don't ceil(), we'll end up with a smaller number. Later, when deciding the mix_count in Mix(), a smaller value (integer) will be produced. This will result in leaving a small gap in the mix buffer resulting in sound crackling when the chunk changes.
 
-            if (!is_muted)
-            {
-                r = dmSoundCodec::Decode(sound->m_CodecContext,
-                                         instance->m_Decoder,
-                                         ((char*) instance->m_Frames) + instance->m_FrameCount * stride,
-                                         n * stride,
-                                         &decoded);
-            }
-            else
-            {
-                r = dmSoundCodec::Skip(sound->m_CodecContext, instance->m_Decoder, n * stride, &decoded);
-                memset(((char*) instance->m_Frames) + instance->m_FrameCount * stride, 0x00, n * stride);
-            }
+            char* frames = ((char*) instance->m_Frames) + instance->m_FrameCount * stride;
+            r = DecodeStream(sound, instance, frames, n * stride, &decoded);
 
             assert(decoded % stride == 0);
             instance->m_FrameCount += decoded / stride;
@@ -1176,25 +1865,14 @@ namespace dmSound
             if (instance->m_FrameCount < mixed_instance_FrameCount) {
 
                 if (instance->m_Looping && instance->m_Loopcounter != 0) {
-                    dmSoundCodec::Reset(sound->m_CodecContext, instance->m_Decoder);
+                    ResetStream(sound, instance);
                     if ( instance->m_Loopcounter > 0 ) {
                         instance->m_Loopcounter --;
                     }
 
                     uint32_t n = mixed_instance_FrameCount - instance->m_FrameCount;
-                    if (!is_muted)
-                    {
-                        r = dmSoundCodec::Decode(sound->m_CodecContext,
-                                                 instance->m_Decoder,
-                                                 ((char*) instance->m_Frames) + instance->m_FrameCount * stride,
-                                                 n * stride,
-                                                 &decoded);
-                    }
-                    else
-                    {
-                        r = dmSoundCodec::Skip(sound->m_CodecContext, instance->m_Decoder, n * stride, &decoded);
-                        memset(((char*) instance->m_Frames) + instance->m_FrameCount * stride, 0x00, n * stride);
-                    }
+                    char* frames = ((char*) instance->m_Frames) + instance->m_FrameCount * stride;
+                    r = DecodeStream(sound, instance, frames, n * stride, &decoded);
 
                     assert(decoded % stride == 0);
                     instance->m_FrameCount += decoded / stride;
@@ -1360,6 +2038,124 @@ namespace dmSound
         }
     }
 
+    static inline float GetMaxGain(const Value* value)
+    {
+        return dmMath::Max(value->m_Prev, dmMath::Max(value->m_Current, value->m_Next));
+    }
+
+    // Max gain of the instance over the update, including the group and master gain
+    static float GetAudibility(SoundSystem* sound, SoundInstance* instance, const SoundGroup* group)
+    {
+        if (instance->m_Speed == 0.0f) {
+            return 0.0f;
+        }
+
+        float gain = GetMaxGain(&instance->m_Gain);
+        if (group != NULL && group->m_NameHash != MASTER_GROUP_HASH) {
+            gain *= dmMath::Min(1.0f, GetMaxGain(&group->m_Gain));
+        }
+
+        int* master_index = sound->m_GroupMap.Get(MASTER_GROUP_HASH);
+        if (master_index != NULL) {
+            gain *= GetMaxGain(&sound->m_Groups[*master_index].m_Gain);
+        }
+        return gain;
+    }
+
+    static inline void SetReal(SoundInstance* instance)
+    {
+        if (instance->m_Virtual) {
+            // Fade in from silence
+            instance->m_Virtual = 0;
+            instance->m_Gain.m_Prev = 0.0f;
+        }
+    }
+
+    struct VoiceSortPred
+    {
+        VoiceSortPred(SoundSystem* sound) : m_Sound(sound) {}
+
+        // Highest priority first, then the loudest. Ties keep the current real voices to avoid swapping
+        bool operator()(uint16_t a, uint16_t b) const
+        {
+            const SoundInstance* ia = &m_Sound->m_Instances[a];
+            const SoundInstance* ib = &m_Sound->m_Instances[b];
+            if (ia->m_Priority != ib->m_Priority)
+                return ia->m_Priority > ib->m_Priority;
+            if (ia->m_Audibility != ib->m_Audibility)
+                return ia->m_Audibility > ib->m_Audibility;
+            if (ia->m_Virtual != ib->m_Virtual)
+                return !ia->m_Virtual;
+            return a < b;
+        }
+
+        SoundSystem* m_Sound;
+    };
+
+    /*
+     * Selects the instances to decode and mix this update. Inaudible instances and the instances
+     * over their group's voice limit are virtual, they advance in the stream without being decoded or mixed.
+     * A playing instance over the limit is faded out over one update before it becomes virtual,
+     * and a virtual instance is faded in when it becomes real again.
+     */
+    static void UpdateVoices(SoundSystem* sound)
+    {
+        DM_PROFILE(Sound, "UpdateVoices")
+
+        uint32_t instances = sound->m_Instances.Size();
+        for (uint32_t i = 0; i < instances; ++i) {
+            SoundInstance* instance = &sound->m_Instances[i];
+            if (!instance->m_Playing && instance->m_FrameCount == 0) {
+                continue;
+            }
+
+            int* group_index = sound->m_GroupMap.Get(instance->m_Group);
+            SoundGroup* group = group_index != NULL ? &sound->m_Groups[*group_index] : NULL;
+            instance->m_Audibility = GetAudibility(sound, instance, group);
+            if (instance->m_Audibility < sound->m_VirtualGainThreshold) {
+                instance->m_Virtual = 1;
+            } else if (group == NULL || group->m_VoiceLimit == 0) {
+                SetReal(instance);
+            }
+        }
+
+        for (uint32_t g = 0; g < MAX_GROUPS; g++) {
+            SoundGroup* group = &sound->m_Groups[g];
+            if (!group->m_MixBuffer || group->m_VoiceLimit == 0) {
+                continue;
+            }
+
+            dmArray<uint16_t>& voices = sound->m_Voices;
+            voices.SetSize(0);
+            for (uint32_t i = 0; i < instances; ++i) {
+                SoundInstance* instance = &sound->m_Instances[i];
+                if ((instance->m_Playing || instance->m_FrameCount > 0) && instance->m_Group == group->m_NameHash &&
+                    instance->m_Audibility >= sound->m_VirtualGainThreshold) {
+                    voices.Push((uint16_t) i);
+                }
+            }
+
+            if (voices.Size() > group->m_VoiceLimit) {
+                std::sort(voices.Begin(), voices.End(), VoiceSortPred(sound));
+            }
+
+            uint32_t real_count = dmMath::Min(voices.Size(), group->m_VoiceLimit);
+            for (uint32_t i = 0; i < real_count; ++i) {
+                SetReal(&sound->m_Instances[voices[i]]);
+            }
+            for (uint32_t i = real_count; i < voices.Size(); ++i) {
+                SoundInstance* instance = &sound->m_Instances[voices[i]];
+                // Instances that aren't heard yet, or are already silent, become virtual at once
+                if (!instance->m_Started || instance->m_Virtual || instance->m_Gain.m_Prev == 0.0f) {
+                    instance->m_Virtual = 1;
+                } else {
+                    // Ramp to zero during this update. The next step restores the gain from m_Next
+                    instance->m_Gain.m_Current = 0.0f;
+                }
+            }
+        }
+    }
+
     static Result UpdateInternal(SoundSystem* sound)
     {
         DM_PROFILE(Sound, "Update")
@@ -1433,6 +2229,7 @@ namespace dmSound
         if (free_slots > 0) {
             StepGroupValues();
             StepInstanceValues();
+            UpdateVoices(sound);
         }
 
         uint32_t current_buffer = 0;
@@ -1464,6 +2261,7 @@ namespace dmSound
             sound->m_Status = RESULT_OK;
             if (!sound->m_IsPaused)
                 sound->m_Status = UpdateInternal(sound);
+            DecodePendingPcm(sound);
             dmTime::Sleep(8000);
         }
     }
@@ -1475,7 +2273,11 @@ namespace dmSound
             return RESULT_OK;
 
         if (!sound->m_Thread)
-            return UpdateInternal(sound);
+        {
+            Result r = UpdateInternal(sound);
+            DecodePendingPcm(sound);
+            return r;
+        }
         return sound->m_Status;
     }
 
@@ -81,6 +81,12 @@ namespace dmSound
         uint32_t m_BufferSize;
         uint32_t m_FrameCount;
         uint32_t m_MaxInstances;
+        /// Memory budget in bytes for fully decoded Ogg sounds shared by their instances. 0 disables the cache
+        uint32_t m_PcmCacheSize;
+        /// Max decoded size in bytes of a sound kept in the cache
+        uint32_t m_PcmCacheMaxSoundSize;
+        /// Instances with a combined instance, group and master gain below this are virtual, i.e. they advance without being decoded or mixed
+        float    m_VirtualGainThreshold;
         bool     m_UseThread;
 
         InitializeParams()
@@ -115,13 +121,38 @@ namespace dmSound
     Result GetGroupGain(dmhash_t group_hash, float* gain);
     Result GetGroupHashes(uint32_t* count, dmhash_t* buffer);
 
+    /// Max number of instances in the group that are decoded and mixed, 0 for no limit.
+    /// The instances over the limit with the lowest priority and gain are virtual
+    Result SetGroupVoiceLimit(dmhash_t group_hash, uint32_t max_voices);
+    Result GetGroupVoiceLimit(dmhash_t group_hash, uint32_t* max_voices);
+
     Result GetGroupRMS(dmhash_t group_hash, float window, float* rms_left, float* rms_right);
     Result GetGroupPeak(dmhash_t group_hash, float window, float* peak_left, float* peak_right);
 
+    struct PcmCacheStats
+    {
+        /// Instances created from cached PCM
+        uint32_t m_Hits;
+        /// Instances of cacheable sounds created without cached PCM. They play from their own decoder
+        uint32_t m_Misses;
+        /// Sounds decoded on the sound thread to be added to the cache
+        uint32_t m_Decodes;
+        /// Bytes of decoded PCM currently held, including sounds changed or deleted while still in use
+        uint32_t m_MemoryUsed;
+        /// Number of cached sounds
+        uint32_t m_EntryCount;
+    };
+
+    void GetPcmCacheStats(PcmCacheStats* stats);
+
     Result Play(HSoundInstance sound_instance);
     Result Stop(HSoundInstance sound_instance);
     Result Pause(HSoundInstance sound_instance, bool pause);
     bool IsPlaying(HSoundInstance sound_instance);
+    /// Instances with a higher priority are kept when a group is over its voice limit. 0 by default
+    Result SetPriority(HSoundInstance sound_instance, uint8_t priority);
+    /// Whether the instance was virtual in the last update, i.e. advanced without being mixed
+    bool IsVirtual(HSoundInstance sound_instance);
     uint32_t GetAndIncreasePlayCounter();
 
     Result SetLooping(HSoundInstance sound_instance, bool looping, int8_t loopcount);
@@ -991,6 +991,400 @@ const TestParams params_verify_ogg_test[] = {TestParams("loopback",
 INSTANTIATE_TEST_CASE_P(dmSoundVerifyOggTest, dmSoundVerifyOggTest, jc_test_values_in(params_verify_ogg_test));
 #endif
 
+class dmSoundPcmCacheTest : public jc_test_params_class<TestParams>
+{
+public:
+    void Initialize(uint32_t pcm_cache_size, uint32_t pcm_cache_max_sound_size)
+    {
+        dmSound::InitializeParams params;
+        params.m_MaxBuffers = MAX_BUFFERS;
+        params.m_MaxSources = MAX_SOURCES;
+        params.m_OutputDevice = GetParam().m_DeviceName;
+        params.m_FrameCount = GetParam().m_BufferFrameCount;
+        params.m_PcmCacheSize = pcm_cache_size;
+        params.m_PcmCacheMaxSoundSize = pcm_cache_max_sound_size;
+        params.m_UseThread = false;
+
+        dmSound::Result r = dmSound::Initialize(0, &params);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+
+    // Plays two overlapping instances of the sound to the end. The second one is created after the
+    // sound is decoded into the cache by the first update
+    void MixTwoInstances(dmArray<int16_t>* output, dmSound::PcmCacheStats* stats)
+    {
+        TestParams params = GetParam();
+        dmSound::HSoundData sd = 0;
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd, 1234));
+
+        dmSound::HSoundInstance instance_a = 0;
+        dmSound::HSoundInstance instance_b = 0;
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &instance_a));
+
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instance_a));
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+        }
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &instance_b));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetLooping(instance_b, true, 1));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instance_b));
+        do {
+            ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+        } while (dmSound::IsPlaying(instance_a) || dmSound::IsPlaying(instance_b));
+
+        dmSound::GetPcmCacheStats(stats);
+
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_a));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_b));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd));
+
+        output->SetCapacity(g_LoopbackDevice->m_AllOutput.Size());
+        output->SetSize(0);
+        output->PushArray(g_LoopbackDevice->m_AllOutput.Begin(), g_LoopbackDevice->m_AllOutput.Size());
+    }
+};
+
+TEST_P(dmSoundPcmCacheTest, Mix)
+{
+    dmArray<int16_t> decoded_output;
+    dmSound::PcmCacheStats stats;
+    Initialize(0, 0);
+    MixTwoInstances(&decoded_output, &stats);
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+    ASSERT_EQ(0u, stats.m_Hits);
+    ASSERT_EQ(0u, stats.m_Misses);
+    ASSERT_EQ(0u, stats.m_Decodes);
+    ASSERT_EQ(0u, stats.m_EntryCount);
+    ASSERT_EQ(0u, stats.m_MemoryUsed);
+
+    dmArray<int16_t> cached_output;
+    Initialize(1024 * 1024, 1024 * 1024);
+    MixTwoInstances(&cached_output, &stats);
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+    ASSERT_EQ(1u, stats.m_Hits);
+    ASSERT_EQ(1u, stats.m_Misses);
+    ASSERT_EQ(1u, stats.m_Decodes);
+    ASSERT_EQ(1u, stats.m_EntryCount);
+    ASSERT_EQ(GetParam().m_FrameCount * 2, stats.m_MemoryUsed);
+
+    ASSERT_EQ(decoded_output.Size(), cached_output.Size());
+    for (uint32_t i = 0; i < decoded_output.Size(); ++i) {
+        ASSERT_EQ(decoded_output[i], cached_output[i]);
+    }
+}
+
+TEST_P(dmSoundPcmCacheTest, Evict)
+{
+    TestParams params = GetParam();
+    const uint32_t size = params.m_FrameCount * 2;
+    Initialize(size, size);
+
+    dmSound::HSoundData sd_a = 0;
+    dmSound::HSoundData sd_b = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd_a, 1));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd_b, 2));
+
+    // A miss plays from its own decoder, the sound is decoded into the cache on the next update
+    dmSound::PcmCacheStats stats;
+    dmSound::HSoundInstance instance_a = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd_a, &instance_a));
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(1u, stats.m_Misses);
+    ASSERT_EQ(0u, stats.m_Decodes);
+    ASSERT_EQ(0u, stats.m_EntryCount);
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(1u, stats.m_Decodes);
+    ASSERT_EQ(1u, stats.m_EntryCount);
+    ASSERT_EQ(size, stats.m_MemoryUsed);
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_a));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd_a, &instance_a));
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(1u, stats.m_Hits);
+
+    // The cache is full and the entry in use, so the other sound isn't decoded at all
+    dmSound::HSoundInstance instance_b = 0;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd_b, &instance_b));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_b));
+    }
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(4u, stats.m_Misses);
+    ASSERT_EQ(1u, stats.m_Decodes);
+    ASSERT_EQ(1u, stats.m_EntryCount);
+
+    // Evicts the unused entry of sd_a
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_a));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd_b, &instance_b));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd_b, &instance_a));
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(5u, stats.m_Misses);
+    ASSERT_EQ(2u, stats.m_Hits);
+    ASSERT_EQ(2u, stats.m_Decodes);
+    ASSERT_EQ(1u, stats.m_EntryCount);
+    ASSERT_EQ(size, stats.m_MemoryUsed);
+
+    // Changing the data while in use keeps the frames until the last instance is deleted
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetSoundData(sd_b, params.m_Sound, params.m_SoundSize));
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(0u, stats.m_EntryCount);
+    ASSERT_EQ(size, stats.m_MemoryUsed);
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_a));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_b));
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(0u, stats.m_MemoryUsed);
+
+    // A decode queued before the data changes isn't added
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd_b, &instance_b));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetSoundData(sd_b, params.m_Sound, params.m_SoundSize));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(0u, stats.m_EntryCount);
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_b));
+
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd_a));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd_b));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+}
+
+TEST_P(dmSoundPcmCacheTest, DecodeOrder)
+{
+    TestParams params = GetParam();
+    Initialize(1024 * 1024, 1024 * 1024);
+
+    dmSound::HSoundData sd_a = 0;
+    dmSound::HSoundData sd_b = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd_a, 1));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd_b, 2));
+
+    dmSound::HSoundInstance instance_a = 0;
+    dmSound::HSoundInstance instance_b = 0;
+    dmSound::HSoundInstance instance_c = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd_a, &instance_a));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd_b, &instance_b));
+
+    // One sound is decoded per update, the first miss first
+    dmSound::PcmCacheStats stats;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(2u, stats.m_Misses);
+    ASSERT_EQ(1u, stats.m_Decodes);
+    ASSERT_EQ(1u, stats.m_EntryCount);
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd_a, &instance_c));
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(1u, stats.m_Hits);
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_c));
+
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(2u, stats.m_Decodes);
+    ASSERT_EQ(2u, stats.m_EntryCount);
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd_b, &instance_c));
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(2u, stats.m_Hits);
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_c));
+
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_a));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_b));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd_a));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd_b));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+}
+
+TEST_P(dmSoundPcmCacheTest, TooLarge)
+{
+    TestParams params = GetParam();
+    Initialize(1024 * 1024, params.m_FrameCount * 2 - 1);
+
+    dmSound::HSoundData sd = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd, 1));
+
+    dmSound::HSoundInstance instance_a = 0;
+    dmSound::HSoundInstance instance_b = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &instance_a));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+    // Not decoded, the stream length is known up front
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &instance_b));
+
+    dmSound::PcmCacheStats stats;
+    dmSound::GetPcmCacheStats(&stats);
+    ASSERT_EQ(1u, stats.m_Misses);
+    ASSERT_EQ(0u, stats.m_Decodes);
+    ASSERT_EQ(0u, stats.m_EntryCount);
+    ASSERT_EQ(0u, stats.m_MemoryUsed);
+
+    // The instance plays from its decoder
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instance_a));
+    do {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+    } while (dmSound::IsPlaying(instance_a));
+    uint32_t non_zero = 0;
+    for (uint32_t i = 0; i < g_LoopbackDevice->m_AllOutput.Size(); ++i) {
+        non_zero += g_LoopbackDevice->m_AllOutput[i] != 0 ? 1 : 0;
+    }
+    ASSERT_LT(params.m_FrameCount, non_zero);
+
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_a));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance_b));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+}
+
+const TestParams params_pcm_cache_test[] = {TestParams("loopback",
+                                            MONO_RESAMPLE_FRAMECOUNT_16000_OGG,
+                                            MONO_RESAMPLE_FRAMECOUNT_16000_OGG_SIZE,
+                                            dmSound::SOUND_DATA_TYPE_OGG_VORBIS,
+                                            2000,
+                                            16000,
+                                            35204,
+                                            2048)};
+INSTANTIATE_TEST_CASE_P(dmSoundPcmCacheTest, dmSoundPcmCacheTest, jc_test_values_in(params_pcm_cache_test));
+
+class dmSoundVirtualVoiceTest : public dmSoundTest
+{
+public:
+    // The loopback device doesn't accept a buffer every update
+    void UpdateUntilMixed()
+    {
+        uint32_t writes = g_LoopbackDevice->m_NumWrites;
+        do {
+            ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+        } while (writes == g_LoopbackDevice->m_NumWrites);
+    }
+};
+
+TEST_P(dmSoundVirtualVoiceTest, Resume)
+{
+    TestParams params = GetParam();
+    dmSound::HSoundData sd = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd, 1234));
+    const uint32_t update_count = 12;
+    const uint32_t muted_count = 5;
+
+    // Reference, audible throughout
+    dmSound::HSoundInstance instance = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instance));
+    for (uint32_t i = 0; i < update_count; ++i) {
+        UpdateUntilMixed();
+        ASSERT_FALSE(dmSound::IsVirtual(instance));
+    }
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Stop(instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance));
+    const uint32_t reference_size = g_LoopbackDevice->m_AllOutput.Size();
+
+    // Muted at first. Virtual instances advance without mixing and resume at the same position
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetParameter(instance, dmSound::PARAMETER_GAIN, Vectormath::Aos::Vector4(0.0f, 0, 0, 0)));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instance));
+    for (uint32_t i = 0; i < muted_count; ++i) {
+        UpdateUntilMixed();
+        ASSERT_TRUE(dmSound::IsVirtual(instance));
+    }
+    for (uint32_t i = reference_size; i < g_LoopbackDevice->m_AllOutput.Size(); ++i) {
+        ASSERT_EQ(0, g_LoopbackDevice->m_AllOutput[i]);
+    }
+
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetParameter(instance, dmSound::PARAMETER_GAIN, Vectormath::Aos::Vector4(1.0f, 0, 0, 0)));
+    UpdateUntilMixed();
+    ASSERT_FALSE(dmSound::IsVirtual(instance));
+    // After the fade in, the output matches the reference
+    const uint32_t resumed = g_LoopbackDevice->m_AllOutput.Size() - reference_size;
+    for (uint32_t i = muted_count + 1; i < update_count; ++i) {
+        UpdateUntilMixed();
+    }
+    const uint32_t end = dmMath::Min(reference_size, g_LoopbackDevice->m_AllOutput.Size() - reference_size);
+    ASSERT_LT(resumed, end);
+    for (uint32_t i = resumed; i < end; ++i) {
+        ASSERT_EQ(g_LoopbackDevice->m_AllOutput[i], g_LoopbackDevice->m_AllOutput[reference_size + i]);
+    }
+
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Stop(instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instance));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd));
+}
+
+TEST_P(dmSoundVirtualVoiceTest, VoiceLimit)
+{
+    TestParams params = GetParam();
+    const dmhash_t group = dmHashString64("limited");
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::AddGroup("limited"));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetGroupVoiceLimit(group, 1));
+    uint32_t max_voices = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::GetGroupVoiceLimit(group, &max_voices));
+    ASSERT_EQ(1u, max_voices);
+    ASSERT_EQ(dmSound::RESULT_NO_SUCH_GROUP, dmSound::SetGroupVoiceLimit(dmHashString64("unknown"), 1));
+
+    dmSound::HSoundData sd = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd, 1234));
+
+    dmSound::HSoundInstance low = 0;
+    dmSound::HSoundInstance high = 0;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &low));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sd, &high));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetInstanceGroup(low, group));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetInstanceGroup(high, group));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetPriority(high, 1));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(low));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(high));
+
+    // The lower priority instance becomes virtual before it is heard
+    UpdateUntilMixed();
+    ASSERT_TRUE(dmSound::IsVirtual(low));
+    ASSERT_FALSE(dmSound::IsVirtual(high));
+
+    // The replaced voice fades out during one update before becoming virtual
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetPriority(low, 2));
+    UpdateUntilMixed();
+    ASSERT_FALSE(dmSound::IsVirtual(low));
+    ASSERT_FALSE(dmSound::IsVirtual(high));
+    UpdateUntilMixed();
+    ASSERT_FALSE(dmSound::IsVirtual(low));
+    ASSERT_TRUE(dmSound::IsVirtual(high));
+
+    // No limit
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetGroupVoiceLimit(group, 0));
+    UpdateUntilMixed();
+    ASSERT_FALSE(dmSound::IsVirtual(low));
+    ASSERT_FALSE(dmSound::IsVirtual(high));
+
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Stop(low));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Stop(high));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(low));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(high));
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sd));
+}
+
+const TestParams params_virtual_voice_test[] = {
+    TestParams("loopback",
+                MONO_TONE_440_44100_88200_WAV,
+                MONO_TONE_440_44100_88200_WAV_SIZE,
+                dmSound::SOUND_DATA_TYPE_WAV,
+                440,
+                44100,
+                88200,
+                2048),
+    TestParams("loopback",
+                MONO_TONE_440_22050_44100_WAV,
+                MONO_TONE_440_22050_44100_WAV_SIZE,
+                dmSound::SOUND_DATA_TYPE_WAV,
+                440,
+                22050,
+                44100,
+                2048),
+    TestParams("loopback",
+                MONO_RESAMPLE_FRAMECOUNT_16000_OGG,
+                MONO_RESAMPLE_FRAMECOUNT_16000_OGG_SIZE,
+                dmSound::SOUND_DATA_TYPE_OGG_VORBIS,
+                2000,
+                16000,
+                35204,
+                2048),
+};
+INSTANTIATE_TEST_CASE_P(dmSoundVirtualVoiceTest, dmSoundVirtualVoiceTest, jc_test_values_in(params_virtual_voice_test));
+
 #if !defined(GITHUB_CI) || (defined(GITHUB_CI) && !(defined(WIN32) || defined(__MACH__)))
 TEST_P(dmSoundTestPlayTest, Play)
 {
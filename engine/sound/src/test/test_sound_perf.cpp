@@ -23,6 +23,11 @@
 #include "../sound_codec.h"
 #include "../sound_decoder.h"
 
+#include "test/mono_tone_440_22050_44100.wav.embed.h"
+#include "test/mono_tone_440_44100_88200.wav.embed.h"
+#include "test/stereo_tone_440_22050_44100.wav.embed.h"
+#include "test/stereo_tone_440_44100_88200.wav.embed.h"
+
 #define DEF_EMBED(x) \
     extern unsigned char x[]; \
     extern uint32_t x##_SIZE;
@@ -155,6 +160,105 @@ TEST_F(dmSoundTest, MeasureTremoloSkip)
 }
 #endif
 
+// Like the null device, but always accepts a buffer so that dmSound::Update mixes every call
+static dmSound::Result DeviceBenchmarkOpen(const dmSound::OpenDeviceParams* params, dmSound::HDevice* device)
+{
+    *device = (dmSound::HDevice) 1;
+    return dmSound::RESULT_OK;
+}
+
+static void DeviceBenchmarkClose(dmSound::HDevice device)
+{
+}
+
+static dmSound::Result DeviceBenchmarkQueue(dmSound::HDevice device, const int16_t* samples, uint32_t sample_count)
+{
+    return dmSound::RESULT_OK;
+}
+
+static uint32_t DeviceBenchmarkFreeBufferSlots(dmSound::HDevice device)
+{
+    return 1;
+}
+
+static void DeviceBenchmarkDeviceInfo(dmSound::HDevice device, dmSound::DeviceInfo* info)
+{
+    info->m_MixRate = 44100;
+}
+
+static void DeviceBenchmarkRestart(dmSound::HDevice device)
+{
+}
+
+static void DeviceBenchmarkStop(dmSound::HDevice device)
+{
+}
+
+DM_DECLARE_SOUND_DEVICE(BenchmarkSoundDevice, "benchmark", DeviceBenchmarkOpen, DeviceBenchmarkClose, DeviceBenchmarkQueue, DeviceBenchmarkFreeBufferSlots, DeviceBenchmarkDeviceInfo, DeviceBenchmarkRestart, DeviceBenchmarkStop);
+
+TEST(dmSoundMixer, Benchmark)
+{
+    const uint32_t frame_count = 768;
+    const uint32_t instance_count = 32;
+    const uint32_t update_count = 2000;
+
+    dmSound::InitializeParams params;
+    params.m_MaxBuffers = 8;
+    params.m_MaxSources = 8;
+    params.m_MaxInstances = instance_count;
+    params.m_OutputDevice = "benchmark";
+    params.m_FrameCount = frame_count;
+    params.m_UseThread = false;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Initialize(0, &params));
+
+    struct Sound { const void* m_Data; uint32_t m_Size; } sounds[] = {
+        { MONO_TONE_440_22050_44100_WAV, MONO_TONE_440_22050_44100_WAV_SIZE },
+        { MONO_TONE_440_44100_88200_WAV, MONO_TONE_440_44100_88200_WAV_SIZE },
+        { STEREO_TONE_440_22050_44100_WAV, STEREO_TONE_440_22050_44100_WAV_SIZE },
+        { STEREO_TONE_440_44100_88200_WAV, STEREO_TONE_440_44100_88200_WAV_SIZE },
+    };
+    const uint32_t sound_count = sizeof(sounds) / sizeof(sounds[0]);
+
+    dmSound::HSoundData sound_data[sound_count];
+    for (uint32_t i = 0; i < sound_count; ++i)
+    {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(sounds[i].m_Data, sounds[i].m_Size, dmSound::SOUND_DATA_TYPE_WAV, &sound_data[i], i + 1));
+    }
+
+    // Covers the resampling and the identity mixers, with panning and gain
+    dmSound::HSoundInstance instances[instance_count];
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sound_data[i % sound_count], &instances[i]));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetLooping(instances[i], true, -1));
+        float pan = (i / (float) (instance_count - 1)) * 2.0f - 1.0f;
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetParameter(instances[i], dmSound::PARAMETER_PAN, Vectormath::Aos::Vector4(pan, 0, 0, 0)));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::SetParameter(instances[i], dmSound::PARAMETER_GAIN, Vectormath::Aos::Vector4(0.5f, 0, 0, 0)));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instances[i]));
+    }
+
+    uint64_t time_begin = dmTime::GetTime();
+    for (uint32_t i = 0; i < update_count; ++i)
+    {
+        dmSound::Update();
+    }
+    uint64_t time_end = dmTime::GetTime();
+
+    const float audio_length = update_count * frame_count / 44100.0f;
+    printf("Mixed %u instances, %.1f s of audio in %.3f ms (%.3f ms per %u frame buffer)\n",
+            instance_count, audio_length, (time_end - time_begin) / 1000.0f, (time_end - time_begin) / (1000.0f * update_count), frame_count);
+
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instances[i]));
+    }
+    for (uint32_t i = 0; i < sound_count; ++i)
+    {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sound_data[i]));
+    }
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);